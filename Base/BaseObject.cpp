@@ -1,6 +1,9 @@
 #include "BaseObject.h"
 #include "../vulkan/GlobalDeviceObjects.h"
 #include "../vulkan/FrameManager.h"
+#include "../class/AABBTree.h"
+#include <algorithm>
+#include <cmath>
 
 bool BaseObject::Init(const std::shared_ptr<BaseObject>& pObj)
 {
@@ -11,6 +14,11 @@ bool BaseObject::Init(const std::shared_ptr<BaseObject>& pObj)
 	return true;
 }
 
+BaseObject::~BaseObject()
+{
+	LeaveSpatialIndex();
+}
+
 std::shared_ptr<BaseObject> BaseObject::Create()
 {
 	std::shared_ptr<BaseObject> pObj = std::make_shared<BaseObject>();
@@ -31,6 +39,7 @@ void BaseObject::DelChild(uint32_t index)
 {
 	if (index < 0 || index >= m_children.size())
 		return;
+	m_children[index]->LeaveSpatialIndex();
 	m_children.erase(m_children.begin() + index);
 }
 
@@ -81,6 +90,14 @@ void BaseObject::LateUpdate()
 }
 
 void BaseObject::UpdateCachedData()
+{
+	UpdateCachedData(m_pSpatialIndex);
+
+	if (m_pSpatialIndex != nullptr)
+		m_pSpatialIndex->Maintain();
+}
+
+void BaseObject::UpdateCachedData(const std::shared_ptr<AABBTree>& pSpatialIndex)
 {
 	Matrix4d cachedParentWorldTransform;
 
@@ -90,8 +107,90 @@ void BaseObject::UpdateCachedData()
 	m_cachedWorldTransform = cachedParentWorldTransform * m_localTransform;
 	m_cachedWorldPosition = (cachedParentWorldTransform * Vector4d(m_localPosition, 1.0f)).xyz();
 
+	if (m_hasBounds)
+	{
+		// Box extents in world space: each axis gathers the reach of all 3 local axes
+		Vector3d center = m_cachedWorldTransform.TransformAsPoint((m_localBoundsMin + m_localBoundsMax) * 0.5);
+		Vector3d localExtents = (m_localBoundsMax - m_localBoundsMin) * 0.5;
+		Vector3d extents;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+				extents[i] += std::abs(m_cachedWorldTransform.c[j][i]) * localExtents[j];
+		}
+
+		m_cachedWorldBoundsMin = center - extents;
+		m_cachedWorldBoundsMax = center + extents;
+	}
+
+	// A nested scene root with its own index takes over for its subtree
+	const std::shared_ptr<AABBTree>& pIndex = m_pSpatialIndex != nullptr ? m_pSpatialIndex : pSpatialIndex;
+
+	UpdateSpatialProxy(pIndex);
+
+	for (size_t i = 0; i < m_children.size(); i++)
+		m_children[i]->UpdateCachedData(pIndex);
+}
+
+void BaseObject::AddLocalBounds(const Vector3d& boundsMin, const Vector3d& boundsMax)
+{
+	if (!m_hasBounds)
+	{
+		m_localBoundsMin = boundsMin;
+		m_localBoundsMax = boundsMax;
+		m_hasBounds = true;
+		return;
+	}
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		m_localBoundsMin[i] = std::min(m_localBoundsMin[i], boundsMin[i]);
+		m_localBoundsMax[i] = std::max(m_localBoundsMax[i], boundsMax[i]);
+	}
+}
+
+void BaseObject::UpdateSpatialProxy(const std::shared_ptr<AABBTree>& pSpatialIndex)
+{
+	if (m_spatialProxy != UINT32_MAX && m_pIndexedIn.lock() != pSpatialIndex)
+		LeaveSpatialIndex();
+
+	if (!m_hasBounds || pSpatialIndex == nullptr)
+		return;
+
+	if (m_spatialProxy == UINT32_MAX)
+	{
+		m_spatialProxy = pSpatialIndex->CreateProxy({ m_cachedWorldBoundsMin, m_cachedWorldBoundsMax }, this);
+		m_pIndexedIn = pSpatialIndex;
+	}
+	else
+		pSpatialIndex->MoveProxy(m_spatialProxy, { m_cachedWorldBoundsMin, m_cachedWorldBoundsMax });
+}
+
+std::shared_ptr<AABBTree> BaseObject::AcquireSpatialIndex() const
+{
+	if (m_pSpatialIndex != nullptr)
+		return m_pSpatialIndex;
+
+	if (!m_pParent.expired())
+		return m_pParent.lock()->AcquireSpatialIndex();
+
+	return nullptr;
+}
+
+void BaseObject::LeaveSpatialIndex()
+{
+	if (m_spatialProxy != UINT32_MAX)
+	{
+		std::shared_ptr<AABBTree> pIndexedIn = m_pIndexedIn.lock();
+		if (pIndexedIn != nullptr)
+			pIndexedIn->DestroyProxy(m_spatialProxy);
+
+		m_spatialProxy = UINT32_MAX;
+		m_pIndexedIn.reset();
+	}
+
 	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->UpdateCachedData();
+		m_children[i]->LeaveSpatialIndex();
 }
 
 void BaseObject::OnPreRender()
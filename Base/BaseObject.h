@@ -4,12 +4,16 @@
 #include "../maths/Matrix.h"
 #include "../maths/Quaternion.h"
 
+class AABBTree;
+
 class BaseObject : public SelfRefBase<BaseObject>
 {
 protected:
 	bool Init(const std::shared_ptr<BaseObject>& pObj);
 
 public:
+	~BaseObject();
+
 	template <typename T>
 	void AddComponent(const std::shared_ptr<T>& pComp)
 	{
@@ -130,6 +134,17 @@ public:
 
 	void Rotate(const Vector3d& v, double angle);
 
+	// Merge bounds of something attached to this object, in object space, into its local bounds
+	void AddLocalBounds(const Vector3d& boundsMin, const Vector3d& boundsMax);
+	bool HasBounds() const { return m_hasBounds; }
+
+	// Scene root owns spatial index, every object with bounds below it keeps a proxy there, moved along in "UpdateCachedData"
+	void SetSpatialIndex(const std::shared_ptr<AABBTree>& pSpatialIndex) { m_pSpatialIndex = pSpatialIndex; }
+	std::shared_ptr<AABBTree> GetSpatialIndex() const { return m_pSpatialIndex; }
+	// Index this object's subtree is kept in, i.e. the one of its nearest ancestor owning one
+	std::shared_ptr<AABBTree> AcquireSpatialIndex() const;
+	uint32_t GetSpatialProxy() const { return m_spatialProxy; }
+
 public:
 	void Update();
 	void OnAnimationUpdate();
@@ -156,12 +171,19 @@ public:
 	// These are before the stage of pre render
 	Matrix4d GetCachedWorldTransform() const { return m_cachedWorldTransform; }
 	Vector3d GetCachedWorldPosition() const { return m_cachedWorldPosition; }
+	const Vector3d& GetCachedWorldBoundsMin() const { return m_cachedWorldBoundsMin; }
+	const Vector3d& GetCachedWorldBoundsMax() const { return m_cachedWorldBoundsMax; }
 
 	//creators
 	static std::shared_ptr<BaseObject> Create();
 
 protected:
 	void UpdateLocalTransform();
+	void UpdateCachedData(const std::shared_ptr<AABBTree>& pSpatialIndex);
+	void UpdateSpatialProxy(const std::shared_ptr<AABBTree>& pSpatialIndex);
+
+	// Objects leaving the scene take their proxies, and their children's, out of spatial index
+	void LeaveSpatialIndex();
 
 protected:
 	std::vector<std::shared_ptr<BaseComponent>>		m_components;
@@ -177,4 +199,14 @@ protected:
 
 	Matrix4d	m_cachedWorldTransform;
 	Vector3d	m_cachedWorldPosition;
+
+	bool		m_hasBounds = false;
+	Vector3d	m_localBoundsMin;
+	Vector3d	m_localBoundsMax;
+	Vector3d	m_cachedWorldBoundsMin;
+	Vector3d	m_cachedWorldBoundsMax;
+
+	std::shared_ptr<AABBTree>	m_pSpatialIndex;
+	std::weak_ptr<AABBTree>		m_pIndexedIn;		// Spatial index "m_spatialProxy" belongs to
+	uint32_t					m_spatialProxy = UINT32_MAX;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Vector.h"
 #include "Quaternion.h"
 #include <algorithm>
+#include <limits>
 
 template <typename T>
 Matrix3x3<T>::Matrix3x3()
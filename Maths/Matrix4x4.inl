@@ -258,7 +258,7 @@ template <typename T>
 const Matrix4x4<T> Matrix4x4<T>::operator - (const Matrix4x4<T>& m) const
 {
 	Matrix4x4<T> ret = *this;
-	ret -= s;
+	ret -= m;
 	return ret;
 }
 
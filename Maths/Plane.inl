@@ -50,9 +50,10 @@ void Plane<T>::Transform(const Matrix3x3<T>& matrix)
 template<typename T>
 void Plane<T>::Transform(const Matrix4x4<T>& matrix)
 {
-	normal = matrix.TransformAsVector(normal);
-
-	// Normal * D is a point on the plane
+	// Normal * D is a point on the plane, it has to be taken before normal is transformed
 	// p dot with normal is D
-	D = matrix.TransformAsPoint(normal * D) * normal;
+	Vector3<T> p = matrix.TransformAsPoint(normal * D);
+
+	normal = matrix.TransformAsVector(normal);
+	D = p * normal;
 }
\ No newline at end of file
@@ -22,6 +22,8 @@ public:
 		FrustumFace_RIGHT,
 		FrustumFace_BOTTOM,
 		FrustumFace_TOP,
+		FrustumFace_NEAR,
+		FrustumFace_FAR,
 		FrustumFace_COUNT,
 	};
 
@@ -32,6 +34,10 @@ public:
 
 	PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect);
 
+	// Same as above, capped by near and far plane at these distances from head along "lookAt"
+	// Frustums built without them leave both planes zero, which never rejects anything
+	PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect, T nearPlane, T farPlane);
+
 public:
 	bool Contain(const Vector3<T>& p) const;
 
@@ -39,6 +39,16 @@ PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& look
 	this->head = head;
 }
 
+template <typename T>
+PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect, T nearPlane, T farPlane)
+	: PyramidFrustum(head, lookAt, fovv, aspect)
+{
+	Vector3<T> dir = lookAt.Normal();
+
+	planes[FrustumFace_NEAR]	= Plane<T>(dir,				head + dir * nearPlane);
+	planes[FrustumFace_FAR]		= Plane<T>(dir.Negative(),	head + dir * farPlane);
+}
+
 template <typename T>
 bool PyramidFrustum<T>::Contain(const Vector3<T>& p) const
 {
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <cmath>
 #include "Vector2.h"
 #include "Vector3.h"
 #include "Vector4.h"
@@ -1,6 +1,7 @@
 #include <windows.h>
 #include "vulkan\VulkanGLobal.h"
 #include "scene/SceneGenerator.h"
+#include <cstring>
 
 #if defined(_WIN32)
 // Windows entry point
@@ -14,7 +15,12 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 #endif
 {
 	VulkanGlobal::GetInstance()->InitVulkan(hInstance, WndProc);
-	VulkanGlobal::GetInstance()->Update();
+
+	// "-benchmark" prints benchmarks and quits rather than running the viewer
+	if (strstr(pCmdLine, "-benchmark") != nullptr)
+		VulkanGlobal::GetInstance()->RunBenchmarks();
+	else
+		VulkanGlobal::GetInstance()->Update();
 	SceneGenerator::Free();
 	VulkanGlobal::Free();
 	return 0;
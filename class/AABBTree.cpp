@@ -0,0 +1,936 @@
+#include "AABBTree.h"
+#include "../common/Macros.h"
+#include "../Maths/Matrix.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <limits>
+
+const uint32_t AABBTree::NONE;
+const double AABBTree::FAT_MARGIN_RATIO = 0.1;
+const double AABBTree::REBUILD_REFIT_RATIO = 0.25;
+
+AABBTree::~AABBTree()
+{
+	// Background build works on its own copy of primitives, nothing to cancel, just let it finish
+	if (m_rebuildFuture.valid())
+		m_rebuildFuture.wait();
+}
+
+uint32_t AABBTree::AllocateNode()
+{
+	uint32_t node;
+	if (m_freeNode != NONE)
+	{
+		node = m_freeNode;
+		m_freeNode = m_nodes[node].parent;
+	}
+	else
+	{
+		node = (uint32_t)m_nodes.size();
+		m_nodes.push_back({});
+	}
+
+	m_nodes[node] = { {}, NONE, NONE, NONE, NONE, 0 };
+	return node;
+}
+
+void AABBTree::FreeNode(uint32_t node)
+{
+	m_nodes[node].parent = m_freeNode;
+	m_nodes[node].height = -1;
+	m_freeNode = node;
+}
+
+uint32_t AABBTree::CreateProxy(const Box& box, void* pUserData)
+{
+	uint32_t proxy;
+	if (m_freeProxies.size() != 0)
+	{
+		proxy = m_freeProxies.back();
+		m_freeProxies.pop_back();
+	}
+	else
+	{
+		proxy = (uint32_t)m_proxies.size();
+		m_proxies.push_back({ {}, nullptr, NONE, false });
+	}
+
+	uint32_t leaf = AllocateNode();
+	m_nodes[leaf].box = Fatten(box);
+	m_nodes[leaf].proxy = proxy;
+
+	m_proxies[proxy].box = box;
+	m_proxies[proxy].pUserData = pUserData;
+	m_proxies[proxy].leaf = leaf;
+
+	InsertLeaf(leaf);
+	m_proxyCount++;
+
+	MarkChanged(proxy);
+	m_pendingChangedBoxes.push_back(box);
+	return proxy;
+}
+
+void AABBTree::DestroyProxy(uint32_t proxy)
+{
+	ASSERTION(proxy < m_proxies.size() && m_proxies[proxy].leaf != NONE);
+
+	RemoveLeaf(m_proxies[proxy].leaf);
+	FreeNode(m_proxies[proxy].leaf);
+
+	m_proxies[proxy].leaf = NONE;
+	m_proxies[proxy].pUserData = nullptr;
+	m_freeProxies.push_back(proxy);
+	m_proxyCount--;
+
+	MarkChanged(proxy);
+	m_pendingChangedBoxes.push_back(m_proxies[proxy].box);
+}
+
+bool AABBTree::MoveProxy(uint32_t proxy, const Box& box)
+{
+	ASSERTION(proxy < m_proxies.size() && m_proxies[proxy].leaf != NONE);
+
+	Box& proxyBox = m_proxies[proxy].box;
+	if (proxyBox.min != box.min || proxyBox.max != box.max)
+		m_pendingChangedBoxes.push_back(Union(proxyBox, box));
+	proxyBox = box;
+
+	uint32_t leaf = m_proxies[proxy].leaf;
+	if (Contains(m_nodes[leaf].box, box))
+		return false;
+
+	// Refit rather than reinsert, cheap but loosens ancestors, background rebuild takes care of quality
+	m_nodes[leaf].box = Fatten(box);
+	Refit(m_nodes[leaf].parent);
+	m_refitsSinceBuild++;
+
+	MarkChanged(proxy);
+	return true;
+}
+
+bool AABBTree::GetBounds(Box& bounds) const
+{
+	if (m_root == NONE)
+		return false;
+
+	// Root holds fat boxes, a little looser than proxies themselves
+	bounds = m_nodes[m_root].box;
+	return true;
+}
+
+void AABBTree::InsertLeaf(uint32_t leaf)
+{
+	if (m_root == NONE)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = NONE;
+		return;
+	}
+
+	// Descend towards the sibling that costs least surface area, going down a subtree costs the area it adds to every node on the way
+	Box leafBox = m_nodes[leaf].box;
+	uint32_t index = m_root;
+	while (m_nodes[index].child0 != NONE)
+	{
+		const Node& node = m_nodes[index];
+		double area = SurfaceArea(node.box);
+		double combinedArea = SurfaceArea(Union(node.box, leafBox));
+
+		// New parent of this node and the leaf
+		double cost = 2.0 * combinedArea;
+		double inheritanceCost = 2.0 * (combinedArea - area);
+
+		auto childCost = [&](uint32_t child)
+		{
+			double newArea = SurfaceArea(Union(m_nodes[child].box, leafBox));
+			if (m_nodes[child].child0 == NONE)
+				return newArea + inheritanceCost;
+			return newArea - SurfaceArea(m_nodes[child].box) + inheritanceCost;
+		};
+
+		double cost0 = childCost(node.child0);
+		double cost1 = childCost(node.child1);
+
+		if (cost < cost0 && cost < cost1)
+			break;
+
+		index = cost0 < cost1 ? node.child0 : node.child1;
+	}
+
+	uint32_t sibling = index;
+	uint32_t oldParent = m_nodes[sibling].parent;
+	uint32_t newParent = AllocateNode();
+
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].box = Union(leafBox, m_nodes[sibling].box);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child0 = sibling;
+	m_nodes[newParent].child1 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent == NONE)
+		m_root = newParent;
+	else if (m_nodes[oldParent].child0 == sibling)
+		m_nodes[oldParent].child0 = newParent;
+	else
+		m_nodes[oldParent].child1 = newParent;
+
+	index = m_nodes[leaf].parent;
+	while (index != NONE)
+	{
+		index = Balance(index);
+
+		Node& node = m_nodes[index];
+		node.height = 1 + std::max(m_nodes[node.child0].height, m_nodes[node.child1].height);
+		node.box = Union(m_nodes[node.child0].box, m_nodes[node.child1].box);
+
+		index = node.parent;
+	}
+}
+
+void AABBTree::RemoveLeaf(uint32_t leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NONE;
+		return;
+	}
+
+	uint32_t parent = m_nodes[leaf].parent;
+	uint32_t grandParent = m_nodes[parent].parent;
+	uint32_t sibling = m_nodes[parent].child0 == leaf ? m_nodes[parent].child1 : m_nodes[parent].child0;
+
+	// Sibling takes over place of parent
+	FreeNode(parent);
+	m_nodes[sibling].parent = grandParent;
+
+	if (grandParent == NONE)
+	{
+		m_root = sibling;
+		return;
+	}
+
+	if (m_nodes[grandParent].child0 == parent)
+		m_nodes[grandParent].child0 = sibling;
+	else
+		m_nodes[grandParent].child1 = sibling;
+
+	uint32_t index = grandParent;
+	while (index != NONE)
+	{
+		index = Balance(index);
+
+		Node& node = m_nodes[index];
+		node.height = 1 + std::max(m_nodes[node.child0].height, m_nodes[node.child1].height);
+		node.box = Union(m_nodes[node.child0].box, m_nodes[node.child1].box);
+
+		index = node.parent;
+	}
+}
+
+void AABBTree::Refit(uint32_t node)
+{
+	while (node != NONE)
+	{
+		m_nodes[node].box = Union(m_nodes[m_nodes[node].child0].box, m_nodes[m_nodes[node].child1].box);
+		node = m_nodes[node].parent;
+	}
+}
+
+uint32_t AABBTree::Balance(uint32_t iA)
+{
+	// Rotate the higher child up if children heights differ by more than 1
+	// A has children B and C, B has children D and E, C has children F and G
+	Node& A = m_nodes[iA];
+	if (A.child0 == NONE || A.height < 2)
+		return iA;
+
+	uint32_t iB = A.child0;
+	uint32_t iC = A.child1;
+	Node& B = m_nodes[iB];
+	Node& C = m_nodes[iC];
+
+	int32_t balance = C.height - B.height;
+
+	// C goes up, A takes C's lower child
+	if (balance > 1)
+	{
+		uint32_t iF = C.child0;
+		uint32_t iG = C.child1;
+		Node& F = m_nodes[iF];
+		Node& G = m_nodes[iG];
+
+		C.child0 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		if (C.parent == NONE)
+			m_root = iC;
+		else if (m_nodes[C.parent].child0 == iA)
+			m_nodes[C.parent].child0 = iC;
+		else
+			m_nodes[C.parent].child1 = iC;
+
+		if (F.height > G.height)
+		{
+			C.child1 = iF;
+			A.child1 = iG;
+			G.parent = iA;
+			A.box = Union(B.box, G.box);
+			C.box = Union(A.box, F.box);
+			A.height = 1 + std::max(B.height, G.height);
+			C.height = 1 + std::max(A.height, F.height);
+		}
+		else
+		{
+			C.child1 = iG;
+			A.child1 = iF;
+			F.parent = iA;
+			A.box = Union(B.box, F.box);
+			C.box = Union(A.box, G.box);
+			A.height = 1 + std::max(B.height, F.height);
+			C.height = 1 + std::max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	// B goes up, A takes B's lower child
+	if (balance < -1)
+	{
+		uint32_t iD = B.child0;
+		uint32_t iE = B.child1;
+		Node& D = m_nodes[iD];
+		Node& E = m_nodes[iE];
+
+		B.child0 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		if (B.parent == NONE)
+			m_root = iB;
+		else if (m_nodes[B.parent].child0 == iA)
+			m_nodes[B.parent].child0 = iB;
+		else
+			m_nodes[B.parent].child1 = iB;
+
+		if (D.height > E.height)
+		{
+			B.child1 = iD;
+			A.child0 = iE;
+			E.parent = iA;
+			A.box = Union(C.box, E.box);
+			B.box = Union(A.box, D.box);
+			A.height = 1 + std::max(C.height, E.height);
+			B.height = 1 + std::max(A.height, D.height);
+		}
+		else
+		{
+			B.child1 = iE;
+			A.child0 = iD;
+			D.parent = iA;
+			A.box = Union(C.box, D.box);
+			B.box = Union(A.box, E.box);
+			A.height = 1 + std::max(C.height, D.height);
+			B.height = 1 + std::max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+// -1: outside of a plane, 1: inside of all planes, 0: intersecting
+static int32_t ClassifyBox(const PyramidFrustumd& frustum, const AABBTree::Box& box)
+{
+	Vector3d center = (box.min + box.max) * 0.5;
+	Vector3d extents = (box.max - box.min) * 0.5;
+
+	int32_t result = 1;
+	for (uint32_t i = 0; i < PyramidFrustumd::FrustumFace_COUNT; i++)
+	{
+		const Planed& plane = frustum.planes[i];
+		double distance = plane.PlaneTest(center);
+		double reach = std::abs(plane.normal.x) * extents.x + std::abs(plane.normal.y) * extents.y + std::abs(plane.normal.z) * extents.z;
+
+		if (distance + reach < 0)
+			return -1;
+		if (distance - reach < 0)
+			result = 0;
+	}
+	return result;
+}
+
+void AABBTree::AppendLeaves(uint32_t node, std::vector<uint32_t>& results) const
+{
+	std::vector<uint32_t> stack = { node };
+	while (stack.size() != 0)
+	{
+		const Node& current = m_nodes[stack.back()];
+		stack.pop_back();
+
+		if (current.child0 == NONE)
+		{
+			results.push_back(current.proxy);
+			continue;
+		}
+
+		stack.push_back(current.child0);
+		stack.push_back(current.child1);
+	}
+}
+
+void AABBTree::QueryFrustum(const PyramidFrustumd& frustum, std::vector<uint32_t>& results) const
+{
+	if (m_root == NONE)
+		return;
+
+	std::vector<uint32_t> stack = { m_root };
+	while (stack.size() != 0)
+	{
+		uint32_t index = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_nodes[index];
+		if (node.child0 == NONE)
+		{
+			if (ClassifyBox(frustum, m_proxies[node.proxy].box) >= 0)
+				results.push_back(node.proxy);
+			continue;
+		}
+
+		int32_t classification = ClassifyBox(frustum, node.box);
+		if (classification < 0)
+			continue;
+
+		// Whole subtree inside, no more plane tests below
+		if (classification > 0)
+		{
+			AppendLeaves(index, results);
+			continue;
+		}
+
+		stack.push_back(node.child0);
+		stack.push_back(node.child1);
+	}
+}
+
+static double SquareDistance(const AABBTree::Box& box, const Vector3d& p)
+{
+	double squareDistance = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		double d = std::max(std::max(box.min[i] - p[i], p[i] - box.max[i]), 0.0);
+		squareDistance += d * d;
+	}
+	return squareDistance;
+}
+
+void AABBTree::QuerySphere(const Vector3d& center, double radius, std::vector<uint32_t>& results) const
+{
+	if (m_root == NONE)
+		return;
+
+	double squareRadius = radius * radius;
+
+	std::vector<uint32_t> stack = { m_root };
+	while (stack.size() != 0)
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+
+		if (SquareDistance(node.box, center) > squareRadius)
+			continue;
+
+		if (node.child0 == NONE)
+		{
+			if (SquareDistance(m_proxies[node.proxy].box, center) <= squareRadius)
+				results.push_back(node.proxy);
+			continue;
+		}
+
+		stack.push_back(node.child0);
+		stack.push_back(node.child1);
+	}
+}
+
+void AABBTree::QueryBox(const Box& box, std::vector<uint32_t>& results) const
+{
+	if (m_root == NONE)
+		return;
+
+	std::vector<uint32_t> stack = { m_root };
+	while (stack.size() != 0)
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+
+		if (!Overlaps(node.box, box))
+			continue;
+
+		if (node.child0 == NONE)
+		{
+			if (Overlaps(m_proxies[node.proxy].box, box))
+				results.push_back(node.proxy);
+			continue;
+		}
+
+		stack.push_back(node.child0);
+		stack.push_back(node.child1);
+	}
+}
+
+uint32_t AABBTree::RayCast(const Vector3d& origin, const Vector3d& direction, double maxDistance, double& hitDistance, const std::function<double(uint32_t)>& hitTest) const
+{
+	uint32_t hitProxy = NONE;
+	hitDistance = maxDistance;
+
+	if (m_root == NONE)
+		return hitProxy;
+
+	// Division by zero gives infinity, which slab test handles as a ray parallel to that axis
+	Vector3d invDirection = Vector3d(1.0 / direction.x, 1.0 / direction.y, 1.0 / direction.z);
+
+	std::vector<uint32_t> stack = { m_root };
+	while (stack.size() != 0)
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+
+		// Closest hit so far clips the ray, anything beyond it is skipped
+		if (RayBox(origin, invDirection, node.box, hitDistance) < 0)
+			continue;
+
+		if (node.child0 == NONE)
+		{
+			double distance = RayBox(origin, invDirection, m_proxies[node.proxy].box, hitDistance);
+			if (distance < 0)
+				continue;
+
+			if (hitTest != nullptr)
+			{
+				distance = hitTest(node.proxy);
+				if (distance < 0 || distance > hitDistance)
+					continue;
+			}
+
+			hitDistance = distance;
+			hitProxy = node.proxy;
+			continue;
+		}
+
+		stack.push_back(node.child0);
+		stack.push_back(node.child1);
+	}
+
+	return hitProxy;
+}
+
+void AABBTree::MarkChanged(uint32_t proxy)
+{
+	if (!m_rebuildFuture.valid() || m_proxies[proxy].changed)
+		return;
+
+	m_proxies[proxy].changed = true;
+	m_changedProxies.push_back(proxy);
+}
+
+std::vector<std::pair<uint32_t, AABBTree::Box>> AABBTree::GatherPrimitives() const
+{
+	std::vector<std::pair<uint32_t, Box>> primitives;
+	primitives.reserve(m_proxyCount);
+
+	for (uint32_t i = 0; i < (uint32_t)m_proxies.size(); i++)
+	{
+		if (m_proxies[i].leaf != NONE)
+			primitives.push_back({ i, m_nodes[m_proxies[i].leaf].box });
+	}
+	return primitives;
+}
+
+void AABBTree::Maintain()
+{
+	m_changedBoxes.swap(m_pendingChangedBoxes);
+	m_pendingChangedBoxes.clear();
+
+	if (m_rebuildFuture.valid())
+	{
+		if (m_rebuildFuture.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		BuildResult buildResult = m_rebuildFuture.get();
+		AdoptBuild(buildResult);
+		return;
+	}
+
+	if (m_proxyCount == 0 || m_refitsSinceBuild <= m_proxyCount * REBUILD_REFIT_RATIO)
+		return;
+
+	// Fat boxes are snapshot here, proxies changed from now on are patched into the result when it's adopted
+	m_refitsSinceBuild = 0;
+	m_rebuildFuture = std::async(std::launch::async, &AABBTree::Build, GatherPrimitives());
+}
+
+void AABBTree::Rebuild()
+{
+	// Background build in flight has to be adopted first, or its changed proxies get lost
+	if (m_rebuildFuture.valid())
+	{
+		BuildResult buildResult = m_rebuildFuture.get();
+		AdoptBuild(buildResult);
+	}
+
+	m_refitsSinceBuild = 0;
+
+	BuildResult buildResult = Build(GatherPrimitives());
+	AdoptBuild(buildResult);
+}
+
+void AABBTree::AdoptBuild(BuildResult& buildResult)
+{
+	typedef struct _ChangedProxy
+	{
+		uint32_t	proxy;
+		bool		alive;
+		Box			fatBox;
+	}ChangedProxy;
+
+	// Current state of changed proxies lives in the tree about to be replaced
+	std::vector<ChangedProxy> changedProxies;
+	for (uint32_t proxy : m_changedProxies)
+	{
+		uint32_t leaf = m_proxies[proxy].leaf;
+		changedProxies.push_back({ proxy, leaf != NONE, leaf != NONE ? m_nodes[leaf].box : Box() });
+		m_proxies[proxy].changed = false;
+	}
+	m_changedProxies.clear();
+
+	m_nodes.swap(buildResult.nodes);
+	m_root = buildResult.root;
+	m_freeNode = NONE;
+
+	// Leaves of new tree are proxies as they were at snapshot
+	for (auto& proxy : m_proxies)
+		proxy.leaf = NONE;
+
+	for (uint32_t i = 0; i < (uint32_t)m_nodes.size(); i++)
+	{
+		if (m_nodes[i].child0 == NONE)
+			m_proxies[m_nodes[i].proxy].leaf = i;
+	}
+
+	for (auto& changed : changedProxies)
+	{
+		Proxy& proxy = m_proxies[changed.proxy];
+		if (proxy.leaf != NONE)
+		{
+			RemoveLeaf(proxy.leaf);
+			FreeNode(proxy.leaf);
+			proxy.leaf = NONE;
+		}
+
+		if (!changed.alive)
+			continue;
+
+		uint32_t leaf = AllocateNode();
+		m_nodes[leaf].box = changed.fatBox;
+		m_nodes[leaf].proxy = changed.proxy;
+		InsertLeaf(leaf);
+		m_proxies[changed.proxy].leaf = leaf;
+	}
+}
+
+AABBTree::BuildResult AABBTree::Build(std::vector<std::pair<uint32_t, Box>> primitives)
+{
+	BuildResult buildResult = { {}, NONE };
+	if (primitives.size() == 0)
+		return buildResult;
+
+	buildResult.nodes.reserve(primitives.size() * 2 - 1);
+	buildResult.root = BuildRange(buildResult.nodes, primitives, 0, (uint32_t)primitives.size(), 0);
+	return buildResult;
+}
+
+uint32_t AABBTree::BuildRange(std::vector<Node>& nodes, std::vector<std::pair<uint32_t, Box>>& primitives, uint32_t begin, uint32_t end, uint32_t depth)
+{
+	uint32_t index = (uint32_t)nodes.size();
+	nodes.push_back({ primitives[begin].second, NONE, NONE, NONE, primitives[begin].first, 0 });
+
+	if (end - begin == 1)
+		return index;
+
+	Box bounds = primitives[begin].second;
+	Box centroidBounds = { (bounds.min + bounds.max) * 0.5, (bounds.min + bounds.max) * 0.5 };
+	for (uint32_t i = begin + 1; i < end; i++)
+	{
+		const Box& box = primitives[i].second;
+		Vector3d centroid = (box.min + box.max) * 0.5;
+		bounds = Union(bounds, box);
+		centroidBounds = Union(centroidBounds, { centroid, centroid });
+	}
+
+	uint32_t axis = 0;
+	Vector3d centroidExtents = centroidBounds.max - centroidBounds.min;
+	if (centroidExtents.y > centroidExtents[axis])
+		axis = 1;
+	if (centroidExtents.z > centroidExtents[axis])
+		axis = 2;
+
+	double axisMin = centroidBounds.min[axis];
+	double axisExtent = centroidExtents[axis];
+	auto binOf = [axis, axisMin, axisExtent](const std::pair<uint32_t, Box>& primitive)
+	{
+		double centroid = (primitive.second.min[axis] + primitive.second.max[axis]) * 0.5;
+		return std::min((uint32_t)((centroid - axisMin) / axisExtent * SAH_BIN_COUNT), SAH_BIN_COUNT - 1);
+	};
+
+	uint32_t mid = begin;
+	if (axisExtent > 0 && depth < MAX_SAH_DEPTH)
+	{
+		Box binBoxes[SAH_BIN_COUNT];
+		uint32_t binCounts[SAH_BIN_COUNT] = {};
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t bin = binOf(primitives[i]);
+			binBoxes[bin] = binCounts[bin] == 0 ? primitives[i].second : Union(binBoxes[bin], primitives[i].second);
+			binCounts[bin]++;
+		}
+
+		// Cost of splitting after each bin: surface area of each side times its primitives count
+		double leftCosts[SAH_BIN_COUNT - 1];
+		Box sideBox;
+		uint32_t sideCount = 0;
+		for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; i++)
+		{
+			if (binCounts[i] != 0)
+				sideBox = sideCount == 0 ? binBoxes[i] : Union(sideBox, binBoxes[i]);
+			sideCount += binCounts[i];
+			leftCosts[i] = sideCount == 0 ? 0 : SurfaceArea(sideBox) * sideCount;
+		}
+
+		double bestCost = std::numeric_limits<double>::max();
+		uint32_t bestSplit = NONE;
+		sideCount = 0;
+		for (uint32_t i = SAH_BIN_COUNT - 1; i > 0; i--)
+		{
+			if (binCounts[i] != 0)
+				sideBox = sideCount == 0 ? binBoxes[i] : Union(sideBox, binBoxes[i]);
+			sideCount += binCounts[i];
+
+			// Both sides need something
+			if (sideCount == 0 || sideCount == end - begin)
+				continue;
+
+			double cost = leftCosts[i - 1] + SurfaceArea(sideBox) * sideCount;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i - 1;
+			}
+		}
+
+		if (bestSplit != NONE)
+		{
+			mid = (uint32_t)(std::partition(primitives.begin() + begin, primitives.begin() + end, [&binOf, bestSplit](const std::pair<uint32_t, Box>& primitive)
+			{
+				return binOf(primitive) <= bestSplit;
+			}) - primitives.begin());
+		}
+	}
+
+	// Every centroid in one spot, or too deep already
+	if (mid == begin || mid == end)
+	{
+		mid = begin + (end - begin) / 2;
+		std::nth_element(primitives.begin() + begin, primitives.begin() + mid, primitives.begin() + end, [axis](const std::pair<uint32_t, Box>& p0, const std::pair<uint32_t, Box>& p1)
+		{
+			return p0.second.min[axis] + p0.second.max[axis] < p1.second.min[axis] + p1.second.max[axis];
+		});
+	}
+
+	uint32_t child0 = BuildRange(nodes, primitives, begin, mid, depth + 1);
+	uint32_t child1 = BuildRange(nodes, primitives, mid, end, depth + 1);
+
+	nodes[index] = { bounds, NONE, child0, child1, NONE, 1 + std::max(nodes[child0].height, nodes[child1].height) };
+	nodes[child0].parent = index;
+	nodes[child1].parent = index;
+
+	return index;
+}
+
+double AABBTree::GetCost() const
+{
+	if (m_root == NONE)
+		return 0;
+
+	double area = 0;
+	for (auto& node : m_nodes)
+	{
+		if (node.height > 0)
+			area += SurfaceArea(node.box);
+	}
+	return area / SurfaceArea(m_nodes[m_root].box);
+}
+
+AABBTree::Box AABBTree::Union(const Box& box0, const Box& box1)
+{
+	Box box;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		box.min[i] = std::min(box0.min[i], box1.min[i]);
+		box.max[i] = std::max(box0.max[i], box1.max[i]);
+	}
+	return box;
+}
+
+bool AABBTree::Contains(const Box& outer, const Box& inner)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (inner.min[i] < outer.min[i] || inner.max[i] > outer.max[i])
+			return false;
+	}
+	return true;
+}
+
+bool AABBTree::Overlaps(const Box& box0, const Box& box1)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (box0.max[i] < box1.min[i] || box1.max[i] < box0.min[i])
+			return false;
+	}
+	return true;
+}
+
+double AABBTree::SurfaceArea(const Box& box)
+{
+	Vector3d size = box.max - box.min;
+	return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+AABBTree::Box AABBTree::Fatten(const Box& box)
+{
+	Vector3d margin = (box.max - box.min) * FAT_MARGIN_RATIO;
+	return { box.min - margin, box.max + margin };
+}
+
+double AABBTree::RayBox(const Vector3d& origin, const Vector3d& invDirection, const Box& box, double maxDistance)
+{
+	double tMin = 0;
+	double tMax = maxDistance;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		double t0 = (box.min[i] - origin[i]) * invDirection[i];
+		double t1 = (box.max[i] - origin[i]) * invDirection[i];
+		if (t0 > t1)
+			std::swap(t0, t1);
+
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+		if (tMin > tMax)
+			return -1;
+	}
+	return tMin;
+}
+
+AABBTree::BenchmarkResult AABBTree::Benchmark(uint32_t objectsCount, uint32_t queriesCount)
+{
+	BenchmarkResult result = {};
+	result.objectsCount = objectsCount;
+
+	// Density stays the same whatever the count, roughly one object per 1000 cubic units
+	double worldSize = std::cbrt((double)objectsCount) * 10.0;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<double> position(0, worldSize);
+	std::uniform_real_distribution<double> size(0.5, 2.0);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+	std::vector<Box> boxes(objectsCount);
+	for (auto& box : boxes)
+	{
+		Vector3d center(position(random), position(random), position(random));
+		Vector3d extents(size(random), size(random), size(random));
+		box = { center - extents, center + extents };
+	}
+
+	AABBTree tree;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto& box : boxes)
+		tree.CreateProxy(box);
+	result.insertTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	double incrementalCost = tree.GetCost();
+
+	start = std::chrono::high_resolution_clock::now();
+	tree.Rebuild();
+	result.buildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	result.incrementalCost = incrementalCost / tree.GetCost();
+
+	std::vector<uint32_t> movedProxies;
+	std::vector<Box> movedBoxes;
+	for (uint32_t i = 0; i < objectsCount; i += 10)
+	{
+		Vector3d offset(unit(random) * 5.0, unit(random) * 5.0, unit(random) * 5.0);
+		movedProxies.push_back(i);
+		movedBoxes.push_back({ boxes[i].min + offset, boxes[i].max + offset });
+	}
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < (uint32_t)movedProxies.size(); i++)
+		tree.MoveProxy(movedProxies[i], movedBoxes[i]);
+	result.refitTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	tree.Rebuild();
+
+	// Camera like frustums, 60 degrees vertical fov and a far plane at a quarter of the world
+	std::vector<PyramidFrustumd> frustums;
+	std::vector<std::pair<Vector3d, Vector3d>> rays;
+	for (uint32_t i = 0; i < queriesCount; i++)
+	{
+		Vector3d head(position(random), position(random), position(random));
+		Vector3d direction(unit(random), unit(random), unit(random));
+		if (direction.SquareLength() == 0)
+			direction = Vector3d(0, 0, -1);
+		direction.Normalize();
+
+		PyramidFrustumd frustum = { {0, 0, 0}, direction, 3.1415926 / 6.0, 16.0 / 9.0, 0.01, worldSize * 0.25 };
+		Matrix4d translation;
+		translation.c[3] = Vector4d(head, 1.0);
+		frustum.Transform(translation);
+
+		frustums.push_back(frustum);
+		rays.push_back({ head, direction });
+	}
+
+	std::vector<uint32_t> results;
+	uint64_t hits = 0;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (auto& frustum : frustums)
+	{
+		results.clear();
+		tree.QueryFrustum(frustum, results);
+		hits += results.size();
+	}
+	result.frustumQueryTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / std::max(queriesCount, 1u);
+	result.frustumQueryHits = (uint32_t)(hits / std::max(queriesCount, 1u));
+
+	start = std::chrono::high_resolution_clock::now();
+	for (auto& ray : rays)
+	{
+		double hitDistance;
+		tree.RayCast(ray.first, ray.second, worldSize, hitDistance);
+	}
+	result.rayCastTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / std::max(queriesCount, 1u);
+
+	return result;
+}
\ No newline at end of file
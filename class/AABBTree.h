@@ -0,0 +1,159 @@
+#pragma once
+#include "../Maths/Vector.h"
+#include "../Maths/PyramidFrustum.h"
+#include <vector>
+#include <future>
+#include <functional>
+#include <cstdint>
+
+// Dynamic bounding volume hierarchy over axis aligned boxes, one proxy per leaf, no dependency on renderer
+// Proxies live in "fat" boxes, a move within fat box costs nothing, a move out of it refits leaf and its ancestors in place
+// Insertion picks sibling by surface area heuristic and keeps the tree balanced with rotations, refits let quality drift,
+// so once enough of them pile up "Maintain" rebuilds the whole tree from scratch with binned SAH on a background thread
+class AABBTree
+{
+public:
+	static const uint32_t NONE = UINT32_MAX;
+
+	typedef struct _Box
+	{
+		Vector3d	min;
+		Vector3d	max;
+	}Box;
+
+	typedef struct _BenchmarkResult
+	{
+		uint32_t	objectsCount;
+		double		insertTime;			// Incremental insertion of all objects, in milliseconds
+		double		buildTime;			// SAH build of all objects from scratch, in milliseconds
+		double		refitTime;			// Moving 10% of objects out of their fat boxes, in milliseconds
+		double		frustumQueryTime;	// Per query, in microseconds
+		double		rayCastTime;		// Per ray, in microseconds
+		double		incrementalCost;	// SAH cost of tree built incrementally, relative to the one built with SAH
+		uint32_t	frustumQueryHits;	// Average proxies returned by a frustum query
+	}BenchmarkResult;
+
+public:
+	AABBTree() = default;
+	~AABBTree();
+
+	// Returns proxy id, "pUserData" is handed back by "GetUserData"
+	uint32_t CreateProxy(const Box& box, void* pUserData = nullptr);
+	void DestroyProxy(uint32_t proxy);
+
+	// Returns true if proxy left its fat box and the tree changed
+	bool MoveProxy(uint32_t proxy, const Box& box);
+
+	const Box& GetProxyBox(uint32_t proxy) const { return m_proxies[proxy].box; }
+	void* GetUserData(uint32_t proxy) const { return m_proxies[proxy].pUserData; }
+	uint32_t GetProxyCount() const { return m_proxyCount; }
+
+	// Box around every proxy, false if tree is empty
+	bool GetBounds(Box& bounds) const;
+
+	// Where proxies were created, moved or destroyed before last "Maintain", a move covers both old and new box
+	const std::vector<Box>& GetChangedBoxes() const { return m_changedBoxes; }
+
+	// Queries append ids of proxies whose box passes the test to "results"
+	// Frustum planes left zero, like near & far of a frustum built without them, never reject anything
+	void QueryFrustum(const PyramidFrustumd& frustum, std::vector<uint32_t>& results) const;
+	void QuerySphere(const Vector3d& center, double radius, std::vector<uint32_t>& results) const;
+	void QueryBox(const Box& box, std::vector<uint32_t>& results) const;
+
+	// Closest proxy whose box "direction" (normalized) hits within "maxDistance", NONE if nothing does
+	// "hitTest" could refine a box hit, e.g. against triangles, by returning a distance, or a negative value for a miss
+	uint32_t RayCast(const Vector3d& origin, const Vector3d& direction, double maxDistance, double& hitDistance, const std::function<double(uint32_t)>& hitTest = nullptr) const;
+
+	// Called once per frame: adopts a finished background rebuild, or starts one if refits degraded the tree enough
+	// Changed boxes gathered since last call are handed over to "GetChangedBoxes"
+	void Maintain();
+
+	// Synchronous SAH rebuild of the whole tree
+	void Rebuild();
+
+	// Sum of internal node surface areas over root surface area, lower is better
+	double GetCost() const;
+	uint32_t GetHeight() const { return m_root == NONE ? 0 : m_nodes[m_root].height; }
+
+	static BenchmarkResult Benchmark(uint32_t objectsCount, uint32_t queriesCount);
+
+protected:
+	// A move out of fat box keeps this much of box size as margin on each side
+	static const double FAT_MARGIN_RATIO;
+
+	// Background rebuild starts once refits since last build exceed this fraction of proxies
+	static const double REBUILD_REFIT_RATIO;
+
+	static const uint32_t SAH_BIN_COUNT = 16;
+
+	// Deeper than this, build falls back to median split, so that skewed inputs can't blow up recursion
+	static const uint32_t MAX_SAH_DEPTH = 48;
+
+	typedef struct _Node
+	{
+		Box			box;
+		uint32_t	parent;
+		uint32_t	child0;
+		uint32_t	child1;
+		uint32_t	proxy;		// NONE for internal nodes
+		int32_t		height;		// 0 for leaves, -1 for free nodes
+	}Node;
+
+	typedef struct _Proxy
+	{
+		Box			box;
+		void*		pUserData;
+		uint32_t	leaf;		// NONE for free proxies
+		bool		changed;	// Created, moved or destroyed since background rebuild started
+	}Proxy;
+
+	typedef struct _BuildResult
+	{
+		std::vector<Node>	nodes;
+		uint32_t			root;
+	}BuildResult;
+
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t node);
+
+	void InsertLeaf(uint32_t leaf);
+	void RemoveLeaf(uint32_t leaf);
+	void Refit(uint32_t node);
+	uint32_t Balance(uint32_t node);
+
+	void AppendLeaves(uint32_t node, std::vector<uint32_t>& results) const;
+
+	void MarkChanged(uint32_t proxy);
+	std::vector<std::pair<uint32_t, Box>> GatherPrimitives() const;
+	void AdoptBuild(BuildResult& buildResult);
+
+	// Binned SAH build over "primitives" (proxy id, fat box), independent of tree state so it could run on any thread
+	static BuildResult Build(std::vector<std::pair<uint32_t, Box>> primitives);
+	static uint32_t BuildRange(std::vector<Node>& nodes, std::vector<std::pair<uint32_t, Box>>& primitives, uint32_t begin, uint32_t end, uint32_t depth);
+
+	static Box Union(const Box& box0, const Box& box1);
+	static bool Contains(const Box& outer, const Box& inner);
+	static bool Overlaps(const Box& box0, const Box& box1);
+	static double SurfaceArea(const Box& box);
+	static Box Fatten(const Box& box);
+
+	// Entry distance of a ray against box, negative if it misses, "invDirection" is component wise reciprocal of direction
+	static double RayBox(const Vector3d& origin, const Vector3d& invDirection, const Box& box, double maxDistance);
+
+protected:
+	std::vector<Node>			m_nodes;
+	uint32_t					m_root = NONE;
+	uint32_t					m_freeNode = NONE;	// Free nodes are chained through "parent"
+
+	std::vector<Proxy>			m_proxies;
+	std::vector<uint32_t>		m_freeProxies;
+	uint32_t					m_proxyCount = 0;
+
+	uint32_t					m_refitsSinceBuild = 0;
+
+	std::future<BuildResult>	m_rebuildFuture;
+	std::vector<uint32_t>		m_changedProxies;	// Proxies to patch into background build once it's adopted
+
+	std::vector<Box>			m_changedBoxes;
+	std::vector<Box>			m_pendingChangedBoxes;
+};
\ No newline at end of file
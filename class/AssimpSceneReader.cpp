@@ -8,9 +8,16 @@
 #include "SkeletonAnimation.h"
 #include "SkeletonAnimationInstance.h"
 #include "../component/AnimationController.h"
+#include "CookedMeshFile.h"
+#include "../common/Util.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
 #include <string>
 #include <codecvt>
 #include <locale>
+#include <chrono>
+#include <algorithm>
 
 std::vector<std::shared_ptr<Mesh>> AssimpSceneReader::Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList)
 {
@@ -19,19 +26,13 @@ std::vector<std::shared_ptr<Mesh>> AssimpSceneReader::Read(const std::string& pa
 	pScene = imp.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
 	ASSERTION(pScene != nullptr);
 
+	std::vector<MeshData> meshData;
+	ConvertMeshes(pScene, argumentedVAFList, meshData);
+	GlobalThreadTaskQueue()->WaitForFree();
+
 	std::vector<std::shared_ptr<Mesh>> meshes;
-	for (uint32_t i = 0; i < (uint32_t)pScene->mNumMeshes; i++)
+	for (auto pMesh : CreateMeshes(meshData))
 	{
-		std::shared_ptr<Mesh> pMesh = nullptr;
-
-		// Iterate all argumented vertex format, from first to last, and see if we can get one match
-		for (auto vaf : argumentedVAFList)
-		{
-			pMesh = Mesh::Create(pScene->mMeshes[i], vaf);
-			if (pMesh)
-				break;
-		}
-
 		// Add mesh to result vector if available
 		if (pMesh)
 			meshes.push_back(pMesh);
@@ -62,36 +63,74 @@ std::shared_ptr<Mesh> AssimpSceneReader::Read(const std::string& path, const std
 
 std::shared_ptr<BaseObject> AssimpSceneReader::ReadAndAssemblyScene(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo)
 {
+	std::chrono::time_point<std::chrono::high_resolution_clock> startTime = std::chrono::high_resolution_clock::now();
+
 	Assimp::Importer imp;
 	const aiScene* pScene = nullptr;
 	pScene = imp.ReadFile(path.c_str(), aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals);
 	ASSERTION(pScene != nullptr);
 
+	std::chrono::time_point<std::chrono::high_resolution_clock> readEndTime = std::chrono::high_resolution_clock::now();
+
 	ExtractAnimations(pScene);
 
-	std::shared_ptr<BaseObject> rootObject = AssemblyNode(pScene->mRootNode, pScene, argumentedVAFList, sceneInfo);
+	// Animation assembly is usually the heaviest single job, so send it out first
+	std::shared_ptr<SkeletonAnimation> pAnimation = nullptr;
+	double animationTime = 0;
+	GlobalThreadTaskQueue()->AddJob([pScene, &pAnimation, &animationTime](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+	{
+		std::chrono::time_point<std::chrono::high_resolution_clock> animationStartTime = std::chrono::high_resolution_clock::now();
+		pAnimation = SkeletonAnimation::Create(pScene);
+		animationTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - animationStartTime).count();
+	}, FrameMgr()->FrameIndex());
+
+	std::vector<MeshData> meshData;
+	ConvertMeshes(pScene, argumentedVAFList, meshData);
+	GlobalThreadTaskQueue()->WaitForFree();
 
-	// Create animation
-	sceneInfo.pAnimation = SkeletonAnimation::Create(pScene);
+	std::chrono::time_point<std::chrono::high_resolution_clock> convertEndTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::shared_ptr<Mesh>> meshes = CreateMeshes(meshData);
+
+	// Reports are per read, like timing
+	sceneInfo.optimizeReports.clear();
+	for (auto& data : meshData)
+		sceneInfo.optimizeReports.push_back(data.optimizeReport);
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> createEndTime = std::chrono::high_resolution_clock::now();
 
-	if (sceneInfo.pAnimation == nullptr)
-		return rootObject;
+	std::shared_ptr<BaseObject> rootObject = AssemblyNode(pScene->mRootNode, meshes, sceneInfo);
 
-	// For each object with animation in his children, create animation instance and animation controller to attach to it
-	for (auto link : sceneInfo.meshLinks)
+	// Create animation
+	sceneInfo.pAnimation = pAnimation;
+
+	if (sceneInfo.pAnimation != nullptr)
 	{
-		if (link.first->ContainBoneData())
+		// For each object with animation in his children, create animation instance and animation controller to attach to it
+		for (auto link : sceneInfo.meshLinks)
 		{
-			std::shared_ptr<SkeletonAnimationInstance> pAnimationInstance = SkeletonAnimationInstance::Create(sceneInfo.pAnimation, link.first);
-			std::shared_ptr<AnimationController> pAnimationController = AnimationController::Create(pAnimationInstance);
-			rootObject->AddComponent(pAnimationController);
+			if (link.first->ContainBoneData())
+			{
+				std::shared_ptr<SkeletonAnimationInstance> pAnimationInstance = SkeletonAnimationInstance::Create(sceneInfo.pAnimation, link.first);
+				std::shared_ptr<AnimationController> pAnimationController = AnimationController::Create(pAnimationInstance);
+				rootObject->AddComponent(pAnimationController);
+			}
 		}
 	}
 
+	std::chrono::time_point<std::chrono::high_resolution_clock> endTime = std::chrono::high_resolution_clock::now();
+
+	sceneInfo.timing.readTime = std::chrono::duration<double, std::milli>(readEndTime - startTime).count();
+	sceneInfo.timing.convertTime = std::chrono::duration<double, std::milli>(convertEndTime - readEndTime).count();
+	sceneInfo.timing.animationTime = animationTime;
+	sceneInfo.timing.createTime = std::chrono::duration<double, std::milli>(createEndTime - convertEndTime).count();
+	sceneInfo.timing.linkTime = std::chrono::duration<double, std::milli>(endTime - createEndTime).count();
+	sceneInfo.timing.totalTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
 	return rootObject;
 }
 
-std::shared_ptr<BaseObject> AssimpSceneReader::AssemblyNode(const aiNode* pAssimpNode, const aiScene* pScene, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo)
+std::shared_ptr<BaseObject> AssimpSceneReader::AssemblyNode(const aiNode* pAssimpNode, const std::vector<std::shared_ptr<Mesh>>& meshes, SceneInfo& sceneInfo)
 {
 	if (pAssimpNode == nullptr)
 		return nullptr;
@@ -106,30 +145,209 @@ std::shared_ptr<BaseObject> AssimpSceneReader::AssemblyNode(const aiNode* pAssim
 
 	for (uint32_t i = 0; i < (uint32_t)pAssimpNode->mNumMeshes; i++)
 	{
-		std::shared_ptr<Mesh> pMesh = nullptr;
-
-		// Iterate all argumented vertex format, from first to last, and see if we can get one match
-		for (auto vaf : argumentedVAFList)
-		{
-			pMesh = Mesh::Create(pScene->mMeshes[pAssimpNode->mMeshes[i]], vaf);
-			if (pMesh)
-				break;
-		}
-
 		// Add mesh to result vector if available
+		std::shared_ptr<Mesh> pMesh = meshes[pAssimpNode->mMeshes[i]];
 		if (pMesh)
 			sceneInfo.meshLinks.push_back({ pMesh, pObject });
 	}
 
 	for (uint32_t i = 0; i < pAssimpNode->mNumChildren; i++)
 	{
-		std::shared_ptr<BaseObject> pChild = AssemblyNode(pAssimpNode->mChildren[i], pScene, argumentedVAFList, sceneInfo);
+		std::shared_ptr<BaseObject> pChild = AssemblyNode(pAssimpNode->mChildren[i], meshes, sceneInfo);
 		pObject->AddChild(pChild);
 	}
 
 	return pObject;
 }
 
+void AssimpSceneReader::ConvertMesh(const aiMesh* pAssimpMesh, const std::vector<uint32_t>& argumentedVAFList, MeshData& meshData)
+{
+	uint32_t vertexFormat = Mesh::AcquireVertexFormat(pAssimpMesh);
+
+	// Iterate all argumented vertex format, from first to last, and pick the first match
+	auto it = std::find_if(argumentedVAFList.begin(), argumentedVAFList.end(), [vertexFormat](uint32_t vaf)
+	{
+		return Mesh::MatchVertexFormat(vertexFormat, vaf);
+	});
+
+	if (it == argumentedVAFList.end())
+		return;
+
+	meshData.vertexFormat = Mesh::AssemblyMeshData(pAssimpMesh, *it, meshData.vertices, meshData.indices, meshData.dequantization, meshData.optimizeReport, meshData.lodChain);
+	meshData.verticesCount = (uint32_t)(meshData.vertices.size() / GetVertexBytes(meshData.vertexFormat));
+
+	Mesh::AcquireBoneData(pAssimpMesh, meshData.boneNameHashes, meshData.boneOffsets);
+}
+
+void AssimpSceneReader::ConvertMeshes(const aiScene* pScene, const std::vector<uint32_t>& argumentedVAFList, std::vector<MeshData>& meshData)
+{
+	meshData.resize(pScene->mNumMeshes);
+
+	// Each job writes its own slot only, no lock needed
+	for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+	{
+		GlobalThreadTaskQueue()->AddJob([pScene, &argumentedVAFList, &meshData, i](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+		{
+			ConvertMesh(pScene->mMeshes[i], argumentedVAFList, meshData[i]);
+		}, FrameMgr()->FrameIndex());
+	}
+}
+
+std::vector<std::shared_ptr<Mesh>> AssimpSceneReader::CreateMeshes(const std::vector<MeshData>& meshData)
+{
+	std::vector<std::shared_ptr<Mesh>> meshes(meshData.size());
+	for (uint32_t i = 0; i < meshData.size(); i++)
+	{
+		if (meshData[i].vertexFormat == 0)
+			continue;
+
+		meshes[i] = Mesh::Create
+		(
+			meshData[i].vertices.data(), meshData[i].verticesCount, meshData[i].vertexFormat,
+			meshData[i].indices.data(), (uint32_t)meshData[i].indices.size(), VK_INDEX_TYPE_UINT32,
+			meshData[i].boneNameHashes, meshData[i].boneOffsets, meshData[i].dequantization, meshData[i].lodChain
+		);
+	}
+	return meshes;
+}
+
+std::string AssimpSceneReader::AcquireCookedPath(const std::string& path, bool preTransformVertices)
+{
+	return path + (preTransformVertices ? ".flat.vlmesh" : ".vlmesh");
+}
+
+std::shared_ptr<CookedMeshFile> AssimpSceneReader::AcquireCookedFile(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, bool preTransformVertices)
+{
+	std::string cookedPath = AcquireCookedPath(path, preTransformVertices);
+
+	std::shared_ptr<CookedMeshFile> pCookedFile = CookedMeshFile::Load(cookedPath);
+	if (pCookedFile && pCookedFile->IsCompatible(path, argumentedVAFList, preTransformVertices))
+		return pCookedFile;
+
+	// Release mapping before overwriting it
+	pCookedFile = nullptr;
+
+	bool cooked = CookedMeshFile::Cook(path, cookedPath, argumentedVAFList, preTransformVertices);
+	ASSERTION(cooked);
+
+	pCookedFile = CookedMeshFile::Load(cookedPath);
+	ASSERTION(pCookedFile != nullptr);
+	return pCookedFile;
+}
+
+std::vector<std::shared_ptr<Mesh>> AssimpSceneReader::ReadCooked(const std::string& path, const std::vector<uint32_t>& argumentedVAFList)
+{
+	std::shared_ptr<CookedMeshFile> pCookedFile = AcquireCookedFile(path, argumentedVAFList, true);
+
+	std::vector<std::shared_ptr<Mesh>> meshes;
+	for (uint32_t i = 0; i < pCookedFile->GetMeshCount(); i++)
+	{
+		// Vertex format is resolved during cooking, a null mesh means no argumented vertex format matches
+		std::shared_ptr<Mesh> pMesh = pCookedFile->CreateMesh(i);
+		if (pMesh)
+			meshes.push_back(pMesh);
+	}
+
+	return meshes;
+}
+
+std::shared_ptr<Mesh> AssimpSceneReader::ReadCooked(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, uint32_t meshIndex)
+{
+	std::shared_ptr<CookedMeshFile> pCookedFile = AcquireCookedFile(path, argumentedVAFList, true);
+	ASSERTION(meshIndex < pCookedFile->GetMeshCount());
+
+	return pCookedFile->CreateMesh(meshIndex);
+}
+
+std::shared_ptr<BaseObject> AssimpSceneReader::ReadAndAssemblyCookedScene(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> startTime = std::chrono::high_resolution_clock::now();
+
+	std::shared_ptr<CookedMeshFile> pCookedFile = AcquireCookedFile(path, argumentedVAFList, false);
+
+	// Animations are not cooked, fall back to assimp
+	if (pCookedFile->GetHeader().hasAnimation)
+		return ReadAndAssemblyScene(path, argumentedVAFList, sceneInfo);
+
+	ASSERTION(pCookedFile->GetNodeCount() > 0);
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> readEndTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::shared_ptr<Mesh>> meshes(pCookedFile->GetMeshCount());
+	sceneInfo.optimizeReports.clear();
+	for (uint32_t i = 0; i < pCookedFile->GetMeshCount(); i++)
+	{
+		meshes[i] = pCookedFile->CreateMesh(i);
+		sceneInfo.optimizeReports.push_back(pCookedFile->GetMeshEntry(i).optimizeReport);
+	}
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> createEndTime = std::chrono::high_resolution_clock::now();
+
+	// Nodes are stored in depth first order, so parent object is always created before its children
+	std::vector<std::shared_ptr<BaseObject>> objects(pCookedFile->GetNodeCount());
+	for (uint32_t i = 0; i < pCookedFile->GetNodeCount(); i++)
+	{
+		const CookedMeshFile::NodeEntry& node = pCookedFile->GetNodeEntry(i);
+
+		aiMatrix4x4 transformation;
+		memcpy(&transformation, node.transformation, sizeof(transformation));
+
+		std::shared_ptr<BaseObject> pObject = BaseObject::Create();
+
+		pObject->SetRotation(AssimpDataConverter::AcquireRotationMatrix(transformation));
+		pObject->SetPos(AssimpDataConverter::AcquireTranslationVector(transformation));
+
+		std::wstring wstr_name = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(pCookedFile->GetName(node.name));
+		pObject->SetName(wstr_name);
+
+		for (uint32_t j = 0; j < node.meshIndexCount; j++)
+		{
+			std::shared_ptr<Mesh> pMesh = meshes[pCookedFile->GetNodeMeshIndex(i, j)];
+			if (pMesh)
+				sceneInfo.meshLinks.push_back({ pMesh, pObject });
+		}
+
+		if (node.parentIndex >= 0)
+			objects[node.parentIndex]->AddChild(pObject);
+
+		objects[i] = pObject;
+	}
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> endTime = std::chrono::high_resolution_clock::now();
+
+	// Nothing to convert for cooked file
+	sceneInfo.timing = {};
+	sceneInfo.timing.readTime = std::chrono::duration<double, std::milli>(readEndTime - startTime).count();
+	sceneInfo.timing.createTime = std::chrono::duration<double, std::milli>(createEndTime - readEndTime).count();
+	sceneInfo.timing.linkTime = std::chrono::duration<double, std::milli>(endTime - createEndTime).count();
+	sceneInfo.timing.totalTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+	return objects[0];
+}
+
+AssimpSceneReader::LoadBenchmark AssimpSceneReader::BenchmarkLoad(const std::string& path, const std::vector<uint32_t>& argumentedVAFList)
+{
+	// Make sure cooked file is ready, so we don't measure cooking
+	AcquireCookedFile(path, argumentedVAFList, true);
+
+	LoadBenchmark benchmark = {};
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> startTime = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<std::shared_ptr<Mesh>> meshes = Read(path, argumentedVAFList);
+	}
+	std::chrono::time_point<std::chrono::high_resolution_clock> assimpEndTime = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<std::shared_ptr<Mesh>> meshes = ReadCooked(path, argumentedVAFList);
+	}
+	std::chrono::time_point<std::chrono::high_resolution_clock> cookedEndTime = std::chrono::high_resolution_clock::now();
+
+	benchmark.assimpLoadTime = std::chrono::duration<double, std::milli>(assimpEndTime - startTime).count();
+	benchmark.cookedLoadTime = std::chrono::duration<double, std::milli>(cookedEndTime - assimpEndTime).count();
+
+	return benchmark;
+}
+
 void AssimpSceneReader::ExtractAnimations(const aiScene* pScene)
 {
 	if (pScene->mNumAnimations == 0)
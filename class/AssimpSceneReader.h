@@ -5,28 +5,85 @@
 #include <vector>
 #include <memory>
 #include "../Maths/DualQuaternion.h"
+#include "MeshOptimizer.h"
+#include "VertexPacker.h"
+#include "MeshSimplifier.h"
 
 class Mesh;
 class BaseObject;
 class SkeletonAnimation;
+class CookedMeshFile;
 
 class AssimpSceneReader : public Singleton<AssimpSceneReader>
 {
 public:
 	typedef std::pair<std::shared_ptr<Mesh>, std::shared_ptr<BaseObject>> MeshLink;
+
+	// Wall time of each import stage, in milliseconds
+	typedef struct _ImportTiming
+	{
+		double	readTime;			// Assimp file parsing
+		double	convertTime;		// Mesh conversion, bone extraction and animation assembly, done in parallel
+		double	animationTime;		// Animation assembly alone, overlapped with mesh conversion
+		double	createTime;			// Buffer allocation, serialized
+		double	linkTime;			// Scene graph linking, serialized
+		double	totalTime;
+	}ImportTiming;
+
 	typedef struct _SceneInfo
 	{
 		std::vector<MeshLink>				meshLinks;
 		std::shared_ptr<SkeletonAnimation>	pAnimation;
+		ImportTiming						timing = {};
+		std::vector<MeshOptimizer::Report>	optimizeReports;	// One per assimp mesh, cooked scene reads the ones made at cook time
 	}SceneInfo;
 
+	typedef struct _LoadBenchmark
+	{
+		double	assimpLoadTime;		// Milliseconds
+		double	cookedLoadTime;		// Milliseconds
+	}LoadBenchmark;
+
 public:
 	static std::vector<std::shared_ptr<Mesh>> Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList);
 	static std::shared_ptr<Mesh> Read(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, uint32_t meshIndex);
 	static std::shared_ptr<BaseObject> ReadAndAssemblyScene(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo);
 
+	// Same as above, but read from cooked mesh file next to "path", it'll be cooked first if it doesn't exist or is out of date
+	static std::vector<std::shared_ptr<Mesh>> ReadCooked(const std::string& path, const std::vector<uint32_t>& argumentedVAFList);
+	static std::shared_ptr<Mesh> ReadCooked(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, uint32_t meshIndex);
+	static std::shared_ptr<BaseObject> ReadAndAssemblyCookedScene(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo);
+
+	// Compare load time of assimp and cooked mesh file of the same source, cooking itself is excluded
+	static LoadBenchmark BenchmarkLoad(const std::string& path, const std::vector<uint32_t>& argumentedVAFList);
+
 protected:
+	// Vertex and index data of one assimp mesh, converted into engine layout but not uploaded yet
+	typedef struct _MeshData
+	{
+		uint32_t						vertexFormat = 0;	// 0 means no argumented vertex format matches
+		uint32_t						verticesCount = 0;
+		std::vector<uint8_t>			vertices;
+		std::vector<uint32_t>			indices;
+		std::vector<std::size_t>		boneNameHashes;
+		std::vector<DualQuaterniond>	boneOffsets;
+		MeshOptimizer::Report			optimizeReport = {};
+		VertexPacker::Dequantization	dequantization;
+		MeshSimplifier::LodChain		lodChain;
+	}MeshData;
+
+	static void ConvertMesh(const aiMesh* pAssimpMesh, const std::vector<uint32_t>& argumentedVAFList, MeshData& meshData);
+
+	// Fan out mesh conversion to worker threads, caller has to wait for global thread task queue to be free before using "meshData"
+	static void ConvertMeshes(const aiScene* pScene, const std::vector<uint32_t>& argumentedVAFList, std::vector<MeshData>& meshData);
+
+	// Buffer allocation, has to be done in serial
+	static std::vector<std::shared_ptr<Mesh>> CreateMeshes(const std::vector<MeshData>& meshData);
+
 	static void ExtractAnimations(const aiScene* pScene);
 	static DualQuaterniond ExtractBoneInfo(const aiBone* pBone);
-	static std::shared_ptr<BaseObject> AssemblyNode(const aiNode* pAssimpNode, const aiScene* pScene, const std::vector<uint32_t>& argumentedVAFList, SceneInfo& sceneInfo);
+	static std::shared_ptr<BaseObject> AssemblyNode(const aiNode* pAssimpNode, const std::vector<std::shared_ptr<Mesh>>& meshes, SceneInfo& sceneInfo);
+
+	static std::string AcquireCookedPath(const std::string& path, bool preTransformVertices);
+	static std::shared_ptr<CookedMeshFile> AcquireCookedFile(const std::string& path, const std::vector<uint32_t>& argumentedVAFList, bool preTransformVertices);
 };
\ No newline at end of file
@@ -229,11 +229,6 @@ void BloomMaterial::CustomizeMaterialLayout(std::vector<UniformVarList>& materia
 	}
 }
 
-void BloomMaterial::CustomizePoolSize(std::vector<uint32_t>& counts)
-{
-	counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount());
-}
-
 void BloomMaterial::CustomizeSecondaryCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong)
 {
 	Vector2f size = { (float)pFrameBuffer->GetFramebufferInfo().width, (float)pFrameBuffer->GetFramebufferInfo().height };
@@ -241,49 +236,4 @@ void BloomMaterial::CustomizeSecondaryCmd(const std::shared_ptr<CommandBuffer>&
 	size = { 1.0f / size.x, 1.0f / size.y };
 
 	pCmdBuf->PushConstants(m_pPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Vector2f), &size);
-}
-
-void BloomMaterial::AttachResourceBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong)
-{
-	std::shared_ptr<Image> pBarrierImg;
-
-	switch (m_bloomPass)
-	{
-	case BloomPass_Prefilter:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::CombineLayer)->GetColorTarget(0);
-		break;
-	case BloomPass_DownSampleBox13:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, m_iterIndex)->GetColorTarget(0);
-		break;
-	case BloomPass_UpSampleTent:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, m_iterIndex + 1)->GetColorTarget(0);
-		break;
-	default:
-		ASSERTION(false);
-		break;
-	}
-
-	VkImageSubresourceRange subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = pBarrierImg->GetImageInfo().mipLevels;
-	subresourceRange.layerCount = pBarrierImg->GetImageInfo().arrayLayers;
-
-	VkImageMemoryBarrier imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pBarrierImg->GetDeviceHandle();
-	imgBarrier.subresourceRange = subresourceRange;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		{},
-		{},
-		{ imgBarrier }
-	);
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "CascadedShadowMap.h"
+#include "../common/Macros.h"
+#include "../Maths/MathUtil.h"
+#include <algorithm>
+#include <cmath>
+
+const double CascadedShadowMap::DEFAULT_SPLIT_LAMBDA = 0.75;
+
+void CascadedShadowMap::ComputeSplits(double nearPlane, double farPlane, uint32_t count, double lambda, double* pSplits)
+{
+	ASSERTION(nearPlane > 0 && farPlane > nearPlane && count > 0);
+
+	// Logarithmic splits keep texel to pixel ratio even along depth but crowd near plane, uniform ones do the opposite
+	for (uint32_t i = 1; i < count; i++)
+	{
+		double ratio = (double)i / count;
+		double logSplit = nearPlane * std::pow(farPlane / nearPlane, ratio);
+		double uniformSplit = nearPlane + (farPlane - nearPlane) * ratio;
+		pSplits[i] = lambda * logSplit + (1 - lambda) * uniformSplit;
+	}
+
+	pSplits[0] = nearPlane;
+	pSplits[count] = farPlane;
+}
+
+CascadedShadowMap::Cascade CascadedShadowMap::FitCascade(const Matrix4d& cameraTransform, double tangentFOV_2, double aspect, double splitNear, double splitFar, const Matrix4d& lightTransform, uint32_t resolution, double casterMaxZ, double margin)
+{
+	ASSERTION(splitFar > splitNear && resolution > 0);
+
+	// Bounding sphere of slice centers on view axis, "k2" is squared tangent of half diagonal fov
+	// Center depth is where near and far corners are equally far, or far plane for a slice too wide for that
+	// Radius depends on nothing but slice and fov, which is what keeps box size fixed while camera rotates
+	double k2 = tangentFOV_2 * tangentFOV_2 * (1 + aspect * aspect);
+	double centerDepth = std::min(splitFar, 0.5 * (splitNear + splitFar) * (1 + k2));
+	double radius = std::sqrt((splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * k2) * (1 + margin);
+
+	Cascade cascade;
+	cascade.splitNear = splitNear;
+	cascade.splitFar = splitFar;
+	cascade.texelSize = radius * 2 / resolution;
+
+	Matrix4d worldToLight = lightTransform;
+	worldToLight.Inverse();
+	Vector3d center = worldToLight.TransformAsPoint(cameraTransform.TransformAsPoint({ 0, 0, -centerDepth }));
+
+	// Box moves by whole texels only, and its size is a whole number of texels, so texels it rasterizes stay put
+	center.x = std::floor(center.x / cascade.texelSize + 0.5) * cascade.texelSize;
+	center.y = std::floor(center.y / cascade.texelSize + 0.5) * cascade.texelSize;
+
+	cascade.boxMin = center - radius;
+	cascade.boxMax = center + radius;
+	cascade.boxMax.z = std::max(cascade.boxMax.z, casterMaxZ);
+	return cascade;
+}
+
+Matrix4d CascadedShadowMap::AcquireProjection(const Cascade& cascade)
+{
+	Vector3d center = (cascade.boxMin + cascade.boxMax) * 0.5;
+	Vector3d halfSize = (cascade.boxMax - cascade.boxMin) * 0.5;
+
+	Matrix4d projection;
+	projection.c00 = 1.0 / halfSize.x;
+	projection.c30 = -center.x / halfSize.x;
+
+	// Reverse y top side down for vulkan ndc
+	projection.c11 = -1.0 / halfSize.y;
+	projection.c31 = center.y / halfSize.y;
+
+	// Nearest to light goes to 1, shadow pass keeps greater depth
+	projection.c22 = 1.0 / (cascade.boxMax.z - cascade.boxMin.z);
+	projection.c32 = -cascade.boxMin.z / (cascade.boxMax.z - cascade.boxMin.z);
+
+	return projection;
+}
+
+PyramidFrustumd CascadedShadowMap::AcquireFrustum(const Cascade& cascade, const Matrix4d& lightTransform)
+{
+	// Opposite planes of an orthographic box are parallel
+	PyramidFrustumd frustum;
+	frustum.planes[PyramidFrustumd::FrustumFace_LEFT]	= Planed({ 1, 0, 0 },	cascade.boxMin);
+	frustum.planes[PyramidFrustumd::FrustumFace_RIGHT]	= Planed({ -1, 0, 0 },	cascade.boxMax);
+	frustum.planes[PyramidFrustumd::FrustumFace_BOTTOM]	= Planed({ 0, 1, 0 },	cascade.boxMin);
+	frustum.planes[PyramidFrustumd::FrustumFace_TOP]	= Planed({ 0, -1, 0 },	cascade.boxMax);
+	frustum.planes[PyramidFrustumd::FrustumFace_NEAR]	= Planed({ 0, 0, -1 },	cascade.boxMax);
+	frustum.planes[PyramidFrustumd::FrustumFace_FAR]	= Planed({ 0, 0, 1 },	cascade.boxMin);
+	frustum.head = (cascade.boxMin + cascade.boxMax) * 0.5;
+
+	frustum.Transform(lightTransform);
+	return frustum;
+}
+
+void CascadedShadowMap::AcquireLightSpaceBounds(const Matrix4d& lightTransform, const Vector3d& worldMin, const Vector3d& worldMax, Vector3d& lightSpaceMin, Vector3d& lightSpaceMax)
+{
+	Matrix4d worldToLight = lightTransform;
+	worldToLight.Inverse();
+
+	Vector3d center = worldToLight.TransformAsPoint((worldMin + worldMax) * 0.5);
+	Vector3d worldExtents = (worldMax - worldMin) * 0.5;
+	Vector3d extents;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+			extents[i] += std::abs(worldToLight.c[j][i]) * worldExtents[j];
+	}
+
+	lightSpaceMin = center - extents;
+	lightSpaceMax = center + extents;
+}
+
+bool CascadedShadowMap::Contains(const Cascade& outer, const Cascade& inner)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (inner.boxMin[i] < outer.boxMin[i] || inner.boxMax[i] > outer.boxMax[i])
+			return false;
+	}
+	return true;
+}
+
+bool CascadedShadowMap::Overlaps(const Cascade& cascade, const Matrix4d& lightTransform, const Vector3d& worldMin, const Vector3d& worldMax)
+{
+	Vector3d boundsMin, boundsMax;
+	AcquireLightSpaceBounds(lightTransform, worldMin, worldMax, boundsMin, boundsMax);
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (boundsMax[i] < cascade.boxMin[i] || boundsMin[i] > cascade.boxMax[i])
+			return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Maths/Vector.h"
+#include "../Maths/Matrix.h"
+#include "../Maths/PyramidFrustum.h"
+#include <cstdint>
+
+// Cascade math of a directional light's shadow map, no dependency on renderer
+// Camera frustum is cut into slices by practical split scheme, a blend of logarithmic and uniform splits, and each slice is covered
+// by an orthographic box fit to its bounding sphere: box size doesn't change however camera rotates, and its center snaps to
+// shadow map texels, so shadow edges don't swim while camera moves
+// Light space is local space of light, light shines along its -z, i.e. greater z is nearer to light
+class CascadedShadowMap
+{
+public:
+	static const double DEFAULT_SPLIT_LAMBDA;
+
+	typedef struct _Cascade
+	{
+		Vector3d	boxMin;			// Light space box shadow map of this cascade covers
+		Vector3d	boxMax;
+		double		splitNear;		// Depth range of camera frustum slice, along camera's -z
+		double		splitFar;
+		double		texelSize;		// Light space size of a shadow map texel
+	}Cascade;
+
+public:
+	// "pSplits" receives "count + 1" depths from "nearPlane" to "farPlane", "lambda" 1 is fully logarithmic and 0 fully uniform
+	static void ComputeSplits(double nearPlane, double farPlane, uint32_t count, double lambda, double* pSplits);
+
+	// "cameraTransform" is camera to world, camera looks down -z, "lightTransform" is light to world
+	// Box is stretched towards light up to "casterMaxZ" so that casters between light and slice still cast
+	// "margin" grows box by this fraction of its size, a cached cascade keeps covering its slice while camera moves a little
+	static Cascade FitCascade(const Matrix4d& cameraTransform, double tangentFOV_2, double aspect, double splitNear, double splitFar, const Matrix4d& lightTransform, uint32_t resolution, double casterMaxZ, double margin = 0);
+
+	// Light space to vulkan ndc: x, y within [-1, 1] with y flipped, z within [0, 1] and 1 nearest to light
+	static Matrix4d AcquireProjection(const Cascade& cascade);
+
+	// World space volume a cascade covers
+	static PyramidFrustumd AcquireFrustum(const Cascade& cascade, const Matrix4d& lightTransform);
+
+	// Light space bounds of a world space box
+	static void AcquireLightSpaceBounds(const Matrix4d& lightTransform, const Vector3d& worldMin, const Vector3d& worldMax, Vector3d& lightSpaceMin, Vector3d& lightSpaceMax);
+
+	// Whether box of "outer" holds box of "inner", both fit with the same light transform
+	static bool Contains(const Cascade& outer, const Cascade& inner);
+
+	// Whether a world space box, e.g. a moved caster, touches what a cascade covers
+	static bool Overlaps(const Cascade& cascade, const Matrix4d& lightTransform, const Vector3d& worldMin, const Vector3d& worldMax);
+};
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "ClusteredLighting.h"
+#include "UniformData.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Shade point and spot lights in deferred pass, needs "pbr_deferred_shading.frag.spv" compile_all_shader.py generates
+// Until it's rebuilt, deferred shading doesn't read light buffer, so lights aren't even collected
+bool CLUSTERED_LIGHTING = false;
+
+// Assign cluster slices on worker threads, turn off to assign them all on main thread for comparison
+bool PARALLEL_LIGHT_CLUSTERING = true;
+
+const double ClusteredLighting::CLUSTER_NEAR_DEPTH = 0.1;
+const double ClusteredLighting::MAX_CLUSTER_DEPTH = 200.0;
+
+void ClusteredLighting::SubmitPointLight(const Vector3d& position, double range, const Vector3d& color)
+{
+	if (!CLUSTERED_LIGHTING)
+		return;
+
+	m_lights.push_back({ position, { 0, 0, -1 }, color, range, -1, -1, PerFrameLightUniforms::LightType_Point });
+}
+
+void ClusteredLighting::SubmitSpotLight(const Vector3d& position, const Vector3d& direction, double range, double innerAngle, double outerAngle, const Vector3d& color)
+{
+	if (!CLUSTERED_LIGHTING)
+		return;
+
+	outerAngle = std::max(outerAngle, 1e-3);
+	innerAngle = std::min(innerAngle, outerAngle * 0.999);
+	m_lights.push_back({ position, direction.Normal(), color, range, std::cos(innerAngle), std::cos(outerAngle), PerFrameLightUniforms::LightType_Spot });
+}
+
+void ClusteredLighting::Flush()
+{
+	m_lastFlushStatistics = {};
+	m_lastFlushStatistics.submittedCount = (uint32_t)m_lights.size();
+
+	std::shared_ptr<PerFrameLightUniforms> pLightUniforms = UniformData::GetInstance()->GetPerFrameLightUniforms();
+
+	// Nothing now and nothing last frame, buffers already tell there's no light
+	if (m_lights.size() == 0 && pLightUniforms->GetLightsCount() == 0)
+		return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::shared_ptr<GlobalUniforms> pGlobalUniforms = UniformData::GetInstance()->GetGlobalUniforms();
+	Matrix4d view = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewMatrix();
+
+	uint32_t count = std::min((uint32_t)m_lights.size(), PerFrameLightUniforms::MAX_LIGHTS);
+	m_lightData.resize(count);
+	m_lightSpheres.resize(count);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Light& light = m_lights[i];
+		Vector3d position = view.TransformAsPoint(light.position);
+		Vector3d direction = view.TransformAsVector(light.direction);
+
+		// Cone fall off reaches 1 at inner angle and 0 at outer one
+		double spotScale = 1.0 / std::max(light.cosInnerAngle - light.cosOuterAngle, 1e-4);
+
+		m_lightData[i] =
+		{
+			Vector4f((float)position.x, (float)position.y, (float)position.z, (float)light.range),
+			Vector4f((float)light.color.x, (float)light.color.y, (float)light.color.z, (float)light.type),
+			Vector4f((float)direction.x, (float)direction.y, (float)direction.z, 0),
+			Vector4f((float)spotScale, (float)(-light.cosOuterAngle * spotScale), 0, 0)
+		};
+
+		// Smallest sphere around spot light's cone: through apex and rim for narrow cones, around rim for wide ones
+		Vector3d center = position;
+		double radius = light.range;
+		if (light.type == PerFrameLightUniforms::LightType_Spot && light.cosOuterAngle > 0)
+		{
+			double sinOuterAngle = std::sqrt(1.0 - light.cosOuterAngle * light.cosOuterAngle);
+			double axisDistance;
+			if (light.cosOuterAngle >= sinOuterAngle)
+			{
+				radius = light.range / (2.0 * light.cosOuterAngle);
+				axisDistance = radius;
+			}
+			else
+			{
+				radius = light.range * sinOuterAngle;
+				axisDistance = light.range * light.cosOuterAngle;
+			}
+
+			center = position + direction * axisDistance;
+		}
+
+		m_lightSpheres[i] = { Vector3f((float)center.x, (float)center.y, (float)center.z), (float)radius };
+	}
+
+	double farDepth = std::min(pGlobalUniforms->GetMainCameraFarPlane(), MAX_CLUSTER_DEPTH);
+	m_lightClusterGrid.SetView(pGlobalUniforms->GetMainCameraHorizontalTangentFOV_2(), pGlobalUniforms->GetMainCameraVerticalTangentFOV_2(), CLUSTER_NEAR_DEPTH, std::max(farDepth, CLUSTER_NEAR_DEPTH * 2));
+	m_lightClusterGrid.SetLights(m_lightSpheres.data(), count);
+
+	// Jobs write disjoint clusters, nothing to synchronize but the end
+	for (uint32_t i = 0; i < m_lightClusterGrid.GetJobCount(); i++)
+	{
+		auto job = [this, i](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+		{
+			m_lightClusterGrid.AssignJob(i);
+		};
+
+		if (PARALLEL_LIGHT_CLUSTERING)
+			FrameMgr()->AddJobToFrame(job);
+		else
+			job(nullptr);
+	}
+
+	if (PARALLEL_LIGHT_CLUSTERING)
+		GlobalThreadTaskQueue()->WaitForFree();
+
+	pLightUniforms->SetLights(m_lightData.data(), count);
+	m_lastFlushStatistics.lightIndicesCount = pLightUniforms->SetClusters(m_lightClusterGrid);
+	m_lastFlushStatistics.droppedIndicesCount = m_lightClusterGrid.GetDroppedIndicesCount();
+	m_lastFlushStatistics.visibleCount = m_lightClusterGrid.GetVisibleLightsCount();
+	m_lastFlushStatistics.assignTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	m_lights.clear();
+}
\ No newline at end of file
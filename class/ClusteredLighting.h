@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "../Maths/Vector.h"
+#include "LightClusterGrid.h"
+#include "PerFrameLightUniforms.h"
+#include <vector>
+
+// Frame wide list of point and spot lights of main camera
+// Lights submit themselves while scene is traversed, "Flush" moves them to camera space, assigns them to clusters of view frustum
+// on worker threads and hands lights and cluster lists over to "PerFrameLightUniforms" for deferred shading
+// Lights are dropped as they're submitted unless "CLUSTERED_LIGHTING" is on, light buffer then stays empty
+class ClusteredLighting : public Singleton<ClusteredLighting>
+{
+public:
+	// Clusters start here, pixels closer than this all share slice 0
+	static const double CLUSTER_NEAR_DEPTH;
+
+	// Clusters end at camera far plane or here, whichever is closer, lights don't reach pixels beyond
+	static const double MAX_CLUSTER_DEPTH;
+
+	typedef struct _Statistics
+	{
+		uint32_t	submittedCount;
+		uint32_t	visibleCount;		// In front of camera, within cluster depth and on screen
+		uint32_t	lightIndicesCount;
+		uint32_t	droppedIndicesCount;	// Didn't fit in light index buffer
+		double		assignTime;			// Milliseconds
+	}Statistics;
+
+public:
+	// World space, "range" is where light fades out to 0
+	void SubmitPointLight(const Vector3d& position, double range, const Vector3d& color);
+
+	// World space, angles are half angles of cone in radian, light falls off from inner to outer one
+	void SubmitSpotLight(const Vector3d& position, const Vector3d& direction, double range, double innerAngle, double outerAngle, const Vector3d& color);
+
+	// Called once per frame after scene is traversed, lights of this frame are dropped afterwards
+	void Flush();
+
+	const Statistics& GetLastFlushStatistics() const { return m_lastFlushStatistics; }
+
+protected:
+	typedef struct _Light
+	{
+		Vector3d	position;
+		Vector3d	direction;
+		Vector3d	color;
+		double		range;
+		double		cosInnerAngle;
+		double		cosOuterAngle;
+		uint32_t	type;
+	}Light;
+
+protected:
+	std::vector<Light>								m_lights;
+	std::vector<PerFrameLightUniforms::LightData>	m_lightData;
+	std::vector<LightClusterGrid::LightSphere>		m_lightSpheres;
+	LightClusterGrid								m_lightClusterGrid;
+	Statistics										m_lastFlushStatistics = {};
+};
\ No newline at end of file
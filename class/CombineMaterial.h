@@ -16,19 +16,17 @@ protected:
 		uint32_t vertexFormatInMem);
 
 	void CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout) override;
-	void CustomizePoolSize(std::vector<uint32_t>& counts) override;
 
 	void CustomizeSecondaryCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0) override;
-	void AttachResourceBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong = 0) override;
 
 public:
 	static std::shared_ptr<CombineMaterial> CreateDefaultMaterial();
 
 public:
 	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const Vector3d& groupNum, const Vector3d& groupSize, uint32_t pingpong = 0) override {}
-	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
+	std::shared_ptr<CommandBuffer> RecordDrawCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
 	{
-		DrawScreenQuad(pCmdBuf, pFrameBuffer, pingpong, overrideVP);
+		return RecordScreenQuadCmd(pPerFrameRes, pFrameBuffer, pingpong, overrideVP);
 	}
 
 private:
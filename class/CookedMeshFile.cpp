@@ -0,0 +1,414 @@
+#include "CookedMeshFile.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "../common/Macros.h"
+#include "../common/Util.h"
+#include "../Maths/AssimpDataConverter.h"
+#include "Importer.hpp"
+#include "postprocess.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <sys/stat.h>
+
+static_assert(sizeof(aiMatrix4x4) == sizeof(float) * 16, "Cooked mesh file expects single precision assimp matrices");
+
+static uint64_t AlignBlock(uint64_t offset)
+{
+	return (offset + CookedMeshFile::BLOCK_ALIGNMENT - 1) / CookedMeshFile::BLOCK_ALIGNMENT * CookedMeshFile::BLOCK_ALIGNMENT;
+}
+
+uint64_t CookedMeshFile::AcquireFileBytes(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+	return (uint64_t)file.tellg();
+}
+
+uint64_t CookedMeshFile::AcquireFileTime(const std::string& path)
+{
+#if defined(_WIN32)
+	struct _stat64 fileStat;
+	if (_stat64(path.c_str(), &fileStat) != 0)
+		return 0;
+#else
+	struct stat fileStat;
+	if (stat(path.c_str(), &fileStat) != 0)
+		return 0;
+#endif
+	return (uint64_t)fileStat.st_mtime;
+}
+
+uint64_t CookedMeshFile::AcquireFileHash(const std::string& path)
+{
+	std::shared_ptr<MappedFile> pMappedFile = MappedFile::Create(path);
+	if (pMappedFile == nullptr)
+		return 0;
+
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	const uint8_t* pData = pMappedFile->GetData();
+	for (uint64_t i = 0; i < pMappedFile->GetSize(); i++)
+	{
+		hash ^= pData[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+CookedMeshFile::NameRef CookedMeshFile::AddName(const char* pName, uint32_t length, std::vector<char>& stringTable)
+{
+	NameRef nameRef = { (uint32_t)stringTable.size(), length };
+	stringTable.insert(stringTable.end(), pName, pName + length);
+	return nameRef;
+}
+
+void CookedMeshFile::CookNode(const aiNode* pAssimpNode, int32_t parentIndex, std::vector<NodeEntry>& nodes, std::vector<uint32_t>& nodeMeshIndices, std::vector<char>& stringTable)
+{
+	if (pAssimpNode == nullptr)
+		return;
+
+	NodeEntry node = {};
+	node.name = AddName(pAssimpNode->mName.C_Str(), (uint32_t)pAssimpNode->mName.length, stringTable);
+	node.parentIndex = parentIndex;
+	node.meshIndexStart = (uint32_t)nodeMeshIndices.size();
+	node.meshIndexCount = pAssimpNode->mNumMeshes;
+	memcpy(node.transformation, &pAssimpNode->mTransformation, sizeof(node.transformation));
+
+	nodeMeshIndices.insert(nodeMeshIndices.end(), pAssimpNode->mMeshes, pAssimpNode->mMeshes + pAssimpNode->mNumMeshes);
+
+	int32_t nodeIndex = (int32_t)nodes.size();
+	nodes.push_back(node);
+
+	for (uint32_t i = 0; i < pAssimpNode->mNumChildren; i++)
+		CookNode(pAssimpNode->mChildren[i], nodeIndex, nodes, nodeMeshIndices, stringTable);
+}
+
+bool CookedMeshFile::Cook(const std::string& srcPath, const std::string& dstPath, const std::vector<uint32_t>& argumentedVAFList, bool preTransformVertices)
+{
+	ASSERTION(argumentedVAFList.size() <= MAX_ARGUMENTED_VAF_COUNT);
+
+	uint32_t importFlags = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
+	if (preTransformVertices)
+		importFlags |= aiProcess_PreTransformVertices;
+
+	Assimp::Importer imp;
+	const aiScene* pScene = imp.ReadFile(srcPath.c_str(), importFlags);
+	if (pScene == nullptr)
+		return false;
+
+	Header header = {};
+	header.magic = COOKED_MESH_MAGIC;
+	header.version = COOKED_MESH_VERSION;
+	header.sourceFileBytes = AcquireFileBytes(srcPath);
+	header.sourceFileTime = AcquireFileTime(srcPath);
+	header.sourceFileHash = AcquireFileHash(srcPath);
+	header.preTransformVertices = preTransformVertices;
+	header.hasAnimation = pScene->mNumAnimations > 0;
+	header.argumentedVAFCount = (uint32_t)argumentedVAFList.size();
+	for (uint32_t i = 0; i < argumentedVAFList.size(); i++)
+		header.argumentedVAFs[i] = argumentedVAFList[i];
+
+	std::vector<MeshEntry>				meshes(pScene->mNumMeshes);
+	std::vector<BoneEntry>				bones;
+	std::vector<NodeEntry>				nodes;
+	std::vector<uint32_t>				nodeMeshIndices;
+	std::vector<char>					stringTable;
+	std::vector<std::vector<uint8_t>>	vertexData(pScene->mNumMeshes);
+	std::vector<std::vector<uint32_t>>	indexData(pScene->mNumMeshes);
+
+	for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+	{
+		const aiMesh* pMesh = pScene->mMeshes[i];
+		uint32_t vertexFormat = Mesh::AcquireVertexFormat(pMesh);
+
+		// Same rule as reading directly from assimp: first matching argumented vertex format wins
+		auto it = std::find_if(argumentedVAFList.begin(), argumentedVAFList.end(), [vertexFormat](uint32_t vaf)
+		{
+			return Mesh::MatchVertexFormat(vertexFormat, vaf);
+		});
+
+		meshes[i] = {};
+		if (it == argumentedVAFList.end())
+			continue;
+
+		VertexPacker::Dequantization dequantization;
+		MeshOptimizer::Report optimizeReport;
+		MeshSimplifier::LodChain lodChain;
+		vertexFormat = Mesh::AssemblyMeshData(pMesh, *it, vertexData[i], indexData[i], dequantization, optimizeReport, lodChain);
+
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			meshes[i].positionScale[j] = dequantization.positionScale[j];
+			meshes[i].positionBias[j] = dequantization.positionBias[j];
+			meshes[i].texCoordScaleBias[j] = dequantization.texCoordScaleBias[j];
+			meshes[i].boundingSphere[j] = lodChain.boundingSphere[j];
+		}
+
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			meshes[i].boundingBoxMin[j] = lodChain.boundingBoxMin[j];
+			meshes[i].boundingBoxMax[j] = lodChain.boundingBoxMax[j];
+		}
+
+		ASSERTION(lodChain.lods.size() <= MeshSimplifier::MAX_LOD_COUNT);
+		meshes[i].lodCount = (uint32_t)lodChain.lods.size();
+		for (uint32_t j = 0; j < lodChain.lods.size(); j++)
+			meshes[i].lods[j] = { lodChain.lods[j].firstIndex, lodChain.lods[j].indicesCount, lodChain.lods[j].error, 0 };
+
+		meshes[i].optimizeReport = optimizeReport;
+		meshes[i].vertexFormat = vertexFormat;
+		meshes[i].verticesCount = (uint32_t)(vertexData[i].size() / GetVertexBytes(vertexFormat));
+		meshes[i].indicesCount = (uint32_t)indexData[i].size();
+		meshes[i].boneStart = (uint32_t)bones.size();
+		meshes[i].boneCount = pMesh->mNumBones;
+
+		for (uint32_t j = 0; j < pMesh->mNumBones; j++)
+		{
+			BoneEntry bone = {};
+			bone.name = AddName(pMesh->mBones[j]->mName.C_Str(), (uint32_t)pMesh->mBones[j]->mName.length, stringTable);
+			memcpy(bone.offsetMatrix, &pMesh->mBones[j]->mOffsetMatrix, sizeof(bone.offsetMatrix));
+			bones.push_back(bone);
+		}
+	}
+
+	// Pre-transformed scene is flattened, hierarchy makes no sense
+	if (!preTransformVertices)
+		CookNode(pScene->mRootNode, -1, nodes, nodeMeshIndices, stringTable);
+
+	// Layout blocks
+	uint64_t offset = AlignBlock(sizeof(Header));
+
+	header.meshCount = (uint32_t)meshes.size();
+	header.meshTableOffset = (uint32_t)offset;
+	offset = AlignBlock(offset + sizeof(MeshEntry) * meshes.size());
+
+	header.boneCount = (uint32_t)bones.size();
+	header.boneTableOffset = (uint32_t)offset;
+	offset = AlignBlock(offset + sizeof(BoneEntry) * bones.size());
+
+	header.nodeCount = (uint32_t)nodes.size();
+	header.nodeTableOffset = (uint32_t)offset;
+	offset = AlignBlock(offset + sizeof(NodeEntry) * nodes.size());
+
+	header.nodeMeshIndexCount = (uint32_t)nodeMeshIndices.size();
+	header.nodeMeshIndexTableOffset = (uint32_t)offset;
+	offset = AlignBlock(offset + sizeof(uint32_t) * nodeMeshIndices.size());
+
+	header.stringTableBytes = (uint32_t)stringTable.size();
+	header.stringTableOffset = (uint32_t)offset;
+	offset = AlignBlock(offset + stringTable.size());
+
+	for (uint32_t i = 0; i < meshes.size(); i++)
+	{
+		meshes[i].vertexDataOffset = (uint32_t)offset;
+		offset = AlignBlock(offset + vertexData[i].size());
+
+		meshes[i].indexDataOffset = (uint32_t)offset;
+		offset = AlignBlock(offset + indexData[i].size() * sizeof(uint32_t));
+	}
+
+	// Offsets are stored as 32 bits
+	if (offset > UINT32_MAX)
+		return false;
+
+	header.fileBytes = offset;
+
+	// Assemble the whole file in memory and write it out in one go
+	std::vector<uint8_t> fileData(offset, 0);
+	memcpy(fileData.data(), &header, sizeof(Header));
+	if (meshes.size() > 0)
+		memcpy(fileData.data() + header.meshTableOffset, meshes.data(), sizeof(MeshEntry) * meshes.size());
+	if (bones.size() > 0)
+		memcpy(fileData.data() + header.boneTableOffset, bones.data(), sizeof(BoneEntry) * bones.size());
+	if (nodes.size() > 0)
+		memcpy(fileData.data() + header.nodeTableOffset, nodes.data(), sizeof(NodeEntry) * nodes.size());
+	if (nodeMeshIndices.size() > 0)
+		memcpy(fileData.data() + header.nodeMeshIndexTableOffset, nodeMeshIndices.data(), sizeof(uint32_t) * nodeMeshIndices.size());
+	if (stringTable.size() > 0)
+		memcpy(fileData.data() + header.stringTableOffset, stringTable.data(), stringTable.size());
+
+	for (uint32_t i = 0; i < meshes.size(); i++)
+	{
+		if (vertexData[i].size() > 0)
+			memcpy(fileData.data() + meshes[i].vertexDataOffset, vertexData[i].data(), vertexData[i].size());
+		if (indexData[i].size() > 0)
+			memcpy(fileData.data() + meshes[i].indexDataOffset, indexData[i].data(), indexData[i].size() * sizeof(uint32_t));
+	}
+
+	std::ofstream file(dstPath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)fileData.data(), fileData.size());
+	return file.good();
+}
+
+std::shared_ptr<CookedMeshFile> CookedMeshFile::Load(const std::string& path)
+{
+	std::shared_ptr<MappedFile> pMappedFile = MappedFile::Create(path);
+	if (pMappedFile == nullptr)
+		return nullptr;
+
+	std::shared_ptr<CookedMeshFile> pCookedMeshFile = std::make_shared<CookedMeshFile>();
+	if (pCookedMeshFile.get() && pCookedMeshFile->Init(pCookedMeshFile, pMappedFile))
+		return pCookedMeshFile;
+	return nullptr;
+}
+
+bool CookedMeshFile::Init(const std::shared_ptr<CookedMeshFile>& pSelf, const std::shared_ptr<MappedFile>& pMappedFile)
+{
+	if (!SelfRefBase<CookedMeshFile>::Init(pSelf))
+		return false;
+
+	uint64_t fileBytes = pMappedFile->GetSize();
+	const uint8_t* pData = pMappedFile->GetData();
+
+	if (fileBytes < sizeof(Header))
+		return false;
+
+	const Header* pHeader = (const Header*)pData;
+	if (pHeader->magic != COOKED_MESH_MAGIC || pHeader->version != COOKED_MESH_VERSION || pHeader->fileBytes != fileBytes)
+		return false;
+
+	if (pHeader->argumentedVAFCount > MAX_ARGUMENTED_VAF_COUNT)
+		return false;
+
+	// Make sure every block stays inside of the file, so that a truncated or corrupted file won't be read out of bounds
+	auto blockValid = [fileBytes](uint64_t blockOffset, uint64_t blockBytes)
+	{
+		return blockOffset % BLOCK_ALIGNMENT == 0 && blockOffset + blockBytes <= fileBytes;
+	};
+
+	if (!blockValid(pHeader->meshTableOffset, sizeof(MeshEntry) * (uint64_t)pHeader->meshCount) ||
+		!blockValid(pHeader->boneTableOffset, sizeof(BoneEntry) * (uint64_t)pHeader->boneCount) ||
+		!blockValid(pHeader->nodeTableOffset, sizeof(NodeEntry) * (uint64_t)pHeader->nodeCount) ||
+		!blockValid(pHeader->nodeMeshIndexTableOffset, sizeof(uint32_t) * (uint64_t)pHeader->nodeMeshIndexCount) ||
+		!blockValid(pHeader->stringTableOffset, pHeader->stringTableBytes))
+		return false;
+
+	const MeshEntry* pMeshes = (const MeshEntry*)(pData + pHeader->meshTableOffset);
+	const BoneEntry* pBones = (const BoneEntry*)(pData + pHeader->boneTableOffset);
+	const NodeEntry* pNodes = (const NodeEntry*)(pData + pHeader->nodeTableOffset);
+	const uint32_t* pNodeMeshIndices = (const uint32_t*)(pData + pHeader->nodeMeshIndexTableOffset);
+
+	auto nameValid = [pHeader](const NameRef& nameRef)
+	{
+		return (uint64_t)nameRef.offset + nameRef.length <= pHeader->stringTableBytes;
+	};
+
+	for (uint32_t i = 0; i < pHeader->meshCount; i++)
+	{
+		const MeshEntry& mesh = pMeshes[i];
+		if (mesh.vertexFormat == 0)
+			continue;
+
+		if (!blockValid(mesh.vertexDataOffset, (uint64_t)mesh.verticesCount * GetVertexBytes(mesh.vertexFormat)) ||
+			!blockValid(mesh.indexDataOffset, (uint64_t)mesh.indicesCount * sizeof(uint32_t)) ||
+			(uint64_t)mesh.boneStart + mesh.boneCount > pHeader->boneCount ||
+			mesh.lodCount > MeshSimplifier::MAX_LOD_COUNT)
+			return false;
+
+		for (uint32_t j = 0; j < mesh.lodCount; j++)
+		{
+			if ((uint64_t)mesh.lods[j].firstIndex + mesh.lods[j].indicesCount > mesh.indicesCount)
+				return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < pHeader->boneCount; i++)
+	{
+		if (!nameValid(pBones[i].name))
+			return false;
+	}
+
+	for (uint32_t i = 0; i < pHeader->nodeCount; i++)
+	{
+		const NodeEntry& node = pNodes[i];
+		if (!nameValid(node.name) ||
+			node.parentIndex >= (int32_t)i ||
+			(uint64_t)node.meshIndexStart + node.meshIndexCount > pHeader->nodeMeshIndexCount)
+			return false;
+
+		for (uint32_t j = 0; j < node.meshIndexCount; j++)
+		{
+			if (pNodeMeshIndices[node.meshIndexStart + j] >= pHeader->meshCount)
+				return false;
+		}
+	}
+
+	m_pMappedFile = pMappedFile;
+	m_pHeader = pHeader;
+	m_pMeshes = pMeshes;
+	m_pBones = pBones;
+	m_pNodes = pNodes;
+	m_pNodeMeshIndices = pNodeMeshIndices;
+	m_pStringTable = (const char*)(pData + pHeader->stringTableOffset);
+
+	return true;
+}
+
+bool CookedMeshFile::IsCompatible(const std::string& sourcePath, const std::vector<uint32_t>& argumentedVAFList, bool preTransformVertices) const
+{
+	if ((m_pHeader->preTransformVertices != 0) != preTransformVertices)
+		return false;
+
+	if (m_pHeader->argumentedVAFCount != argumentedVAFList.size())
+		return false;
+
+	for (uint32_t i = 0; i < argumentedVAFList.size(); i++)
+	{
+		if (m_pHeader->argumentedVAFs[i] != argumentedVAFList[i])
+			return false;
+	}
+
+	// Size and modification time are cheap to get, whole source file is only read when size matches but time doesn't, e.g. after a checkout
+	if (m_pHeader->sourceFileBytes != AcquireFileBytes(sourcePath))
+		return false;
+
+	if (m_pHeader->sourceFileTime == AcquireFileTime(sourcePath))
+		return true;
+
+	return m_pHeader->sourceFileHash == AcquireFileHash(sourcePath);
+}
+
+std::shared_ptr<Mesh> CookedMeshFile::CreateMesh(uint32_t meshIndex) const
+{
+	ASSERTION(meshIndex < m_pHeader->meshCount);
+
+	const MeshEntry& mesh = m_pMeshes[meshIndex];
+	if (mesh.vertexFormat == 0)
+		return nullptr;
+
+	std::vector<std::size_t> boneNameHashes;
+	std::vector<DualQuaterniond> boneOffsets;
+	for (uint32_t i = mesh.boneStart; i < mesh.boneStart + mesh.boneCount; i++)
+	{
+		aiMatrix4x4 offsetMatrix;
+		memcpy(&offsetMatrix, m_pBones[i].offsetMatrix, sizeof(offsetMatrix));
+
+		boneNameHashes.push_back(Mesh::AcquireBoneNameHash(GetName(m_pBones[i].name)));
+		boneOffsets.push_back(AssimpDataConverter::AcquireDualQuaternion(offsetMatrix));
+	}
+
+	VertexPacker::Dequantization dequantization;
+	dequantization.positionScale = Vector4f(mesh.positionScale[0], mesh.positionScale[1], mesh.positionScale[2], mesh.positionScale[3]);
+	dequantization.positionBias = Vector4f(mesh.positionBias[0], mesh.positionBias[1], mesh.positionBias[2], mesh.positionBias[3]);
+	dequantization.texCoordScaleBias = Vector4f(mesh.texCoordScaleBias[0], mesh.texCoordScaleBias[1], mesh.texCoordScaleBias[2], mesh.texCoordScaleBias[3]);
+
+	MeshSimplifier::LodChain lodChain;
+	lodChain.boundingSphere = Vector4f(mesh.boundingSphere[0], mesh.boundingSphere[1], mesh.boundingSphere[2], mesh.boundingSphere[3]);
+	lodChain.boundingBoxMin = Vector3f(mesh.boundingBoxMin[0], mesh.boundingBoxMin[1], mesh.boundingBoxMin[2]);
+	lodChain.boundingBoxMax = Vector3f(mesh.boundingBoxMax[0], mesh.boundingBoxMax[1], mesh.boundingBoxMax[2]);
+	for (uint32_t i = 0; i < mesh.lodCount; i++)
+		lodChain.lods.push_back({ mesh.lods[i].firstIndex, mesh.lods[i].indicesCount, mesh.lods[i].error });
+
+	// No intermediate copy here, mapped memory goes straight to shared buffer update
+	return Mesh::Create
+	(
+		GetVertices(meshIndex), mesh.verticesCount, mesh.vertexFormat,
+		GetIndices(meshIndex), mesh.indicesCount, VK_INDEX_TYPE_UINT32,
+		boneNameHashes, boneOffsets, dequantization, lodChain
+	);
+}
\ No newline at end of file
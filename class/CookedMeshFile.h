@@ -0,0 +1,151 @@
+#pragma once
+#include "../Base/Base.h"
+#include "../common/MappedFile.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+class Mesh;
+struct aiNode;
+
+// Versioned binary mesh container, cooked offline from assimp and memory mapped at runtime
+// Every block starts at a 16 bytes aligned offset of the file, all offsets are relative to the beginning of the file
+//
+// Header
+// MeshEntry[meshCount]				vertex & index data layout of each mesh, as well as its bone range and LOD index ranges
+// BoneEntry[boneCount]				bones of all meshes, one after another
+// NodeEntry[nodeCount]				scene hierarchy in depth first order, parent always goes before its children
+// uint32_t[nodeMeshIndexCount]		mesh indices referenced by nodes
+// char[stringTableBytes]			names of bones and nodes
+// Vertex and index data			interleaved with the exact layout of "VertexFormat", welded and reordered by MeshOptimizer, packed if the argumented format asks for it, ready to be uploaded directly
+class CookedMeshFile : public SelfRefBase<CookedMeshFile>
+{
+public:
+	static const uint32_t COOKED_MESH_MAGIC = 0x434D4C56;	// "VLMC"
+	static const uint32_t COOKED_MESH_VERSION = 8;
+	static const uint32_t MAX_ARGUMENTED_VAF_COUNT = 8;
+	static const uint32_t BLOCK_ALIGNMENT = 16;
+
+	typedef struct _NameRef
+	{
+		uint32_t	offset;
+		uint32_t	length;
+	}NameRef;
+
+	typedef struct _Header
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint64_t	fileBytes;
+		uint64_t	sourceFileBytes;	// Used to tell if the source file has changed since cooked
+		uint64_t	sourceFileTime;		// Last modification, in seconds
+		uint64_t	sourceFileHash;		// Catches edits that keep the size, only compared when modification time differs
+		uint32_t	preTransformVertices;
+		uint32_t	hasAnimation;
+		uint32_t	argumentedVAFCount;
+		uint32_t	argumentedVAFs[MAX_ARGUMENTED_VAF_COUNT];
+
+		uint32_t	meshCount;
+		uint32_t	meshTableOffset;
+		uint32_t	boneCount;
+		uint32_t	boneTableOffset;
+		uint32_t	nodeCount;
+		uint32_t	nodeTableOffset;
+		uint32_t	nodeMeshIndexCount;
+		uint32_t	nodeMeshIndexTableOffset;
+		uint32_t	stringTableBytes;
+		uint32_t	stringTableOffset;
+	}Header;
+
+	typedef struct _LodEntry
+	{
+		uint32_t	firstIndex;
+		uint32_t	indicesCount;
+		float		error;
+		uint32_t	padding;
+	}LodEntry;
+
+	typedef struct _MeshEntry
+	{
+		uint32_t	vertexFormat;		// 0 means no argumented vertex format matches this mesh
+		uint32_t	verticesCount;
+		uint32_t	indicesCount;		// Always 32 bits indices, including all LODs
+		uint32_t	vertexDataOffset;
+		uint32_t	indexDataOffset;
+		uint32_t	boneStart;
+		uint32_t	boneCount;
+		uint32_t	padding;
+		float		positionScale[4];	// Same layout as VertexPacker::Dequantization
+		float		positionBias[4];
+		float		texCoordScaleBias[4];
+		float		boundingSphere[4];
+		float		boundingBoxMin[4];	// w unused
+		float		boundingBoxMax[4];
+		uint32_t	lodCount;
+		uint32_t	lodPadding[3];
+		LodEntry	lods[MeshSimplifier::MAX_LOD_COUNT];
+		MeshOptimizer::Report	optimizeReport;	// What welding and reordering did at cook time
+	}MeshEntry;
+
+	typedef struct _BoneEntry
+	{
+		NameRef		name;
+		float		offsetMatrix[16];	// Same layout as aiMatrix4x4
+	}BoneEntry;
+
+	typedef struct _NodeEntry
+	{
+		NameRef		name;
+		int32_t		parentIndex;		// -1 for root
+		uint32_t	meshIndexStart;
+		uint32_t	meshIndexCount;
+		float		transformation[16];	// Same layout as aiMatrix4x4
+	}NodeEntry;
+
+public:
+	// Import "srcPath" with assimp and write cooked result into "dstPath"
+	static bool Cook(const std::string& srcPath, const std::string& dstPath, const std::vector<uint32_t>& argumentedVAFList, bool preTransformVertices);
+
+	// Map cooked file, no parsing involved except header validation
+	static std::shared_ptr<CookedMeshFile> Load(const std::string& path);
+
+public:
+	const Header& GetHeader() const { return *m_pHeader; }
+	bool IsCompatible(const std::string& sourcePath, const std::vector<uint32_t>& argumentedVAFList, bool preTransformVertices) const;
+
+	uint32_t GetMeshCount() const { return m_pHeader->meshCount; }
+	const MeshEntry& GetMeshEntry(uint32_t meshIndex) const { return m_pMeshes[meshIndex]; }
+	const void* GetVertices(uint32_t meshIndex) const { return m_pMappedFile->GetData() + m_pMeshes[meshIndex].vertexDataOffset; }
+	const void* GetIndices(uint32_t meshIndex) const { return m_pMappedFile->GetData() + m_pMeshes[meshIndex].indexDataOffset; }
+
+	uint32_t GetNodeCount() const { return m_pHeader->nodeCount; }
+	const NodeEntry& GetNodeEntry(uint32_t nodeIndex) const { return m_pNodes[nodeIndex]; }
+	uint32_t GetNodeMeshIndex(uint32_t nodeIndex, uint32_t i) const { return m_pNodeMeshIndices[m_pNodes[nodeIndex].meshIndexStart + i]; }
+
+	std::string GetName(const NameRef& nameRef) const { return std::string(m_pStringTable + nameRef.offset, nameRef.length); }
+
+	// Vertex and index data are streamed directly from mapped memory into shared buffers
+	std::shared_ptr<Mesh> CreateMesh(uint32_t meshIndex) const;
+
+	static uint64_t AcquireFileBytes(const std::string& path);
+	static uint64_t AcquireFileTime(const std::string& path);
+	static uint64_t AcquireFileHash(const std::string& path);
+
+protected:
+	bool Init(const std::shared_ptr<CookedMeshFile>& pSelf, const std::shared_ptr<MappedFile>& pMappedFile);
+
+	static void CookNode(const aiNode* pAssimpNode, int32_t parentIndex, std::vector<NodeEntry>& nodes, std::vector<uint32_t>& nodeMeshIndices, std::vector<char>& stringTable);
+	static NameRef AddName(const char* pName, uint32_t length, std::vector<char>& stringTable);
+
+protected:
+	std::shared_ptr<MappedFile>	m_pMappedFile;
+
+	const Header*				m_pHeader = nullptr;
+	const MeshEntry*			m_pMeshes = nullptr;
+	const BoneEntry*			m_pBones = nullptr;
+	const NodeEntry*			m_pNodes = nullptr;
+	const uint32_t*				m_pNodeMeshIndices = nullptr;
+	const char*					m_pStringTable = nullptr;
+};
\ No newline at end of file
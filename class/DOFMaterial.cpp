@@ -307,135 +307,4 @@ void DOFMaterial::CustomizeMaterialLayout(std::vector<UniformVarList>& materialL
 			GetSwapChain()->GetSwapChainImageCount()
 		});
 	}
-}
-
-void DOFMaterial::CustomizePoolSize(std::vector<uint32_t>& counts)
-{
-	if (m_DOFPass == DOFPass_Prefilter)
-	{
-		counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount() + 2);
-	}
-	else if (m_DOFPass == DOFPass_Combine)
-	{
-		counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount() + 4);
-	}
-	else
-	{
-		counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount());
-	}
-	counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount());
-}
-
-void DOFMaterial::AttachResourceBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong)
-{
-	std::shared_ptr<Image> pBarrierImg;
-
-	switch (m_DOFPass)
-	{
-	case DOFPass_Prefilter:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (pingpong + 1) % 2)->GetColorTarget(FrameBufferDiction::CombinedResult);
-		break;
-	case DOFPass_Blur:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, DOFPass_Prefilter)->GetColorTarget(0);
-		break;
-	case DOFPass_Postfilter:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, DOFPass_Blur)->GetColorTarget(0);
-		break;
-	case DOFPass_Combine:
-		pBarrierImg = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, DOFPass_Postfilter)->GetColorTarget(0);
-		break;
-	default:
-		ASSERTION(false);
-		break;
-	}
-
-	std::vector<VkImageMemoryBarrier> barriers;
-
-	VkImageSubresourceRange subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = pBarrierImg->GetImageInfo().mipLevels;
-	subresourceRange.layerCount = pBarrierImg->GetImageInfo().arrayLayers;
-
-	VkImageMemoryBarrier imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pBarrierImg->GetDeviceHandle();
-	imgBarrier.subresourceRange = subresourceRange;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	barriers.push_back(imgBarrier);
-
-	if (m_DOFPass == DOFPass_Prefilter)
-	{
-		std::shared_ptr<Image> pCoCResult = FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (pingpong + 1) % 2)->GetColorTarget(FrameBufferDiction::CoC);
-
-		subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = pCoCResult->GetImageInfo().mipLevels;
-		subresourceRange.layerCount = pCoCResult->GetImageInfo().arrayLayers;
-
-		imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pCoCResult->GetDeviceHandle();
-		imgBarrier.subresourceRange = subresourceRange;
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		barriers.push_back(imgBarrier);
-	}
-	else if (m_DOFPass == DOFPass_Combine)
-	{
-		std::shared_ptr<Image> pShadingResult = FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (pingpong + 1) % 2)->GetColorTarget(FrameBufferDiction::CombinedResult);
-
-		subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = pShadingResult->GetImageInfo().mipLevels;
-		subresourceRange.layerCount = pShadingResult->GetImageInfo().arrayLayers;
-
-		imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pShadingResult->GetDeviceHandle();
-		imgBarrier.subresourceRange = subresourceRange;
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		barriers.push_back(imgBarrier);
-
-		std::shared_ptr<Image> pCoCResult = FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (pingpong + 1) % 2)->GetColorTarget(FrameBufferDiction::CoC);
-
-		subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = pCoCResult->GetImageInfo().mipLevels;
-		subresourceRange.layerCount = pCoCResult->GetImageInfo().arrayLayers;
-
-		imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pCoCResult->GetDeviceHandle();
-		imgBarrier.subresourceRange = subresourceRange;
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		barriers.push_back(imgBarrier);
-	}
-
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		{},
-		{},
-		barriers
-	);
 }
\ No newline at end of file
@@ -21,7 +21,7 @@
 #include "FrameBufferDiction.h"
 #include "../common/Util.h"
 
-std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool skinned)
+std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool skinned, bool packedVertex, bool gpuCulling)
 {
 	std::vector<UniformVar> vars =
 	{
@@ -50,16 +50,21 @@ std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool ski
 	};
 
 	SimpleMaterialCreateInfo simpleMaterialInfo = {};
-	std::wstring vert = skinned ? L"../data/shaders/pbr_gbuffer_gen_skinned.vert.spv" : L"../data/shaders/pbr_gbuffer_gen.vert.spv";
+	std::wstring vert = skinned ? L"../data/shaders/pbr_gbuffer_gen_skinned" : L"../data/shaders/pbr_gbuffer_gen";
+	vert += packedVertex ? L"_packed.vert.spv" : L".vert.spv";
 	simpleMaterialInfo.shaderPaths = { vert, L"", L"", L"", L"../data/shaders/pbr_gbuffer_gen.frag.spv", L"" };
 	simpleMaterialInfo.materialUniformVars = vars;
 	simpleMaterialInfo.vertexFormat = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
-	simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+	if (packedVertex)
+		simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTBPacked : VertexFormatPNTCTPacked;
+	else
+		simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
 	simpleMaterialInfo.subpassIndex = 0;
 	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_GBuffer;
 	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer);
 
 	std::shared_ptr<GBufferMaterial> pGbufferMaterial = std::make_shared<GBufferMaterial>();
+	pGbufferMaterial->m_gpuCulling = gpuCulling;
 
 	VkGraphicsPipelineCreateInfo createInfo = {};
 
@@ -306,16 +311,21 @@ bool DeferredShadingMaterial::Init(const std::shared_ptr<DeferredShadingMaterial
 		m_pUniformStorageDescriptorSet->UpdateImages(MaterialUniformStorageTypeCount + i, gbuffers);
 	}
 
+	// Each shadow cascade renders into a layer of its own, frames of a cascade are next to each other
+	// Cascade 0 comes first, so that it's where shaders compiled before cascades find the shadow map of a frame
 	std::vector<CombinedImage> depthBuffers;
-	for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
 	{
-		std::shared_ptr<FrameBuffer> pShadowPassFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_ShadowMap)[j];
+		for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
+		{
+			std::shared_ptr<FrameBuffer> pShadowPassFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_ShadowMap, i)[j];
 
-		depthBuffers.push_back({
-			pShadowPassFrameBuffer->GetDepthStencilTarget(),
-			pShadowPassFrameBuffer->GetDepthStencilTarget()->CreateLinearClampToBorderSampler(VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK),
-			pShadowPassFrameBuffer->GetDepthStencilTarget()->CreateDepthSampleImageView()
-		});
+			depthBuffers.push_back({
+				pShadowPassFrameBuffer->GetDepthStencilTarget(),
+				pShadowPassFrameBuffer->GetDepthStencilTarget()->CreateLinearClampToBorderSampler(VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK),
+				pShadowPassFrameBuffer->GetDepthStencilTarget()->CreateDepthSampleImageView()
+			});
+		}
 	}
 
 	m_pUniformStorageDescriptorSet->UpdateImages(MaterialUniformStorageTypeCount + FrameBufferDiction::GBufferCount + 1, depthBuffers);
@@ -398,7 +408,7 @@ void DeferredShadingMaterial::CustomizeMaterialLayout(std::vector<UniformVarList
 		CombinedSampler,
 		"ShadowMapDepthBuffer",
 		{},
-		GetSwapChain()->GetSwapChainImageCount()
+		GetSwapChain()->GetSwapChainImageCount() * SHADOW_CASCADE_COUNT
 	});
 
 	materialLayout.push_back(
@@ -416,131 +426,4 @@ void DeferredShadingMaterial::CustomizeMaterialLayout(std::vector<UniformVarList
 		{},
 		GetSwapChain()->GetSwapChainImageCount()
 	});
-}
-
-void DeferredShadingMaterial::CustomizePoolSize(std::vector<uint32_t>& counts)
-{
-	counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount() * (FrameBufferDiction::GBufferCount + 4));
-}
-
-void DeferredShadingMaterial::AttachResourceBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong)
-{
-	std::vector<VkImageMemoryBarrier> barriers;
-	for (uint32_t i = 0; i < FrameBufferDiction::GBufferCount; i++)
-	{
-		std::shared_ptr<Image> pGBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[FrameMgr()->FrameIndex()]->GetColorTarget(i);
-
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = pGBuffer->GetImageInfo().mipLevels;
-		subresourceRange.layerCount = pGBuffer->GetImageInfo().arrayLayers;
-
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pGBuffer->GetDeviceHandle();
-		imgBarrier.subresourceRange = subresourceRange;
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		barriers.push_back(imgBarrier);
-	}
-
-	std::shared_ptr<Image> pSSAOBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOBlurH)[FrameMgr()->FrameIndex()]->GetColorTarget(0);
-
-	VkImageSubresourceRange subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = pSSAOBuffer->GetImageInfo().mipLevels;
-	subresourceRange.layerCount = pSSAOBuffer->GetImageInfo().arrayLayers;
-
-	VkImageMemoryBarrier imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pSSAOBuffer->GetDeviceHandle();
-	imgBarrier.subresourceRange = subresourceRange;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	barriers.push_back(imgBarrier);
-
-	std::shared_ptr<Image> pSSRInfoBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOSSR)[FrameMgr()->FrameIndex()]->GetColorTarget(1);
-
-	subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = pSSRInfoBuffer->GetImageInfo().mipLevels;
-	subresourceRange.layerCount = pSSRInfoBuffer->GetImageInfo().arrayLayers;
-
-	imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pSSRInfoBuffer->GetDeviceHandle();
-	imgBarrier.subresourceRange = subresourceRange;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	barriers.push_back(imgBarrier);
-
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		{},
-		{},
-		barriers
-	);
-
-	barriers.clear();
-
-	std::shared_ptr<Image> pDepthTarget = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[FrameMgr()->FrameIndex()]->GetDepthStencilTarget();
-
-	subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = pDepthTarget->GetImageInfo().mipLevels;
-	subresourceRange.layerCount = pDepthTarget->GetImageInfo().arrayLayers;
-
-	imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pDepthTarget->GetDeviceHandle();
-	imgBarrier.subresourceRange = subresourceRange;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	barriers.push_back(imgBarrier);
-
-	std::shared_ptr<Image> pShadowMap = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_ShadowMap)[FrameMgr()->FrameIndex()]->GetDepthStencilTarget();
-
-	subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = pShadowMap->GetImageInfo().mipLevels;
-	subresourceRange.layerCount = pShadowMap->GetImageInfo().arrayLayers;
-
-	imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pShadowMap->GetDeviceHandle();
-	imgBarrier.subresourceRange = subresourceRange;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	barriers.push_back(imgBarrier);
-
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		{},
-		{},
-		barriers
-	);
 }
\ No newline at end of file
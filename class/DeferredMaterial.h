@@ -6,13 +6,13 @@ class RenderPassBase;
 class GBufferMaterial : public Material
 {
 public:
-	static std::shared_ptr<GBufferMaterial> CreateDefaultMaterial(bool skinned = false);
+	static std::shared_ptr<GBufferMaterial> CreateDefaultMaterial(bool skinned = false, bool packedVertex = false, bool gpuCulling = false);
 
 public:
 	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const Vector3d& groupNum, const Vector3d& groupSize, uint32_t pingpong = 0) override {}
-	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
+	std::shared_ptr<CommandBuffer> RecordDrawCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
 	{
-		DrawIndirect(pCmdBuf, pFrameBuffer, pingpong, overrideVP);
+		return RecordIndirectCmd(pPerFrameRes, pFrameBuffer, pingpong, overrideVP);
 	}
 };
 
@@ -28,16 +28,14 @@ protected:
 		uint32_t vertexFormatInMem);
 
 	void CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout) override;
-	void CustomizePoolSize(std::vector<uint32_t>& counts) override;
-	void AttachResourceBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong = 0) override;
 
 public:
 	static std::shared_ptr<DeferredShadingMaterial> CreateDefaultMaterial();
 
 public:
 	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const Vector3d& groupNum, const Vector3d& groupSize, uint32_t pingpong = 0) override {}
-	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
+	std::shared_ptr<CommandBuffer> RecordDrawCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
 	{
-		DrawScreenQuad(pCmdBuf, pFrameBuffer, pingpong, overrideVP);
+		return RecordScreenQuadCmd(pPerFrameRes, pFrameBuffer, pingpong, overrideVP);
 	}
 };
\ No newline at end of file
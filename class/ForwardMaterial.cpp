@@ -18,6 +18,8 @@ std::shared_ptr<ForwardMaterial> ForwardMaterial::CreateDefaultMaterial(const Si
 	std::shared_ptr<ForwardMaterial> pForwardMaterial = std::make_shared<ForwardMaterial>();
 
 	pForwardMaterial->m_frameBufferType = simpleMaterialInfo.frameBufferType;
+	pForwardMaterial->m_perDrawDataStrategy = simpleMaterialInfo.perDrawDataStrategy;
+	pForwardMaterial->m_gpuCulling = simpleMaterialInfo.gpuCulling;
 
 	VkGraphicsPipelineCreateInfo createInfo = {};
 
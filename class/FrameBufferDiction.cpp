@@ -5,6 +5,7 @@
 #include "../vulkan/Texture2D.h"
 #include "../vulkan/DepthStencilBuffer.h"
 #include "../vulkan/Framebuffer.h"
+#include "../vulkan/DeviceMemoryManager.h"
 #include "../Maths/Vector.h"
 #include "RenderPassDiction.h"
 #include "RenderPassBase.h"
@@ -115,6 +116,88 @@ std::shared_ptr<FrameBuffer> FrameBufferDiction::GetPingPongFrameBuffer(FrameBuf
 		return m_frameBuffers[type][0][frameIndex];
 }
 
+std::shared_ptr<Image> FrameBufferDiction::CreateColorTarget(FrameBufferType type, uint32_t layer, uint32_t index, uint32_t frameIndex, uint32_t width, uint32_t height, VkFormat format)
+{
+	auto it = m_aliasedTargets.find(MakeTargetKey(type, layer, index));
+	if (it == m_aliasedTargets.end())
+		return Texture2D::CreateOffscreenTexture(GetDevice(), width, height, format);
+
+	std::shared_ptr<Image> pColorTarget = Texture2D::CreateAliasedOffscreenTexture(GetDevice(), width, height, format, m_aliasedHeaps[frameIndex][it->second.heap], it->second.offset);
+	m_aliasedPlacements[pColorTarget.get()] = { it->second.heap, it->second.offset, (uint32_t)pColorTarget->GetMemoryReqirments().size };
+	return pColorTarget;
+}
+
+bool FrameBufferDiction::FindColorTarget(const std::shared_ptr<Image>& pImage, TargetSlot& slot) const
+{
+	for (uint32_t type = 0; type < FrameBufferType_PostProcessing; type++)
+	{
+		if (type == FrameBufferType_TemporalResolve)
+			continue;
+
+		for (uint32_t layer = 0; layer < (uint32_t)m_frameBuffers[type].size(); layer++)
+		{
+			const std::vector<std::shared_ptr<Image>>& colorTargets = m_frameBuffers[type][layer][FrameMgr()->FrameIndex()]->GetColorTargets();
+			for (uint32_t index = 0; index < (uint32_t)colorTargets.size(); index++)
+			{
+				if (colorTargets[index] == pImage)
+				{
+					slot = { (FrameBufferType)type, layer, index };
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void FrameBufferDiction::AliasColorTargets(const std::vector<AliasedTarget>& targets, const std::vector<VkMemoryRequirements>& heaps)
+{
+	m_aliasedTargets.clear();
+	m_aliasedPlacements.clear();
+
+	std::vector<bool> recreate(PipelineRenderPassCount, false);
+	for (auto& target : targets)
+	{
+		m_aliasedTargets[MakeTargetKey(target.slot.type, target.slot.layer, target.slot.index)] = target;
+		recreate[target.slot.type] = true;
+	}
+
+	// Shading frame buffer takes depth of GBuffer
+	if (recreate[FrameBufferType_GBuffer])
+		recreate[FrameBufferType_Shading] = true;
+
+	m_aliasedHeaps.clear();
+	m_aliasedHeaps.resize(GetSwapChain()->GetSwapChainImageCount());
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		for (auto& heap : heaps)
+			m_aliasedHeaps[i].push_back(DeviceMemMgr()->AllocateImageMemChunk((uint32_t)heap.size, heap.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+	}
+
+	// Recreate in type and layer order, so that frame buffers sharing targets of earlier ones pick up new targets
+	for (uint32_t type = 0; type < PipelineRenderPassCount; type++)
+	{
+		if (!recreate[type])
+			continue;
+
+		for (uint32_t layer = 0; layer < (uint32_t)m_frameBuffers[type].size(); layer++)
+			m_frameBuffers[type][layer] = CreateFrameBuffer((FrameBufferType)type, layer);
+	}
+}
+
+bool FrameBufferDiction::GetAliasedPlacement(const Image* pImage, uint32_t& heap, uint32_t& offset, uint32_t& size) const
+{
+	auto it = m_aliasedPlacements.find(pImage);
+	if (it == m_aliasedPlacements.end())
+		return false;
+
+	heap = it->second.heap;
+	offset = it->second.offset;
+	size = it->second.size;
+	return true;
+}
+
 FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateGBufferFrameBuffer(uint32_t layer)
 {
 	Vector2d windowSize = UniformData::GetInstance()->GetGlobalUniforms()->GetGameWindowSize();
@@ -125,10 +208,8 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateGBufferFrameBuffe
 	{
 		std::vector<std::shared_ptr<Image>> gbuffer_vec(GBufferCount);
 
-		gbuffer_vec[GBuffer0] = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, m_GBufferFormatTable[GBuffer0]);
-		gbuffer_vec[GBuffer1] = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, m_GBufferFormatTable[GBuffer1]);
-		gbuffer_vec[GBuffer2] = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, m_GBufferFormatTable[GBuffer2]);
-		gbuffer_vec[MotionVector] = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, m_GBufferFormatTable[MotionVector]);
+		for (uint32_t j = 0; j < GBufferCount; j++)
+			gbuffer_vec[j] = CreateColorTarget(FrameBufferType_GBuffer, layer, j, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, m_GBufferFormatTable[j]);
 
 		std::shared_ptr<DepthStencilBuffer> pDepthStencilBuffer = DepthStencilBuffer::CreateSampledAttachment(GetDevice(), OFFSCREEN_DEPTH_STENCIL_FORMAT, (uint32_t)windowSize.x, (uint32_t)windowSize.y);
 
@@ -146,7 +227,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateMotionTileMaxFram
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_MOTION_TILE_FORMAT);
+		std::shared_ptr<Image> pColorTarget = CreateColorTarget(FrameBufferType_MotionTileMax, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_MOTION_TILE_FORMAT);
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pColorTarget }, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionTileMax)->GetRenderPass()));
 	}
 
@@ -161,7 +242,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateMotionNeighborMax
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_MOTION_TILE_FORMAT);
+		std::shared_ptr<Image> pColorTarget = CreateColorTarget(FrameBufferType_MotionNeighborMax, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_MOTION_TILE_FORMAT);
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pColorTarget }, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionNeighborMax)->GetRenderPass()));
 	}
 
@@ -192,8 +273,8 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateSSAOSSRFrameBuffe
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pSSAO = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSAO_FORMAT);
-		std::shared_ptr<Image> pSSR = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSR_FORMAT);
+		std::shared_ptr<Image> pSSAO = CreateColorTarget(FrameBufferType_SSAOSSR, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSAO_FORMAT);
+		std::shared_ptr<Image> pSSR = CreateColorTarget(FrameBufferType_SSAOSSR, layer, 1, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSR_FORMAT);
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pSSAO, pSSR }, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOSSR)->GetRenderPass()));
 	}
 
@@ -208,7 +289,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateSSAOBlurFrameBuff
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSAO_FORMAT);
+		std::shared_ptr<Image> pColorTarget = CreateColorTarget(FrameBufferType_SSAOBlurV, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSAO_FORMAT);
 
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), pColorTarget, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurV)->GetRenderPass()));
 	}
@@ -224,7 +305,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateSSAOBlurFrameBuff
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSAO_FORMAT);
+		std::shared_ptr<Image> pColorTarget = CreateColorTarget(FrameBufferType_SSAOBlurH, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, SSAO_FORMAT);
 
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), pColorTarget, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurH)->GetRenderPass()));
 	}
@@ -241,8 +322,8 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateShadingFrameBuffe
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pShadingResult = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
-		std::shared_ptr<Image> pSSResult = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
+		std::shared_ptr<Image> pShadingResult = CreateColorTarget(FrameBufferType_Shading, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
+		std::shared_ptr<Image> pSSResult = CreateColorTarget(FrameBufferType_Shading, layer, 1, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
 		std::shared_ptr<DepthStencilBuffer> pDepthStencilBuffer = m_frameBuffers[FrameBufferType_GBuffer][0][i]->GetDepthStencilTarget();
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pShadingResult, pSSResult }, pDepthStencilBuffer, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->GetRenderPass()));
 	}
@@ -310,7 +391,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateDOFFrameBuffer(ui
 		if (layer == PostfilterLayer)
 			pColorTarget = GetFrameBuffers(FrameBufferType_DOF, PrefilterLayer)[i]->GetColorTarget(0);
 		else
-			pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)layerSize.x, (uint32_t)layerSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
+			pColorTarget = CreateColorTarget(FrameBufferType_DOF, layer, 0, i, (uint32_t)layerSize.x, (uint32_t)layerSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pColorTarget }, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassDOF)->GetRenderPass()));
 	}
 
@@ -334,7 +415,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateBloomFrameBuffer(
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)layerSize.x, (uint32_t)layerSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
+		std::shared_ptr<Image> pColorTarget = CreateColorTarget(FrameBufferType_Bloom, layer, 0, i, (uint32_t)layerSize.x, (uint32_t)layerSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pColorTarget }, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->GetRenderPass()));
 	}
 
@@ -349,7 +430,7 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateCombineResultFram
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pColorTarget = Texture2D::CreateOffscreenTexture(GetDevice(), (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
+		std::shared_ptr<Image> pColorTarget = CreateColorTarget(FrameBufferType_CombineResult, layer, 0, i, (uint32_t)windowSize.x, (uint32_t)windowSize.y, OFFSCREEN_HDR_COLOR_FORMAT);
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), { pColorTarget }, nullptr, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassCombine)->GetRenderPass()));
 	}
 
@@ -3,9 +3,12 @@
 #include "../common/Singleton.h"
 #include "../vulkan/RenderPass.h"
 #include <map>
+#include <unordered_map>
 
 class FrameBuffer;
 class Texture2D;
+class Image;
+class MemoryKey;
 
 class FrameBufferDiction : public Singleton<FrameBufferDiction>
 {
@@ -81,6 +84,22 @@ public:
 		DOFFrameBufferLayerCount
 	};
 
+	// Color target "index" of frame buffer "type" at "layer"
+	typedef struct _TargetSlot
+	{
+		FrameBufferType	type;
+		uint32_t		layer;
+		uint32_t		index;
+	}TargetSlot;
+
+	// Color target placed at "offset" of memory heap "heap", each frame has heaps of its own
+	typedef struct _AliasedTarget
+	{
+		TargetSlot		slot;
+		uint32_t		heap;
+		uint32_t		offset;
+	}AliasedTarget;
+
 public:
 	bool Init() override;
 
@@ -109,6 +128,28 @@ public:
 	FrameBufferCombo CreateForwardEnvGenOffScreenFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateForwardScreenFrameBuffer(uint32_t layer = 0);
 
+	// Locate "pImage" among color targets of current frame, targets shared by layers report the layer creating them
+	// Temporal targets are shared across frames and never reported
+	bool FindColorTarget(const std::shared_ptr<Image>& pImage, TargetSlot& slot) const;
+
+	// Recreate "targets" of every frame inside shared memory heaps, "heaps" gives size and memory types of each of them
+	// Frame buffers of these targets are recreated too, so it has to be done before anything refers to them
+	void AliasColorTargets(const std::vector<AliasedTarget>& targets, const std::vector<VkMemoryRequirements>& heaps);
+
+	// Heap, offset and size of an aliased target, false if it has memory of its own
+	bool GetAliasedPlacement(const Image* pImage, uint32_t& heap, uint32_t& offset, uint32_t& size) const;
+
+protected:
+	std::shared_ptr<Image> CreateColorTarget(FrameBufferType type, uint32_t layer, uint32_t index, uint32_t frameIndex, uint32_t width, uint32_t height, VkFormat format);
+	static uint32_t MakeTargetKey(FrameBufferType type, uint32_t layer, uint32_t index) { return (type << 16) | (layer << 8) | index; }
+
+	typedef struct _AliasedPlacement
+	{
+		uint32_t	heap;
+		uint32_t	offset;
+		uint32_t	size;
+	}AliasedPlacement;
+
 protected:
 	// Since you can't render to a specific mip layer of a frame buffer
 	// I'll have to create multiple frame buffers as layers
@@ -116,4 +157,8 @@ protected:
 	std::vector<std::vector<FrameBufferCombo>>					m_frameBuffers;
 	std::vector<std::vector<std::shared_ptr<Texture2D>>>		m_temporalTexture;
 	static VkFormat												m_GBufferFormatTable[GBufferCount];
+
+	std::unordered_map<uint32_t, AliasedTarget>					m_aliasedTargets;		// Keyed by "MakeTargetKey"
+	std::vector<std::vector<std::shared_ptr<MemoryKey>>>		m_aliasedHeaps;			// Per frame, per heap
+	std::unordered_map<const Image*, AliasedPlacement>			m_aliasedPlacements;
 };
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "FrustumCuller.h"
+#include "../component/MeshRenderer.h"
+#include "../common/Macros.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <xmmintrin.h>
+#include <cmath>
+
+// Cull views on worker threads, one job per view, turn off to cull them all on main thread for comparison
+bool PARALLEL_VIEW_CULLING = true;
+
+const uint32_t FrustumCuller::BATCH_SIZE;
+const uint32_t FrustumCuller::MAX_VIEW_COUNT;
+
+void FrustumCuller::SetView(uint32_t renderState, const PyramidFrustumd& frustum, bool occlusionCulling)
+{
+	ASSERTION(renderState < MAX_VIEW_COUNT && m_renderers.size() == 0);
+
+	if (m_viewMask == 0)
+		m_origin = frustum.head;
+
+	View& view = m_views[renderState];
+	view.occlusionCulling = occlusionCulling;
+
+	for (uint32_t i = 0; i < PyramidFrustumd::FrustumFace_COUNT; i++)
+	{
+		const Planed& plane = frustum.planes[i];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			view.planes[i].normal[j] = (float)plane.normal[j];
+			view.planes[i].absNormal[j] = (float)std::abs(plane.normal[j]);
+		}
+
+		// "normal * (p - origin) = D - normal * origin"
+		view.planes[i].D = (float)(plane.D - plane.normal * m_origin);
+	}
+
+	m_viewMask |= 1 << renderState;
+}
+
+void FrustumCuller::Submit(MeshRenderer* pRenderer, const Vector3d& boxCenter, const Vector3d& boxExtents, const Vector3d& sphereCenter, double radius)
+{
+	Vector3d relativeBoxCenter = boxCenter - m_origin;
+	Vector3d relativeSphereCenter = sphereCenter - m_origin;
+
+	m_renderers.push_back(pRenderer);
+	m_boxCenterX.push_back((float)relativeBoxCenter.x);
+	m_boxCenterY.push_back((float)relativeBoxCenter.y);
+	m_boxCenterZ.push_back((float)relativeBoxCenter.z);
+	m_boxExtentX.push_back((float)boxExtents.x);
+	m_boxExtentY.push_back((float)boxExtents.y);
+	m_boxExtentZ.push_back((float)boxExtents.z);
+	m_sphereCenterX.push_back((float)relativeSphereCenter.x);
+	m_sphereCenterY.push_back((float)relativeSphereCenter.y);
+	m_sphereCenterZ.push_back((float)relativeSphereCenter.z);
+	m_sphereRadius.push_back((float)radius);
+}
+
+void FrustumCuller::CullView(View& view, uint32_t count)
+{
+	uint32_t paddedCount = (uint32_t)m_boxCenterX.size();
+
+	view.visible.resize(paddedCount);
+	view.visibleCount = 0;
+	view.culledCount = 0;
+
+	const __m128 zero = _mm_setzero_ps();
+	for (uint32_t i = 0; i < paddedCount; i += BATCH_SIZE)
+	{
+		__m128 boxCenterX = _mm_loadu_ps(&m_boxCenterX[i]);
+		__m128 boxCenterY = _mm_loadu_ps(&m_boxCenterY[i]);
+		__m128 boxCenterZ = _mm_loadu_ps(&m_boxCenterZ[i]);
+		__m128 boxExtentX = _mm_loadu_ps(&m_boxExtentX[i]);
+		__m128 boxExtentY = _mm_loadu_ps(&m_boxExtentY[i]);
+		__m128 boxExtentZ = _mm_loadu_ps(&m_boxExtentZ[i]);
+		__m128 sphereCenterX = _mm_loadu_ps(&m_sphereCenterX[i]);
+		__m128 sphereCenterY = _mm_loadu_ps(&m_sphereCenterY[i]);
+		__m128 sphereCenterZ = _mm_loadu_ps(&m_sphereCenterZ[i]);
+		__m128 sphereRadius = _mm_loadu_ps(&m_sphereRadius[i]);
+
+		// A box reaches "absNormal * extents" towards the positive side of a plane from its center
+		// Zero planes (frustum without near & far) give 0 for both, which never counts as outside
+		__m128 outside = zero;
+		for (uint32_t j = 0; j < PyramidFrustumd::FrustumFace_COUNT; j++)
+		{
+			const CullPlane& plane = view.planes[j];
+			__m128 normalX = _mm_set1_ps(plane.normal[0]);
+			__m128 normalY = _mm_set1_ps(plane.normal[1]);
+			__m128 normalZ = _mm_set1_ps(plane.normal[2]);
+			__m128 D = _mm_set1_ps(plane.D);
+
+			__m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, boxCenterX), _mm_mul_ps(normalY, boxCenterY)), _mm_mul_ps(normalZ, boxCenterZ));
+			__m128 boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.absNormal[0]), boxExtentX), _mm_mul_ps(_mm_set1_ps(plane.absNormal[1]), boxExtentY)), _mm_mul_ps(_mm_set1_ps(plane.absNormal[2]), boxExtentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(_mm_sub_ps(boxDistance, D), boxReach), zero));
+
+			__m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, sphereCenterX), _mm_mul_ps(normalY, sphereCenterY)), _mm_mul_ps(normalZ, sphereCenterZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(_mm_sub_ps(sphereDistance, D), sphereRadius), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (uint32_t j = 0; j < BATCH_SIZE; j++)
+			view.visible[i + j] = (outsideMask & (1 << j)) ? 0 : 1;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (view.visible[i])
+			view.visibleCount++;
+		else
+			view.culledCount++;
+	}
+}
+
+void FrustumCuller::OcclusionCull(View& view, uint32_t count)
+{
+	// Whatever is inside frustum still has to get past occluders
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (!view.visible[i])
+			continue;
+
+		m_occludeeRenderers.push_back(i);
+		m_occludees.push_back({ m_origin + Vector3d(m_boxCenterX[i], m_boxCenterY[i], m_boxCenterZ[i]), Vector3d(m_boxExtentX[i], m_boxExtentY[i], m_boxExtentZ[i]) });
+	}
+
+	OcclusionCuller::GetInstance()->Cull(m_occludees, m_occlusionVisible);
+	for (uint32_t i = 0; i < (uint32_t)m_occludeeRenderers.size(); i++)
+	{
+		if (m_occlusionVisible[i] != 0)
+			continue;
+
+		view.visible[m_occludeeRenderers[i]] = 0;
+		view.visibleCount--;
+	}
+
+	m_occludeeRenderers.clear();
+	m_occludees.clear();
+}
+
+void FrustumCuller::Flush()
+{
+	uint32_t count = (uint32_t)m_renderers.size();
+	uint32_t paddedCount = (count + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+
+	// Padding lanes are tested as well, their results are ignored
+	for (auto pArray : { &m_boxCenterX, &m_boxCenterY, &m_boxCenterZ, &m_boxExtentX, &m_boxExtentY, &m_boxExtentZ, &m_sphereCenterX, &m_sphereCenterY, &m_sphereCenterZ, &m_sphereRadius })
+		pArray->resize(paddedCount, 0);
+
+	// Views only read submitted bounds and write their own results
+	uint32_t viewsCount = 0;
+	for (uint32_t i = 0; i < MAX_VIEW_COUNT; i++)
+	{
+		m_views[i].visibleCount = 0;
+		m_views[i].culledCount = 0;
+
+		if ((m_viewMask & (1 << i)) == 0 || count == 0)
+			continue;
+
+		auto job = [this, i, count](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+		{
+			CullView(m_views[i], count);
+		};
+
+		if (PARALLEL_VIEW_CULLING)
+			FrameMgr()->AddJobToFrame(job);
+		else
+			job(nullptr);
+
+		viewsCount++;
+	}
+
+	if (PARALLEL_VIEW_CULLING && viewsCount != 0)
+		GlobalThreadTaskQueue()->WaitForFree();
+
+	m_renderStateMasks.assign(count, 0);
+	for (uint32_t i = 0; i < MAX_VIEW_COUNT; i++)
+	{
+		if ((m_viewMask & (1 << i)) == 0 || count == 0)
+			continue;
+
+		if (m_views[i].occlusionCulling)
+			OcclusionCull(m_views[i], count);
+
+		for (uint32_t j = 0; j < count; j++)
+			m_renderStateMasks[j] |= (uint32_t)m_views[i].visible[j] << i;
+	}
+
+	// A renderer visible in several views inserts its instances once
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (m_renderStateMasks[i] != 0)
+			m_renderers[i]->InsertIntoRenderQueue(m_renderStateMasks[i]);
+	}
+
+	m_renderers.clear();
+	for (auto pArray : { &m_boxCenterX, &m_boxCenterY, &m_boxCenterZ, &m_boxExtentX, &m_boxExtentY, &m_boxExtentZ, &m_sphereCenterX, &m_sphereCenterY, &m_sphereCenterZ, &m_sphereRadius })
+		pArray->clear();
+
+	m_viewMask = 0;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "../Maths/Vector.h"
+#include "../Maths/PyramidFrustum.h"
+#include "OcclusionCuller.h"
+#include <vector>
+
+class MeshRenderer;
+
+// Frame wide visibility test of mesh renderers, one view per render state: main camera for scene, light for shadow map,
+// capture camera for env generation. Renderers submit world space bounds once while scene is traversed, "Flush" tests them
+// against every view's frustum 4 at a time with SSE, views on worker threads of their own, then camera view goes on to "OcclusionCuller"
+// Each renderer inserts instances of render states it's visible in into render queue, so it has to run before "RenderQueue::Flush"
+class FrustumCuller : public Singleton<FrustumCuller>
+{
+public:
+	// World space frustum culling instances drawn in "renderState" (a "RenderWorkManager::RenderState") this frame
+	// Views have to be set before renderers submit, bounds are kept relative to head of the first one so that single precision
+	// holds far away from world origin
+	void SetView(uint32_t renderState, const PyramidFrustumd& frustum, bool occlusionCulling = false);
+
+	// Render states with a view this frame, instances drawn in them have to wait for "Flush"
+	uint32_t GetCulledRenderStateMask() const { return m_viewMask; }
+
+	// Raw pointer is kept until "Flush", renderer has to stay alive until then
+	// A renderer is culled if either its bounding box or its bounding sphere lies completely outside a plane
+	void Submit(MeshRenderer* pRenderer, const Vector3d& boxCenter, const Vector3d& boxExtents, const Vector3d& sphereCenter, double radius);
+
+	// Test everything submitted against all views, hand visible renderers over to render queue, then empty the batch and drop views
+	void Flush();
+
+	// Visible ones passed both frustum and occlusion culling, culled ones are outside frustum only
+	uint32_t GetLastFlushVisibleCount(uint32_t renderState) const { return m_views[renderState].visibleCount; }
+	uint32_t GetLastFlushCulledCount(uint32_t renderState) const { return m_views[renderState].culledCount; }
+
+protected:
+	static const uint32_t BATCH_SIZE = 4;
+	static const uint32_t MAX_VIEW_COUNT = 32;	// One per bit of render state mask
+
+	typedef struct _CullPlane
+	{
+		float	normal[3];
+		float	absNormal[3];
+		float	D;				// Relative to origin
+	}CullPlane;
+
+	typedef struct _View
+	{
+		CullPlane				planes[PyramidFrustumd::FrustumFace_COUNT];
+		bool					occlusionCulling;
+		std::vector<uint8_t>	visible;		// One per submitted renderer
+		uint32_t				visibleCount;
+		uint32_t				culledCount;
+	}View;
+
+	void CullView(View& view, uint32_t count);
+	void OcclusionCull(View& view, uint32_t count);
+
+protected:
+	View						m_views[MAX_VIEW_COUNT] = {};
+	uint32_t					m_viewMask = 0;
+	Vector3d					m_origin;
+
+	// Structure of arrays, padded to a multiple of "BATCH_SIZE" at flush time
+	std::vector<MeshRenderer*>	m_renderers;
+	std::vector<float>			m_boxCenterX;
+	std::vector<float>			m_boxCenterY;
+	std::vector<float>			m_boxCenterZ;
+	std::vector<float>			m_boxExtentX;
+	std::vector<float>			m_boxExtentY;
+	std::vector<float>			m_boxExtentZ;
+	std::vector<float>			m_sphereCenterX;
+	std::vector<float>			m_sphereCenterY;
+	std::vector<float>			m_sphereCenterZ;
+	std::vector<float>			m_sphereRadius;
+
+	std::vector<uint32_t>		m_renderStateMasks;		// Render states each renderer is visible in
+
+	std::vector<uint32_t>		m_occludeeRenderers;
+	std::vector<OcclusionCuller::Occludee>	m_occludees;
+	std::vector<uint8_t>		m_occlusionVisible;
+};
\ No newline at end of file
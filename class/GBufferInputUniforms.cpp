@@ -3,16 +3,42 @@
 #include "Material.h"
 #include "../vulkan/GlobalDeviceObjects.h"
 #include "../vulkan/DescriptorSet.h"
+#include "../vulkan/DescriptorSetLayout.h"
+#include "../vulkan/DescriptorAllocator.h"
+#include "../vulkan/PipelineLayout.h"
+#include "../vulkan/ComputePipeline.h"
+#include "../vulkan/ShaderModule.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/FrameManager.h"
+#include "../vulkan/SwapChain.h"
 #include "../vulkan/Image.h"
 #include "../vulkan/Texture2D.h"
 #include "../vulkan/DepthStencilBuffer.h"
 #include "RenderWorkManager.h"
+#include "ShaderLibrary.h"
+#include "UniformData.h"
+#include "HiZPyramid.h"
+
+// Build Hi-Z pyramid after GBuffer pass, needs "hiz_build.comp.spv" compile_all_shader.py generates
+// Without it nothing reads the pyramid: GPU culling skips occlusion test, SSR and SSAO read depth buffer only
+bool HIZ_PYRAMID = false;
 
 bool GBufferInputUniforms::Init(const std::shared_ptr<GBufferInputUniforms>& pSelf)
 {
 	if (!SelfRefBase<GBufferInputUniforms>::Init(pSelf))
 		return false;
 
+	// Same size as depth buffer, so that level 0 is a plain copy and texel footprints match "HiZPyramid"
+	Vector2d size = UniformData::GetInstance()->GetGlobalUniforms()->GetGameWindowSize();
+	m_hizWidth = (uint32_t)size.x;
+	m_hizHeight = (uint32_t)size.y;
+	m_hizLevelCount = HiZPyramid::GetLevelCount(m_hizWidth, m_hizHeight);
+
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+		m_hizPyramids.push_back(Texture2D::CreateStorageMipmapTexture(GetDevice(), m_hizWidth, m_hizHeight, m_hizLevelCount, HIZ_PYRAMID_FORMAT));
+
+	m_hizDescriptorSets.resize(GetSwapChain()->GetSwapChainImageCount());
+
 	return true;
 }
 
@@ -29,16 +55,10 @@ std::vector<UniformVarList> GBufferInputUniforms::PrepareUniformVarList() const
 	return
 	{
 		{
-			InputAttachment,
-			"RGBA8_GBuffer0"
-		},
-		{
-			InputAttachment,
-			"RGBA8_GBuffer1"
-		},
-		{
-			InputAttachment,
-			"RGBA8_GBuffer2"
+			CombinedSampler,
+			"HiZ pyramid of each frame, R: farthest depth, G: nearest depth",
+			{},
+			(uint32_t)m_hizPyramids.size()
 		}
 	};
 }
@@ -61,6 +81,96 @@ uint32_t GBufferInputUniforms::SetupDescriptorSet(const std::shared_ptr<Descript
 		pDSBuffer->CreateLinearClampToEdgeSampler(), 
 		pDSBuffer->CreateDepthSampleImageView());
 		*/
+
+	// Shaders read pyramid with "texelFetch" only, sampler makes no difference
+	std::vector<CombinedImage> pyramids;
+	for (auto& pPyramid : m_hizPyramids)
+		pyramids.push_back({ pPyramid, pPyramid->CreateNearestRepeatSampler(), pPyramid->CreateDefaultImageView() });
+
+	pDescriptorSet->UpdateImages(bindingIndex++, pyramids);
+
 	return bindingIndex;
 }
 
+void GBufferInputUniforms::InitHiZBuild(const std::shared_ptr<DepthStencilBuffer>& pDepthBuffer, uint32_t frameIndex)
+{
+	if (m_pHiZPipeline == nullptr)
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings =
+		{
+			{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },	// Depth buffer or level above
+			{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },			// Level being built
+		};
+		m_pHiZDescriptorSetLayout = GlobalDescriptorAllocator()->AcquireDescriptorSetLayout(bindings);
+
+		VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t) };
+		m_pHiZPipelineLayout = PipelineLayout::Create(GetDevice(), { m_pHiZDescriptorSetLayout }, { pushConstantRange });
+
+		VkComputePipelineCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+
+		std::shared_ptr<ShaderModule> pShader = ShaderLibrary::GetInstance()->AcquireShaderModule(L"../data/shaders/hiz_build.comp.spv", ShaderModule::ShaderType::ShaderTypeCompute, "main");
+		m_pHiZPipeline = ComputePipeline::Create(GetDevice(), createInfo, pShader, m_pHiZPipelineLayout);
+	}
+
+	// Depth buffers belong to GBuffer frame buffers, which don't exist yet by the time uniforms are created
+	std::shared_ptr<Texture2D> pPyramid = m_hizPyramids[frameIndex];
+	for (uint32_t level = 0; level < m_hizLevelCount; level++)
+	{
+		std::shared_ptr<DescriptorSet> pDescriptorSet = GlobalDescriptorAllocator()->AllocateDescriptorSet(m_pHiZDescriptorSetLayout);
+
+		if (level == 0)
+			pDescriptorSet->UpdateImage(0, pDepthBuffer, pDepthBuffer->CreateNearestRepeatSampler(), pDepthBuffer->CreateDepthSampleImageView());
+		else
+			pDescriptorSet->UpdateImage(0, pPyramid, pPyramid->CreateNearestRepeatSampler(), pPyramid->CreateMipImageView(level - 1));
+
+		pDescriptorSet->UpdateStorageImage(1, pPyramid, pPyramid->CreateMipImageView(level));
+
+		m_hizDescriptorSets[frameIndex].push_back(pDescriptorSet);
+	}
+}
+
+bool GBufferInputUniforms::IsHiZPyramidEnabled() const
+{
+	return HIZ_PYRAMID;
+}
+
+void GBufferInputUniforms::BuildHiZPyramid(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<DepthStencilBuffer>& pDepthBuffer)
+{
+	if (!HIZ_PYRAMID)
+		return;
+
+	uint32_t frameIndex = FrameMgr()->FrameIndex();
+
+	if (m_hizDescriptorSets[frameIndex].size() == 0)
+		InitHiZBuild(pDepthBuffer, frameIndex);
+
+	std::shared_ptr<Texture2D> pPyramid = m_hizPyramids[frameIndex];
+
+	pCmdBuf->BindPipeline(m_pHiZPipeline);
+
+	// One dispatch per level, each waits for the one before, level 0 copies depth as both min and max
+	for (uint32_t level = 0; level < m_hizLevelCount; level++)
+	{
+		if (level == 0)
+			pCmdBuf->RequireImageAccess(pDepthBuffer, { VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1 }, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+		else
+			pCmdBuf->RequireImageAccess(pPyramid, { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1 }, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+		pCmdBuf->RequireImageAccess(pPyramid, { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 }, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		pCmdBuf->FlushBarriers();
+
+		uint32_t copyDepth = level == 0 ? 1 : 0;
+		pCmdBuf->PushConstants(m_pHiZPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &copyDepth);
+		pCmdBuf->BindDescriptorSets(m_pHiZPipelineLayout, { m_hizDescriptorSets[frameIndex][level] }, {}, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+		uint32_t width = std::max(m_hizWidth >> level, 1u);
+		uint32_t height = std::max(m_hizHeight >> level, 1u);
+		pCmdBuf->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+	}
+
+	// Back to shader read only for fragment shaders of this frame and culling dispatches of the next one
+	pCmdBuf->RestoreResourceStates();
+
+	m_lastBuiltHiZPyramid = frameIndex;
+}
\ No newline at end of file
@@ -4,10 +4,19 @@
 #include "IMaterialUniformOperator.h"
 
 class DescriptorSet;
+class DescriptorSetLayout;
+class PipelineLayout;
+class ComputePipeline;
+class CommandBuffer;
+class DepthStencilBuffer;
 class Texture2D;
 
+// Resources derived from GBuffer that later passes share, for now a depth min/max pyramid per frame, see "HiZPyramid"
 class GBufferInputUniforms : public SelfRefBase<GBufferInputUniforms>, public IMaterialUniformOperator
 {
+public:
+	static const VkFormat HIZ_PYRAMID_FORMAT = VK_FORMAT_R32G32_SFLOAT;
+
 public:
 	bool Init(const std::shared_ptr<GBufferInputUniforms>& pSelf);
 	static std::shared_ptr<GBufferInputUniforms> Create();
@@ -15,4 +24,31 @@ public:
 public:
 	virtual std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+	// Whether pyramids are built at all, see "HIZ_PYRAMID"
+	bool IsHiZPyramidEnabled() const;
+	// Reduce depth GBuffer pass just wrote into pyramid of current frame, recorded right after GBuffer render pass ends
+	void BuildHiZPyramid(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<DepthStencilBuffer>& pDepthBuffer);
+
+	const std::vector<std::shared_ptr<Texture2D>>& GetHiZPyramids() const { return m_hizPyramids; }
+	// Pyramid built most recently, UINT32_MAX before the first one or if pyramids aren't built, only valid for passes that run after it's built
+	uint32_t GetLastBuiltHiZPyramid() const { return m_lastBuiltHiZPyramid; }
+	uint32_t GetHiZLevelCount() const { return m_hizLevelCount; }
+	uint32_t GetHiZWidth() const { return m_hizWidth; }
+	uint32_t GetHiZHeight() const { return m_hizHeight; }
+
+protected:
+	void InitHiZBuild(const std::shared_ptr<DepthStencilBuffer>& pDepthBuffer, uint32_t frameIndex);
+
+protected:
+	std::vector<std::shared_ptr<Texture2D>>					m_hizPyramids;
+	uint32_t												m_hizLevelCount = 0;
+	uint32_t												m_hizWidth = 0;
+	uint32_t												m_hizHeight = 0;
+	uint32_t												m_lastBuiltHiZPyramid = UINT32_MAX;
+
+	std::shared_ptr<DescriptorSetLayout>					m_pHiZDescriptorSetLayout;
+	std::shared_ptr<PipelineLayout>							m_pHiZPipelineLayout;
+	std::shared_ptr<ComputePipeline>						m_pHiZPipeline;
+	std::vector<std::vector<std::shared_ptr<DescriptorSet>>>	m_hizDescriptorSets;	// Per frame, one per level
 };
\ No newline at end of file
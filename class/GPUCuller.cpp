@@ -0,0 +1,241 @@
+#include "GPUCuller.h"
+#include "HiZPyramid.h"
+#include "../common/Macros.h"
+#include "../Maths/Matrix.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const uint32_t GPUCuller::GROUP_SIZE;
+const uint32_t GPUCuller::MAX_INSTANCE_COUNT;
+const uint32_t GPUCuller::MAX_DRAW_COUNT;
+const uint32_t GPUCuller::MAX_OBJECT_COUNT;
+const float GPUCuller::HIZ_DEPTH_BIAS = 1e-4f;
+
+void GPUCuller::SetView(const PyramidFrustumd& frustum)
+{
+	m_origin = frustum.head;
+
+	for (uint32_t i = 0; i < PyramidFrustumd::FrustumFace_COUNT; i++)
+	{
+		const Planed& plane = frustum.planes[i];
+
+		// "normal * (p - origin) = D - normal * origin"
+		m_planes[i] = Vector4f((float)plane.normal.x, (float)plane.normal.y, (float)plane.normal.z, (float)(plane.D - plane.normal * m_origin));
+	}
+}
+
+void GPUCuller::SetOcclusionView(const Matrix4d& cameraTransform, const Matrix4d& projection)
+{
+	m_prevViewProjection = m_viewProjection;
+	m_prevViewHead = m_viewHead;
+
+	m_viewHead = cameraTransform.TranslationVector();
+
+	Matrix4d view = cameraTransform;
+	view.c30 = 0;
+	view.c31 = 0;
+	view.c32 = 0;
+	view.Inverse();
+
+	m_viewProjection = projection * view;
+	m_viewCount = std::min(m_viewCount + 1, 2u);
+}
+
+void GPUCuller::SetOcclusionPyramid(uint32_t pyramidIndex, uint32_t width, uint32_t height, uint32_t levelCount)
+{
+	m_hizPyramidIndex = pyramidIndex;
+	m_hizSize[0] = (float)width;
+	m_hizSize[1] = (float)height;
+	m_hizLevelCount = levelCount;
+}
+
+void GPUCuller::SetObjectBounds(uint32_t perObjectIndex, const Vector3d& boxCenter, const Vector3d& boxExtents, bool cullable)
+{
+	ASSERTION(perObjectIndex < MAX_OBJECT_COUNT);
+	m_objectBounds[perObjectIndex] = { boxCenter, boxExtents, cullable };
+}
+
+bool GPUCuller::PrepareInput(const VkDrawIndexedIndirectCommand* pCmds, const uint32_t* pIndirectOffsets, uint32_t drawCount,
+	const PerMaterialIndirectVariables* pIndirectVariables, uint32_t indirectVariablesCount, CullingInput& input) const
+{
+	for (uint32_t i = 0; i < PyramidFrustumd::FrustumFace_COUNT; i++)
+		input.planes[i] = m_planes[i];
+
+	// Arrays of input hold one work group, nothing is written into them beyond that
+	bool fits = drawCount <= MAX_DRAW_COUNT && indirectVariablesCount <= MAX_INSTANCE_COUNT;
+	for (uint32_t i = 0; fits && i < indirectVariablesCount; i++)
+		fits = pIndirectVariables[i].perObjectIndex < MAX_OBJECT_COUNT;
+
+	input.bypass = fits ? 0 : 1;
+	input.padding = 0;
+	if (!fits)
+	{
+		input.instanceCount = 0;
+		input.drawCount = 0;
+		input.hizLevelCount = 0;
+		return false;
+	}
+
+	input.instanceCount = indirectVariablesCount;
+	input.drawCount = drawCount;
+
+	// Last frame's view projection takes boxes relative to this frame's origin, difference of heads is applied in double
+	input.hizLevelCount = m_viewCount == 2 ? m_hizLevelCount : 0;
+	input.hizPyramidIndex = m_hizPyramidIndex;
+	input.hizSize[0] = m_hizSize[0];
+	input.hizSize[1] = m_hizSize[1];
+	if (input.hizLevelCount > 0)
+	{
+		Matrix4d translation;
+		translation.c30 = m_origin.x - m_prevViewHead.x;
+		translation.c31 = m_origin.y - m_prevViewHead.y;
+		translation.c32 = m_origin.z - m_prevViewHead.z;
+		input.hizViewProjection = (m_prevViewProjection * translation).SinglePrecision();
+	}
+
+	for (uint32_t i = 0; i < drawCount; i++)
+	{
+		uint32_t first = pIndirectOffsets[i];
+		uint32_t count = (i + 1 < drawCount ? pIndirectOffsets[i + 1] : indirectVariablesCount) - first;
+		ASSERTION(count > 0);
+
+		CullingDraw& draw = input.draws[i];
+		draw.indexCount = pCmds[i].indexCount;
+		draw.firstIndex = pCmds[i].firstIndex;
+		draw.vertexOffset = pCmds[i].vertexOffset;
+		draw.firstInstance = pCmds[i].firstInstance;
+		draw.firstCullingInstance = first;
+		draw.cullingInstanceCount = count;
+		draw.instancesPerEntry = std::max(1u, pCmds[i].instanceCount / count);
+		draw.padding = 0;
+
+		for (uint32_t j = first; j < first + count; j++)
+		{
+			const PerMaterialIndirectVariables& variables = pIndirectVariables[j];
+			ASSERTION(variables.perObjectIndex < MAX_OBJECT_COUNT);
+
+			const ObjectBounds& bounds = m_objectBounds[variables.perObjectIndex];
+			Vector3d relativeCenter = bounds.boxCenter - m_origin;
+
+			CullingInstance& instance = input.instances[j];
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				instance.boxCenter[k] = (float)relativeCenter[k];
+				instance.boxExtents[k] = (float)bounds.boxExtents[k];
+			}
+			instance.padding = 0;
+			instance.flags = bounds.cullable && draw.instancesPerEntry == 1 ? 0 : CullingFlag_AlwaysVisible;
+			instance.variables = variables;
+		}
+	}
+
+	return true;
+}
+
+bool GPUCuller::IsBoxVisible(const CullingInput& input, const CullingInstance& instance)
+{
+	// A box reaches "absNormal * extents" towards the positive side of a plane from its center
+	// Zero planes (frustum without near & far) give 0 for both, which never counts as outside
+	for (uint32_t i = 0; i < PyramidFrustumd::FrustumFace_COUNT; i++)
+	{
+		const Vector4f& plane = input.planes[i];
+		float distance = plane.x * instance.boxCenter[0] + plane.y * instance.boxCenter[1] + plane.z * instance.boxCenter[2];
+		float reach = std::abs(plane.x) * instance.boxExtents[0] + std::abs(plane.y) * instance.boxExtents[1] + std::abs(plane.z) * instance.boxExtents[2];
+		if (distance - plane.w + reach < 0)
+			return false;
+	}
+	return true;
+}
+
+bool GPUCuller::IsBoxOccluded(const CullingInput& input, const CullingInstance& instance, const HiZPyramid& pyramid)
+{
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = -std::numeric_limits<float>::max();
+	float maxY = -std::numeric_limits<float>::max();
+	float nearestDepth = 0;
+
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		Vector4f corner
+		(
+			instance.boxCenter[0] + ((i & 1) ? instance.boxExtents[0] : -instance.boxExtents[0]),
+			instance.boxCenter[1] + ((i & 2) ? instance.boxExtents[1] : -instance.boxExtents[1]),
+			instance.boxCenter[2] + ((i & 4) ? instance.boxExtents[2] : -instance.boxExtents[2]),
+			1.0f
+		);
+		Vector4f clip = input.hizViewProjection * corner;
+
+		// Box reaches near plane, it can't be behind anything
+		if (clip.z > clip.w || clip.w <= 0)
+			return false;
+
+		float x = (clip.x / clip.w * 0.5f + 0.5f) * input.hizSize[0];
+		float y = (clip.y / clip.w * 0.5f + 0.5f) * input.hizSize[1];
+
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestDepth = std::max(nearestDepth, clip.z / clip.w);
+	}
+
+	// Out of last frame's screen, nothing known about what's there
+	if (maxX < 0 || maxY < 0 || minX >= input.hizSize[0] || minY >= input.hizSize[1])
+		return false;
+
+	uint32_t x0 = (uint32_t)std::max(minX, 0.0f);
+	uint32_t y0 = (uint32_t)std::max(minY, 0.0f);
+	uint32_t x1 = (uint32_t)std::min(maxX, input.hizSize[0] - 1);
+	uint32_t y1 = (uint32_t)std::min(maxY, input.hizSize[1] - 1);
+
+	// Occluded only if the farthest surface anywhere under box is still nearer than box
+	return nearestDepth * (1.0f + HIZ_DEPTH_BIAS) < pyramid.QueryRect(x0, y0, x1, y1).minDepth;
+}
+
+void GPUCuller::Cull(const CullingInput& input, CullingOutput& output, const HiZPyramid* pPyramid)
+{
+	ASSERTION(input.instanceCount <= MAX_INSTANCE_COUNT && input.drawCount <= MAX_DRAW_COUNT);
+	ASSERTION(input.hizLevelCount == 0 || pPyramid == nullptr || (pPyramid->GetLevelCount() == input.hizLevelCount && pPyramid->GetWidth() == (uint32_t)input.hizSize[0] && pPyramid->GetHeight() == (uint32_t)input.hizSize[1]));
+
+	bool occlusion = input.hizLevelCount > 0 && pPyramid != nullptr;
+
+	output.cmds.clear();
+	output.indirectOffsets.clear();
+	output.indirectVariables.clear();
+
+	// Draws were uploaded unculled, kernel leaves them alone
+	if (input.bypass != 0)
+		return;
+
+	// Inclusive prefix sum of visible instances, what kernel's first scan leaves in shared memory
+	uint32_t instancePrefix[MAX_INSTANCE_COUNT];
+	uint32_t visibleCount = 0;
+	for (uint32_t i = 0; i < input.instanceCount; i++)
+	{
+		const CullingInstance& instance = input.instances[i];
+		if ((instance.flags & CullingFlag_AlwaysVisible) != 0 || (IsBoxVisible(input, instance) && !(occlusion && IsBoxOccluded(input, instance, *pPyramid))))
+		{
+			output.indirectVariables.push_back(instance.variables);
+			visibleCount++;
+		}
+		instancePrefix[i] = visibleCount;
+	}
+
+	// Instances of a draw are consecutive, so are their survivors
+	for (uint32_t i = 0; i < input.drawCount; i++)
+	{
+		const CullingDraw& draw = input.draws[i];
+		if (draw.cullingInstanceCount == 0)
+			continue;
+
+		uint32_t firstVisible = draw.firstCullingInstance == 0 ? 0 : instancePrefix[draw.firstCullingInstance - 1];
+		uint32_t drawVisibleCount = instancePrefix[draw.firstCullingInstance + draw.cullingInstanceCount - 1] - firstVisible;
+		if (drawVisibleCount == 0)
+			continue;
+
+		output.cmds.push_back({ draw.indexCount, drawVisibleCount * draw.instancesPerEntry, draw.firstIndex, draw.vertexOffset, draw.firstInstance });
+		output.indirectOffsets.push_back(firstVisible);
+	}
+}
\ No newline at end of file
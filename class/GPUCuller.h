@@ -0,0 +1,146 @@
+#pragma once
+
+#include "vulkan.h"
+#include "../common/Singleton.h"
+#include "../Maths/Vector.h"
+#include "../Maths/PyramidFrustum.h"
+#include "../Maths/Matrix.h"
+#include "PerMaterialIndirectVariables.h"
+#include <vector>
+#include <cstdint>
+
+class HiZPyramid;
+
+// Frustum culling and compaction of a material's indirect draws on GPU, for materials created with "gpuCulling"
+// Instead of indirect commands, such a material uploads every instance it'd draw this frame with its bounds, plus one template per draw.
+// A compute pass ("gpu_culling.comp") culls instances against main camera and writes surviving instances, indirect commands and
+// their count where "DrawIndexedIndirectCount" reads them. One work group does a whole material: survivors are placed by a prefix sum
+// over instances and draws with any survivor by a prefix sum over draws, so output keeps input order and doesn't depend on scheduling
+// Instances passing frustum test are then tested against Hi-Z pyramid last frame built, see "GBufferInputUniforms::BuildHiZPyramid":
+// this frame's depth doesn't exist yet when culling runs, so boxes are projected with last frame's view projection instead.
+// A box out of last frame's view is always kept, one that moved, or whose occluder moved, could stay culled a frame too long
+// A frame with more instances or draws than one work group holds isn't culled: its draws go up from CPU as they are, and kernel
+// is told to leave them alone, see "PrepareInput"
+// "Cull" is CPU reference of the same kernel over the same input, it's what tests verify on machines without a GPU
+class GPUCuller : public Singleton<GPUCuller>
+{
+public:
+	// Kernel runs one thread per instance and per draw, capacities match per object chunks and indirect draw count of a material
+	static const uint32_t GROUP_SIZE = 256;
+	static const uint32_t MAX_INSTANCE_COUNT = GROUP_SIZE;
+	static const uint32_t MAX_DRAW_COUNT = GROUP_SIZE;
+	static const uint32_t MAX_OBJECT_COUNT = 256;
+
+	enum CullingFlag
+	{
+		CullingFlag_AlwaysVisible = 1 << 0,		// Bounds don't hold, e.g. skinned, manually instanced or opted out of culling
+	};
+
+	// Layouts from here on have to match "gpu_culling.comp"
+	typedef struct _CullingInstance
+	{
+		float							boxCenter[3];		// Relative to view origin
+		uint32_t						padding;
+		float							boxExtents[3];
+		uint32_t						flags;				// Combination of "CullingFlag"
+		PerMaterialIndirectVariables	variables;
+	}CullingInstance;
+
+	typedef struct _CullingDraw
+	{
+		uint32_t	indexCount;
+		uint32_t	firstIndex;
+		int32_t		vertexOffset;
+		uint32_t	firstInstance;
+		uint32_t	firstCullingInstance;
+		uint32_t	cullingInstanceCount;
+		uint32_t	instancesPerEntry;		// A manually instanced draw is one culling instance standing for all of its instances
+		uint32_t	padding;
+	}CullingDraw;
+
+	typedef struct _CullingInput
+	{
+		Vector4f		planes[PyramidFrustumd::FrustumFace_COUNT];	// xyz: normal, w: D relative to view origin
+		uint32_t		instanceCount;
+		uint32_t		drawCount;
+
+		// Where output of this frame starts, in 4 bytes words from start of each output buffer binding
+		uint32_t		cmdWordOffset;
+		uint32_t		countWordOffset;
+		uint32_t		indirectOffsetWordOffset;
+		uint32_t		indirectVariableWordOffset;
+		uint32_t		bypass;					// Nonzero if draws exceed capacity, kernel writes nothing and CPU uploads them unculled
+		uint32_t		padding;
+
+		// Occlusion against last frame's Hi-Z pyramid, "hizLevelCount" 0 turns it off
+		Matrix4f		hizViewProjection;		// Last frame's view projection, relative to this frame's view origin
+		uint32_t		hizLevelCount;
+		uint32_t		hizPyramidIndex;		// Which one of pyramids bound to kernel
+		float			hizSize[2];				// Size of level 0
+
+		CullingInstance	instances[MAX_INSTANCE_COUNT];
+		CullingDraw		draws[MAX_DRAW_COUNT];
+	}CullingInput;
+
+	// What kernel writes, count of draws is "cmds.size()"
+	typedef struct _CullingOutput
+	{
+		std::vector<VkDrawIndexedIndirectCommand>	cmds;
+		std::vector<uint32_t>						indirectOffsets;
+		std::vector<PerMaterialIndirectVariables>	indirectVariables;
+	}CullingOutput;
+
+public:
+	// Main camera's world space frustum, bounds are kept relative to its head so that single precision holds far away from world origin
+	void SetView(const PyramidFrustumd& frustum);
+
+	// Main camera's transform and projection of this frame, pyramid built with them is what next frame's culling reprojects into
+	void SetOcclusionView(const Matrix4d& cameraTransform, const Matrix4d& projection);
+
+	// Pyramid culling of this frame tests against, it was built by last frame, "levelCount" 0 turns occlusion culling off
+	void SetOcclusionPyramid(uint32_t pyramidIndex, uint32_t width, uint32_t height, uint32_t levelCount);
+
+	// World space bounds of per object chunk "perObjectIndex" this frame, written by its renderer
+	// Different objects could be written by different threads
+	void SetObjectBounds(uint32_t perObjectIndex, const Vector3d& boxCenter, const Vector3d& boxExtents, bool cullable);
+
+	// Kernel input out of a material's draws as render queue appends them: draw "i" uses indirect variables from "pIndirectOffsets[i]"
+	// up to where next draw's start, instances find their bounds through "perObjectIndex"
+	// Output word offsets are left to caller, as they depend on where buffers live
+	// Returns false with "bypass" set if draws don't fit in kernel capacity, it's then up to caller to upload them unculled
+	bool PrepareInput(const VkDrawIndexedIndirectCommand* pCmds, const uint32_t* pIndirectOffsets, uint32_t drawCount,
+		const PerMaterialIndirectVariables* pIndirectVariables, uint32_t indirectVariablesCount, CullingInput& input) const;
+
+	// CPU reference of compute kernel, "pPyramid" stands for the one "hizPyramidIndex" refers to, occlusion is skipped without it
+	static void Cull(const CullingInput& input, CullingOutput& output, const HiZPyramid* pPyramid = nullptr);
+
+protected:
+	static bool IsBoxVisible(const CullingInput& input, const CullingInstance& instance);
+	static bool IsBoxOccluded(const CullingInput& input, const CullingInstance& instance, const HiZPyramid& pyramid);
+
+	// Nearest depth of a box is pushed this much nearer before it's compared, so that a surface isn't taken to occlude itself
+	static const float HIZ_DEPTH_BIAS;
+
+protected:
+	typedef struct _ObjectBounds
+	{
+		Vector3d	boxCenter;
+		Vector3d	boxExtents;
+		bool		cullable;
+	}ObjectBounds;
+
+	Vector3d		m_origin;
+	Vector4f		m_planes[PyramidFrustumd::FrustumFace_COUNT] = {};
+	ObjectBounds	m_objectBounds[MAX_OBJECT_COUNT] = {};
+
+	// View projections are relative to their camera's position
+	Matrix4d		m_viewProjection;
+	Vector3d		m_viewHead;
+	Matrix4d		m_prevViewProjection;
+	Vector3d		m_prevViewHead;
+	uint32_t		m_viewCount = 0;	// Occlusion views set so far, up to 2
+
+	uint32_t		m_hizPyramidIndex = 0;
+	uint32_t		m_hizLevelCount = 0;
+	float			m_hizSize[2] = {};
+};
\ No newline at end of file
@@ -9,6 +9,9 @@
 #include "../vulkan/StagingBufferManager.h"
 #include "../vulkan/Framebuffer.h"
 #include "../class/RenderWorkManager.h"
+#include "../class/RenderQueue.h"
+#include "../class/FrustumCuller.h"
+#include "../component/Camera.h"
 #include "../class/Mesh.h"
 #include "../component/MeshRenderer.h"
 #include "../Base/BaseObject.h"
@@ -21,6 +24,7 @@
 #include "ForwardMaterial.h"
 #include "../Maths/Vector.h"
 #include "FrameBufferDiction.h"
+#include "StreamingManager.h"
 #include <random>
 #include <gli\gli.hpp>
 
@@ -164,9 +168,15 @@ void GlobalTextures::InitIrradianceTexture()
 		SceneGenerator::GetInstance()->GetRootObject()->LateUpdate();
 		SceneGenerator::GetInstance()->GetRootObject()->UpdateCachedData();
 		SceneGenerator::GetInstance()->GetRootObject()->OnPreRender();
+
+		// Each face culls with a view of its own
+		FrustumCuller::GetInstance()->SetView(RenderWorkManager::IrradianceGen, SceneGenerator::GetInstance()->GetCameraObject()->GetComponent<Camera>()->AcquireWorldFrustum());
+
 		SceneGenerator::GetInstance()->GetRootObject()->OnRenderObject();
 		SceneGenerator::GetInstance()->GetRootObject()->OnPostRender();
 		UniformData::GetInstance()->SyncDataBuffer();
+		FrustumCuller::GetInstance()->Flush();
+		RenderQueue::GetInstance()->Flush();
 		SceneGenerator::GetInstance()->GetMaterial0()->SyncBufferData();
 
 		SceneGenerator::GetInstance()->GetMaterial0()->OnFrameBegin();
@@ -252,9 +262,14 @@ void GlobalTextures::InitPrefilterEnvTexture()
 			SceneGenerator::GetInstance()->GetRootObject()->LateUpdate();
 			SceneGenerator::GetInstance()->GetRootObject()->UpdateCachedData();
 			SceneGenerator::GetInstance()->GetRootObject()->OnPreRender();
+
+			FrustumCuller::GetInstance()->SetView(RenderWorkManager::ReflectionGen, SceneGenerator::GetInstance()->GetCameraObject()->GetComponent<Camera>()->AcquireWorldFrustum());
+
 			SceneGenerator::GetInstance()->GetRootObject()->OnRenderObject();
 			SceneGenerator::GetInstance()->GetRootObject()->OnPostRender();
 			UniformData::GetInstance()->SyncDataBuffer();
+			FrustumCuller::GetInstance()->Flush();
+			RenderQueue::GetInstance()->Flush();
 			SceneGenerator::GetInstance()->GetMaterial0()->SyncBufferData();
 
 			SceneGenerator::GetInstance()->GetMaterial0()->OnFrameBegin();
@@ -310,6 +325,7 @@ void GlobalTextures::InitBRDFLUTTexture()
 	SceneGenerator::GetInstance()->GetRootObject()->OnRenderObject();
 	SceneGenerator::GetInstance()->GetRootObject()->OnPostRender();
 	UniformData::GetInstance()->SyncDataBuffer();
+	RenderQueue::GetInstance()->Flush();
 	SceneGenerator::GetInstance()->GetMaterial0()->SyncBufferData();
 
 	SceneGenerator::GetInstance()->GetMaterial0()->OnFrameBegin();
@@ -416,6 +432,20 @@ void GlobalTextures::InsertTexture(InGameTextureType type, const TextureDesc& de
 	uint32_t emptySlot;
 	InsertTextureDesc(desc, m_textureDiction[type], emptySlot);
 	m_textureDiction[type].pTextureArray->InsertTexture(gliTexture2d, emptySlot);
+
+	// Texture arrays are allocated up front and a slot can't be read back in, so it starts resident and evicts are only accounted
+	TextureArrayDesc& textureArr = m_textureDiction[type];
+	uint32_t slot = textureArr.lookupTable[desc.textureName];
+	if (textureArr.streamingResources.find(slot) == textureArr.streamingResources.end())
+		textureArr.streamingResources[slot] = StreamingManager::GetInstance()->RegisterResource(gliTexture2d.size(), true);
+}
+
+uint32_t GlobalTextures::GetStreamingResource(InGameTextureType type, uint32_t textureIndex) const
+{
+	auto it = m_textureDiction[type].streamingResources.find(textureIndex);
+	if (it == m_textureDiction[type].streamingResources.end())
+		return StreamingScheduler::NONE;
+	return it->second;
 }
 
 bool GlobalTextures::GetTextureIndex(const TextureArrayDesc& textureArr, const std::string& textureName, uint32_t& textureIndex)
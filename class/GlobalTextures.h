@@ -44,6 +44,7 @@ typedef struct _TextureArrayDesc
 	uint32_t						currentEmptySlot;		// Empty slot is available for new texture, and is updated everytime when textureDescriptions changed
 	std::shared_ptr<Image>			pTextureArray;
 	std::map<std::string, uint32_t> lookupTable;
+	std::map<uint32_t, uint32_t>	streamingResources;		// Key: index in texture array, value: resource of "StreamingManager"
 }TextureArrayDesc;
 
 class GlobalTextures : public SelfRefBase<GlobalTextures>, public IMaterialUniformOperator
@@ -65,6 +66,9 @@ public:
 	bool GetTextureIndex(InGameTextureType type, const std::string& textureName, uint32_t& textureIndex);
 	bool GetScreenSizeTextureIndex(const std::string& textureName, uint32_t& textureIndex);
 
+	// Streaming resource of an in game texture slot, "StreamingScheduler::NONE" if there's no texture in it
+	uint32_t GetStreamingResource(InGameTextureType type, uint32_t textureIndex) const;
+
 	virtual std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
 
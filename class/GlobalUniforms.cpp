@@ -9,6 +9,7 @@
 #include "../vulkan/TextureCube.h"
 #include "../vulkan/ShaderStorageBuffer.h"
 #include "../scene/SceneGenerator.h"
+#include "PlanetSubdivider.h"
 #include "UniformData.h"
 #include "GlobalTextures.h"
 #include "GlobalUniforms.h"
@@ -30,7 +31,7 @@ bool GlobalUniforms::Init(const std::shared_ptr<GlobalUniforms>& pSelf)
 	InitSSAORandomSample();
 	InitIcosahedron();
 
-	SceneGenerator::GenerateCube(CubeVertices, CubeIndices);
+	PlanetSubdivider::GenerateCube(CubeVertices, CubeIndices);
 
 	return true;
 }
@@ -141,10 +142,25 @@ void GlobalUniforms::SetMainLightColor(const Vector3d& color)
 	SetDirty();
 }
 
-void GlobalUniforms::SetMainLightVP(const Matrix4d& vp)
+void GlobalUniforms::SetMainLightVP(uint32_t cascade, const Matrix4d& vp)
 {
-	m_globalVariables.mainLightVP = vp;
-	CONVERT2SINGLE(m_globalVariables, m_singlePrecisionGlobalVariables, mainLightVP);
+	if (cascade == 0)
+	{
+		m_globalVariables.mainLightVP = vp;
+		CONVERT2SINGLE(m_globalVariables, m_singlePrecisionGlobalVariables, mainLightVP);
+	}
+	else
+	{
+		m_globalVariables.mainLightCascadeVP[cascade - 1] = vp;
+		CONVERT2SINGLE(m_globalVariables, m_singlePrecisionGlobalVariables, mainLightCascadeVP[cascade - 1]);
+	}
+	SetDirty();
+}
+
+void GlobalUniforms::SetMainLightCascadeSplits(const Vector4d& splits)
+{
+	m_globalVariables.mainLightCascadeSplits = splits;
+	CONVERT2SINGLE(m_globalVariables, m_singlePrecisionGlobalVariables, mainLightCascadeSplits);
 	SetDirty();
 }
 
@@ -380,6 +396,13 @@ void GlobalUniforms::SetScreenSizeMipLevel(double mipLevel)
 	SetDirty();
 }
 
+void GlobalUniforms::SetSSRTHiZMaxLevel(double level)
+{
+	m_globalVariables.SSRSettings2.w = level;
+	CONVERT2SINGLEVAL(m_globalVariables, m_singlePrecisionGlobalVariables, SSRSettings2.w);
+	SetDirty();
+}
+
 void GlobalUniforms::SetTemporalSettings0(const Vector4d& setting)
 {
 	m_globalVariables.TemporalSettings0 = setting;
@@ -725,6 +748,16 @@ std::vector<UniformVarList> GlobalUniforms::PrepareUniformVarList() const
 					Vec4Unit,
 					"SSAO Samples",
 					SSAO_SAMPLE_COUNT
+				},
+				{
+					Mat4Unit,
+					"MainLightCascadeVP",
+					0,
+					SHADOW_CASCADE_COUNT - 1
+				},
+				{
+					Vec4Unit,
+					"MainLightCascadeSplits"
 				}
 			}
 		}
@@ -1101,6 +1134,14 @@ void PerMeshUniforms::SetBoneChunkIndexOffset(uint32_t chunkIndex, uint32_t bone
 	SetChunkDirty(chunkIndex);
 }
 
+void PerMeshUniforms::SetDequantization(uint32_t chunkIndex, const VertexPacker::Dequantization& dequantization)
+{
+	m_meshData[chunkIndex].positionScale = dequantization.positionScale;
+	m_meshData[chunkIndex].positionBias = dequantization.positionBias;
+	m_meshData[chunkIndex].texCoordScaleBias = dequantization.texCoordScaleBias;
+	SetChunkDirty(chunkIndex);
+}
+
 void PerMeshUniforms::UpdateDirtyChunkInternal(uint32_t index)
 {
 }
@@ -1113,7 +1154,13 @@ std::vector<UniformVarList> PerMeshUniforms::PrepareUniformVarList() const
 			DynamicShaderStorageBuffer,
 			"Per Mesh Uniforms",
 			{
-				{ OneUnit, "Bone chunk index offset" }
+				{ OneUnit, "Bone chunk index offset" },
+				{ OneUnit, "Padding0" },
+				{ OneUnit, "Padding1" },
+				{ OneUnit, "Padding2" },
+				{ Vec4Unit, "Position dequantization scale" },
+				{ Vec4Unit, "Position dequantization bias" },
+				{ Vec4Unit, "Texcoord dequantization scale bias" }
 			}
 		}
 	};
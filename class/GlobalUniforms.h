@@ -3,6 +3,7 @@
 #include "UniformDataStorage.h"
 #include "ChunkBasedUniforms.h"
 #include "../Maths/DualQuaternion.h"
+#include "VertexPacker.h"
 #include "../common/Macros.h"
 #include <unordered_map>
 #include <string>
@@ -14,6 +15,7 @@ class Mesh;
 class SkeletonAnimationInstance;
 
 const static uint32_t SSAO_SAMPLE_COUNT = 64;
+const static uint32_t SHADOW_CASCADE_COUNT = 4;		// Split depths of all cascades fit in one vec4
 const static uint32_t PLANET_LOD_MAX_LEVEL = 32;
 
 template<typename T>
@@ -50,7 +52,7 @@ public:
 	Vector4<T>		mainLightColor;
 
 	/*******************************************************************
-	* DESCRIPTION: Main directional light vpn matrix
+	* DESCRIPTION: Main directional light vpn matrix of shadow cascade 0, from camera space
 	*/
 	Matrix4x4<T>	mainLightVP;
 
@@ -130,7 +132,7 @@ public:
 	* X: How far a hit to the edge of screen that it needs to be fade, to prevent from hard boundary
 	* Y: How many steps that a hit starts to fade, to prevent from hard boundary
 	* Z: Screen sized mipmap level count
-	* W: Reserved
+	* W: Coarsest Hi-Z pyramid level ray trace skips empty space with, 0 turns off Hi-Z reads of both SSR and SSAO
 	*/
 	Vector4<T>	SSRSettings2;
 
@@ -208,7 +210,7 @@ public:
 	* DESCRIPTION: Planet Rendering Settings0
 	*
 	* X: The ratio in planet radius that transition between rendering raw vertices to normalized spherical vertices
-	* Y: Planet triangle screen size
+	* Y: Planet triangle screen size in pixels, patches whose edges span more get subdivided
 	* Z: Planet max lod level
 	* W: Planet patch subdivide level
 	*/
@@ -226,6 +228,20 @@ public:
 
 	// SSAO settings
 	Vector4<T>	SSAOSamples[SSAO_SAMPLE_COUNT];
+
+	// Shadow cascades are appended, so that members above keep their offsets in shaders compiled before cascades
+
+	/*******************************************************************
+	* DESCRIPTION: Main directional light vpn matrix of shadow cascades from 1 on, from camera space
+	*/
+	Matrix4x4<T>	mainLightCascadeVP[SHADOW_CASCADE_COUNT - 1];
+
+	/*******************************************************************
+	* DESCRIPTION: Main directional light shadow cascade splits
+	*
+	* XYZW: Camera space depth each cascade reaches, along -z, 0 for cascades not in use
+	*/
+	Vector4<T>	mainLightCascadeSplits;
 };
 
 typedef GlobalVariables<float> GlobalVariablesf;
@@ -263,8 +279,10 @@ public:
 	Vector4d GetMainLightDir() const { return m_globalVariables.mainLightDir; }
 	void SetMainLightColor(const Vector3d& color);
 	Vector4d GetMainLightColor() const { return m_globalVariables.mainLightColor; }
-	void SetMainLightVP(const Matrix4d& vp);
-	Matrix4d GetmainLightVP() const { return m_globalVariables.mainLightVP; }
+	void SetMainLightVP(uint32_t cascade, const Matrix4d& vp);
+	Matrix4d GetmainLightVP(uint32_t cascade) const { return cascade == 0 ? m_globalVariables.mainLightVP : m_globalVariables.mainLightCascadeVP[cascade - 1]; }
+	void SetMainLightCascadeSplits(const Vector4d& splits);
+	Vector4d GetMainLightCascadeSplits() const { return m_globalVariables.mainLightCascadeSplits; }
 
 	void SetMainCameraSettings0(const Vector4d& settings);
 	Vector4d GetMainCameraSettings0() const { return m_globalVariables.mainCameraSettings0; }
@@ -334,6 +352,8 @@ public:
 	double GetSSRTStepCountFadingDist() const { return m_globalVariables.SSRSettings2.y; }
 	void SetScreenSizeMipLevel(double mipLevel);
 	double GetScreenSizeMipLevel() const { return m_globalVariables.SSRSettings2.z; }
+	void SetSSRTHiZMaxLevel(double level);
+	double GetSSRTHiZMaxLevel() const { return m_globalVariables.SSRSettings2.w; }
 
 	void SetTemporalSettings0(const Vector4d& setting);
 	Vector4d GetTemporalSettings0() const { return m_globalVariables.TemporalSettings0; }
@@ -527,9 +547,14 @@ protected:
 
 class PerMeshUniforms : public ChunkBasedUniforms
 {
+	// Layout has to match "MeshData" in uniform_layout.sh
 	typedef struct _MeshData
 	{
 		uint32_t	boneChunkIndexOffset;
+		uint32_t	padding[3];
+		Vector4f	positionScale;
+		Vector4f	positionBias;
+		Vector4f	texCoordScaleBias;
 	}MeshData;
 
 protected:
@@ -545,6 +570,7 @@ public:
 protected:
 	void SetBoneChunkIndexOffset(uint32_t chunkIndex, uint32_t boneChunkIndexOffset);
 	uint32_t GetBoneChunkIndexOffset(uint32_t chunkIndex) const { return m_meshData[chunkIndex].boneChunkIndexOffset; }
+	void SetDequantization(uint32_t chunkIndex, const VertexPacker::Dequantization& dequantization);
 
 protected:
 	void UpdateDirtyChunkInternal(uint32_t index) override;
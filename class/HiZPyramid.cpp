@@ -0,0 +1,103 @@
+#include "HiZPyramid.h"
+#include "../common/Macros.h"
+#include <algorithm>
+
+uint32_t HiZPyramid::GetLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levelCount = 1;
+	while (width > 1 || height > 1)
+	{
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		levelCount++;
+	}
+	return levelCount;
+}
+
+void HiZPyramid::Build(const float* pDepth, uint32_t width, uint32_t height)
+{
+	ASSERTION(width > 0 && height > 0);
+
+	// Storage is kept when size doesn't change, which is every frame but the first
+	uint32_t levelCount = GetLevelCount(width, height);
+	if (m_levels.size() != levelCount || m_levels[0].width != width || m_levels[0].height != height)
+	{
+		m_levels.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			m_levels[level].width = width;
+			m_levels[level].height = height;
+			m_levels[level].texels.resize(width * height);
+
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+		}
+	}
+
+	std::vector<MinMax>& texels = m_levels[0].texels;
+	for (uint32_t i = 0; i < (uint32_t)texels.size(); i++)
+		texels[i] = { pDepth[i], pDepth[i] };
+
+	for (uint32_t level = 1; level < levelCount; level++)
+	{
+		const Level& source = m_levels[level - 1];
+		Level& destination = m_levels[level];
+
+		// Texels read are 2 by 2 in general, last column or row reads up to 3 of an odd sized source, 1 of a source already 1 wide
+		for (uint32_t y = 0; y < destination.height; y++)
+		{
+			uint32_t y0 = std::min(y * 2, source.height - 1);
+			uint32_t y1 = y == destination.height - 1 ? source.height - 1 : y * 2 + 1;
+			MinMax* pDestination = &destination.texels[y * destination.width];
+
+			for (uint32_t x = 0; x < destination.width; x++)
+			{
+				uint32_t x0 = std::min(x * 2, source.width - 1);
+				uint32_t x1 = x == destination.width - 1 ? source.width - 1 : x * 2 + 1;
+
+				MinMax result = source.texels[y0 * source.width + x0];
+				for (uint32_t sy = y0; sy <= y1; sy++)
+				{
+					for (uint32_t sx = x0; sx <= x1; sx++)
+					{
+						const MinMax& texel = source.texels[sy * source.width + sx];
+						result.minDepth = std::min(result.minDepth, texel.minDepth);
+						result.maxDepth = std::max(result.maxDepth, texel.maxDepth);
+					}
+				}
+				pDestination[x] = result;
+			}
+		}
+	}
+}
+
+uint32_t HiZPyramid::GetRectLevel(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
+{
+	uint32_t level = 0;
+	while (level + 1 < (uint32_t)m_levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+		level++;
+	return level;
+}
+
+HiZPyramid::MinMax HiZPyramid::QueryRect(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
+{
+	ASSERTION(x0 <= x1 && y0 <= y1 && x1 < GetWidth() && y1 < GetHeight());
+
+	uint32_t level = GetRectLevel(x0, y0, x1, y1);
+	uint32_t texelX0 = std::min(x0 >> level, GetWidth(level) - 1);
+	uint32_t texelY0 = std::min(y0 >> level, GetHeight(level) - 1);
+	uint32_t texelX1 = std::min(x1 >> level, GetWidth(level) - 1);
+	uint32_t texelY1 = std::min(y1 >> level, GetHeight(level) - 1);
+
+	MinMax result = GetTexel(level, texelX0, texelY0);
+	for (uint32_t y = texelY0; y <= texelY1; y++)
+	{
+		for (uint32_t x = texelX0; x <= texelX1; x++)
+		{
+			const MinMax& texel = GetTexel(level, x, y);
+			result.minDepth = std::min(result.minDepth, texel.minDepth);
+			result.maxDepth = std::max(result.maxDepth, texel.maxDepth);
+		}
+	}
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Depth min/max pyramid, CPU reference of what "hiz_build.comp" builds once per frame after GBuffer pass, no dependency on renderer
+// Level 0 is depth buffer itself, each texel of the next level keeps min and max of 2 by 2 texels below
+// Level sizes round down like any mip chain, so last texel of a row or column also takes what an odd sized level below leaves over:
+// texel (x, y) of level n covers pixels from (x << n, y << n) up to but not including ((x + 1) << n, (y + 1) << n),
+// and last column or row of texels reaches to screen edge. Pixel (x, y) falls into texel (min(x >> n, width - 1), min(y >> n, height - 1))
+// Depth is post projection z of a reverse depth projection: greater is nearer, 0 means nothing was drawn,
+// so min is the farthest surface within a texel and max the nearest one
+class HiZPyramid
+{
+public:
+	typedef struct _MinMax
+	{
+		float	minDepth;
+		float	maxDepth;
+	}MinMax;
+
+public:
+	// Levels down to 1 by 1, same as a full mip chain
+	static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+	void Build(const float* pDepth, uint32_t width, uint32_t height);
+
+	uint32_t GetLevelCount() const { return (uint32_t)m_levels.size(); }
+	uint32_t GetWidth(uint32_t level = 0) const { return m_levels[level].width; }
+	uint32_t GetHeight(uint32_t level = 0) const { return m_levels[level].height; }
+	const MinMax& GetTexel(uint32_t level, uint32_t x, uint32_t y) const { return m_levels[level].texels[y * m_levels[level].width + x]; }
+
+	// Coarsest level an inclusive rect of pixels touches at most 2 by 2 texels of, the level "gpu_culling.comp" tests boxes at
+	uint32_t GetRectLevel(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const;
+
+	// Min and max depth of texels at "GetRectLevel" an inclusive rect of pixels falls into
+	// Those texels could reach past the rect, never short of it, so min is never farther than any pixel within and max never nearer
+	MinMax QueryRect(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const;
+
+protected:
+	typedef struct _Level
+	{
+		uint32_t			width;
+		uint32_t			height;
+		std::vector<MinMax>	texels;
+	}Level;
+
+protected:
+	std::vector<Level>	m_levels;
+};
\ No newline at end of file
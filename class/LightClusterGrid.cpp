@@ -0,0 +1,323 @@
+#include "LightClusterGrid.h"
+#include "../common/Macros.h"
+#include "../Maths/MathUtil.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <future>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+const uint32_t LightClusterGrid::CLUSTER_X;
+const uint32_t LightClusterGrid::CLUSTER_Y;
+const uint32_t LightClusterGrid::CLUSTER_Z;
+const uint32_t LightClusterGrid::CLUSTER_COUNT;
+const uint32_t LightClusterGrid::SLICES_PER_JOB;
+
+static_assert(LightClusterGrid::CLUSTER_Z % LightClusterGrid::SLICES_PER_JOB == 0, "Jobs have to cover whole slices");
+
+LightClusterGrid::LightClusterGrid()
+{
+	m_clusterMinX.resize(CLUSTER_Z * CLUSTER_Y * ROW_GROUPS * 4);
+	m_clusterMaxX.resize(m_clusterMinX.size());
+	m_clusterMinY.resize(m_clusterMinX.size());
+	m_clusterMaxY.resize(m_clusterMinX.size());
+	m_jobs.resize(GetJobCount());
+
+	SetView(1, 1, 1, 2);
+}
+
+void LightClusterGrid::SetView(double tangentFOVH_2, double tangentFOVV_2, double nearDepth, double farDepth)
+{
+	ASSERTION(nearDepth > 0 && farDepth > nearDepth);
+
+	m_tangentFOVH_2 = tangentFOVH_2;
+	m_tangentFOVV_2 = tangentFOVV_2;
+	m_nearDepth = nearDepth;
+	m_farDepth = farDepth;
+	m_sliceScale = (CLUSTER_Z - 1) / std::log(farDepth / nearDepth);
+
+	for (uint32_t z = 0; z < CLUSTER_Z; z++)
+	{
+		double nearSliceDepth = GetSliceDepth(z);
+		double farSliceDepth = GetSliceDepth(z + 1);
+		m_sliceMinDepth[z] = (float)nearSliceDepth;
+		m_sliceMaxDepth[z] = (float)farSliceDepth;
+
+		for (uint32_t y = 0; y < CLUSTER_Y; y++)
+		{
+			for (uint32_t x = 0; x < ROW_GROUPS * 4; x++)
+			{
+				uint32_t index = (z * CLUSTER_Y + y) * ROW_GROUPS * 4 + x;
+
+				// Padding never touches anything
+				if (x >= CLUSTER_X)
+				{
+					m_clusterMinX[index] = m_clusterMinY[index] = FLT_MAX;
+					m_clusterMaxX[index] = m_clusterMaxY[index] = -FLT_MAX;
+					continue;
+				}
+
+				// Tile edges are lines through camera, box has to hold them at both ends of the slice
+				double ndcMinX = -1.0 + 2.0 * x / CLUSTER_X;
+				double ndcMaxX = ndcMinX + 2.0 / CLUSTER_X;
+				double ndcMinY = -1.0 + 2.0 * y / CLUSTER_Y;
+				double ndcMaxY = ndcMinY + 2.0 / CLUSTER_Y;
+
+				m_clusterMinX[index] = (float)(std::min(ndcMinX * nearSliceDepth, ndcMinX * farSliceDepth) * tangentFOVH_2);
+				m_clusterMaxX[index] = (float)(std::max(ndcMaxX * nearSliceDepth, ndcMaxX * farSliceDepth) * tangentFOVH_2);
+				m_clusterMinY[index] = (float)(std::min(ndcMinY * nearSliceDepth, ndcMinY * farSliceDepth) * tangentFOVV_2);
+				m_clusterMaxY[index] = (float)(std::max(ndcMaxY * nearSliceDepth, ndcMaxY * farSliceDepth) * tangentFOVV_2);
+			}
+		}
+	}
+}
+
+double LightClusterGrid::GetSliceDepth(uint32_t slice) const
+{
+	if (slice == 0)
+		return 0;
+
+	return m_nearDepth * std::pow(m_farDepth / m_nearDepth, (slice - 1) / (double)(CLUSTER_Z - 1));
+}
+
+uint32_t LightClusterGrid::GetSlice(double depth) const
+{
+	if (depth < m_nearDepth)
+		return 0;
+
+	double slice = 1 + std::floor(std::log(depth / m_nearDepth) * m_sliceScale);
+	return (uint32_t)std::min(slice, (double)CLUSTER_Z);
+}
+
+uint32_t LightClusterGrid::AcquireTile(double ndc, uint32_t tileCount)
+{
+	double tile = std::floor((ndc * 0.5 + 0.5) * tileCount);
+	return (uint32_t)std::min(std::max(tile, 0.0), (double)(tileCount - 1));
+}
+
+uint32_t LightClusterGrid::GetClusterIndex(const Vector3d& position) const
+{
+	double depth = -position.z;
+	if (depth <= 0)
+		return CLUSTER_COUNT;
+
+	uint32_t slice = GetSlice(depth);
+	double ndcX = position.x / (depth * m_tangentFOVH_2);
+	double ndcY = -position.y / (depth * m_tangentFOVV_2);
+	if (slice >= CLUSTER_Z || std::abs(ndcX) > 1 || std::abs(ndcY) > 1)
+		return CLUSTER_COUNT;
+
+	return (slice * CLUSTER_Y + AcquireTile(ndcY, CLUSTER_Y)) * CLUSTER_X + AcquireTile(ndcX, CLUSTER_X);
+}
+
+void LightClusterGrid::SetLights(const LightSphere* pLights, uint32_t count)
+{
+	m_lights.clear();
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		double x = pLights[i].center.x;
+		double y = -pLights[i].center.y;
+		double depth = -pLights[i].center.z;
+		double radius = pLights[i].radius;
+
+		double minDepth = depth - radius;
+		double maxDepth = depth + radius;
+		if (radius <= 0 || maxDepth <= 0 || minDepth >= m_farDepth)
+			continue;
+
+		uint32_t minSlice = GetSlice(std::max(minDepth, 0.0));
+		uint32_t maxSlice = std::min(GetSlice(maxDepth), CLUSTER_Z - 1);
+
+		// A sphere reaching camera plane could cover any tile
+		LightBounds bounds = { i, (float)x, (float)y, (float)depth, (float)radius, minSlice, maxSlice, 0, CLUSTER_X - 1, 0, CLUSTER_Y - 1 };
+
+		if (minDepth > 0)
+		{
+			// Box around sphere, its screen extent is reached at its nearest or farthest depth
+			double minX = std::min((x - radius) / minDepth, (x - radius) / maxDepth) / m_tangentFOVH_2;
+			double maxX = std::max((x + radius) / minDepth, (x + radius) / maxDepth) / m_tangentFOVH_2;
+			double minY = std::min((y - radius) / minDepth, (y - radius) / maxDepth) / m_tangentFOVV_2;
+			double maxY = std::max((y + radius) / minDepth, (y + radius) / maxDepth) / m_tangentFOVV_2;
+			if (maxX < -1 || minX > 1 || maxY < -1 || minY > 1)
+				continue;
+
+			bounds.minTileX = AcquireTile(minX, CLUSTER_X);
+			bounds.maxTileX = AcquireTile(maxX, CLUSTER_X);
+			bounds.minTileY = AcquireTile(minY, CLUSTER_Y);
+			bounds.maxTileY = AcquireTile(maxY, CLUSTER_Y);
+		}
+
+		m_lights.push_back(bounds);
+	}
+}
+
+void LightClusterGrid::AssignJob(uint32_t job)
+{
+	Job& jobData = m_jobs[job];
+	jobData.clusterLights.clear();
+
+	uint32_t firstSlice = job * SLICES_PER_JOB;
+	uint32_t endSlice = firstSlice + SLICES_PER_JOB;
+
+	const __m128 zero = _mm_setzero_ps();
+
+	// Lights are visited in order, so each cluster finds its lights in ascending order
+	for (auto& light : m_lights)
+	{
+		uint32_t minSlice = std::max(light.minSlice, firstSlice);
+		uint32_t maxSlice = std::min(light.maxSlice + 1, endSlice);
+		if (minSlice >= maxSlice)
+			continue;
+
+		__m128 centerX = _mm_set1_ps(light.x);
+		__m128 centerY = _mm_set1_ps(light.y);
+		float radius2 = light.radius * light.radius;
+		__m128 radiusSquared = _mm_set1_ps(radius2);
+
+		for (uint32_t z = minSlice; z < maxSlice; z++)
+		{
+			float dz = std::max(std::max(m_sliceMinDepth[z] - light.depth, light.depth - m_sliceMaxDepth[z]), 0.0f);
+			float dz2 = dz * dz;
+			if (dz2 > radius2)
+				continue;
+
+			__m128 distanceZ = _mm_set1_ps(dz2);
+
+			for (uint32_t y = light.minTileY; y <= light.maxTileY; y++)
+			{
+				uint32_t row = z * CLUSTER_Y + y;
+
+				// Closest point of each box to light center, a cluster is touched if it's within radius
+				for (uint32_t x = light.minTileX & ~3u; x <= light.maxTileX; x += 4)
+				{
+					uint32_t index = row * ROW_GROUPS * 4 + x;
+
+					__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_clusterMinX[index]), centerX), _mm_sub_ps(centerX, _mm_loadu_ps(&m_clusterMaxX[index]))), zero);
+					__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_clusterMinY[index]), centerY), _mm_sub_ps(centerY, _mm_loadu_ps(&m_clusterMaxY[index]))), zero);
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), distanceZ);
+
+					int32_t mask = _mm_movemask_ps(_mm_cmple_ps(distance, radiusSquared));
+					for (uint32_t lane = 0; mask != 0; lane++, mask >>= 1)
+					{
+						if ((mask & 1) == 0)
+							continue;
+
+						jobData.clusterLights.push_back(row * CLUSTER_X + x + lane);
+						jobData.clusterLights.push_back(light.light);
+					}
+				}
+			}
+		}
+	}
+
+	// Counting sort by cluster, stable so that lights stay in order
+	uint32_t firstCluster = firstSlice * CLUSTER_Y * CLUSTER_X;
+	jobData.counts.assign(SLICES_PER_JOB * CLUSTER_Y * CLUSTER_X, 0);
+	for (uint32_t i = 0; i < (uint32_t)jobData.clusterLights.size(); i += 2)
+		jobData.counts[jobData.clusterLights[i] - firstCluster]++;
+
+	jobData.offsets.resize(jobData.counts.size());
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < (uint32_t)jobData.counts.size(); i++)
+	{
+		jobData.offsets[i] = offset;
+		offset += jobData.counts[i];
+	}
+
+	jobData.lightIndices.resize(offset);
+	std::vector<uint32_t> cursors = jobData.offsets;
+	for (uint32_t i = 0; i < (uint32_t)jobData.clusterLights.size(); i += 2)
+		jobData.lightIndices[cursors[jobData.clusterLights[i] - firstCluster]++] = jobData.clusterLights[i + 1];
+}
+
+uint32_t LightClusterGrid::Compact(uint32_t* pClusterRanges, uint32_t* pLightIndices, uint32_t maxIndices)
+{
+	uint32_t indicesCount = 0;
+	m_droppedIndicesCount = 0;
+
+	// Jobs own consecutive clusters, so their lists are simply laid one after another
+	for (uint32_t job = 0; job < GetJobCount(); job++)
+	{
+		const Job& jobData = m_jobs[job];
+		uint32_t firstCluster = job * SLICES_PER_JOB * CLUSTER_Y * CLUSTER_X;
+
+		for (uint32_t i = 0; i < (uint32_t)jobData.counts.size(); i++)
+		{
+			uint32_t count = std::min(jobData.counts[i], maxIndices - indicesCount);
+			pClusterRanges[(firstCluster + i) * 2] = indicesCount;
+			pClusterRanges[(firstCluster + i) * 2 + 1] = count;
+
+			if (count != 0)
+				memcpy(pLightIndices + indicesCount, &jobData.lightIndices[jobData.offsets[i]], count * sizeof(uint32_t));
+
+			indicesCount += count;
+			m_droppedIndicesCount += jobData.counts[i] - count;
+		}
+	}
+
+	return indicesCount;
+}
+
+LightClusterGrid::BenchmarkResult LightClusterGrid::Benchmark(uint32_t lightsCount)
+{
+	BenchmarkResult result = {};
+	result.lightsCount = lightsCount;
+
+	const double tangentFOVV_2 = std::tan(PI / 6);
+	const double tangentFOVH_2 = tangentFOVV_2 * 16.0 / 9.0;
+	const double farDepth = 200;
+
+	// Street lamps and effects, mostly small, spread over whole depth range
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> unit(0, 1);
+
+	std::vector<LightSphere> lights(lightsCount);
+	for (auto& light : lights)
+	{
+		double depth = 0.5 + unit(random) * farDepth;
+		double x = (unit(random) * 2 - 1) * depth * tangentFOVH_2;
+		double y = (unit(random) * 2 - 1) * depth * tangentFOVV_2;
+		light.center = Vector3f((float)x, (float)y, (float)-depth);
+		light.radius = (float)(0.5 + unit(random) * 4.5);
+	}
+
+	LightClusterGrid grid;
+	grid.SetView(tangentFOVH_2, tangentFOVV_2, 0.1, farDepth);
+
+	std::vector<uint32_t> ranges(CLUSTER_COUNT * 2);
+	std::vector<uint32_t> indices(CLUSTER_COUNT * 256);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	grid.SetLights(lights.data(), lightsCount);
+	result.setupTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t job = 0; job < grid.GetJobCount(); job++)
+		grid.AssignJob(job);
+	grid.Compact(ranges.data(), indices.data(), (uint32_t)indices.size());
+	result.assignTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<std::future<void>> jobs;
+	for (uint32_t job = 0; job < grid.GetJobCount(); job++)
+		jobs.push_back(std::async(std::launch::async, [&grid, job]() { grid.AssignJob(job); }));
+	for (auto& job : jobs)
+		job.wait();
+	result.lightIndicesCount = grid.Compact(ranges.data(), indices.data(), (uint32_t)indices.size());
+	result.parallelAssignTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	uint32_t litClustersCount = 0;
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		uint32_t count = ranges[cluster * 2 + 1];
+		litClustersCount += count > 0 ? 1 : 0;
+		result.maxLightsPerCluster = std::max(result.maxLightsPerCluster, count);
+	}
+	result.averageLightsPerCluster = litClustersCount == 0 ? 0 : result.lightIndicesCount / (double)litClustersCount;
+
+	return result;
+}
\ No newline at end of file
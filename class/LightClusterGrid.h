@@ -0,0 +1,122 @@
+#pragma once
+#include "../Maths/Vector.h"
+#include <vector>
+#include <cstdint>
+
+// Froxel grid over a perspective view frustum and assignment of light spheres to its clusters, no dependency on renderer
+// Clusters are screen tiles by depth slices: slice 0 reaches from camera to near depth, the rest split near to far depth exponentially,
+// so that a cluster is roughly as deep as it is wide. Every light is tested against camera space boxes of clusters its conservative
+// screen and depth range covers, 4 clusters of a row at a time with SSE
+// Slices are assigned in jobs that touch disjoint clusters only, so jobs could run on different threads, "Compact" then packs
+// light lists of all clusters into one index array, each list ordered by light index
+// Camera looks down -z, tile 0 is at left top of screen
+class LightClusterGrid
+{
+public:
+	static const uint32_t CLUSTER_X = 16;
+	static const uint32_t CLUSTER_Y = 9;
+	static const uint32_t CLUSTER_Z = 24;
+	static const uint32_t CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+	static const uint32_t SLICES_PER_JOB = 4;
+
+	// Camera space bounding sphere of a light's influence
+	typedef struct _LightSphere
+	{
+		Vector3f	center;
+		float		radius;
+	}LightSphere;
+
+	typedef struct _BenchmarkResult
+	{
+		uint32_t	lightsCount;
+		double		setupTime;				// Screen and depth range of all lights, in milliseconds
+		double		assignTime;				// All jobs one after another and compaction, in milliseconds
+		double		parallelAssignTime;		// Same with one thread per job, in milliseconds
+		uint32_t	lightIndicesCount;
+		double		averageLightsPerCluster;	// Over clusters with at least one light
+		uint32_t	maxLightsPerCluster;
+	}BenchmarkResult;
+
+public:
+	LightClusterGrid();
+
+	// Tangents of half field of view, depths are positive distances along -z
+	void SetView(double tangentFOVH_2, double tangentFOVV_2, double nearDepth, double farDepth);
+
+	// Lights behind camera, beyond far depth or off screen are dropped here
+	void SetLights(const LightSphere* pLights, uint32_t count);
+
+	uint32_t GetVisibleLightsCount() const { return (uint32_t)m_lights.size(); }
+
+	uint32_t GetJobCount() const { return CLUSTER_Z / SLICES_PER_JOB; }
+	void AssignJob(uint32_t job);
+
+	// "pClusterRanges" receives offset and count of each cluster's list, "pLightIndices" all lists back to back
+	// Lists that don't fit in "maxIndices" are cut, returns number of indices written
+	uint32_t Compact(uint32_t* pClusterRanges, uint32_t* pLightIndices, uint32_t maxIndices);
+
+	// Lights cut by last "Compact"
+	uint32_t GetDroppedIndicesCount() const { return m_droppedIndicesCount; }
+
+	// Depth where a slice starts, "CLUSTER_Z" gives far depth
+	double GetSliceDepth(uint32_t slice) const;
+
+	// "CLUSTER_Z" if depth is beyond far depth
+	uint32_t GetSlice(double depth) const;
+
+	// What shader needs to find a pixel's slice, x: near depth, y: slices per log depth
+	Vector2d GetSliceParameters() const { return { m_nearDepth, m_sliceScale }; }
+
+	// Cluster a camera space position falls in, "CLUSTER_COUNT" if it's out of grid
+	uint32_t GetClusterIndex(const Vector3d& position) const;
+
+	// Lights scattered over a view frustum of a street level camera
+	static BenchmarkResult Benchmark(uint32_t lightsCount);
+
+protected:
+	static const uint32_t ROW_GROUPS = (CLUSTER_X + 3) / 4;
+
+	typedef struct _LightBounds
+	{
+		uint32_t	light;
+		float		x;
+		float		y;			// Flipped, so that y grows downwards with tiles
+		float		depth;
+		float		radius;
+		uint32_t	minSlice;
+		uint32_t	maxSlice;
+		uint32_t	minTileX;
+		uint32_t	maxTileX;
+		uint32_t	minTileY;
+		uint32_t	maxTileY;
+	}LightBounds;
+
+	typedef struct _Job
+	{
+		std::vector<uint32_t>	clusterLights;		// Cluster and light pairs in the order they're found
+		std::vector<uint32_t>	counts;				// One per cluster of job's slices
+		std::vector<uint32_t>	offsets;
+		std::vector<uint32_t>	lightIndices;		// Grouped by cluster
+	}Job;
+
+	static uint32_t AcquireTile(double ndc, uint32_t tileCount);
+
+protected:
+	double						m_tangentFOVH_2 = 1;
+	double						m_tangentFOVV_2 = 1;
+	double						m_nearDepth = 1;
+	double						m_farDepth = 2;
+	double						m_sliceScale = 1;
+
+	// Camera space boxes of clusters, rows padded to a multiple of 4 for SSE
+	std::vector<float>			m_clusterMinX;
+	std::vector<float>			m_clusterMaxX;
+	std::vector<float>			m_clusterMinY;
+	std::vector<float>			m_clusterMaxY;
+	float						m_sliceMinDepth[CLUSTER_Z];
+	float						m_sliceMaxDepth[CLUSTER_Z];
+
+	std::vector<LightBounds>	m_lights;
+	std::vector<Job>			m_jobs;
+	uint32_t					m_droppedIndicesCount = 0;
+};
\ No newline at end of file
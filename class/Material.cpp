@@ -17,7 +17,7 @@
 #include "../vulkan/PipelineLayout.h"
 #include "../vulkan/ShaderModule.h"
 #include "../vulkan/Framebuffer.h"
-#include "../vulkan/DescriptorPool.h"
+#include "../vulkan/DescriptorAllocator.h"
 #include "../class/MaterialInstance.h"
 #include "../vulkan/ShaderStorageBuffer.h"
 #include "../class/UniformData.h"
@@ -25,6 +25,7 @@
 #include "../vulkan/Image.h"
 #include "../vulkan/SharedIndirectBuffer.h"
 #include "RenderWorkManager.h"
+#include "ShaderLibrary.h"
 #include "../vulkan/GlobalVulkanStates.h"
 #include "../vulkan/GlobalDeviceObjects.h"
 #include "../class/PerMaterialIndirectUniforms.h"
@@ -38,6 +39,13 @@
 #include "RenderPassBase.h"
 #include "../vulkan/ComputePipeline.h"
 #include "Mesh.h"
+#include "RenderQueue.h"
+#include "GPUCuller.h"
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+static std::atomic<uint32_t> materialIDCounter(0);
 
 void Material::GeneralInit
 (
@@ -48,6 +56,8 @@ void Material::GeneralInit
 	bool includeIndirectBuffer
 )
 {
+	m_materialID = materialIDCounter++;
+
 	m_materialVariableLayout.resize(MaterialUniformStorageTypeCount);
 	m_materialUniforms.resize(MaterialUniformStorageTypeCount);
 
@@ -149,39 +159,20 @@ void Material::GeneralInit
 			break;
 		}
 	}
-	m_pDescriptorSetLayout = DescriptorSetLayout::Create(GetDevice(), bindings);
+	m_pDescriptorSetLayout = GlobalDescriptorAllocator()->AcquireDescriptorSetLayout(bindings);
 
 	std::vector<std::shared_ptr<DescriptorSetLayout>> descriptorSetLayouts = UniformData::GetInstance()->GetDescriptorSetLayouts();
 	descriptorSetLayouts.push_back(m_pDescriptorSetLayout);
 
-	// Create pipeline layout
-	m_pPipelineLayout = PipelineLayout::Create(GetDevice(), descriptorSetLayouts, pushConstsRanges);
-
-
-	// Prepare descriptor pool size according to resources used by this material
-	std::vector<uint32_t> counts(VK_DESCRIPTOR_TYPE_RANGE_SIZE);
-	for (auto & binding : bindings)
-	{
-		counts[binding.descriptorType]++;
-	}
-
-	CustomizePoolSize(counts);
-
-	std::vector<VkDescriptorPoolSize> descPoolSize;
-	for (uint32_t i = 0; i < counts.size(); i++)
-	{
-		if (counts[i] != 0)
-			descPoolSize.push_back({ (VkDescriptorType)i, counts[i] });
-	}
+	// Offset of current draw's indirect variables is pushed to vertex shader
+	std::vector<VkPushConstantRange> ranges = pushConstsRanges;
+	if (m_perDrawDataStrategy == PerDrawData_PushConstants)
+		ranges.push_back({ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t) });
 
-	VkDescriptorPoolCreateInfo descPoolInfo = {};
-	descPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descPoolInfo.pPoolSizes = descPoolSize.data();
-	descPoolInfo.poolSizeCount = (uint32_t)descPoolSize.size();
-	descPoolInfo.maxSets = 1 + GetSwapChain()->GetSwapChainImageCount();
+	// Create pipeline layout
+	m_pPipelineLayout = PipelineLayout::Create(GetDevice(), descriptorSetLayouts, ranges);
 
-	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), descPoolInfo);
-	m_pUniformStorageDescriptorSet = m_pDescriptorPool->AllocateDescriptorSet(m_pDescriptorSetLayout);
+	m_pUniformStorageDescriptorSet = GlobalDescriptorAllocator()->AllocateDescriptorSet(m_pDescriptorSetLayout);
 
 	m_descriptorSets = UniformData::GetInstance()->GetDescriptorSets();
 	m_descriptorSets.push_back(m_pUniformStorageDescriptorSet);
@@ -196,6 +187,8 @@ void Material::GeneralInit
 	// Setup cached frame offsets
 	m_cachedFrameOffsets = UniformData::GetInstance()->GetCachedFrameOffsets();
 
+	m_indirectVariablesOffsetIndex = (uint32_t)m_cachedFrameOffsets[0].size() + PerMaterialIndirectVariableBuffer;
+
 	for (uint32_t frameIndex = 0; frameIndex < GetSwapChain()->GetSwapChainImageCount(); frameIndex++)
 	{
 		std::vector<uint32_t> offsets;
@@ -204,6 +197,15 @@ void Material::GeneralInit
 			m_cachedFrameOffsets[frameIndex].push_back(m_materialUniforms[i]->GetFrameOffset() * frameIndex);
 		}
 	}
+
+	if (m_perDrawDataStrategy == PerDrawData_DynamicOffset)
+	{
+		uint32_t minAlign = (uint32_t)GetPhysicalDevice()->GetPhysicalDeviceProperties().limits.minStorageBufferOffsetAlignment;
+		m_indirectVariablesAlignment = PerDrawData::AcquireAlignment(m_perDrawDataStrategy, minAlign);
+
+		// Direct draws all have draw id 0, first offset stays 0 and buffer offset does the rest
+		m_pPerMaterialIndirectOffset->SetIndirectOffset(0, 0);
+	}
 }
 
 bool Material::Init
@@ -237,6 +239,21 @@ bool Material::Init
 	if (!SelfRefBase<Material>::Init(pSelf))
 		return false;
 
+	// Pushed offsets are read by "PER_DRAW_PUSH_CONSTANTS" variant of vertex shader only, "*_push.vert.spv" compile_all_shader.py generates
+	// Until it's there, draws find their variables through dynamic offsets instead, which works with any shader
+	std::vector<std::wstring> materialShaderPaths = shaderPaths;
+	if (m_perDrawDataStrategy == PerDrawData_PushConstants)
+	{
+		std::wstring& vertexShaderPath = materialShaderPaths[ShaderModule::ShaderTypeVertex];
+		std::wstring pushVariantPath = PerDrawData::AcquirePushVariantPath(vertexShaderPath);
+
+		bool hasPushVariant = pushVariantPath != L"" && (pushVariantPath == vertexShaderPath || ShaderLibrary::GetInstance()->Contains(pushVariantPath));
+		if (hasPushVariant)
+			vertexShaderPath = pushVariantPath;
+
+		m_perDrawDataStrategy = PerDrawData::ResolveStrategy(m_perDrawDataStrategy, hasPushVariant);
+	}
+
 	GeneralInit(pushConstsRanges, materialUniformVars, includeIndirectBuffer);
 
 	// Init shaders
@@ -244,8 +261,8 @@ bool Material::Init
 	
 	for (uint32_t i = 0; i < (uint32_t)ShaderModule::ShaderTypeCount; i++)
 	{
-		if (shaderPaths[i] != L"")
-			shaders.push_back(ShaderModule::Create(GetDevice(), shaderPaths[i], (ShaderModule::ShaderType)i, "main"));	//FIXME: hard-coded main
+		if (materialShaderPaths[i] != L"")
+			shaders.push_back(ShaderLibrary::GetInstance()->AcquireShaderModule(materialShaderPaths[i], (ShaderModule::ShaderType)i, "main"));	//FIXME: hard-coded main
 	}
 
 	// Create pipeline
@@ -253,7 +270,7 @@ bool Material::Init
 
 	m_pRenderPass = pRenderPass;
 
-	if (includeIndirectBuffer)
+	if (includeIndirectBuffer && m_perDrawDataStrategy == PerDrawData_IndirectBuffer)
 	{
 		for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 		{
@@ -264,11 +281,18 @@ bool Material::Init
 		{
 			m_indirectCmdCountBuffers.push_back(SharedIndirectBuffer::Create(GetDevice(), sizeof(uint32_t)));
 		}
+
+		if (m_gpuCulling)
+			InitGPUCulling();
 	}
 
 	m_vertexFormat = vertexFormat;
 	m_vertexFormatInMem = vertexFormatInMem;
 
+	// Resolved here on main thread, as lookup creates manager lazily and "BindMeshData" runs on recording threads
+	if (m_vertexFormatInMem != 0)
+		m_pVertexAttribBufferMgr = VertexAttribBufferMgr(m_vertexFormatInMem);
+
 	return true;
 }
 
@@ -284,7 +308,7 @@ bool Material::Init
 	GeneralInit(pushConstsRanges, materialUniformVars, false);
 
 	// Init shader
-	std::shared_ptr<ShaderModule> pShader = ShaderModule::Create(GetDevice(), shaderPath, ShaderModule::ShaderType::ShaderTypeCompute, "main");
+	std::shared_ptr<ShaderModule> pShader = ShaderLibrary::GetInstance()->AcquireShaderModule(shaderPath, ShaderModule::ShaderType::ShaderTypeCompute, "main");
 
 	// Create pipeline
 	m_pComputePipeline = ComputePipeline::Create(GetDevice(), pipelineCreateInfo, pShader, m_pPipelineLayout);
@@ -292,6 +316,46 @@ bool Material::Init
 	return true;
 }
 
+void Material::InitGPUCulling()
+{
+	// Culling kernel handles a material's whole frame in one workgroup
+	static_assert(GPUCuller::MAX_DRAW_COUNT <= MAX_INDIRECT_COUNT && GPUCuller::MAX_DRAW_COUNT <= CommandBuffer::MAX_INDIRECT_DRAW_COUNT, "Culled draws have to fit indirect buffer");
+
+	m_pCullingUniforms = PerMaterialCullingUniforms::Create();
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings =
+	{
+		{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },	// Culling input
+		{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },			// Indirect commands and count
+		{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },			// Indirect offsets
+		{ 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },			// Indirect variables
+		{ 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, GetSwapChain()->GetSwapChainImageCount(), VK_SHADER_STAGE_COMPUTE_BIT, nullptr },	// Hi-Z pyramids
+	};
+	m_pCullingDescriptorSetLayout = GlobalDescriptorAllocator()->AcquireDescriptorSetLayout(bindings);
+	m_pCullingDescriptorSet = GlobalDescriptorAllocator()->AllocateDescriptorSet(m_pCullingDescriptorSetLayout);
+
+	// Outputs of every frame are bound at once and addressed by word offsets in culling input
+	// Indirect buffers of all frames are suballocated from the same device buffer, which is bound as a whole
+	m_pCullingUniforms->SetupDescriptorSet(m_pCullingDescriptorSet, 0);
+	m_pCullingDescriptorSet->UpdateShaderStorageBuffer(1, m_indirectBuffers[0], 0, VK_WHOLE_SIZE);
+	m_pCullingDescriptorSet->UpdateShaderStorageBuffer(2, std::dynamic_pointer_cast<ShaderStorageBuffer>(m_pPerMaterialIndirectOffset->GetBuffer()));
+	m_pCullingDescriptorSet->UpdateShaderStorageBuffer(3, std::dynamic_pointer_cast<ShaderStorageBuffer>(m_pPerMaterialIndirectUniforms->GetBuffer()));
+
+	// Culling input tells which pyramid to read, all of them are bound once
+	std::vector<CombinedImage> pyramids;
+	for (auto& pPyramid : UniformData::GetInstance()->GetGBufferInputUniforms()->GetHiZPyramids())
+		pyramids.push_back({ pPyramid, pPyramid->CreateNearestRepeatSampler(), pPyramid->CreateDefaultImageView() });
+	m_pCullingDescriptorSet->UpdateImages(4, pyramids);
+
+	m_pCullingPipelineLayout = PipelineLayout::Create(GetDevice(), { m_pCullingDescriptorSetLayout });
+
+	VkComputePipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+
+	std::shared_ptr<ShaderModule> pShader = ShaderLibrary::GetInstance()->AcquireShaderModule(L"../data/shaders/gpu_culling.comp.spv", ShaderModule::ShaderType::ShaderTypeCompute, "main");
+	m_pCullingPipeline = ComputePipeline::Create(GetDevice(), createInfo, pShader, m_pCullingPipelineLayout);
+}
+
 // This function follows rule of std430
 // Could be bugs in it
 uint32_t Material::GetByteSize(std::vector<UniformVar>& UBOLayout)
@@ -395,38 +459,39 @@ uint32_t Material::GetUniformBufferSize() const
 
 void Material::SyncBufferData()
 {
-	if (m_indirectBuffers.size() > 0)
+	// Culling kernel writes indirect data of this frame, only its input goes up from here
+	// Unless there's more than it holds, then draws go up unculled below and kernel leaves them alone
+	bool gpuCulled = false;
+	if (IsGPUCullingEnabled())
 	{
-		uint32_t drawID = 0;
-		uint32_t offset = 0;
-		VkDrawIndexedIndirectCommand cmd;
-
-		// Contruct indirect buffer for current frame
-		for each(auto& meshRenderData in m_cachedMeshRenderData)
-		{
-			// Prepare mesh indirect data
-			meshRenderData.pMesh->PrepareIndirectCmd(cmd);
-			cmd.instanceCount = meshRenderData.instanceCount;
-			cmd.firstInstance = meshRenderData.instanceDataOffset;
-			m_indirectBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmd(drawID, cmd);
+		uint32_t frameIndex = FrameMgr()->FrameIndex();
 
-			// Prepare indirect offset
-			m_pPerMaterialIndirectOffset->SetIndirectOffset(drawID, offset);
+		gpuCulled = m_pCullingUniforms->SetDraws(m_cachedIndirectCmds.data(), m_cachedIndirectOffsets.data(), (uint32_t)m_cachedIndirectCmds.size(), m_cachedIndirectVariables.data(), (uint32_t)m_cachedIndirectVariables.size());
+		m_pCullingUniforms->SetOutputWordOffsets
+		(
+			m_indirectBuffers[frameIndex]->GetBufferOffset() / sizeof(uint32_t),
+			m_indirectCmdCountBuffers[frameIndex]->GetBufferOffset() / sizeof(uint32_t),
+			frameIndex * m_pPerMaterialIndirectOffset->GetFrameOffset() / sizeof(uint32_t),
+			frameIndex * m_pPerMaterialIndirectUniforms->GetFrameOffset() / sizeof(uint32_t)
+		);
+		m_pCullingUniforms->SyncBufferData();
+	}
 
-			// Prepare indirect indices for all data
-			for (uint32_t instanceCount = 0; instanceCount < meshRenderData.indirectIndices.size(); instanceCount++)
-			{
-				m_pPerMaterialIndirectUniforms->SetPerObjectIndex(offset, meshRenderData.indirectIndices[instanceCount].perObjectIndex);
-				m_pPerMaterialIndirectUniforms->SetPerMaterialIndex(offset, meshRenderData.indirectIndices[instanceCount].perMaterialIndex);
-				m_pPerMaterialIndirectUniforms->SetPerMeshIndex(offset, meshRenderData.indirectIndices[instanceCount].perMeshIndex);
-				m_pPerMaterialIndirectUniforms->SetUtilityIndex(offset, meshRenderData.indirectIndices[instanceCount].utilityIndex);
-				offset++;
-			}
+	if (!gpuCulled && m_indirectBuffers.size() > 0)
+	{
+		uint32_t drawCount = (uint32_t)m_cachedIndirectCmds.size();
 
-			drawID++;
-		}
+		// Indirect data of current frame is already assembled by render queue, publish each array with one write
+		m_indirectBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmds(m_cachedIndirectCmds.data(), drawCount);
+		m_pPerMaterialIndirectOffset->SetIndirectOffsets(0, m_cachedIndirectOffsets.data(), drawCount);
+		m_pPerMaterialIndirectUniforms->SetIndirectVariables(0, m_cachedIndirectVariables.data(), (uint32_t)m_cachedIndirectVariables.size());
 
-		m_indirectCmdCountBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmdCount((uint32_t)m_cachedMeshRenderData.size());
+		m_indirectCmdCountBuffers[FrameMgr()->FrameIndex()]->SetIndirectCmdCount(drawCount);
+	}
+	else if (!gpuCulled && m_perDrawDataStrategy != PerDrawData_IndirectBuffer)
+	{
+		// Draw arguments go into command buffer, only indirect variables are uploaded
+		m_pPerMaterialIndirectUniforms->SetIndirectVariables(0, m_cachedIndirectVariables.data(), (uint32_t)m_cachedIndirectVariables.size());
 	}
 
 	for (auto & var : m_materialUniforms)
@@ -455,47 +520,48 @@ void Material::BindMeshData(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
 		return;
 
 	// FIXME: Hard-coded 0 as a starting binding slot. Will improve when there's need
-	pCmdBuffer->BindVertexBuffer(VertexAttribBufferMgr(m_vertexFormatInMem)->GetBuffer(), 0, ReservedVBBindingSlot_MeshData);
+	pCmdBuffer->BindVertexBuffer(m_pVertexAttribBufferMgr->GetBuffer(), 0, ReservedVBBindingSlot_MeshData);
 	pCmdBuffer->BindIndexBuffer(IndexBufferMgr()->GetBuffer(), VK_INDEX_TYPE_UINT32);
 }
 
-void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance)
+void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance, uint32_t renderState, float depth)
 {
 	ASSERTION(instanceCount > 0);
 
-	auto iter = m_perFrameMeshRefTable.find(pMesh);
+	// Batching into auto instanced draws is deferred to render queue flush
+	RenderQueue::GetInstance()->Insert(renderState, this, pMesh.get(), { perObjectIndex, perMaterialIndex, perMeshIndex, utilityIndex }, instanceCount, startInstance, depth);
+}
 
-	// Instance count greater than 1 means manually instanced rendering
-	bool manualInstance = instanceCount > 1;
+void Material::AppendIndirectDraw(Mesh* pMesh, uint32_t instanceCount, uint32_t firstInstance, const PerMaterialIndirectVariables* pIndirectVariables, uint32_t indirectVariablesCount)
+{
+	VkDrawIndexedIndirectCommand cmd;
+	pMesh->PrepareIndirectCmd(cmd);
+	cmd.instanceCount = instanceCount;
+	cmd.firstInstance = firstInstance;
+	m_cachedIndirectCmds.push_back(cmd);
+
+	// Offset of this draw's first instance within indirect variables
+	uint32_t alignment = m_perDrawDataStrategy == PerDrawData_DynamicOffset ? m_indirectVariablesAlignment : 1;
+	m_cachedIndirectOffsets.push_back(PerDrawData::AppendIndirectVariables(m_cachedIndirectVariables, pIndirectVariables, indirectVariablesCount, alignment));
+}
 
-	// If a mesh is not yet added to ref table of current frame
-	if (iter == m_perFrameMeshRefTable.end() || manualInstance)
-	{
-		// First all the info into cached mesh render data
-		m_cachedMeshRenderData.push_back
-		(
-			{
-				pMesh,
-				instanceCount,
-				startInstance,
-				std::vector<PerMaterialIndirectVariables>(1, {perObjectIndex, perMaterialIndex, perMeshIndex, utilityIndex })
-			}
-		);
+void Material::RecordDirectDraws(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+{
+	std::vector<uint32_t> offsets = m_cachedFrameOffsets[FrameMgr()->FrameIndex()];
+	uint32_t frameOffset = offsets[m_indirectVariablesOffsetIndex];
 
-		// Then add mesh to ref table, as well as its index in render data table
-		// Ref table is only updated when auto instanced rendering is enabled
-		// Or there's no need to search this mesh and add it to instance count
-		// NOTE: Only add to ref table if it's not manual instanced rendering
-		if (!manualInstance)
-			m_perFrameMeshRefTable[pMesh] = (uint32_t)m_cachedMeshRenderData.size() - 1;
+	for (uint32_t i = 0; i < (uint32_t)m_cachedIndirectCmds.size(); i++)
+	{
+		if (m_perDrawDataStrategy == PerDrawData_DynamicOffset)
+		{
+			offsets[m_indirectVariablesOffsetIndex] = PerDrawData::AcquireDynamicOffset(frameOffset, m_cachedIndirectOffsets[i]);
+			pCmdBuffer->BindDescriptorSets(GetPipelineLayout(), m_descriptorSets, offsets);
+		}
+		else
+			pCmdBuffer->PushConstants(GetPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &m_cachedIndirectOffsets[i]);
 
-		return;
+		pCmdBuffer->DrawIndexed(m_cachedIndirectCmds[i]);
 	}
-
-	// If a mesh is already recorded, add instance count by 1
-	auto& renderData = m_cachedMeshRenderData[iter->second];
-	renderData.instanceCount += 1;
-	renderData.indirectIndices.push_back({ perObjectIndex, perMaterialIndex, perMeshIndex, utilityIndex });
 }
 
 void Material::BeforeRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong)
@@ -541,27 +607,53 @@ void Material::PrepareSecondaryCmd(const std::shared_ptr<CommandBuffer>& pSecond
 	CustomizeSecondaryCmd(pSecondaryCmdBuf, pFrameBuffer, pingpong);
 }
 
+void Material::Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+{
+	std::shared_ptr<CommandBuffer> pSecondaryCmd = RecordDrawCmd(MainThreadPerFrameRes(), pFrameBuffer, pingpong, overrideVP);
+	if (pSecondaryCmd != nullptr)
+		pCmdBuf->Execute({ pSecondaryCmd });
+}
+
 void Material::DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
 {
-	if (m_indirectBuffers.size() == 0)
-		return;
+	std::shared_ptr<CommandBuffer> pSecondaryCmd = RecordIndirectCmd(MainThreadPerFrameRes(), pFrameBuffer, pingpong, overrideVP);
+	if (pSecondaryCmd != nullptr)
+		pCmdBuf->Execute({ pSecondaryCmd });
+}
 
-	std::shared_ptr<CommandBuffer> pSecondaryCmd = MainThreadPerFrameRes()->AllocatePersistantSecondaryCommandBuffer();
+void Material::DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+{
+	pCmdBuf->Execute({ RecordScreenQuadCmd(MainThreadPerFrameRes(), pFrameBuffer, pingpong, overrideVP) });
+}
+
+std::shared_ptr<CommandBuffer> Material::RecordIndirectCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+{
+	if (m_perDrawDataStrategy == PerDrawData_IndirectBuffer && m_indirectBuffers.size() == 0)
+		return nullptr;
+
+	// Direct draws know their count on CPU
+	if (m_perDrawDataStrategy != PerDrawData_IndirectBuffer && m_cachedIndirectCmds.size() == 0)
+		return nullptr;
+
+	std::shared_ptr<CommandBuffer> pSecondaryCmd = pPerFrameRes->AllocatePersistantSecondaryCommandBuffer();
 
 	pSecondaryCmd->StartSecondaryRecording(m_pRenderPass->GetRenderPass(), m_pGraphicPipeline->GetInfo().subpass, pFrameBuffer);
 
 	PrepareSecondaryCmd(pSecondaryCmd, pFrameBuffer, pingpong, overrideVP);
 
-	pSecondaryCmd->DrawIndexedIndirectCount(m_indirectBuffers[FrameMgr()->FrameIndex()], 0, m_indirectCmdCountBuffers[FrameMgr()->FrameIndex()], 0);
+	if (m_perDrawDataStrategy == PerDrawData_IndirectBuffer)
+		pSecondaryCmd->DrawIndexedIndirectCount(m_indirectBuffers[FrameMgr()->FrameIndex()], 0, m_indirectCmdCountBuffers[FrameMgr()->FrameIndex()], 0);
+	else
+		RecordDirectDraws(pSecondaryCmd);
 
 	pSecondaryCmd->EndSecondaryRecording();
 
-	pCmdBuf->Execute({ pSecondaryCmd });
+	return pSecondaryCmd;
 }
 
-void Material::DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+std::shared_ptr<CommandBuffer> Material::RecordScreenQuadCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
 {
-	std::shared_ptr<CommandBuffer> pSecondaryCmd = MainThreadPerFrameRes()->AllocatePersistantSecondaryCommandBuffer();
+	std::shared_ptr<CommandBuffer> pSecondaryCmd = pPerFrameRes->AllocatePersistantSecondaryCommandBuffer();
 
 	pSecondaryCmd->StartSecondaryRecording(m_pRenderPass->GetRenderPass(), m_pGraphicPipeline->GetInfo().subpass, pFrameBuffer);
 
@@ -571,7 +663,33 @@ void Material::DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, con
 
 	pSecondaryCmd->EndSecondaryRecording();
 
-	pCmdBuf->Execute({ pSecondaryCmd });
+	return pSecondaryCmd;
+}
+
+void Material::DispatchCulling(const std::shared_ptr<CommandBuffer>& pCmdBuf)
+{
+	if (!IsGPUCullingEnabled())
+		return;
+
+	uint32_t frameIndex = FrameMgr()->FrameIndex();
+
+	std::shared_ptr<BufferBase> pIndirectOffsetBuffer = m_pPerMaterialIndirectOffset->GetBuffer();
+	std::shared_ptr<BufferBase> pIndirectVariableBuffer = m_pPerMaterialIndirectUniforms->GetBuffer();
+
+	pCmdBuf->RequireBufferAccess(m_indirectBuffers[frameIndex], 0, (uint32_t)m_indirectBuffers[frameIndex]->GetBufferInfo().size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	pCmdBuf->RequireBufferAccess(m_indirectCmdCountBuffers[frameIndex], 0, sizeof(uint32_t), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	pCmdBuf->RequireBufferAccess(pIndirectOffsetBuffer, frameIndex * m_pPerMaterialIndirectOffset->GetFrameOffset(), m_pPerMaterialIndirectOffset->GetFrameOffset(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	pCmdBuf->RequireBufferAccess(pIndirectVariableBuffer, frameIndex * m_pPerMaterialIndirectUniforms->GetFrameOffset(), m_pPerMaterialIndirectUniforms->GetFrameOffset(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	pCmdBuf->FlushBarriers();
+
+	pCmdBuf->BindPipeline(m_pCullingPipeline);
+	pCmdBuf->BindDescriptorSets(m_pCullingPipelineLayout, { m_pCullingDescriptorSet }, { frameIndex * m_pCullingUniforms->GetFrameOffset() }, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+	// Always one workgroup, counts are read on GPU so that prebaked command buffers stay valid
+	pCmdBuf->Dispatch(1, 1, 1);
+
+	// Draws read results as indirect commands and vertex shader storage buffers
+	pCmdBuf->RestoreResourceStates();
 }
 
 void Material::OnFrameBegin()
@@ -583,8 +701,9 @@ void Material::OnFrameEnd()
 	//m_indirectIndex = 0;
 
 	// Clear tables that are used to construct indirect buffer of current frame
-	m_perFrameMeshRefTable.clear();
-	m_cachedMeshRenderData.clear();
+	m_cachedIndirectCmds.clear();
+	m_cachedIndirectOffsets.clear();
+	m_cachedIndirectVariables.clear();
 }
 
 void Material::SetPerObjectIndex(uint32_t indirectIndex, uint32_t perObjectIndex)
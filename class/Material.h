@@ -9,6 +9,8 @@
 #include "../common/Enums.h"
 #include "../Maths/Vector3.h"
 #include "PerMaterialIndirectUniforms.h"
+#include "PerMaterialCullingUniforms.h"
+#include "PerDrawData.h"
 
 #include "../vulkan/Buffer.h"
 
@@ -20,14 +22,15 @@ class DescriptorSet;
 class ShaderModule;
 class RenderPass;
 class MaterialInstance;
-class DescriptorPool;
 class UniformBuffer;
 class ShaderStorageBuffer;
 class CommandBuffer;
 class Image;
 class SharedIndirectBuffer;
+class SharedBufferManager;
 class FrameBuffer;
 class RenderPassBase;
+class PerFrameResource;
 
 // More to add
 enum MaterialVariableType
@@ -51,6 +54,8 @@ typedef struct _SimpleMaterialCreateInfo
 	bool													isTransparent = false;
 	bool													depthTestEnable = true;
 	bool													depthWriteEnable = true;
+	PerDrawDataStrategy										perDrawDataStrategy = PerDrawData_IndirectBuffer;
+	bool													gpuCulling = false;		// Only with "PerDrawData_IndirectBuffer", see "Material::DispatchCulling"
 }SimpleMaterialCreateInfo;
 
 class Material : public SelfRefBase<Material>
@@ -76,6 +81,9 @@ public:
 	std::vector<std::vector<uint32_t>> GetCachedFrameOffsets() const { return m_cachedFrameOffsets; }
 	uint32_t GetVertexFormat() const { return m_vertexFormat; }
 	uint32_t GetVertexFormatInMem() const { return m_vertexFormatInMem; }
+	uint32_t GetMaterialID() const { return m_materialID; }
+	PerDrawDataStrategy GetPerDrawDataStrategy() const { return m_perDrawDataStrategy; }
+	bool IsGPUCullingEnabled() const { return m_pCullingPipeline != nullptr; }
 
 	std::shared_ptr<DescriptorSet> GetDescriptorSet() const { return m_pUniformStorageDescriptorSet; }
 
@@ -115,11 +123,25 @@ public:
 
 	virtual void BeforeRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0);
 
-	virtual void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) = 0;
+	// Record and execute draw commands within "pCmdBuf" right away, secondary command buffer comes from main thread
+	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
 	virtual void DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
 	virtual void DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
 
+	// Record draw commands into a secondary command buffer allocated from "pPerFrameRes", and leave it to caller to execute
+	// Material states and global buffer managers are only read here, anything created lazily has to be resolved in "Init" on main thread
+	// Different materials could then be recorded by different threads, each with its own "pPerFrameRes"
+	// Returns nullptr if there's nothing to draw
+	virtual std::shared_ptr<CommandBuffer> RecordDrawCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) = 0;
+	std::shared_ptr<CommandBuffer> RecordIndirectCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
+	std::shared_ptr<CommandBuffer> RecordScreenQuadCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
+
 	virtual void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const Vector3d& groupNum, const Vector3d& groupSize, uint32_t pingpong = 0) = 0;
+
+	// Cull draws appended this frame on GPU, writing indirect commands, count, offsets and variables that "RecordIndirectCmd" draws with
+	// Recorded outside render passes, before the one drawing this material. Does nothing unless GPU culling is enabled
+	void DispatchCulling(const std::shared_ptr<CommandBuffer>& pCmdBuf);
+
 	virtual void AfterRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0);
 
 	virtual void OnFrameBegin();
@@ -178,20 +200,20 @@ protected:
 	);
 
 	virtual void CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout) {}
-	virtual void CustomizePoolSize(std::vector<uint32_t>& counts) {}
 
 	static uint32_t GetByteSize(std::vector<UniformVar>& UBOLayout);
-	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance);
+	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance, uint32_t renderState, float depth);
 
-protected:
-	typedef struct _MeshRenderData
-	{
-		std::shared_ptr<Mesh>						pMesh;
-		uint32_t									instanceCount;
-		uint32_t									instanceDataOffset;
-		std::vector<PerMaterialIndirectVariables>	indirectIndices;
-	}MeshRenderData;
+	// Called by render queue flush, one call per indirect draw of current frame
+	void AppendIndirectDraw(Mesh* pMesh, uint32_t instanceCount, uint32_t firstInstance, const PerMaterialIndirectVariables* pIndirectVariables, uint32_t indirectVariablesCount);
 
+	// Record draws of current frame one by one, for strategies other than "PerDrawData_IndirectBuffer"
+	void RecordDirectDraws(const std::shared_ptr<CommandBuffer>& pCmdBuffer);
+
+	// Compute pipeline and descriptor set of "gpu_culling.comp", writing into this material's indirect buffers
+	void InitGPUCulling();
+
+protected:
 	std::shared_ptr<RenderPassBase>						m_pRenderPass;
 
 	std::shared_ptr<PipelineLayout>						m_pPipelineLayout;
@@ -200,7 +222,6 @@ protected:
 
 	std::shared_ptr<DescriptorSetLayout>				m_pDescriptorSetLayout;
 	std::shared_ptr<DescriptorSet>						m_pUniformStorageDescriptorSet;
-	std::shared_ptr<DescriptorPool>						m_pDescriptorPool;
 	std::vector<std::shared_ptr<DescriptorSet>>			m_descriptorSets;	// Including descriptor sets from uniform data, and "m_pDescriptorSet" of this class
 
 	std::vector<UniformVarList>							m_materialVariableLayout;
@@ -212,10 +233,10 @@ protected:
 	std::shared_ptr<PerMaterialIndirectUniforms>		m_pPerMaterialIndirectUniforms;
 	std::shared_ptr<PerMaterialUniforms>				m_pPerMaterialUniforms;
 
-	// key: mesh, value: mesh index at "m_cachedMeshRenderData"
-	std::unordered_map<std::shared_ptr<Mesh>, uint32_t>	m_perFrameMeshRefTable;
-
-	std::vector<MeshRenderData>							m_cachedMeshRenderData;
+	// Indirect data of current frame, appended by render queue and published with a single write each
+	std::vector<VkDrawIndexedIndirectCommand>			m_cachedIndirectCmds;
+	std::vector<uint32_t>								m_cachedIndirectOffsets;
+	std::vector<PerMaterialIndirectVariables>			m_cachedIndirectVariables;
 
 	bool												m_isScreenMaterial;
 
@@ -226,5 +247,21 @@ protected:
 	
 	uint32_t											m_vertexFormat;
 	uint32_t											m_vertexFormatInMem;
+	std::shared_ptr<SharedBufferManager>				m_pVertexAttribBufferMgr;
+	uint32_t											m_materialID;
+
+	// Set before "Init", pipeline layout and indirect buffers depend on it
+	PerDrawDataStrategy									m_perDrawDataStrategy = PerDrawData_IndirectBuffer;
+	uint32_t											m_indirectVariablesAlignment = 1;	// In elements, for "PerDrawData_DynamicOffset"
+	uint32_t											m_indirectVariablesOffsetIndex = 0;	// Dynamic offset of indirect variables buffer within frame offsets
+
+	// Set before "Init", indirect data is then produced by "DispatchCulling" rather than uploaded from CPU
+	bool												m_gpuCulling = false;
+	std::shared_ptr<PerMaterialCullingUniforms>			m_pCullingUniforms;
+	std::shared_ptr<DescriptorSetLayout>				m_pCullingDescriptorSetLayout;
+	std::shared_ptr<DescriptorSet>						m_pCullingDescriptorSet;
+	std::shared_ptr<PipelineLayout>						m_pCullingPipelineLayout;
+	std::shared_ptr<ComputePipeline>					m_pCullingPipeline;
 	friend class MaterialInstance;
+	friend class RenderQueue;
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "../vulkan/SwapChain.h"
 #include "../class/UniformData.h"
 #include "../component/MeshRenderer.h"
+#include "RenderWorkManager.h"
 
 MaterialInstance::~MaterialInstance()
 {
@@ -24,18 +25,20 @@ void MaterialInstance::SetMaterialTexture(uint32_t parameterIndex, InGameTexture
 {
 	uint32_t textureIndex;
 	if (!UniformData::GetInstance()->GetGlobalTextures()->GetTextureIndex(type, textureName, textureIndex))
+	{
 		SetParameter(parameterIndex, (float)-1);
+		m_textureStreamingResources.erase(parameterIndex);
+	}
 	else
+	{
 		SetParameter(parameterIndex, (float)textureIndex);
+		m_textureStreamingResources[parameterIndex] = UniformData::GetInstance()->GetGlobalTextures()->GetStreamingResource(type, textureIndex);
+	}
 }
 
 void MaterialInstance::SetMaterialTexture(const std::string& paramName, InGameTextureType type, const std::string& textureName)
 {
-	uint32_t textureIndex;
-	if (!UniformData::GetInstance()->GetGlobalTextures()->GetTextureIndex(type, textureName, textureIndex))
-		SetParameter(paramName, (float)-1);
-	else
-		SetParameter(paramName, (float)textureIndex);
+	SetMaterialTexture(m_pMaterial->GetParamIndex(paramName), type, textureName);
 }
 
 void MaterialInstance::BindPipeline(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
@@ -54,7 +57,13 @@ void MaterialInstance::PrepareMaterial(const std::shared_ptr<CommandBuffer>& pCm
 	BindDescriptorSet(pCmdBuffer);
 }
 
-void MaterialInstance::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance)
+void MaterialInstance::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance, float depth)
 {
-	m_pMaterial->InsertIntoRenderQueue(pMesh, perObjectIndex, m_materialBufferChunkIndex, perMeshIndex, utilityIndex, instanceCount, startInstance);
+	// Lowest render state this instance is drawn in goes to the top of sort key
+	uint32_t renderStateMask = RenderWorkManager::GetInstance()->GetRenderStateMask() & m_renderMask;
+	uint32_t renderState = 0;
+	while (renderStateMask != 0 && (renderStateMask & (1 << renderState)) == 0)
+		renderState++;
+
+	m_pMaterial->InsertIntoRenderQueue(pMesh, perObjectIndex, m_materialBufferChunkIndex, perMeshIndex, utilityIndex, instanceCount, startInstance, renderState, depth);
 }
\ No newline at end of file
@@ -21,6 +21,9 @@ public:
 	void SetMaterialTexture(const std::string& paramName, InGameTextureType type, const std::string& textureName);
 	void PrepareMaterial(const std::shared_ptr<CommandBuffer>& pCmdBuffer);
 
+	// Key: parameter index, value: streaming resource of texture slot it refers to
+	const std::map<uint32_t, uint32_t>& GetTextureStreamingResources() const { return m_textureStreamingResources; }
+
 	// FIXME: should add name based functions to ease of use
 	template <typename T>
 	void SetParameter(uint32_t parameterIndex, T val)
@@ -46,7 +49,8 @@ public:
 		return m_pMaterial->GetParameter<T>(m_materialBufferChunkIndex, paramName);
 	}
 
-	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance);
+	// "depth" is distance from camera, only used to order instances of a draw front to back
+	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance, float depth = 0);
 
 protected:
 	bool Init(const std::shared_ptr<MaterialInstance>& pMaterialInstance);
@@ -58,6 +62,7 @@ protected:
 	std::vector<uint32_t>						m_materialVariables;
 	uint32_t									m_renderMask = 0xffffffff;
 	uint32_t									m_materialBufferChunkIndex;
+	std::map<uint32_t, uint32_t>				m_textureStreamingResources;
 
 	friend class Material;
 	friend class MeshRenderer;
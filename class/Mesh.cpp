@@ -11,6 +11,10 @@
 #include "../common/Util.h"
 #include <codecvt>
 #include <locale>
+#include <atomic>
+
+// Meshes could be created by several import threads at once
+static std::atomic<uint32_t> meshIDCounter(0);
 
 bool Mesh::Init
 (
@@ -22,6 +26,8 @@ bool Mesh::Init
 	if (!SelfRefBase<Mesh>::Init(pSelf))
 		return false;
 
+	m_meshID = meshIDCounter++;
+
 	m_vertexBytes = ::GetVertexBytes(vertexFormat);
 	m_verticesCount = verticesCount;
 	m_indicesCount = indicesCount;
@@ -31,6 +37,13 @@ bool Mesh::Init
 	m_pIndexBuffer = SharedIndexBuffer::Create(GetDevice(), indicesCount * GetIndexBytes(indexType), indexType);
 	m_pIndexBuffer->UpdateByteStream(pIndices, 0, indicesCount * GetIndexBytes(indexType));
 
+	// Bounds could only be read from full precision positions, packed ones get theirs from LOD chain
+	if ((vertexFormat & (1 << VAFPosition)) && (vertexFormat & ((1 << VAPFPositionHalf) | (1 << VAPFPositionSnorm16))) == 0)
+	{
+		m_boundingSphere = MeshSimplifier::ComputeBoundingSphere((const uint8_t*)pVertices, m_verticesCount, m_vertexBytes);
+		MeshSimplifier::ComputeBoundingBox((const uint8_t*)pVertices, m_verticesCount, m_vertexBytes, m_boundingBoxMin, m_boundingBoxMax);
+	}
+
 	return true;
 }
 
@@ -79,98 +92,156 @@ std::vector<std::shared_ptr<Mesh>> Mesh::CreateMeshes(const std::string& filePat
 	return meshes;
 }
 
-std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVertexFormat)
+std::shared_ptr<Mesh> Mesh::Create
+(
+	const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
+	const void* pIndices, uint32_t indicesCount, VkIndexType indexType,
+	const std::vector<std::size_t>& boneNameHashes, const std::vector<DualQuaterniond>& boneOffsets,
+	const VertexPacker::Dequantization& dequantization,
+	const MeshSimplifier::LodChain& lodChain
+)
+{
+	std::shared_ptr<Mesh> pRetMesh = std::make_shared<Mesh>();
+	if (pRetMesh.get() && pRetMesh->Init
+	(
+		pRetMesh,
+		pVertices, verticesCount, vertexFormat,
+		pIndices, indicesCount, indexType
+	))
+	{
+		pRetMesh->InitPerMeshData(boneNameHashes, boneOffsets, dequantization);
+		pRetMesh->InitLods(lodChain);
+		return pRetMesh;
+	}
+	return nullptr;
+}
+
+bool Mesh::Init(const std::shared_ptr<Mesh>& pSelf, const std::shared_ptr<Mesh>& pSourceMesh, const MeshSimplifier::Lod& lod)
+{
+	if (!SelfRefBase<Mesh>::Init(pSelf))
+		return false;
+
+	// A LOD is a different draw from its source mesh, so it gets its own id
+	m_meshID = meshIDCounter++;
+
+	// Everything but index range comes from source mesh
+	m_pVertexBuffer = pSourceMesh->m_pVertexBuffer;
+	m_pIndexBuffer = pSourceMesh->m_pIndexBuffer;
+	m_verticesCount = pSourceMesh->m_verticesCount;
+	m_vertexBytes = pSourceMesh->m_vertexBytes;
+	m_meshChunkIndex = pSourceMesh->m_meshChunkIndex;
+	m_meshBoneChunkIndexOffset = pSourceMesh->m_meshBoneChunkIndexOffset;
+	m_boneCount = pSourceMesh->m_boneCount;
+	m_dequantization = pSourceMesh->m_dequantization;
+	m_boundingSphere = pSourceMesh->m_boundingSphere;
+	m_boundingBoxMin = pSourceMesh->m_boundingBoxMin;
+	m_boundingBoxMax = pSourceMesh->m_boundingBoxMax;
+
+	m_firstIndex = lod.firstIndex;
+	m_indicesCount = lod.indicesCount;
+	m_lodError = lod.error;
+
+	return true;
+}
+
+void Mesh::InitLods(const MeshSimplifier::LodChain& lodChain)
+{
+	// Default LOD chain has no bounds, keep what's computed from vertices
+	if (lodChain.boundingSphere.w > 0)
+	{
+		m_boundingSphere = lodChain.boundingSphere;
+		m_boundingBoxMin = lodChain.boundingBoxMin;
+		m_boundingBoxMax = lodChain.boundingBoxMax;
+	}
+
+	// No LOD generated, the whole index buffer is LOD 0
+	if (lodChain.lods.size() == 0)
+		return;
+
+	m_firstIndex = lodChain.lods[0].firstIndex;
+	m_indicesCount = lodChain.lods[0].indicesCount;
+	m_lodError = lodChain.lods[0].error;
+
+	for (uint32_t i = 1; i < lodChain.lods.size(); i++)
+	{
+		std::shared_ptr<Mesh> pLod = std::make_shared<Mesh>();
+		if (pLod.get() && pLod->Init(pLod, GetSelfSharedPtr(), lodChain.lods[i]))
+			m_lods.push_back(pLod);
+	}
+}
+
+void Mesh::InitPerMeshData(const std::vector<std::size_t>& boneNameHashes, const std::vector<DualQuaterniond>& boneOffsets, const VertexPacker::Dequantization& dequantization)
+{
+	ASSERTION(boneNameHashes.size() == boneOffsets.size());
+
+	m_boneCount = (uint32_t)boneNameHashes.size();
+
+	if (m_boneCount)
+		m_meshBoneChunkIndexOffset = UniformData::GetInstance()->GetPerBoneIndirectUniforms()->AllocateConsecutiveChunks(m_boneCount);
+
+	for (uint32_t i = 0; i < m_boneCount; i++)
+		UniformData::GetInstance()->GetPerBoneIndirectUniforms()->SetBoneTransform(m_meshBoneChunkIndexOffset, boneNameHashes[i], boneOffsets[i]);
+
+	m_meshChunkIndex = UniformData::GetInstance()->GetPerMeshUniforms()->AllocatePerObjectChunk();
+	UniformData::GetInstance()->GetPerMeshUniforms()->SetBoneChunkIndexOffset(m_meshChunkIndex, m_meshBoneChunkIndexOffset);
+
+	m_dequantization = dequantization;
+	UniformData::GetInstance()->GetPerMeshUniforms()->SetDequantization(m_meshChunkIndex, m_dequantization);
+}
+
+uint32_t Mesh::AcquireVertexFormat(const aiMesh* pMesh)
 {
 	uint32_t vertexFormat = 0;
 
-	uint32_t vertexSize = 0;
 	if (pMesh->HasPositions())
-	{
-		vertexSize += 3 * sizeof(float);
 		vertexFormat |= (1 << VAFPosition);
-	}
 	if (pMesh->HasNormals())
-	{
-		vertexSize += 3 * sizeof(float);
 		vertexFormat |= (1 << VAFNormal);
-	}
 	//FIXME: hard-coded index 0 here, we don't have more than 1 color for now
 	if (pMesh->HasVertexColors(0))
-	{
-		vertexSize += 4 * sizeof(float);
 		vertexFormat |= (1 << VAFColor);
-	}
 	//FIXME: hard-coded index 0 here, we don't have more than 1 texture coord for now
 	if (pMesh->HasTextureCoords(0))
-	{
-		vertexSize += 2 * sizeof(float);
 		vertexFormat |= (1 << VAFTexCoord);
-	}
 	if (pMesh->HasTangentsAndBitangents())
-	{
-		vertexSize += 3 * sizeof(float);
 		vertexFormat |= (1 << VAFTangent);
-	}
 	if (pMesh->HasBones())
-	{
-		vertexSize += 4 * sizeof(float);	// Bone weight
-		vertexSize += 4 * sizeof(uint8_t);	// Bone index
 		vertexFormat |= (1 << VAFBone);
-	}
 
-	if (vertexFormat != argumentedVertexFormat && argumentedVertexFormat != 0)
-		return nullptr;
+	return vertexFormat;
+}
+
+void Mesh::AssemblyVertices(const aiMesh* pMesh, uint32_t vertexFormat, uint8_t* pVertices)
+{
+	uint32_t vertexBytes = ::GetVertexBytes(vertexFormat);
+	uint32_t attribOffset = 0;
 
-	float* pVertices = new float[pMesh->mNumVertices * vertexSize / sizeof(float)];
-	memset(pVertices, 0, pMesh->mNumVertices * vertexSize);
-	uint32_t verticesNumBytes = pMesh->mNumVertices * vertexSize;
-	uint32_t count = 0;
+	memset(pVertices, 0, pMesh->mNumVertices * vertexBytes);
 
-	for (uint32_t i = 0; i < pMesh->mNumVertices; i++)
+	// Copy attribute by attribute rather than vertex by vertex, so that there's no per-vertex format check
+	auto copyAttrib = [&](const void* pSrc, uint32_t srcStride, uint32_t numBytes)
 	{
-		uint32_t offset = i * vertexSize / sizeof(float);
-		count = 0;
-		if (vertexFormat & (1 << VAFPosition))
-		{
-			pVertices[offset] = pMesh->mVertices[i].x;
-			pVertices[offset + 1] = pMesh->mVertices[i].y;
-			pVertices[offset + 2] = pMesh->mVertices[i].z;
-			count += 3;
-		}
-		if (vertexFormat & (1 << VAFNormal))
-		{
-			pVertices[offset + count] = pMesh->mNormals[i].x;
-			pVertices[offset + count + 1] = pMesh->mNormals[i].y;
-			pVertices[offset + count + 2] = pMesh->mNormals[i].z;
-			count += 3;
-		}
-		if (vertexFormat & (1 << VAFColor))
-		{
-			pVertices[offset + count] = pMesh->mColors[i][0].r;
-			pVertices[offset + count + 1] = pMesh->mColors[i][0].g;
-			pVertices[offset + count + 2] = pMesh->mColors[i][0].b;
-			pVertices[offset + count + 3] = pMesh->mColors[i][0].a;
-			count += 4;
-		}
-		if (vertexFormat & (1 << VAFTexCoord))
-		{
-			pVertices[offset + count] = pMesh->mTextureCoords[0][i].x;
-			pVertices[offset + count + 1] = pMesh->mTextureCoords[0][i].y;
-			count += 2;
-		}
-		if (vertexFormat & (1 << VAFTangent))
-		{
-			pVertices[offset + count] = pMesh->mTangents[i].x;
-			pVertices[offset + count + 1] = pMesh->mTangents[i].y;
-			pVertices[offset + count + 2] = pMesh->mTangents[i].z;
-			count += 3;
-		}
-	}
+		const uint8_t* pSrcBytes = (const uint8_t*)pSrc;
+		uint8_t* pDstBytes = pVertices + attribOffset;
+		for (uint32_t i = 0; i < pMesh->mNumVertices; i++)
+			memcpy(pDstBytes + i * vertexBytes, pSrcBytes + i * srcStride, numBytes);
+
+		attribOffset += numBytes;
+	};
+
+	if (vertexFormat & (1 << VAFPosition))
+		copyAttrib(pMesh->mVertices, sizeof(aiVector3D), 3 * sizeof(float));
+	if (vertexFormat & (1 << VAFNormal))
+		copyAttrib(pMesh->mNormals, sizeof(aiVector3D), 3 * sizeof(float));
+	if (vertexFormat & (1 << VAFColor))
+		copyAttrib(pMesh->mColors[0], sizeof(aiColor4D), 4 * sizeof(float));
+	if (vertexFormat & (1 << VAFTexCoord))
+		copyAttrib(pMesh->mTextureCoords[0], sizeof(aiVector3D), 2 * sizeof(float));
+	if (vertexFormat & (1 << VAFTangent))
+		copyAttrib(pMesh->mTangents, sizeof(aiVector3D), 3 * sizeof(float));
 
 	if (vertexFormat & (1 << VAFBone))
 	{
-		uint32_t vertexSizeInFloats = vertexSize / sizeof(float);
-
 		uint8_t* pOffsets = new uint8_t[pMesh->mNumVertices];
 		memset(pOffsets, 0, pMesh->mNumVertices);
 		for (uint32_t i = 0; i < pMesh->mNumBones; i++)
@@ -182,56 +253,107 @@ std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVerte
 
 				ASSERTION(pOffsets[vertexID] <= 4);
 
-				pVertices[vertexSizeInFloats * vertexID + count + pOffsets[vertexID]] = boneWeight;
+				uint8_t* pBoneData = pVertices + vertexBytes * vertexID + attribOffset;
+				((float*)pBoneData)[pOffsets[vertexID]] = boneWeight;
 
-				uint8_t* pBoneIndex = (uint8_t*)(&pVertices[vertexSizeInFloats * vertexID + count + 4]);
-				pBoneIndex[pOffsets[vertexID]] = i;
+				// Bone index right after 4 bone weights
+				pBoneData[sizeof(float) * 4 + pOffsets[vertexID]] = i;
 
 				pOffsets[vertexID]++;
 			}
 		}
 		delete[] pOffsets;
 	}
+}
 
-	uint32_t* pIndices = new uint32_t[pMesh->mNumFaces * 3];
-	uint32_t indicesNumBytes = pMesh->mNumFaces * 3 * sizeof(uint32_t);
+void Mesh::AssemblyIndices(const aiMesh* pMesh, uint32_t* pIndices)
+{
 	for (size_t i = 0; i < pMesh->mNumFaces; i++)
 	{
 		pIndices[i * 3] = pMesh->mFaces[i].mIndices[0];
 		pIndices[i * 3 + 1] = pMesh->mFaces[i].mIndices[1];
 		pIndices[i * 3 + 2] = pMesh->mFaces[i].mIndices[2];
 	}
+}
 
-	std::shared_ptr<Mesh> pRetMesh = std::make_shared<Mesh>();
-	if (pRetMesh.get() && pRetMesh->Init
-	(
-		pRetMesh,
-		pVertices, pMesh->mNumVertices, vertexFormat,
-		pIndices, pMesh->mNumFaces * 3, VK_INDEX_TYPE_UINT32
-	))
+std::size_t Mesh::AcquireBoneNameHash(const std::string& boneName)
+{
+	return std::hash<std::wstring>()(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(boneName));
+}
+
+void Mesh::AcquireBoneData(const aiMesh* pMesh, std::vector<std::size_t>& boneNameHashes, std::vector<DualQuaterniond>& boneOffsets)
+{
+	for (uint32_t i = 0; i < pMesh->mNumBones; i++)
 	{
-		pRetMesh->m_boneCount = pMesh->mNumBones;
+		boneNameHashes.push_back(AcquireBoneNameHash(pMesh->mBones[i]->mName.C_Str()));
+		boneOffsets.push_back(AssimpDataConverter::AcquireDualQuaternion(pMesh->mBones[i]->mOffsetMatrix));
+	}
+}
 
-		if (pMesh->mNumBones)
-			pRetMesh->m_meshBoneChunkIndexOffset = UniformData::GetInstance()->GetPerBoneIndirectUniforms()->AllocateConsecutiveChunks(pMesh->mNumBones);
+bool Mesh::MatchVertexFormat(uint32_t vertexFormat, uint32_t argumentedVertexFormat)
+{
+	return argumentedVertexFormat == 0 || (argumentedVertexFormat & VERTEX_ATTRIB_MASK) == vertexFormat;
+}
 
-		for (uint32_t i = 0; i < pMesh->mNumBones; i++)
-		{
-			DualQuaterniond dq = AssimpDataConverter::AcquireDualQuaternion(pMesh->mBones[i]->mOffsetMatrix);
-			UniformData::GetInstance()->GetPerBoneIndirectUniforms()->SetBoneTransform(pRetMesh->m_meshBoneChunkIndexOffset, std::hash<std::wstring>()(std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(pMesh->mBones[i]->mName.C_Str())), dq);
-		}
+uint32_t Mesh::AssemblyMeshData
+(
+	const aiMesh* pMesh, uint32_t argumentedVertexFormat,
+	std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices,
+	VertexPacker::Dequantization& dequantization, MeshOptimizer::Report& optimizeReport, MeshSimplifier::LodChain& lodChain
+)
+{
+	uint32_t vertexFormat = AcquireVertexFormat(pMesh);
 
-		pRetMesh->m_meshChunkIndex = UniformData::GetInstance()->GetPerMeshUniforms()->AllocatePerObjectChunk();
-		UniformData::GetInstance()->GetPerMeshUniforms()->SetBoneChunkIndexOffset(pRetMesh->m_meshChunkIndex, pRetMesh->m_meshBoneChunkIndexOffset);
+	if (!MatchVertexFormat(vertexFormat, argumentedVertexFormat))
+		return 0;
 
-		delete[] pVertices;
-		delete[] pIndices;
-		return pRetMesh;
-	}
+	vertices.resize(pMesh->mNumVertices * ::GetVertexBytes(vertexFormat));
+	AssemblyVertices(pMesh, vertexFormat, vertices.data());
 
-	delete[] pVertices;
-	delete[] pIndices;
-	return nullptr;
+	indices.resize(pMesh->mNumFaces * 3);
+	AssemblyIndices(pMesh, indices.data());
+
+	// Optimization and simplification work on full precision vertices
+	optimizeReport = MeshOptimizer::Optimize(vertexFormat, vertices, indices);
+	lodChain = MeshSimplifier::GenerateLods(vertexFormat, vertices, indices);
+
+	uint32_t packedVertexFormat = argumentedVertexFormat == 0 ? vertexFormat : argumentedVertexFormat;
+	dequantization = VertexPacker::Dequantization();
+	if (packedVertexFormat == vertexFormat)
+		return vertexFormat;
+
+	uint32_t verticesCount = (uint32_t)(vertices.size() / ::GetVertexBytes(vertexFormat));
+	std::vector<uint8_t> packedVertices(verticesCount * ::GetVertexBytes(packedVertexFormat));
+	dequantization = VertexPacker::Pack(packedVertexFormat, vertices.data(), verticesCount, packedVertices.data());
+
+	ASSERTION(VertexPacker::Validate(packedVertexFormat, dequantization, vertices.data(), packedVertices.data(), verticesCount));
+
+	vertices.swap(packedVertices);
+	return packedVertexFormat;
+}
+
+std::shared_ptr<Mesh> Mesh::Create(const aiMesh* pMesh, uint32_t argumentedVertexFormat)
+{
+	std::vector<uint8_t> vertices;
+	std::vector<uint32_t> indices;
+	VertexPacker::Dequantization dequantization;
+	MeshOptimizer::Report optimizeReport;
+	MeshSimplifier::LodChain lodChain;
+
+	uint32_t vertexFormat = AssemblyMeshData(pMesh, argumentedVertexFormat, vertices, indices, dequantization, optimizeReport, lodChain);
+	if (vertexFormat == 0)
+		return nullptr;
+
+	std::vector<std::size_t> boneNameHashes;
+	std::vector<DualQuaterniond> boneOffsets;
+	AcquireBoneData(pMesh, boneNameHashes, boneOffsets);
+
+	return Create
+	(
+		vertices.data(), (uint32_t)(vertices.size() / ::GetVertexBytes(vertexFormat)), vertexFormat,
+		indices.data(), (uint32_t)indices.size(), VK_INDEX_TYPE_UINT32,
+		boneNameHashes, boneOffsets, dequantization, lodChain
+	);
 }
 
 uint32_t Mesh::GetVertexFormat() const
@@ -246,6 +368,6 @@ void Mesh::PrepareIndirectCmd(VkDrawIndexedIndirectCommand& cmd)
 	cmd.instanceCount = 1;
 
 	cmd.vertexOffset = GetVertexBuffer()->GetBufferOffset() / m_vertexBytes;
-	cmd.firstIndex = GetIndexBuffer()->GetBufferOffset() / GetIndexBytes(GetIndexBuffer()->GetType());
+	cmd.firstIndex = GetIndexBuffer()->GetBufferOffset() / GetIndexBytes(GetIndexBuffer()->GetType()) + m_firstIndex;
 	cmd.indexCount = m_indicesCount;
 }
\ No newline at end of file
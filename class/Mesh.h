@@ -4,6 +4,10 @@
 #include "../vulkan/DeviceObjectBase.h"
 #include <string>
 #include "../common/Enums.h"
+#include "../Maths/DualQuaternion.h"
+#include "VertexPacker.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "scene.h"
 
 class SharedVertexBuffer;
@@ -21,6 +25,40 @@ public:
 		const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
 		const void* pIndices, uint32_t indicesCount, VkIndexType indexType
 	);
+	static std::shared_ptr<Mesh> Create
+	(
+		const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
+		const void* pIndices, uint32_t indicesCount, VkIndexType indexType,
+		const std::vector<std::size_t>& boneNameHashes, const std::vector<DualQuaterniond>& boneOffsets,
+		const VertexPacker::Dequantization& dequantization = VertexPacker::Dequantization(),
+		const MeshSimplifier::LodChain& lodChain = MeshSimplifier::LodChain()
+	);
+
+public:
+	// Argumented vertex format 0 matches everything, pack flags are ignored
+	static bool MatchVertexFormat(uint32_t vertexFormat, uint32_t argumentedVertexFormat);
+
+	// Assembly, optimize, generate LODs and pack vertices & indices of an assimp mesh, indices of all LODs go one after another
+	// Returns vertex format of the result, or 0 if "argumentedVertexFormat" doesn't match
+	static uint32_t AssemblyMeshData
+	(
+		const aiMesh* pMesh, uint32_t argumentedVertexFormat,
+		std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices,
+		VertexPacker::Dequantization& dequantization, MeshOptimizer::Report& optimizeReport, MeshSimplifier::LodChain& lodChain
+	);
+
+	// Vertex format an assimp mesh is able to provide
+	static uint32_t AcquireVertexFormat(const aiMesh* pMesh);
+
+	// Interleave assimp mesh attributes into "pVertices", with the layout of "vertexFormat"
+	// "pVertices" should be at least "mNumVertices * GetVertexBytes(vertexFormat)" bytes
+	static void AssemblyVertices(const aiMesh* pMesh, uint32_t vertexFormat, uint8_t* pVertices);
+
+	// "pIndices" should be at least "mNumFaces * 3" indices
+	static void AssemblyIndices(const aiMesh* pMesh, uint32_t* pIndices);
+
+	static void AcquireBoneData(const aiMesh* pMesh, std::vector<std::size_t>& boneNameHashes, std::vector<DualQuaterniond>& boneOffsets);
+	static std::size_t AcquireBoneNameHash(const std::string& boneName);
 
 public:
 	std::shared_ptr<SharedVertexBuffer> GetVertexBuffer() const { return m_pVertexBuffer; }
@@ -28,12 +66,26 @@ public:
 	uint32_t GetVertexFormat() const;
 	uint32_t GetVertexBytes() const { return m_vertexBytes; }
 	uint32_t GetVerticesCount() const { return m_verticesCount; }
+	uint32_t GetIndicesCount() const { return m_indicesCount; }
 	uint32_t GetMeshChunkIndex() const { return m_meshChunkIndex; }
+	uint32_t GetMeshID() const { return m_meshID; }
 	uint32_t GetMeshBoneChunkIndexOffset() const { return m_meshBoneChunkIndexOffset; }
 	uint32_t ContainBoneData() const { return m_meshChunkIndex != -1; }
 	uint32_t GetBoneCount() const { return m_boneCount; }
+	const VertexPacker::Dequantization& GetDequantization() const { return m_dequantization; }
+	const Vector4f& GetBoundingSphere() const { return m_boundingSphere; }
+	const Vector3f& GetBoundingBoxMin() const { return m_boundingBoxMin; }
+	const Vector3f& GetBoundingBoxMax() const { return m_boundingBoxMax; }
+
+	// Meshes with packed positions and no LOD chain carry no bounds, they're never culled
+	bool HasBounds() const { return m_boundingSphere.w > 0; }
 	void PrepareIndirectCmd(VkDrawIndexedIndirectCommand& cmd);
 
+	// LOD 0 is the mesh itself, coarser LODs share its vertex & index buffer and differ only by index range
+	uint32_t GetLodCount() const { return (uint32_t)m_lods.size() + 1; }
+	std::shared_ptr<Mesh> GetLod(uint32_t lod) const { return lod == 0 ? GetSelfSharedPtr() : m_lods[lod - 1]; }
+	float GetLodError(uint32_t lod) const { return lod == 0 ? m_lodError : m_lods[lod - 1]->m_lodError; }
+
 protected:
 	bool Init
 	(
@@ -42,13 +94,27 @@ protected:
 		const void* pIndices, uint32_t indicesCount, VkIndexType indexType
 	);
 
+	bool Init(const std::shared_ptr<Mesh>& pSelf, const std::shared_ptr<Mesh>& pSourceMesh, const MeshSimplifier::Lod& lod);
+
+	void InitPerMeshData(const std::vector<std::size_t>& boneNameHashes, const std::vector<DualQuaterniond>& boneOffsets, const VertexPacker::Dequantization& dequantization);
+	void InitLods(const MeshSimplifier::LodChain& lodChain);
+
 protected:
 	std::shared_ptr<SharedVertexBuffer>	m_pVertexBuffer;
 	std::shared_ptr<SharedIndexBuffer>	m_pIndexBuffer;
 	uint32_t							m_verticesCount;
 	uint32_t							m_vertexBytes;
 	uint32_t							m_indicesCount;
+	uint32_t							m_firstIndex = 0;
+	uint32_t							m_meshID;
 	uint32_t							m_meshChunkIndex = -1;
 	uint32_t							m_meshBoneChunkIndexOffset;
-	uint32_t							m_boneCount;
+	uint32_t							m_boneCount = 0;
+	VertexPacker::Dequantization		m_dequantization;
+
+	Vector4f							m_boundingSphere;
+	Vector3f							m_boundingBoxMin;
+	Vector3f							m_boundingBoxMax;
+	float								m_lodError = 0;
+	std::vector<std::shared_ptr<Mesh>>	m_lods;
 };
\ No newline at end of file
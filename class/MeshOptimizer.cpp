@@ -0,0 +1,335 @@
+#include "MeshOptimizer.h"
+#include "../common/Util.h"
+#include "../common/Enums.h"
+#include "../Maths/Vector.h"
+#include <algorithm>
+#include <cstring>
+
+static uint32_t HashVertex(const uint8_t* pBytes, uint32_t numBytes)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (uint32_t i = 0; i < numBytes; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+MeshOptimizer::Report MeshOptimizer::Optimize(uint32_t vertexFormat, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, uint32_t cacheSize)
+{
+	uint32_t vertexBytes = GetVertexBytes(vertexFormat);
+
+	Report report = {};
+	report.trianglesCount = (uint32_t)indices.size() / 3;
+	report.verticesCountBefore = (uint32_t)(vertices.size() / vertexBytes);
+
+	if (report.trianglesCount == 0 || report.verticesCountBefore == 0)
+		return report;
+
+	uint32_t transformedBefore = SimulateVertexCache(indices, report.verticesCountBefore, cacheSize);
+
+	WeldVertices(vertexBytes, vertices, indices);
+
+	std::vector<uint32_t> clusters;
+	OptimizeVertexCache(indices, (uint32_t)(vertices.size() / vertexBytes), cacheSize, clusters);
+
+	if (vertexFormat & (1 << VAFPosition))
+		OptimizeOverdraw(vertices.data(), vertexBytes, indices, clusters);
+
+	OptimizeVertexFetch(vertexBytes, vertices, indices);
+
+	report.verticesCountAfter = (uint32_t)(vertices.size() / vertexBytes);
+
+	uint32_t transformedAfter = SimulateVertexCache(indices, report.verticesCountAfter, cacheSize);
+
+	report.acmrBefore = transformedBefore / (float)report.trianglesCount;
+	report.acmrAfter = transformedAfter / (float)report.trianglesCount;
+	report.atvrBefore = transformedBefore / (float)report.verticesCountAfter;
+	report.atvrAfter = transformedAfter / (float)report.verticesCountAfter;
+
+	return report;
+}
+
+void MeshOptimizer::WeldVertices(uint32_t vertexBytes, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices)
+{
+	uint32_t verticesCount = (uint32_t)(vertices.size() / vertexBytes);
+
+	// Open addressing hash table, at least twice as large as vertex count to keep probing short
+	uint32_t tableSize = 1;
+	while (tableSize < verticesCount * 2)
+		tableSize <<= 1;
+
+	std::vector<uint32_t> table(tableSize, UINT32_MAX);
+	std::vector<uint32_t> remap(verticesCount);
+	uint32_t uniqueCount = 0;
+
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		const uint8_t* pVertex = vertices.data() + i * vertexBytes;
+		uint32_t slot = HashVertex(pVertex, vertexBytes) & (tableSize - 1);
+
+		while (true)
+		{
+			if (table[slot] == UINT32_MAX)
+			{
+				// Unique vertices are compacted towards the front, "uniqueCount" never exceeds "i" so nothing unprocessed gets overwritten
+				if (uniqueCount != i)
+					memcpy(vertices.data() + uniqueCount * vertexBytes, pVertex, vertexBytes);
+
+				table[slot] = uniqueCount;
+				remap[i] = uniqueCount++;
+				break;
+			}
+
+			if (memcmp(vertices.data() + table[slot] * vertexBytes, pVertex, vertexBytes) == 0)
+			{
+				remap[i] = table[slot];
+				break;
+			}
+
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+
+	vertices.resize(uniqueCount * vertexBytes);
+
+	for (auto& index : indices)
+		index = remap[index];
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t verticesCount, uint32_t cacheSize, std::vector<uint32_t>& clusters)
+{
+	uint32_t trianglesCount = (uint32_t)indices.size() / 3;
+
+	clusters.clear();
+	if (trianglesCount == 0 || verticesCount == 0)
+		return;
+
+	// Vertex to triangle adjacency, packed
+	std::vector<uint32_t> liveTriangles(verticesCount, 0);
+	for (auto index : indices)
+		liveTriangles[index]++;
+
+	std::vector<uint32_t> adjacencyOffsets(verticesCount + 1, 0);
+	for (uint32_t i = 0; i < verticesCount; i++)
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t i = 0; i < trianglesCount; i++)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+			adjacency[fillOffsets[indices[i * 3 + j]]++] = i;
+	}
+
+	std::vector<uint32_t> cacheTimeStamps(verticesCount, 0);
+	std::vector<bool> emitted(trianglesCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t timeStamp = cacheSize + 1;
+	uint32_t cursor = 0;
+	int32_t fanningVertex = 0;
+	bool newCluster = true;
+
+	auto inCache = [&](uint32_t vertex) { return timeStamp - cacheTimeStamps[vertex] <= cacheSize; };
+
+	while (fanningVertex >= 0)
+	{
+		candidates.clear();
+
+		// Emit all remaining triangles around fanning vertex
+		for (uint32_t i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; i++)
+		{
+			uint32_t triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+
+			if (newCluster)
+			{
+				clusters.push_back((uint32_t)output.size() / 3);
+				newCluster = false;
+			}
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t vertex = indices[triangle * 3 + j];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if (!inCache(vertex))
+					cacheTimeStamps[vertex] = timeStamp++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// Next fanning vertex is the oldest candidate that still stays in cache after all its triangles are emitted
+		fanningVertex = -1;
+		uint32_t bestPriority = 0;
+		for (auto vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			uint32_t priority = 0;
+			if (timeStamp - cacheTimeStamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = timeStamp - cacheTimeStamps[vertex];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanningVertex = (int32_t)vertex;
+			}
+		}
+
+		if (fanningVertex >= 0)
+			continue;
+
+		// Dead end, go back to most recently referenced vertex that still has triangles left
+		while (!deadEnds.empty() && fanningVertex < 0)
+		{
+			uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0)
+				fanningVertex = (int32_t)vertex;
+		}
+
+		// Otherwise scan for the next vertex with triangles left
+		while (fanningVertex < 0 && cursor < verticesCount)
+		{
+			if (liveTriangles[cursor] > 0)
+				fanningVertex = (int32_t)cursor;
+			else
+				cursor++;
+		}
+
+		// Cache has been flushed, triangles after this point can be reordered freely without hurting cache efficiency much
+		if (fanningVertex >= 0 && !inCache((uint32_t)fanningVertex))
+			newCluster = true;
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(const uint8_t* pVertices, uint32_t vertexBytes, std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters)
+{
+	uint32_t trianglesCount = (uint32_t)indices.size() / 3;
+	if (clusters.size() <= 1)
+		return;
+
+	auto position = [pVertices, vertexBytes](uint32_t vertex)
+	{
+		const float* pPosition = (const float*)(pVertices + vertex * vertexBytes);
+		return Vector3f(pPosition[0], pPosition[1], pPosition[2]);
+	};
+
+	typedef struct _Cluster
+	{
+		uint32_t	start;
+		uint32_t	end;
+		Vector3f	centroid;
+		Vector3f	normal;
+		float		sortKey;
+	}Cluster;
+
+	std::vector<Cluster> clusterList(clusters.size());
+	Vector3f meshCentroid;
+	float meshArea = 0;
+
+	for (uint32_t i = 0; i < clusters.size(); i++)
+	{
+		Cluster& cluster = clusterList[i];
+		cluster.start = clusters[i];
+		cluster.end = (i + 1 < clusters.size()) ? clusters[i + 1] : trianglesCount;
+
+		// Area weighted centroid and normal
+		float clusterArea = 0;
+		for (uint32_t j = cluster.start; j < cluster.end; j++)
+		{
+			Vector3f p0 = position(indices[j * 3]);
+			Vector3f p1 = position(indices[j * 3 + 1]);
+			Vector3f p2 = position(indices[j * 3 + 2]);
+
+			Vector3f areaNormal = (p1 - p0) ^ (p2 - p0);
+			float area = areaNormal.Length();
+
+			cluster.centroid += (p0 + p1 + p2) * (area / 3.0f);
+			cluster.normal += areaNormal;
+			clusterArea += area;
+		}
+
+		meshCentroid += cluster.centroid;
+		meshArea += clusterArea;
+
+		if (clusterArea > 0)
+			cluster.centroid /= clusterArea;
+	}
+
+	if (meshArea > 0)
+		meshCentroid /= meshArea;
+
+	// Clusters facing outward are more likely to occlude others, so draw them first
+	for (auto& cluster : clusterList)
+	{
+		float normalLength = cluster.normal.Length();
+		cluster.sortKey = normalLength > 0 ? ((cluster.centroid - meshCentroid) * cluster.normal) / normalLength : 0;
+	}
+
+	std::stable_sort(clusterList.begin(), clusterList.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (auto& cluster : clusterList)
+		output.insert(output.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(uint32_t vertexBytes, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices)
+{
+	uint32_t verticesCount = (uint32_t)(vertices.size() / vertexBytes);
+
+	std::vector<uint32_t> remap(verticesCount, UINT32_MAX);
+	uint32_t nextVertex = 0;
+	for (auto& index : indices)
+	{
+		if (remap[index] == UINT32_MAX)
+			remap[index] = nextVertex++;
+		index = remap[index];
+	}
+
+	std::vector<uint8_t> output(nextVertex * vertexBytes);
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		if (remap[i] != UINT32_MAX)
+			memcpy(output.data() + remap[i] * vertexBytes, vertices.data() + i * vertexBytes, vertexBytes);
+	}
+
+	vertices.swap(output);
+}
+
+uint32_t MeshOptimizer::SimulateVertexCache(const std::vector<uint32_t>& indices, uint32_t verticesCount, uint32_t cacheSize)
+{
+	// FIFO: time stamp only refreshes when a vertex enters cache
+	std::vector<uint32_t> cacheTimeStamps(verticesCount, 0);
+	uint32_t timeStamp = cacheSize + 1;
+	uint32_t transformedCount = 0;
+
+	for (auto index : indices)
+	{
+		if (timeStamp - cacheTimeStamps[index] > cacheSize)
+		{
+			cacheTimeStamps[index] = timeStamp++;
+			transformedCount++;
+		}
+	}
+
+	return transformedCount;
+}
\ No newline at end of file
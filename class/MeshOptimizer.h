@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Offline index & vertex reordering for triangle lists with 32 bits indices
+// Vertex cache ordering is "Tipsify" from Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+class MeshOptimizer
+{
+public:
+	static const uint32_t DEFAULT_CACHE_SIZE = 16;
+
+	// ACMR: average cache miss ratio, transformed vertices per triangle, 0.5 is the best case of a regular grid and 3 the worst
+	// ATVR: average transformed vertex ratio, transformed vertices per unique(welded) vertex, 1 is optimal
+	typedef struct _Report
+	{
+		uint32_t	trianglesCount;
+		uint32_t	verticesCountBefore;
+		uint32_t	verticesCountAfter;
+		float		acmrBefore;
+		float		acmrAfter;
+		float		atvrBefore;
+		float		atvrAfter;
+	}Report;
+
+public:
+	// Weld, vertex cache, overdraw and vertex fetch optimization in order, "vertices" and "indices" are modified in place
+	static Report Optimize(uint32_t vertexFormat, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+	// Merge vertices that are binary identical
+	static void WeldVertices(uint32_t vertexBytes, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices);
+
+	// "clusters" receives start triangle of each cluster, a new cluster begins whenever tipsify hits a dead end
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t verticesCount, uint32_t cacheSize, std::vector<uint32_t>& clusters);
+
+	// Sort clusters so that the ones facing away from mesh center go first, position is expected at the beginning of each vertex
+	static void OptimizeOverdraw(const uint8_t* pVertices, uint32_t vertexBytes, std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters);
+
+	// Reorder vertices by the order they're first referenced, unreferenced vertices are removed
+	static void OptimizeVertexFetch(uint32_t vertexBytes, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices);
+
+	// Simulate a FIFO post-transform cache, returns how many vertices are transformed
+	static uint32_t SimulateVertexCache(const std::vector<uint32_t>& indices, uint32_t verticesCount, uint32_t cacheSize);
+};
\ No newline at end of file
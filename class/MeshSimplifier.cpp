@@ -0,0 +1,400 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "../common/Util.h"
+#include "../common/Enums.h"
+#include <algorithm>
+#include <unordered_set>
+#include <cstring>
+#include <cmath>
+
+// Symmetric 4x4 matrix, upper triangle only
+typedef struct _Quadric
+{
+	double a00, a01, a02, a03;
+	double a11, a12, a13;
+	double a22, a23;
+	double a33;
+}Quadric;
+
+typedef struct _Collapse
+{
+	uint32_t	from;
+	uint32_t	to;
+	double		cost;
+}Collapse;
+
+static void AddPlane(Quadric& q, const Vector3d& n, double d)
+{
+	q.a00 += n.x * n.x; q.a01 += n.x * n.y; q.a02 += n.x * n.z; q.a03 += n.x * d;
+	q.a11 += n.y * n.y; q.a12 += n.y * n.z; q.a13 += n.y * d;
+	q.a22 += n.z * n.z; q.a23 += n.z * d;
+	q.a33 += d * d;
+}
+
+static Quadric AddQuadric(const Quadric& q0, const Quadric& q1)
+{
+	return
+	{
+		q0.a00 + q1.a00, q0.a01 + q1.a01, q0.a02 + q1.a02, q0.a03 + q1.a03,
+		q0.a11 + q1.a11, q0.a12 + q1.a12, q0.a13 + q1.a13,
+		q0.a22 + q1.a22, q0.a23 + q1.a23,
+		q0.a33 + q1.a33
+	};
+}
+
+// Sum of squared distances from "p" to all planes accumulated in "q"
+static double EvaluateQuadric(const Quadric& q, const Vector3d& p)
+{
+	double result =
+		q.a00 * p.x * p.x + 2 * q.a01 * p.x * p.y + 2 * q.a02 * p.x * p.z + 2 * q.a03 * p.x +
+		q.a11 * p.y * p.y + 2 * q.a12 * p.y * p.z + 2 * q.a13 * p.y +
+		q.a22 * p.z * p.z + 2 * q.a23 * p.z +
+		q.a33;
+
+	// Rounding could take it slightly below zero
+	return std::max(result, 0.0);
+}
+
+static Vector3d FetchPosition(const uint8_t* pVertices, uint32_t vertexBytes, uint32_t index)
+{
+	const float* pPosition = (const float*)(pVertices + index * vertexBytes);
+	return Vector3d(pPosition[0], pPosition[1], pPosition[2]);
+}
+
+// Map every vertex to the first vertex with the same position
+static void BuildPositionRemap(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes, std::vector<uint32_t>& remap)
+{
+	uint32_t tableSize = 1;
+	while (tableSize < verticesCount * 2)
+		tableSize <<= 1;
+
+	std::vector<uint32_t> table(tableSize, UINT32_MAX);
+	remap.resize(verticesCount);
+
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		const uint8_t* pPosition = pVertices + i * vertexBytes;
+
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (uint32_t j = 0; j < 3 * sizeof(float); j++)
+		{
+			hash ^= pPosition[j];
+			hash *= 16777619u;
+		}
+
+		uint32_t slot = hash & (tableSize - 1);
+		while (table[slot] != UINT32_MAX && memcmp(pVertices + table[slot] * vertexBytes, pPosition, 3 * sizeof(float)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == UINT32_MAX)
+			table[slot] = i;
+
+		remap[i] = table[slot];
+	}
+}
+
+Vector4f MeshSimplifier::ComputeBoundingSphere(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes)
+{
+	if (verticesCount == 0)
+		return Vector4f(0, 0, 0, 0);
+
+	Vector3f minPos, maxPos;
+	ComputeBoundingBox(pVertices, verticesCount, vertexBytes, minPos, maxPos);
+
+	Vector3d center = Vector3d((minPos.x + maxPos.x) * 0.5, (minPos.y + maxPos.y) * 0.5, (minPos.z + maxPos.z) * 0.5);
+	double radius = 0;
+	for (uint32_t i = 0; i < verticesCount; i++)
+		radius = std::max(radius, (FetchPosition(pVertices, vertexBytes, i) - center).SquareLength());
+
+	return Vector4f((float)center.x, (float)center.y, (float)center.z, (float)std::sqrt(radius));
+}
+
+void MeshSimplifier::ComputeBoundingBox(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes, Vector3f& minPos, Vector3f& maxPos)
+{
+	minPos = maxPos = Vector3f(0, 0, 0);
+	if (verticesCount == 0)
+		return;
+
+	Vector3d minPosd = FetchPosition(pVertices, vertexBytes, 0);
+	Vector3d maxPosd = minPosd;
+	for (uint32_t i = 1; i < verticesCount; i++)
+	{
+		Vector3d p = FetchPosition(pVertices, vertexBytes, i);
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			minPosd[j] = std::min(minPosd[j], p[j]);
+			maxPosd[j] = std::max(maxPosd[j], p[j]);
+		}
+	}
+
+	minPos = Vector3f((float)minPosd.x, (float)minPosd.y, (float)minPosd.z);
+	maxPos = Vector3f((float)maxPosd.x, (float)maxPosd.y, (float)maxPosd.z);
+}
+
+float MeshSimplifier::Simplify(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes, const std::vector<uint32_t>& indices, uint32_t targetIndicesCount, float maxError, std::vector<uint32_t>& result)
+{
+	result = indices;
+	if (result.size() <= targetIndicesCount || verticesCount == 0)
+		return 0;
+
+	std::vector<uint32_t> positionRemap;
+	BuildPositionRemap(pVertices, verticesCount, vertexBytes, positionRemap);
+
+	// Vertices sharing position carry different attributes, moving one of them tears the surface apart
+	std::vector<uint8_t> locked(verticesCount, 0);
+	std::vector<uint32_t> wedgeCount(verticesCount, 0);
+	for (uint32_t i = 0; i < verticesCount; i++)
+		wedgeCount[positionRemap[i]]++;
+	for (uint32_t i = 0; i < verticesCount; i++)
+		locked[i] = wedgeCount[positionRemap[i]] > 1;
+
+	// An edge without its opposite half edge is on border, collapsing border vertices shrinks the silhouette
+	std::unordered_set<uint64_t> halfEdges;
+	for (uint32_t i = 0; i < result.size(); i += 3)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t v0 = positionRemap[result[i + j]];
+			uint32_t v1 = positionRemap[result[i + (j + 1) % 3]];
+			halfEdges.insert(((uint64_t)v0 << 32) | v1);
+		}
+	}
+	for (uint32_t i = 0; i < result.size(); i += 3)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t v0 = positionRemap[result[i + j]];
+			uint32_t v1 = positionRemap[result[i + (j + 1) % 3]];
+			if (halfEdges.find(((uint64_t)v1 << 32) | v0) == halfEdges.end())
+				locked[result[i + j]] = locked[result[i + (j + 1) % 3]] = 1;
+		}
+	}
+
+	// Quadrics are accumulated per position
+	std::vector<Quadric> quadrics(verticesCount, Quadric());
+	for (uint32_t i = 0; i < result.size(); i += 3)
+	{
+		Vector3d p0 = FetchPosition(pVertices, vertexBytes, result[i]);
+		Vector3d p1 = FetchPosition(pVertices, vertexBytes, result[i + 1]);
+		Vector3d p2 = FetchPosition(pVertices, vertexBytes, result[i + 2]);
+
+		Vector3d n = (p1 - p0) ^ (p2 - p0);
+		double length = n.Length();
+		if (length == 0)
+			continue;
+
+		n /= length;
+		for (uint32_t j = 0; j < 3; j++)
+			AddPlane(quadrics[positionRemap[result[i + j]]], n, -(n * p0));
+	}
+
+	double maxCost = (double)maxError * maxError;
+	double resultCost = 0;
+
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(verticesCount);
+	std::vector<uint8_t> touched(verticesCount);
+	std::vector<uint32_t> adjacencyOffsets(verticesCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<uint32_t> linkMarks(verticesCount, 0);
+	uint32_t linkStamp = 0;
+
+	while (result.size() > targetIndicesCount)
+	{
+		// Candidates collapse "from" onto "to", "to" stays where it is
+		collapses.clear();
+		for (uint32_t i = 0; i < result.size(); i += 3)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t v0 = result[i + j];
+				uint32_t v1 = result[i + (j + 1) % 3];
+				if (positionRemap[v0] == positionRemap[v1])
+					continue;
+
+				Quadric q = AddQuadric(quadrics[positionRemap[v0]], quadrics[positionRemap[v1]]);
+				if (!locked[v0])
+					collapses.push_back({ v0, v1, EvaluateQuadric(q, FetchPosition(pVertices, vertexBytes, v1)) });
+				if (!locked[v1])
+					collapses.push_back({ v1, v0, EvaluateQuadric(q, FetchPosition(pVertices, vertexBytes, v0)) });
+			}
+		}
+
+		if (collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& c0, const Collapse& c1) { return c0.cost < c1.cost; });
+
+		// Triangles referencing each position
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+			adjacencyOffsets[positionRemap[index] + 1]++;
+		for (uint32_t i = 0; i < verticesCount; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+		adjacency.resize(result.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < result.size(); i++)
+			adjacency[fill[positionRemap[result[i]]]++] = i / 3;
+
+		for (uint32_t i = 0; i < verticesCount; i++)
+			remap[i] = i;
+		std::fill(touched.begin(), touched.end(), 0);
+
+		// Each pass only collapses edges that don't share any neighbourhood, so that flip tests stay valid
+		uint32_t trianglesToRemove = (uint32_t)(result.size() - targetIndicesCount) / 3;
+		uint32_t trianglesRemoved = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.cost > maxCost)
+				break;
+
+			// "from" is never a seam, so its own index is also its position
+			uint32_t from = collapse.from;
+			uint32_t to = collapse.to;
+			uint32_t toPosition = positionRemap[to];
+			if (touched[from] || touched[toPosition])
+				continue;
+
+			// Link condition: an edge shared by more than 2 triangles' worth of neighbours folds the surface onto itself when collapsed
+			linkStamp++;
+			for (uint32_t j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1]; j++)
+				for (uint32_t k = 0; k < 3; k++)
+					linkMarks[positionRemap[result[adjacency[j] * 3 + k]]] = linkStamp;
+
+			linkStamp++;
+			uint32_t sharedNeighbours = 0;
+			for (uint32_t j = adjacencyOffsets[toPosition]; j < adjacencyOffsets[toPosition + 1]; j++)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t neighbour = positionRemap[result[adjacency[j] * 3 + k]];
+					if (neighbour != from && neighbour != toPosition && linkMarks[neighbour] == linkStamp - 1)
+					{
+						sharedNeighbours++;
+						linkMarks[neighbour] = linkStamp;
+					}
+				}
+			}
+
+			if (sharedNeighbours > 2)
+				continue;
+
+			Vector3d target = FetchPosition(pVertices, vertexBytes, to);
+
+			bool flipped = false;
+			uint32_t collapsedCount = 0;
+			for (uint32_t j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1] && !flipped; j++)
+			{
+				const uint32_t* pTriangle = &result[adjacency[j] * 3];
+
+				bool degenerate = false;
+				for (uint32_t k = 0; k < 3; k++)
+					degenerate |= positionRemap[pTriangle[k]] == toPosition;
+
+				if (degenerate)
+				{
+					collapsedCount++;
+					continue;
+				}
+
+				Vector3d p[3], q[3];
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					p[k] = FetchPosition(pVertices, vertexBytes, pTriangle[k]);
+					q[k] = pTriangle[k] == from ? target : p[k];
+				}
+
+				Vector3d n0 = (p[1] - p[0]) ^ (p[2] - p[0]);
+				Vector3d n1 = (q[1] - q[0]) ^ (q[2] - q[0]);
+				// Reject large normal deviation as well, which mostly ends up as slivers
+				flipped = n0 * n1 <= 0.25 * n0.Length() * n1.Length();
+			}
+
+			if (flipped)
+				continue;
+
+			remap[from] = to;
+			quadrics[toPosition] = AddQuadric(quadrics[toPosition], quadrics[from]);
+			resultCost = std::max(resultCost, collapse.cost);
+
+			for (uint32_t j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1]; j++)
+				for (uint32_t k = 0; k < 3; k++)
+					touched[positionRemap[result[adjacency[j] * 3 + k]]] = 1;
+			touched[toPosition] = 1;
+
+			trianglesRemoved += collapsedCount;
+			if (trianglesRemoved >= trianglesToRemove)
+				break;
+		}
+
+		if (trianglesRemoved == 0)
+			break;
+
+		// Apply collapses and drop triangles that no longer have any area
+		uint32_t writeIndex = 0;
+		for (uint32_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t v0 = remap[result[i]];
+			uint32_t v1 = remap[result[i + 1]];
+			uint32_t v2 = remap[result[i + 2]];
+
+			if (positionRemap[v0] == positionRemap[v1] || positionRemap[v1] == positionRemap[v2] || positionRemap[v0] == positionRemap[v2])
+				continue;
+
+			result[writeIndex++] = v0;
+			result[writeIndex++] = v1;
+			result[writeIndex++] = v2;
+		}
+		result.resize(writeIndex);
+	}
+
+	return (float)std::sqrt(resultCost);
+}
+
+MeshSimplifier::LodChain MeshSimplifier::GenerateLods(uint32_t vertexFormat, const std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, uint32_t maxLodCount, float reduction, float maxError)
+{
+	uint32_t vertexBytes = GetVertexBytes(vertexFormat);
+	uint32_t verticesCount = (uint32_t)(vertices.size() / vertexBytes);
+
+	LodChain lodChain = {};
+	lodChain.lods.push_back({ 0, (uint32_t)indices.size(), 0 });
+
+	if ((vertexFormat & (1 << VAFPosition)) == 0 || verticesCount == 0)
+		return lodChain;
+
+	lodChain.boundingSphere = ComputeBoundingSphere(vertices.data(), verticesCount, vertexBytes);
+	ComputeBoundingBox(vertices.data(), verticesCount, vertexBytes, lodChain.boundingBoxMin, lodChain.boundingBoxMax);
+
+	float radius = lodChain.boundingSphere.w;
+	if (radius <= 0)
+		return lodChain;
+
+	// Each LOD is simplified from its predecessor, errors add up along the chain
+	std::vector<uint32_t> lodIndices(indices);
+	std::vector<uint32_t> simplified;
+	std::vector<uint32_t> clusters;
+	for (uint32_t i = 1; i < maxLodCount; i++)
+	{
+		uint32_t trianglesCount = (uint32_t)lodIndices.size() / 3;
+		float errorBudget = maxError - lodChain.lods.back().error;
+		if (trianglesCount < MIN_LOD_TRIANGLES_COUNT || errorBudget <= 0)
+			break;
+
+		uint32_t targetIndicesCount = (uint32_t)(trianglesCount * reduction) * 3;
+		float error = Simplify(vertices.data(), verticesCount, vertexBytes, lodIndices, targetIndicesCount, errorBudget * radius, simplified);
+
+		// Not worth a LOD if it barely saves anything
+		if (simplified.size() == 0 || simplified.size() > lodIndices.size() * (1.0f + reduction) * 0.5f)
+			break;
+
+		MeshOptimizer::OptimizeVertexCache(simplified, verticesCount, MeshOptimizer::DEFAULT_CACHE_SIZE, clusters);
+
+		lodChain.lods.push_back({ (uint32_t)indices.size(), (uint32_t)simplified.size(), lodChain.lods.back().error + error / radius });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		lodIndices.swap(simplified);
+	}
+
+	return lodChain;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "../Maths/Vector.h"
+
+// Offline LOD generation for triangle lists with 32 bits indices
+// Edge collapse driven by quadric error metric, Garland & Heckbert "Surface Simplification Using Quadric Error Metrics"
+// Vertices are never moved or created, a collapse snaps one vertex onto a neighbour, so every LOD shares the vertex data of the full detail mesh
+class MeshSimplifier
+{
+public:
+	static const uint32_t MAX_LOD_COUNT = 4;
+	static const uint32_t MIN_LOD_TRIANGLES_COUNT = 64;
+
+	typedef struct _Lod
+	{
+		uint32_t	firstIndex;
+		uint32_t	indicesCount;
+		float		error;			// Geometric deviation from full detail mesh, relative to bounding sphere radius
+	}Lod;
+
+	typedef struct _LodChain
+	{
+		Vector4f			boundingSphere;	// xyz: center, w: radius, in mesh space
+		Vector3f			boundingBoxMin;	// Axis aligned bounding box in mesh space, its center is bounding sphere center
+		Vector3f			boundingBoxMax;
+		std::vector<Lod>	lods;			// Lod 0 is always the full detail mesh
+	}LodChain;
+
+public:
+	// Simplified indices of each LOD are appended to "indices", every LOD aims at "reduction" of triangles of its predecessor
+	// Chain stops early once a LOD can't get rid of enough triangles, or its error goes beyond "maxError"
+	static LodChain GenerateLods(uint32_t vertexFormat, const std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, uint32_t maxLodCount = MAX_LOD_COUNT, float reduction = 0.5f, float maxError = 0.25f);
+
+	// Collapse edges until "targetIndicesCount" is reached or no collapse stays within "maxError", returns absolute error of the result
+	// Border vertices and vertices sharing position with others (attribute seams) are locked
+	static float Simplify(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes, const std::vector<uint32_t>& indices, uint32_t targetIndicesCount, float maxError, std::vector<uint32_t>& result);
+
+	// Center of bounding box and the farthest vertex from it, position is expected at the beginning of each vertex
+	static Vector4f ComputeBoundingSphere(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes);
+
+	// Axis aligned bounding box, position is expected at the beginning of each vertex
+	static void ComputeBoundingBox(const uint8_t* pVertices, uint32_t verticesCount, uint32_t vertexBytes, Vector3f& minPos, Vector3f& maxPos);
+};
\ No newline at end of file
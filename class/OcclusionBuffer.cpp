@@ -0,0 +1,314 @@
+#include "OcclusionBuffer.h"
+#include "../common/Macros.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+const uint32_t OcclusionBuffer::DEFAULT_WIDTH;
+const uint32_t OcclusionBuffer::DEFAULT_HEIGHT;
+const uint32_t OcclusionBuffer::BAND_HEIGHT;
+const uint32_t OcclusionBuffer::MAX_TEST_TEXELS;
+const double OcclusionBuffer::DEPTH_TEST_BIAS = 1e-4;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+	: m_width(width), m_height(height)
+{
+	ASSERTION(width % 4 == 0 && height % BAND_HEIGHT == 0);
+	ASSERTION((width & (width - 1)) == 0 && (height & (height - 1)) == 0);
+
+	for (uint32_t level = 0; (width >> level) > 0 && (height >> level) > 0; level++)
+		m_levels.push_back(std::vector<float>((width >> level) * (height >> level), 0.0f));
+
+	m_bandTriangles.resize(GetBandCount());
+}
+
+std::shared_ptr<OcclusionBuffer::Occluder> OcclusionBuffer::CreateOccluder(const void* pVertices, uint32_t verticesCount, uint32_t vertexBytes, const uint32_t* pIndices, uint32_t indicesCount)
+{
+	std::shared_ptr<Occluder> pOccluder = std::make_shared<Occluder>();
+
+	pOccluder->positions.resize(verticesCount);
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		float xyz[3];
+		std::memcpy(xyz, (const uint8_t*)pVertices + i * vertexBytes, sizeof(xyz));
+		pOccluder->positions[i] = Vector3f(xyz[0], xyz[1], xyz[2]);
+	}
+
+	pOccluder->indices.assign(pIndices, pIndices + indicesCount);
+	return pOccluder;
+}
+
+void OcclusionBuffer::SetView(const Matrix4d& cameraTransform, const Matrix4d& projection)
+{
+	m_head = cameraTransform.TranslationVector();
+
+	Matrix4d view = cameraTransform;
+	view.c30 = 0;
+	view.c31 = 0;
+	view.c32 = 0;
+	view.Inverse();
+
+	m_viewProjection = projection * view;
+
+	m_triangles.clear();
+	for (auto& bandTriangles : m_bandTriangles)
+		bandTriangles.clear();
+}
+
+void OcclusionBuffer::AddOccluder(const Occluder& occluder, const Matrix4d& worldTransform)
+{
+	Matrix4d relativeWorld = worldTransform;
+	relativeWorld.c30 -= m_head.x;
+	relativeWorld.c31 -= m_head.y;
+	relativeWorld.c32 -= m_head.z;
+
+	Matrix4f transform = (m_viewProjection * relativeWorld).SinglePrecision();
+
+	m_clipVertices.resize(occluder.positions.size());
+	for (uint32_t i = 0; i < (uint32_t)occluder.positions.size(); i++)
+		m_clipVertices[i] = transform * Vector4f(occluder.positions[i], 1.0f);
+
+	for (uint32_t i = 0; i + 2 < (uint32_t)occluder.indices.size(); i += 3)
+	{
+		const Vector4f* pVertices[3] = { &m_clipVertices[occluder.indices[i]], &m_clipVertices[occluder.indices[i + 1]], &m_clipVertices[occluder.indices[i + 2]] };
+
+		// Near plane of a reverse depth projection is "z == w", anything nearer has "z > w"
+		float distances[3];
+		uint32_t insideCount = 0;
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			distances[j] = pVertices[j]->w - pVertices[j]->z;
+			insideCount += distances[j] >= 0 ? 1 : 0;
+		}
+
+		if (insideCount == 0)
+			continue;
+
+		if (insideCount == 3)
+		{
+			SetupTriangle(*pVertices[0], *pVertices[1], *pVertices[2]);
+			continue;
+		}
+
+		// Clipping a triangle against one plane leaves 3 or 4 vertices
+		Vector4f polygon[4];
+		uint32_t count = 0;
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t k = (j + 1) % 3;
+			if (distances[j] >= 0)
+				polygon[count++] = *pVertices[j];
+
+			if ((distances[j] >= 0) != (distances[k] >= 0))
+				polygon[count++] = *pVertices[j] + (*pVertices[k] - *pVertices[j]) * (distances[j] / (distances[j] - distances[k]));
+		}
+
+		for (uint32_t j = 1; j + 1 < count; j++)
+			SetupTriangle(polygon[0], polygon[j], polygon[j + 1]);
+	}
+}
+
+void OcclusionBuffer::SetupTriangle(const Vector4f& clip0, const Vector4f& clip1, const Vector4f& clip2)
+{
+	const Vector4f* pClips[3] = { &clip0, &clip1, &clip2 };
+
+	float x[3], y[3], z[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (pClips[i]->w <= 0)
+			return;
+
+		float invW = 1.0f / pClips[i]->w;
+		x[i] = (pClips[i]->x * invW * 0.5f + 0.5f) * m_width;
+		y[i] = (pClips[i]->y * invW * 0.5f + 0.5f) * m_height;
+		z[i] = pClips[i]->z * invW;
+	}
+
+	// Both faces occlude, so a clockwise triangle is turned into a counter clockwise one rather than dropped
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!std::isfinite(area) || area == 0)
+		return;
+
+	if (area < 0)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	// Pixel "(x, y)" is sampled at its center "(x + 0.5, y + 0.5)"
+	float minX = std::ceil(std::max(std::min({ x[0], x[1], x[2] }) - 0.5f, 0.0f));
+	float maxX = std::floor(std::min(std::max({ x[0], x[1], x[2] }) - 0.5f, (float)m_width - 1));
+	float minY = std::ceil(std::max(std::min({ y[0], y[1], y[2] }) - 0.5f, 0.0f));
+	float maxY = std::floor(std::min(std::max({ y[0], y[1], y[2] }) - 0.5f, (float)m_height - 1));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	Triangle triangle;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		uint32_t j = (i + 1) % 3;
+		triangle.edgeA[i] = y[i] - y[j];
+		triangle.edgeB[i] = x[j] - x[i];
+		triangle.edgeC[i] = -(triangle.edgeA[i] * x[i] + triangle.edgeB[i] * y[i]) + 0.5f * (triangle.edgeA[i] + triangle.edgeB[i]);
+	}
+
+	// Depth after projection is linear in screen space
+	triangle.depthDx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	triangle.depthDy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	triangle.depth = z[0] - triangle.depthDx * x[0] - triangle.depthDy * y[0] + 0.5f * (triangle.depthDx + triangle.depthDy);
+
+	// Plane equation could overshoot at pixels outside vertices, an occluder must never get nearer than it is
+	triangle.maxDepth = std::max({ z[0], z[1], z[2] });
+
+	triangle.minX = (int32_t)minX;
+	triangle.maxX = (int32_t)maxX;
+	triangle.minY = (int32_t)minY;
+	triangle.maxY = (int32_t)maxY;
+
+	uint32_t index = (uint32_t)m_triangles.size();
+	m_triangles.push_back(triangle);
+
+	for (uint32_t band = triangle.minY / BAND_HEIGHT; band <= triangle.maxY / BAND_HEIGHT; band++)
+		m_bandTriangles[band].push_back(index);
+}
+
+void OcclusionBuffer::RasterizeBand(uint32_t band)
+{
+	int32_t bandMinY = band * BAND_HEIGHT;
+	int32_t bandMaxY = bandMinY + BAND_HEIGHT - 1;
+
+	std::vector<float>& depthBuffer = m_levels[0];
+	std::fill(depthBuffer.begin() + bandMinY * m_width, depthBuffer.begin() + (bandMaxY + 1) * m_width, 0.0f);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_setr_ps(0, 1, 2, 3);
+
+	for (uint32_t index : m_bandTriangles[band])
+	{
+		const Triangle& triangle = m_triangles[index];
+
+		__m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]);
+		__m128 edgeA1 = _mm_set1_ps(triangle.edgeA[1]);
+		__m128 edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+		__m128 depthDx = _mm_set1_ps(triangle.depthDx);
+		__m128 maxDepth = _mm_set1_ps(triangle.maxDepth);
+
+		// 4 pixels a time, starting from an aligned column, width is a multiple of 4 so the last group never runs out of row
+		int32_t minX = triangle.minX & ~3;
+		int32_t minY = std::max(triangle.minY, bandMinY);
+		int32_t maxY = std::min(triangle.maxY, bandMaxY);
+
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			float* pRow = &depthBuffer[y * m_width];
+
+			__m128 rowEdge0 = _mm_set1_ps(triangle.edgeB[0] * y + triangle.edgeC[0]);
+			__m128 rowEdge1 = _mm_set1_ps(triangle.edgeB[1] * y + triangle.edgeC[1]);
+			__m128 rowEdge2 = _mm_set1_ps(triangle.edgeB[2] * y + triangle.edgeC[2]);
+			__m128 rowDepth = _mm_set1_ps(triangle.depthDy * y + triangle.depth);
+
+			for (int32_t x = minX; x <= triangle.maxX; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, pixelX), rowEdge0), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, pixelX), rowEdge1), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, pixelX), rowEdge2), zero));
+
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depthDx, pixelX), rowDepth), maxDepth);
+				__m128 current = _mm_loadu_ps(pRow + x);
+				__m128 nearer = _mm_max_ps(current, depth);
+				_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::BuildHierarchy()
+{
+	for (uint32_t level = 1; level < (uint32_t)m_levels.size(); level++)
+	{
+		const std::vector<float>& source = m_levels[level - 1];
+		std::vector<float>& destination = m_levels[level];
+
+		uint32_t sourceWidth = m_width >> (level - 1);
+		uint32_t width = m_width >> level;
+		uint32_t height = m_height >> level;
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			const float* pRow0 = &source[(y * 2) * sourceWidth];
+			const float* pRow1 = pRow0 + sourceWidth;
+			for (uint32_t x = 0; x < width; x++)
+				destination[y * width + x] = std::min(std::min(pRow0[x * 2], pRow0[x * 2 + 1]), std::min(pRow1[x * 2], pRow1[x * 2 + 1]));
+		}
+	}
+}
+
+bool OcclusionBuffer::TestBox(const Vector3d& center, const Vector3d& extents) const
+{
+	Vector3d relativeCenter = center - m_head;
+
+	double minX = std::numeric_limits<double>::max();
+	double minY = std::numeric_limits<double>::max();
+	double maxX = -std::numeric_limits<double>::max();
+	double maxY = -std::numeric_limits<double>::max();
+	double nearestDepth = 0;
+
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		Vector3d corner = relativeCenter + Vector3d((i & 1) ? extents.x : -extents.x, (i & 2) ? extents.y : -extents.y, (i & 4) ? extents.z : -extents.z);
+		Vector4d clip = m_viewProjection * Vector4d(corner, 1.0);
+
+		// Box reaches near plane, it can't be behind anything
+		if (clip.z > clip.w || clip.w <= 0)
+			return true;
+
+		double invW = 1.0 / clip.w;
+		double x = (clip.x * invW * 0.5 + 0.5) * m_width;
+		double y = (clip.y * invW * 0.5 + 0.5) * m_height;
+
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestDepth = std::max(nearestDepth, clip.z * invW);
+	}
+
+	nearestDepth *= 1.0 + DEPTH_TEST_BIAS;
+
+	// Out of screen, frustum culling decides
+	if (maxX < 0 || maxY < 0 || minX >= m_width || minY >= m_height)
+		return true;
+
+	// Every pixel box touches, not only those whose center it covers
+	uint32_t x0 = (uint32_t)std::max(minX, 0.0);
+	uint32_t y0 = (uint32_t)std::max(minY, 0.0);
+	uint32_t x1 = (uint32_t)std::min(maxX, (double)m_width - 1);
+	uint32_t y1 = (uint32_t)std::min(maxY, (double)m_height - 1);
+
+	uint32_t level = 0;
+	while (level + 1 < (uint32_t)m_levels.size() && ((x1 >> level) - (x0 >> level) >= MAX_TEST_TEXELS || (y1 >> level) - (y0 >> level) >= MAX_TEST_TEXELS))
+		level++;
+
+	const std::vector<float>& texels = m_levels[level];
+	uint32_t width = m_width >> level;
+
+	for (uint32_t y = y0 >> level; y <= (y1 >> level); y++)
+	{
+		for (uint32_t x = x0 >> level; x <= (x1 >> level); x++)
+		{
+			if (nearestDepth >= texels[y * width + x])
+				return true;
+		}
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+#include "../Maths/Vector.h"
+#include "../Maths/Matrix.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Low resolution depth buffer occluders are rasterized into on CPU, and a min depth hierarchy over it that occludees are tested against
+// Screen is split into horizontal bands, triangles are binned to bands they touch, so that bands could be rasterized on different threads
+// Depth is post projection z of a reverse depth projection, like "PhysicalCamera" builds: greater is nearer, 0 means nothing was drawn
+// Everything is relative to camera position, so that single precision holds far away from world origin, no dependency on renderer
+class OcclusionBuffer
+{
+public:
+	static const uint32_t DEFAULT_WIDTH = 256;
+	static const uint32_t DEFAULT_HEIGHT = 128;
+	static const uint32_t BAND_HEIGHT = 16;
+
+	// Simplified geometry of an occluder in object space, it must not stick out of what's actually drawn
+	typedef struct _Occluder
+	{
+		std::vector<Vector3f>	positions;
+		std::vector<uint32_t>	indices;
+	}Occluder;
+
+public:
+	// Width has to be a multiple of 4 and height a multiple of "BAND_HEIGHT", both powers of 2
+	OcclusionBuffer(uint32_t width = DEFAULT_WIDTH, uint32_t height = DEFAULT_HEIGHT);
+
+	// Position is taken from "pVertices" with a stride of "vertexBytes", and is expected to be the first attribute
+	static std::shared_ptr<Occluder> CreateOccluder(const void* pVertices, uint32_t verticesCount, uint32_t vertexBytes, const uint32_t* pIndices, uint32_t indicesCount);
+
+	// Drops occluders of last frame, has to be called before adding new ones
+	void SetView(const Matrix4d& cameraTransform, const Matrix4d& projection);
+
+	// Transform, clip against near plane and bin triangles of an occluder, both faces of a triangle occlude
+	void AddOccluder(const Occluder& occluder, const Matrix4d& worldTransform);
+
+	// Bands could be rasterized in any order and at the same time, "BuildHierarchy" has to wait for all of them
+	uint32_t GetBandCount() const { return m_height / BAND_HEIGHT; }
+	void RasterizeBand(uint32_t band);
+	void BuildHierarchy();
+
+	// False only if world space box is completely behind occluders, a box crossing near plane or out of screen is always visible
+	bool TestBox(const Vector3d& center, const Vector3d& extents) const;
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	uint32_t GetTrianglesCount() const { return (uint32_t)m_triangles.size(); }
+	float GetDepth(uint32_t x, uint32_t y) const { return m_levels[0][y * m_width + x]; }
+
+protected:
+	// A texel of the level a box is tested at covers this many pixels or more, so a test reads at most 4 by 4 texels
+	static const uint32_t MAX_TEST_TEXELS = 4;
+
+	// Relative depth an occludee is pulled towards camera by, so that an occluder doesn't hide itself through rounding
+	static const double DEPTH_TEST_BIAS;
+
+	// Half space setup of a screen space triangle, edge functions and depth are offset to sample pixel centers with integer coordinates
+	typedef struct _Triangle
+	{
+		float		edgeA[3];
+		float		edgeB[3];
+		float		edgeC[3];		// Edge "i" is "A * x + B * y + C", non negative inside
+		float		depth;			// Depth is "depth + depthDx * x + depthDy * y", clamped to nearest vertex depth
+		float		depthDx;
+		float		depthDy;
+		float		maxDepth;
+		int32_t		minX;
+		int32_t		minY;
+		int32_t		maxX;
+		int32_t		maxY;
+	}Triangle;
+
+	void SetupTriangle(const Vector4f& clip0, const Vector4f& clip1, const Vector4f& clip2);
+
+protected:
+	uint32_t							m_width;
+	uint32_t							m_height;
+
+	Vector3d							m_head;
+	Matrix4d							m_viewProjection;	// Camera relative
+
+	std::vector<Triangle>				m_triangles;
+	std::vector<std::vector<uint32_t>>	m_bandTriangles;
+	std::vector<Vector4f>				m_clipVertices;
+
+	// Level 0 is the depth buffer, each texel of the next level keeps the farthest of 2 by 2 texels below
+	std::vector<std::vector<float>>		m_levels;
+};
\ No newline at end of file
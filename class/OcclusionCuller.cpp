@@ -0,0 +1,68 @@
+#include "OcclusionCuller.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include <chrono>
+
+// Rasterize occluder bands on worker threads, turn off to rasterize them all on main thread for comparison
+bool PARALLEL_OCCLUSION_RASTERIZATION = true;
+
+void OcclusionCuller::SetView(const Matrix4d& cameraTransform, const Matrix4d& projection)
+{
+	m_occlusionBuffer.SetView(cameraTransform, projection);
+	m_hasOccluders = false;
+}
+
+void OcclusionCuller::SubmitOccluder(const OcclusionBuffer::Occluder& occluder, const Matrix4d& worldTransform)
+{
+	m_occlusionBuffer.AddOccluder(occluder, worldTransform);
+	m_hasOccluders = true;
+}
+
+void OcclusionCuller::Cull(const std::vector<Occludee>& occludees, std::vector<uint8_t>& visible)
+{
+	visible.assign(occludees.size(), 1);
+	m_lastCullStatistics = {};
+
+	if (!m_hasOccluders || occludees.size() == 0)
+		return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Bands write disjoint rows of depth buffer, nothing to synchronize but the end
+	for (uint32_t band = 0; band < m_occlusionBuffer.GetBandCount(); band++)
+	{
+		auto job = [this, band](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+		{
+			m_occlusionBuffer.RasterizeBand(band);
+		};
+
+		if (PARALLEL_OCCLUSION_RASTERIZATION)
+			FrameMgr()->AddJobToFrame(job);
+		else
+			job(nullptr);
+	}
+
+	if (PARALLEL_OCCLUSION_RASTERIZATION)
+		GlobalThreadTaskQueue()->WaitForFree();
+
+	m_occlusionBuffer.BuildHierarchy();
+
+	auto rasterEnd = std::chrono::high_resolution_clock::now();
+	m_lastCullStatistics.rasterTime = std::chrono::duration<double, std::milli>(rasterEnd - start).count();
+
+	for (uint32_t i = 0; i < (uint32_t)occludees.size(); i++)
+	{
+		if (m_occlusionBuffer.TestBox(occludees[i].center, occludees[i].extents))
+			continue;
+
+		visible[i] = 0;
+		m_lastCullStatistics.occludedCount++;
+	}
+
+	m_lastCullStatistics.testTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - rasterEnd).count();
+	m_lastCullStatistics.testedCount = (uint32_t)occludees.size();
+	m_lastCullStatistics.occluderTrianglesCount = m_occlusionBuffer.GetTrianglesCount();
+
+	m_hasOccluders = false;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "OcclusionBuffer.h"
+#include <vector>
+
+// Frame wide occlusion pass of main camera, between frustum culling and render queue insertion
+// Renderers marked as occluders submit their occluder geometry while scene is traversed, "Cull" rasterizes it band by band
+// on worker threads, then tests whatever survived frustum culling against the depth hierarchy
+class OcclusionCuller : public Singleton<OcclusionCuller>
+{
+public:
+	typedef struct _Occludee
+	{
+		Vector3d	center;		// World space bounding box
+		Vector3d	extents;
+	}Occludee;
+
+	typedef struct _Statistics
+	{
+		uint32_t	occluderTrianglesCount;		// After near plane clipping and screen rejection
+		uint32_t	testedCount;
+		uint32_t	occludedCount;
+		double		rasterTime;					// Milliseconds
+		double		testTime;					// Milliseconds
+	}Statistics;
+
+public:
+	void SetView(const Matrix4d& cameraTransform, const Matrix4d& projection);
+
+	// Occluder is used right away, it doesn't have to outlive this call
+	void SubmitOccluder(const OcclusionBuffer::Occluder& occluder, const Matrix4d& worldTransform);
+
+	// One result per occludee, 0 for occluded ones, occluders of this frame are dropped afterwards
+	void Cull(const std::vector<Occludee>& occludees, std::vector<uint8_t>& visible);
+
+	const Statistics& GetLastCullStatistics() const { return m_lastCullStatistics; }
+
+protected:
+	OcclusionBuffer		m_occlusionBuffer;
+	bool				m_hasOccluders = false;
+	Statistics			m_lastCullStatistics = {};
+};
\ No newline at end of file
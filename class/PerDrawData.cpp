@@ -0,0 +1,142 @@
+#include "PerDrawData.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const std::wstring PUSH_SUFFIX = L"_push.vert.spv";
+static const std::wstring VERTEX_SUFFIX = L".vert.spv";
+
+// Same layout as "VkDrawIndexedIndirectCommand", so that benchmark builds without Vulkan headers
+typedef struct _DrawIndexedCommand
+{
+	uint32_t	indexCount;
+	uint32_t	instanceCount;
+	uint32_t	firstIndex;
+	int32_t		vertexOffset;
+	uint32_t	firstInstance;
+}DrawIndexedCommand;
+
+static bool EndsWith(const std::wstring& str, const std::wstring& suffix)
+{
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+uint32_t PerDrawData::AcquireAlignment(PerDrawDataStrategy strategy, uint32_t minOffsetAlignment)
+{
+	// Only dynamic offsets have to land on device alignment, others index variables directly
+	if (strategy != PerDrawData_DynamicOffset)
+		return 1;
+
+	uint32_t elementSize = (uint32_t)sizeof(PerMaterialIndirectVariables);
+	return std::max(1u, (minOffsetAlignment + elementSize - 1) / elementSize);
+}
+
+uint32_t PerDrawData::AppendIndirectVariables(std::vector<PerMaterialIndirectVariables>& variables, const PerMaterialIndirectVariables* pIndirectVariables, uint32_t count, uint32_t alignment)
+{
+	uint32_t offset = ((uint32_t)variables.size() + alignment - 1) / alignment * alignment;
+	variables.resize(offset);
+	variables.insert(variables.end(), pIndirectVariables, pIndirectVariables + count);
+	return offset;
+}
+
+std::wstring PerDrawData::AcquirePushVariantPath(const std::wstring& vertexShaderPath)
+{
+	if (EndsWith(vertexShaderPath, PUSH_SUFFIX))
+		return vertexShaderPath;
+
+	if (!EndsWith(vertexShaderPath, VERTEX_SUFFIX))
+		return L"";
+
+	return vertexShaderPath.substr(0, vertexShaderPath.size() - VERTEX_SUFFIX.size()) + PUSH_SUFFIX;
+}
+
+PerDrawDataStrategy PerDrawData::ResolveStrategy(PerDrawDataStrategy strategy, bool hasPushVariant)
+{
+	if (strategy == PerDrawData_PushConstants && !hasPushVariant)
+		return PerDrawData_DynamicOffset;
+
+	return strategy;
+}
+
+PerDrawData::BenchmarkResult PerDrawData::Benchmark(uint32_t drawsCount, uint32_t instancesPerDraw, uint32_t minOffsetAlignment, uint32_t iterations)
+{
+	BenchmarkResult benchmark = {};
+
+	std::vector<PerMaterialIndirectVariables> drawVariables(instancesPerDraw);
+	for (uint32_t i = 0; i < instancesPerDraw; i++)
+		drawVariables[i] = { i, i, i, i };
+
+	DrawIndexedCommand drawCmd = { 36, instancesPerDraw, 0, 0, 0 };
+
+	// Same scratch a material keeps from frame to frame, plus a stand-in for mapped memory and command stream
+	std::vector<DrawIndexedCommand> cmds;
+	std::vector<uint32_t> indirectOffsets;
+	std::vector<PerMaterialIndirectVariables> variables;
+	std::vector<uint32_t> dynamicOffsets(4);
+	std::vector<uint8_t> mappedMemory;
+	std::vector<uint32_t> cmdStream;
+
+	for (uint32_t i = 0; i < PerDrawDataStrategyCount; i++)
+	{
+		PerDrawDataStrategy strategy = (PerDrawDataStrategy)i;
+		uint32_t alignment = AcquireAlignment(strategy, minOffsetAlignment);
+		uint32_t uploadBytes = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t iteration = 0; iteration < iterations; iteration++)
+		{
+			cmds.clear();
+			indirectOffsets.clear();
+			variables.clear();
+			cmdStream.clear();
+
+			// Render queue flush
+			for (uint32_t j = 0; j < drawsCount; j++)
+			{
+				cmds.push_back(drawCmd);
+				indirectOffsets.push_back(AppendIndirectVariables(variables, drawVariables.data(), instancesPerDraw, alignment));
+			}
+
+			// Sync to host visible buffers
+			uploadBytes = (uint32_t)(variables.size() * sizeof(PerMaterialIndirectVariables));
+			if (strategy == PerDrawData_IndirectBuffer)
+				uploadBytes += drawsCount * (uint32_t)(sizeof(DrawIndexedCommand) + sizeof(IndirectOffset)) + sizeof(uint32_t);
+
+			mappedMemory.resize(uploadBytes);
+			uint32_t offset = 0;
+			if (strategy == PerDrawData_IndirectBuffer)
+			{
+				memcpy(&mappedMemory[offset], cmds.data(), cmds.size() * sizeof(DrawIndexedCommand));
+				offset += (uint32_t)(cmds.size() * sizeof(DrawIndexedCommand));
+				memcpy(&mappedMemory[offset], indirectOffsets.data(), indirectOffsets.size() * sizeof(uint32_t));
+				offset += (uint32_t)(indirectOffsets.size() * sizeof(uint32_t));
+				memcpy(&mappedMemory[offset], &drawsCount, sizeof(uint32_t));
+				offset += sizeof(uint32_t);
+			}
+			memcpy(&mappedMemory[offset], variables.data(), variables.size() * sizeof(PerMaterialIndirectVariables));
+
+			// Arguments of commands recorded per draw
+			for (uint32_t j = 0; strategy != PerDrawData_IndirectBuffer && j < drawsCount; j++)
+			{
+				if (strategy == PerDrawData_DynamicOffset)
+				{
+					dynamicOffsets.back() = AcquireDynamicOffset(0, indirectOffsets[j]);
+					cmdStream.insert(cmdStream.end(), dynamicOffsets.begin(), dynamicOffsets.end());
+				}
+				else
+					cmdStream.push_back(indirectOffsets[j]);
+
+				const uint32_t* pCmd = (const uint32_t*)&cmds[j];
+				cmdStream.insert(cmdStream.end(), pCmd, pCmd + sizeof(DrawIndexedCommand) / sizeof(uint32_t));
+			}
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		benchmark.cpuTime[strategy] = std::chrono::duration<double, std::micro>(end - start).count() / std::max(1u, iterations);
+		benchmark.uploadBytes[strategy] = uploadBytes;
+		benchmark.drawCommands[strategy] = strategy == PerDrawData_IndirectBuffer ? 1 : drawsCount * 2;
+	}
+
+	return benchmark;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include "PerMaterialIndirectVariables.h"
+#include <string>
+#include <vector>
+
+// How a draw finds its "PerMaterialIndirectVariables", chosen at material creation
+// Direct strategies bake this frame's draws into command buffer, so they need command buffers recorded every frame ("PREBAKE_CB" off)
+enum PerDrawDataStrategy
+{
+	// One indirect count draw per material, shader reads offset of each draw from "PerMaterialIndirectOffset[gl_DrawID]"
+	// Per draw cost is on GPU only, suits materials with many draws
+	PerDrawData_IndirectBuffer,
+
+	// One direct draw per item, each rebinds material descriptor set with indirect variables buffer offset to its own variables
+	// No indirect command or offset upload, but each draw's variables start on an aligned boundary
+	PerDrawData_DynamicOffset,
+
+	// One direct draw per item, each pushes offset of its own variables
+	// Vertex shader is swapped for its "PER_DRAW_PUSH_CONSTANTS" variant ("*_push.vert.spv"), material falls back to
+	// "PerDrawData_DynamicOffset" if that isn't compiled
+	PerDrawData_PushConstants,
+
+	PerDrawDataStrategyCount
+};
+
+// CPU side of per draw data strategies: where each draw's variables go and what it's bound with, no dependency on renderer
+class PerDrawData
+{
+public:
+	// CPU cost of preparing one frame of per draw data for the same synthetic draws, under each strategy
+	// Driver cost of recorded commands isn't included, "drawCommands" tells how many of them each strategy records
+	typedef struct _BenchmarkResult
+	{
+		double		cpuTime[PerDrawDataStrategyCount];		// Microseconds per frame
+		uint32_t	uploadBytes[PerDrawDataStrategyCount];	// Written to host visible buffers per frame
+		uint32_t	drawCommands[PerDrawDataStrategyCount];
+	}BenchmarkResult;
+
+public:
+	// Elements each draw's variables are aligned to, "minOffsetAlignment" is device's minimum storage buffer offset alignment in bytes
+	static uint32_t AcquireAlignment(PerDrawDataStrategy strategy, uint32_t minOffsetAlignment);
+
+	// Append variables of one draw starting on a multiple of "alignment" elements, returns index of the first one
+	static uint32_t AppendIndirectVariables(std::vector<PerMaterialIndirectVariables>& variables, const PerMaterialIndirectVariables* pIndirectVariables, uint32_t count, uint32_t alignment);
+
+	// Dynamic offset in bytes that binds indirect variables buffer at a draw's first variable, for "PerDrawData_DynamicOffset"
+	static uint32_t AcquireDynamicOffset(uint32_t frameOffset, uint32_t indirectOffset) { return frameOffset + indirectOffset * (uint32_t)sizeof(PerMaterialIndirectVariables); }
+
+	// "*_push.vert.spv" counterpart of a vertex shader binary, the path itself if it's a push variant already, empty if it's no vertex shader binary
+	static std::wstring AcquirePushVariantPath(const std::wstring& vertexShaderPath);
+
+	// Strategy a material really uses, push constants need push variant of vertex shader
+	static PerDrawDataStrategy ResolveStrategy(PerDrawDataStrategy strategy, bool hasPushVariant);
+
+	// "minOffsetAlignment" is device's minimum storage buffer offset alignment in bytes
+	static BenchmarkResult Benchmark(uint32_t drawsCount, uint32_t instancesPerDraw, uint32_t minOffsetAlignment, uint32_t iterations);
+};
\ No newline at end of file
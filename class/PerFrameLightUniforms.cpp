@@ -0,0 +1,75 @@
+#include "PerFrameLightUniforms.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/ShaderStorageBuffer.h"
+#include "Material.h"
+#include <algorithm>
+#include <cstring>
+
+const uint32_t PerFrameLightUniforms::MAX_LIGHTS;
+const uint32_t PerFrameLightUniforms::MAX_LIGHT_INDICES;
+
+bool PerFrameLightUniforms::Init(const std::shared_ptr<PerFrameLightUniforms>& pSelf)
+{
+	memset(&m_lightClusterData, 0, sizeof(m_lightClusterData));
+
+	if (!UniformDataStorage::Init(pSelf, sizeof(m_lightClusterData), PerFrameDataStorage::ShaderStorage))
+		return false;
+
+	// Every frame starts with empty cluster lists rather than whatever buffer memory holds
+	SetDirty();
+	return true;
+}
+
+std::shared_ptr<PerFrameLightUniforms> PerFrameLightUniforms::Create()
+{
+	std::shared_ptr<PerFrameLightUniforms> pPerFrameLightUniforms = std::make_shared<PerFrameLightUniforms>();
+	if (pPerFrameLightUniforms.get() && pPerFrameLightUniforms->Init(pPerFrameLightUniforms))
+		return pPerFrameLightUniforms;
+	return nullptr;
+}
+
+void PerFrameLightUniforms::SetLights(const LightData* pLights, uint32_t count)
+{
+	m_lightsCount = std::min(count, MAX_LIGHTS);
+	if (m_lightsCount != 0)
+		memcpy(m_lightClusterData.lights, pLights, m_lightsCount * sizeof(LightData));
+
+	m_lightClusterData.clusterSettings.z = (float)m_lightsCount;
+	SetDirty();
+}
+
+uint32_t PerFrameLightUniforms::SetClusters(LightClusterGrid& grid)
+{
+	Vector2d sliceParameters = grid.GetSliceParameters();
+	m_lightClusterData.clusterSettings.x = (float)sliceParameters.x;
+	m_lightClusterData.clusterSettings.y = (float)sliceParameters.y;
+
+	m_lightIndicesCount = grid.Compact(m_lightClusterData.clusterLightRanges, m_lightClusterData.lightIndices, MAX_LIGHT_INDICES);
+	SetDirty();
+
+	return m_lightIndicesCount;
+}
+
+std::vector<UniformVarList> PerFrameLightUniforms::PrepareUniformVarList() const
+{
+	return
+	{
+		{
+			DynamicShaderStorageBuffer,
+			"PerFrameLightUniforms",
+			{
+				{ Vec4Unit, "Cluster settings, x: near depth, y: slices per log depth, z: light count" },
+				{ Vec2Unit, "Cluster light list offset and count", 0, LightClusterGrid::CLUSTER_COUNT },
+				{ Mat4Unit, "Light position range, color type, direction, spot scale offset", 0, MAX_LIGHTS },
+				{ OneUnit, "Cluster light indices", 0, MAX_LIGHT_INDICES },
+			}
+		}
+	};
+}
+
+uint32_t PerFrameLightUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
+{
+	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
+
+	return bindingIndex;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../Maths/Matrix.h"
+#include "UniformDataStorage.h"
+#include "LightClusterGrid.h"
+#include <cstddef>
+
+class DescriptorSet;
+
+// Point and spot lights of current frame in camera space, plus light lists of every cluster of "LightClusterGrid"
+class PerFrameLightUniforms : public UniformDataStorage
+{
+public:
+	static const uint32_t MAX_LIGHTS = 1024;
+	static const uint32_t MAX_LIGHT_INDICES = 1 << 16;
+
+	enum LightType
+	{
+		LightType_Point,
+		LightType_Spot,
+	};
+
+	typedef struct _LightData
+	{
+		Vector4f	positionRange;		// xyz: camera space position, w: range
+		Vector4f	colorType;			// xyz: color, w: "LightType"
+		Vector4f	direction;			// xyz: camera space direction light shines along
+		Vector4f	spotScaleOffset;	// Cone fall off is saturate(cos * x + y)
+	}LightData;
+
+	typedef struct _LightClusterData
+	{
+		Vector4f	clusterSettings;	// x: near depth, y: slices per log depth, z: light count
+		uint32_t	clusterLightRanges[LightClusterGrid::CLUSTER_COUNT * 2];
+		LightData	lights[MAX_LIGHTS];
+		uint32_t	lightIndices[MAX_LIGHT_INDICES];
+	}LightClusterData;
+
+protected:
+	bool Init(const std::shared_ptr<PerFrameLightUniforms>& pSelf);
+
+public:
+	static std::shared_ptr<PerFrameLightUniforms> Create();
+
+public:
+	// Lights beyond "MAX_LIGHTS" are ignored
+	void SetLights(const LightData* pLights, uint32_t count);
+	uint32_t GetLightsCount() const { return m_lightsCount; }
+
+	// Slice parameters and light lists from a grid whose jobs are all done, returns number of light indices
+	uint32_t SetClusters(LightClusterGrid& grid);
+	uint32_t GetLightIndicesCount() const { return m_lightIndicesCount; }
+
+	std::vector<UniformVarList> PrepareUniformVarList() const override;
+	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+protected:
+	void UpdateUniformDataInternal() override {}
+	void SetDirtyInternal() override {}
+	const void* AcquireDataPtr() const override { return &m_lightClusterData; }
+
+	// Only indices in use are uploaded
+	uint32_t AcquireDataSize() const override { return (uint32_t)offsetof(LightClusterData, lightIndices) + m_lightIndicesCount * sizeof(uint32_t); }
+
+protected:
+	LightClusterData	m_lightClusterData;
+	uint32_t			m_lightsCount = 0;
+	uint32_t			m_lightIndicesCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "PerMaterialCullingUniforms.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/ShaderStorageBuffer.h"
+#include "Material.h"
+#include <cstring>
+
+bool PerMaterialCullingUniforms::Init(const std::shared_ptr<PerMaterialCullingUniforms>& pSelf)
+{
+	memset(&m_cullingInput, 0, sizeof(m_cullingInput));
+
+	if (!UniformDataStorage::Init(pSelf, sizeof(m_cullingInput), PerFrameDataStorage::ShaderStorage))
+		return false;
+
+	// A dispatch before any draw is appended finds nothing to cull rather than whatever buffer memory holds
+	SetDirty();
+	return true;
+}
+
+std::shared_ptr<PerMaterialCullingUniforms> PerMaterialCullingUniforms::Create()
+{
+	std::shared_ptr<PerMaterialCullingUniforms> pPerMaterialCullingUniforms = std::make_shared<PerMaterialCullingUniforms>();
+	if (pPerMaterialCullingUniforms.get() && pPerMaterialCullingUniforms->Init(pPerMaterialCullingUniforms))
+		return pPerMaterialCullingUniforms;
+	return nullptr;
+}
+
+bool PerMaterialCullingUniforms::SetDraws(const VkDrawIndexedIndirectCommand* pCmds, const uint32_t* pIndirectOffsets, uint32_t drawCount, const PerMaterialIndirectVariables* pIndirectVariables, uint32_t indirectVariablesCount)
+{
+	bool fits = GPUCuller::GetInstance()->PrepareInput(pCmds, pIndirectOffsets, drawCount, pIndirectVariables, indirectVariablesCount, m_cullingInput);
+	SetDirty();
+	return fits;
+}
+
+void PerMaterialCullingUniforms::SetOutputWordOffsets(uint32_t cmdWordOffset, uint32_t countWordOffset, uint32_t indirectOffsetWordOffset, uint32_t indirectVariableWordOffset)
+{
+	m_cullingInput.cmdWordOffset = cmdWordOffset;
+	m_cullingInput.countWordOffset = countWordOffset;
+	m_cullingInput.indirectOffsetWordOffset = indirectOffsetWordOffset;
+	m_cullingInput.indirectVariableWordOffset = indirectVariableWordOffset;
+	SetDirty();
+}
+
+std::vector<UniformVarList> PerMaterialCullingUniforms::PrepareUniformVarList() const
+{
+	return
+	{
+		{
+			DynamicShaderStorageBuffer,
+			"PerMaterialCullingUniforms",
+			{
+				{ Vec4Unit, "Frustum planes relative to camera position, xyz: normal, w: D", 0, PyramidFrustumd::FrustumFace_COUNT },
+				{ Vec4Unit, "Instance count, draw count, indirect command word offset, draw count word offset" },
+				{ Vec4Unit, "Indirect offset word offset, indirect variable word offset, bypass, padding" },
+				{ Mat4Unit, "Last frame's view projection relative to camera position, for Hi-Z occlusion" },
+				{ Vec4Unit, "Hi-Z level count, pyramid index, size" },
+				{ Vec4Unit, "Instance box center, extents and flags, indirect variables, 3 per instance", 0, GPUCuller::MAX_INSTANCE_COUNT * 3 },
+				{ Mat2x4Unit, "Draw arguments and range of its instances", 0, GPUCuller::MAX_DRAW_COUNT },
+			}
+		}
+	};
+}
+
+uint32_t PerMaterialCullingUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
+{
+	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
+
+	return bindingIndex;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "UniformDataStorage.h"
+#include "GPUCuller.h"
+
+class DescriptorSet;
+
+// Input of a material's "gpu_culling.comp" dispatch: frustum, bounds and variables of every instance appended this frame, and draws they belong to
+// Word offsets tell kernel where this frame's indirect commands, draw count, offsets and variables live in the buffers it writes
+class PerMaterialCullingUniforms : public UniformDataStorage
+{
+protected:
+	bool Init(const std::shared_ptr<PerMaterialCullingUniforms>& pSelf);
+
+public:
+	static std::shared_ptr<PerMaterialCullingUniforms> Create();
+
+public:
+	// Culling input from draws assembled by render queue, with bounds and view last handed to "GPUCuller"
+	// False if they don't fit in culling kernel, which is then told to leave output alone
+	bool SetDraws(const VkDrawIndexedIndirectCommand* pCmds, const uint32_t* pIndirectOffsets, uint32_t drawCount, const PerMaterialIndirectVariables* pIndirectVariables, uint32_t indirectVariablesCount);
+
+	// All in 4 byte words from start of the buffer bound to kernel
+	void SetOutputWordOffsets(uint32_t cmdWordOffset, uint32_t countWordOffset, uint32_t indirectOffsetWordOffset, uint32_t indirectVariableWordOffset);
+
+	std::vector<UniformVarList> PrepareUniformVarList() const override;
+	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+protected:
+	void UpdateUniformDataInternal() override {}
+	void SetDirtyInternal() override {}
+	const void* AcquireDataPtr() const override { return &m_cullingInput; }
+	uint32_t AcquireDataSize() const override { return sizeof(m_cullingInput); }
+
+protected:
+	GPUCuller::CullingInput		m_cullingInput;
+};
\ No newline at end of file
@@ -27,6 +27,18 @@ void PerMaterialIndirectOffsetUniforms::UpdateDirtyChunkInternal(uint32_t index)
 {
 }
 
+void PerMaterialIndirectOffsetUniforms::SetIndirectOffsets(uint32_t firstDrawID, const uint32_t* pIndirectOffsets, uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	static_assert(sizeof(IndirectOffset) == sizeof(uint32_t), "IndirectOffset is expected to be tightly packed");
+	memcpy(&m_indirectOffsets[firstDrawID], pIndirectOffsets, count * sizeof(IndirectOffset));
+
+	// Whole array is uploaded during sync, a single dirty mark is enough
+	SetChunkDirty(firstDrawID);
+}
+
 std::vector<UniformVarList> PerMaterialIndirectOffsetUniforms::PrepareUniformVarList() const
 {
 	return
@@ -67,6 +79,16 @@ void PerMaterialIndirectUniforms::UpdateDirtyChunkInternal(uint32_t index)
 {
 }
 
+void PerMaterialIndirectUniforms::SetIndirectVariables(uint32_t firstIndirectIndex, const PerMaterialIndirectVariables* pVariables, uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	memcpy(&m_perMaterialIndirectIndex[firstIndirectIndex], pVariables, count * sizeof(PerMaterialIndirectVariables));
+
+	SetChunkDirty(firstIndirectIndex);
+}
+
 std::vector<UniformVarList> PerMaterialIndirectUniforms::PrepareUniformVarList() const
 {
 	return
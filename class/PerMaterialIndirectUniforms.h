@@ -2,27 +2,10 @@
 
 #include "../Maths/Matrix.h"
 #include "ChunkBasedUniforms.h"
+#include "PerMaterialIndirectVariables.h"
 
 class DescriptorSet;
 
-// You can't directly map "gl_drawID" to the array "PerMaterialIndirectVariables" one by one,
-// as there could be more than 1 instance for a mesh, and they all share the same "gl_drawID"
-// Considering the fact described above, offset is added here serving as another indirect so that 
-// one could get a correct index of "PerMaterialIndirectVariables" with "DrawIDOffset[gl_drawID] + gl_instanceID"
-typedef struct _IndirectOffset
-{
-	uint32_t offset = 0;
-}IndirectOffset;
-
-// Variables that could indirect to specific data in shader
-typedef struct _PerMaterialIndirectVariables
-{
-	uint32_t perObjectIndex = 0;
-	uint32_t perMaterialIndex = 0;
-	uint32_t perMeshIndex = 0;
-	uint32_t utilityIndex = 0;
-}PerMaterialIndirectVariables;
-
 class PerMaterialIndirectOffsetUniforms : public ChunkBasedUniforms
 {
 public:
@@ -32,6 +15,8 @@ public:
 public:
 	void SetIndirectOffset(uint32_t drawID, uint32_t indirectOffset) { m_indirectOffsets[drawID].offset = indirectOffset; SetChunkDirty(drawID); }
 	uint32_t GetIndirectOffset(uint32_t drawID) const { return m_indirectOffsets[drawID].offset; }
+	// Set offsets of "count" consecutive draws starting from "firstDrawID" at once
+	void SetIndirectOffsets(uint32_t firstDrawID, const uint32_t* pIndirectOffsets, uint32_t count);
 
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
@@ -61,6 +46,8 @@ public:
 	uint32_t GetPerMeshIndex(uint32_t indirectIndex) const { return m_perMaterialIndirectIndex[indirectIndex].perMeshIndex; }
 	void SetUtilityIndex(uint32_t indirectIndex, uint32_t utilityIndex) { m_perMaterialIndirectIndex[indirectIndex].utilityIndex = utilityIndex; SetChunkDirty(indirectIndex); }
 	uint32_t GetPerAnimationindex(uint32_t indirectIndex) const { return m_perMaterialIndirectIndex[indirectIndex].utilityIndex; }
+	// Set "count" consecutive indirect variables starting from "firstIndirectIndex" at once
+	void SetIndirectVariables(uint32_t firstIndirectIndex, const PerMaterialIndirectVariables* pVariables, uint32_t count);
 
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
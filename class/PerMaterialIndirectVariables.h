@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+// You can't directly map "gl_drawID" to the array "PerMaterialIndirectVariables" one by one,
+// as there could be more than 1 instance for a mesh, and they all share the same "gl_drawID"
+// Considering the fact described above, offset is added here serving as another indirect so that 
+// one could get a correct index of "PerMaterialIndirectVariables" with "DrawIDOffset[gl_drawID] + gl_instanceID"
+typedef struct _IndirectOffset
+{
+	uint32_t offset = 0;
+}IndirectOffset;
+
+// Variables that could indirect to specific data in shader
+typedef struct _PerMaterialIndirectVariables
+{
+	uint32_t perObjectIndex = 0;
+	uint32_t perMaterialIndex = 0;
+	uint32_t perMeshIndex = 0;
+	uint32_t utilityIndex = 0;
+}PerMaterialIndirectVariables;
\ No newline at end of file
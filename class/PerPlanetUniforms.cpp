@@ -5,6 +5,7 @@
 #include "../vulkan/ShaderStorageBuffer.h"
 #include "UniformData.h"
 #include "Material.h"
+#include "PlanetSubdivider.h"
 
 bool PerPlanetUniforms::Init(const std::shared_ptr<PerPlanetUniforms>& pSelf)
 {
@@ -31,10 +32,12 @@ void PerPlanetUniforms::SetPlanetRadius(uint32_t index, double radius)
 	uint32_t index1 = UniformData::GetInstance()->GetGlobalUniforms()->CubeIndices[2];
 
 	double size = (UniformData::GetInstance()->GetGlobalUniforms()->CubeVertices[index0] - UniformData::GetInstance()->GetGlobalUniforms()->CubeVertices[index1]).Length();
-	double frac = std::tan(UniformData::GetInstance()->GetGlobalUniforms()->GetMainCameraHorizontalFOV() * UniformData::GetInstance()->GetGlobalUniforms()->GetPlanetTriangleScreenSize() / UniformData::GetInstance()->GetGlobalUniforms()->GetGameWindowSize().x);
+
+	// Screen space error: window height covers twice the tangent of half vertical FOV at distance of 1
+	double pixelsPerUnit = UniformData::GetInstance()->GetGlobalUniforms()->GetGameWindowSize().y / (2.0 * UniformData::GetInstance()->GetGlobalUniforms()->GetMainCameraVerticalTangentFOV_2());
 	for (uint32_t i = 0; i < UniformData::GetInstance()->GetGlobalUniforms()->GetMaxPlanetLODLevel() + 1; i++)
 	{
-		m_perPlanetVariables[index].PlanetLODDistanceLUT[i] = size / frac * radius;
+		m_perPlanetVariables[index].PlanetLODDistanceLUT[i] = PlanetSubdivider::ComputeLODDistance(size * radius, pixelsPerUnit, UniformData::GetInstance()->GetGlobalUniforms()->GetPlanetTriangleScreenSize());
 		CONVERT2SINGLEVAL(m_perPlanetVariables[index], m_singlePrecisionPerPlanetVariables[index], PlanetLODDistanceLUT[i]);
 		size *= 0.5;
 	}
@@ -42,6 +45,14 @@ void PerPlanetUniforms::SetPlanetRadius(uint32_t index, double radius)
 	SetChunkDirty(index);
 }
 
+void PerPlanetUniforms::SetPlanetMaxTerrainHeight(uint32_t index, double height)
+{
+	m_perPlanetVariables[index].PlanetDescriptor0.z = height;
+	CONVERT2SINGLEVAL(m_perPlanetVariables[index], m_singlePrecisionPerPlanetVariables[index], PlanetDescriptor0.z);
+
+	SetChunkDirty(index);
+}
+
 void PerPlanetUniforms::SetPlanetTriangleSubdivideLevel(uint32_t index, uint32_t level)
 {
 	m_perPlanetVariables[index].PlanetDescriptor0.y = level;
@@ -13,7 +13,7 @@ public:
 	*
 	* X: Planet radius
 	* Y: Planet triangle subdivide level
-	* Z: Reserved
+	* Z: Max terrain height above planet radius
 	* W: Reserved
 	*/
 	Vector4<T>	PlanetDescriptor0;
@@ -38,6 +38,8 @@ public:
 	double GetPlanetRadius(uint32_t index) const { return m_perPlanetVariables[index].PlanetDescriptor0.x; }
 	void SetPlanetTriangleSubdivideLevel(uint32_t index, uint32_t level);
 	double SetPlanetTriangleSubdivideLevel(uint32_t index) const { return m_perPlanetVariables[index].PlanetDescriptor0.y; }
+	void SetPlanetMaxTerrainHeight(uint32_t index, double height);
+	double GetPlanetMaxTerrainHeight(uint32_t index) const { return m_perPlanetVariables[index].PlanetDescriptor0.z; }
 	double GetLODDistance(uint32_t index, uint32_t level) const { return m_perPlanetVariables[index].PlanetLODDistanceLUT[level]; }
 
 public:
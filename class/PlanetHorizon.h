@@ -0,0 +1,38 @@
+#pragma once
+#include "../Maths/Vector.h"
+
+// Horizon of a sphere seen from a camera, no dependency on renderer
+// Hidden points lie beyond the plane through horizon circle, and within the cone from camera touching sphere along that circle
+// Everything is relative to sphere center
+class PlanetHorizon
+{
+public:
+	void SetView(const Vector3d& cameraPosition, double radius)
+	{
+		m_cameraPosition = cameraPosition;
+		m_horizonDistanceSquare = cameraPosition.SquareLength() - radius * radius;
+	}
+
+	// Whether sphere hides a point from camera
+	bool IsHidden(const Vector3d& p) const
+	{
+		// Camera inside sphere, nothing could be told
+		if (m_horizonDistanceSquare <= 0.0)
+			return false;
+
+		// Projection of camera to point onto camera to planet center is "-viewDotCamera" times camera distance, horizon plane is at squared tangent length times that
+		Vector3d view = p - m_cameraPosition;
+		double viewDotCamera = view * m_cameraPosition;
+		if (-viewDotCamera <= m_horizonDistanceSquare)
+			return false;
+
+		// Cosine of cone half angle is tangent length over camera distance
+		return viewDotCamera * viewDotCamera > m_horizonDistanceSquare * view.SquareLength();
+	}
+
+protected:
+	Vector3d	m_cameraPosition;
+
+	// Squared length of camera's tangent to sphere, negative if camera is inside it
+	double		m_horizonDistanceSquare = 0;
+};
\ No newline at end of file
@@ -0,0 +1,643 @@
+#include "PlanetSubdivider.h"
+#include "../common/Macros.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+void PlanetSubdivider::GenerateCube(Vector3d vertices[], uint32_t indices[])
+{
+	vertices[0] = { -1, -1,  1 };
+	vertices[1] = {  1, -1,  1 };
+	vertices[2] = { -1, -1, -1 };
+	vertices[3] = {  1, -1, -1 };
+
+	vertices[4] = { -1,  1,  1 };
+	vertices[5] = {  1,  1,  1 };
+	vertices[6] = { -1,  1, -1 };
+	vertices[7] = {  1,  1, -1 };
+
+	for (uint32_t i = 0; i < 8; i++)
+		vertices[i].Normalize();
+
+	// Bottom
+	indices[0] = 1;
+	indices[1] = 0;
+	indices[2] = 3;
+	indices[3] = 3;
+	indices[4] = 0;
+	indices[5] = 2;
+
+	// Top
+	indices[6] = 4;
+	indices[7] = 5;
+	indices[8] = 6;
+	indices[9] = 6;
+	indices[10] = 5;
+	indices[11] = 7;
+
+	// Front
+	indices[12] = 0;
+	indices[13] = 1;
+	indices[14] = 4;
+	indices[15] = 4;
+	indices[16] = 1;
+	indices[17] = 5;
+
+	// Back
+	indices[18] = 3;
+	indices[19] = 2;
+	indices[20] = 7;
+	indices[21] = 7;
+	indices[22] = 2;
+	indices[23] = 6;
+
+	// Left
+	indices[24] = 2;
+	indices[25] = 0;
+	indices[26] = 6;
+	indices[27] = 6;
+	indices[28] = 0;
+	indices[29] = 4;
+
+	// Right
+	indices[30] = 1;
+	indices[31] = 3;
+	indices[32] = 5;
+	indices[33] = 5;
+	indices[34] = 3;
+	indices[35] = 7;
+}
+
+void PlanetSubdivider::Init(const Vector3d* pVertices, const uint32_t* pIndices, double planetRadius, double maxTerrainHeight, uint32_t maxLODLevel, const std::vector<double>& distanceLUT)
+{
+	ASSERTION(distanceLUT.size() >= maxLODLevel);
+
+	m_pVertices = pVertices;
+	m_pIndices = pIndices;
+	m_planetRadius = planetRadius;
+	m_maxTerrainHeight = maxTerrainHeight;
+	m_maxLODLevel = maxLODLevel;
+	m_distanceLUT = distanceLUT;
+
+	InitHeightLUT();
+}
+
+void PlanetSubdivider::InitHeightLUT()
+{
+	Vector3d a = m_pVertices[m_pIndices[1]];
+	Vector3d b = m_pVertices[m_pIndices[2]];
+	Vector3d center = (a + b) / 2.0;
+	center.Normalize();
+
+	double cosin_a_center = a * center;
+
+	// cosin_a_center = r / h, r = 1(local length)
+	double height_level_0 = 1 / cosin_a_center;
+	
+	m_heightLUT.clear();
+	m_heightLUT.push_back(height_level_0);
+	for (uint32_t i = 1; i < m_maxLODLevel + 1; i++)
+	{
+		// Next level vertices
+		Vector3d A = center.Normal();
+		Vector3d B = b;
+
+		center = (A + B) * 0.5;
+		center.Normalize();
+
+		double cosin_A_center = A * center;
+		double height = 1 / cosin_A_center;
+		m_heightLUT.push_back(height);
+
+		a = A;
+		b = B;
+	}
+}
+
+void PlanetSubdivider::SetView(const Vector3d& cameraPosition, const PyramidFrustumd& frustum, const Vector3d& emitOrigin)
+{
+	m_cameraPosition = cameraPosition;
+	m_cameraFrustum = frustum;
+	m_emitOrigin = emitOrigin;
+}
+
+PlanetSubdivider::CullState PlanetSubdivider::FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height)
+{
+	CullState state = CullState::DIVIDE;
+
+	// Side faces only, planet reaches well beyond camera far plane
+	for (uint32_t i = 0; i < m_cameraFrustum.FrustumFace_NEAR; i++)
+	{
+		uint32_t outsideCount = 0;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(a) > 0 ? 0 : 1;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(b) > 0 ? 0 : 1;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(c) > 0 ? 0 : 1;
+
+		if (outsideCount == 3)
+		{
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(a * height) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(b * height) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(c * height) > 0 ? 0 : 1;
+
+			if (outsideCount == 6)
+				return CullState::CULL;
+			else
+				state = CullState::CULL_DIVIDE;
+		}
+		else if (outsideCount > 0)
+			state = CullState::CULL_DIVIDE;
+	}
+
+	return state;
+}
+
+PlanetSubdivider::CullState PlanetSubdivider::FrustumCull(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2, const Vector3d& p3, double height)
+{
+	CullState state = CullState::DIVIDE;
+	for (uint32_t i = 0; i < m_cameraFrustum.FrustumFace_NEAR; i++)
+	{
+		uint32_t outsideCount = 0;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(p0) > 0 ? 0 : 1;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(p1) > 0 ? 0 : 1;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(p2) > 0 ? 0 : 1;
+		outsideCount += m_cameraFrustum.planes[i].PlaneTest(p3) > 0 ? 0 : 1;
+
+		if (outsideCount == 4)
+		{
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(p0 * height) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(p1 * height) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(p2 * height) > 0 ? 0 : 1;
+			outsideCount += m_cameraFrustum.planes[i].PlaneTest(p3 * height) > 0 ? 0 : 1;
+
+			if (outsideCount == 8)
+				return CullState::CULL;
+			else
+				state = CullState::CULL_DIVIDE;
+		}
+		else if (outsideCount > 0)
+			state = CullState::CULL_DIVIDE;
+	}
+
+	return state;
+}
+
+bool PlanetSubdivider::BackFaceCull(const Vector3d& a, const Vector3d& b, const Vector3d& c)
+{
+	// Utility vector No.3 represents triangle normal
+	// Utility vector No.4 represents vector from camera to one triangle vertex
+	m_utilityVector3 = c;
+	m_utilityVector4 = a;
+	m_utilityVector3 -= b;
+	m_utilityVector4 -= b;
+	m_utilityVector3 = m_utilityVector3 ^ m_utilityVector4;
+
+	m_utilityVector4 = a;
+	m_utilityVector4 -= m_cameraPosition;
+
+	// If camera is located at the negative side of this triangle(dot product greater than 0)
+	// Then more check will perform
+	// Otherwise(camera at positive side of this triangle), proceeding to subdivide step
+	// NOTE: No need to normalize, as what we want is the dot product sign only
+	if (m_utilityVector3 * m_utilityVector4 > 0.0)
+	{
+		// Utility vector 0, 1 and 2 are vectors from camera to them respectively
+		m_utilityVector0 = a;
+		m_utilityVector1 = b;
+		m_utilityVector2 = c;
+
+		m_utilityVector0 -= m_cameraPosition;
+		m_utilityVector1 -= m_cameraPosition;
+		m_utilityVector2 -= m_cameraPosition;
+
+		// This checks if camera could observe the sphere surface within current triangle 
+		// NOTE: No need to normalize, as what we want is the dot product sign only
+		if (a * m_utilityVector0 > 0.0
+			&& b * m_utilityVector1 > 0.0
+			&& c * m_utilityVector2 > 0.0)
+			return true;
+	}
+
+	return false;
+}
+
+// Assume a quad is arranged like this
+// c--------d
+// | \      |
+// |   \    |
+// |     \  |
+// a--------b
+// trianlge 1: abc, triangle 2: cbd
+bool PlanetSubdivider::BackFaceCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d)
+{
+	// Triangle 1 start
+	// Utility vector No.3 represents triangle normal
+	// Utility vector No.4 represents vector from camera to one triangle vertex
+	m_utilityVector3 = c;
+	m_utilityVector4 = a;
+	m_utilityVector3 -= b;
+	m_utilityVector4 -= b;
+	m_utilityVector3 = m_utilityVector3 ^ m_utilityVector4;
+
+	m_utilityVector4 = a;
+	m_utilityVector4 -= m_cameraPosition;
+
+	// If camera is located at the negative side of this triangle(dot product greater than 0)
+	// Then more check will perform
+	// Otherwise(camera at positive side of this triangle), proceeding to subdivide step
+	// NOTE: No need to normalize, as what we want is the dot product sign only
+	if (m_utilityVector3 * m_utilityVector4 < 0.0)
+		return false;
+
+	// Utility vector 0, 1 and 2 are vectors from camera to them respectively
+	m_utilityVector0 = a;
+	m_utilityVector1 = b;
+	m_utilityVector2 = c;
+
+	m_utilityVector0 -= m_cameraPosition;
+	m_utilityVector1 -= m_cameraPosition;
+	m_utilityVector2 -= m_cameraPosition;
+
+	// This checks if camera could observe the sphere surface within current triangle 
+	// NOTE: No need to normalize, as what we want is the dot product sign only
+	if (a * m_utilityVector0 < 0.0
+		|| b * m_utilityVector1 < 0.0
+		|| c * m_utilityVector2 < 0.0)
+		return false;
+
+	// Now we're done for checking trianlge 1, now start triangle 2
+	m_utilityVector3 = d;
+	m_utilityVector4 = c;
+	m_utilityVector3 -= b;
+	m_utilityVector4 -= b;
+	m_utilityVector3 = m_utilityVector3 ^ m_utilityVector4;
+
+	m_utilityVector4 = d;
+	m_utilityVector4 -= m_cameraPosition;
+
+	if (m_utilityVector3 * m_utilityVector4 < 0.0)
+		return false;
+
+	// Only deal with 4th vertex
+	m_utilityVector0 = d;
+
+	m_utilityVector0 -= m_cameraPosition;
+
+	// This checks if camera could observe the sphere surface within current triangle 
+	// NOTE: No need to normalize, as what we want is the dot product sign only
+	if (d * m_utilityVector0 < 0.0)
+		return false;
+
+	// Finally we're sure that nothing can be seen from this angle, we return true as a permission to cull this quad
+	return true;
+}
+
+bool PlanetSubdivider::HorizonCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height) const
+{
+	// Hidden region is convex, so is patch bound, hiding all its corners hides all of it
+	return m_horizon.IsHidden(a) && m_horizon.IsHidden(b) && m_horizon.IsHidden(c)
+		&& m_horizon.IsHidden(a * height) && m_horizon.IsHidden(b * height) && m_horizon.IsHidden(c * height);
+}
+
+bool PlanetSubdivider::HorizonCull(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2, const Vector3d& p3, double height) const
+{
+	return m_horizon.IsHidden(p0) && m_horizon.IsHidden(p1) && m_horizon.IsHidden(p2) && m_horizon.IsHidden(p3)
+		&& m_horizon.IsHidden(p0 * height) && m_horizon.IsHidden(p1 * height) && m_horizon.IsHidden(p2 * height) && m_horizon.IsHidden(p3 * height);
+}
+
+void PlanetSubdivider::SubDivideTriangle(uint32_t currentLevel, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, bool reversed, Triangle*& pOutputTriangles)
+{
+	Vector3d newA = a;
+	Vector3d newB = b;
+	Vector3d newC = c;
+
+	newA *= m_planetRadius;
+	newB *= m_planetRadius;
+	newC *= m_planetRadius;
+
+	// Terrain could rise above the plane touching patch center
+	double boundHeight = GetBoundHeight(currentLevel);
+
+	// Only perform frustum cull if state is CULL_DIVIDE, as it intersects the volumn
+	if (state == CullState::CULL_DIVIDE)
+	{
+		// Frustum cull
+		state = FrustumCull(newA, newB, newC, boundHeight);
+
+		// Early quit if triangle is totally outside of the volumn
+		if (state == CullState::CULL)
+			return;
+
+		// Whatever has left should be either CULL_DIVIDE or DIVIDE
+		// This state will be passed on to the next sub divide level
+	}
+
+	// Peaks of a back facing patch could still rise over horizon
+	if (m_maxTerrainHeight == 0 && BackFaceCull(newA, newB, newC))
+		return;
+
+	if (m_horizonCulling && HorizonCull(newA, newB, newC, boundHeight))
+		return;
+
+	Vector3d camera_relative_a = newA - m_cameraPosition;
+	Vector3d camera_relative_b = newB - m_cameraPosition;
+	Vector3d camera_relative_c = newC - m_cameraPosition;
+
+	double distA = camera_relative_a.Length();
+	double distB = camera_relative_b.Length();
+	double distC = camera_relative_c.Length();
+
+	double minDist = std::fmin(std::fmin(distA, distB), distC);
+
+	// Distance table already holds planet radius, it's where patch edge of this level spans planet triangle screen size
+	// It's copied up to max level exclusive, so max level goes first
+	if (currentLevel == m_maxLODLevel || m_distanceLUT[currentLevel] <= minDist)
+	{
+		camera_relative_a = newA - m_emitOrigin;
+		camera_relative_b = newB - m_emitOrigin;
+		camera_relative_c = newC - m_emitOrigin;
+
+		pOutputTriangles->p = camera_relative_a.SinglePrecision();
+		pOutputTriangles->edge0 = camera_relative_b.SinglePrecision();
+		pOutputTriangles->edge1 = camera_relative_c.SinglePrecision();
+
+		pOutputTriangles->edge0 -= pOutputTriangles->p;
+		pOutputTriangles->edge1 -= pOutputTriangles->p;
+
+		// Level + 1 to avoid zero
+		pOutputTriangles->level = reversed ? -1.0f : 1.0f * (currentLevel + 1);
+
+		pOutputTriangles++;
+		m_emittedTriangleCount++;
+
+		return;
+	}
+
+	Vector3d A = c;
+	Vector3d B = c;
+	Vector3d C = b;
+
+	A += b;
+	A *= 0.5f;
+
+	B += a;
+	B *= 0.5f;
+
+	C += a;
+	C *= 0.5f;
+
+	A.Normalize();
+	B.Normalize();
+	C.Normalize();
+
+	SubDivideTriangle(currentLevel + 1, state, a, C, B, reversed, pOutputTriangles);
+	SubDivideTriangle(currentLevel + 1, state, C, b, A, reversed, pOutputTriangles);
+	SubDivideTriangle(currentLevel + 1, state, B, A, c, reversed, pOutputTriangles);
+	SubDivideTriangle(currentLevel + 1, state, A, B, C, reversed, pOutputTriangles);
+}
+
+void PlanetSubdivider::SubDivideQuad(uint32_t currentLevel, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d, Triangle*& pOutputTriangles)
+{
+	Vector3d realSizeA = a;
+	Vector3d realSizeB = b;
+	Vector3d realSizeC = c;
+	Vector3d realSizeD = d;
+
+	realSizeA.Normalize();
+	realSizeB.Normalize();
+	realSizeC.Normalize();
+	realSizeD.Normalize();
+
+	realSizeA *= m_planetRadius;
+	realSizeB *= m_planetRadius;
+	realSizeC *= m_planetRadius;
+	realSizeD *= m_planetRadius;
+
+	// Terrain could rise above the plane touching patch center
+	double boundHeight = GetBoundHeight(currentLevel);
+
+	// Only perform frustum cull if state is CULL_DIVIDE, as it intersects the volumn
+	if (state == CullState::CULL_DIVIDE)
+	{
+		// Frustum cull
+		state = FrustumCull(realSizeA, realSizeB, realSizeC, realSizeD, boundHeight);
+
+		// Early quit if triangle is totally outside of the volumn
+		if (state == CullState::CULL)
+			return;
+
+		// Whatever has left should be either CULL_DIVIDE or DIVIDE
+		// This state will be passed on to the next sub divide level
+	}
+
+	// Peaks of a back facing patch could still rise over horizon
+	if (m_maxTerrainHeight == 0 && BackFaceCull(realSizeA, realSizeB, realSizeC, realSizeD))
+		return;
+
+	if (m_horizonCulling && HorizonCull(realSizeA, realSizeB, realSizeC, realSizeD, boundHeight))
+		return;
+
+	Vector3d camera_relative_a = realSizeA - m_cameraPosition;
+	Vector3d camera_relative_b = realSizeB - m_cameraPosition;
+	Vector3d camera_relative_c = realSizeC - m_cameraPosition;
+	Vector3d camera_relative_d = realSizeD - m_cameraPosition;
+
+	double distA = camera_relative_a.Length();
+	double distB = camera_relative_b.Length();
+	double distC = camera_relative_c.Length();
+	double distD = camera_relative_d.Length();
+
+	double minDist = std::fmin(std::fmin(std::fmin(distA, distB), distC), distD);
+
+	if (currentLevel == m_maxLODLevel || m_distanceLUT[currentLevel] <= minDist)
+	{
+		camera_relative_a = realSizeA - m_emitOrigin;
+		camera_relative_b = realSizeB - m_emitOrigin;
+		camera_relative_c = realSizeC - m_emitOrigin;
+		camera_relative_d = realSizeD - m_emitOrigin;
+
+		// Triangle abc
+		pOutputTriangles->p = camera_relative_c.SinglePrecision();
+		pOutputTriangles->edge0 = camera_relative_a.SinglePrecision();
+		pOutputTriangles->edge1 = camera_relative_b.SinglePrecision();
+
+		pOutputTriangles->edge0 -= pOutputTriangles->p;
+		pOutputTriangles->edge1 -= pOutputTriangles->p;
+
+		// Level + 1 to avoid zero
+		pOutputTriangles->level = (float)currentLevel + 1.0f;
+
+		pOutputTriangles++;
+
+		// Triangle cbd
+		pOutputTriangles->p = camera_relative_b.SinglePrecision();
+		pOutputTriangles->edge0 = camera_relative_d.SinglePrecision();
+		pOutputTriangles->edge1 = camera_relative_c.SinglePrecision();
+
+		pOutputTriangles->edge0 -= pOutputTriangles->p;
+		pOutputTriangles->edge1 -= pOutputTriangles->p;
+
+		// Minus gives a sign whether to reverse morphing in vertex shader
+		pOutputTriangles->level = ((float)currentLevel + 1.0f) * -1.0f;
+
+		pOutputTriangles++;
+		m_emittedTriangleCount += 2;
+
+		return;
+	}
+
+	Vector3d ab = a;
+	Vector3d ac = a;
+	Vector3d bd = b;
+	Vector3d cd = c;
+
+	ab += b;
+	ab *= 0.5f;
+
+	ac += c;
+	ac *= 0.5f;
+
+	bd += d;
+	bd *= 0.5f;
+
+	cd += d;
+	cd *= 0.5f;
+
+	Vector3d center = ab;
+	center += cd;
+	center *= 0.5f;
+
+	SubDivideQuad(currentLevel + 1, state, a, ab, ac, center, pOutputTriangles);
+	SubDivideQuad(currentLevel + 1, state, ab, b, center, bd, pOutputTriangles);
+	SubDivideQuad(currentLevel + 1, state, ac, center, c, cd, pOutputTriangles);
+	SubDivideQuad(currentLevel + 1, state, center, bd, cd, d, pOutputTriangles);
+}
+
+uint32_t PlanetSubdivider::GenerateTriangles(Triangle* pTriangles)
+{
+	m_horizon.SetView(m_cameraPosition, m_planetRadius);
+	m_emittedTriangleCount = 0;
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		SubDivideQuad(0, CullState::CULL_DIVIDE,
+			m_pVertices[m_pIndices[i * 6 + 0]],	// a
+			m_pVertices[m_pIndices[i * 6 + 1]],	// b
+			m_pVertices[m_pIndices[i * 6 + 2]],	// c
+			m_pVertices[m_pIndices[i * 6 + 5]],	// d
+			pTriangles);
+	}
+
+	return m_emittedTriangleCount;
+}
+
+PlanetSubdivider::BenchmarkResult PlanetSubdivider::Benchmark(uint32_t framesCount)
+{
+	ASSERTION(framesCount > 1);
+
+	BenchmarkResult result = {};
+	result.framesCount = framesCount;
+
+	// Earth sized planet, 1080p with 60 degrees vertical FOV, same triangle screen size and max level as scene setup
+	const double planetRadius = 6378000;
+	const double maxTerrainHeight = 8848;
+	const double windowWidth = 1920;
+	const double windowHeight = 1080;
+	const double tangentVerticalFOV_2 = std::tan(3.14159265358979 / 6.0);
+	const double aspect = windowWidth / windowHeight;
+	const double triangleScreenSize = 400;
+	const uint32_t maxLODLevel = 32;
+
+	Vector3d vertices[8];
+	uint32_t indices[36];
+	GenerateCube(vertices, indices);
+
+	BenchmarkCase* cases[] = { &result.legacy, &result.flat, &result.terrain, &result.terrainNoHorizon };
+	PlanetSubdivider planets[4];
+
+	double legacyFrac = std::tan(2.0 * std::atan(aspect * tangentVerticalFOV_2) * triangleScreenSize / windowWidth);
+	double pixelsPerUnit = windowHeight / (2.0 * tangentVerticalFOV_2);
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		// Legacy table took screen size ratio of horizontal FOV as an angle
+		std::vector<double> distanceLUT;
+		double size = (vertices[indices[1]] - vertices[indices[2]]).Length();
+		for (uint32_t j = 0; j < maxLODLevel; j++)
+		{
+			if (cases[i] == &result.legacy)
+				distanceLUT.push_back(size / legacyFrac * planetRadius);
+			else
+				distanceLUT.push_back(ComputeLODDistance(size * planetRadius, pixelsPerUnit, triangleScreenSize));
+			size *= 0.5;
+		}
+
+		bool terrain = cases[i] == &result.terrain || cases[i] == &result.terrainNoHorizon;
+		planets[i].Init(vertices, indices, planetRadius, terrain ? maxTerrainHeight : 0, maxLODLevel, distanceLUT);
+		planets[i].SetHorizonCulling(cases[i] != &result.terrainNoHorizon);
+	}
+
+	// Recorded flight: take off skimming the ground looking at horizon, climb to orbit while pitching down to face the planet
+	typedef struct _FlightKey
+	{
+		double	altitude;
+		double	pitch;		// In degrees, negative looks down
+	}FlightKey;
+
+	const FlightKey flightKeys[] =
+	{
+		{ 2,		0 },
+		{ 50,		-2 },
+		{ 1000,		-5 },
+		{ 20000,	-15 },
+		{ 400000,	-40 },
+		{ 20000000,	-90 },
+	};
+	const uint32_t flightKeysCount = sizeof(flightKeys) / sizeof(FlightKey);
+
+	// Ground track follows a great circle tilted off cube axes
+	Vector3d trackX = Vector3d(1, 0.4, 0.2).Normal();
+	Vector3d trackY = (trackX ^ Vector3d(0, 1, 0)).Normal();
+
+	// Far more than any case emits, "GenerateTriangles" doesn't check bounds
+	std::vector<Triangle> triangles(1 << 16);
+
+	for (uint32_t i = 0; i < framesCount; i++)
+	{
+		double t = (double)i / (framesCount - 1) * (flightKeysCount - 1);
+		uint32_t key = std::min((uint32_t)t, flightKeysCount - 2);
+		double frac = t - key;
+
+		double altitude = std::exp(std::log(flightKeys[key].altitude) * (1.0 - frac) + std::log(flightKeys[key + 1].altitude) * frac);
+		double pitch = (flightKeys[key].pitch * (1.0 - frac) + flightKeys[key + 1].pitch * frac) * 3.14159265358979 / 180.0;
+		double longitude = 0.02 * i / framesCount;
+
+		Vector3d up = trackX * std::cos(longitude) + trackY * std::sin(longitude);
+		Vector3d heading = trackY * std::cos(longitude) - trackX * std::sin(longitude);
+		Vector3d position = up * (planetRadius + altitude);
+
+		PyramidFrustumd frustum = PyramidFrustumd({ 0, 0, 0 }, heading * std::cos(pitch) + up * std::sin(pitch), std::atan(tangentVerticalFOV_2), aspect);
+		frustum.Transform(Matrix4d(Matrix3d(), position));
+
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			planets[j].SetView(position, frustum, position);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			uint32_t count = planets[j].GenerateTriangles(triangles.data());
+			cases[j]->time += std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+
+			ASSERTION(count <= triangles.size());
+
+			cases[j]->trianglesCount += count;
+			cases[j]->maxTrianglesCount = std::max(cases[j]->maxTrianglesCount, count);
+		}
+	}
+
+	for (auto pCase : cases)
+	{
+		pCase->trianglesCount /= framesCount;
+		pCase->time /= framesCount;
+	}
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include "../Maths/Vector.h"
+#include "../Maths/Matrix.h"
+#include "../Maths/PyramidFrustum.h"
+#include "PlanetHorizon.h"
+#include <vector>
+#include <cstdint>
+
+// Subdivision of a cube shaped planet into patches against a camera, no dependency on renderer
+// Each cube face is a quad tree, a patch is split until it's at max level or its nearest corner is as far as distance table of its level
+// says its edge spans planet triangle screen size. Patches out of frustum, back facing ones (flat planet only) and ones behind horizon are culled
+// Everything is in planet local space, patch bounds reach up to "maxTerrainHeight" above planet sphere
+class PlanetSubdivider
+{
+public:
+	enum class CullState
+	{
+		CULL,			// If a triangle is fully out of a volumn
+		CULL_DIVIDE,	// If a triangle intersects with a volumn
+		DIVIDE			// If a triangle is fully inside a volumn
+	};
+
+	typedef struct _Triangle
+	{
+		// A triangle consists of a vertex, and 2 edge vectors: edge0 and edge1
+		Vector3f	p;
+		Vector3f	edge0;
+		Vector3f	edge1;
+		float		level;	// the sign of this variable gives morphing direction
+	}Triangle;
+
+	typedef struct _BenchmarkCase
+	{
+		double		trianglesCount;		// Average per frame
+		uint32_t	maxTrianglesCount;
+		double		time;				// Per frame, in microseconds
+	}BenchmarkCase;
+
+	typedef struct _BenchmarkResult
+	{
+		uint32_t		framesCount;
+		BenchmarkCase	legacy;				// Distance table from horizontal FOV, frustum and back face culling, flat planet
+		BenchmarkCase	flat;				// Screen space error from vertical FOV, flat planet
+		BenchmarkCase	terrain;			// Same with terrain up to Everest height, horizon culling
+		BenchmarkCase	terrainNoHorizon;	// Same without horizon culling, frustum culling is all that's left
+	}BenchmarkResult;
+
+public:
+	// Unit cube corners pushed onto unit sphere, and 2 triangles per face, whose first 3 and last index make a face quad
+	static void GenerateCube(Vector3d vertices[], uint32_t indices[]);
+
+	// Distance from camera, below which a patch edge of "edgeLength" spans more than "triangleScreenSize" pixels on screen
+	// "pixelsPerUnit" is how many pixels a unit length facing camera at distance of 1 spans
+	static double ComputeLODDistance(double edgeLength, double pixelsPerUnit, double triangleScreenSize) { return edgeLength * pixelsPerUnit / triangleScreenSize; }
+
+	// Emitted triangles along a recorded flight path from ground level up to orbit, "framesCount" camera positions along it
+	static BenchmarkResult Benchmark(uint32_t framesCount);
+
+public:
+	// "pVertices" and "pIndices" are what "GenerateCube" makes, "distanceLUT" holds one distance per level below "maxLODLevel"
+	// Terrain rises at most "maxTerrainHeight" above "planetRadius" and never dips below it
+	void Init(const Vector3d* pVertices, const uint32_t* pIndices, double planetRadius, double maxTerrainHeight, uint32_t maxLODLevel, const std::vector<double>& distanceLUT);
+
+	// Culling and level selection work from "cameraPosition", emitted triangles are relative to "emitOrigin"
+	void SetView(const Vector3d& cameraPosition, const PyramidFrustumd& frustum, const Vector3d& emitOrigin);
+
+	// On by default, switched off only to compare against
+	void SetHorizonCulling(bool flag) { m_horizonCulling = flag; }
+
+	// Subdivides all 6 cube faces against current view, returns count of triangles written
+	uint32_t GenerateTriangles(Triangle* pTriangles);
+
+	uint32_t GetEmittedTriangleCount() const { return m_emittedTriangleCount; }
+
+	// How far above planet center patch bounds of a level reach over a corner direction, in units of planet radius
+	double GetBoundHeight(uint32_t level) const { return m_heightLUT[level] * (m_planetRadius + m_maxTerrainHeight) / m_planetRadius; }
+
+protected:
+	// Height of the plane touching each level's patch center, over corners at unit length
+	void InitHeightLUT();
+
+	CullState FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height);
+	CullState FrustumCull(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2, const Vector3d& p3, double height);
+	// Planet sphere is a conservative occluder, as terrain never dips below it
+	// Patch corners on sphere, and the same scaled by "height", bound everything terrain could put over patch
+	bool HorizonCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height) const;
+	bool HorizonCull(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2, const Vector3d& p3, double height) const;
+	bool BackFaceCull(const Vector3d& a, const Vector3d& b, const Vector3d& c);
+	// Though we can do it with simply 2 triangle back face cullings, this function could potentially reduce some calculation
+	bool BackFaceCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d);
+	void SubDivideTriangle(uint32_t currentLevel, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, bool reversed, Triangle*& pOutputTriangles);
+	void SubDivideQuad(uint32_t currentLevel, CullState state, const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d, Triangle*& pOutputTriangles);
+
+protected:
+	double					m_planetRadius = 1;
+	double					m_maxTerrainHeight = 0;
+
+	std::vector<double>		m_heightLUT;
+	std::vector<double>		m_distanceLUT;
+	uint32_t				m_maxLODLevel = 0;
+	const Vector3d*			m_pVertices = nullptr;
+	const uint32_t*			m_pIndices = nullptr;
+
+	// Utility variables, to avoid frequent construction and destruction every frame
+	Vector3d				m_utilityVector0;
+	Vector3d				m_utilityVector1;
+	Vector3d				m_utilityVector2;
+	Vector3d				m_utilityVector3;
+	Vector3d				m_utilityVector4;
+
+	PyramidFrustumd			m_cameraFrustum;
+	Vector3d				m_cameraPosition;
+	Vector3d				m_emitOrigin;
+
+	bool					m_horizonCulling = true;
+	PlanetHorizon			m_horizon;
+
+	uint32_t				m_emittedTriangleCount = 0;
+};
\ No newline at end of file
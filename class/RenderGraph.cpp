@@ -0,0 +1,358 @@
+#include "RenderGraph.h"
+#include "../common/Macros.h"
+#include <algorithm>
+
+const uint32_t RenderGraph::NONE;
+
+void RenderGraph::Reset()
+{
+	m_passes.clear();
+	m_resources.clear();
+	m_executionOrder.clear();
+	m_levelsCount = 0;
+	m_barriersCount = 0;
+}
+
+uint32_t RenderGraph::AddResource(bool external, uint32_t initialUsage)
+{
+	m_resources.push_back({ external, initialUsage, false, {}, NONE, NONE, NONE, NONE });
+	return (uint32_t)m_resources.size() - 1;
+}
+
+uint32_t RenderGraph::AddPass()
+{
+	m_passes.push_back({});
+	return (uint32_t)m_passes.size() - 1;
+}
+
+RenderGraph::Access& RenderGraph::AcquireAccess(uint32_t pass, uint32_t resource)
+{
+	ASSERTION(pass < m_passes.size() && resource < m_resources.size());
+
+	for (auto& access : m_passes[pass].accesses)
+	{
+		if (access.resource == resource)
+			return access;
+	}
+
+	m_passes[pass].accesses.push_back({ resource, 0, 0 });
+	return m_passes[pass].accesses.back();
+}
+
+void RenderGraph::AddDependency(uint32_t pass, uint32_t dependency)
+{
+	std::vector<uint32_t>& dependencies = m_passes[pass].dependencies;
+	if (dependency != NONE && dependency != pass && std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end())
+		dependencies.push_back(dependency);
+}
+
+void RenderGraph::Read(uint32_t pass, uint32_t resource, ResourceUsage usage)
+{
+	AcquireAccess(pass, resource).readUsages |= usage;
+}
+
+void RenderGraph::Write(uint32_t pass, uint32_t resource, ResourceUsage usage)
+{
+	Access& access = AcquireAccess(pass, resource);
+
+	// One pass writes a resource in one way only
+	ASSERTION(access.writeUsage == 0 || access.writeUsage == (uint32_t)usage);
+	access.writeUsage = usage;
+}
+
+void RenderGraph::SetResourceMemory(uint32_t resource, const ResourceMemory& memory)
+{
+	ASSERTION(resource < m_resources.size() && !m_resources[resource].external);
+
+	m_resources[resource].hasMemory = true;
+	m_resources[resource].memory = memory;
+}
+
+bool RenderGraph::LifetimesOverlap(uint32_t resource0, uint32_t resource1) const
+{
+	const Resource& r0 = m_resources[resource0];
+	const Resource& r1 = m_resources[resource1];
+
+	if (r0.firstPass == NONE || r1.firstPass == NONE)
+		return false;
+
+	return r0.firstPass <= r1.lastPass && r1.firstPass <= r0.lastPass;
+}
+
+bool RenderGraph::MemoryOverlaps(uint32_t resource0, uint32_t resource1) const
+{
+	const Resource& r0 = m_resources[resource0];
+	const Resource& r1 = m_resources[resource1];
+
+	if (!r0.hasMemory || !r1.hasMemory || r0.memory.heap != r1.memory.heap)
+		return false;
+
+	return r0.memory.offset < r1.memory.offset + r1.memory.size && r1.memory.offset < r0.memory.offset + r0.memory.size;
+}
+
+void RenderGraph::Compile()
+{
+	// Declaration order is program order: a resource could be written by more than one pass (bloom chain, aliased DOF layers),
+	// a read always refers to the latest write declared before it, so every dependency points forward
+	std::vector<uint32_t> lastWriter(m_resources.size(), NONE);
+	for (uint32_t i = 0; i < (uint32_t)m_passes.size(); i++)
+	{
+		Pass& pass = m_passes[i];
+		pass.producers.clear();
+		pass.live = false;
+
+		for (auto& access : pass.accesses)
+		{
+			if (access.readUsages != 0 && lastWriter[access.resource] != NONE)
+				pass.producers.push_back(lastWriter[access.resource]);
+		}
+
+		for (auto& access : pass.accesses)
+		{
+			if (access.writeUsage != 0)
+				lastWriter[access.resource] = i;
+		}
+	}
+
+	// Walk backwards from passes writing external resources, anything they don't depend on is culled
+	for (int32_t i = (int32_t)m_passes.size() - 1; i >= 0; i--)
+	{
+		Pass& pass = m_passes[i];
+		for (auto& access : pass.accesses)
+		{
+			if (access.writeUsage != 0 && m_resources[access.resource].external)
+				pass.live = true;
+		}
+
+		if (!pass.live)
+			continue;
+
+		for (uint32_t producer : pass.producers)
+			m_passes[producer].live = true;
+	}
+
+	for (auto& resource : m_resources)
+	{
+		resource.firstPass = NONE;
+		resource.lastPass = NONE;
+		resource.firstUse = NONE;
+		resource.lastUse = NONE;
+	}
+
+	std::vector<std::vector<uint32_t>> users(m_resources.size());
+	for (uint32_t i = 0; i < (uint32_t)m_passes.size(); i++)
+	{
+		if (!m_passes[i].live)
+			continue;
+
+		for (auto& access : m_passes[i].accesses)
+		{
+			Resource& resource = m_resources[access.resource];
+			if (resource.firstPass == NONE)
+				resource.firstPass = i;
+			resource.lastPass = i;
+			users[access.resource].push_back(i);
+		}
+	}
+
+	// Hazards between live passes, in declaration order: a read waits for last write, a write waits for last write and reads since.
+	// Reads of the same write don't depend on each other
+	std::vector<uint32_t> hazardWriter(m_resources.size(), NONE);
+	std::vector<std::vector<uint32_t>> hazardReaders(m_resources.size());
+	for (uint32_t i = 0; i < (uint32_t)m_passes.size(); i++)
+	{
+		Pass& pass = m_passes[i];
+		pass.dependencies.clear();
+		if (!pass.live)
+			continue;
+
+		for (auto& access : pass.accesses)
+		{
+			if (access.readUsages != 0)
+				AddDependency(i, hazardWriter[access.resource]);
+
+			if (access.writeUsage != 0)
+			{
+				AddDependency(i, hazardWriter[access.resource]);
+				for (uint32_t reader : hazardReaders[access.resource])
+					AddDependency(i, reader);
+
+				hazardWriter[access.resource] = i;
+				hazardReaders[access.resource].clear();
+			}
+			else
+				hazardReaders[access.resource].push_back(i);
+		}
+	}
+
+	// Resources sharing bytes are placed so that their lifetimes in declaration order don't overlap,
+	// every pass using the later one waits for every pass using the earlier one, whatever else sorting does
+	for (uint32_t r0 = 0; r0 < (uint32_t)m_resources.size(); r0++)
+	{
+		for (uint32_t r1 = 0; r1 < (uint32_t)m_resources.size(); r1++)
+		{
+			if (r0 == r1 || !MemoryOverlaps(r0, r1) || m_resources[r0].lastPass == NONE || m_resources[r1].firstPass == NONE
+				|| m_resources[r0].lastPass >= m_resources[r1].firstPass)
+				continue;
+
+			for (uint32_t i : users[r1])
+				for (uint32_t j : users[r0])
+					AddDependency(i, j);
+		}
+	}
+
+	// Every dependency is declared before, so levels are done in one pass: one above the highest dependency
+	// Sorting by level keeps each dependency ahead, passes of a level keep declaration order among themselves
+	m_levelsCount = 0;
+	m_executionOrder.clear();
+	for (uint32_t i = 0; i < (uint32_t)m_passes.size(); i++)
+	{
+		Pass& pass = m_passes[i];
+		pass.level = NONE;
+		if (!pass.live)
+			continue;
+
+		pass.level = 0;
+		for (uint32_t dependency : pass.dependencies)
+			pass.level = std::max(pass.level, m_passes[dependency].level + 1);
+
+		m_levelsCount = std::max(m_levelsCount, pass.level + 1);
+		m_executionOrder.push_back(i);
+	}
+
+	std::stable_sort(m_executionOrder.begin(), m_executionOrder.end(), [this](uint32_t p0, uint32_t p1)
+	{
+		return m_passes[p0].level < m_passes[p1].level;
+	});
+
+	for (uint32_t i = 0; i < (uint32_t)m_executionOrder.size(); i++)
+	{
+		for (auto& access : m_passes[m_executionOrder[i]].accesses)
+		{
+			Resource& resource = m_resources[access.resource];
+			if (resource.firstUse == NONE)
+				resource.firstUse = i;
+			resource.lastUse = i;
+		}
+	}
+
+	// Track each resource through live passes, a barrier is only needed when a write is involved:
+	// read after write, write after read or write after write. Reads after a read of the same kind are already covered
+	typedef struct _ResourceState
+	{
+		uint32_t	lastWriteUsage;
+		uint32_t	readUsages;		// Reads since last write
+	}ResourceState;
+
+	std::vector<ResourceState> states(m_resources.size());
+	for (uint32_t i = 0; i < (uint32_t)m_resources.size(); i++)
+		states[i] = { m_resources[i].initialUsage, 0 };
+
+	m_barriersCount = 0;
+	for (uint32_t i = 0; i < (uint32_t)m_executionOrder.size(); i++)
+	{
+		Pass& pass = m_passes[m_executionOrder[i]];
+		pass.barriers.clear();
+
+		for (auto& access : pass.accesses)
+		{
+			ResourceState& state = states[access.resource];
+
+			uint32_t srcUsages = 0;
+			uint32_t dstUsages = 0;
+			bool discard = false;
+
+			// First use of a resource sharing memory: every resource done with overlapping bytes has to finish with them
+			if (m_resources[access.resource].hasMemory && m_resources[access.resource].firstUse == i)
+			{
+				for (uint32_t j = 0; j < (uint32_t)m_resources.size(); j++)
+				{
+					if (j == access.resource || !MemoryOverlaps(access.resource, j) || m_resources[j].lastUse == NONE || m_resources[j].lastUse >= i)
+						continue;
+
+					srcUsages |= states[j].lastWriteUsage | states[j].readUsages;
+					discard = true;
+				}
+
+				if (discard)
+					dstUsages |= access.readUsages | access.writeUsage;
+			}
+
+			uint32_t newReads = access.readUsages & ~state.readUsages;
+			if (newReads != 0 && state.lastWriteUsage != 0)
+			{
+				srcUsages |= state.lastWriteUsage;
+				dstUsages |= newReads;
+			}
+
+			if (access.writeUsage != 0)
+			{
+				uint32_t prevUsages = state.readUsages != 0 ? state.readUsages : state.lastWriteUsage;
+				if (prevUsages != 0)
+				{
+					srcUsages |= prevUsages;
+					dstUsages |= access.writeUsage;
+				}
+
+				state.lastWriteUsage = access.writeUsage;
+				state.readUsages = 0;
+			}
+			else
+				state.readUsages |= access.readUsages;
+
+			if (srcUsages != 0)
+				pass.barriers.push_back({ access.resource, srcUsages, dstUsages, discard });
+		}
+
+		m_barriersCount += (uint32_t)pass.barriers.size();
+	}
+}
+
+std::vector<uint32_t> RenderGraph::PlaceResources()
+{
+	std::vector<uint32_t> resources;
+	for (uint32_t i = 0; i < (uint32_t)m_resources.size(); i++)
+	{
+		if (m_resources[i].hasMemory)
+			resources.push_back(i);
+	}
+
+	// Largest first, each one takes the lowest offset clear of placed resources alive at the same time
+	std::stable_sort(resources.begin(), resources.end(), [this](uint32_t r0, uint32_t r1)
+	{
+		return m_resources[r0].memory.size > m_resources[r1].memory.size;
+	});
+
+	std::vector<uint32_t> heapSizes;
+	std::vector<uint32_t> placed;
+	for (uint32_t resource : resources)
+	{
+		ResourceMemory& memory = m_resources[resource].memory;
+		ASSERTION(memory.alignment != 0);
+
+		memory.offset = 0;
+		bool moved = true;
+		while (moved)
+		{
+			moved = false;
+			for (uint32_t other : placed)
+			{
+				if (!LifetimesOverlap(resource, other) || !MemoryOverlaps(resource, other))
+					continue;
+
+				const ResourceMemory& otherMemory = m_resources[other].memory;
+				uint32_t end = otherMemory.offset + otherMemory.size;
+				memory.offset = (end + memory.alignment - 1) / memory.alignment * memory.alignment;
+				moved = true;
+			}
+		}
+
+		if (heapSizes.size() <= memory.heap)
+			heapSizes.resize(memory.heap + 1, 0);
+		heapSizes[memory.heap] = std::max(heapSizes[memory.heap], memory.offset + memory.size);
+
+		placed.push_back(resource);
+	}
+
+	return heapSizes;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Vulkan free description of a frame: passes declare resources they read and write, "Compile" works out which passes contribute
+// to the frame, the order they run in and barriers needed before each of them
+// Declaration order only matters where passes touch the same resource and one of them writes, or where resources share memory.
+// Passes are sorted topologically over those edges into dependency levels: passes of a level don't depend on each other,
+// so they could be recorded in parallel, and execution order is level after level
+// Passes and resources are plain indices, mapping them to render passes and images is up to caller, so the compiler could run on its own
+class RenderGraph
+{
+public:
+	enum ResourceUsage
+	{
+		ResourceUsage_ColorAttachment = 1 << 0,
+		ResourceUsage_DepthStencilAttachment = 1 << 1,
+		ResourceUsage_ShaderRead = 1 << 2,
+	};
+
+	typedef struct _Barrier
+	{
+		uint32_t	resource;
+		uint32_t	srcUsages;		// Combination of "ResourceUsage" that have to finish before
+		uint32_t	dstUsages;		// Combination of "ResourceUsage" that wait
+		bool		discard;		// Resource takes over memory of others, its previous content is undefined
+	}Barrier;
+
+	// Placement of a transient resource inside a memory heap shared with others
+	typedef struct _ResourceMemory
+	{
+		uint32_t	heap;
+		uint32_t	offset;
+		uint32_t	size;
+		uint32_t	alignment;
+	}ResourceMemory;
+
+public:
+	void Reset();
+
+	// "external" resources outlive the frame, e.g. swap chain images and history buffers, passes writing them are never culled
+	// "initialUsage" tells how resource was accessed before this frame, 0 if its content doesn't matter
+	uint32_t AddResource(bool external = false, uint32_t initialUsage = 0);
+	uint32_t AddPass();
+
+	void Read(uint32_t pass, uint32_t resource, ResourceUsage usage = ResourceUsage_ShaderRead);
+	void Write(uint32_t pass, uint32_t resource, ResourceUsage usage);
+
+	// Resources with memory live in shared heaps, "Compile" makes the first pass using one wait for whatever used overlapping bytes before
+	void SetResourceMemory(uint32_t resource, const ResourceMemory& memory);
+
+	void Compile();
+
+	// Give every resource with memory an offset in its heap, resources not alive at the same time could share bytes
+	// Lifetimes come from last "Compile", returns size of each heap
+	std::vector<uint32_t> PlaceResources();
+
+	// Live passes in the order they have to be executed, sorted by dependency level then declaration order
+	const std::vector<uint32_t>& GetExecutionOrder() const { return m_executionOrder; }
+	uint32_t GetPassLevel(uint32_t pass) const { return m_passes[pass].level; }
+	uint32_t GetLevelsCount() const { return m_levelsCount; }
+	const std::vector<uint32_t>& GetPassDependencies(uint32_t pass) const { return m_passes[pass].dependencies; }
+	const std::vector<Barrier>& GetPassBarriers(uint32_t pass) const { return m_passes[pass].barriers; }
+	bool IsPassCulled(uint32_t pass) const { return !m_passes[pass].live; }
+	uint32_t GetBarriersCount() const { return m_barriersCount; }
+	bool IsResourceExternal(uint32_t resource) const { return m_resources[resource].external; }
+	const ResourceMemory& GetResourceMemory(uint32_t resource) const { return m_resources[resource].memory; }
+
+protected:
+	static const uint32_t NONE = UINT32_MAX;
+
+	typedef struct _Access
+	{
+		uint32_t	resource;
+		uint32_t	readUsages;
+		uint32_t	writeUsage;
+	}Access;
+
+	typedef struct _Pass
+	{
+		std::vector<Access>		accesses;		// One per resource
+		std::vector<uint32_t>	producers;		// Passes whose output this pass reads
+		std::vector<uint32_t>	dependencies;	// Live passes that have to finish before this one, producers included
+		bool					live;
+		uint32_t				level;
+		std::vector<Barrier>	barriers;
+	}Pass;
+
+	typedef struct _Resource
+	{
+		bool			external;
+		uint32_t		initialUsage;
+		bool			hasMemory;
+		ResourceMemory	memory;
+		uint32_t		firstPass;		// Lifetime in declaration order, memory placement goes by it as it doesn't depend on sorting
+		uint32_t		lastPass;
+		uint32_t		firstUse;		// Lifetime in execution order, "NONE" if no live pass touches it
+		uint32_t		lastUse;
+	}Resource;
+
+	Access& AcquireAccess(uint32_t pass, uint32_t resource);
+	void AddDependency(uint32_t pass, uint32_t dependency);
+	bool LifetimesOverlap(uint32_t resource0, uint32_t resource1) const;
+	bool MemoryOverlaps(uint32_t resource0, uint32_t resource1) const;
+
+protected:
+	std::vector<Pass>		m_passes;
+	std::vector<Resource>	m_resources;
+	std::vector<uint32_t>	m_executionOrder;
+	uint32_t				m_levelsCount = 0;
+	uint32_t				m_barriersCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "RenderQueue.h"
+#include "Material.h"
+#include "Mesh.h"
+#include <cstring>
+
+void RenderQueue::Insert(uint32_t renderState, Material* pMaterial, Mesh* pMesh, const PerMaterialIndirectVariables& indirectVariables, uint32_t instanceCount, uint32_t startInstance, float depth)
+{
+	// Instance count greater than 1 means manually instanced rendering, which never merges with others
+	bool manualInstance = instanceCount > 1;
+
+	AcquireThreadBuffer().push_back
+	(
+		{
+			MakeSortKey(renderState, pMaterial->GetMaterialID(), pMesh->GetMeshID(), manualInstance, depth),
+			pMaterial,
+			pMesh,
+			indirectVariables,
+			instanceCount,
+			startInstance
+		}
+	);
+}
+
+uint64_t RenderQueue::MakeSortKey(uint32_t renderState, uint32_t materialID, uint32_t meshID, bool manualInstance, float depth)
+{
+	// Bit pattern of a non-negative float grows with its value, its top bits make a coarse but ordered depth
+	uint32_t depthBits = 0;
+	if (depth > 0)
+	{
+		std::memcpy(&depthBits, &depth, sizeof(float));
+		depthBits >>= 32 - DEPTH_BITS;
+	}
+
+	uint64_t key = renderState & ((1 << RENDER_STATE_BITS) - 1);
+	key = (key << MATERIAL_BITS) | (materialID & ((1 << MATERIAL_BITS) - 1));
+	key = (key << MESH_BITS) | (meshID & ((1 << MESH_BITS) - 1));
+	key = (key << MANUAL_INSTANCE_BITS) | (manualInstance ? 1 : 0);
+	key = (key << DEPTH_BITS) | depthBits;
+	return key;
+}
+
+std::vector<RenderQueue::RenderItem>& RenderQueue::AcquireThreadBuffer()
+{
+	// Registered once per thread, emission itself takes no lock
+	static thread_local std::vector<RenderItem>* pThreadBuffer = nullptr;
+
+	if (pThreadBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_threadBuffersMutex);
+		m_threadBuffers.push_back(std::make_shared<std::vector<RenderItem>>());
+		pThreadBuffer = m_threadBuffers.back().get();
+	}
+
+	return *pThreadBuffer;
+}
+
+void RenderQueue::Flush()
+{
+	m_items.clear();
+	for (auto& pThreadBuffer : m_threadBuffers)
+	{
+		m_items.insert(m_items.end(), pThreadBuffer->begin(), pThreadBuffer->end());
+		pThreadBuffer->clear();
+	}
+
+	m_sortEntries.resize(m_items.size());
+	for (uint32_t i = 0; i < (uint32_t)m_items.size(); i++)
+		m_sortEntries[i] = { m_items[i].sortKey, i };
+
+	RadixSort();
+
+	m_lastFlushItemsCount = (uint32_t)m_items.size();
+	m_lastFlushDrawsCount = 0;
+
+	uint32_t i = 0;
+	while (i < (uint32_t)m_sortEntries.size())
+	{
+		const RenderItem& item = m_items[m_sortEntries[i].itemIndex];
+		i++;
+
+		if (item.instanceCount > 1)
+		{
+			item.pMaterial->AppendIndirectDraw(item.pMesh, item.instanceCount, item.startInstance, &item.indirectVariables, 1);
+			m_lastFlushDrawsCount++;
+			continue;
+		}
+
+		// Auto instancing: run of items sharing material and mesh becomes one draw, ordered by depth within
+		// Pointers are compared rather than key bits, so that wrapped ids could only cost a batch, not merge different meshes
+		m_batchVariables.clear();
+		m_batchVariables.push_back(item.indirectVariables);
+
+		while (i < (uint32_t)m_sortEntries.size())
+		{
+			const RenderItem& next = m_items[m_sortEntries[i].itemIndex];
+			if (next.pMaterial != item.pMaterial || next.pMesh != item.pMesh || next.instanceCount > 1)
+				break;
+
+			m_batchVariables.push_back(next.indirectVariables);
+			i++;
+		}
+
+		item.pMaterial->AppendIndirectDraw(item.pMesh, (uint32_t)m_batchVariables.size(), item.startInstance, m_batchVariables.data(), (uint32_t)m_batchVariables.size());
+		m_lastFlushDrawsCount++;
+	}
+}
+
+void RenderQueue::RadixSort()
+{
+	if (m_sortEntries.size() == 0)
+		return;
+
+	// LSD radix sort, 8 bits per pass, stable so that items of equal key keep their emission order
+	m_sortScratch.resize(m_sortEntries.size());
+
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		uint32_t histogram[256] = {};
+		for (auto& entry : m_sortEntries)
+			histogram[(entry.sortKey >> shift) & 0xff]++;
+
+		// Every key shares this digit, nothing to move
+		if (histogram[(m_sortEntries[0].sortKey >> shift) & 0xff] == (uint32_t)m_sortEntries.size())
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < 256; digit++)
+		{
+			uint32_t count = histogram[digit];
+			histogram[digit] = offset;
+			offset += count;
+		}
+
+		for (auto& entry : m_sortEntries)
+			m_sortScratch[histogram[(entry.sortKey >> shift) & 0xff]++] = entry;
+
+		m_sortEntries.swap(m_sortScratch);
+	}
+}
\ No newline at end of file
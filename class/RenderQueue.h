@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "PerMaterialIndirectUniforms.h"
+#include <vector>
+#include <mutex>
+
+class Material;
+class Mesh;
+
+// Frame wide queue of everything that goes through indirect draws
+// Renderers emit one item per material per object, each tagged by a 64 bits sort key, into a linear buffer owned by the emitting thread
+// At sync time items of all threads are radix sorted by key, consecutive items with the same material and mesh are merged into one
+// auto instanced indirect draw, and the draws are handed over to their materials
+class RenderQueue : public Singleton<RenderQueue>
+{
+public:
+	// Sort key layout, from most significant bit:
+	// render state(4) | material id(12) | mesh id(23) | manual instanced(1) | depth(24)
+	static const uint32_t DEPTH_BITS = 24;
+	static const uint32_t MANUAL_INSTANCE_BITS = 1;
+	static const uint32_t MESH_BITS = 23;
+	static const uint32_t MATERIAL_BITS = 12;
+	static const uint32_t RENDER_STATE_BITS = 4;
+
+	typedef struct _RenderItem
+	{
+		uint64_t						sortKey;
+		Material*						pMaterial;
+		Mesh*							pMesh;
+		PerMaterialIndirectVariables	indirectVariables;
+		uint32_t						instanceCount;
+		uint32_t						startInstance;
+	}RenderItem;
+
+public:
+	// Thread safe, each thread writes into its own buffer
+	// Raw pointers are kept until "Flush", material and mesh have to stay alive until then
+	void Insert(uint32_t renderState, Material* pMaterial, Mesh* pMesh, const PerMaterialIndirectVariables& indirectVariables, uint32_t instanceCount, uint32_t startInstance, float depth);
+
+	// Sort, batch and append indirect draws of all queued items to their materials, then empty the queue
+	// Must not run concurrently with "Insert"
+	void Flush();
+
+	uint32_t GetLastFlushItemsCount() const { return m_lastFlushItemsCount; }
+	uint32_t GetLastFlushDrawsCount() const { return m_lastFlushDrawsCount; }
+
+	static uint64_t MakeSortKey(uint32_t renderState, uint32_t materialID, uint32_t meshID, bool manualInstance, float depth);
+
+protected:
+	typedef struct _SortEntry
+	{
+		uint64_t	sortKey;
+		uint32_t	itemIndex;
+	}SortEntry;
+
+	std::vector<RenderItem>& AcquireThreadBuffer();
+	void RadixSort();
+
+protected:
+	std::mutex												m_threadBuffersMutex;
+	std::vector<std::shared_ptr<std::vector<RenderItem>>>	m_threadBuffers;
+
+	// Scratch data reused from frame to frame, so that a steady state frame allocates nothing
+	std::vector<RenderItem>									m_items;
+	std::vector<SortEntry>									m_sortEntries;
+	std::vector<SortEntry>									m_sortScratch;
+	std::vector<PerMaterialIndirectVariables>				m_batchVariables;
+
+	uint32_t												m_lastFlushItemsCount = 0;
+	uint32_t												m_lastFlushDrawsCount = 0;
+};
\ No newline at end of file
@@ -22,6 +22,70 @@
 #include "DOFMaterial.h"
 #include "GBufferPlanetMaterial.h"
 #include "MaterialInstance.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "GPUCuller.h"
+#include "UniformData.h"
+#include "ShaderLibrary.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/FrameManager.h"
+#include "../vulkan/PerFrameResource.h"
+#include "../vulkan/PipelineCache.h"
+#include "../vulkan/GraphicPipeline.h"
+#include "../vulkan/DescriptorAllocator.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../thread/ThreadTaskQueue.hpp"
+#include "RenderPassBase.h"
+#include <chrono>
+#include <iostream>
+
+// Skinned meshes use quantized vertices, shader variants with "PACKED_VERTEX" read them
+// Needs "pbr_gbuffer_gen_skinned_packed.vert.spv" and "shadow_map_gen_skinned_packed.vert.spv" compile_all_shader.py generates
+bool PACKED_SKINNED_VERTEX = false;
+
+// Record secondary command buffers of materials on worker threads, turn off to record them all on main thread for comparison
+bool PARALLEL_CMD_RECORDING = true;
+
+// Let transient frame buffer targets share memory when render graph finds their lifetimes don't overlap
+bool ALIAS_TRANSIENT_ATTACHMENTS = true;
+
+// Print transient attachment memory before and after aliasing whenever frame buffers are recreated
+bool LOG_TRANSIENT_ATTACHMENTS = false;
+
+// Compile material pipelines on worker threads after all materials are set up, rather than one by one while creating them
+bool PARALLEL_PIPELINE_CREATION = true;
+
+// Print material setup and pipeline creation times, and how pipeline cache was loaded and saved
+bool LOG_PIPELINE_CREATION = false;
+
+// Print how many shader modules were created, shared or read from archive once materials are set up
+bool LOG_SHADER_LOADING = false;
+
+// Print shared descriptor set layouts, pools and descriptor writes once materials are set up
+bool LOG_DESCRIPTOR_ALLOCATION = false;
+
+// Frustum cull static meshes of GBuffer pass on GPU, a compute pass compacts indirect draws right before render passes
+// Needs "gpu_culling.comp.spv" compile_all_shader.py generates
+bool GPU_DRIVEN_CULLING = false;
+
+// GPU driven culling also tests against Hi-Z pyramid built after last frame's GBuffer pass
+bool HIZ_OCCLUSION_CULLING = true;
+
+// Whether every shader binary a feature needs is there, prints which one is missing so that feature isn't left off silently
+static bool ContainsShaders(const std::vector<std::wstring>& shaderPaths, const char* pFeatureName)
+{
+	for (auto& path : shaderPaths)
+	{
+		if (ShaderLibrary::GetInstance()->Contains(path))
+			continue;
+
+		std::cout << pFeatureName << " is off, \"" << std::string(path.begin(), path.end()) << "\" is missing, run compile_all_shader.py" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static_assert(RenderWorkManager::ShadowMapGenCascade3 - RenderWorkManager::ShadowMapGen + 1 == SHADOW_CASCADE_COUNT, "One shadow map render state per cascade");
 
 enum MaterialEnum
 {
@@ -52,13 +116,27 @@ bool RenderWorkManager::Init()
 	if (!Singleton<RenderWorkManager>::Init())
 		return false;
 
+	// Create render queue up front, so that renderers emitting from worker threads never race on its creation
+	RenderQueue::GetInstance();
+
+	// Materials bind frame buffer targets at creation, aliased ones have to be in place before that
+	if (ALIAS_TRANSIENT_ATTACHMENTS)
+		AliasTransientAttachments();
+
+	bool packedSkinnedVertex = PACKED_SKINNED_VERTEX && ContainsShaders(
+		{ L"../data/shaders/pbr_gbuffer_gen_skinned_packed.vert.spv", L"../data/shaders/shadow_map_gen_skinned_packed.vert.spv" }, "PACKED_SKINNED_VERTEX");
+	bool gpuDrivenCulling = GPU_DRIVEN_CULLING && ContainsShaders({ L"../data/shaders/gpu_culling.comp.spv" }, "GPU_DRIVEN_CULLING");
+
+	auto materialStart = std::chrono::high_resolution_clock::now();
+	GraphicPipeline::DeferCreation(PARALLEL_PIPELINE_CREATION);
+
 	m_materials.resize(MaterialEnumCount);
 	for (uint32_t i = 0; i < MaterialEnumCount; i++)
 	{
 		switch ((MaterialEnum)i)
 		{
-		case PBRGBuffer:		m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial()} }; break;
-		case PBRSkinnedGBuffer: m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial(true) } }; break;
+		case PBRGBuffer:		m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial(false, false, gpuDrivenCulling)} }; break;
+		case PBRSkinnedGBuffer: m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial(true, packedSkinnedVertex) } }; break;
 		case PBRPlanetGBuffer:	m_materials[i] = { { GBufferPlanetMaterial::CreateDefaultMaterial() } }; break;
 		case BackgroundMotion:	
 		{
@@ -78,8 +156,17 @@ bool RenderWorkManager::Init()
 
 		case MotionTileMax:		m_materials[i] = { { MotionTileMaxMaterial::CreateDefaultMaterial() } }; break;
 		case MotionNeighborMax:	m_materials[i] = { { MotionNeighborMaxMaterial::CreateDefaultMaterial() } }; break;
-		case Shadow:			m_materials[i] = { { ShadowMapMaterial::CreateDefaultMaterial() } }; break;
-		case SkinnedShadow:		m_materials[i] = { { ShadowMapMaterial::CreateDefaultMaterial(true) } }; break;
+		// One material per shadow cascade, so that each cascade pass draws only what's been queued for it
+		case Shadow:
+		{
+			for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; j++)
+				m_materials[i].materialSet.push_back(ShadowMapMaterial::CreateDefaultMaterial());
+		}break;
+		case SkinnedShadow:
+		{
+			for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; j++)
+				m_materials[i].materialSet.push_back(ShadowMapMaterial::CreateDefaultMaterial(true, packedSkinnedVertex));
+		}break;
 		case SSAO:				m_materials[i] = { { SSAOMaterial::CreateDefaultMaterial() } }; break;
 		case SSAOBlurV:			m_materials[i] = { { GaussianBlurMaterial::CreateDefaultMaterial(FrameBufferDiction::FrameBufferType_SSAOSSR, FrameBufferDiction::FrameBufferType_SSAOBlurV, RenderPassDiction::PipelineRenderPassSSAOBlurV,{ true, 1, 1 }) } }; break;
 		case SSAOBlurH:			m_materials[i] = { { GaussianBlurMaterial::CreateDefaultMaterial(FrameBufferDiction::FrameBufferType_SSAOBlurV, FrameBufferDiction::FrameBufferType_SSAOBlurH, RenderPassDiction::PipelineRenderPassSSAOBlurH,{ false, 1, 1 }) } }; break;
@@ -131,6 +218,38 @@ bool RenderWorkManager::Init()
 		}
 	}
 
+	GraphicPipeline::DeferCreation(false);
+
+	auto pipelineStart = std::chrono::high_resolution_clock::now();
+	double compileTime = GraphicPipeline::CreateDeferredPipelines();
+	auto pipelineEnd = std::chrono::high_resolution_clock::now();
+
+	uint32_t savedBytes = GlobalPipelineCache()->Save();
+
+	// Without parallel creation pipelines are compiled within material setup
+	if (LOG_PIPELINE_CREATION)
+	{
+		std::cout << "Material setup: " << std::chrono::duration<double, std::milli>(pipelineStart - materialStart).count() << "ms, "
+			<< "pipeline creation: " << std::chrono::duration<double, std::milli>(pipelineEnd - pipelineStart).count() << "ms wall, " << compileTime << "ms summed, "
+			<< "pipeline cache: " << (GlobalPipelineCache()->IsLoadedFromDisk() ? "loaded " : "rebuilt ") << GlobalPipelineCache()->GetLoadedBytes() << " bytes, saved " << savedBytes << " bytes\n";
+	}
+
+	if (LOG_SHADER_LOADING)
+	{
+		const ShaderLibrary::LoadStatistics& shaderStatistics = ShaderLibrary::GetInstance()->GetLoadStatistics();
+		std::cout << "Shaders: " << shaderStatistics.requestsCount << " requested, " << shaderStatistics.modulesCreated << " modules created, " << shaderStatistics.modulesShared << " shared, "
+			<< shaderStatistics.archiveHits << " from archive, " << shaderStatistics.filesMapped << " files mapped, " << shaderStatistics.bytesLoaded / 1024 << "KB, " << shaderStatistics.loadTime << "ms\n";
+	}
+
+	if (LOG_DESCRIPTOR_ALLOCATION)
+	{
+		const DescriptorAllocator::AllocatorStatistics& descriptorStatistics = GlobalDescriptorAllocator()->GetStatistics();
+		DescriptorSet::UpdateStatistics updateStatistics = DescriptorSet::GetUpdateStatistics();
+		std::cout << "Descriptor set layouts: " << descriptorStatistics.layoutRequests << " requested, " << descriptorStatistics.layoutsCreated << " created, "
+			<< "sets: " << descriptorStatistics.setsAllocated << " from " << descriptorStatistics.poolsCreated << " pools, "
+			<< "descriptors written: " << updateStatistics.descriptorsWritten << " in " << updateStatistics.updateCalls << " updates\n";
+	}
+
 	return true;
 }
 
@@ -155,17 +274,19 @@ std::shared_ptr<MaterialInstance> RenderWorkManager::AcquirePBRPlanetMaterialIns
 	return pMaterialInstance;
 }
 
-std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireShadowMaterialInstance() const
+std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireShadowMaterialInstance(uint32_t cascade) const
 {
-	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(Shadow)->CreateMaterialInstance();
-	pMaterialInstance->SetRenderMask(1 << ShadowMapGen);
+	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(Shadow, cascade)->CreateMaterialInstance();
+	pMaterialInstance->SetRenderMask(1 << (ShadowMapGen + cascade));
+	pMaterialInstance->SetParameter("CascadeIndex", (float)cascade);
 	return pMaterialInstance;
 }
 
-std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireSkinnedShadowMaterialInstance() const
+std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireSkinnedShadowMaterialInstance(uint32_t cascade) const
 {
-	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(SkinnedShadow)->CreateMaterialInstance();
-	pMaterialInstance->SetRenderMask(1 << ShadowMapGen);
+	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(SkinnedShadow, cascade)->CreateMaterialInstance();
+	pMaterialInstance->SetRenderMask(1 << (ShadowMapGen + cascade));
+	pMaterialInstance->SetParameter("CascadeIndex", (float)cascade);
 	return pMaterialInstance;
 }
 
@@ -178,6 +299,17 @@ std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireSkyBoxMaterialInstan
 
 void RenderWorkManager::SyncMaterialData()
 {
+	// Visible renderers insert what they've held back for scene pass, then queue hands over sorted and batched draws
+	// to materials before they upload indirect data
+	FrustumCuller::GetInstance()->Flush();
+	RenderQueue::GetInstance()->Flush();
+
+	// This frame's pyramid is built later during "Draw", culling goes with the one before it
+	std::shared_ptr<GBufferInputUniforms> pGBufferInput = UniformData::GetInstance()->GetGBufferInputUniforms();
+	uint32_t pyramid = pGBufferInput->GetLastBuiltHiZPyramid();
+	GPUCuller::GetInstance()->SetOcclusionPyramid(pyramid == UINT32_MAX ? 0 : pyramid, pGBufferInput->GetHiZWidth(), pGBufferInput->GetHiZHeight(),
+		HIZ_OCCLUSION_CULLING && pyramid != UINT32_MAX ? pGBufferInput->GetHiZLevelCount() : 0);
+
 	for (auto& materialSet : m_materials)
 	{
 		for (auto pMaterial : materialSet.materialSet)
@@ -187,137 +319,421 @@ void RenderWorkManager::SyncMaterialData()
 	}
 }
 
-void RenderWorkManager::Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+uint32_t RenderWorkManager::AcquireGraphResource(const std::shared_ptr<Image>& pImage, bool external, uint32_t initialUsage)
+{
+	auto it = m_graphResourceTable.find(pImage.get());
+	if (it != m_graphResourceTable.end())
+		return it->second;
+
+	uint32_t resource = m_renderGraph.AddResource(external, initialUsage);
+	m_graphResourceTable[pImage.get()] = resource;
+	m_graphImages.push_back(pImage);
+
+	uint32_t heap, offset, size;
+	if (FrameBufferDiction::GetInstance()->GetAliasedPlacement(pImage.get(), heap, offset, size))
+		m_renderGraph.SetResourceMemory(resource, { heap, offset, size, 1 });
+
+	return resource;
+}
+
+uint32_t RenderWorkManager::AddGraphPass(RenderPassDiction::PipelineRenderPass renderPass, const std::shared_ptr<FrameBuffer>& pFrameBuffer, const std::vector<std::vector<PassDraw>>& subpasses, bool external, uint32_t initialUsage)
+{
+	uint32_t pass = m_renderGraph.AddPass();
+	ASSERTION(pass == (uint32_t)m_passes.size());
+	m_passes.push_back({ renderPass, pFrameBuffer, subpasses, 0 });
+
+	for (auto& pColorTarget : pFrameBuffer->GetColorTargets())
+		m_renderGraph.Write(pass, AcquireGraphResource(pColorTarget, external, initialUsage), RenderGraph::ResourceUsage_ColorAttachment);
+
+	if (pFrameBuffer->GetDepthStencilTarget() != nullptr)
+		m_renderGraph.Write(pass, AcquireGraphResource(pFrameBuffer->GetDepthStencilTarget(), external, initialUsage), RenderGraph::ResourceUsage_DepthStencilAttachment);
+
+	return pass;
+}
+
+void RenderWorkManager::ReadGraphImage(uint32_t pass, const std::shared_ptr<Image>& pImage, bool external, uint32_t initialUsage)
 {
-	GetMaterial(PBRGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRPlanetGBuffer)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(BackgroundMotion)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
-	GetMaterial(PBRGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	GetMaterial(PBRPlanetGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->NextSubpass(pDrawCmdBuffer);
-	GetMaterial(BackgroundMotion)->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(BackgroundMotion)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRPlanetGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(PBRGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(MotionTileMax)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionTileMax)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionTileMax));
-	GetMaterial(MotionTileMax)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionTileMax), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionTileMax)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(MotionTileMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(MotionNeighborMax)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionNeighborMax)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionNeighborMax));
-	GetMaterial(MotionNeighborMax)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionNeighborMax), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassMotionNeighborMax)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(MotionNeighborMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(Shadow)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(SkinnedShadow)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap));
-	GetMaterial(Shadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
-	GetMaterial(SkinnedShadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SkinnedShadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(Shadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(SSAO)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOSSR)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOSSR));
-	GetMaterial(SSAO)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOSSR), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOSSR)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SSAO)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(SSAOBlurV)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurV)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurV));
-	GetMaterial(SSAOBlurV)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurV), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurV)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SSAOBlurV)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(SSAOBlurH)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurH)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurH));
-	GetMaterial(SSAOBlurH)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurH), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassSSAOBlurH)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SSAOBlurH)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(DeferredShading)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(SkyBox)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading));
-	GetMaterial(DeferredShading)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->NextSubpass(pDrawCmdBuffer);
-	GetMaterial(SkyBox)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShading)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SkyBox)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(DeferredShading)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-
-
-	GetMaterial(TemporalResolve, pingpong)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassTemporalResolve)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (FrameMgr()->FrameIndex() + 1) % GetSwapChain()->GetSwapChainImageCount(), (pingpong + 1) % 2));
-	GetMaterial(TemporalResolve, pingpong)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (FrameMgr()->FrameIndex() + 1) % GetSwapChain()->GetSwapChainImageCount(), (pingpong + 1) % 2));
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassTemporalResolve)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(TemporalResolve, pingpong)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	m_renderGraph.Read(pass, AcquireGraphResource(pImage, external, initialUsage));
+}
+
+void RenderWorkManager::PreparePasses(uint32_t pingpong)
+{
+	m_passes.clear();
+	m_renderGraph.Reset();
+	m_graphImages.clear();
+	m_graphResourceTable.clear();
+
+	std::shared_ptr<FrameBuffer> pGBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer);
+	std::shared_ptr<FrameBuffer> pMotionTileMax = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionTileMax);
+	std::shared_ptr<FrameBuffer> pMotionNeighborMax = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_MotionNeighborMax);
+	std::shared_ptr<FrameBuffer> pShadowMaps[SHADOW_CASCADE_COUNT];
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		pShadowMaps[i] = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap, i);
+	std::shared_ptr<FrameBuffer> pSSAOSSR = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOSSR);
+	std::shared_ptr<FrameBuffer> pSSAOBlurV = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurV);
+	std::shared_ptr<FrameBuffer> pSSAOBlurH = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurH);
+	std::shared_ptr<FrameBuffer> pShading = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Shading);
+	std::shared_ptr<FrameBuffer> pTemporalHistory = FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, pingpong);
+	std::shared_ptr<FrameBuffer> pTemporalResult = FrameBufferDiction::GetInstance()->GetPingPongFrameBuffer(FrameBufferDiction::FrameBufferType_TemporalResolve, (FrameMgr()->FrameIndex() + 1) % GetSwapChain()->GetSwapChainImageCount(), (pingpong + 1) % 2);
+	std::shared_ptr<FrameBuffer> pCombineResult = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_CombineResult);
+
+	uint32_t pass = AddGraphPass
+	(
+		RenderPassDiction::PipelineRenderPassGBuffer,
+		pGBuffer,
+		{
+			{ { PBRGBuffer, 0, false }, { PBRSkinnedGBuffer, 0, false }, { PBRPlanetGBuffer, 0, false } },
+			{ { BackgroundMotion, 0, true } }
+		}
+	);
+
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassMotionTileMax, pMotionTileMax, { { { MotionTileMax, 0, false } } });
+	ReadGraphImage(pass, pGBuffer->GetColorTarget(FrameBufferDiction::MotionVector));
+
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassMotionNeighborMax, pMotionNeighborMax, { { { MotionNeighborMax, 0, false } } });
+	ReadGraphImage(pass, pMotionTileMax->GetColorTarget(0));
+
+	// A cached cascade isn't rendered every frame, its depth target keeps what an earlier frame with the same index rendered
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		if ((m_renderStateMask & (1 << (ShadowMapGen + i))) != 0)
+			AddGraphPass(RenderPassDiction::PipelineRenderPassShadowMap, pShadowMaps[i], { { { Shadow, i, false }, { SkinnedShadow, i, false } } });
+	}
+
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassSSAOSSR, pSSAOSSR, { { { SSAO, 0, false } } });
+	ReadGraphImage(pass, pGBuffer->GetColorTarget(FrameBufferDiction::GBuffer0));
+	ReadGraphImage(pass, pGBuffer->GetColorTarget(FrameBufferDiction::GBuffer2));
+	ReadGraphImage(pass, pGBuffer->GetDepthStencilTarget());
+
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassSSAOBlurV, pSSAOBlurV, { { { SSAOBlurV, 0, false } } });
+	ReadGraphImage(pass, pSSAOSSR->GetColorTarget(0));
+
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassSSAOBlurH, pSSAOBlurH, { { { SSAOBlurH, 0, false } } });
+	ReadGraphImage(pass, pSSAOBlurV->GetColorTarget(0));
+
+	// Shading frame buffer shares depth with GBuffer, so it shows up as both sampled and attached here
+	pass = AddGraphPass
+	(
+		RenderPassDiction::PipelineRenderPassShading,
+		pShading,
+		{
+			{ { DeferredShading, 0, false } },
+			{ { SkyBox, 0, false } }
+		}
+	);
+	for (uint32_t i = 0; i < FrameBufferDiction::GBufferCount; i++)
+		ReadGraphImage(pass, pGBuffer->GetColorTarget(i));
+	ReadGraphImage(pass, pGBuffer->GetDepthStencilTarget());
+	ReadGraphImage(pass, pSSAOBlurH->GetColorTarget(0));
+	ReadGraphImage(pass, pSSAOSSR->GetColorTarget(1));
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		ReadGraphImage(pass, pShadowMaps[i]->GetDepthStencilTarget());
+
+	// Temporal buffers live across frames: history was rendered last frame, result was sampled as history last frame
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassTemporalResolve, pTemporalResult, { { { TemporalResolve, pingpong, false } } }, true, RenderGraph::ResourceUsage_ShaderRead);
+	ReadGraphImage(pass, pGBuffer->GetColorTarget(FrameBufferDiction::MotionVector));
+	ReadGraphImage(pass, pGBuffer->GetColorTarget(FrameBufferDiction::GBuffer1));
+	ReadGraphImage(pass, pShading->GetColorTarget(0));
+	ReadGraphImage(pass, pShading->GetColorTarget(1));
+	ReadGraphImage(pass, pMotionNeighborMax->GetColorTarget(0));
+	for (auto& pHistory : pTemporalHistory->GetColorTargets())
+		ReadGraphImage(pass, pHistory, true, RenderGraph::ResourceUsage_ColorAttachment);
 
 	for (uint32_t i = 0; i < DOFMaterial::DOFPass_Count; i++)
 	{
-		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, i);
-		Vector2ui size = { pTargetFrameBuffer->GetFramebufferInfo().width, pTargetFrameBuffer->GetFramebufferInfo().height };
-
-		GetMaterial(DepthOfField, i)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassDOF)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
-		GetMaterial(DepthOfField, i)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassDOF)->EndRenderPass(pDrawCmdBuffer);
-		GetMaterial(DepthOfField, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		pass = AddGraphPass(RenderPassDiction::PipelineRenderPassDOF, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, i), { { { DepthOfField, i, false } } });
+
+		switch (i)
+		{
+		case DOFMaterial::DOFPass_Prefilter:
+			ReadGraphImage(pass, pTemporalResult->GetColorTarget(FrameBufferDiction::CombinedResult));
+			ReadGraphImage(pass, pTemporalResult->GetColorTarget(FrameBufferDiction::CoC));
+			break;
+		case DOFMaterial::DOFPass_Blur:
+			ReadGraphImage(pass, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, DOFMaterial::DOFPass_Prefilter)->GetColorTarget(0));
+			break;
+		case DOFMaterial::DOFPass_Postfilter:
+			ReadGraphImage(pass, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, DOFMaterial::DOFPass_Blur)->GetColorTarget(0));
+			break;
+		case DOFMaterial::DOFPass_Combine:
+			ReadGraphImage(pass, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, DOFMaterial::DOFPass_Postfilter)->GetColorTarget(0));
+			ReadGraphImage(pass, pTemporalResult->GetColorTarget(FrameBufferDiction::CombinedResult));
+			break;
+		default:
+			ASSERTION(false);
+			break;
+		}
 	}
 
+	std::shared_ptr<Image> pDOFResult = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::CombineLayer)->GetColorTarget(0);
+
 	// Downsample first
 	for (uint32_t i = 0; i < BLOOM_ITER_COUNT; i++)
 	{
-		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i + 1);
-		Vector2ui size = { pTargetFrameBuffer->GetFramebufferInfo().width, pTargetFrameBuffer->GetFramebufferInfo().height };
-
-		GetMaterial(BloomDownSample, i)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
-		GetMaterial(BloomDownSample, i)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->EndRenderPass(pDrawCmdBuffer);
-		GetMaterial(BloomDownSample, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		pass = AddGraphPass(RenderPassDiction::PipelineRenderPassBloom, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i + 1), { { { BloomDownSample, i, false } } });
+		ReadGraphImage(pass, i == 0 ? pDOFResult : FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i)->GetColorTarget(0));
 	}
 
-	// Upsample then
 	for (int32_t i = BLOOM_ITER_COUNT - 1; i >= 0; i--)
 	{
-		std::shared_ptr<FrameBuffer> pTargetFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i);
-		Vector2ui size = { pTargetFrameBuffer->GetFramebufferInfo().width, pTargetFrameBuffer->GetFramebufferInfo().height };
-
-		GetMaterial(BloomUpSample, i)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->BeginRenderPass(pDrawCmdBuffer, pTargetFrameBuffer);
-		GetMaterial(BloomUpSample, i)->Draw(pDrawCmdBuffer, pTargetFrameBuffer, pingpong);
-		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassBloom)->EndRenderPass(pDrawCmdBuffer);
-		GetMaterial(BloomUpSample, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		pass = AddGraphPass(RenderPassDiction::PipelineRenderPassBloom, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i), { { { BloomUpSample, (uint32_t)i, false } } });
+		ReadGraphImage(pass, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, i + 1)->GetColorTarget(0));
+	}
+
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassCombine, pCombineResult, { { { Combine, 0, false } } });
+	ReadGraphImage(pass, pDOFResult);
+	ReadGraphImage(pass, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_Bloom, 0)->GetColorTarget(0));
+
+	// Swap chain image goes to presentation
+	pass = AddGraphPass(RenderPassDiction::PipelineRenderPassPostProcessing, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing), { { { PostProcess, 0, false } } }, true);
+	ReadGraphImage(pass, pCombineResult->GetColorTarget(0));
+	ReadGraphImage(pass, pMotionNeighborMax->GetColorTarget(0));
+
+	m_renderGraph.Compile();
+}
+
+void RenderWorkManager::AliasTransientAttachments()
+{
+	// Passes don't touch materials when declared, lifetimes are the same for every frame and ping pong index
+	PreparePasses(0);
+
+	// Candidates are color targets created per frame, external ones and depth stencil buffers keep memory of their own
+	std::vector<uint32_t> resources;
+	std::vector<FrameBufferDiction::AliasedTarget> targets;
+	std::vector<VkMemoryRequirements> heaps;
+	uint32_t bytesBeforeAliasing = 0;
+
+	for (uint32_t resource = 0; resource < (uint32_t)m_graphImages.size(); resource++)
+	{
+		FrameBufferDiction::TargetSlot slot;
+		if (m_renderGraph.IsResourceExternal(resource) || !FrameBufferDiction::GetInstance()->FindColorTarget(m_graphImages[resource], slot))
+			continue;
+
+		VkMemoryRequirements reqs = m_graphImages[resource]->GetMemoryReqirments();
+
+		// Images only share a heap if they agree on memory types
+		uint32_t heap = 0;
+		while (heap < (uint32_t)heaps.size() && heaps[heap].memoryTypeBits != reqs.memoryTypeBits)
+			heap++;
+		if (heap == (uint32_t)heaps.size())
+			heaps.push_back({ 0, 0, reqs.memoryTypeBits });
+
+		m_renderGraph.SetResourceMemory(resource, { heap, 0, (uint32_t)reqs.size, (uint32_t)reqs.alignment });
+		resources.push_back(resource);
+		targets.push_back({ slot, heap, 0 });
+		bytesBeforeAliasing += (uint32_t)reqs.size;
+	}
+
+	std::vector<uint32_t> heapSizes = m_renderGraph.PlaceResources();
+
+	uint32_t bytesAfterAliasing = 0;
+	for (uint32_t i = 0; i < (uint32_t)heapSizes.size(); i++)
+	{
+		heaps[i].size = heapSizes[i];
+		bytesAfterAliasing += heapSizes[i];
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)targets.size(); i++)
+		targets[i].offset = m_renderGraph.GetResourceMemory(resources[i]).offset;
+
+	// Old targets are held here, let them go before frame buffers are recreated
+	m_passes.clear();
+	m_renderGraph.Reset();
+	m_graphImages.clear();
+	m_graphResourceTable.clear();
+
+	FrameBufferDiction::GetInstance()->AliasColorTargets(targets, heaps);
+
+	if (LOG_TRANSIENT_ATTACHMENTS)
+	{
+		const double MB = 1024.0 * 1024.0;
+		std::cout << "Transient attachments: " << targets.size() << " targets, "
+			<< bytesBeforeAliasing / MB << "MB per frame before aliasing, "
+			<< bytesAfterAliasing / MB << "MB after, in " << heaps.size() << " heaps, "
+			<< GetSwapChain()->GetSwapChainImageCount() << " frames" << std::endl;
 	}
+}
 
-	GetMaterial(Combine)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassCombine)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_CombineResult));
-	GetMaterial(Combine)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_CombineResult), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassCombine)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(Combine)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+static VkPipelineStageFlags GetUsageStages(uint32_t usages)
+{
+	VkPipelineStageFlags stages = 0;
+	if (usages & RenderGraph::ResourceUsage_ColorAttachment)
+		stages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	if (usages & RenderGraph::ResourceUsage_DepthStencilAttachment)
+		stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	if (usages & RenderGraph::ResourceUsage_ShaderRead)
+		stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	return stages;
+}
 
+static VkAccessFlags GetUsageAccess(uint32_t usages)
+{
+	VkAccessFlags access = 0;
+	if (usages & RenderGraph::ResourceUsage_ColorAttachment)
+		access |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	if (usages & RenderGraph::ResourceUsage_DepthStencilAttachment)
+		access |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	if (usages & RenderGraph::ResourceUsage_ShaderRead)
+		access |= VK_ACCESS_SHADER_READ_BIT;
+	return access;
+}
+
+void RenderWorkManager::AttachPassBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pass)
+{
+	const std::vector<RenderGraph::Barrier>& barriers = m_renderGraph.GetPassBarriers(pass);
+	if (barriers.size() == 0)
+		return;
+
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	std::vector<VkImageMemoryBarrier> imgBarriers;
 
-	GetMaterial(PostProcess)->BeforeRenderPass(pDrawCmdBuffer, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing));
-	GetMaterial(PostProcess)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(PostProcess)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	for (auto& barrier : barriers)
+	{
+		std::shared_ptr<Image> pImage = m_graphImages[barrier.resource];
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = pImage->GetImageInfo().mipLevels;
+		subresourceRange.layerCount = pImage->GetImageInfo().arrayLayers;
+
+		if (pImage->GetImageInfo().format == VK_FORMAT_D24_UNORM_S8_UINT
+			|| pImage->GetImageInfo().format == VK_FORMAT_D32_SFLOAT_S8_UINT)
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+		if (pImage->GetImageInfo().format == VK_FORMAT_D32_SFLOAT)
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+		// Every pipeline render pass leaves its targets in shader read layout, layout transitions are done by render passes
+		// Reads don't make anything available, so they only take part as execution dependency
+		// An image taking over aliased memory has nothing worth keeping, it starts from undefined layout
+		VkImageMemoryBarrier imgBarrier = {};
+		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imgBarrier.image = pImage->GetDeviceHandle();
+		imgBarrier.subresourceRange = subresourceRange;
+		imgBarrier.oldLayout = barrier.discard ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imgBarrier.srcAccessMask = GetUsageAccess(barrier.srcUsages & ~RenderGraph::ResourceUsage_ShaderRead);
+		imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imgBarrier.dstAccessMask = GetUsageAccess(barrier.dstUsages);
+
+		imgBarriers.push_back(imgBarrier);
+
+		srcStages |= GetUsageStages(barrier.srcUsages);
+		dstStages |= GetUsageStages(barrier.dstUsages);
+	}
+
+	pCmdBuf->AttachBarriers
+	(
+		srcStages,
+		dstStages,
+		{},
+		{},
+		imgBarriers
+	);
+}
+
+void RenderWorkManager::RecordSecondaryCmds(uint32_t pingpong)
+{
+	// Every draw gets a fixed slot in pass order, so whichever thread records it, primary executes them in the same order
+	m_recordJobs.clear();
+	for (uint32_t passIndex : m_renderGraph.GetExecutionOrder())
+	{
+		Pass& pass = m_passes[passIndex];
+		pass.firstSlot = (uint32_t)m_recordJobs.size();
+		for (auto& subpass : pass.subpasses)
+			for (auto& draw : subpass)
+				m_recordJobs.push_back({ draw, pass.pFrameBuffer });
+	}
+
+	m_secondaryCmds.assign(m_recordJobs.size(), nullptr);
+	m_recordingTimes.assign(m_recordJobs.size(), 0);
+
+	auto wallStart = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < (uint32_t)m_recordJobs.size(); i++)
+	{
+		ThreadJobFunc job = [this, i, pingpong](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			const RecordJob& recordJob = m_recordJobs[i];
+			if (recordJob.draw.screenQuad)
+				m_secondaryCmds[i] = GetMaterial(recordJob.draw.material, recordJob.draw.index)->RecordScreenQuadCmd(pPerFrameRes, recordJob.pFrameBuffer, pingpong);
+			else
+				m_secondaryCmds[i] = GetMaterial(recordJob.draw.material, recordJob.draw.index)->RecordDrawCmd(pPerFrameRes, recordJob.pFrameBuffer, pingpong);
+
+			m_recordingTimes[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		// Worker threads record with command pools of their own per frame resource
+		if (PARALLEL_CMD_RECORDING)
+			FrameMgr()->AddJobToFrame(job);
+		else
+			job(MainThreadPerFrameRes());
+	}
+
+	if (PARALLEL_CMD_RECORDING)
+		GlobalThreadTaskQueue()->WaitForFree();
+
+	m_recordingStatistics.secondaryCmdCount = (uint32_t)m_recordJobs.size();
+	m_recordingStatistics.recordingTime = 0;
+	for (double recordingTime : m_recordingTimes)
+		m_recordingStatistics.recordingTime += recordingTime;
+	m_recordingStatistics.wallTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - wallStart).count();
+}
+
+void RenderWorkManager::Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
+{
+	PreparePasses(pingpong);
+	RecordSecondaryCmds(pingpong);
+
+	// Compute work can't go inside render passes, so all culling dispatches are done before the first one
+	for (uint32_t passIndex : m_renderGraph.GetExecutionOrder())
+		for (auto& subpass : m_passes[passIndex].subpasses)
+			for (auto& draw : subpass)
+				GetMaterial(draw.material, draw.index)->DispatchCulling(pDrawCmdBuffer);
+
+	// Primary command buffer is recorded on main thread only, in the order render graph works out, culled passes are skipped
+	std::vector<std::shared_ptr<CommandBuffer>> subpassCmds;
+	for (uint32_t passIndex : m_renderGraph.GetExecutionOrder())
+	{
+		const Pass& pass = m_passes[passIndex];
+		std::shared_ptr<RenderPassBase> pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(pass.renderPass);
+
+		// Barriers come from render graph instead of materials
+		AttachPassBarriers(pDrawCmdBuffer, passIndex);
+
+		uint32_t slot = pass.firstSlot;
+		pRenderPass->BeginRenderPass(pDrawCmdBuffer, pass.pFrameBuffer);
+		for (uint32_t i = 0; i < (uint32_t)pass.subpasses.size(); i++)
+		{
+			if (i > 0)
+				pRenderPass->NextSubpass(pDrawCmdBuffer);
+
+			subpassCmds.clear();
+			for (uint32_t j = 0; j < (uint32_t)pass.subpasses[i].size(); j++, slot++)
+			{
+				if (m_secondaryCmds[slot] != nullptr)
+					subpassCmds.push_back(m_secondaryCmds[slot]);
+			}
+
+			if (subpassCmds.size() > 0)
+				pDrawCmdBuffer->Execute(subpassCmds);
+		}
+		pRenderPass->EndRenderPass(pDrawCmdBuffer);
+
+		// Depth is complete once GBuffer pass ends, anything after it could read the pyramid
+		if (pass.renderPass == RenderPassDiction::PipelineRenderPassGBuffer)
+			UniformData::GetInstance()->GetGBufferInputUniforms()->BuildHiZPyramid(pDrawCmdBuffer, pass.pFrameBuffer->GetDepthStencilTarget());
+
+		for (auto subpass = pass.subpasses.rbegin(); subpass != pass.subpasses.rend(); subpass++)
+			for (auto draw = subpass->rbegin(); draw != subpass->rend(); draw++)
+				GetMaterial(draw->material, draw->index)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	}
+
+	// Primary command buffer keeps references of those it executes
+	m_secondaryCmds.clear();
 }
 
 void RenderWorkManager::OnFrameBegin()
@@ -340,4 +756,13 @@ void RenderWorkManager::OnFrameEnd()
 			pMaterial->OnFrameEnd();
 		}
 	}
+
+	m_lastFrameLodStatistics = m_lodStatistics;
+	m_lodStatistics = {};
+}
+
+void RenderWorkManager::AddLodStatistics(uint32_t trianglesBeforeLod, uint32_t trianglesAfterLod)
+{
+	m_lodStatistics.trianglesBeforeLod += trianglesBeforeLod;
+	m_lodStatistics.trianglesAfterLod += trianglesAfterLod;
 }
\ No newline at end of file
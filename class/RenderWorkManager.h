@@ -3,8 +3,11 @@
 #include "../common/Singleton.h"
 #include "../vulkan/RenderPass.h"
 #include "RenderPassDiction.h"
+#include "RenderGraph.h"
+#include <unordered_map>
 
 class FrameBuffer;
+class Image;
 class Texture2D;
 class DepthStencilBuffer;
 class GBufferMaterial;
@@ -38,7 +41,10 @@ public:
 		ReflectionGen,
 		BrdfLutGen,
 		Scene,
-		ShadowMapGen,
+		ShadowMapGen,			// Shadow cascade i is drawn in "ShadowMapGen + i"
+		ShadowMapGenCascade1,
+		ShadowMapGenCascade2,
+		ShadowMapGenCascade3,
 		RenderStateCount
 	};
 
@@ -78,8 +84,9 @@ public:
 	std::shared_ptr<MaterialInstance> AcquirePBRMaterialInstance() const;
 	std::shared_ptr<MaterialInstance> AcquirePBRSkinnedMaterialInstance() const;
 	std::shared_ptr<MaterialInstance> AcquirePBRPlanetMaterialInstance() const;
-	std::shared_ptr<MaterialInstance> AcquireShadowMaterialInstance() const;
-	std::shared_ptr<MaterialInstance> AcquireSkinnedShadowMaterialInstance() const;
+	// A shadow casting renderer needs one of these per shadow cascade
+	std::shared_ptr<MaterialInstance> AcquireShadowMaterialInstance(uint32_t cascade) const;
+	std::shared_ptr<MaterialInstance> AcquireSkinnedShadowMaterialInstance(uint32_t cascade) const;
 	std::shared_ptr<MaterialInstance> AcquireSkyBoxMaterialInstance() const;
 
 	void SyncMaterialData();
@@ -88,6 +95,28 @@ public:
 	void OnFrameBegin();
 	void OnFrameEnd();
 
+	// Triangles submitted to render queues, with full detail meshes and with selected LODs
+	typedef struct _LodStatistics
+	{
+		uint32_t	trianglesBeforeLod;
+		uint32_t	trianglesAfterLod;
+	}LodStatistics;
+
+	void AddLodStatistics(uint32_t trianglesBeforeLod, uint32_t trianglesAfterLod);
+
+	// Statistics of last finished frame
+	const LodStatistics& GetLodStatistics() const { return m_lastFrameLodStatistics; }
+
+	// Secondary command buffer recording of last "Draw", times are in milliseconds
+	typedef struct _RecordingStatistics
+	{
+		uint32_t	secondaryCmdCount;
+		double		recordingTime;		// Sum of time each secondary command buffer takes to record
+		double		wallTime;			// From the first recording issued till the last one done
+	}RecordingStatistics;
+
+	const RecordingStatistics& GetRecordingStatistics() const { return m_recordingStatistics; }
+
 protected:
 	// Since there could be some mutants of the same material class
 	// We encapsulate these one or more materials into "MaterialSet"
@@ -99,6 +128,55 @@ protected:
 
 	std::shared_ptr<Material>	GetMaterial(MaterialEnum materialEnum, uint32_t index = 0) const { return m_materials[materialEnum].GetMaterial(index); }
 
+	// Materials are referred by enum, so passes could be declared before materials exist
+	typedef struct _PassDraw
+	{
+		MaterialEnum	material;
+		uint32_t		index;
+		bool			screenQuad;		// Draw a screen quad no matter how material draws itself
+	}PassDraw;
+
+	// A render pass of current frame, "subpasses" lists draws of each subpass in the order they're executed
+	typedef struct _Pass
+	{
+		RenderPassDiction::PipelineRenderPass	renderPass;
+		std::shared_ptr<FrameBuffer>			pFrameBuffer;
+		std::vector<std::vector<PassDraw>>		subpasses;
+		uint32_t								firstSlot;		// Slot of its first draw in "m_secondaryCmds"
+	}Pass;
+
+	typedef struct _RecordJob
+	{
+		PassDraw						draw;
+		std::shared_ptr<FrameBuffer>	pFrameBuffer;
+	}RecordJob;
+
+	// Add a pass to both "m_passes" and render graph, all targets of "pFrameBuffer" are declared as written by it
+	// "external" and "initialUsage" apply to targets seen by render graph for the first time
+	uint32_t AddGraphPass(RenderPassDiction::PipelineRenderPass renderPass, const std::shared_ptr<FrameBuffer>& pFrameBuffer, const std::vector<std::vector<PassDraw>>& subpasses, bool external = false, uint32_t initialUsage = 0);
+	void ReadGraphImage(uint32_t pass, const std::shared_ptr<Image>& pImage, bool external = false, uint32_t initialUsage = 0);
+	uint32_t AcquireGraphResource(const std::shared_ptr<Image>& pImage, bool external, uint32_t initialUsage);
+	void AttachPassBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pass);
+
+	void PreparePasses(uint32_t pingpong);
+	// Place transient color targets whose lifetimes don't overlap into shared memory, frame buffers holding them are recreated
+	void AliasTransientAttachments();
+	void RecordSecondaryCmds(uint32_t pingpong);
+
 	std::vector<MaterialSet>	m_materials;
-	uint32_t					m_renderStateMask;
+	uint32_t					m_renderStateMask = 0;
+
+	LodStatistics				m_lodStatistics = {};
+	LodStatistics				m_lastFrameLodStatistics = {};
+
+	std::vector<Pass>			m_passes;
+	// Passes of "m_passes" share indices with render graph passes
+	RenderGraph					m_renderGraph;
+	std::vector<std::shared_ptr<Image>>			m_graphImages;			// Indexed by render graph resource
+	std::unordered_map<Image*, uint32_t>		m_graphResourceTable;	// Aliased frame buffer targets map to the same resource
+	// Draws of "m_passes" flattened in execution order, each recording job writes only to its own slot
+	std::vector<RecordJob>		m_recordJobs;
+	std::vector<std::shared_ptr<CommandBuffer>>	m_secondaryCmds;
+	std::vector<double>			m_recordingTimes;
+	RecordingStatistics			m_recordingStatistics = {};
 };
\ No newline at end of file
@@ -203,73 +203,7 @@ void SSAOMaterial::CustomizeMaterialLayout(std::vector<UniformVarList>& material
 	});
 }
 
-void SSAOMaterial::CustomizePoolSize(std::vector<uint32_t>& counts)
-{
-	counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += (GetSwapChain()->GetSwapChainImageCount() * (FrameBufferDiction::GBufferCount + 1));
-}
-
 void SSAOMaterial::CustomizeSecondaryCmd(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong)
 {
 	pCmdBuf->PushConstants(m_pPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float), &m_blueNoiseTexIndex);
-}
-
-void SSAOMaterial::AttachResourceBarriers(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong)
-{
-	std::shared_ptr<Image> pGBuffer0 = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[FrameMgr()->FrameIndex()]->GetColorTarget(FrameBufferDiction::GBuffer0);
-	std::shared_ptr<Image> pGBuffer2 = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[FrameMgr()->FrameIndex()]->GetColorTarget(FrameBufferDiction::GBuffer2);
-	std::shared_ptr<Image> pDepth = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[FrameMgr()->FrameIndex()]->GetDepthStencilTarget();
-
-	VkImageSubresourceRange subresourceRange0 = {};
-	subresourceRange0.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange0.baseMipLevel = 0;
-	subresourceRange0.levelCount = pGBuffer0->GetImageInfo().mipLevels;
-	subresourceRange0.layerCount = pGBuffer0->GetImageInfo().arrayLayers;
-
-	VkImageMemoryBarrier imgBarrier0 = {};
-	imgBarrier0.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier0.image = pGBuffer0->GetDeviceHandle();
-	imgBarrier0.subresourceRange = subresourceRange0;
-	imgBarrier0.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier0.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier0.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier0.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	VkImageSubresourceRange subresourceRange1 = {};
-	subresourceRange1.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange1.baseMipLevel = 0;
-	subresourceRange1.levelCount = pGBuffer2->GetImageInfo().mipLevels;
-	subresourceRange1.layerCount = pGBuffer2->GetImageInfo().arrayLayers;
-
-	VkImageMemoryBarrier imgBarrier1 = {};
-	imgBarrier1.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier1.image = pGBuffer2->GetDeviceHandle();
-	imgBarrier1.subresourceRange = subresourceRange1;
-	imgBarrier1.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier1.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier1.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier1.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	VkImageSubresourceRange subresourceRange2 = {};
-	subresourceRange2.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-	subresourceRange2.baseMipLevel = 0;
-	subresourceRange2.levelCount = pDepth->GetImageInfo().mipLevels;
-	subresourceRange2.layerCount = pDepth->GetImageInfo().arrayLayers;
-
-	VkImageMemoryBarrier imgBarrier2 = {};
-	imgBarrier2.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier2.image = pDepth->GetDeviceHandle();
-	imgBarrier2.subresourceRange = subresourceRange2;
-	imgBarrier2.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier2.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-	imgBarrier2.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier2.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		{},
-		{},
-		{ imgBarrier0, imgBarrier1, imgBarrier2 }
-	);
 }
\ No newline at end of file
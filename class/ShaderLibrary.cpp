@@ -0,0 +1,142 @@
+#include "ShaderLibrary.h"
+#include "../common/MappedFile.h"
+#include "../common/Macros.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include <chrono>
+#include <codecvt>
+#include <fstream>
+#include <locale>
+
+// Load SPIR-V from the archive "compile_all_shader.py" writes, it has to be run again whenever a shader changes
+bool USE_SHADER_ARCHIVE = false;
+
+static const char* SHADER_ARCHIVE_PATH = "../data/shaders/shaders.vlsa";
+
+bool ShaderLibrary::Init()
+{
+	if (!Singleton<ShaderLibrary>::Init())
+		return false;
+
+	if (USE_SHADER_ARCHIVE)
+		LoadArchive(SHADER_ARCHIVE_PATH);
+
+	return true;
+}
+
+bool ShaderLibrary::LoadArchive(const std::string& path)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::shared_ptr<MappedFile> pArchive = MappedFile::Create(path);
+	if (pArchive == nullptr || pArchive->GetSize() < sizeof(ArchiveHeader))
+		return false;
+
+	const uint8_t* pData = pArchive->GetData();
+	const ArchiveHeader* pHeader = (const ArchiveHeader*)pData;
+	if (pHeader->magic != ARCHIVE_MAGIC || pHeader->version != ARCHIVE_VERSION)
+		return false;
+
+	if (sizeof(ArchiveHeader) + (uint64_t)pHeader->entriesCount * sizeof(ArchiveEntry) > pArchive->GetSize())
+		return false;
+
+	std::string folder = path.substr(0, path.find_last_of("/\\") + 1);
+
+	const ArchiveEntry* pEntries = (const ArchiveEntry*)(pData + sizeof(ArchiveHeader));
+	for (uint32_t i = 0; i < pHeader->entriesCount; i++)
+	{
+		const ArchiveEntry& entry = pEntries[i];
+		if ((uint64_t)entry.nameOffset + entry.nameLength > pArchive->GetSize() || (uint64_t)entry.codeOffset + entry.codeBytes > pArchive->GetSize())
+			return false;
+
+		m_archiveEntries[folder + std::string((const char*)pData + entry.nameOffset, entry.nameLength)] = &entry;
+	}
+
+	m_pArchive = pArchive;
+	m_loadStatistics.filesMapped++;
+	m_loadStatistics.loadTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	return true;
+}
+
+uint64_t ShaderLibrary::HashCode(const uint8_t* pCode, uint32_t codeBytes)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t i = 0; i < codeBytes; i++)
+	{
+		hash ^= pCode[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ShaderLibrary::Contains(const std::wstring& path) const
+{
+	std::string narrowPath = std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(path);
+	if (m_archiveEntries.find(narrowPath) != m_archiveEntries.end())
+		return true;
+
+	return std::ifstream(narrowPath, std::ios::binary).good();
+}
+
+std::shared_ptr<ShaderModule> ShaderLibrary::AcquireShaderModule(const std::wstring& path, ShaderModule::ShaderType type, const std::string& entryName)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	m_loadStatistics.requestsCount++;
+
+	std::wstring requestKey = path + L"|" + std::to_wstring((uint32_t)type) + L"|" + std::wstring(entryName.begin(), entryName.end());
+	auto request = m_requests.find(requestKey);
+	if (request != m_requests.end())
+	{
+		m_loadStatistics.modulesShared++;
+		return request->second;
+	}
+
+	const uint8_t* pCode = nullptr;
+	uint32_t codeBytes = 0;
+
+	// Mapping of a loose file only has to live until module is created
+	std::shared_ptr<MappedFile> pMappedFile;
+	std::string narrowPath = std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(path);
+
+	auto archiveEntry = m_archiveEntries.find(narrowPath);
+	if (archiveEntry != m_archiveEntries.end())
+	{
+		pCode = m_pArchive->GetData() + archiveEntry->second->codeOffset;
+		codeBytes = archiveEntry->second->codeBytes;
+		m_loadStatistics.archiveHits++;
+	}
+	else
+	{
+		pMappedFile = MappedFile::Create(narrowPath);
+		ASSERTION(pMappedFile != nullptr);
+
+		pCode = pMappedFile->GetData();
+		codeBytes = (uint32_t)pMappedFile->GetSize();
+		m_loadStatistics.filesMapped++;
+	}
+
+	m_loadStatistics.bytesLoaded += codeBytes;
+
+	// Different paths could hold same SPIR-V, e.g. one shader compiled under several names
+	ModuleKey moduleKey = { HashCode(pCode, codeBytes), codeBytes, type, entryName };
+	std::shared_ptr<ShaderModule> pModule;
+
+	auto module = m_modules.find(moduleKey);
+	if (module != m_modules.end())
+	{
+		pModule = module->second;
+		m_loadStatistics.modulesShared++;
+	}
+	else
+	{
+		pModule = ShaderModule::Create(GetDevice(), path, (const uint32_t*)pCode, codeBytes, type, entryName);
+		m_modules[moduleKey] = pModule;
+		m_loadStatistics.modulesCreated++;
+	}
+
+	m_requests[requestKey] = pModule;
+	m_loadStatistics.loadTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	return pModule;
+}
\ No newline at end of file
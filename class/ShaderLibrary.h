@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "../vulkan/ShaderModule.h"
+#include <map>
+#include <string>
+
+class MappedFile;
+
+// Every shader module goes through here: SPIR-V files are memory mapped rather than read, modules of identical content are
+// created once and shared by all materials using them
+// With "USE_SHADER_ARCHIVE", SPIR-V comes from one archive mapped at startup, written by "compile_all_shader.py" next to the shaders
+// Shaders missing from archive are still loaded from their own file
+// Not thread safe, materials are created on main thread
+class ShaderLibrary : public Singleton<ShaderLibrary>
+{
+public:
+	// Archive layout: header, entries, names, SPIR-V of each entry aligned to 4 bytes
+	static const uint32_t ARCHIVE_MAGIC = 0x41534c56;	// "VLSA"
+	static const uint32_t ARCHIVE_VERSION = 1;
+
+	typedef struct _ArchiveHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	entriesCount;
+		uint32_t	reserved;
+	}ArchiveHeader;
+
+	typedef struct _ArchiveEntry
+	{
+		uint32_t	nameOffset;		// File name only, relative to archive folder
+		uint32_t	nameLength;
+		uint32_t	codeOffset;
+		uint32_t	codeBytes;
+	}ArchiveEntry;
+
+	typedef struct _LoadStatistics
+	{
+		uint32_t	requestsCount;
+		uint32_t	filesMapped;
+		uint32_t	archiveHits;
+		uint32_t	modulesCreated;
+		uint32_t	modulesShared;		// Requests served by an existing module, same path or same content
+		uint64_t	bytesLoaded;
+		double		loadTime;			// ms
+	}LoadStatistics;
+
+public:
+	bool Init();
+
+public:
+	std::shared_ptr<ShaderModule> AcquireShaderModule(const std::wstring& path, ShaderModule::ShaderType type, const std::string& entryName);
+
+	// Whether SPIR-V of "path" is in archive or on disk, e.g. a shader variant only compile_all_shader.py generates
+	bool Contains(const std::wstring& path) const;
+
+	const LoadStatistics& GetLoadStatistics() const { return m_loadStatistics; }
+	uint32_t GetArchiveEntriesCount() const { return (uint32_t)m_archiveEntries.size(); }
+
+protected:
+	bool LoadArchive(const std::string& path);
+
+	static uint64_t HashCode(const uint8_t* pCode, uint32_t codeBytes);
+
+protected:
+	typedef struct _ModuleKey
+	{
+		uint64_t					hash;
+		uint32_t					codeBytes;
+		ShaderModule::ShaderType	type;
+		std::string					entryName;
+
+		bool operator < (const _ModuleKey& key) const
+		{
+			if (hash != key.hash) return hash < key.hash;
+			if (codeBytes != key.codeBytes) return codeBytes < key.codeBytes;
+			if (type != key.type) return type < key.type;
+			return entryName < key.entryName;
+		}
+	}ModuleKey;
+
+	std::shared_ptr<MappedFile>										m_pArchive;
+	// Key: path as materials refer to it, e.g. "../data/shaders/sky_box.vert.spv"
+	std::map<std::string, const ArchiveEntry*>						m_archiveEntries;
+
+	std::map<ModuleKey, std::shared_ptr<ShaderModule>>				m_modules;
+	// Key: path, type and entry name of a request already served
+	std::map<std::wstring, std::shared_ptr<ShaderModule>>			m_requests;
+
+	LoadStatistics													m_loadStatistics = {};
+};
\ No newline at end of file
@@ -13,13 +13,20 @@
 #include "RenderPassDiction.h"
 #include "../common/Util.h"
 
-std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool skinned)
+std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool skinned, bool packedVertex)
 {
 	SimpleMaterialCreateInfo simpleMaterialInfo = {};
-	std::wstring vert = skinned ? L"../data/shaders/shadow_map_gen_skinned.vert.spv" : L"../data/shaders/shadow_map_gen.vert.spv";
+	std::wstring vert = skinned ? L"../data/shaders/shadow_map_gen_skinned" : L"../data/shaders/shadow_map_gen";
+	vert += packedVertex ? L"_packed.vert.spv" : L".vert.spv";
 	simpleMaterialInfo.shaderPaths = { vert, L"", L"", L"", L"", L"" };
+
+	// Shadow cascade an instance draws into, which picks light matrix in shader
+	simpleMaterialInfo.materialUniformVars = { { OneUnit, "CascadeIndex" } };
 	simpleMaterialInfo.vertexFormat = skinned ? (1 << VAFPosition) | (1 << VAFBone) : (1 << VAFPosition);
-	simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+	if (packedVertex)
+		simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTBPacked : VertexFormatPNTCTPacked;
+	else
+		simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
 	simpleMaterialInfo.subpassIndex = 0;
 	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_ShadowMap;
 	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap);
@@ -4,12 +4,12 @@
 class ShadowMapMaterial : public Material
 {
 public:
-	static std::shared_ptr<ShadowMapMaterial> CreateDefaultMaterial(bool skinned = false);
+	static std::shared_ptr<ShadowMapMaterial> CreateDefaultMaterial(bool skinned = false, bool packedVertex = false);
 
 public:
 	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, const Vector3d& groupNum, const Vector3d& groupSize, uint32_t pingpong = 0) override {}
-	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
+	std::shared_ptr<CommandBuffer> RecordDrawCmd(const std::shared_ptr<PerFrameResource>& pPerFrameRes, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
 	{
-		DrawIndirect(pCmdBuf, pFrameBuffer, pingpong, overrideVP);
+		return RecordIndirectCmd(pPerFrameRes, pFrameBuffer, pingpong, overrideVP);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "StreamingManager.h"
+#include "Mesh.h"
+#include "../vulkan/SharedIndexBuffer.h"
+#include "../common/Util.h"
+
+bool StreamingManager::Init()
+{
+	if (!Singleton<StreamingManager>::Init())
+		return false;
+
+	m_loader = std::thread(&StreamingManager::LoaderLoop, this);
+	return true;
+}
+
+StreamingManager::~StreamingManager()
+{
+	if (!m_loader.joinable())
+		return;
+
+	std::unique_lock<std::mutex> lock(m_loaderMutex);
+	m_isDestroying = true;
+	lock.unlock();
+	m_loaderCondition.notify_one();
+	m_loader.join();
+}
+
+uint32_t StreamingManager::RegisterResource(uint64_t sizeInBytes, bool resident, const std::function<void()>& load, const std::function<void()>& evict)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32_t resource = m_scheduler.RegisterResource(sizeInBytes, resident);
+	if (resource >= (uint32_t)m_callbacks.size())
+		m_callbacks.resize(resource + 1);
+	m_callbacks[resource] = { load, evict };
+
+	return resource;
+}
+
+uint32_t StreamingManager::AcquireMeshResource(const std::shared_ptr<Mesh>& pMesh)
+{
+	// Vertex buffer and whole index buffer, LODs are ranges within it
+	uint64_t sizeInBytes = (uint64_t)pMesh->GetVerticesCount() * pMesh->GetVertexBytes();
+	sizeInBytes += (uint64_t)pMesh->GetIndexBuffer()->GetCount() * GetIndexBytes(pMesh->GetIndexBuffer()->GetType());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_meshResources.find(pMesh->GetMeshID());
+	if (it != m_meshResources.end())
+		return it->second.resource;
+
+	uint32_t resource = m_scheduler.RegisterResource(sizeInBytes, true);
+	if (resource >= (uint32_t)m_callbacks.size())
+		m_callbacks.resize(resource + 1);
+	m_callbacks[resource] = {};
+
+	m_meshResources[pMesh->GetMeshID()] = { pMesh, resource };
+	return resource;
+}
+
+void StreamingManager::ReportVisibility(uint32_t resource, double screenCoverage, double distance, bool visible)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_scheduler.ReportVisibility(resource, screenCoverage, distance, visible);
+}
+
+bool StreamingManager::IsResident(uint32_t resource) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_scheduler.IsResident(resource);
+}
+
+void StreamingManager::SetBudget(uint64_t budgetBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	StreamingScheduler::Settings settings = m_scheduler.GetSettings();
+	settings.budgetBytes = budgetBytes;
+	m_scheduler.SetSettings(settings);
+}
+
+void StreamingManager::Update()
+{
+	std::vector<uint32_t> landedLoads;
+	{
+		std::lock_guard<std::mutex> loaderLock(m_loaderMutex);
+		landedLoads.swap(m_landedLoads);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (uint32_t resource : landedLoads)
+		m_scheduler.OnLoaded(resource);
+
+	// Meshes gone since last update give their memory back, unless a load of theirs is still in flight
+	for (auto it = m_meshResources.begin(); it != m_meshResources.end();)
+	{
+		if (it->second.pMesh.expired() && !m_scheduler.IsLoading(it->second.resource))
+		{
+			m_scheduler.UnregisterResource(it->second.resource);
+			m_callbacks[it->second.resource] = {};
+			it = m_meshResources.erase(it);
+		}
+		else
+			it++;
+	}
+
+	m_scheduler.Update();
+	m_lastUpdateStatistics = m_scheduler.GetLastUpdateStatistics();
+
+	if (m_scheduler.GetRequests().size() == 0)
+		return;
+
+	std::unique_lock<std::mutex> loaderLock(m_loaderMutex);
+	for (auto& request : m_scheduler.GetRequests())
+	{
+		const Callbacks& callbacks = m_callbacks[request.resource];
+		m_loaderJobs.push_back({ request.resource, request.type, request.type == StreamingScheduler::RequestType_Load ? callbacks.load : callbacks.evict });
+	}
+	loaderLock.unlock();
+	m_loaderCondition.notify_one();
+}
+
+void StreamingManager::LoaderLoop()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(m_loaderMutex);
+		m_loaderCondition.wait(lock, [this]() { return !m_loaderJobs.empty() || m_isDestroying; });
+
+		if (m_isDestroying)
+			return;
+
+		LoaderJob job = m_loaderJobs.front();
+		m_loaderJobs.pop_front();
+		lock.unlock();
+
+		// Requests run one at a time in the order they're issued, an evict making room always goes before the load it's for
+		if (job.work != nullptr)
+			job.work();
+
+		if (job.type == StreamingScheduler::RequestType_Load)
+		{
+			lock.lock();
+			m_landedLoads.push_back(job.resource);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "StreamingScheduler.h"
+#include <vector>
+#include <map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+class Mesh;
+
+// Keeps meshes and texture array slots of "GlobalTextures" resident by what main camera sees, within a memory budget
+// Renderers report screen coverage and distance once culling is done, "Update" runs "StreamingScheduler" once per frame and hands
+// its requests over to a loader thread in the order they're issued, loads landed there are adopted by next "Update"
+class StreamingManager : public Singleton<StreamingManager>
+{
+public:
+	bool Init() override;
+	~StreamingManager();
+
+	// "load" and "evict" run on loader thread, either could be null for data that's kept in memory anyway
+	// Registration is fine from any thread, e.g. import threads creating meshes
+	uint32_t RegisterResource(uint64_t sizeInBytes, bool resident, const std::function<void()>& load = nullptr, const std::function<void()>& evict = nullptr);
+
+	// One resource per mesh shared by its LODs, registered on first call and given up once mesh is gone
+	// Meshes have no way to reload their buffers, so they're registered resident and evicts only count
+	uint32_t AcquireMeshResource(const std::shared_ptr<Mesh>& pMesh);
+
+	// Main thread only, after culling and before "Update"
+	void ReportVisibility(uint32_t resource, double screenCoverage, double distance, bool visible);
+
+	bool IsResident(uint32_t resource) const;
+
+	void SetBudget(uint64_t budgetBytes);
+
+	// Called once per frame after visibility pass
+	void Update();
+
+	const StreamingScheduler::Statistics& GetLastUpdateStatistics() const { return m_lastUpdateStatistics; }
+
+protected:
+	void LoaderLoop();
+
+	typedef struct _Callbacks
+	{
+		std::function<void()>	load;
+		std::function<void()>	evict;
+	}Callbacks;
+
+	typedef struct _LoaderJob
+	{
+		uint32_t					resource;
+		StreamingScheduler::RequestType	type;
+		std::function<void()>		work;
+	}LoaderJob;
+
+	typedef struct _MeshResource
+	{
+		std::weak_ptr<Mesh>	pMesh;
+		uint32_t			resource;
+	}MeshResource;
+
+protected:
+	mutable std::mutex						m_mutex;			// Guards scheduler and registration
+	StreamingScheduler						m_scheduler;
+	std::vector<Callbacks>					m_callbacks;		// Indexed by resource
+	std::map<uint32_t, MeshResource>		m_meshResources;	// Key: mesh id
+	StreamingScheduler::Statistics			m_lastUpdateStatistics = {};
+
+	std::thread								m_loader;
+	std::mutex								m_loaderMutex;		// Guards everything below
+	std::condition_variable					m_loaderCondition;
+	std::deque<LoaderJob>					m_loaderJobs;
+	std::vector<uint32_t>					m_landedLoads;
+	bool									m_isDestroying = false;
+};
\ No newline at end of file
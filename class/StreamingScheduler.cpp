@@ -0,0 +1,204 @@
+#include "StreamingScheduler.h"
+#include "../common/Macros.h"
+#include <algorithm>
+#include <cmath>
+
+const uint32_t StreamingScheduler::NONE;
+const StreamingScheduler::Settings StreamingScheduler::DEFAULT_SETTINGS = { 512ull << 20, 4, 0.25, 0.9 };
+const double StreamingScheduler::MIN_PRIORITY = 1e-6;
+const double StreamingScheduler::EVICT_PRIORITY_RATIO = 1.25;
+
+uint32_t StreamingScheduler::RegisterResource(uint64_t sizeInBytes, bool resident)
+{
+	uint32_t resource;
+	if (m_freeResources.size() != 0)
+	{
+		resource = m_freeResources.back();
+		m_freeResources.pop_back();
+	}
+	else
+	{
+		resource = (uint32_t)m_resources.size();
+		m_resources.push_back({});
+	}
+
+	m_resources[resource] = { sizeInBytes, 0, 0, -1, 0, false, resident, false, true };
+
+	if (resident)
+		m_residentBytes += sizeInBytes;
+
+	return resource;
+}
+
+void StreamingScheduler::UnregisterResource(uint32_t resource)
+{
+	Resource& r = m_resources[resource];
+	ASSERTION(r.registered && !r.loading);
+
+	if (r.resident)
+		m_residentBytes -= r.sizeInBytes;
+
+	r.registered = false;
+	r.resident = false;
+	m_freeResources.push_back(resource);
+}
+
+void StreamingScheduler::ReportVisibility(uint32_t resource, double screenCoverage, double distance, bool visible)
+{
+	Resource& r = m_resources[resource];
+	ASSERTION(r.registered);
+
+	// Anything in view ranks above anything out of it, bigger on screen goes first within either
+	double coverage = std::min(std::max(screenCoverage, 0.0), 1.0);
+	double priority = visible ? 1.0 + coverage : coverage * m_settings.offscreenWeight;
+
+	if (priority > r.framePriority || (priority == r.framePriority && distance < r.frameDistance))
+	{
+		r.framePriority = priority;
+		r.frameDistance = distance;
+	}
+	r.frameVisible |= visible;
+}
+
+void StreamingScheduler::OnLoaded(uint32_t resource)
+{
+	Resource& r = m_resources[resource];
+	ASSERTION(r.registered && r.loading);
+
+	r.loading = false;
+	r.resident = true;
+	m_pendingLoadsCount--;
+}
+
+void StreamingScheduler::SortByPriority()
+{
+	m_order.clear();
+	for (uint32_t i = 0; i < (uint32_t)m_resources.size(); i++)
+	{
+		if (m_resources[i].registered)
+			m_order.push_back(i);
+	}
+
+	// Resource id is the last tie breaker, so that order never depends on sort implementation
+	std::sort(m_order.begin(), m_order.end(), [this](uint32_t r0, uint32_t r1)
+	{
+		const Resource& res0 = m_resources[r0];
+		const Resource& res1 = m_resources[r1];
+		if (res0.priority != res1.priority)
+			return res0.priority > res1.priority;
+		if (res0.distance != res1.distance)
+			return res0.distance < res1.distance;
+		return r0 < r1;
+	});
+}
+
+void StreamingScheduler::Evict(uint32_t resource)
+{
+	Resource& r = m_resources[resource];
+	r.resident = false;
+	m_residentBytes -= r.sizeInBytes;
+	m_requests.push_back({ resource, RequestType_Evict });
+	m_lastUpdateStatistics.evictsCount++;
+}
+
+void StreamingScheduler::Update()
+{
+	m_requests.clear();
+	m_lastUpdateStatistics = {};
+
+	// Whatever was reported this frame counts in full, older reports fade out below anything in view
+	for (auto& r : m_resources)
+	{
+		if (!r.registered)
+			continue;
+
+		double decayed = (r.priority > 1.0 ? r.priority - 1.0 : r.priority) * m_settings.priorityDecay;
+		if (r.framePriority >= decayed)
+		{
+			r.priority = r.framePriority;
+			r.distance = r.frameDistance;
+		}
+		else
+			r.priority = decayed;
+
+		if (r.priority < MIN_PRIORITY)
+			r.priority = 0;
+
+		if (r.frameVisible)
+		{
+			m_lastUpdateStatistics.visibleCount++;
+			if (!r.resident)
+				m_lastUpdateStatistics.missesCount++;
+		}
+
+		r.framePriority = -1;
+		r.frameVisible = false;
+	}
+
+	SortByPriority();
+
+	// Evict candidates are taken from the least important end
+	uint32_t evictCursor = (uint32_t)m_order.size();
+	auto nextEvictable = [this, &evictCursor]()
+	{
+		while (evictCursor > 0)
+		{
+			uint32_t resource = m_order[--evictCursor];
+			if (m_resources[resource].resident)
+				return resource;
+		}
+		return NONE;
+	};
+
+	// Most important first, anything not resident that fits gets loaded, making room out of what's least important
+	// Evicts a load needs come right before it, so a loader running requests in order never exceeds budget
+	for (uint32_t i = 0; i < (uint32_t)m_order.size() && m_pendingLoadsCount < m_settings.maxPendingLoads; i++)
+	{
+		uint32_t resource = m_order[i];
+		Resource& r = m_resources[resource];
+		if (r.priority == 0)
+			break;
+
+		if (r.resident || r.loading || r.sizeInBytes > m_settings.budgetBytes)
+			continue;
+
+		// Candidates have to stay behind this one in order, and they're least important first, so once one can't go none can
+		bool fits = true;
+		while (m_residentBytes + r.sizeInBytes > m_settings.budgetBytes)
+		{
+			uint32_t candidate = nextEvictable();
+			if (candidate == NONE || evictCursor <= i || m_resources[candidate].priority * EVICT_PRIORITY_RATIO > r.priority)
+			{
+				// Give candidate back, over budget trimming below may still need it
+				if (candidate != NONE)
+					evictCursor++;
+				fits = false;
+				break;
+			}
+			Evict(candidate);
+		}
+
+		if (!fits)
+			break;
+
+		r.loading = true;
+		m_residentBytes += r.sizeInBytes;
+		m_pendingLoadsCount++;
+		m_requests.push_back({ resource, RequestType_Load });
+		m_lastUpdateStatistics.loadsCount++;
+	}
+
+	// Budget lowered, or resident data registered beyond it
+	while (m_residentBytes > m_settings.budgetBytes)
+	{
+		uint32_t candidate = nextEvictable();
+		if (candidate == NONE)
+			break;
+		Evict(candidate);
+	}
+
+	m_lastUpdateStatistics.residentBytes = m_residentBytes;
+	m_lastUpdateStatistics.pendingLoadsCount = m_pendingLoadsCount;
+	for (auto& r : m_resources)
+		m_lastUpdateStatistics.residentCount += r.registered && r.resident ? 1 : 0;
+}
\ No newline at end of file
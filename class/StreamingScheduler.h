@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Decides which streamable resources, like meshes and texture array slots, stay resident within a memory budget, no dependency on renderer or loader
+// Visibility pass reports screen coverage and camera distance of whatever uses a resource, "Update" turns reports into priorities,
+// picks the most important set that fits into budget and issues loads and evicts in priority order, loader tells back once a load lands
+// Updates are the only clock, so a recorded camera path replays exactly the same
+class StreamingScheduler
+{
+public:
+	static const uint32_t NONE = UINT32_MAX;
+
+	enum RequestType
+	{
+		RequestType_Load,
+		RequestType_Evict,
+	};
+
+	typedef struct _Request
+	{
+		uint32_t	resource;
+		RequestType	type;
+	}Request;
+
+	typedef struct _Settings
+	{
+		uint64_t	budgetBytes;
+		uint32_t	maxPendingLoads;	// Loads issued but not landed yet, more wait for a later update
+		double		offscreenWeight;	// Share of its coverage a resource keeps when its users are out of view, 0 loads only what's seen
+		double		priorityDecay;		// Share of its coverage a resource keeps per update once it's no longer reported, 0 forgets it right away
+	}Settings;
+
+	typedef struct _Statistics
+	{
+		uint64_t	residentBytes;		// Loads in flight included, their memory is taken once issued
+		uint32_t	residentCount;
+		uint32_t	pendingLoadsCount;
+		uint32_t	loadsCount;			// Issued by last update
+		uint32_t	evictsCount;
+		uint32_t	visibleCount;		// Resources used by something in view
+		uint32_t	missesCount;		// Of those, ones not resident
+	}Statistics;
+
+	static const Settings DEFAULT_SETTINGS;
+
+public:
+	const Settings& GetSettings() const { return m_settings; }
+	void SetSettings(const Settings& settings) { m_settings = settings; }
+
+	// "resident" is for data loaded some other way before, it takes budget right away
+	uint32_t RegisterResource(uint64_t sizeInBytes, bool resident);
+
+	// Memory of resource is given back, it mustn't be loading
+	void UnregisterResource(uint32_t resource);
+
+	// Could be called many times per update for a resource shared by many users, the most important report counts
+	// "screenCoverage" is fraction of screen a user covers, "visible" tells if it survived culling
+	// Priority of a visible report is 1 plus coverage, so that what's in view always comes before prefetching what's around
+	void ReportVisibility(uint32_t resource, double screenCoverage, double distance, bool visible);
+
+	// Called once per frame after visibility pass, reports gathered since last call are consumed
+	void Update();
+
+	// Requests issued by last update in the order loader should run them
+	const std::vector<Request>& GetRequests() const { return m_requests; }
+
+	void OnLoaded(uint32_t resource);
+
+	bool IsResident(uint32_t resource) const { return m_resources[resource].resident; }
+	bool IsLoading(uint32_t resource) const { return m_resources[resource].loading; }
+	double GetPriority(uint32_t resource) const { return m_resources[resource].priority; }
+	uint64_t GetResourceSize(uint32_t resource) const { return m_resources[resource].sizeInBytes; }
+	const Statistics& GetLastUpdateStatistics() const { return m_lastUpdateStatistics; }
+
+protected:
+	// Priorities fading below this are dropped, so that a resource out of sight for long isn't wanted just because there's room
+	static const double MIN_PRIORITY;
+
+	// A resident resource is only evicted for a load whose priority is this many times its own, so that resources of about the same
+	// importance don't take turns evicting each other. Over budget trimming doesn't care
+	static const double EVICT_PRIORITY_RATIO;
+
+	typedef struct _Resource
+	{
+		uint64_t	sizeInBytes;
+		double		priority;
+		double		distance;			// Nearest report that counted, breaks ties of priority
+		double		framePriority;		// Gathered from reports since last update, negative if there's none
+		double		frameDistance;
+		bool		frameVisible;
+		bool		resident;
+		bool		loading;
+		bool		registered;
+	}Resource;
+
+	// Registered resources, most important first
+	void SortByPriority();
+
+	void Evict(uint32_t resource);
+
+protected:
+	Settings				m_settings = DEFAULT_SETTINGS;
+	std::vector<Resource>	m_resources;
+	std::vector<uint32_t>	m_freeResources;
+	std::vector<uint32_t>	m_order;
+	std::vector<Request>	m_requests;
+	uint64_t				m_residentBytes = 0;
+	uint32_t				m_pendingLoadsCount = 0;
+	Statistics				m_lastUpdateStatistics = {};
+};
\ No newline at end of file
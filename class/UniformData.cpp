@@ -5,7 +5,7 @@
 #include "../vulkan/Buffer.h"
 #include "../vulkan/DescriptorSetLayout.h"
 #include "../vulkan/DescriptorSet.h"
-#include "../vulkan/DescriptorPool.h"
+#include "../vulkan/DescriptorAllocator.h"
 #include "../vulkan/SwapChain.h"
 #include "GlobalTextures.h"
 #include "GBufferInputUniforms.h"
@@ -30,6 +30,7 @@ bool UniformData::Init()
 		case UniformStorageType::PerAnimationUniformBuffer:	m_uniformStorageBuffers[i] = PerAnimationUniforms::Create(); break;
 		case UniformStorageType::PerFrameBoneBuffer:		m_uniformStorageBuffers[i] = PerBoneUniforms::Create(); break;
 		case UniformStorageType::PerFrameVariableBuffer:	m_uniformStorageBuffers[i] = PerFrameUniforms::Create(); break;
+		case UniformStorageType::PerFrameLightBuffer:		m_uniformStorageBuffers[i] = PerFrameLightUniforms::Create(); break;
 		case UniformStorageType::PerObjectVariableBuffer:	m_uniformStorageBuffers[i] = PerObjectUniforms::Create(); break;
 		default:
 			break;
@@ -107,9 +108,8 @@ void UniformData::BuildDescriptorSets()
 	std::vector<UniformVarList> globalTextureVars = m_uniformTextures[UniformTextureType::GlobalUniformTextures]->PrepareUniformVarList();
 	globalUniformVars.insert(globalUniformVars.end(), globalTextureVars.begin(), globalTextureVars.end());
 
-	/*
-	std::vector<UniformVarList> globalInputAttachVars = m_uniformTextures[UniformTextureType::GlobalGBufferInputUniforms]->PrepareUniformVarList();
-	globalUniformVars.insert(globalUniformVars.end(), globalInputAttachVars.begin(), globalInputAttachVars.end());*/
+	std::vector<UniformVarList> globalGBufferInputVars = m_uniformTextures[UniformTextureType::GlobalGBufferInputUniforms]->PrepareUniformVarList();
+	globalUniformVars.insert(globalUniformVars.end(), globalGBufferInputVars.begin(), globalGBufferInputVars.end());
 
 	// Setup per frame uniform var list
 	std::vector<UniformVarList> perFrameUniformVars = m_uniformStorageBuffers[UniformStorageType::PerFrameVariableBuffer]->PrepareUniformVarList();
@@ -118,6 +118,10 @@ void UniformData::BuildDescriptorSets()
 	std::vector<UniformVarList> perFrameBoneVars = m_uniformStorageBuffers[UniformStorageType::PerFrameBoneBuffer]->PrepareUniformVarList();
 	perFrameUniformVars.insert(perFrameUniformVars.end(), perFrameBoneVars.begin(), perFrameBoneVars.end());
 
+	// Setup per frame light var list
+	std::vector<UniformVarList> perFrameLightVars = m_uniformStorageBuffers[UniformStorageType::PerFrameLightBuffer]->PrepareUniformVarList();
+	perFrameUniformVars.insert(perFrameUniformVars.end(), perFrameLightVars.begin(), perFrameLightVars.end());
+
 	// Setup per object uniform var list
 	std::vector<UniformVarList> perObjectUniformVars = m_uniformStorageBuffers[UniformStorageType::PerObjectVariableBuffer]->PrepareUniformVarList();
 
@@ -129,7 +133,6 @@ void UniformData::BuildDescriptorSets()
 	uniformVarLists[PerObjectUniformsLocation]	= perObjectUniformVars;
 
 	// Build vulkan layout bindings
-	std::vector<std::vector<VkDescriptorSetLayoutBinding>> layoutBindings;
 	for (auto & varList : uniformVarLists)
 	{
 		std::vector<VkDescriptorSetLayoutBinding> bindings;
@@ -164,7 +167,7 @@ void UniformData::BuildDescriptorSets()
 				({
 					(uint32_t)bindings.size(),
 					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-					1,
+					var.count,
 					VK_SHADER_STAGE_FRAGMENT_BIT,
 					nullptr
 					});
@@ -184,38 +187,12 @@ void UniformData::BuildDescriptorSets()
 				break;
 			}
 		}
-		m_descriptorSetLayouts.push_back(DescriptorSetLayout::Create(GetDevice(), bindings));
-		layoutBindings.push_back(bindings);
-	}
-
-	// Prepare descriptor pool size according to resources used by this material
-	std::vector<uint32_t> counts(VK_DESCRIPTOR_TYPE_RANGE_SIZE);
-	for (auto & bindings : layoutBindings)
-	{
-		for (auto & binding : bindings)
-		{
-			counts[binding.descriptorType]++;
-		}
-	}
-
-	std::vector<VkDescriptorPoolSize> descPoolSize;
-	for (uint32_t i = 0; i < counts.size(); i++)
-	{
-		if (counts[i] != 0)
-			descPoolSize.push_back({ (VkDescriptorType)i, counts[i] });
+		m_descriptorSetLayouts.push_back(GlobalDescriptorAllocator()->AcquireDescriptorSetLayout(bindings));
 	}
 
-	VkDescriptorPoolCreateInfo descPoolInfo = {};
-	descPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descPoolInfo.pPoolSizes = descPoolSize.data();
-	descPoolInfo.poolSizeCount = (uint32_t)descPoolSize.size();
-	descPoolInfo.maxSets = PerObjectMaterialVariableBufferLocation;
-
-	m_pDescriptorPool = DescriptorPool::Create(GetDevice(), descPoolInfo);
-
 	// Allocate descriptor sets according to layouts
 	for (auto & layout : m_descriptorSetLayouts)
-		m_descriptorSets.push_back(m_pDescriptorPool->AllocateDescriptorSet(layout));
+		m_descriptorSets.push_back(GlobalDescriptorAllocator()->AllocateDescriptorSet(layout));
 
 
 
@@ -231,11 +208,13 @@ void UniformData::BuildDescriptorSets()
 	bindingSlot = m_uniformStorageBuffers[PerPlanetBuffer]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
 	bindingSlot = m_uniformStorageBuffers[PerAnimationUniformBuffer]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
 	bindingSlot = m_uniformTextures[GlobalUniformTextures]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
+	bindingSlot = m_uniformTextures[GlobalGBufferInputUniforms]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
 
 	// 2. Per frame descriptor set
 	bindingSlot = 0;
 	bindingSlot = m_uniformStorageBuffers[PerFrameVariableBuffer]->SetupDescriptorSet(m_descriptorSets[PerFrameUniformsLocation], bindingSlot);
 	bindingSlot = m_uniformStorageBuffers[PerFrameBoneBuffer]->SetupDescriptorSet(m_descriptorSets[PerFrameUniformsLocation], bindingSlot);
+	bindingSlot = m_uniformStorageBuffers[PerFrameLightBuffer]->SetupDescriptorSet(m_descriptorSets[PerFrameUniformsLocation], bindingSlot);
 
 	// 3. Per object descriptor set
 	m_uniformStorageBuffers[PerObjectVariableBuffer]->SetupDescriptorSet(m_descriptorSets[PerObjectUniformsLocation], 0);
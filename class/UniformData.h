@@ -5,11 +5,11 @@
 #include "GBufferInputUniforms.h"
 #include "GlobalTextures.h"
 #include "PerPlanetUniforms.h"
+#include "PerFrameLightUniforms.h"
 #include "../common/Singleton.h"
 #include "../Maths/Matrix.h"
 #include "../Base/Base.h"
 
-class DescriptorPool;
 class DescriptorSetLayout;
 class DescriptorSet;
 
@@ -36,6 +36,7 @@ public:
 		PerAnimationUniformBuffer,
 		PerFrameVariableBuffer,
 		PerFrameBoneBuffer,
+		PerFrameLightBuffer,
 		PerObjectVariableBuffer,
 		PerObjectMaterialVariableBuffer,
 		UniformStorageTypeCount
@@ -61,6 +62,7 @@ public:
 	std::shared_ptr<PerAnimationUniforms> GetPerAnimationUniforms() const { return std::dynamic_pointer_cast<PerAnimationUniforms>(m_uniformStorageBuffers[UniformStorageType::PerAnimationUniformBuffer]); }
 	std::shared_ptr<PerFrameUniforms> GetPerFrameUniforms() const { return std::dynamic_pointer_cast<PerFrameUniforms>(m_uniformStorageBuffers[UniformStorageType::PerFrameVariableBuffer]); }
 	std::shared_ptr<PerBoneUniforms> GetPerFrameBoneUniforms() const { return std::dynamic_pointer_cast<PerBoneUniforms>(m_uniformStorageBuffers[UniformStorageType::PerFrameBoneBuffer]); }
+	std::shared_ptr<PerFrameLightUniforms> GetPerFrameLightUniforms() const { return std::dynamic_pointer_cast<PerFrameLightUniforms>(m_uniformStorageBuffers[UniformStorageType::PerFrameLightBuffer]); }
 	std::shared_ptr<PerObjectUniforms> GetPerObjectUniforms() const { return std::dynamic_pointer_cast<PerObjectUniforms>(m_uniformStorageBuffers[UniformStorageType::PerObjectVariableBuffer]); }
 	std::shared_ptr<PerFrameDataStorage> GetUniformStorage(UniformStorageType uniformStorageType) const { return m_uniformStorageBuffers[uniformStorageType]; }
 	
@@ -82,7 +84,6 @@ protected:
 	std::vector<std::shared_ptr<UniformDataStorage>>		m_uniformStorageBuffers;
 	std::vector<std::shared_ptr<IMaterialUniformOperator>>	m_uniformTextures;
 
-	std::shared_ptr<DescriptorPool>							m_pDescriptorPool;
 	std::vector<std::shared_ptr<DescriptorSetLayout>>		m_descriptorSetLayouts;
 	std::vector<std::shared_ptr<DescriptorSet>>				m_descriptorSets;
 
@@ -0,0 +1,497 @@
+#include "VertexPacker.h"
+#include "../common/Enums.h"
+#include "../common/Util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+#include <vector>
+
+static int16_t FloatToSnorm16(float value)
+{
+	value = std::min(std::max(value, -1.0f), 1.0f);
+	return (int16_t)std::lround(value * 32767.0f);
+}
+
+static float Snorm16ToFloat(int16_t value)
+{
+	return std::max(value / 32767.0f, -1.0f);
+}
+
+static uint16_t FloatToUnorm16(float value)
+{
+	value = std::min(std::max(value, 0.0f), 1.0f);
+	return (uint16_t)std::lround(value * 65535.0f);
+}
+
+static float Unorm16ToFloat(uint16_t value)
+{
+	return value / 65535.0f;
+}
+
+static void AcquireAttribOffsets(uint32_t vertexFormat, uint32_t* pOffsets)
+{
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < VACount; i++)
+	{
+		pOffsets[i] = offset;
+		offset += GetVertexAttribBytes(vertexFormat, i);
+	}
+}
+
+uint16_t VertexPacker::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	// NaN & infinity
+	if (((bits >> 23) & 0xff) == 0xff)
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+	// Overflow, clamp to infinity
+	if (exponent >= 0x1f)
+		return sign | 0x7c00;
+
+	// Too small even for half denormals
+	if (exponent < -10)
+		return sign;
+
+	// Half denormals
+	if (exponent <= 0)
+	{
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t halfMantissa = mantissa >> shift;
+		// Round to nearest
+		if ((mantissa >> (shift - 1)) & 1)
+			halfMantissa++;
+		return sign | (uint16_t)halfMantissa;
+	}
+
+	uint16_t half = sign | (uint16_t)(exponent << 10) | (uint16_t)(mantissa >> 13);
+	// Round to nearest, carry into exponent is fine since it yields the next representable value
+	if (mantissa & 0x1000)
+		half++;
+	return half;
+}
+
+float VertexPacker::HalfToFloat(uint16_t value)
+{
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0)
+	{
+		// Zero or denormal
+		float result = std::ldexp((float)mantissa, -24);
+		return sign ? -result : result;
+	}
+	else if (exponent == 0x1f)
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+void VertexPacker::OctEncode(const Vector3f& v, int16_t* pEncoded)
+{
+	float l1Norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+	if (l1Norm <= 0)
+	{
+		pEncoded[0] = pEncoded[1] = 0;
+		return;
+	}
+
+	// Project onto octahedron, then fold lower half over the diagonals
+	float x = v.x / l1Norm;
+	float y = v.y / l1Norm;
+	if (v.z < 0)
+	{
+		float foldedX = (1.0f - std::abs(y)) * (x >= 0 ? 1.0f : -1.0f);
+		float foldedY = (1.0f - std::abs(x)) * (y >= 0 ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	pEncoded[0] = FloatToSnorm16(x);
+	pEncoded[1] = FloatToSnorm16(y);
+}
+
+Vector3f VertexPacker::OctDecode(const int16_t* pEncoded)
+{
+	// Same as "OctDecode" in utilities.sh
+	Vector3f v(Snorm16ToFloat(pEncoded[0]), Snorm16ToFloat(pEncoded[1]), 0);
+	v.z = 1.0f - std::abs(v.x) - std::abs(v.y);
+
+	float t = std::max(-v.z, 0.0f);
+	v.x += v.x >= 0 ? -t : t;
+	v.y += v.y >= 0 ? -t : t;
+
+	return v.Normal();
+}
+
+VertexPacker::Dequantization VertexPacker::Pack(uint32_t packedVertexFormat, const uint8_t* pSrcVertices, uint32_t verticesCount, uint8_t* pDstVertices)
+{
+	uint32_t srcVertexFormat = packedVertexFormat & VERTEX_ATTRIB_MASK;
+	uint32_t srcVertexBytes = GetVertexBytes(srcVertexFormat);
+	uint32_t dstVertexBytes = GetVertexBytes(packedVertexFormat);
+
+	uint32_t srcOffsets[VACount];
+	uint32_t dstOffsets[VACount];
+	AcquireAttribOffsets(srcVertexFormat, srcOffsets);
+	AcquireAttribOffsets(packedVertexFormat, dstOffsets);
+
+	auto srcAttrib = [&](uint32_t vertexIndex, uint32_t attrib, uint32_t component)
+	{
+		float value;
+		memcpy(&value, pSrcVertices + vertexIndex * srcVertexBytes + srcOffsets[attrib] + component * sizeof(float), sizeof(float));
+		return value;
+	};
+
+	Dequantization dequantization;
+
+	// Per mesh bounds
+	if ((packedVertexFormat & (1 << VAFPosition)) && (packedVertexFormat & (1 << VAPFPositionSnorm16)))
+	{
+		Vector3f minPosition(FLT_MAX), maxPosition(-FLT_MAX);
+		for (uint32_t i = 0; i < verticesCount; i++)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				minPosition[j] = std::min(minPosition[j], srcAttrib(i, VAFPosition, j));
+				maxPosition[j] = std::max(maxPosition[j], srcAttrib(i, VAFPosition, j));
+			}
+		}
+
+		for (uint32_t j = 0; j < 3 && verticesCount > 0; j++)
+		{
+			float halfExtent = (maxPosition[j] - minPosition[j]) * 0.5f;
+			dequantization.positionScale[j] = halfExtent > 0 ? halfExtent : 1.0f;
+			dequantization.positionBias[j] = (maxPosition[j] + minPosition[j]) * 0.5f;
+		}
+	}
+
+	if ((packedVertexFormat & (1 << VAFTexCoord)) && (packedVertexFormat & (1 << VAPFTexCoordUnorm16)))
+	{
+		Vector2f minTexCoord(FLT_MAX), maxTexCoord(-FLT_MAX);
+		for (uint32_t i = 0; i < verticesCount; i++)
+		{
+			for (uint32_t j = 0; j < 2; j++)
+			{
+				minTexCoord[j] = std::min(minTexCoord[j], srcAttrib(i, VAFTexCoord, j));
+				maxTexCoord[j] = std::max(maxTexCoord[j], srcAttrib(i, VAFTexCoord, j));
+			}
+		}
+
+		for (uint32_t j = 0; j < 2 && verticesCount > 0; j++)
+		{
+			float extent = maxTexCoord[j] - minTexCoord[j];
+			dequantization.texCoordScaleBias[j] = extent > 0 ? extent : 1.0f;
+			dequantization.texCoordScaleBias[j + 2] = minTexCoord[j];
+		}
+	}
+
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		uint8_t* pDst = pDstVertices + i * dstVertexBytes;
+		const uint8_t* pSrc = pSrcVertices + i * srcVertexBytes;
+
+		if (packedVertexFormat & (1 << VAFPosition))
+		{
+			if (packedVertexFormat & (1 << VAPFPositionHalf))
+			{
+				uint16_t position[4] = { FloatToHalf(srcAttrib(i, VAFPosition, 0)), FloatToHalf(srcAttrib(i, VAFPosition, 1)), FloatToHalf(srcAttrib(i, VAFPosition, 2)), 0 };
+				memcpy(pDst + dstOffsets[VAFPosition], position, sizeof(position));
+			}
+			else if (packedVertexFormat & (1 << VAPFPositionSnorm16))
+			{
+				int16_t position[4] = {};
+				for (uint32_t j = 0; j < 3; j++)
+					position[j] = FloatToSnorm16((srcAttrib(i, VAFPosition, j) - dequantization.positionBias[j]) / dequantization.positionScale[j]);
+				memcpy(pDst + dstOffsets[VAFPosition], position, sizeof(position));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFPosition], pSrc + srcOffsets[VAFPosition], 3 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFNormal))
+		{
+			if (packedVertexFormat & (1 << VAPFNormalOct))
+			{
+				int16_t normal[2];
+				OctEncode(Vector3f(srcAttrib(i, VAFNormal, 0), srcAttrib(i, VAFNormal, 1), srcAttrib(i, VAFNormal, 2)), normal);
+				memcpy(pDst + dstOffsets[VAFNormal], normal, sizeof(normal));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFNormal], pSrc + srcOffsets[VAFNormal], 3 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFColor))
+			memcpy(pDst + dstOffsets[VAFColor], pSrc + srcOffsets[VAFColor], 4 * sizeof(float));
+
+		if (packedVertexFormat & (1 << VAFTexCoord))
+		{
+			if (packedVertexFormat & (1 << VAPFTexCoordUnorm16))
+			{
+				uint16_t texCoord[2];
+				for (uint32_t j = 0; j < 2; j++)
+					texCoord[j] = FloatToUnorm16((srcAttrib(i, VAFTexCoord, j) - dequantization.texCoordScaleBias[j + 2]) / dequantization.texCoordScaleBias[j]);
+				memcpy(pDst + dstOffsets[VAFTexCoord], texCoord, sizeof(texCoord));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFTexCoord], pSrc + srcOffsets[VAFTexCoord], 2 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFTangent))
+		{
+			if (packedVertexFormat & (1 << VAPFTangentOct))
+			{
+				int16_t tangent[2];
+				OctEncode(Vector3f(srcAttrib(i, VAFTangent, 0), srcAttrib(i, VAFTangent, 1), srcAttrib(i, VAFTangent, 2)), tangent);
+				memcpy(pDst + dstOffsets[VAFTangent], tangent, sizeof(tangent));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFTangent], pSrc + srcOffsets[VAFTangent], 3 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFBone))
+		{
+			if (packedVertexFormat & (1 << VAPFBoneWeightUnorm8))
+			{
+				uint8_t weights[4];
+				int32_t sum = 0;
+				float srcSum = 0;
+				uint32_t largest = 0;
+				for (uint32_t j = 0; j < 4; j++)
+				{
+					float weight = std::min(std::max(srcAttrib(i, VAFBone, j), 0.0f), 1.0f);
+					weights[j] = (uint8_t)std::lround(weight * 255.0f);
+					sum += weights[j];
+					srcSum += weight;
+					if (srcAttrib(i, VAFBone, j) > srcAttrib(i, VAFBone, largest))
+						largest = j;
+				}
+
+				// Rounding error goes to the largest weight, so that normalized weights still add up to 1
+				if (std::abs(srcSum - 1.0f) < 1.0f / 255.0f)
+					weights[largest] = (uint8_t)std::min(std::max((int32_t)weights[largest] + 255 - sum, 0), 255);
+
+				memcpy(pDst + dstOffsets[VAFBone], weights, sizeof(weights));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFBone], pSrc + srcOffsets[VAFBone], 4 * sizeof(float));
+
+			// Bone indices are copied as they are
+			memcpy(pDst + dstOffsets[VAFBone] + GetVertexAttribBytes(packedVertexFormat, VAFBone) - sizeof(uint32_t), pSrc + srcOffsets[VAFBone] + 4 * sizeof(float), sizeof(uint32_t));
+		}
+	}
+
+	return dequantization;
+}
+
+void VertexPacker::Unpack(uint32_t packedVertexFormat, const Dequantization& dequantization, const uint8_t* pSrcVertices, uint32_t verticesCount, uint8_t* pDstVertices)
+{
+	uint32_t dstVertexFormat = packedVertexFormat & VERTEX_ATTRIB_MASK;
+	uint32_t srcVertexBytes = GetVertexBytes(packedVertexFormat);
+	uint32_t dstVertexBytes = GetVertexBytes(dstVertexFormat);
+
+	uint32_t srcOffsets[VACount];
+	uint32_t dstOffsets[VACount];
+	AcquireAttribOffsets(packedVertexFormat, srcOffsets);
+	AcquireAttribOffsets(dstVertexFormat, dstOffsets);
+
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		uint8_t* pDst = pDstVertices + i * dstVertexBytes;
+		const uint8_t* pSrc = pSrcVertices + i * srcVertexBytes;
+
+		if (packedVertexFormat & (1 << VAFPosition))
+		{
+			float position[3];
+			if (packedVertexFormat & (1 << VAPFPositionHalf))
+			{
+				uint16_t packed[4];
+				memcpy(packed, pSrc + srcOffsets[VAFPosition], sizeof(packed));
+				for (uint32_t j = 0; j < 3; j++)
+					position[j] = HalfToFloat(packed[j]);
+			}
+			else if (packedVertexFormat & (1 << VAPFPositionSnorm16))
+			{
+				int16_t packed[4];
+				memcpy(packed, pSrc + srcOffsets[VAFPosition], sizeof(packed));
+				for (uint32_t j = 0; j < 3; j++)
+					position[j] = Snorm16ToFloat(packed[j]) * dequantization.positionScale[j] + dequantization.positionBias[j];
+			}
+			else
+				memcpy(position, pSrc + srcOffsets[VAFPosition], sizeof(position));
+
+			memcpy(pDst + dstOffsets[VAFPosition], position, sizeof(position));
+		}
+
+		if (packedVertexFormat & (1 << VAFNormal))
+		{
+			if (packedVertexFormat & (1 << VAPFNormalOct))
+			{
+				int16_t packed[2];
+				memcpy(packed, pSrc + srcOffsets[VAFNormal], sizeof(packed));
+				Vector3f normal = OctDecode(packed);
+				memcpy(pDst + dstOffsets[VAFNormal], &normal.x, 3 * sizeof(float));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFNormal], pSrc + srcOffsets[VAFNormal], 3 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFColor))
+			memcpy(pDst + dstOffsets[VAFColor], pSrc + srcOffsets[VAFColor], 4 * sizeof(float));
+
+		if (packedVertexFormat & (1 << VAFTexCoord))
+		{
+			if (packedVertexFormat & (1 << VAPFTexCoordUnorm16))
+			{
+				uint16_t packed[2];
+				memcpy(packed, pSrc + srcOffsets[VAFTexCoord], sizeof(packed));
+				float texCoord[2];
+				for (uint32_t j = 0; j < 2; j++)
+					texCoord[j] = Unorm16ToFloat(packed[j]) * dequantization.texCoordScaleBias[j] + dequantization.texCoordScaleBias[j + 2];
+				memcpy(pDst + dstOffsets[VAFTexCoord], texCoord, sizeof(texCoord));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFTexCoord], pSrc + srcOffsets[VAFTexCoord], 2 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFTangent))
+		{
+			if (packedVertexFormat & (1 << VAPFTangentOct))
+			{
+				int16_t packed[2];
+				memcpy(packed, pSrc + srcOffsets[VAFTangent], sizeof(packed));
+				Vector3f tangent = OctDecode(packed);
+				memcpy(pDst + dstOffsets[VAFTangent], &tangent.x, 3 * sizeof(float));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFTangent], pSrc + srcOffsets[VAFTangent], 3 * sizeof(float));
+		}
+
+		if (packedVertexFormat & (1 << VAFBone))
+		{
+			if (packedVertexFormat & (1 << VAPFBoneWeightUnorm8))
+			{
+				uint8_t packed[4];
+				memcpy(packed, pSrc + srcOffsets[VAFBone], sizeof(packed));
+				float weights[4];
+				for (uint32_t j = 0; j < 4; j++)
+					weights[j] = packed[j] / 255.0f;
+				memcpy(pDst + dstOffsets[VAFBone], weights, sizeof(weights));
+			}
+			else
+				memcpy(pDst + dstOffsets[VAFBone], pSrc + srcOffsets[VAFBone], 4 * sizeof(float));
+
+			memcpy(pDst + dstOffsets[VAFBone] + 4 * sizeof(float), pSrc + srcOffsets[VAFBone] + GetVertexAttribBytes(packedVertexFormat, VAFBone) - sizeof(uint32_t), sizeof(uint32_t));
+		}
+	}
+}
+
+bool VertexPacker::Validate(uint32_t packedVertexFormat, const Dequantization& dequantization, const uint8_t* pSrcVertices, const uint8_t* pPackedVertices, uint32_t verticesCount, DecodeError* pDecodeError)
+{
+	uint32_t vertexFormat = packedVertexFormat & VERTEX_ATTRIB_MASK;
+	uint32_t vertexBytes = GetVertexBytes(vertexFormat);
+
+	std::vector<uint8_t> decoded(verticesCount * vertexBytes);
+	Unpack(packedVertexFormat, dequantization, pPackedVertices, verticesCount, decoded.data());
+
+	uint32_t offsets[VACount];
+	AcquireAttribOffsets(vertexFormat, offsets);
+
+	auto attrib = [&](const uint8_t* pVertices, uint32_t vertexIndex, uint32_t attribIndex, uint32_t component)
+	{
+		float value;
+		memcpy(&value, pVertices + vertexIndex * vertexBytes + offsets[attribIndex] + component * sizeof(float), sizeof(float));
+		return value;
+	};
+
+	DecodeError error = {};
+	bool valid = true;
+
+	for (uint32_t i = 0; i < verticesCount; i++)
+	{
+		if (vertexFormat & (1 << VAFPosition))
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				float src = attrib(pSrcVertices, i, VAFPosition, j);
+				float diff = std::abs(attrib(decoded.data(), i, VAFPosition, j) - src);
+
+				// One quantization step
+				float tolerance = 0;
+				if (packedVertexFormat & (1 << VAPFPositionHalf))
+					tolerance = std::max(std::abs(src) / 1024.0f, 1.0f / 16777216.0f);
+				else if (packedVertexFormat & (1 << VAPFPositionSnorm16))
+					tolerance = dequantization.positionScale[j] / 32767.0f;
+
+				error.position = std::max(error.position, diff);
+				valid &= diff <= tolerance;
+			}
+		}
+
+		// Octahedral encoding only keeps direction, compare against normalized source
+		auto checkDirection = [&](uint32_t attribIndex, uint32_t packFlag, float& maxError)
+		{
+			if (!(vertexFormat & (1 << attribIndex)) || !(packedVertexFormat & (1 << packFlag)))
+				return;
+
+			Vector3f src(attrib(pSrcVertices, i, attribIndex, 0), attrib(pSrcVertices, i, attribIndex, 1), attrib(pSrcVertices, i, attribIndex, 2));
+			if (src.Length() <= 0)
+				return;
+
+			Vector3f dst(attrib(decoded.data(), i, attribIndex, 0), attrib(decoded.data(), i, attribIndex, 1), attrib(decoded.data(), i, attribIndex, 2));
+			float diff = (dst - src.Normal()).Length();
+
+			maxError = std::max(maxError, diff);
+			valid &= diff <= 1e-3f;
+		};
+
+		checkDirection(VAFNormal, VAPFNormalOct, error.normal);
+		checkDirection(VAFTangent, VAPFTangentOct, error.tangent);
+
+		if ((vertexFormat & (1 << VAFTexCoord)) && (packedVertexFormat & (1 << VAPFTexCoordUnorm16)))
+		{
+			for (uint32_t j = 0; j < 2; j++)
+			{
+				float diff = std::abs(attrib(decoded.data(), i, VAFTexCoord, j) - attrib(pSrcVertices, i, VAFTexCoord, j));
+				error.texCoord = std::max(error.texCoord, diff);
+				valid &= diff <= dequantization.texCoordScaleBias[j] / 65535.0f;
+			}
+		}
+
+		if ((vertexFormat & (1 << VAFBone)) && (packedVertexFormat & (1 << VAPFBoneWeightUnorm8)))
+		{
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				float diff = std::abs(attrib(decoded.data(), i, VAFBone, j) - attrib(pSrcVertices, i, VAFBone, j));
+				error.boneWeight = std::max(error.boneWeight, diff);
+
+				// Rounding error of all 4 weights might go to the largest one
+				valid &= diff <= 2.5f / 255.0f;
+			}
+
+			uint32_t srcIndices, dstIndices;
+			memcpy(&srcIndices, pSrcVertices + i * vertexBytes + offsets[VAFBone] + 4 * sizeof(float), sizeof(uint32_t));
+			memcpy(&dstIndices, decoded.data() + i * vertexBytes + offsets[VAFBone] + 4 * sizeof(float), sizeof(uint32_t));
+			valid &= srcIndices == dstIndices;
+		}
+	}
+
+	if (pDecodeError)
+		*pDecodeError = error;
+
+	return valid;
+}
\ No newline at end of file
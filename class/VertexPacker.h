@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include "../Maths/Vector.h"
+
+// Converts full precision vertices into layouts described by "VertexAttribPackFlag" and back
+// Full precision layout of a packed vertex format is "packedVertexFormat & VERTEX_ATTRIB_MASK"
+class VertexPacker
+{
+public:
+	// Recovers attributes quantized into per mesh bounds: value = packed * scale + bias
+	typedef struct _Dequantization
+	{
+		Vector4f	positionScale = Vector4f(1, 1, 1, 0);
+		Vector4f	positionBias = Vector4f(0, 0, 0, 0);
+		Vector4f	texCoordScaleBias = Vector4f(1, 1, 0, 0);	// xy: scale, zw: bias
+	}Dequantization;
+
+	// Maximum absolute error of each attribute after a round trip
+	typedef struct _DecodeError
+	{
+		float	position;
+		float	normal;
+		float	texCoord;
+		float	tangent;
+		float	boneWeight;
+	}DecodeError;
+
+public:
+	static Dequantization Pack(uint32_t packedVertexFormat, const uint8_t* pSrcVertices, uint32_t verticesCount, uint8_t* pDstVertices);
+	static void Unpack(uint32_t packedVertexFormat, const Dequantization& dequantization, const uint8_t* pSrcVertices, uint32_t verticesCount, uint8_t* pDstVertices);
+
+	// Decode packed vertices and compare with source, false if any attribute goes beyond what its quantization step allows
+	static bool Validate(uint32_t packedVertexFormat, const Dequantization& dequantization, const uint8_t* pSrcVertices, const uint8_t* pPackedVertices, uint32_t verticesCount, DecodeError* pDecodeError = nullptr);
+
+	static uint16_t FloatToHalf(float value);
+	static float HalfToFloat(uint16_t value);
+	static void OctEncode(const Vector3f& v, int16_t* pEncoded);
+	static Vector3f OctDecode(const int16_t* pEncoded);
+};
\ No newline at end of file
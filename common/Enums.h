@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 enum VertexAttribFlag
 {
@@ -11,6 +12,22 @@ enum VertexAttribFlag
 	VACount
 };
 
+// Packed storage of vertex attributes, or'ed into vertex format on top of attribute flags
+// An attribute without pack flag is stored as 32 bits floats
+enum VertexAttribPackFlag
+{
+	VAPFPositionHalf = 8,		// 4 x float16
+	VAPFPositionSnorm16,		// 4 x snorm16, normalized into per mesh bounds
+	VAPFNormalOct,				// 2 x snorm16, octahedral encoded
+	VAPFTangentOct,				// 2 x snorm16, octahedral encoded
+	VAPFTexCoordUnorm16,		// 2 x unorm16, normalized into per mesh bounds
+	VAPFBoneWeightUnorm8,		// 4 x unorm8
+	VAPFCount
+};
+
+// Bits of vertex format that stand for attributes, rather than the way they're packed
+static const uint32_t VERTEX_ATTRIB_MASK = (1 << VACount) - 1;
+
 enum VertexFormat
 {
 	VertexFormatNul = 0,
@@ -19,7 +36,12 @@ enum VertexFormat
 	VertexFormatPTC = (1 << VAFPosition) | (1 << VAFTexCoord),
 	VertexFormatPNTC = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord),
 	VertexFormatPNTCT = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord) | (1 << VAFTangent),
-	VertexFormatPNTCTB = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord) | (1 << VAFTangent) | (1 << VAFBone)
+	VertexFormatPNTCTB = (1 << VAFPosition) | (1 << VAFNormal) | (1 << VAFTexCoord) | (1 << VAFTangent) | (1 << VAFBone),
+
+	// 20 bytes rather than 44
+	VertexFormatPNTCTPacked = VertexFormatPNTCT | (1 << VAPFPositionSnorm16) | (1 << VAPFNormalOct) | (1 << VAPFTangentOct) | (1 << VAPFTexCoordUnorm16),
+	// 28 bytes rather than 64
+	VertexFormatPNTCTBPacked = VertexFormatPNTCTPacked | (1 << VAFBone) | (1 << VAPFBoneWeightUnorm8)
 };
 
 // Reserved vertex buffer binding slot, don't use these slot
@@ -1,6 +1,4 @@
-#if defined(_WIN32)
 #include <assert.h>
-#endif
 
 #include <iostream>
 
@@ -13,7 +11,9 @@
 #define EXTENSION_VULKAN_DRAW_INDIRECT_COUNT "VK_KHR_draw_indirect_count"
 #define PROJECT_NAME "VulkanLearn"
 
+#if !defined(UINT64_MAX)
 #define UINT64_MAX       0xffffffffffffffffui64
+#endif
 
 #define TO_STRING(x) #x
 
@@ -37,6 +37,13 @@
 #define CHECK_ERROR(vkExpress) vkExpress;
 #define ASSERTION(express) express;
 #endif
+#else
+// Only CPU side code builds elsewhere, see "tests"
+#if defined(_DEBUG)
+#define ASSERTION(express) assert(express);
+#else
+#define ASSERTION(express) express;
+#endif
 #endif
 
 #define GET_INSTANCE_PROC_ADDR(inst, entrypoint)                        \
@@ -0,0 +1,83 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<MappedFile> MappedFile::Create(const std::string& path)
+{
+	std::shared_ptr<MappedFile> pMappedFile = std::make_shared<MappedFile>();
+	if (pMappedFile.get() && pMappedFile->Init(path))
+		return pMappedFile;
+	return nullptr;
+}
+
+#if defined(_WIN32)
+bool MappedFile::Init(const std::string& path)
+{
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	m_hFile = hFile;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+		return false;
+
+	m_size = (uint64_t)fileSize.QuadPart;
+
+	m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping == nullptr)
+		return false;
+
+	m_pData = (const uint8_t*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	return m_pData != nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData != nullptr)
+		UnmapViewOfFile(m_pData);
+
+	if (m_hMapping != nullptr)
+		CloseHandle(m_hMapping);
+
+	if (m_hFile != nullptr)
+		CloseHandle(m_hFile);
+}
+#else
+bool MappedFile::Init(const std::string& path)
+{
+	m_fileDesc = open(path.c_str(), O_RDONLY);
+	if (m_fileDesc < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(m_fileDesc, &fileStat) != 0 || fileStat.st_size == 0)
+		return false;
+
+	m_size = (uint64_t)fileStat.st_size;
+
+	void* pData = mmap(nullptr, (size_t)m_size, PROT_READ, MAP_PRIVATE, m_fileDesc, 0);
+	if (pData == MAP_FAILED)
+		return false;
+
+	m_pData = (const uint8_t*)pData;
+	return true;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData != nullptr)
+		munmap((void*)m_pData, (size_t)m_size);
+
+	if (m_fileDesc >= 0)
+		close(m_fileDesc);
+}
+#endif
\ No newline at end of file
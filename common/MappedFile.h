@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <cstdint>
+
+// Read only memory mapped file, contents stay valid as long as this object is alive
+class MappedFile
+{
+public:
+	static std::shared_ptr<MappedFile> Create(const std::string& path);
+	~MappedFile();
+
+public:
+	const uint8_t* GetData() const { return m_pData; }
+	uint64_t GetSize() const { return m_size; }
+
+private:
+	bool Init(const std::string& path);
+
+private:
+	const uint8_t*	m_pData = nullptr;
+	uint64_t		m_size = 0;
+
+#if defined(_WIN32)
+	void*			m_hFile = nullptr;
+	void*			m_hMapping = nullptr;
+#else
+	int				m_fileDesc = -1;
+#endif
+};
\ No newline at end of file
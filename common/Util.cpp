@@ -2,33 +2,80 @@
 #include "Enums.h"
 #include "../common/Macros.h"
 
-uint32_t GetVertexBytes(uint32_t vertexFormat)
+uint32_t GetVertexAttribBytes(uint32_t vertexFormat, uint32_t vertexAttrib)
 {
-	uint32_t vertexByte = 0;
-	if (vertexFormat & (1 << VAFPosition))
-	{
-		vertexByte += 3 * sizeof(float);
-	}
-	if (vertexFormat & (1 << VAFNormal))
-	{
-		vertexByte += 3 * sizeof(float);
-	}
-	if (vertexFormat & (1 << VAFColor))
-	{
-		vertexByte += 4 * sizeof(float);
-	}
-	if (vertexFormat & (1 << VAFTexCoord))
-	{
-		vertexByte += 2 * sizeof(float);
-	}
-	if (vertexFormat & (1 << VAFTangent))
+	if ((vertexFormat & (1 << vertexAttrib)) == 0)
+		return 0;
+
+	switch (vertexAttrib)
 	{
-		vertexByte += 3 * sizeof(float);
+	case VAFPosition:
+		if (vertexFormat & ((1 << VAPFPositionHalf) | (1 << VAPFPositionSnorm16)))
+			return 4 * sizeof(uint16_t);
+		return 3 * sizeof(float);
+	case VAFNormal:
+		if (vertexFormat & (1 << VAPFNormalOct))
+			return 2 * sizeof(int16_t);
+		return 3 * sizeof(float);
+	case VAFColor:
+		return 4 * sizeof(float);
+	case VAFTexCoord:
+		if (vertexFormat & (1 << VAPFTexCoordUnorm16))
+			return 2 * sizeof(uint16_t);
+		return 2 * sizeof(float);
+	case VAFTangent:
+		if (vertexFormat & (1 << VAPFTangentOct))
+			return 2 * sizeof(int16_t);
+		return 3 * sizeof(float);
+	case VAFBone:
+		// Bone weights, plus 4 bone indices of 1 byte each
+		if (vertexFormat & (1 << VAPFBoneWeightUnorm8))
+			return 4 * sizeof(uint8_t) + sizeof(uint32_t);
+		return 4 * sizeof(float) + sizeof(uint32_t);
+	default: ASSERTION(false);
 	}
-	if (vertexFormat & (1 << VAFBone))
+	return 0;
+}
+
+VkFormat GetVertexAttribFormat(uint32_t vertexFormat, uint32_t vertexAttrib)
+{
+	switch (vertexAttrib)
 	{
-		vertexByte += 5 * sizeof(float);
+	case VAFPosition:
+		if (vertexFormat & (1 << VAPFPositionHalf))
+			return VK_FORMAT_R16G16B16A16_SFLOAT;
+		if (vertexFormat & (1 << VAPFPositionSnorm16))
+			return VK_FORMAT_R16G16B16A16_SNORM;
+		return VK_FORMAT_R32G32B32_SFLOAT;
+	case VAFNormal:
+		if (vertexFormat & (1 << VAPFNormalOct))
+			return VK_FORMAT_R16G16_SNORM;
+		return VK_FORMAT_R32G32B32_SFLOAT;
+	case VAFColor:
+		return VK_FORMAT_R32G32B32A32_SFLOAT;
+	case VAFTexCoord:
+		if (vertexFormat & (1 << VAPFTexCoordUnorm16))
+			return VK_FORMAT_R16G16_UNORM;
+		return VK_FORMAT_R32G32_SFLOAT;
+	case VAFTangent:
+		if (vertexFormat & (1 << VAPFTangentOct))
+			return VK_FORMAT_R16G16_SNORM;
+		return VK_FORMAT_R32G32B32_SFLOAT;
+	case VAFBone:
+		// Format of bone weights, bone indices are always "VK_FORMAT_R32_UINT"
+		if (vertexFormat & (1 << VAPFBoneWeightUnorm8))
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		return VK_FORMAT_R32G32B32A32_SFLOAT;
+	default: ASSERTION(false);
 	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+uint32_t GetVertexBytes(uint32_t vertexFormat)
+{
+	uint32_t vertexByte = 0;
+	for (uint32_t i = 0; i < VACount; i++)
+		vertexByte += GetVertexAttribBytes(vertexFormat, i);
 	return vertexByte;
 }
 
@@ -56,91 +103,37 @@ VkVertexInputBindingDescription GenerateReservedVBBindingDesc(uint32_t vertexFor
 std::vector<VkVertexInputAttributeDescription> GenerateReservedVBAttribDesc(uint32_t vertexFormat, uint32_t vertexFormatInMem)
 {
 	// Do assert all bits of vertex format must exist in vertex format in memory
-	ASSERTION((vertexFormat & vertexFormatInMem) == vertexFormat);
+	ASSERTION((vertexFormat & vertexFormatInMem & VERTEX_ATTRIB_MASK) == (vertexFormat & VERTEX_ATTRIB_MASK));
 
 	std::vector<VkVertexInputAttributeDescription> attribDesc;
 
+	// Attribute packing follows the layout in memory
 	uint32_t offset = 0;
-	if (vertexFormat & (1 << VAFPosition))
-	{
-		VkVertexInputAttributeDescription attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32G32B32_SFLOAT;
-		attrib.location = VAFPosition;
-		attrib.offset = offset;
-		attribDesc.push_back(attrib);
-	}
-	if (vertexFormatInMem & (1 << VAFPosition))
-		offset += sizeof(float) * 3;
-
-	if (vertexFormat & (1 << VAFNormal))
-	{
-		VkVertexInputAttributeDescription attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32G32B32_SFLOAT;
-		attrib.location = VAFNormal;
-		attrib.offset = offset;
-		attribDesc.push_back(attrib);
-	}
-	if (vertexFormatInMem & (1 << VAFNormal))
-		offset += sizeof(float) * 3;
-
-	if (vertexFormat & (1 << VAFColor))
+	for (uint32_t i = 0; i < VACount; i++)
 	{
-		VkVertexInputAttributeDescription attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		attrib.location = VAFColor;
-		attrib.offset = offset;
-		attribDesc.push_back(attrib);
-	}
-	if (vertexFormatInMem & (1 << VAFColor))
-		offset += sizeof(float) * 4;
-
-	if (vertexFormat & (1 << VAFTexCoord))
-	{
-		VkVertexInputAttributeDescription attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32G32_SFLOAT;
-		attrib.location = VAFTexCoord;
-		attrib.offset = offset;
-		attribDesc.push_back(attrib);
-	}
-	if (vertexFormatInMem & (1 << VAFTexCoord))
-		offset += sizeof(float) * 2;
+		if (vertexFormat & (1 << i))
+		{
+			VkVertexInputAttributeDescription attrib = {};
+			attrib.binding = ReservedVBBindingSlot_MeshData;
+			attrib.format = GetVertexAttribFormat(vertexFormatInMem, i);
+			attrib.location = i;
+			attrib.offset = offset;
+			attribDesc.push_back(attrib);
 
-	if (vertexFormat & (1 << VAFTangent))
-	{
-		VkVertexInputAttributeDescription attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32G32B32_SFLOAT;
-		attrib.location = VAFTangent;
-		attrib.offset = offset;
-		attribDesc.push_back(attrib);
-	}
-	if (vertexFormatInMem & (1 << VAFTangent))
-		offset += sizeof(float) * 3;
-
-	if (vertexFormat & (1 << VAFBone))
-	{
-		// Bone weight
-		VkVertexInputAttributeDescription attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		attrib.location = VAFBone;
-		attrib.offset = offset;
-		attribDesc.push_back(attrib);
+			if (i == VAFBone)
+			{
+				// Bone index (4 bytes, 1 per index from 0 - 255)
+				attrib = {};
+				attrib.binding = ReservedVBBindingSlot_MeshData;
+				attrib.format = VK_FORMAT_R32_UINT;
+				attrib.location = VAFBone + 1;
+				attrib.offset = offset + GetVertexAttribBytes(vertexFormatInMem, VAFBone) - sizeof(uint32_t);
+				attribDesc.push_back(attrib);
+			}
+		}
 
-		// Bone index (4 bytes, 1 per index from 0 - 255)
-		attrib = {};
-		attrib.binding = ReservedVBBindingSlot_MeshData;
-		attrib.format = VK_FORMAT_R32_UINT;
-		attrib.location = VAFBone + 1;
-		attrib.offset = offset + sizeof(float) * 4;
-		attribDesc.push_back(attrib);
+		offset += GetVertexAttribBytes(vertexFormatInMem, i);
 	}
-	if (vertexFormatInMem & (1 << VAFBone))
-		offset += sizeof(float) * 5;
 
 	return attribDesc;
 }
\ No newline at end of file
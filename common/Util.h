@@ -21,6 +21,10 @@ if (!pRet || !pRet->Init()) \
 #define EQUAL(type, x, y) ((((x) - (std::numeric_limits<type>::epsilon())) <= (y)) && (((x) + (std::numeric_limits<type>::epsilon())) >= (y)))
 
 uint32_t GetVertexBytes(uint32_t vertexFormat);
+
+// Bytes and format of a single attribute in memory, depending on pack flags of "vertexFormat"
+uint32_t GetVertexAttribBytes(uint32_t vertexFormat, uint32_t vertexAttrib);
+VkFormat GetVertexAttribFormat(uint32_t vertexFormat, uint32_t vertexAttrib);
 uint32_t GetIndexBytes(VkIndexType indexType);
 
 // There's mechanism that handles mesh data store and binding by default
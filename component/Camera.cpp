@@ -47,6 +47,13 @@ void Camera::UpdateViewMatrix()
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetCameraDirection(m_pObject.lock()->GetCachedWorldTransform()[2].xyz().Negative());
 }
 
+PyramidFrustumd Camera::AcquireWorldFrustum() const
+{
+	PyramidFrustumd frustum = { { 0, 0, 0 }, { 0, 0, -1 }, m_cameraInfo.fov / 2.0, m_cameraInfo.aspect, m_cameraInfo.near, m_cameraInfo.far };
+	frustum.Transform(GetBaseObject()->GetCachedWorldTransform());
+	return frustum;
+}
+
 void Camera::UpdateProjMatrix()
 {
 	if (!m_projDirty)
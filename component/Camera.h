@@ -1,6 +1,7 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
+#include "../Maths/PyramidFrustum.h"
 
 #undef near
 #undef far
@@ -37,6 +38,9 @@ public:
 
 	const Matrix4d GetVPMatrix() const { return m_vpMatrix; }
 
+	// View frustum in world space, as of last "UpdateCachedData"
+	PyramidFrustumd AcquireWorldFrustum() const;
+
 	static std::shared_ptr<Camera> Create(const CameraInfo& info);
 
 protected:
@@ -3,31 +3,50 @@
 #include "Camera.h"
 #include <iostream>
 #include <math.h>
+#include <limits>
+#include <algorithm>
 #include "../Maths/Vector.h"
 #include "../Maths/MathUtil.h"
 #include "../class/UniformData.h"
+#include "../class/FrustumCuller.h"
+#include "../class/RenderWorkManager.h"
+#include "../class/AABBTree.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/FrameManager.h"
 
-const double DirectionLight::DEFAULT_SHADOWMAP_SIZE = 512;
-const double DirectionLight::DEFAULT_FRUSTUM_SIZE = 2.56;
-const double DirectionLight::DEFAULT_FRUSTUM_LENGTH = 5.12;
+// Split main light's shadow map into "SHADOW_CASCADE_COUNT" cascades, shaders have to be compiled by compile_all_shader.py first
+// Otherwise one shadow map, cascade 0, covers whole shadow distance, which shaders compiled before cascades sample the same way
+bool SHADOW_CASCADES = false;
+
+const double DirectionLight::DEFAULT_SHADOW_DISTANCE = 24.0;
+const uint32_t DirectionLight::FIRST_CACHED_CASCADE;
+const uint32_t DirectionLight::CACHED_CASCADE_REFRESH_INTERVAL;
+const double DirectionLight::CACHED_CASCADE_MARGIN = 0.2;
 
 DEFINITE_CLASS_RTTI(DirectionLight, BaseComponent);
 
-bool DirectionLight::Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, const Vector3d& frustumSize, const Vector2ui& shadowMapSize)
+bool DirectionLight::Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, double shadowDistance)
 {
 	if (!BaseComponent::Init(pLight))
 		return false;
 
 	SetLightColor(lightColor);
-	m_frustumSize = frustumSize;
-	m_shadowMapSize = shadowMapSize;
+	m_shadowDistance = shadowDistance;
+
+	// Cached cascades are fit on first frame
+	for (auto& cascade : m_cascades)
+	{
+		cascade.framesSinceFit = CACHED_CASCADE_REFRESH_INTERVAL;
+		cascade.version = 0;
+	}
+
 	return true;
 }
 
-std::shared_ptr<DirectionLight> DirectionLight::Create(const Vector3d& lightColor, const Vector3d& frustumSize, const Vector2ui& shadowMapSize)
+std::shared_ptr<DirectionLight> DirectionLight::Create(const Vector3d& lightColor, double shadowDistance)
 {
 	std::shared_ptr<DirectionLight> pLight = std::make_shared<DirectionLight>();
-	if (pLight.get() && pLight->Init(pLight, lightColor, frustumSize, shadowMapSize))
+	if (pLight.get() && pLight->Init(pLight, lightColor, shadowDistance))
 		return pLight;
 
 	return nullptr;
@@ -35,40 +54,115 @@ std::shared_ptr<DirectionLight> DirectionLight::Create(const Vector3d& lightColo
 
 void DirectionLight::UpdateData()
 {
-	std::shared_ptr<BaseObject> pObj = GetBaseObject();
-
-	Matrix4d proj;
-	proj.c00 = 1.0 / m_frustumSize.x;
-
-	// Reverse y top side down for vulkan ndc
-	proj.c11 = -1.0 / m_frustumSize.y;
-
-	// -1 <= z / fz <= 1
-	// 0 <= z / fz + 1 <= 2
-	// 0 <= 0.5(z / fz + 1) <= 1
-	// 0 <= 0.5z / fz + 0.5 <= 1
-	// Convert to range 0~1 for vulkan ndc depth
-	proj.c22 = 0.5 / m_frustumSize.z;
-	proj.c32 = 0.5;
-
-	// 3rd step: get light projection matrix
-	m_cs2lsProjMatrix = proj;
-
 	// light space 2 world space
-	Matrix4d ls2ws = pObj->GetCachedWorldTransform();
+	Matrix4d ls2ws = GetBaseObject()->GetCachedWorldTransform();
 	// light direction in world space
 	m_csLightDirection = ls2ws[2].xyz();
 	// light direction in camera space
 	m_csLightDirection = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewMatrix().TransformAsVector(m_csLightDirection);
+}
 
-	// 2nd step: from world space 2 light space
-	m_cs2lsProjMatrix *= ls2ws.Inverse();
+void DirectionLight::UpdateCascades()
+{
+	std::shared_ptr<GlobalUniforms> pGlobalUniforms = UniformData::GetInstance()->GetGlobalUniforms();
+	std::shared_ptr<PerFrameUniforms> pPerFrameUniforms = UniformData::GetInstance()->GetPerFrameUniforms();
+
+	Matrix4d ls2ws = GetBaseObject()->GetCachedWorldTransform();
+	Matrix4d ws2ls = ls2ws;
+	ws2ls.Inverse();
 
-	// 1st step: from camera space 2 world space
-	// final = 3rd * 2nd * 1st
-	// final matrix transforms vertices from camera space 2 light space and then to light ndc
 	// FIXME: should use camera world transform instead of acquiring it from per frame uniform, since it could be results from last frame
-	m_cs2lsProjMatrix *= UniformData::GetInstance()->GetPerFrameUniforms()->GetViewCoordinateSystem();
+	Matrix4d cs2ws = pPerFrameUniforms->GetViewCoordinateSystem();
+
+	// Cascades not in use reach nowhere
+	double splits[SHADOW_CASCADE_COUNT + 1] = {};
+	double farPlane = std::min(pGlobalUniforms->GetMainCameraFarPlane(), m_shadowDistance);
+	CascadedShadowMap::ComputeSplits(pPerFrameUniforms->GetNearFarAB().x, farPlane, GetCascadeCount(), CascadedShadowMap::DEFAULT_SPLIT_LAMBDA, splits);
+
+	double tangentFOV_2 = pGlobalUniforms->GetMainCameraVerticalTangentFOV_2();
+	double aspect = pGlobalUniforms->GetMainCameraAspect();
+	uint32_t resolution = (uint32_t)pGlobalUniforms->GetShadowGenWindowSize().x;
+
+	// Boxes reach up to the top of scene as light sees it, so that casters out of camera's sight still cast into slices
+	std::shared_ptr<AABBTree> pSpatialIndex = GetBaseObject()->AcquireSpatialIndex();
+	double casterMaxZ = std::numeric_limits<double>::lowest();
+	AABBTree::Box sceneBounds;
+	if (pSpatialIndex != nullptr && pSpatialIndex->GetBounds(sceneBounds))
+	{
+		Vector3d lsMin, lsMax;
+		CascadedShadowMap::AcquireLightSpaceBounds(ls2ws, sceneBounds.min, sceneBounds.max, lsMin, lsMax);
+		casterMaxZ = lsMax.z;
+	}
+
+	// Cached boxes live in light space, any change of light throws them away
+	bool lightChanged = false;
+	for (uint32_t i = 0; i < 4; i++)
+		for (uint32_t j = 0; j < 4; j++)
+			lightChanged |= ls2ws[i][j] != m_cachedLightTransform[i][j];
+	m_cachedLightTransform = ls2ws;
+
+	uint32_t frameIndex = FrameMgr()->FrameIndex();
+
+	m_renderedCascadeMask = 0;
+	for (uint32_t i = 0; i < GetCascadeCount(); i++)
+	{
+		ShadowCascade& shadowCascade = m_cascades[i];
+		if (shadowCascade.frameVersions.size() != FrameMgr()->MaxFrameCount())
+			shadowCascade.frameVersions.assign(FrameMgr()->MaxFrameCount(), UINT32_MAX);
+
+		CascadedShadowMap::Cascade cascade = CascadedShadowMap::FitCascade(cs2ws, tangentFOV_2, aspect, splits[i], splits[i + 1], ls2ws, resolution, casterMaxZ);
+
+		if (i < FIRST_CACHED_CASCADE)
+		{
+			shadowCascade.cascade = cascade;
+			shadowCascade.wsProjMatrix = CascadedShadowMap::AcquireProjection(cascade) * ws2ls;
+			shadowCascade.version++;
+		}
+		else
+		{
+			shadowCascade.framesSinceFit++;
+
+			if (lightChanged || shadowCascade.framesSinceFit >= CACHED_CASCADE_REFRESH_INTERVAL || !CascadedShadowMap::Contains(shadowCascade.cascade, cascade))
+			{
+				shadowCascade.cascade = CascadedShadowMap::FitCascade(cs2ws, tangentFOV_2, aspect, splits[i], splits[i + 1], ls2ws, resolution, casterMaxZ, CACHED_CASCADE_MARGIN);
+				shadowCascade.wsProjMatrix = CascadedShadowMap::AcquireProjection(shadowCascade.cascade) * ws2ls;
+				shadowCascade.framesSinceFit = 0;
+				shadowCascade.version++;
+			}
+			else if (pSpatialIndex != nullptr)
+			{
+				// Casters moving within or across a cached box have to show up in it
+				for (auto& box : pSpatialIndex->GetChangedBoxes())
+				{
+					if (CascadedShadowMap::Overlaps(shadowCascade.cascade, ls2ws, box.min, box.max))
+					{
+						shadowCascade.version++;
+						break;
+					}
+				}
+			}
+		}
+
+		// Each frame samples its own shadow maps, only those holding a stale version are rendered again
+		if (shadowCascade.frameVersions[frameIndex] != shadowCascade.version)
+		{
+			shadowCascade.frameVersions[frameIndex] = shadowCascade.version;
+			m_renderedCascadeMask |= 1 << i;
+
+			RenderWorkManager::GetInstance()->AddRenderStateMask((RenderWorkManager::RenderState)(RenderWorkManager::ShadowMapGen + i));
+			FrustumCuller::GetInstance()->SetView(RenderWorkManager::ShadowMapGen + i, CascadedShadowMap::AcquireFrustum(shadowCascade.cascade, ls2ws));
+		}
+
+		// Matrix of a cached cascade stays, camera doesn't, so camera to light ndc is updated every frame
+		pGlobalUniforms->SetMainLightVP(i, shadowCascade.wsProjMatrix * cs2ws);
+	}
+
+	pGlobalUniforms->SetMainLightCascadeSplits({ splits[1], splits[2], splits[3], splits[4] });
+}
+
+uint32_t DirectionLight::GetCascadeCount() const
+{
+	return SHADOW_CASCADES ? SHADOW_CASCADE_COUNT : 1;
 }
 
 void DirectionLight::SetLightColor(const Vector3d& lightColor)
@@ -84,16 +178,14 @@ void DirectionLight::Update()
 void DirectionLight::OnPreRender()
 {
 	UpdateData();
+	UpdateCascades();
 
 	// FIXME: Put main light stuff to per frame uniform
 	UniformData::GetInstance()->GetGlobalUniforms()->SetMainLightDir(m_csLightDirection);
-	UniformData::GetInstance()->GetGlobalUniforms()->SetMainLightVP(m_cs2lsProjMatrix);
 
 	if (m_isDirty)
 	{
 		UniformData::GetInstance()->GetGlobalUniforms()->SetMainLightColor(m_lightColor);
 		m_isDirty = false;
 	}
-}
-
-
+}
\ No newline at end of file
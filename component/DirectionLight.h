@@ -1,35 +1,65 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
+#include "../class/CascadedShadowMap.h"
+#include "../class/GlobalUniforms.h"
+#include <vector>
 
 class DirectionLight : public BaseComponent
 {
 	DECLARE_CLASS_RTTI(DirectionLight);
 
 public:
-	static const double DEFAULT_SHADOWMAP_SIZE;
-	static const double DEFAULT_FRUSTUM_SIZE;
-	static const double DEFAULT_FRUSTUM_LENGTH;
+	static const double DEFAULT_SHADOW_DISTANCE;
+
+	// Cascades from this one on are cached, nearer ones are fit and rendered every frame
+	static const uint32_t FIRST_CACHED_CASCADE = 2;
+
+	// A cached cascade is fit again after this many frames even if nothing asks for it
+	static const uint32_t CACHED_CASCADE_REFRESH_INTERVAL = 30;
+
+	// Cached cascades are fit this much larger, so that camera could move a while before slice leaves its box
+	static const double CACHED_CASCADE_MARGIN;
 
 protected:
-	bool Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, const Vector3d& frustumSize, const Vector2ui& shadowMapSize);
+	bool Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, double shadowDistance);
 
 public:
-	static std::shared_ptr<DirectionLight> Create(const Vector3d& lightColor, const Vector3d& frustumSize = { DEFAULT_FRUSTUM_SIZE, DEFAULT_FRUSTUM_SIZE, DEFAULT_FRUSTUM_LENGTH }, const Vector2ui& shadowMapSize = { (uint32_t)DEFAULT_SHADOWMAP_SIZE, (uint32_t)DEFAULT_SHADOWMAP_SIZE });
+	static std::shared_ptr<DirectionLight> Create(const Vector3d& lightColor, double shadowDistance = DEFAULT_SHADOW_DISTANCE);
 
 public:
 	void SetLightColor(const Vector3d& lightColor);
 
+	// Camera depth cascades reach, clamped by camera far plane
+	void SetShadowDistance(double shadowDistance) { m_shadowDistance = shadowDistance; }
+
+	// Cascades in use, "SHADOW_CASCADE_COUNT" or only cascade 0 if cascades are turned off
+	uint32_t GetCascadeCount() const;
+
+	// Bit i is set if cascade i is rendered this frame
+	uint32_t GetRenderedCascadeMask() const { return m_renderedCascadeMask; }
+
 	void Update() override;
 	void OnPreRender() override;
 
 protected:
 	void UpdateData();
+	void UpdateCascades();
 
 protected:
-	Vector3d	m_lightColor;
-	Vector3d	m_frustumSize;
-	Vector2ui	m_shadowMapSize;
-	Matrix4d	m_cs2lsProjMatrix;
-	Vector3d	m_csLightDirection;
+	typedef struct _ShadowCascade
+	{
+		CascadedShadowMap::Cascade	cascade;
+		Matrix4d					wsProjMatrix;		// World space to light ndc
+		uint32_t					framesSinceFit;
+		uint32_t					version;			// Bumped whenever shadow map content of this cascade goes stale
+		std::vector<uint32_t>		frameVersions;		// Version shadow map of each frame holds
+	}ShadowCascade;
+
+	Vector3d		m_lightColor;
+	double			m_shadowDistance;
+	Vector3d		m_csLightDirection;
+	ShadowCascade	m_cascades[SHADOW_CASCADE_COUNT];
+	Matrix4d		m_cachedLightTransform;				// Light transform cached cascades were fit with
+	uint32_t		m_renderedCascadeMask = 0;
 };
\ No newline at end of file
@@ -23,9 +23,17 @@
 #include "../vulkan/Framebuffer.h"
 #include "../class/UniformData.h"
 #include "../class/Material.h"
+#include "../class/FrustumCuller.h"
+#include "../class/OcclusionCuller.h"
+#include "../class/GPUCuller.h"
+#include "../class/StreamingManager.h"
+#include <algorithm>
 
 DEFINITE_CLASS_RTTI(MeshRenderer, BaseComponent);
 
+const float MeshRenderer::DEFAULT_LOD_ERROR_THRESHOLD = 0.001f;
+const float MeshRenderer::LOD_HYSTERESIS = 0.2f;
+
 std::shared_ptr<MeshRenderer> MeshRenderer::Create(const std::shared_ptr<Mesh> pMesh, const std::shared_ptr<MaterialInstance>& pMaterialInstance)
 {
 	std::shared_ptr<MeshRenderer> pMeshRenderer = std::make_shared<MeshRenderer>();
@@ -61,6 +69,7 @@ bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::s
 		return false;
 
 	m_pMesh = pMesh;
+	m_streamingResource = m_pMesh != nullptr ? StreamingManager::GetInstance()->AcquireMeshResource(m_pMesh) : StreamingScheduler::NONE;
 
 	for (auto & val : materialInstances)
 	{
@@ -77,6 +86,16 @@ bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::s
 	return true;
 }
 
+void MeshRenderer::OnAddedToObjectInternal(const std::shared_ptr<BaseObject>& pObject)
+{
+	if (m_pMesh == nullptr || !m_pMesh->HasBounds())
+		return;
+
+	const Vector3f& boxMin = m_pMesh->GetBoundingBoxMin();
+	const Vector3f& boxMax = m_pMesh->GetBoundingBoxMax();
+	pObject->AddLocalBounds(Vector3d(boxMin.x, boxMin.y, boxMin.z), Vector3d(boxMax.x, boxMax.y, boxMax.z));
+}
+
 void MeshRenderer::OnRenderObject()
 {
 	if (m_pMesh == nullptr)
@@ -86,19 +105,125 @@ void MeshRenderer::OnRenderObject()
 	if (m_instanceCount == 0)
 		return;
 
-	if (m_modelMatrixOverride)
+	Matrix4d modelMatrix = m_modelMatrixOverride ? m_overrideModelMatrix : GetBaseObject()->GetCachedWorldTransform();
+	m_modelMatrixOverride = false;
+
+	UniformData::GetInstance()->GetPerObjectUniforms()->SetModelMatrix(m_perObjectBufferIndex, modelMatrix);
+
+	// Bounding sphere in world space and its distance to camera, used for both LOD selection and sorting
+	const Vector4f& boundingSphere = m_pMesh->GetBoundingSphere();
+
+	double scale = 0;
+	for (uint32_t i = 0; i < 3; i++)
+		scale = std::max(scale, modelMatrix.c[i].xyz().Length());
+
+	Vector3d center = modelMatrix.TransformAsPoint(Vector3d(boundingSphere.x, boundingSphere.y, boundingSphere.z));
+	double radius = boundingSphere.w * scale;
+	double distance = (center - UniformData::GetInstance()->GetPerFrameUniforms()->GetCameraPosition()).Length();
+
+	m_currentLod = SelectLod(radius, distance);
+	m_cameraDistance = (float)distance;
+
+	double screenSize = distance <= radius ? 1.0 : radius * std::abs(UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix().y1) / distance;
+	m_screenCoverage = (float)std::min(screenSize * screenSize, 1.0);
+
+	// Box extents in world space: each axis gathers the reach of all 3 local axes
+	const Vector3f& boxMin = m_pMesh->GetBoundingBoxMin();
+	const Vector3f& boxMax = m_pMesh->GetBoundingBoxMax();
+	Vector3d localCenter = Vector3d((boxMin.x + boxMax.x) * 0.5, (boxMin.y + boxMax.y) * 0.5, (boxMin.z + boxMax.z) * 0.5);
+	Vector3d localExtents = Vector3d((boxMax.x - boxMin.x) * 0.5, (boxMax.y - boxMin.y) * 0.5, (boxMax.z - boxMin.z) * 0.5);
+
+	m_worldBoundingBoxCenter = modelMatrix.TransformAsPoint(localCenter);
+	for (uint32_t i = 0; i < 3; i++)
 	{
-		UniformData::GetInstance()->GetPerObjectUniforms()->SetModelMatrix(m_perObjectBufferIndex, m_overrideModelMatrix);
-		m_modelMatrixOverride = false;
+		m_worldBoundingBoxExtents[i] = 0;
+		for (uint32_t j = 0; j < 3; j++)
+			m_worldBoundingBoxExtents[i] += std::abs(modelMatrix.c[j][i]) * localExtents[j];
 	}
-	else
-		UniformData::GetInstance()->GetPerObjectUniforms()->SetModelMatrix(m_perObjectBufferIndex, GetBaseObject()->GetCachedWorldTransform());
+
+	// Bind pose bounds don't hold once skinned, and bounds of one instance say nothing about a manually instanced batch
+	bool frustumCulling = m_frustumCulling && m_pMesh->HasBounds() && m_pMesh->GetBoneCount() == 0 && m_instanceCount == 1;
+	uint32_t culledRenderStates = frustumCulling ? FrustumCuller::GetInstance()->GetCulledRenderStateMask() : 0;
+
+	if (m_pOccluder != nullptr && (RenderWorkManager::GetInstance()->GetRenderStateMask() & (1 << RenderWorkManager::Scene)) != 0)
+		OcclusionCuller::GetInstance()->SubmitOccluder(*m_pOccluder, modelMatrix);
+
+	// Out of view until render queue insertion says otherwise, what's around camera still gets a share of priority
+	if ((RenderWorkManager::GetInstance()->GetRenderStateMask() & (1 << RenderWorkManager::Scene)) != 0)
+		ReportStreamingVisibility(false);
+
+	// Materials culled on GPU take every instance, culling kernel finds bounds by per object index
+	GPUCuller::GetInstance()->SetObjectBounds(m_perObjectBufferIndex, m_worldBoundingBoxCenter, m_worldBoundingBoxExtents, frustumCulling);
+	InsertIntoRenderQueue(UINT32_MAX, true);
+
+	// Instances of render states without a view go in right away
+	InsertIntoRenderQueue(~culledRenderStates);
+
+	if ((culledRenderStates & RenderWorkManager::GetInstance()->GetRenderStateMask()) != 0)
+		FrustumCuller::GetInstance()->Submit(this, m_worldBoundingBoxCenter, m_worldBoundingBoxExtents, center, radius);
+}
+
+void MeshRenderer::InsertIntoRenderQueue(uint32_t renderStateMask, bool gpuCulledMaterials)
+{
+	std::shared_ptr<Mesh> pLod = m_pMesh->GetLod(m_currentLod);
+	bool visibleInScene = false;
 
 	for (uint32_t i = 0; i < m_materialInstances.size(); i++)
 	{
-		if ((RenderWorkManager::GetInstance()->GetRenderStateMask() & m_materialInstances[i]->GetRenderMask()) == 0)
+		if (m_materialInstances[i]->GetMaterial()->IsGPUCullingEnabled() != gpuCulledMaterials)
+			continue;
+
+		uint32_t renderMask = m_materialInstances[i]->GetRenderMask();
+		if ((RenderWorkManager::GetInstance()->GetRenderStateMask() & renderMask & renderStateMask) == 0)
 			continue;
 
-		m_materialInstances[i]->InsertIntoRenderQueue(m_pMesh, m_perObjectBufferIndex, m_pMesh->GetMeshChunkIndex(), m_utilityIndex, m_instanceCount, m_startInstance);
+		m_materialInstances[i]->InsertIntoRenderQueue(pLod, m_perObjectBufferIndex, pLod->GetMeshChunkIndex(), m_utilityIndex, m_instanceCount, m_startInstance, m_cameraDistance);
+
+		RenderWorkManager::GetInstance()->AddLodStatistics(m_pMesh->GetIndicesCount() / 3 * m_instanceCount, pLod->GetIndicesCount() / 3 * m_instanceCount);
+
+		visibleInScene |= (renderMask & renderStateMask & (1 << RenderWorkManager::Scene)) != 0;
+	}
+
+	// Instances culled on GPU count as visible, they're only known to be culled after the fact
+	if (visibleInScene)
+		ReportStreamingVisibility(true);
+}
+
+void MeshRenderer::ReportStreamingVisibility(bool visible) const
+{
+	StreamingManager::GetInstance()->ReportVisibility(m_streamingResource, m_screenCoverage, m_cameraDistance, visible);
+
+	for (auto& pMaterialInstance : m_materialInstances)
+	{
+		for (auto& textureResource : pMaterialInstance->GetTextureStreamingResources())
+		{
+			if (textureResource.second != StreamingScheduler::NONE)
+				StreamingManager::GetInstance()->ReportVisibility(textureResource.second, m_screenCoverage, m_cameraDistance, visible);
+		}
+	}
+}
+
+uint32_t MeshRenderer::SelectLod(double radius, double distance) const
+{
+	if (m_pMesh->GetLodCount() == 1)
+		return 0;
+
+	// Camera inside bounding sphere
+	if (distance <= radius)
+		return 0;
+
+	// Diameter of bounding sphere over screen height at that distance, projection y scale is cot(fov_v / 2)
+	double screenSize = radius * std::abs(UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix().y1) / distance;
+
+	// LOD error is relative to bounding sphere radius, so its projection over screen height is "error * screenSize / 2"
+	for (uint32_t lod = m_pMesh->GetLodCount() - 1; lod > 0; lod--)
+	{
+		double threshold = m_lodErrorThreshold;
+		if (lod > m_currentLod)
+			threshold *= 1.0 - LOD_HYSTERESIS;
+
+		if (m_pMesh->GetLodError(lod) * screenSize * 0.5 <= threshold)
+			return lod;
 	}
+	return 0;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
+#include "../class/OcclusionBuffer.h"
 
 class Mesh;
 class Material;
@@ -12,6 +13,12 @@ class MeshRenderer : public BaseComponent
 {
 	DECLARE_CLASS_RTTI(MeshRenderer);
 
+	// Projected simplification error a LOD is allowed to have, in fraction of screen height, roughly 1 pixel at 1080p
+	static const float DEFAULT_LOD_ERROR_THRESHOLD;
+
+	// Going to a coarser LOD needs error to drop this much below threshold, so that LOD doesn't flicker around boundary
+	static const float LOD_HYSTERESIS;
+
 public:
 	static std::shared_ptr<MeshRenderer> Create(const std::shared_ptr<Mesh> pMesh, const std::shared_ptr<MaterialInstance>& pMaterialInstance);
 	static std::shared_ptr<MeshRenderer> Create(const std::shared_ptr<Mesh> pMesh, const std::vector<std::shared_ptr<MaterialInstance>>& materialInstances);
@@ -31,10 +38,40 @@ public:
 	uint32_t GetUtilityIndex() const { return m_utilityIndex; }
 	void SetUtilityIndex(uint32_t index) { m_utilityIndex = index; }
 	void OverrideModelMatrix(const Matrix4d& matrix) { m_overrideModelMatrix = matrix; m_modelMatrixOverride = true; }
+	uint32_t GetCurrentLod() const { return m_currentLod; }
+	float GetLodErrorThreshold() const { return m_lodErrorThreshold; }
+	void SetLodErrorThreshold(float threshold) { m_lodErrorThreshold = threshold; }
+
+	// Renderers that don't live where their transform says, like sky box, have to opt out
+	bool IsFrustumCullingEnabled() const { return m_frustumCulling; }
+	void SetFrustumCullingEnabled(bool enabled) { m_frustumCulling = enabled; }
+
+	// Occluder geometry is rasterized for occlusion culling of main camera, it has to stay inside what this renderer draws
+	std::shared_ptr<OcclusionBuffer::Occluder> GetOccluder() const { return m_pOccluder; }
+	void SetOccluder(const std::shared_ptr<OcclusionBuffer::Occluder>& pOccluder) { m_pOccluder = pOccluder; }
+
+	// World space bounding box of last "OnRenderObject"
+	const Vector3d& GetWorldBoundingBoxCenter() const { return m_worldBoundingBoxCenter; }
+	const Vector3d& GetWorldBoundingBoxExtents() const { return m_worldBoundingBoxExtents; }
+
+	// Insert material instances drawn in any of "renderStateMask" into render queue
+	// Those of render states with a view wait for "FrustumCuller" to tell which views see this renderer
+	// Instances of materials culled on GPU are only taken when "gpuCulledMaterials" is set, and the other way around
+	void InsertIntoRenderQueue(uint32_t renderStateMask, bool gpuCulledMaterials = false);
 
 protected:
 	bool Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::shared_ptr<Mesh> pMesh, const std::vector<std::shared_ptr<MaterialInstance>>& materialInstances);
 
+	// Pick the coarsest LOD whose error, projected with main camera, stays within threshold
+	// "radius" and "distance" are of world space bounding sphere
+	uint32_t SelectLod(double radius, double distance) const;
+
+	// Tell "StreamingManager" how much of main camera's screen this renderer covers, for its mesh and every texture its materials use
+	void ReportStreamingVisibility(bool visible) const;
+
+	// Mesh bounding box becomes part of object's bounds, so that object gets into scene's spatial index
+	void OnAddedToObjectInternal(const std::shared_ptr<BaseObject>& pObject) override;
+
 protected:
 	std::shared_ptr<Mesh>	m_pMesh;
 	uint32_t				m_perObjectBufferIndex;
@@ -58,4 +95,16 @@ protected:
 
 	bool					m_modelMatrixOverride = false;
 	Matrix4d				m_overrideModelMatrix;
+
+	uint32_t				m_currentLod = 0;
+	float					m_lodErrorThreshold = DEFAULT_LOD_ERROR_THRESHOLD;
+	float					m_cameraDistance = 0;
+	float					m_screenCoverage = 0;	// Bounding sphere diameter over screen height, squared
+	uint32_t				m_streamingResource;
+
+	bool					m_frustumCulling = true;
+	Vector3d				m_worldBoundingBoxCenter;
+	Vector3d				m_worldBoundingBoxExtents;
+
+	std::shared_ptr<OcclusionBuffer::Occluder>	m_pOccluder;
 };
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "PhysicalCamera.h"
 #include "../Base/BaseObject.h"
 #include "../class/UniformData.h"
+#include "../class/FrustumCuller.h"
+#include "../class/OcclusionCuller.h"
+#include "../class/GPUCuller.h"
+#include "../class/RenderWorkManager.h"
 
 DEFINITE_CLASS_RTTI(PhysicalCamera, BaseComponent);
 
@@ -34,6 +38,13 @@ void PhysicalCamera::OnPreRender()
 	UpdateCameraProps();
 	UpdateViewMatrix();
 	UpdateProjMatrix();
+
+	// Projection is up to date only after "UpdateProjMatrix"
+	if (!m_pObject.expired())
+	{
+		OcclusionCuller::GetInstance()->SetView(GetBaseObject()->GetCachedWorldTransform(), UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix());
+		GPUCuller::GetInstance()->SetOcclusionView(GetBaseObject()->GetCachedWorldTransform(), UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix());
+	}
 }
 
 void PhysicalCamera::UpdateViewMatrix()
@@ -46,6 +57,12 @@ void PhysicalCamera::UpdateViewMatrix()
 	Matrix4d matrix = m_pObject.lock()->GetCachedWorldTransform();
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetCameraDirection(matrix[2].xyz().Negative());
 
+	// Frustum goes first, "Inverse" below works in place
+	PyramidFrustumd worldFrustum = m_frustum;
+	worldFrustum.Transform(matrix);
+	FrustumCuller::GetInstance()->SetView(RenderWorkManager::Scene, worldFrustum, true);
+	GPUCuller::GetInstance()->SetView(worldFrustum);
+
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetViewCoordinateSystem(matrix);
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetViewMatrix(matrix.Inverse());
 }
@@ -174,6 +191,8 @@ void PhysicalCamera::SetFarPlane(double farPlane)
 {
 	m_props.farPlane = farPlane;
 
+	m_frustum = { {0, 0, 0}, {0, 0, -1}, m_supplementProps.verticalFOV_2, m_props.aspect, m_supplementProps.fixedNearPlane, m_props.farPlane };
+
 	m_projDirty = true;
 	m_propDirty = true;
 }
@@ -196,7 +215,7 @@ void PhysicalCamera::UpdateCameraSupplementProps()
 	m_supplementProps.fixedNearPlaneHeight = m_supplementProps.fixedNearPlane * m_supplementProps.filmHeight / m_props.focalLength;	// 2 * n * tan(FOV_2)
 	m_supplementProps.fixedNearPlaneWidth = m_supplementProps.fixedNearPlaneHeight * m_props.aspect;
 
-	m_frustum = { {0, 0, 0}, {0, 0, -1}, m_supplementProps.verticalFOV_2, m_props.aspect };
+	m_frustum = { {0, 0, 0}, {0, 0, -1}, m_supplementProps.verticalFOV_2, m_props.aspect, m_supplementProps.fixedNearPlane, m_props.farPlane };
 
 	m_projDirty = true;
 	m_propDirty = true;
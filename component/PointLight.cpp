@@ -0,0 +1,30 @@
+#include "PointLight.h"
+#include "../Base/BaseObject.h"
+#include "../class/ClusteredLighting.h"
+
+DEFINITE_CLASS_RTTI(PointLight, BaseComponent);
+
+bool PointLight::Init(const std::shared_ptr<PointLight>& pLight, const Vector3d& lightColor, double range)
+{
+	if (!BaseComponent::Init(pLight))
+		return false;
+
+	m_lightColor = lightColor;
+	m_range = range;
+
+	return true;
+}
+
+std::shared_ptr<PointLight> PointLight::Create(const Vector3d& lightColor, double range)
+{
+	std::shared_ptr<PointLight> pLight = std::make_shared<PointLight>();
+	if (pLight.get() && pLight->Init(pLight, lightColor, range))
+		return pLight;
+
+	return nullptr;
+}
+
+void PointLight::OnPreRender()
+{
+	ClusteredLighting::GetInstance()->SubmitPointLight(GetBaseObject()->GetCachedWorldPosition(), m_range, m_lightColor);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#include "../Base/BaseComponent.h"
+#include "../Maths/Matrix.h"
+
+// Light at owner's position reaching every direction, shaded through clustered lighting, casts no shadow
+class PointLight : public BaseComponent
+{
+	DECLARE_CLASS_RTTI(PointLight);
+
+protected:
+	bool Init(const std::shared_ptr<PointLight>& pLight, const Vector3d& lightColor, double range);
+
+public:
+	static std::shared_ptr<PointLight> Create(const Vector3d& lightColor, double range);
+
+public:
+	void SetLightColor(const Vector3d& lightColor) { m_lightColor = lightColor; }
+	Vector3d GetLightColor() const { return m_lightColor; }
+
+	// Distance light fades out to 0
+	void SetRange(double range) { m_range = range; }
+	double GetRange() const { return m_range; }
+
+	void OnPreRender() override;
+
+protected:
+	Vector3d	m_lightColor;
+	double		m_range;
+};
\ No newline at end of file
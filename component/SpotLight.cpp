@@ -0,0 +1,33 @@
+#include "SpotLight.h"
+#include "../Base/BaseObject.h"
+#include "../class/ClusteredLighting.h"
+
+DEFINITE_CLASS_RTTI(SpotLight, BaseComponent);
+
+bool SpotLight::Init(const std::shared_ptr<SpotLight>& pLight, const Vector3d& lightColor, double range, double innerAngle, double outerAngle)
+{
+	if (!BaseComponent::Init(pLight))
+		return false;
+
+	m_lightColor = lightColor;
+	m_range = range;
+	SetConeAngles(innerAngle, outerAngle);
+
+	return true;
+}
+
+std::shared_ptr<SpotLight> SpotLight::Create(const Vector3d& lightColor, double range, double innerAngle, double outerAngle)
+{
+	std::shared_ptr<SpotLight> pLight = std::make_shared<SpotLight>();
+	if (pLight.get() && pLight->Init(pLight, lightColor, range, innerAngle, outerAngle))
+		return pLight;
+
+	return nullptr;
+}
+
+void SpotLight::OnPreRender()
+{
+	// light space 2 world space, light shines along its -z
+	Matrix4d ls2ws = GetBaseObject()->GetCachedWorldTransform();
+	ClusteredLighting::GetInstance()->SubmitSpotLight(GetBaseObject()->GetCachedWorldPosition(), -ls2ws[2].xyz(), m_range, m_innerAngle, m_outerAngle, m_lightColor);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include "../Base/BaseComponent.h"
+#include "../Maths/Matrix.h"
+
+// Light at owner's position shining along its -z within a cone, shaded through clustered lighting, casts no shadow
+class SpotLight : public BaseComponent
+{
+	DECLARE_CLASS_RTTI(SpotLight);
+
+protected:
+	bool Init(const std::shared_ptr<SpotLight>& pLight, const Vector3d& lightColor, double range, double innerAngle, double outerAngle);
+
+public:
+	// Angles are half angles of cone in radian, light falls off from inner to outer one
+	static std::shared_ptr<SpotLight> Create(const Vector3d& lightColor, double range, double innerAngle, double outerAngle);
+
+public:
+	void SetLightColor(const Vector3d& lightColor) { m_lightColor = lightColor; }
+	Vector3d GetLightColor() const { return m_lightColor; }
+
+	// Distance light fades out to 0
+	void SetRange(double range) { m_range = range; }
+	double GetRange() const { return m_range; }
+
+	void SetConeAngles(double innerAngle, double outerAngle) { m_innerAngle = innerAngle; m_outerAngle = outerAngle; }
+
+	void OnPreRender() override;
+
+protected:
+	Vector3d	m_lightColor;
+	double		m_range;
+	double		m_innerAngle;
+	double		m_outerAngle;
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 from pathlib import Path
 import os
+import struct
 
 def compile_shader(abs_path, ext):
 
@@ -22,11 +23,54 @@ def compile_shader(abs_path, ext):
 			print(cmd)
 			os.system(cmd)
 
+		if _file in ['pbr_gbuffer_gen.vert', 'pbr_gbuffer_gen_skinned.vert', 'shadow_map_gen.vert', 'shadow_map_gen_skinned.vert']:
+			cmd = 'glslc ' + path_in_string + ' -DPACKED_VERTEX -o ' + path_in_string[:-len('.vert')] + '_packed.vert.spv'
+			print(cmd)
+			os.system(cmd)
+
+			cmd = 'glslc ' + path_in_string + ' -DPACKED_VERTEX -DPER_DRAW_PUSH_CONSTANTS -o ' + path_in_string[:-len('.vert')] + '_packed_push.vert.spv'
+			print(cmd)
+			os.system(cmd)
+
+		# For materials drawing with "PerDrawData_PushConstants"
+		if _file in ['pbr_gbuffer_gen.vert', 'pbr_gbuffer_gen_skinned.vert', 'shadow_map_gen.vert', 'shadow_map_gen_skinned.vert', 'pbr_gbuffer_planet.vert', 'simple.vert']:
+			cmd = 'glslc ' + path_in_string + ' -DPER_DRAW_PUSH_CONSTANTS -o ' + path_in_string[:-len('.vert')] + '_push.vert.spv'
+			print(cmd)
+			os.system(cmd)
+
 		cmd = 'glslc ' + path_in_string + ' -o ' + path_in_string + '.spv'
 		print(cmd)
 		os.system(cmd)
 	
+# Pack all SPIR-V into one archive ShaderLibrary maps at startup, layout has to match ShaderLibrary.h
+# header(magic, version, entries count, reserved), entries(name offset, name length, code offset, code bytes), names, code
+def pack_shaders(abs_path, archive_name):
+
+	spv_list = sorted(Path(abs_path).glob('**/*.spv'))
+	names = [path.relative_to(abs_path).as_posix().encode('ascii') for path in spv_list]
+
+	name_offset = 16 + 16 * len(spv_list)
+	code_offset = (name_offset + sum(len(name) for name in names) + 3) // 4 * 4
+
+	entries = b''
+	name_table = b''
+	code_table = b''
+	for path, name in zip(spv_list, names):
+		code = path.read_bytes()
+		entries += struct.pack('<4I', name_offset + len(name_table), len(name), code_offset + len(code_table), len(code))
+		name_table += name
+		code_table += code + b'\0' * (-len(code) % 4)
+
+	name_table += b'\0' * (code_offset - name_offset - len(name_table))
+
+	with open(os.path.join(abs_path, archive_name), 'wb') as archive:
+		archive.write(struct.pack('<4I', 0x41534c56, 1, len(spv_list), 0) + entries + name_table + code_table)
+
+	print('packed ' + str(len(spv_list)) + ' shaders into ' + archive_name)
+
 cur_path = os.path.dirname(os.path.abspath(__file__))
 	
 compile_shader(cur_path, 'vert')
-compile_shader(cur_path, 'frag')
\ No newline at end of file
+compile_shader(cur_path, 'frag')
+compile_shader(cur_path, 'comp')
+pack_shaders(cur_path, 'shaders.vlsa')
\ No newline at end of file
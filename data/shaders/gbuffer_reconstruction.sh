@@ -37,11 +37,11 @@ vec3 ReconstructCSPosition(in ivec2 coord, in vec2 oneNearPosition, in sampler2D
 	return vec3(oneNearPosition * abs(linearDepth), linearDepth);
 }
 
-float AcquireShadowFactor(vec4 csPosition, sampler2D ShadowMapDepthBuffer)
+float AcquireShadowFactor(vec4 csPosition, mat4 mainLightVP, sampler2D ShadowMapDepthBuffer)
 {
 	// The view matrix in main light VP needs to be the transfrom from main camera space rather than world space
 	// Doing this to avoid large number of world space position in a large scale scene
-	vec4 lsPosition = globalData.mainLightVP * csPosition;
+	vec4 lsPosition = mainLightVP * csPosition;
 	lsPosition /= lsPosition.w;
 	lsPosition.xy = lsPosition.xy * 0.5f + 0.5f;	// NOTE: Don't do this to z, as it's already within [0, 1] after vulkan ndc transform
 
@@ -104,7 +104,7 @@ GBufferVariables UnpackGBuffers(ivec2 coord, vec2 oneNearPosition, sampler2D GBu
 	return vars;
 }
 
-GBufferVariables UnpackGBuffers(ivec2 coord, vec2 texcoord, vec2 oneNearPosition, sampler2D GBuffer0, sampler2D GBuffer1, sampler2D GBuffer2, sampler2D DepthStencilBuffer, sampler2D BlurredSSAOBuffer, sampler2D ShadowMapDepthBuffer)
+GBufferVariables UnpackGBuffers(ivec2 coord, vec2 texcoord, vec2 oneNearPosition, sampler2D GBuffer0, sampler2D GBuffer1, sampler2D GBuffer2, sampler2D DepthStencilBuffer, sampler2D BlurredSSAOBuffer)
 {
 	GBufferVariables vars;
 
@@ -123,7 +123,8 @@ GBufferVariables UnpackGBuffers(ivec2 coord, vec2 texcoord, vec2 oneNearPosition
 
 	vars.metalic = gbuffer2.g;
 
-	vars.shadowFactor = AcquireShadowFactor(vars.csPosition, ShadowMapDepthBuffer);
+	// Shadow cascades live in separate samplers, it's up to caller to pick one
+	vars.shadowFactor = 1.0f;
 
 	vars.ssaoFactor = texture(BlurredSSAOBuffer, texcoord).r;
 
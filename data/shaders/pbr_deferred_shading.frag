@@ -14,7 +14,7 @@ layout (set = 3, binding = 4) uniform sampler2D GBuffer1[3];
 layout (set = 3, binding = 5) uniform sampler2D GBuffer2[3];
 layout (set = 3, binding = 6) uniform sampler2D MotionVector[3];
 layout (set = 3, binding = 7) uniform sampler2D DepthStencilBuffer[3];
-layout (set = 3, binding = 8) uniform sampler2D ShadowMapDepthBuffer[3];
+layout (set = 3, binding = 8) uniform sampler2D ShadowMapDepthBuffer[3 * SHADOW_CASCADE_COUNT];	// Frames of a cascade are next to each other, cascade 0 comes first
 layout (set = 3, binding = 9) uniform sampler2D BlurredSSAOBuffer[3];
 layout (set = 3, binding = 10) uniform sampler2D SSRInfo[3];
 
@@ -109,11 +109,88 @@ vec4 CalculateSSR(vec3 n, vec3 v, float NdotV, vec4 albedoRoughness, vec3 CSPosi
 	return SSRRadiance;
 }
 
+// Cluster pixel falls in, -1 if it's beyond last slice
+int AcquireLightCluster(vec3 csPosition)
+{
+	float csDepth = -csPosition.z;
+	if (csDepth <= 0.0f)
+		return -1;
+
+	int slice = 0;
+	if (csDepth >= clusterSettings.x)
+		slice = 1 + int(floor(log(csDepth / clusterSettings.x) * clusterSettings.y));
+	if (slice >= LIGHT_CLUSTER_Z)
+		return -1;
+
+	// Same tiles CPU assigned lights to, tile 0 is at left top
+	vec2 ndc = vec2(csPosition.x, -csPosition.y) / (csDepth * globalData.MainCameraSettings3.xy);
+	ivec2 tile = clamp(ivec2(floor((ndc * 0.5f + 0.5f) * vec2(LIGHT_CLUSTER_X, LIGHT_CLUSTER_Y))), ivec2(0), ivec2(LIGHT_CLUSTER_X - 1, LIGHT_CLUSTER_Y - 1));
+
+	return (slice * LIGHT_CLUSTER_Y + tile.y) * LIGHT_CLUSTER_X + tile.x;
+}
+
+// Point and spot lights of pixel's cluster, windowed inverse square fall off reaching 0 at light range
+vec3 CalculateClusteredLights(vec3 csPosition, vec3 n, vec3 v, float NdotV, vec4 albedoRoughness, float metalic)
+{
+	vec3 radiance = vec3(0);
+
+	int cluster = AcquireLightCluster(csPosition);
+	if (cluster < 0)
+		return radiance;
+
+	uvec2 range = clusterLightRanges[cluster];
+	for (uint i = range.x; i < range.x + range.y; i++)
+	{
+		LightData light = lightData[clusterLightIndices[i]];
+
+		vec3 toLight = light.positionRange.xyz - csPosition;
+		float distanceSquared = dot(toLight, toLight);
+		float rangeRatio = distanceSquared / (light.positionRange.w * light.positionRange.w);
+		float window = clamp(1.0f - rangeRatio * rangeRatio, 0.0f, 1.0f);
+		float attenuation = window * window / max(distanceSquared, 1e-4);
+
+		vec3 l = toLight * inversesqrt(max(distanceSquared, 1e-8));
+		if (uint(light.colorType.w) == LIGHT_TYPE_SPOT)
+		{
+			float cone = clamp(dot(-l, light.direction.xyz) * light.spotScaleOffset.x + light.spotScaleOffset.y, 0.0f, 1.0f);
+			attenuation *= cone * cone;
+		}
+
+		float NdotL = max(0.0f, dot(n, l));
+		if (attenuation * NdotL <= 0.0f)
+			continue;
+
+		vec3 h = normalize(l + v);
+		float NdotH = max(0.0f, dot(n, h));
+		float LdotH = max(0.0f, dot(l, h));
+
+		vec3 fresnel = Fresnel_Schlick(F0, LdotH);
+		vec3 kD = (1.0 - metalic) * (vec3(1.0) - fresnel);
+
+		vec3 specular = fresnel * G_SchlicksmithGGX(NdotL, NdotV, albedoRoughness.a) * min(1.0f, GGX_D(NdotH, albedoRoughness.a)) / (4.0f * NdotL * NdotV + 0.001f);
+		vec3 diffuse = albedoRoughness.rgb * kD / PI;
+		radiance += (specular + diffuse) * NdotL * attenuation * light.colorType.rgb;
+	}
+
+	return radiance;
+}
+
 void main() 
 {
 	ivec2 coord = ivec2(floor(inUv * globalData.gameWindowSize.xy));
 
-	GBufferVariables vars = UnpackGBuffers(coord, inUv, inOneNearPosition, GBuffer0[frameIndex], GBuffer1[frameIndex], GBuffer2[frameIndex], DepthStencilBuffer[frameIndex], BlurredSSAOBuffer[frameIndex], ShadowMapDepthBuffer[frameIndex]);
+	GBufferVariables vars = UnpackGBuffers(coord, inUv, inOneNearPosition, GBuffer0[frameIndex], GBuffer1[frameIndex], GBuffer2[frameIndex], DepthStencilBuffer[frameIndex], BlurredSSAOBuffer[frameIndex]);
+
+	// First cascade reaching pixel's depth, nothing is shadowed beyond the last one
+	float csDepth = -vars.csPosition.z;
+	for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		if (csDepth <= globalData.mainLightCascadeSplits[i])
+		{
+			vars.shadowFactor = AcquireShadowFactor(vars.csPosition, MainLightVP(i), ShadowMapDepthBuffer[i * 3 + frameIndex]);
+			break;
+		}
+	}
 
 	if (length(vars.normalAO.xyz) > 1.1f)
 		discard;
@@ -166,6 +243,7 @@ void main()
 	vec3 dirLightSpecular = fresnel * G_SchlicksmithGGX(NdotL, NdotV, vars.albedoRoughness.a) * min(1.0f, GGX_D(NdotH, vars.albedoRoughness.a)) / (4.0f * NdotL * NdotV + 0.001f);
 	vec3 dirLightDiffuse = vars.albedoRoughness.rgb * kD / PI;
 	vec3 punctualRadiance = vars.shadowFactor * ((dirLightSpecular + dirLightDiffuse) * NdotL * globalData.mainLightColor.rgb);
+	punctualRadiance += CalculateClusteredLights(vars.csPosition.xyz, n, v, NdotV, vars.albedoRoughness, vars.metalic);
 
 	outShadingColor = vec4(punctualRadiance, vars.albedoRoughness.a);
 	outSSRColor = vec4(skyBoxAmbient, SSRRadiance.a);
@@ -4,9 +4,17 @@
 #extension GL_ARB_shading_language_420pack : enable
 
 layout (location = 0) in vec3 inPos;
+#if defined(PACKED_VERTEX)
+layout (location = 1) in vec2 inNormal;
+#else
 layout (location = 1) in vec3 inNormal;
+#endif
 layout (location = 3) in vec2 inUv;
+#if defined(PACKED_VERTEX)
+layout (location = 4) in vec2 inTangent;
+#else
 layout (location = 4) in vec3 inTangent;
+#endif
 
 layout (location = 0) out vec2 outUv;
 layout (location = 1) out vec3 outCSNormal;
@@ -27,17 +35,30 @@ void main()
 
 	perObjectIndex = objectDataIndex[indirectIndex].perObjectIndex;
 
-	gl_Position = perObjectData[perObjectIndex].MVP * vec4(inPos.xyz, 1.0);
+#if defined(PACKED_VERTEX)
+	int perMeshIndex = objectDataIndex[indirectIndex].perMeshIndex;
+	vec3 position = DequantizePosition(inPos, perMeshIndex);
+	vec3 normal = OctDecode(inNormal);
+	vec3 tangent = OctDecode(inTangent);
+	vec2 uv = DequantizeTexCoord(inUv, perMeshIndex);
+#else
+	vec3 position = inPos;
+	vec3 normal = inNormal;
+	vec3 tangent = inTangent;
+	vec2 uv = inUv;
+#endif
 
-	outCSNormal = normalize(vec3(perObjectData[perObjectIndex].MV * vec4(inNormal, 0.0)));
-	outCSPosition = (perObjectData[perObjectIndex].MV * vec4(inPos, 1.0)).xyz;
-	outPrevCSPosition = (perObjectData[perObjectIndex].prevMV * vec4(inPos.xyz, 1.0)).xyz;
+	gl_Position = perObjectData[perObjectIndex].MVP * vec4(position.xyz, 1.0);
+
+	outCSNormal = normalize(vec3(perObjectData[perObjectIndex].MV * vec4(normal, 0.0)));
+	outCSPosition = (perObjectData[perObjectIndex].MV * vec4(position, 1.0)).xyz;
+	outPrevCSPosition = (perObjectData[perObjectIndex].prevMV * vec4(position.xyz, 1.0)).xyz;
 	outScreenPosition = gl_Position.xy / gl_Position.w;
 
-	outUv = inUv;
-	outUv.t = 1.0 - inUv.t;
+	outUv = uv;
+	outUv.t = 1.0 - uv.t;
 
-	outCSTangent = normalize(vec3(perObjectData[perObjectIndex].MV * vec4(inTangent, 0.0)));
+	outCSTangent = normalize(vec3(perObjectData[perObjectIndex].MV * vec4(tangent, 0.0)));
 	outCSBitangent = normalize(cross(outCSNormal, outCSTangent));
 
 	perMaterialIndex = objectDataIndex[indirectIndex].perMaterialIndex;
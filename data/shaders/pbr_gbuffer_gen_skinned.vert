@@ -4,9 +4,17 @@
 #extension GL_ARB_shading_language_420pack : enable
 
 layout (location = 0) in vec3 inPos;
+#if defined(PACKED_VERTEX)
+layout (location = 1) in vec2 inNormal;
+#else
 layout (location = 1) in vec3 inNormal;
+#endif
 layout (location = 3) in vec2 inUv;
+#if defined(PACKED_VERTEX)
+layout (location = 4) in vec2 inTangent;
+#else
 layout (location = 4) in vec3 inTangent;
+#endif
 layout (location = 5) in vec4 inBoneWeight;
 layout (location = 6) in uint inBoneIndices;
 
@@ -32,6 +40,19 @@ void main()
 
 	int perAnimationChunkIndex = objectDataIndex[indirectIndex].utilityIndex;
 
+#if defined(PACKED_VERTEX)
+	int perMeshIndex = objectDataIndex[indirectIndex].perMeshIndex;
+	vec3 position = DequantizePosition(inPos, perMeshIndex);
+	vec3 normal = OctDecode(inNormal);
+	vec3 tangent = OctDecode(inTangent);
+	vec2 uv = DequantizeTexCoord(inUv, perMeshIndex);
+#else
+	vec3 position = inPos;
+	vec3 normal = inNormal;
+	vec3 tangent = inTangent;
+	vec2 uv = inUv;
+#endif
+
 	vec4 bone_weights = inBoneWeight;
 	uvec4 boneIndices = uvec4(perFrameBoneChunkIndirect[animationData[perAnimationChunkIndex].boneChunkIndexOffset + (inBoneIndices >> 0) & 255],
 								perFrameBoneChunkIndirect[animationData[perAnimationChunkIndex].boneChunkIndexOffset + (inBoneIndices >> 8) & 255],
@@ -91,10 +112,10 @@ void main()
 	len = length(prevDQ[0]);
 	prevDQ /= len;
 
-	vec3 animated_pos = DualQuaternionTransformPoint(currDQ, inPos);
-	vec3 prev_animated_pos = DualQuaternionTransformPoint(prevDQ, inPos);
-	vec3 animated_normal = DualQuaternionTransformVector(currDQ, inNormal);
-	vec3 animated_tangent = DualQuaternionTransformVector(currDQ, inTangent);
+	vec3 animated_pos = DualQuaternionTransformPoint(currDQ, position);
+	vec3 prev_animated_pos = DualQuaternionTransformPoint(prevDQ, position);
+	vec3 animated_normal = DualQuaternionTransformVector(currDQ, normal);
+	vec3 animated_tangent = DualQuaternionTransformVector(currDQ, tangent);
 
 	gl_Position = perObjectData[perObjectIndex].MVP * vec4(animated_pos.xyz, 1.0);
 
@@ -103,8 +124,8 @@ void main()
 	outPrevCSPosition = (perObjectData[perObjectIndex].prevMV * vec4(prev_animated_pos.xyz, 1.0)).xyz;
 	outScreenPosition = gl_Position.xy / gl_Position.w;
 
-	outUv = inUv;
-	outUv.t = 1.0 - inUv.t;
+	outUv = uv;
+	outUv.t = 1.0 - uv.t;
 
 	outCSTangent = normalize(vec3(perObjectData[perObjectIndex].MV * vec4(animated_tangent, 0.0)));
 	outCSBitangent = normalize(cross(outCSNormal, outCSTangent));
@@ -8,9 +8,27 @@ layout (location = 0) in vec3 inPos;
 #include "uniform_layout.sh"
 #include "utilities.sh"
 
+struct ShadowMapVariables
+{
+	float cascadeIndex;
+};
+
+layout(set = 3, binding = 0) buffer MaterialUniforms
+{
+	ShadowMapVariables variables[];
+};
+
 void main() 
 {
-	int perObjectIndex = objectDataIndex[GetIndirectIndex(gl_DrawID, gl_InstanceIndex)].perObjectIndex;
+	int indirectIndex = GetIndirectIndex(gl_DrawID, gl_InstanceIndex);
+	int perObjectIndex = objectDataIndex[indirectIndex].perObjectIndex;
+	int cascade = int(variables[objectDataIndex[indirectIndex].perMaterialIndex].cascadeIndex);
+
+#if defined(PACKED_VERTEX)
+	vec3 position = DequantizePosition(inPos, objectDataIndex[indirectIndex].perMeshIndex);
+#else
+	vec3 position = inPos;
+#endif
 
-	gl_Position = globalData.mainLightVP * perObjectData[perObjectIndex].MV * vec4(inPos.xyz, 1.0);
+	gl_Position = MainLightVP(cascade) * perObjectData[perObjectIndex].MV * vec4(position.xyz, 1.0);
 }
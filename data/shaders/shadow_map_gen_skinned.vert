@@ -11,14 +11,31 @@ layout (location = 6) in uint inBoneIndices;
 #include "quaternion.sh"
 #include "utilities.sh"
 
+struct ShadowMapVariables
+{
+	float cascadeIndex;
+};
+
+layout(set = 3, binding = 0) buffer MaterialUniforms
+{
+	ShadowMapVariables variables[];
+};
+
 void main() 
 {
 	int indirectIndex = GetIndirectIndex(gl_DrawID, gl_InstanceIndex);
 
 	int perObjectIndex = objectDataIndex[indirectIndex].perObjectIndex;
+	int cascade = int(variables[objectDataIndex[indirectIndex].perMaterialIndex].cascadeIndex);
 
 	int perAnimationChunkIndex = objectDataIndex[indirectIndex].utilityIndex;
 
+#if defined(PACKED_VERTEX)
+	vec3 position = DequantizePosition(inPos, objectDataIndex[indirectIndex].perMeshIndex);
+#else
+	vec3 position = inPos;
+#endif
+
 	vec4 bone_weights = inBoneWeight;
 
 	mat2x4 dq0 = perFrameBoneData[perFrameBoneChunkIndirect[animationData[perAnimationChunkIndex].boneChunkIndexOffset + (inBoneIndices >> 0) & 255]].currAnimationDQ;
@@ -52,7 +69,7 @@ void main()
 	float len = length(result[0]);
 	result /= len;
 
-	vec3 animated_pos = DualQuaternionTransformPoint(result, inPos);
+	vec3 animated_pos = DualQuaternionTransformPoint(result, position);
 
-	gl_Position = globalData.mainLightVP * perObjectData[perObjectIndex].MV * vec4(animated_pos, 1.0);
+	gl_Position = MainLightVP(cascade) * perObjectData[perObjectIndex].MV * vec4(animated_pos, 1.0);
 }
@@ -30,6 +30,50 @@ float rayTraceStride = globalData.SSRSettings1.x;
 float rayTraceInitOffset = globalData.SSRSettings1.y;
 float rayTraceMaxStep = globalData.SSRSettings1.z;
 float rayTraceHitThickness = globalData.SSRSettings1.w;
+float rayTraceHiZMaxLevel = globalData.SSRSettings2.w;
+
+// SSAO samples this many times their pixel offset away read Hi-Z pyramid level whose texels are 1 / (1 << HIZ_SSAO_LEVEL_BIAS) of offset,
+// nearest surface of a texel is taken so that a thin occluder isn't skipped over, closer samples read depth buffer as before
+#define HIZ_SSAO_LEVEL_BIAS 3
+
+// Nearest depth over a cell of Hi-Z pyramid as camera space z, nothing drawn is infinitely far
+float HiZNearestZ(ivec2 texel, int level)
+{
+	float nearestDepth = texelFetch(HIZ_PYRAMID[frameIndex], texel, level).g;
+	return nearestDepth == 0.0f ? -1e30f : ReconstructLinearDepth(nearestDepth);
+}
+
+// Ray march steps from "P" on that all sample pixels of one cell of Hi-Z pyramid, while ray stays in front of nearest surface of that cell
+// over all of them, so none of them could hit. Coarsest level is tried first, 0 if no level gets more than one step
+// "P" and "dP" are permuted like ray march does, last texel of a level covering leftover pixels of an odd sized level is never skipped through
+int HiZSkipSteps(vec2 P, float Qz, float k, vec2 dP, float dQz, float dk, bool permute)
+{
+	float rayZStart = (Qz - dQz * 0.5f) / (k - dk * 0.5f);
+
+	for (int level = int(rayTraceHiZMaxLevel); level > 0; level--)
+	{
+		float cellSize = float(1 << level);
+		vec2 cellMin = floor(P / cellSize) * cellSize;
+
+		// Pixels sampled by steps from 0 to "steps - 1" stay within cell, a little margin keeps the last one off its far edge
+		vec2 room = mix(P - cellMin, cellMin + cellSize - P, greaterThan(dP, vec2(0.0f))) - 0.001f;
+		vec2 stepsInCell = room / max(abs(dP), vec2(0.00001f));
+		int steps = 1 + int(floor(min(stepsInCell.x, stepsInCell.y)));
+		if (steps < 2)
+			continue;
+
+		ivec2 texel = ivec2(permute ? cellMin.yx : cellMin) >> level;
+		ivec2 levelSize = textureSize(HIZ_PYRAMID[frameIndex], level);
+		if (any(lessThan(texel, ivec2(0))) || any(greaterThanEqual(texel, levelSize)))
+			continue;
+
+		float rayZEnd = (Qz + dQz * (steps - 0.5f)) / (k + dk * (steps - 0.5f));
+		if (min(rayZStart, rayZEnd) > HiZNearestZ(texel, level))
+			return steps;
+	}
+
+	return 0;
+}
 
 void UnpackNormalRoughness(ivec2 coord, out vec3 normal, out float roughness)
 {
@@ -119,6 +163,20 @@ vec4 RayMarch(vec3 sampleCSNormal, vec3 csNormal, vec3 position, vec3 csViewRay)
 			sampleZ != 0.0f;
 			P += dP, Q.z += dQ.z, k += dk, stepCount++)
 	{
+		// Empty space is crossed in one go, counting as one step together with the one after it
+		int skipped = HiZSkipSteps(P, Q.z, k, dP, dQ.z, dk, permute);
+		if (skipped > 0)
+		{
+			P += dP * skipped;
+			Q.z += dQ.z * skipped;
+			k += dk * skipped;
+			prevZMax = (Q.z - dQ.z * 0.5f) / (k - dk * 0.5f);
+
+			hit = permute ? P.yx : P;
+			if ((P.x * stepDirection) > end)
+				break;
+		}
+
 		ZMin = prevZMax;
 		ZMax = (Q.z + dQ.z * 0.5f) / (k + dk * 0.5f);
 		prevZMax = ZMax;
@@ -193,11 +251,18 @@ void main()
 		clipSpaceSample = clipSpaceSample / clipSpaceSample.w;
 		clipSpaceSample.xy = clipSpaceSample.xy * 0.5f + 0.5f;
 
-		float sampledDepth = clipSpaceSample.z;
-		float textureDepth = texture(DepthStencilBuffer[frameIndex], clipSpaceSample.xy).r;
-
-		sampledDepth = ReconstructLinearDepth(sampledDepth);
-		textureDepth = ReconstructLinearDepth(textureDepth);
+		float sampledDepth = ReconstructLinearDepth(clipSpaceSample.z);
+		float textureDepth;
+
+		// Far samples read a coarser level, keeping texture reads of a pixel close together
+		float pixelOffset = length((clipSpaceSample.xy - inUv) * globalData.gameWindowSize.xy);
+		int level = min(int(floor(log2(max(pixelOffset, 1.0f)))) - HIZ_SSAO_LEVEL_BIAS, textureQueryLevels(HIZ_PYRAMID[frameIndex]) - 1);
+		ivec2 levelSize = textureSize(HIZ_PYRAMID[frameIndex], max(level, 0));
+		ivec2 texel = min(ivec2(floor(clipSpaceSample.xy * globalData.gameWindowSize.xy)) >> max(level, 0), levelSize - 1);
+		if (level > 0 && rayTraceHiZMaxLevel > 0.0f && all(greaterThanEqual(clipSpaceSample.xy, vec2(0.0f))) && all(lessThan(clipSpaceSample.xy, vec2(1.0f))))
+			textureDepth = HiZNearestZ(texel, level);
+		else
+			textureDepth = ReconstructLinearDepth(texture(DepthStencilBuffer[frameIndex], clipSpaceSample.xy).r);
 
 		// abs(textureDepth - sampledDepth) : The depth difference between sample position and texture position in camera space
 		// ssaoCSLength : ssao sample length in camera space
@@ -1,6 +1,17 @@
 #if !defined(SHADER_UNIFORM_LAYOUT)
 #define SHADER_UNIFORM_LAYOUT
 
+#define SHADOW_CASCADE_COUNT 4
+
+// Light cluster grid: screen tiles by exponential depth slices
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define MAX_LIGHTS 1024
+
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT 1
+
 #extension GL_EXT_scalar_block_layout :enable
 
 struct GlobalData
@@ -20,7 +31,7 @@ struct GlobalData
 	// Scene Settings
 	vec4 mainLightDir;
 	vec4 mainLightColor;
-	mat4 mainLightVP;
+	mat4 mainLightVP;			// Shadow cascade 0
 
 	// Main camera settings
 	vec4 MainCameraSettings0;
@@ -43,6 +54,10 @@ struct GlobalData
 	vec4 PlanetRenderingSettings0;
 	vec4 PlanetRenderingSettings1;
 	vec4 SSAOSamples[64];
+
+	// Appended, members above keep offsets of shaders compiled before shadow cascades
+	mat4 mainLightCascadeVP[SHADOW_CASCADE_COUNT - 1];	// Shadow cascades from 1 on
+	vec4 mainLightCascadeSplits;	// Camera space depth each shadow cascade reaches, 0 for cascades not in use
 };
 
 struct BoneData
@@ -52,7 +67,13 @@ struct BoneData
 
 struct MeshData
 {
-	uint boneChunkIndexOffset;
+	uint boneChunkIndexOffset;	// First, at the offset it had before dequantization was added
+	uint padding0;
+	uint padding1;
+	uint padding2;
+	vec4 positionScale;
+	vec4 positionBias;
+	vec4 texCoordScaleBias;
 };
 
 struct PlanetData
@@ -94,6 +115,14 @@ struct PerFrameData
 	float reservedPadding1;
 };
 
+struct LightData
+{
+	vec4 positionRange;		// xyz: camera space position, w: range
+	vec4 colorType;			// xyz: color, w: light type
+	vec4 direction;			// xyz: camera space direction light shines along
+	vec4 spotScaleOffset;	// Cone fall off is saturate(cos * x + y)
+};
+
 struct PerObjectData
 {
 	mat4 MV;			// We can keep the translation of modelview matrix, as it's relative to camera. Larger number means far away, float rounding isn't visible
@@ -161,6 +190,7 @@ layout(set = 0, binding = 11) uniform samplerCube RGBA16_512_CUBE_IRRADIANCE;
 layout(set = 0, binding = 12) uniform samplerCube RGBA16_512_CUBE_PREFILTERENV;
 layout(set = 0, binding = 13) uniform sampler2D RGBA16_512_2D_BRDFLUT;
 layout(set = 0, binding = 14) uniform sampler2D SSAO_RANDOM_ROTATIONS;
+layout(set = 0, binding = 15) uniform sampler2D HIZ_PYRAMID[3];	// Per frame depth pyramid, r: farthest, g: nearest, read with texelFetch only
 
 layout(std430, set = 1, binding = 0) uniform PerFrameUniforms
 {
@@ -172,6 +202,14 @@ layout(std430, set = 1, binding = 1) buffer PerFrameBoneUniforms
 	PerFrameBoneData perFrameBoneData[];
 };
 
+layout(std430, set = 1, binding = 2) buffer PerFrameLightUniforms
+{
+	vec4		clusterSettings;	// x: near depth, y: slices per log depth, z: light count
+	uvec2		clusterLightRanges[LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z];	// Offset and count of each cluster's light list
+	LightData	lightData[MAX_LIGHTS];
+	uint		clusterLightIndices[];
+};
+
 layout(std430, set = 2, binding = 0) buffer PerObjectUniforms
 {
 	PerObjectData perObjectData[];
@@ -187,4 +225,12 @@ layout(std430, set = 3, binding = 2) buffer PerMaterialIndirectUniforms
 	ObjectDataIndex objectDataIndex[];
 };
 
+#ifdef PER_DRAW_PUSH_CONSTANTS
+// Offset of current draw's first "objectDataIndex", pushed by materials drawing one by one
+layout(push_constant) uniform PerDrawPushConstants
+{
+	int indirectOffset;
+} perDrawData;
+#endif
+
 #endif
\ No newline at end of file
@@ -161,9 +161,38 @@ float CalculateCoC(float eyeDepth)
 	return clamp(coc * 0.5f * globalData.DOFSettings0.y + 0.5f, 0, 1);
 }
 
+mat4 MainLightVP(int cascade)
+{
+	return cascade == 0 ? globalData.mainLightVP : globalData.mainLightCascadeVP[cascade - 1];
+}
+
 int GetIndirectIndex(int drawID, int instanceID)
 {
+#ifdef PER_DRAW_PUSH_CONSTANTS
+	return perDrawData.indirectOffset + instanceID;
+#else
 	return indirectOffsets[drawID].offset + instanceID;
+#endif
+}
+
+// Inverse of VertexPacker::OctEncode
+vec3 OctDecode(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.x += v.x >= 0.0 ? -t : t;
+	v.y += v.y >= 0.0 ? -t : t;
+	return normalize(v);
+}
+
+vec3 DequantizePosition(vec3 pos, int perMeshIndex)
+{
+	return pos * meshData[perMeshIndex].positionScale.xyz + meshData[perMeshIndex].positionBias.xyz;
+}
+
+vec2 DequantizeTexCoord(vec2 uv, int perMeshIndex)
+{
+	return uv * meshData[perMeshIndex].texCoordScaleBias.xy + meshData[perMeshIndex].texCoordScaleBias.zw;
 }
 
 #endif
\ No newline at end of file
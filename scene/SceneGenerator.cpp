@@ -93,70 +93,6 @@ void SceneGenerator::GenerateBRDFLUTGenScene()
 	StagingBufferMgr()->FlushDataMainThread();
 }
 
-void SceneGenerator::GenerateCube(Vector3d vertices[], uint32_t indices[])
-{
-	vertices[0] = { -1, -1,  1 };
-	vertices[1] = {  1, -1,  1 };
-	vertices[2] = { -1, -1, -1 };
-	vertices[3] = {  1, -1, -1 };
-
-	vertices[4] = { -1,  1,  1 };
-	vertices[5] = {  1,  1,  1 };
-	vertices[6] = { -1,  1, -1 };
-	vertices[7] = {  1,  1, -1 };
-
-	for (uint32_t i = 0; i < 8; i++)
-		vertices[i].Normalize();
-
-	// Bottom
-	indices[0] = 1;
-	indices[1] = 0;
-	indices[2] = 3;
-	indices[3] = 3;
-	indices[4] = 0;
-	indices[5] = 2;
-
-	// Top
-	indices[6] = 4;
-	indices[7] = 5;
-	indices[8] = 6;
-	indices[9] = 6;
-	indices[10] = 5;
-	indices[11] = 7;
-
-	// Front
-	indices[12] = 0;
-	indices[13] = 1;
-	indices[14] = 4;
-	indices[15] = 4;
-	indices[16] = 1;
-	indices[17] = 5;
-
-	// Back
-	indices[18] = 3;
-	indices[19] = 2;
-	indices[20] = 7;
-	indices[21] = 7;
-	indices[22] = 2;
-	indices[23] = 6;
-
-	// Left
-	indices[24] = 2;
-	indices[25] = 0;
-	indices[26] = 6;
-	indices[27] = 6;
-	indices[28] = 0;
-	indices[29] = 4;
-
-	// Right
-	indices[30] = 1;
-	indices[31] = 3;
-	indices[32] = 5;
-	indices[33] = 5;
-	indices[34] = 3;
-	indices[35] = 7;
-}
-
 std::shared_ptr<Mesh> SceneGenerator::GenerateLODTriangleMesh(uint32_t level, bool forQuad)
 {
 	std::vector<Vector4f> vertices;
@@ -349,51 +285,57 @@ std::shared_ptr<Mesh> SceneGenerator::GenerateLODQuadMesh(uint32_t level)
 	);
 }
 
+// Shared by box mesh and its occluder
+static const float boxPositions[] = {
+	// front
+	-1.0, -1.0,  1.0,
+	1.0, -1.0,  1.0,
+	1.0,  1.0,  1.0,
+	-1.0,  1.0,  1.0,
+	// back
+	-1.0, -1.0, -1.0,
+	1.0, -1.0, -1.0,
+	1.0,  1.0, -1.0,
+	-1.0,  1.0, -1.0,
+};
+
+static const uint32_t boxIndices[] = {
+	// front
+	0, 2, 1,
+	2, 0, 3,
+	// top
+	1, 6, 5,
+	6, 1, 2,
+	// back
+	7, 5, 6,
+	5, 7, 4,
+	// bottom
+	4, 3, 0,
+	3, 4, 7,
+	// left
+	4, 1, 5,
+	1, 4, 0,
+	// right
+	3, 6, 2,
+	6, 3, 7,
+};
+
 std::shared_ptr<Mesh> SceneGenerator::GenerateBoxMesh()
 {
-	float cubeVertices[] = {
-		// front
-		-1.0, -1.0,  1.0,
-		1.0, -1.0,  1.0,
-		1.0,  1.0,  1.0,
-		-1.0,  1.0,  1.0,
-		// back
-		-1.0, -1.0, -1.0,
-		1.0, -1.0, -1.0,
-		1.0,  1.0, -1.0,
-		-1.0,  1.0, -1.0,
-	};
-
-	uint32_t cubeIndices[] = {
-		// front
-		0, 2, 1,
-		2, 0, 3,
-		// top
-		1, 6, 5,
-		6, 1, 2,
-		// back
-		7, 5, 6,
-		5, 7, 4,
-		// bottom
-		4, 3, 0,
-		3, 4, 7,
-		// left
-		4, 1, 5,
-		1, 4, 0,
-		// right
-		3, 6, 2,
-		6, 3, 7,
-	};
-
 	std::shared_ptr<Mesh> pCubeMesh = Mesh::Create
 	(
-		cubeVertices, 8, VertexFormatP,
-		cubeIndices, 36, VK_INDEX_TYPE_UINT32
+		boxPositions, 8, VertexFormatP,
+		boxIndices, 36, VK_INDEX_TYPE_UINT32
 	);
 
 	return pCubeMesh;
 }
 
+std::shared_ptr<OcclusionBuffer::Occluder> SceneGenerator::GenerateBoxOccluder()
+{
+	return OcclusionBuffer::CreateOccluder(boxPositions, 8, sizeof(float) * 3, boxIndices, 36);
+}
+
 std::shared_ptr<Mesh> SceneGenerator::GeneratePBRBoxMesh()
 {
 	// FIXME: Put this into utility classes
@@ -4,6 +4,7 @@
 #include "../Base/BaseObject.h"
 #include "../Base/BaseComponent.h"
 #include "../common/Singleton.h"
+#include "../class/OcclusionBuffer.h"
 
 class Camera;
 class Mesh;
@@ -31,10 +32,10 @@ public:
 	std::shared_ptr<MeshRenderer> GetMeshRenderer0() const { return m_pMeshRenderer0; }
 
 public:
-	static void GenerateCube(Vector3d vertices[], uint32_t indices[]);
 	static std::shared_ptr<Mesh> GenerateLODTriangleMesh(uint32_t level, bool forQuadTriangle);	// Otherwise, it's for icosahedron triangle
 	static std::shared_ptr<Mesh> GenerateLODQuadMesh(uint32_t level);
 	static std::shared_ptr<Mesh> GenerateBoxMesh();
+	static std::shared_ptr<OcclusionBuffer::Occluder> GenerateBoxOccluder();	// Same shape as box mesh
 	static std::shared_ptr<Mesh> GenerateQuadMesh();
 	static std::shared_ptr<Mesh> GeneratePBRQuadMesh();
 	static std::shared_ptr<Mesh> GeneratePBRBoxMesh();
@@ -0,0 +1,153 @@
+#include "Tests.h"
+#include "../class/AABBTree.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static bool Overlaps(const AABBTree::Box& box0, const AABBTree::Box& box1)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (box0.max[i] < box1.min[i] || box1.max[i] < box0.min[i])
+			return false;
+	}
+	return true;
+}
+
+static double SquareDistance(const AABBTree::Box& box, const Vector3d& p)
+{
+	double squareDistance = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		double d = std::max(std::max(box.min[i] - p[i], p[i] - box.max[i]), 0.0);
+		squareDistance += d * d;
+	}
+	return squareDistance;
+}
+
+// Slab test, entry distance or -1 for a miss, a ray starting inside hits at 0
+static double RayBox(const Vector3d& origin, const Vector3d& direction, const AABBTree::Box& box, double maxDistance)
+{
+	double tMin = 0, tMax = maxDistance;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		double t0 = (box.min[i] - origin[i]) / direction[i];
+		double t1 = (box.max[i] - origin[i]) / direction[i];
+		if (t0 > t1)
+			std::swap(t0, t1);
+
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+		if (tMin > tMax)
+			return -1;
+	}
+	return tMin;
+}
+
+// Queries go through the tree and through every live box, both must agree
+static bool CheckQueries(const AABBTree& tree, const std::vector<uint32_t>& proxies, std::mt19937& random)
+{
+	bool passed = true;
+
+	std::uniform_real_distribution<double> position(0, 100.0);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+	for (uint32_t i = 0; i < 50; i++)
+	{
+		Vector3d center(position(random), position(random), position(random));
+		Vector3d extents(position(random) * 0.1, position(random) * 0.1, position(random) * 0.1);
+		AABBTree::Box box = { center - extents, center + extents };
+		double radius = position(random) * 0.1;
+
+		std::vector<uint32_t> boxHits, sphereHits, expectedBoxHits, expectedSphereHits;
+		tree.QueryBox(box, boxHits);
+		tree.QuerySphere(center, radius, sphereHits);
+
+		for (uint32_t proxy : proxies)
+		{
+			if (Overlaps(tree.GetProxyBox(proxy), box))
+				expectedBoxHits.push_back(proxy);
+			if (SquareDistance(tree.GetProxyBox(proxy), center) <= radius * radius)
+				expectedSphereHits.push_back(proxy);
+		}
+
+		std::sort(boxHits.begin(), boxHits.end());
+		std::sort(sphereHits.begin(), sphereHits.end());
+		std::sort(expectedBoxHits.begin(), expectedBoxHits.end());
+		std::sort(expectedSphereHits.begin(), expectedSphereHits.end());
+		CHECK(boxHits == expectedBoxHits);
+		CHECK(sphereHits == expectedSphereHits);
+
+		Vector3d direction(unit(random), unit(random), unit(random));
+		if (direction.SquareLength() == 0)
+			direction = Vector3d(0, 0, 1);
+		direction.Normalize();
+
+		double expectedDistance = 200.0;
+		for (uint32_t proxy : proxies)
+		{
+			double distance = RayBox(center, direction, tree.GetProxyBox(proxy), expectedDistance);
+			if (distance >= 0)
+				expectedDistance = distance;
+		}
+
+		double hitDistance;
+		uint32_t hitProxy = tree.RayCast(center, direction, 200.0, hitDistance);
+		CHECK((hitProxy == AABBTree::NONE) == (expectedDistance == 200.0));
+		if (hitProxy != AABBTree::NONE)
+			CHECK(std::abs(hitDistance - expectedDistance) < 1e-9);
+	}
+
+	return passed;
+}
+
+bool TestAABBTree()
+{
+	bool passed = true;
+
+	std::mt19937 random(0);
+	std::uniform_real_distribution<double> position(0, 100.0);
+	std::uniform_real_distribution<double> size(0.5, 2.0);
+	std::uniform_real_distribution<double> offset(-5.0, 5.0);
+
+	AABBTree tree;
+	std::vector<uint32_t> proxies;
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		Vector3d center(position(random), position(random), position(random));
+		Vector3d extents(size(random), size(random), size(random));
+		proxies.push_back(tree.CreateProxy({ center - extents, center + extents }));
+	}
+
+	CHECK(tree.GetProxyCount() == 1000);
+	passed &= CheckQueries(tree, proxies, random);
+
+	// Moves in and out of fat boxes, plus destroyed proxies whose slots come back on creation
+	for (uint32_t i = 0; i < (uint32_t)proxies.size(); i += 3)
+	{
+		AABBTree::Box box = tree.GetProxyBox(proxies[i]);
+		Vector3d delta(offset(random), offset(random), offset(random));
+		tree.MoveProxy(proxies[i], { box.min + delta, box.max + delta });
+	}
+
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		tree.DestroyProxy(proxies.back());
+		proxies.pop_back();
+	}
+
+	CHECK(tree.GetProxyCount() == 800);
+	passed &= CheckQueries(tree, proxies, random);
+
+	tree.Rebuild();
+	passed &= CheckQueries(tree, proxies, random);
+
+	for (uint32_t proxy : proxies)
+		tree.DestroyProxy(proxy);
+
+	AABBTree::Box bounds;
+	CHECK(tree.GetProxyCount() == 0);
+	CHECK(!tree.GetBounds(bounds));
+
+	return passed;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "../class/AABBTree.h"
+#include "../class/LightClusterGrid.h"
+#include "../class/PerDrawData.h"
+#include "../class/PlanetSubdivider.h"
+#include <iostream>
+#include <cstring>
+#include <utility>
+
+// Benchmarks of CPU side code, built next to tests but not run by ctest, run "VulkanLearnBenchmarks [name]"
+// Release builds give meaningful numbers
+
+static void BenchmarkAABBTree()
+{
+	for (uint32_t objectsCount : { 10000, 100000, 1000000 })
+	{
+		AABBTree::BenchmarkResult benchmark = AABBTree::Benchmark(objectsCount, 1000);
+		std::cout << "AABB tree, " << objectsCount << " objects: insert " << benchmark.insertTime << "ms, build " << benchmark.buildTime << "ms, refit " << benchmark.refitTime
+			<< "ms, frustum query " << benchmark.frustumQueryTime << "us (" << benchmark.frustumQueryHits << " hits), ray cast " << benchmark.rayCastTime
+			<< "us, incremental cost " << benchmark.incrementalCost << "\n";
+	}
+}
+
+// 16x9x24 clusters, street level camera
+static void BenchmarkLightClusterGrid()
+{
+	for (uint32_t lightsCount : { 1000, 2000, 5000, 10000 })
+	{
+		LightClusterGrid::BenchmarkResult benchmark = LightClusterGrid::Benchmark(lightsCount);
+		std::cout << "Clustered lighting, " << lightsCount << " lights: setup " << benchmark.setupTime << "ms, assign " << benchmark.assignTime << "ms, parallel assign " << benchmark.parallelAssignTime
+			<< "ms, " << benchmark.lightIndicesCount << " light indices, " << benchmark.averageLightsPerCluster << " average and " << benchmark.maxLightsPerCluster << " max lights per lit cluster\n";
+	}
+}
+
+static void BenchmarkPerDrawData()
+{
+	const char* strategyNames[PerDrawDataStrategyCount] = { "indirect buffer", "dynamic offset", "push constants" };
+
+	// Usual minimum storage buffer offset alignments, no device here to ask
+	for (uint32_t alignment : { 16, 64, 256 })
+	{
+		for (uint32_t drawsCount : { 1, 8, 64, 256 })
+		{
+			PerDrawData::BenchmarkResult benchmark = PerDrawData::Benchmark(drawsCount, 1, alignment, 10000);
+			std::cout << "Per draw data, " << alignment << " bytes alignment, " << drawsCount << " draws:";
+			for (uint32_t i = 0; i < PerDrawDataStrategyCount; i++)
+				std::cout << " " << strategyNames[i] << " " << benchmark.cpuTime[i] << "us, " << benchmark.uploadBytes[i] << " bytes, " << benchmark.drawCommands[i] << " commands;";
+			std::cout << "\n";
+		}
+	}
+}
+
+// Earth sized planet along a flight from ground level up to orbit
+static void BenchmarkPlanetSubdivider()
+{
+	PlanetSubdivider::BenchmarkResult benchmark = PlanetSubdivider::Benchmark(1000);
+	std::pair<const char*, PlanetSubdivider::BenchmarkCase> cases[] =
+	{
+		{ "legacy", benchmark.legacy },
+		{ "screen space error", benchmark.flat },
+		{ "terrain aware with horizon culling", benchmark.terrain },
+		{ "terrain aware without horizon culling", benchmark.terrainNoHorizon },
+	};
+
+	for (auto& c : cases)
+	{
+		std::cout << "Planet patches over " << benchmark.framesCount << " frames of flight, " << c.first << ": " << c.second.trianglesCount << " average and "
+			<< c.second.maxTrianglesCount << " max triangles, " << c.second.time << "us per frame\n";
+	}
+}
+
+typedef struct _Benchmark
+{
+	const char*	name;
+	void		(*run)();
+}Benchmark;
+
+static const Benchmark BENCHMARKS[] =
+{
+	{ "AABBTree", BenchmarkAABBTree },
+	{ "LightClusterGrid", BenchmarkLightClusterGrid },
+	{ "PerDrawData", BenchmarkPerDrawData },
+	{ "PlanetSubdivider", BenchmarkPlanetSubdivider },
+};
+
+// Runs the benchmark named on command line, or all of them
+int main(int argc, char* argv[])
+{
+	bool found = false;
+	for (const Benchmark& benchmark : BENCHMARKS)
+	{
+		if (argc > 1 && strcmp(argv[1], benchmark.name) != 0)
+			continue;
+
+		found = true;
+		benchmark.run();
+	}
+
+	if (!found)
+	{
+		std::cout << "No benchmark named " << argv[1] << "\n";
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
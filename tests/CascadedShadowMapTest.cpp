@@ -0,0 +1,132 @@
+#include "Tests.h"
+#include "../class/CascadedShadowMap.h"
+#include "../Maths/MathUtil.h"
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+bool TestCascadedShadowMap()
+{
+	auto nearlyEqual = [](double a, double b, double tolerance)
+	{
+		return std::abs(a - b) <= tolerance * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+	};
+
+	auto onTexelGrid = [](double value, double texelSize)
+	{
+		double texels = value / texelSize;
+		return std::abs(texels - std::floor(texels + 0.5)) < 1e-6;
+	};
+
+	bool passed = true;
+
+	// Pure logarithmic and pure uniform splits have known values, blended ones lie between them, both ends are kept as they are
+	double logSplits[5], uniformSplits[5], splits[5];
+	CascadedShadowMap::ComputeSplits(0.1, 1000, 4, 1, logSplits);
+	CascadedShadowMap::ComputeSplits(0.1, 1000, 4, 0, uniformSplits);
+	CascadedShadowMap::ComputeSplits(0.1, 1000, 4, CascadedShadowMap::DEFAULT_SPLIT_LAMBDA, splits);
+
+	for (uint32_t i = 0; i <= 4; i++)
+	{
+		CHECK(nearlyEqual(logSplits[i], 0.1 * std::pow(10.0, i), 1e-12));
+		CHECK(nearlyEqual(uniformSplits[i], 0.1 + 999.9 * i / 4, 1e-12));
+		CHECK(splits[i] >= logSplits[i] && splits[i] <= uniformSplits[i]);
+		if (i > 0)
+			CHECK(splits[i] > splits[i - 1]);
+	}
+	CHECK(splits[0] == 0.1 && splits[4] == 1000);
+
+	// 60 degrees vertical field of view, light tilted around 2 axes, cameras turned every way, the second half far away from origin
+	const double tangentFOV_2 = std::tan(PI / 6.0);
+	const double aspect = 16.0 / 9.0;
+	const uint32_t resolution = 1024;
+	const double noCasters = -1e30;
+
+	Matrix4d lightTransform(Matrix3d::EulerAngle(0.78, 0, 0) * Matrix3d::EulerAngle(0, 2.355, 0), { 3, 5, -2 });
+	Matrix4d worldToLight = lightTransform;
+	worldToLight.Inverse();
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> angle(-PI, PI);
+	std::uniform_real_distribution<double> offset(-100, 100);
+
+	double boxSize = 0;
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		Vector3d position = { offset(random), offset(random), offset(random) };
+		if (i >= 32)
+			position += Vector3d(1e6, -3e5, 5e5);
+
+		Matrix4d cameraTransform(Matrix3d::EulerAngle(angle(random), angle(random), angle(random)), position);
+		CascadedShadowMap::Cascade cascade = CascadedShadowMap::FitCascade(cameraTransform, tangentFOV_2, aspect, 2, 10, lightTransform, resolution, noCasters);
+
+		// Every corner of slice is inside box
+		for (double depth : { 2.0, 10.0 })
+		{
+			for (double x : { -1.0, 1.0 })
+			{
+				for (double y : { -1.0, 1.0 })
+				{
+					Vector3d corner = worldToLight.TransformAsPoint(cameraTransform.TransformAsPoint({ x * depth * tangentFOV_2 * aspect, y * depth * tangentFOV_2, -depth }));
+					for (uint32_t axis = 0; axis < 3; axis++)
+						CHECK(corner[axis] >= cascade.boxMin[axis] - 1e-6 && corner[axis] <= cascade.boxMax[axis] + 1e-6);
+				}
+			}
+		}
+
+		// Box size doesn't depend on camera, it's a whole number of texels, and box corner sits on a texel boundary
+		if (i == 0)
+			boxSize = cascade.boxMax.x - cascade.boxMin.x;
+		CHECK(nearlyEqual(cascade.boxMax.x - cascade.boxMin.x, boxSize, 1e-9) && nearlyEqual(cascade.boxMax.y - cascade.boxMin.y, boxSize, 1e-9));
+		CHECK(nearlyEqual(boxSize, cascade.texelSize * resolution, 1e-12));
+		CHECK(onTexelGrid(cascade.boxMin.x, cascade.texelSize) && onTexelGrid(cascade.boxMin.y, cascade.texelSize));
+
+		// Moving camera by part of a texel leaves box where it is or shifts it by whole texels
+		Matrix4d nudgedTransform = cameraTransform;
+		nudgedTransform.c30 += cascade.texelSize * 0.3;
+		nudgedTransform.c31 -= cascade.texelSize * 0.6;
+		CascadedShadowMap::Cascade nudged = CascadedShadowMap::FitCascade(nudgedTransform, tangentFOV_2, aspect, 2, 10, lightTransform, resolution, noCasters);
+		CHECK(onTexelGrid(nudged.boxMin.x - cascade.boxMin.x, cascade.texelSize) && onTexelGrid(nudged.boxMin.y - cascade.boxMin.y, cascade.texelSize));
+
+		// Box goes onto the whole ndc, nearest to light at depth 1
+		Matrix4d projection = CascadedShadowMap::AcquireProjection(cascade);
+		Vector3d ndcMin = projection.TransformAsPoint(cascade.boxMin);
+		Vector3d ndcMax = projection.TransformAsPoint(cascade.boxMax);
+		CHECK(nearlyEqual(ndcMin.x, -1, 1e-9) && nearlyEqual(ndcMin.y, 1, 1e-9) && nearlyEqual(ndcMin.z, 0, 1e-9));
+		CHECK(nearlyEqual(ndcMax.x, 1, 1e-9) && nearlyEqual(ndcMax.y, -1, 1e-9) && nearlyEqual(ndcMax.z, 1, 1e-9));
+
+		Vector3d center = (cascade.boxMin + cascade.boxMax) * 0.5;
+		PyramidFrustumd frustum = CascadedShadowMap::AcquireFrustum(cascade, lightTransform);
+		CHECK(frustum.Contain(lightTransform.TransformAsPoint(center)));
+		CHECK(!frustum.Contain(lightTransform.TransformAsPoint(center + Vector3d(boxSize, 0, 0))));
+		CHECK(!frustum.Contain(lightTransform.TransformAsPoint(center - Vector3d(0, 0, boxSize))));
+
+		// Cascade fit with margin keeps covering slice of a camera moved less than margin, but not the other way round
+		CascadedShadowMap::Cascade cached = CascadedShadowMap::FitCascade(cameraTransform, tangentFOV_2, aspect, 2, 10, lightTransform, resolution, noCasters, 0.2);
+		Matrix4d movedTransform = cameraTransform;
+		movedTransform.c30 += 0.5;
+		movedTransform.c32 -= 0.5;
+		CascadedShadowMap::Cascade moved = CascadedShadowMap::FitCascade(movedTransform, tangentFOV_2, aspect, 2, 10, lightTransform, resolution, noCasters);
+		CHECK(CascadedShadowMap::Contains(cached, moved) && !CascadedShadowMap::Contains(moved, cached));
+
+		// World space boxes at box center overlap, one beside box or behind it seen from light doesn't
+		Vector3d worldCenter = lightTransform.TransformAsPoint(center);
+		Vector3d beside = lightTransform.TransformAsPoint(center + Vector3d(boxSize, 0, 0));
+		Vector3d behind = lightTransform.TransformAsPoint(center - Vector3d(0, 0, boxSize));
+		CHECK(CascadedShadowMap::Overlaps(cascade, lightTransform, worldCenter - 0.1, worldCenter + 0.1));
+		CHECK(!CascadedShadowMap::Overlaps(cascade, lightTransform, beside - 0.1, beside + 0.1));
+		CHECK(!CascadedShadowMap::Overlaps(cascade, lightTransform, behind - 0.1, behind + 0.1));
+	}
+
+	// Casters above slice stretch box towards light, nothing else changes
+	CascadedShadowMap::Cascade cascade = CascadedShadowMap::FitCascade(Matrix4d(), tangentFOV_2, aspect, 2, 10, lightTransform, resolution, noCasters);
+	CascadedShadowMap::Cascade stretched = CascadedShadowMap::FitCascade(Matrix4d(), tangentFOV_2, aspect, 2, 10, lightTransform, resolution, cascade.boxMax.z + 50);
+	CHECK(stretched.boxMax.z == cascade.boxMax.z + 50 && stretched.boxMin == cascade.boxMin && stretched.boxMax.x == cascade.boxMax.x);
+	CHECK(CascadedShadowMap::Contains(stretched, cascade) && !CascadedShadowMap::Contains(cascade, stretched));
+
+	// Slice wider than it's deep centers sphere on far plane
+	CascadedShadowMap::Cascade wide = CascadedShadowMap::FitCascade(Matrix4d(), 1, 2, 1, 1.5, Matrix4d(), resolution, noCasters);
+	CHECK(nearlyEqual(wide.boxMax.x - wide.boxMin.x, 2 * 1.5 * std::sqrt(5.0), 1e-12) && nearlyEqual((wide.boxMin.z + wide.boxMax.z) * 0.5, -1.5, 1e-12));
+
+	return passed;
+}
\ No newline at end of file
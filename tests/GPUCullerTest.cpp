@@ -0,0 +1,281 @@
+#include "Tests.h"
+#include "../class/GPUCuller.h"
+#include "../class/HiZPyramid.h"
+#include <algorithm>
+#include <random>
+#include <memory>
+#include <cmath>
+#include <cstring>
+
+static bool TestOcclusion()
+{
+	const double nearPlane = 0.1;
+	const uint32_t size = 64;
+
+	// 90 degrees both ways, a pixel's ndc is view space x / -z and y / z
+	Matrix4d projection;
+	projection.x0 = 1;
+	projection.y1 = -1;
+	projection.z2 = 0;
+	projection.w2 = nearPlane;
+	projection.z3 = -1;
+	projection.w3 = 0;
+
+	// Last frame's depth: a 16 by 16 wall 10 ahead of camera, nothing around it
+	std::vector<float> depth(size * size, 0.0f);
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			double ndcX = (x + 0.5) / size * 2.0 - 1.0;
+			double ndcY = (y + 0.5) / size * 2.0 - 1.0;
+			if (std::abs(ndcX) <= 0.8 && std::abs(ndcY) <= 0.8)
+				depth[y * size + x] = (float)(nearPlane / 10.0);
+		}
+	}
+
+	HiZPyramid pyramid;
+	pyramid.Build(depth.data(), size, size);
+
+	// Camera has moved a bit since last frame, far away from world origin
+	Vector3d lastPosition = { 1e7, -3e6, 5e6 };
+	Vector3d position = lastPosition + Vector3d(0.3, 0.1, 0.5);
+
+	Matrix4d lastTransform;
+	lastTransform.c30 = lastPosition.x;
+	lastTransform.c31 = lastPosition.y;
+	lastTransform.c32 = lastPosition.z;
+
+	Matrix4d transform = lastTransform;
+	transform.c30 = position.x;
+	transform.c31 = position.y;
+	transform.c32 = position.z;
+
+	PyramidFrustumd frustum = PyramidFrustumd({ 0, 0, 0 }, { 0, 0, -1 }, std::atan(1.0) * 2.0, 1.0, nearPlane, 1000);
+	frustum.Transform(transform);
+
+	GPUCuller culler;
+	culler.SetOcclusionView(lastTransform, projection);
+	culler.SetOcclusionView(transform, projection);
+	culler.SetOcclusionPyramid(1, size, size, pyramid.GetLevelCount());
+	culler.SetView(frustum);
+
+	// Boxes placed relative to last frame's camera, one draw each
+	typedef struct _Case
+	{
+		Vector3d	center;
+		Vector3d	extents;
+		bool		cullable;
+		bool		expectedVisible;
+	}Case;
+
+	const Case cases[] =
+	{
+		{ { 0, 0, -20 }, { 2, 2, 2 }, true, false },			// Right behind wall
+		{ { 3, -2, -10.5 }, { 0.2, 0.2, 0.2 }, true, false },	// Just behind wall
+		{ { 0, 0, -6 }, { 1, 1, 1 }, true, true },				// In front of wall
+		{ { 0, 0, -10 }, { 0.5, 0.5, 0.5 }, true, true },		// Through wall
+		{ { 15, 0, -20 }, { 2, 2, 2 }, true, true },			// Sticking out of wall's shadow
+		{ { 0.3, 0.1, -0.5 }, { 1, 1, 1 }, true, true },		// Around camera
+		{ { 0, 0, -20 }, { 2, 2, 2 }, false, true },			// Behind wall but opted out of culling
+	};
+	const uint32_t caseCount = sizeof(cases) / sizeof(Case);
+
+	std::vector<VkDrawIndexedIndirectCommand> cmds;
+	std::vector<uint32_t> indirectOffsets;
+	std::vector<PerMaterialIndirectVariables> variables;
+	for (uint32_t i = 0; i < caseCount; i++)
+	{
+		culler.SetObjectBounds(i, lastPosition + cases[i].center, cases[i].extents, cases[i].cullable);
+		cmds.push_back({ 36, 1, 0, 0, 0 });
+		indirectOffsets.push_back(i);
+		variables.push_back({ i, 0, 0, 0 });
+	}
+
+	std::shared_ptr<GPUCuller::CullingInput> pInput = std::make_shared<GPUCuller::CullingInput>();
+	culler.PrepareInput(cmds.data(), indirectOffsets.data(), (uint32_t)cmds.size(), variables.data(), (uint32_t)variables.size(), *pInput);
+
+	bool passed = true;
+	CHECK(pInput->hizLevelCount == pyramid.GetLevelCount() && pInput->hizPyramidIndex == 1);
+
+	GPUCuller::CullingOutput output;
+	GPUCuller::Cull(*pInput, output, &pyramid);
+
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < caseCount; i++)
+	{
+		if (cases[i].expectedVisible)
+			expected.push_back(i);
+	}
+
+	std::vector<uint32_t> visible;
+	for (auto& variable : output.indirectVariables)
+		visible.push_back(variable.perObjectIndex);
+	CHECK(visible == expected);
+
+	// Without a pyramid, or before there's a last frame, only frustum culls
+	GPUCuller::Cull(*pInput, output);
+	CHECK(output.indirectVariables.size() == caseCount);
+
+	GPUCuller firstFrame;
+	firstFrame.SetOcclusionView(transform, projection);
+	firstFrame.SetOcclusionPyramid(1, size, size, pyramid.GetLevelCount());
+	firstFrame.SetView(frustum);
+	for (uint32_t i = 0; i < caseCount; i++)
+		firstFrame.SetObjectBounds(i, lastPosition + cases[i].center, cases[i].extents, cases[i].cullable);
+	firstFrame.PrepareInput(cmds.data(), indirectOffsets.data(), (uint32_t)cmds.size(), variables.data(), (uint32_t)variables.size(), *pInput);
+	CHECK(pInput->hizLevelCount == 0);
+
+	return passed;
+}
+
+bool TestGPUCuller()
+{
+	const double nearPlane = 0.1;
+	const double farPlane = 500;
+	const double fovv = std::atan(0.6);
+	const double aspect = 16.0 / 9.0;
+
+	bool passed = true;
+
+	// Same random scene around a camera at world origin and around one far away from it
+	for (const Vector3d& position : { Vector3d(0, 0, 0), Vector3d(1e7, -3e6, 5e6) })
+	{
+		Matrix4d cameraTransform;
+		cameraTransform.c30 = position.x;
+		cameraTransform.c31 = position.y;
+		cameraTransform.c32 = position.z;
+
+		PyramidFrustumd frustum = PyramidFrustumd({ 0, 0, 0 }, { 0.3, -0.2, -1 }, fovv, aspect, nearPlane, farPlane);
+		frustum.Transform(cameraTransform);
+
+		GPUCuller culler;
+		culler.SetView(frustum);
+
+		std::mt19937 random(7);
+		std::uniform_real_distribution<double> unit(0, 1);
+
+		// Boxes anywhere around camera, those too close to a plane for single and double precision to agree are moved away
+		std::vector<bool> expectedVisible(GPUCuller::MAX_OBJECT_COUNT);
+		for (uint32_t i = 0; i < GPUCuller::MAX_OBJECT_COUNT; i++)
+		{
+			Vector3d center, extents;
+			bool visible = true;
+			bool ambiguous = true;
+			while (ambiguous)
+			{
+				center = position + Vector3d(unit(random) * 800 - 400, unit(random) * 400 - 200, unit(random) * 800 - 600);
+				extents = Vector3d(0.1 + unit(random) * 5, 0.1 + unit(random) * 5, 0.1 + unit(random) * 5);
+
+				visible = true;
+				ambiguous = false;
+				for (uint32_t j = 0; j < PyramidFrustumd::FrustumFace_COUNT; j++)
+				{
+					const Planed& plane = frustum.planes[j];
+					double reach = std::abs(plane.normal.x) * extents.x + std::abs(plane.normal.y) * extents.y + std::abs(plane.normal.z) * extents.z;
+					double margin = plane.normal * center - plane.D + reach;
+					ambiguous |= std::abs(margin) < 1e-2;
+					visible &= margin >= 0;
+				}
+			}
+
+			// Every 16th object opts out of culling
+			bool cullable = i % 16 != 0;
+			culler.SetObjectBounds(i, center, extents, cullable);
+			expectedVisible[i] = visible || !cullable;
+		}
+
+		// Auto instanced draws of 1 to 7 instances, each 5th one manually instanced, until all objects are taken
+		std::vector<VkDrawIndexedIndirectCommand> cmds;
+		std::vector<uint32_t> indirectOffsets;
+		std::vector<PerMaterialIndirectVariables> variables;
+		std::vector<bool> manual;
+		while (variables.size() < GPUCuller::MAX_OBJECT_COUNT && cmds.size() < GPUCuller::MAX_DRAW_COUNT)
+		{
+			bool manualInstance = cmds.size() % 5 == 4;
+			uint32_t count = manualInstance ? 1 : std::min(1 + (uint32_t)(unit(random) * 7), GPUCuller::MAX_OBJECT_COUNT - (uint32_t)variables.size());
+			uint32_t drawIndex = (uint32_t)cmds.size();
+
+			cmds.push_back({ 36 + drawIndex * 3, manualInstance ? 10u : count, drawIndex * 100, (int32_t)drawIndex * 7, manualInstance ? 4u : 0u });
+			indirectOffsets.push_back((uint32_t)variables.size());
+			manual.push_back(manualInstance);
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t object = (uint32_t)variables.size();
+				variables.push_back({ object, drawIndex, drawIndex + 1000, object * 3 });
+			}
+		}
+
+		std::shared_ptr<GPUCuller::CullingInput> pInput = std::make_shared<GPUCuller::CullingInput>();
+		culler.PrepareInput(cmds.data(), indirectOffsets.data(), (uint32_t)cmds.size(), variables.data(), (uint32_t)variables.size(), *pInput);
+
+		GPUCuller::CullingOutput output;
+		GPUCuller::Cull(*pInput, output);
+
+		// Straightforward version: draw by draw, keep visible instances, drop draws left with none
+		GPUCuller::CullingOutput expected;
+		for (uint32_t i = 0; i < (uint32_t)cmds.size(); i++)
+		{
+			uint32_t end = i + 1 < (uint32_t)cmds.size() ? indirectOffsets[i + 1] : (uint32_t)variables.size();
+			uint32_t first = (uint32_t)expected.indirectVariables.size();
+			for (uint32_t j = indirectOffsets[i]; j < end; j++)
+			{
+				if (manual[i] || expectedVisible[variables[j].perObjectIndex])
+					expected.indirectVariables.push_back(variables[j]);
+			}
+
+			uint32_t count = (uint32_t)expected.indirectVariables.size() - first;
+			if (count == 0)
+				continue;
+
+			VkDrawIndexedIndirectCommand cmd = cmds[i];
+			cmd.instanceCount = manual[i] ? cmds[i].instanceCount : count;
+			expected.cmds.push_back(cmd);
+			expected.indirectOffsets.push_back(first);
+		}
+
+		CHECK(output.cmds.size() == expected.cmds.size() && output.indirectVariables.size() == expected.indirectVariables.size());
+		CHECK(output.indirectOffsets == expected.indirectOffsets);
+		CHECK(std::memcmp(output.cmds.data(), expected.cmds.data(), std::min(output.cmds.size(), expected.cmds.size()) * sizeof(VkDrawIndexedIndirectCommand)) == 0);
+		CHECK(std::memcmp(output.indirectVariables.data(), expected.indirectVariables.data(), std::min(output.indirectVariables.size(), expected.indirectVariables.size()) * sizeof(PerMaterialIndirectVariables)) == 0);
+
+		// Scene has to exercise both outcomes, and some draws have to go entirely
+		CHECK(output.indirectVariables.size() > 0 && output.indirectVariables.size() < variables.size());
+		CHECK(output.cmds.size() < cmds.size());
+	}
+
+	// Nothing to draw
+	std::shared_ptr<GPUCuller::CullingInput> pEmptyInput = std::make_shared<GPUCuller::CullingInput>();
+	GPUCuller().PrepareInput(nullptr, nullptr, 0, nullptr, 0, *pEmptyInput);
+
+	GPUCuller::CullingOutput emptyOutput;
+	GPUCuller::Cull(*pEmptyInput, emptyOutput);
+	CHECK(emptyOutput.cmds.size() == 0 && emptyOutput.indirectVariables.size() == 0);
+
+	// One instance more than a work group holds, or one object out of bounds range, is handed back to caller untouched
+	std::vector<VkDrawIndexedIndirectCommand> overflowCmds(1, { 36, GPUCuller::MAX_INSTANCE_COUNT + 1, 0, 0, 0 });
+	std::vector<uint32_t> overflowOffsets(1, 0);
+	std::vector<PerMaterialIndirectVariables> overflowVariables(GPUCuller::MAX_INSTANCE_COUNT + 1);
+	for (uint32_t i = 0; i < (uint32_t)overflowVariables.size(); i++)
+		overflowVariables[i] = { i % GPUCuller::MAX_OBJECT_COUNT, 0, 0, 0 };
+
+	std::shared_ptr<GPUCuller::CullingInput> pOverflowInput = std::make_shared<GPUCuller::CullingInput>();
+	CHECK(!GPUCuller().PrepareInput(overflowCmds.data(), overflowOffsets.data(), 1, overflowVariables.data(), (uint32_t)overflowVariables.size(), *pOverflowInput));
+	CHECK(pOverflowInput->bypass != 0 && pOverflowInput->instanceCount == 0 && pOverflowInput->drawCount == 0);
+
+	overflowCmds[0].instanceCount = 1;
+	overflowVariables[0].perObjectIndex = GPUCuller::MAX_OBJECT_COUNT;
+	CHECK(!GPUCuller().PrepareInput(overflowCmds.data(), overflowOffsets.data(), 1, overflowVariables.data(), 1, *pOverflowInput));
+
+	GPUCuller::CullingOutput overflowOutput;
+	GPUCuller::Cull(*pOverflowInput, overflowOutput);
+	CHECK(overflowOutput.cmds.size() == 0 && overflowOutput.indirectVariables.size() == 0);
+
+	overflowVariables[0].perObjectIndex = 0;
+	CHECK(GPUCuller().PrepareInput(overflowCmds.data(), overflowOffsets.data(), 1, overflowVariables.data(), 1, *pOverflowInput) && pOverflowInput->bypass == 0);
+
+	CHECK(TestOcclusion());
+
+	return passed;
+}
\ No newline at end of file
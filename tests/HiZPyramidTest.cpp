@@ -0,0 +1,92 @@
+#include "Tests.h"
+#include "../class/HiZPyramid.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+bool TestHiZPyramid()
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> unit(0, 1);
+
+	bool passed = true;
+
+	const uint32_t sizes[][2] = { { 1, 1 }, { 1, 9 }, { 33, 1 }, { 64, 64 }, { 37, 23 }, { 160, 90 }, { 129, 67 } };
+	for (auto& size : sizes)
+	{
+		uint32_t width = size[0];
+		uint32_t height = size[1];
+
+		// Random depth with patches of nothing drawn
+		std::vector<float> depth(width * height);
+		for (auto& pixel : depth)
+			pixel = unit(random) < 0.2f ? 0.0f : unit(random);
+
+		HiZPyramid pyramid;
+		pyramid.Build(depth.data(), width, height);
+
+		CHECK(pyramid.GetLevelCount() == HiZPyramid::GetLevelCount(width, height));
+		CHECK(pyramid.GetWidth(pyramid.GetLevelCount() - 1) == 1 && pyramid.GetHeight(pyramid.GetLevelCount() - 1) == 1);
+
+		auto bruteForce = [&](uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+		{
+			HiZPyramid::MinMax result = { depth[y0 * width + x0], depth[y0 * width + x0] };
+			for (uint32_t y = y0; y <= y1; y++)
+			{
+				for (uint32_t x = x0; x <= x1; x++)
+				{
+					result.minDepth = std::min(result.minDepth, depth[y * width + x]);
+					result.maxDepth = std::max(result.maxDepth, depth[y * width + x]);
+				}
+			}
+			return result;
+		};
+
+		// Each texel is exactly what its footprint holds, not less and not more
+		for (uint32_t level = 0; level < pyramid.GetLevelCount(); level++)
+		{
+			for (uint32_t y = 0; y < pyramid.GetHeight(level); y++)
+			{
+				for (uint32_t x = 0; x < pyramid.GetWidth(level); x++)
+				{
+					uint32_t x1 = x == pyramid.GetWidth(level) - 1 ? width - 1 : ((x + 1) << level) - 1;
+					uint32_t y1 = y == pyramid.GetHeight(level) - 1 ? height - 1 : ((y + 1) << level) - 1;
+					HiZPyramid::MinMax expected = bruteForce(x << level, y << level, x1, y1);
+					const HiZPyramid::MinMax& texel = pyramid.GetTexel(level, x, y);
+					CHECK(texel.minDepth == expected.minDepth && texel.maxDepth == expected.maxDepth);
+				}
+			}
+		}
+
+		// Rect queries never miss a pixel, and a single pixel is read at level 0
+		for (uint32_t i = 0; i < 200; i++)
+		{
+			uint32_t x0 = (uint32_t)(unit(random) * width) % width;
+			uint32_t y0 = (uint32_t)(unit(random) * height) % height;
+			uint32_t x1 = std::min(x0 + (uint32_t)(unit(random) * unit(random) * width), width - 1);
+			uint32_t y1 = std::min(y0 + (uint32_t)(unit(random) * unit(random) * height), height - 1);
+
+			HiZPyramid::MinMax expected = bruteForce(x0, y0, x1, y1);
+			HiZPyramid::MinMax result = pyramid.QueryRect(x0, y0, x1, y1);
+			CHECK(result.minDepth <= expected.minDepth && result.maxDepth >= expected.maxDepth);
+
+			HiZPyramid::MinMax pixel = pyramid.QueryRect(x0, y0, x0, y0);
+			CHECK(pyramid.GetRectLevel(x0, y0, x0, y0) == 0 && pixel.minDepth == depth[y0 * width + x0] && pixel.maxDepth == depth[y0 * width + x0]);
+		}
+
+		HiZPyramid::MinMax whole = pyramid.QueryRect(0, 0, width - 1, height - 1);
+		HiZPyramid::MinMax expectedWhole = bruteForce(0, 0, width - 1, height - 1);
+		CHECK(whole.minDepth == expectedWhole.minDepth && whole.maxDepth == expectedWhole.maxDepth);
+	}
+
+	// Rebuilding with a different size doesn't keep anything of the old one
+	HiZPyramid pyramid;
+	std::vector<float> depth(48 * 48, 0.5f);
+	pyramid.Build(depth.data(), 48, 48);
+	depth.assign(5 * 3, 0.25f);
+	pyramid.Build(depth.data(), 5, 3);
+	CHECK(pyramid.GetLevelCount() == 3 && pyramid.GetWidth(1) == 2 && pyramid.GetHeight(1) == 1);
+	CHECK(pyramid.GetTexel(2, 0, 0).minDepth == 0.25f && pyramid.GetTexel(2, 0, 0).maxDepth == 0.25f);
+
+	return passed;
+}
\ No newline at end of file
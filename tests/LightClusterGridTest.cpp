@@ -0,0 +1,174 @@
+#include "Tests.h"
+#include "../class/LightClusterGrid.h"
+#include "../Maths/MathUtil.h"
+#include <algorithm>
+#include <random>
+#include <future>
+#include <vector>
+#include <cmath>
+
+// Camera space box of a cluster, tile edges are lines through camera so box holds them at both ends of the slice
+static void AcquireClusterBox(const LightClusterGrid& grid, uint32_t cluster, double tangentFOVH_2, double tangentFOVV_2, Vector3d& boxMin, Vector3d& boxMax)
+{
+	uint32_t x = cluster % LightClusterGrid::CLUSTER_X;
+	uint32_t y = (cluster / LightClusterGrid::CLUSTER_X) % LightClusterGrid::CLUSTER_Y;
+	uint32_t z = cluster / (LightClusterGrid::CLUSTER_X * LightClusterGrid::CLUSTER_Y);
+
+	double nearSliceDepth = grid.GetSliceDepth(z);
+	double farSliceDepth = grid.GetSliceDepth(z + 1);
+	double ndcMinX = -1.0 + 2.0 * x / LightClusterGrid::CLUSTER_X;
+	double ndcMaxX = ndcMinX + 2.0 / LightClusterGrid::CLUSTER_X;
+	double ndcMinY = -1.0 + 2.0 * y / LightClusterGrid::CLUSTER_Y;
+	double ndcMaxY = ndcMinY + 2.0 / LightClusterGrid::CLUSTER_Y;
+
+	// y is flipped, so that it grows downwards with tiles
+	boxMin = Vector3d(std::min(ndcMinX * nearSliceDepth, ndcMinX * farSliceDepth) * tangentFOVH_2, std::min(ndcMinY * nearSliceDepth, ndcMinY * farSliceDepth) * tangentFOVV_2, nearSliceDepth);
+	boxMax = Vector3d(std::max(ndcMaxX * nearSliceDepth, ndcMaxX * farSliceDepth) * tangentFOVH_2, std::max(ndcMaxY * nearSliceDepth, ndcMaxY * farSliceDepth) * tangentFOVV_2, farSliceDepth);
+}
+
+bool TestLightClusterGrid()
+{
+	const uint32_t CLUSTER_COUNT = LightClusterGrid::CLUSTER_COUNT;
+	const double tangentFOVV_2 = std::tan(PI / 6);
+	const double tangentFOVH_2 = tangentFOVV_2 * 16.0 / 9.0;
+	const double nearDepth = 0.1;
+	const double farDepth = 100;
+
+	bool passed = true;
+
+	LightClusterGrid grid;
+	grid.SetView(tangentFOVH_2, tangentFOVV_2, nearDepth, farDepth);
+
+	// Slice boundaries and lookup agree
+	CHECK(grid.GetSlice(nearDepth * 0.5) == 0);
+	CHECK(grid.GetSlice(farDepth * 1.01) == LightClusterGrid::CLUSTER_Z);
+	CHECK(std::abs(grid.GetSliceDepth(LightClusterGrid::CLUSTER_Z) - farDepth) < 1e-9);
+
+	for (uint32_t slice = 1; slice < LightClusterGrid::CLUSTER_Z; slice++)
+	{
+		CHECK(grid.GetSlice(grid.GetSliceDepth(slice) * 1.0001) == slice);
+		CHECK(grid.GetSlice(grid.GetSliceDepth(slice + 1) * 0.9999) == slice);
+	}
+
+	// Lights anywhere around frustum, crossing camera plane, behind camera, off screen and beyond far depth
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> unit(0, 1);
+
+	std::vector<LightClusterGrid::LightSphere> lights(400);
+	for (auto& light : lights)
+	{
+		double depth = unit(random) * farDepth * 1.2 - farDepth * 0.1;
+		double x = (unit(random) * 2 - 1) * std::abs(depth) * tangentFOVH_2 * 1.3;
+		double y = (unit(random) * 2 - 1) * std::abs(depth) * tangentFOVV_2 * 1.3;
+		light.center = Vector3f((float)x, (float)y, (float)-depth);
+		light.radius = (float)(0.05 + unit(random) * unit(random) * 10);
+	}
+
+	grid.SetLights(lights.data(), (uint32_t)lights.size());
+	for (uint32_t job = 0; job < grid.GetJobCount(); job++)
+		grid.AssignJob(job);
+
+	std::vector<uint32_t> ranges(CLUSTER_COUNT * 2);
+	std::vector<uint32_t> indices(CLUSTER_COUNT * 64);
+	uint32_t indicesCount = grid.Compact(ranges.data(), indices.data(), (uint32_t)indices.size());
+	CHECK(grid.GetDroppedIndicesCount() == 0);
+	CHECK(indicesCount != 0);
+
+	// Lists are packed back to back, each one ordered, without duplicates, and every light in it really touches cluster box
+	bool packed = true, ordered = true, touching = true;
+	uint32_t expectedOffset = 0;
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		packed &= ranges[cluster * 2] == expectedOffset;
+		expectedOffset += ranges[cluster * 2 + 1];
+
+		Vector3d boxMin, boxMax;
+		AcquireClusterBox(grid, cluster, tangentFOVH_2, tangentFOVV_2, boxMin, boxMax);
+
+		for (uint32_t i = 0; i < ranges[cluster * 2 + 1]; i++)
+		{
+			uint32_t light = indices[ranges[cluster * 2] + i];
+			if (light >= lights.size() || (i > 0 && light <= indices[ranges[cluster * 2] + i - 1]))
+			{
+				ordered = false;
+				continue;
+			}
+
+			Vector3d center(lights[light].center.x, -lights[light].center.y, -lights[light].center.z);
+			double squareDistance = 0;
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				double d = std::max(std::max(boxMin[axis] - center[axis], center[axis] - boxMax[axis]), 0.0);
+				squareDistance += d * d;
+			}
+			touching &= squareDistance <= lights[light].radius * lights[light].radius * 1.0001;
+		}
+	}
+
+	CHECK(packed && expectedOffset == indicesCount);
+	CHECK(ordered);
+	CHECK(touching);
+
+	// Any point inside a light finds that light in its cluster, the way a shader would look it up
+	bool found = true;
+	for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+	{
+		for (uint32_t j = 0; j < 32; j++)
+		{
+			Vector3d direction(unit(random) * 2 - 1, unit(random) * 2 - 1, unit(random) * 2 - 1);
+			if (direction.Length() < 1e-3)
+				continue;
+
+			double distance = std::cbrt(unit(random)) * lights[i].radius * 0.999;
+			Vector3d point = Vector3d(lights[i].center.x, lights[i].center.y, lights[i].center.z) + direction.Normal() * distance;
+
+			uint32_t cluster = grid.GetClusterIndex(point);
+			if (cluster == CLUSTER_COUNT)
+				continue;
+
+			auto begin = indices.begin() + ranges[cluster * 2];
+			found &= std::binary_search(begin, begin + ranges[cluster * 2 + 1], i);
+		}
+	}
+	CHECK(found);
+
+	// Jobs don't depend on each other, in reverse order or on their own threads
+	std::vector<uint32_t> reversedRanges(ranges.size());
+	std::vector<uint32_t> reversedIndices(indices.size());
+	for (uint32_t job = grid.GetJobCount(); job > 0; job--)
+		grid.AssignJob(job - 1);
+	CHECK(grid.Compact(reversedRanges.data(), reversedIndices.data(), (uint32_t)reversedIndices.size()) == indicesCount);
+	CHECK(reversedRanges == ranges && reversedIndices == indices);
+
+	std::vector<std::future<void>> jobs;
+	for (uint32_t job = 0; job < grid.GetJobCount(); job++)
+		jobs.push_back(std::async(std::launch::async, [&grid, job]() { grid.AssignJob(job); }));
+	for (auto& job : jobs)
+		job.wait();
+
+	std::vector<uint32_t> parallelRanges(ranges.size());
+	std::vector<uint32_t> parallelIndices(indices.size());
+	CHECK(grid.Compact(parallelRanges.data(), parallelIndices.data(), (uint32_t)parallelIndices.size()) == indicesCount);
+	CHECK(parallelRanges == ranges && parallelIndices == indices);
+
+	// Lists beyond capacity are cut, not overrun
+	uint32_t capacity = indicesCount / 3;
+	std::vector<uint32_t> cutIndices(capacity + 1, UINT32_MAX);
+	CHECK(grid.Compact(ranges.data(), cutIndices.data(), capacity) == capacity);
+	CHECK(grid.GetDroppedIndicesCount() == indicesCount - capacity);
+	CHECK(cutIndices[capacity] == UINT32_MAX);
+
+	bool withinCapacity = true;
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+		withinCapacity &= ranges[cluster * 2] + ranges[cluster * 2 + 1] <= capacity;
+	CHECK(withinCapacity);
+
+	// Nothing behind camera or beyond far depth
+	std::vector<LightClusterGrid::LightSphere> outsideLights = { { Vector3f(0, 0, 5), 4.0f }, { Vector3f(0, 0, (float)-farDepth * 1.1f), (float)farDepth * 0.05f } };
+	grid.SetLights(outsideLights.data(), (uint32_t)outsideLights.size());
+	for (uint32_t job = 0; job < grid.GetJobCount(); job++)
+		grid.AssignJob(job);
+	CHECK(grid.Compact(ranges.data(), indices.data(), (uint32_t)indices.size()) == 0);
+
+	return passed;
+}
\ No newline at end of file
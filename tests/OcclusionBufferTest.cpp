@@ -0,0 +1,104 @@
+#include "Tests.h"
+#include "../class/OcclusionBuffer.h"
+#include <cmath>
+#include <future>
+#include <vector>
+
+bool TestOcclusionBuffer()
+{
+	// 90 degrees field of view, square screen, camera at origin looking down -z
+	const double nearPlane = 0.1;
+	Matrix4d projection;
+	projection.x0 = 1;
+	projection.y1 = -1;
+	projection.z2 = 0;
+	projection.w2 = nearPlane;
+	projection.z3 = -1;
+	projection.w3 = 0;
+
+	auto rasterize = [](OcclusionBuffer& buffer)
+	{
+		for (uint32_t band = 0; band < buffer.GetBandCount(); band++)
+			buffer.RasterizeBand(band);
+		buffer.BuildHierarchy();
+	};
+
+	bool passed = true;
+	OcclusionBuffer buffer(64, 64);
+
+	// A wall at distance 10 covering the center half of screen, its 2 triangles wound differently
+	OcclusionBuffer::Occluder wall;
+	wall.positions = { { -5, -5, -10 }, { 5, -5, -10 }, { 5, 5, -10 }, { -5, 5, -10 } };
+	wall.indices = { 0, 1, 2, 0, 3, 2 };
+
+	buffer.SetView(Matrix4d(), projection);
+	buffer.AddOccluder(wall, Matrix4d());
+	rasterize(buffer);
+
+	CHECK(std::abs(buffer.GetDepth(32, 32) - nearPlane / 10) < 1e-6);
+	CHECK(std::abs(buffer.GetDepth(17, 46) - nearPlane / 10) < 1e-6);
+	CHECK(buffer.GetDepth(4, 4) == 0 && buffer.GetDepth(60, 32) == 0 && buffer.GetDepth(32, 15) == 0);
+
+	CHECK(!buffer.TestBox({ 0, 0, -20 }, { 2, 2, 2 }));			// Right behind wall
+	CHECK(!buffer.TestBox({ 0, 0, -10.5 }, { 0.2, 0.2, 0.2 }));	// Just behind wall
+	CHECK(buffer.TestBox({ 0, 0, -10 }, { 0.5, 0.5, 0.5 }));		// Through wall
+	CHECK(buffer.TestBox({ 0, 0, -6 }, { 1, 1, 1 }));			// In front of wall
+	CHECK(buffer.TestBox({ 12, 0, -20 }, { 2, 2, 2 }));			// Sticking out of wall's shadow
+	CHECK(buffer.TestBox({ 0, 0, -1 }, { 2, 2, 2 }));			// Around camera
+
+	// Same scene moved far away from origin, with camera following it
+	Matrix4d farTransform;
+	farTransform.c30 = 1e7;
+	farTransform.c31 = -3e6;
+	farTransform.c32 = 5e6;
+
+	buffer.SetView(farTransform, projection);
+	buffer.AddOccluder(wall, farTransform);
+	rasterize(buffer);
+
+	CHECK(std::abs(buffer.GetDepth(32, 32) - nearPlane / 10) < 1e-6);
+	CHECK(!buffer.TestBox(farTransform.TransformAsPoint({ 0, 0, -10.5 }), { 0.2, 0.2, 0.2 }));
+	CHECK(buffer.TestBox(farTransform.TransformAsPoint({ 0, 0, -10 }), { 0.5, 0.5, 0.5 }));
+
+	// Ground reaching behind camera, clipped by near plane
+	OcclusionBuffer::Occluder ground;
+	ground.positions = { { -50, -1, 10 }, { 50, -1, 10 }, { 50, -1, -100 }, { -50, -1, -100 } };
+	ground.indices = { 0, 1, 2, 2, 3, 0 };
+
+	buffer.SetView(Matrix4d(), projection);
+	buffer.AddOccluder(ground, Matrix4d());
+	rasterize(buffer);
+
+	CHECK(buffer.GetDepth(32, 63) > 0 && buffer.GetDepth(32, 0) == 0);
+	CHECK(!buffer.TestBox({ 0, -3, -20 }, { 1, 1, 1 }));		// Under ground
+	CHECK(buffer.TestBox({ 0, 1, -20 }, { 1, 1, 1 }));		// Above ground
+
+	// Bands rasterized on their own threads end up the same as one after another
+	std::vector<float> depths;
+	for (uint32_t y = 0; y < buffer.GetHeight(); y++)
+		for (uint32_t x = 0; x < buffer.GetWidth(); x++)
+			depths.push_back(buffer.GetDepth(x, y));
+
+	buffer.SetView(Matrix4d(), projection);
+	buffer.AddOccluder(ground, Matrix4d());
+
+	std::vector<std::future<void>> bandJobs;
+	for (uint32_t band = 0; band < buffer.GetBandCount(); band++)
+		bandJobs.push_back(std::async(std::launch::async, [&buffer, band]() { buffer.RasterizeBand(band); }));
+	for (auto& bandJob : bandJobs)
+		bandJob.wait();
+	buffer.BuildHierarchy();
+
+	for (uint32_t y = 0; y < buffer.GetHeight(); y++)
+		for (uint32_t x = 0; x < buffer.GetWidth(); x++)
+			CHECK(buffer.GetDepth(x, y) == depths[y * buffer.GetWidth() + x]);
+
+	// Position is the first attribute of an interleaved vertex
+	const float vertices[] = { 1, 2, 3, 0, 1, 4, 5, 6, 1, 0 };
+	const uint32_t indices[] = { 0, 1, 0 };
+	std::shared_ptr<OcclusionBuffer::Occluder> pOccluder = OcclusionBuffer::CreateOccluder(vertices, 2, sizeof(float) * 5, indices, 3);
+	CHECK(pOccluder->positions.size() == 2 && pOccluder->indices.size() == 3);
+	CHECK(pOccluder->positions[0] == Vector3f(1, 2, 3) && pOccluder->positions[1] == Vector3f(4, 5, 6));
+
+	return passed;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "Tests.h"
+#include "../class/PerDrawData.h"
+#include <random>
+#include <vector>
+
+bool TestPerDrawData()
+{
+	const uint32_t STRIDE = (uint32_t)sizeof(PerMaterialIndirectVariables);
+	const uint32_t MIN_OFFSET_ALIGNMENTS[] = { 4, 16, 64, 256 };
+
+	bool passed = true;
+
+	// Push variants are found next to the shader they replace, anything else has none
+	CHECK(PerDrawData::AcquirePushVariantPath(L"../data/shaders/pbr_gbuffer_gen.vert.spv") == L"../data/shaders/pbr_gbuffer_gen_push.vert.spv");
+	CHECK(PerDrawData::AcquirePushVariantPath(L"../data/shaders/pbr_gbuffer_gen_packed.vert.spv") == L"../data/shaders/pbr_gbuffer_gen_packed_push.vert.spv");
+	CHECK(PerDrawData::AcquirePushVariantPath(L"../data/shaders/pbr_gbuffer_gen_push.vert.spv") == L"../data/shaders/pbr_gbuffer_gen_push.vert.spv");
+	CHECK(PerDrawData::AcquirePushVariantPath(L"../data/shaders/pbr_gbuffer_gen.frag.spv") == L"");
+	CHECK(PerDrawData::AcquirePushVariantPath(L"") == L"");
+
+	// Only push constants depend on a push variant, and fall back to dynamic offsets without one
+	for (uint32_t i = 0; i < PerDrawDataStrategyCount; i++)
+	{
+		PerDrawDataStrategy strategy = (PerDrawDataStrategy)i;
+		CHECK(PerDrawData::ResolveStrategy(strategy, true) == strategy);
+		CHECK(PerDrawData::ResolveStrategy(strategy, false) == (strategy == PerDrawData_PushConstants ? PerDrawData_DynamicOffset : strategy));
+	}
+
+	// Draws with random instance counts, each instance tagged with its draw and instance so that lookups can be verified
+	std::mt19937 random(5);
+	std::uniform_int_distribution<uint32_t> instances(1, 9);
+
+	std::vector<std::vector<PerMaterialIndirectVariables>> draws(200);
+	for (uint32_t i = 0; i < (uint32_t)draws.size(); i++)
+	{
+		draws[i].resize(instances(random));
+		for (uint32_t j = 0; j < (uint32_t)draws[i].size(); j++)
+			draws[i][j] = { i, j, i * 7 + j, 3 };
+	}
+
+	for (uint32_t minAlign : MIN_OFFSET_ALIGNMENTS)
+	{
+		for (uint32_t i = 0; i < PerDrawDataStrategyCount; i++)
+		{
+			PerDrawDataStrategy strategy = (PerDrawDataStrategy)i;
+			uint32_t alignment = PerDrawData::AcquireAlignment(strategy, minAlign);
+			CHECK(alignment >= 1);
+
+			// Offsets of strategies indexing variables directly are packed, dynamic offsets land on device alignment
+			if (strategy != PerDrawData_DynamicOffset)
+				CHECK(alignment == 1);
+			if (strategy == PerDrawData_DynamicOffset)
+				CHECK(alignment * STRIDE % minAlign == 0 && (alignment - 1) * STRIDE < minAlign);
+
+			// A frame's variables start on an aligned boundary within buffer, as frame offsets of uniform storages do
+			uint32_t frameOffset = minAlign * STRIDE * 3;
+
+			std::vector<PerMaterialIndirectVariables> variables;
+			std::vector<uint32_t> offsets;
+			for (auto& draw : draws)
+				offsets.push_back(PerDrawData::AppendIndirectVariables(variables, draw.data(), (uint32_t)draw.size(), alignment));
+
+			bool aligned = true, ordered = true, found = true, packed = true;
+			uint32_t expectedEnd = 0;
+			for (uint32_t d = 0; d < (uint32_t)draws.size(); d++)
+			{
+				aligned &= offsets[d] % alignment == 0;
+				ordered &= offsets[d] >= expectedEnd;
+				packed &= offsets[d] - expectedEnd < alignment;
+				expectedEnd = offsets[d] + (uint32_t)draws[d].size();
+
+				for (uint32_t j = 0; j < (uint32_t)draws[d].size(); j++)
+				{
+					// What vertex shader reads for instance j of this draw, indexed from the offset it finds its variables with:
+					// offset table at draw id, pushed offset, or buffer bound at dynamic offset
+					uint32_t index;
+					if (strategy == PerDrawData_DynamicOffset)
+					{
+						uint32_t dynamicOffset = PerDrawData::AcquireDynamicOffset(frameOffset, offsets[d]);
+						aligned &= dynamicOffset % minAlign == 0;
+						index = (dynamicOffset - frameOffset) / STRIDE + j;
+					}
+					else
+						index = offsets[d] + j;
+
+					const PerMaterialIndirectVariables& v = variables[index];
+					found &= v.perObjectIndex == d && v.perMaterialIndex == j && v.perMeshIndex == d * 7 + j && v.utilityIndex == 3;
+				}
+			}
+
+			CHECK(aligned);
+			CHECK(ordered);
+			CHECK(packed && expectedEnd == (uint32_t)variables.size());
+			CHECK(found);
+		}
+	}
+
+	return passed;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "Tests.h"
+#include "../class/PlanetHorizon.h"
+#include <random>
+#include <cmath>
+
+// Brute force: a point is hidden if segment from camera to it enters sphere first
+static bool SegmentHitsSphere(const Vector3d& from, const Vector3d& to, double radius)
+{
+	Vector3d dir = to - from;
+	double a = dir.SquareLength();
+	double b = from * dir;
+	double c = from.SquareLength() - radius * radius;
+	double discriminant = b * b - a * c;
+	if (discriminant < 0.0)
+		return false;
+
+	double t = (-b - std::sqrt(discriminant)) / a;
+	return t > 0.0 && t < 1.0;
+}
+
+bool TestPlanetHorizon()
+{
+	const double radius = 1000.0;
+
+	bool passed = true;
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> unit(-1, 1);
+
+	// Sphere shrinks or grows a little so that only points clear of horizon are checked
+	PlanetHorizon horizon;
+	uint32_t hiddenCount = 0;
+	uint32_t wrongHiddenCount = 0;
+	uint32_t wrongVisibleCount = 0;
+	for (uint32_t i = 0; i < 100000; i++)
+	{
+		Vector3d cameraDir = { unit(random), unit(random), unit(random) };
+		Vector3d pointDir = { unit(random), unit(random), unit(random) };
+		if (cameraDir.Length() < 0.01 || pointDir.Length() < 0.01)
+			continue;
+
+		// Camera from 0.1 meter up to 10 radii above surface, points from surface up to 3 radii
+		Vector3d camera = cameraDir.Normal() * radius * (1.0 + std::pow(10.0, unit(random) * 2.5 - 1.5));
+		horizon.SetView(camera, radius);
+
+		Vector3d p = pointDir.Normal() * radius * (2.0 + unit(random));
+
+		bool hidden = horizon.IsHidden(p);
+		if (hidden && !SegmentHitsSphere(camera, p, radius * (1.0 - 1e-6)))
+			wrongHiddenCount++;
+
+		if (!hidden && SegmentHitsSphere(camera, p, radius * (1.0 + 1e-6)) && p.Length() > radius * (1.0 + 1e-6))
+			wrongVisibleCount++;
+
+		hiddenCount += hidden ? 1 : 0;
+	}
+
+	CHECK(wrongHiddenCount == 0);
+	CHECK(wrongVisibleCount == 0);
+	CHECK(hiddenCount > 0);
+
+	// Camera inside sphere hides nothing
+	horizon.SetView({ 0, 0, 500 }, radius);
+	CHECK(!horizon.IsHidden({ 0, 0, -2000 }));
+
+	// Right behind planet, and a point above horizon seen past it
+	horizon.SetView({ 0, 0, 2000 }, radius);
+	CHECK(horizon.IsHidden({ 0, 0, -1500 }));
+	CHECK(!horizon.IsHidden({ 0, 1500, -500 }));
+
+	return passed;
+}
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "Tests.h"
+#include "../class/PlanetSubdivider.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <limits>
+
+// Small planet seen at 1080p with 60 degrees vertical FOV, levels are capped low enough that ground next to camera reaches max level
+static const double RADIUS = 1000.0;
+static const double TERRAIN_HEIGHT = 50.0;
+static const double TANGENT_FOVV_2 = 0.57735026918962576;
+static const double ASPECT = 16.0 / 9.0;
+static const double PIXELS_PER_UNIT = 1080.0 / (2.0 * TANGENT_FOVV_2);
+static const double TRIANGLE_SCREEN_SIZE = 40.0;
+static const uint32_t MAX_LOD_LEVEL = 12;
+
+typedef struct _Camera
+{
+	Vector3d		position;
+	PyramidFrustumd	frustum;
+	double			spread;		// How far around nadir terrain samples go
+}Camera;
+
+// Emitted triangle back in planet space
+typedef struct _Patch
+{
+	Vector3d	a;
+	Vector3d	b;
+	Vector3d	c;
+	uint32_t	level;
+}Patch;
+
+// Brute force: a point is hidden if segment from camera to it enters sphere first
+static bool SegmentHitsSphere(const Vector3d& from, const Vector3d& to, double radius)
+{
+	Vector3d dir = to - from;
+	double a = dir.SquareLength();
+	double b = from * dir;
+	double c = from.SquareLength() - radius * radius;
+	double discriminant = b * b - a * c;
+	if (discriminant < 0.0)
+		return false;
+
+	double t = (-b - std::sqrt(discriminant)) / a;
+	return t > 0.0 && t < 1.0;
+}
+
+// Whether ray from planet center along "dir" passes through triangle, a little tolerance covers single precision of emitted vertices
+static bool RayHitsPatch(const Vector3d& dir, const Patch& patch)
+{
+	Vector3d edge0 = patch.b - patch.a;
+	Vector3d edge1 = patch.c - patch.a;
+	Vector3d p = dir ^ edge1;
+	double determinant = edge0 * p;
+	if (std::abs(determinant) < 1e-12)
+		return false;
+
+	Vector3d s = patch.a.Negative();
+	double u = (s * p) / determinant;
+	Vector3d q = s ^ edge0;
+	double v = (dir * q) / determinant;
+	double t = (edge1 * q) / determinant;
+
+	const double tolerance = 1e-3;
+	return t > 0.0 && u >= -tolerance && v >= -tolerance && u + v <= 1.0 + tolerance;
+}
+
+static std::vector<double> AcquireDistanceLUT(const Vector3d vertices[], const uint32_t indices[])
+{
+	std::vector<double> distanceLUT;
+	double size = (vertices[indices[1]] - vertices[indices[2]]).Length();
+	for (uint32_t i = 0; i < MAX_LOD_LEVEL; i++)
+	{
+		distanceLUT.push_back(PlanetSubdivider::ComputeLODDistance(size * RADIUS, PIXELS_PER_UNIT, TRIANGLE_SCREEN_SIZE));
+		size *= 0.5;
+	}
+	return distanceLUT;
+}
+
+static Camera AcquireCamera(const Vector3d& up, double altitude, double pitch, double spread)
+{
+	Vector3d heading = (up ^ Vector3d(0, 0, 1)).Normal();
+
+	Camera camera;
+	camera.position = up * (RADIUS + altitude);
+	camera.frustum = PyramidFrustumd({ 0, 0, 0 }, heading * std::cos(pitch) + up * std::sin(pitch), std::atan(TANGENT_FOVV_2), ASPECT);
+	camera.frustum.Transform(Matrix4d(Matrix3d(), camera.position));
+	camera.spread = spread;
+	return camera;
+}
+
+// Triangles are emitted relative to camera, so that distances are read off directly
+static std::vector<Patch> Generate(PlanetSubdivider& planet, const Camera& camera, std::vector<PlanetSubdivider::Triangle>& triangles)
+{
+	planet.SetView(camera.position, camera.frustum, camera.position);
+	uint32_t count = planet.GenerateTriangles(triangles.data());
+
+	std::vector<Patch> patches(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const PlanetSubdivider::Triangle& triangle = triangles[i];
+		Vector3d p(triangle.p.x, triangle.p.y, triangle.p.z);
+		patches[i].a = camera.position + p;
+		patches[i].b = camera.position + p + Vector3d(triangle.edge0.x, triangle.edge0.y, triangle.edge0.z);
+		patches[i].c = camera.position + p + Vector3d(triangle.edge1.x, triangle.edge1.y, triangle.edge1.z);
+		patches[i].level = (uint32_t)std::abs(triangle.level) - 1;
+	}
+	return patches;
+}
+
+// Terrain points seen from camera that no patch lies under, out of those seen
+static uint32_t AcquireUncoveredCount(const std::vector<Patch>& patches, const Camera& camera, uint32_t& visibleCount)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<double> unit(-1, 1);
+
+	Vector3d nadir = camera.position.Normal();
+
+	uint32_t uncoveredCount = 0;
+	visibleCount = 0;
+	for (uint32_t i = 0; i < 20000; i++)
+	{
+		Vector3d dir = (nadir + Vector3d(unit(random), unit(random), unit(random)) * camera.spread).Normal();
+		Vector3d p = dir * (RADIUS + (unit(random) + 1.0) * 0.5 * TERRAIN_HEIGHT);
+
+		// Side planes only, as generator does, and clear of planet sphere
+		bool inFrustum = true;
+		for (uint32_t j = 0; j < camera.frustum.FrustumFace_NEAR; j++)
+			inFrustum &= camera.frustum.planes[j].PlaneTest(p) > 0;
+
+		if (!inFrustum || SegmentHitsSphere(camera.position, p, RADIUS * (1.0 + 1e-6)))
+			continue;
+
+		visibleCount++;
+		bool covered = std::any_of(patches.begin(), patches.end(), [&dir](const Patch& patch) { return RayHitsPatch(dir, patch); });
+		uncoveredCount += covered ? 0 : 1;
+	}
+
+	return uncoveredCount;
+}
+
+bool TestPlanetSubdivider()
+{
+	bool passed = true;
+
+	Vector3d vertices[8];
+	uint32_t indices[36];
+	PlanetSubdivider::GenerateCube(vertices, indices);
+	std::vector<double> distanceLUT = AcquireDistanceLUT(vertices, indices);
+
+	// Cube corners are on unit sphere, each face quad is its first 3 and last index
+	for (uint32_t i = 0; i < 8; i++)
+		CHECK(std::abs(vertices[i].Length() - 1.0) < 1e-12);
+	for (uint32_t i = 0; i < 6; i++)
+		CHECK((vertices[indices[i * 6 + 1]] - vertices[indices[i * 6 + 0]]) * (vertices[indices[i * 6 + 2]] - vertices[indices[i * 6 + 0]]) < 1e-12);
+
+	PlanetSubdivider flat, terrain, terrainNoHorizon;
+	flat.Init(vertices, indices, RADIUS, 0, MAX_LOD_LEVEL, distanceLUT);
+	terrain.Init(vertices, indices, RADIUS, TERRAIN_HEIGHT, MAX_LOD_LEVEL, distanceLUT);
+	terrainNoHorizon.Init(vertices, indices, RADIUS, TERRAIN_HEIGHT, MAX_LOD_LEVEL, distanceLUT);
+	terrainNoHorizon.SetHorizonCulling(false);
+
+	// Patch bounds rise with terrain
+	CHECK(terrain.GetBoundHeight(0) > flat.GetBoundHeight(0) && flat.GetBoundHeight(0) > 1.0);
+	CHECK(terrain.GetBoundHeight(MAX_LOD_LEVEL) >= (RADIUS + TERRAIN_HEIGHT) / RADIUS);
+
+	// Off cube axes, standing on ground looking a little down at horizon, and from orbit looking at planet
+	Vector3d up = Vector3d(0.3, 0.9, 0.2).Normal();
+	Camera cameras[] =
+	{
+		AcquireCamera(up, 5.0, -5.0 * 3.14159265358979 / 180.0, 0.6),
+		AcquireCamera(up, RADIUS, -3.14159265358979 / 2.0, 3.0),
+	};
+
+	// Far more than any case emits, "GenerateTriangles" doesn't check bounds
+	std::vector<PlanetSubdivider::Triangle> triangles(1 << 18);
+
+	for (const Camera& camera : cameras)
+	{
+		std::vector<Patch> patches = Generate(terrain, camera, triangles);
+		CHECK(!patches.empty() && patches.size() < triangles.size());
+
+		// Screen space error: a patch is split until its nearest corner is no nearer than distance table allows at its level,
+		// and no further than that, its parent's nearest corner was nearer than table allowed one level up
+		// Patch edges on sphere are up to square root of 3 times longer than cube face edges they come from, at face centers
+		bool fineEnough = true, coarseEnough = true, withinScreenSize = true;
+		const Patch* pNearest = &patches[0];
+		double nearestDistance = std::numeric_limits<double>::max();
+		for (const Patch& patch : patches)
+		{
+			double minDistance = std::min(std::min((patch.a - camera.position).Length(), (patch.b - camera.position).Length()), (patch.c - camera.position).Length());
+			double maxEdge = std::max(std::max((patch.b - patch.a).Length(), (patch.c - patch.a).Length()), (patch.c - patch.b).Length());
+
+			if (patch.level < MAX_LOD_LEVEL)
+			{
+				fineEnough &= minDistance >= distanceLUT[patch.level] * (1.0 - 1e-4);
+				withinScreenSize &= maxEdge * PIXELS_PER_UNIT / minDistance <= TRIANGLE_SCREEN_SIZE * std::sqrt(3.0) * 1.01;
+			}
+
+			if (patch.level > 0)
+				coarseEnough &= minDistance < distanceLUT[patch.level - 1] + maxEdge * 2.5;
+
+			if (minDistance < nearestDistance)
+			{
+				nearestDistance = minDistance;
+				pNearest = &patch;
+			}
+		}
+
+		CHECK(fineEnough);
+		CHECK(coarseEnough);
+		CHECK(withinScreenSize);
+
+		// Ground next to camera gets finest level
+		if (&camera == &cameras[0])
+			CHECK(pNearest->level == MAX_LOD_LEVEL);
+
+		// Every terrain point camera could see has a patch under it, bounds that ignore terrain drop some of them
+		uint32_t visibleCount;
+		CHECK(AcquireUncoveredCount(patches, camera, visibleCount) == 0);
+		CHECK(visibleCount > 1000);
+
+		std::vector<Patch> flatPatches = Generate(flat, camera, triangles);
+		CHECK(AcquireUncoveredCount(flatPatches, camera, visibleCount) > 0);
+
+		// Horizon culling only ever drops patches
+		std::vector<Patch> noHorizonPatches = Generate(terrainNoHorizon, camera, triangles);
+		CHECK(noHorizonPatches.size() > patches.size());
+	}
+
+	return passed;
+}
\ No newline at end of file
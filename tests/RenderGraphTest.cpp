@@ -0,0 +1,281 @@
+#include "Tests.h"
+#include "../class/RenderGraph.h"
+#include <algorithm>
+#include <vector>
+
+static uint32_t ExecutionIndex(const RenderGraph& graph, uint32_t pass)
+{
+	const std::vector<uint32_t>& order = graph.GetExecutionOrder();
+	return (uint32_t)(std::find(order.begin(), order.end(), pass) - order.begin());
+}
+
+// Every live pass runs after what it depends on, one level above the highest of them
+static bool IsTopologicallySorted(const RenderGraph& graph)
+{
+	for (uint32_t pass : graph.GetExecutionOrder())
+	{
+		uint32_t level = 0;
+		for (uint32_t dependency : graph.GetPassDependencies(pass))
+		{
+			if (graph.IsPassCulled(dependency) || ExecutionIndex(graph, dependency) >= ExecutionIndex(graph, pass))
+				return false;
+			level = std::max(level, graph.GetPassLevel(dependency) + 1);
+		}
+
+		if (level != graph.GetPassLevel(pass))
+			return false;
+	}
+
+	return true;
+}
+
+static const RenderGraph::Barrier* FindBarrier(const RenderGraph& graph, uint32_t pass, uint32_t resource)
+{
+	for (auto& barrier : graph.GetPassBarriers(pass))
+	{
+		if (barrier.resource == resource)
+			return &barrier;
+	}
+	return nullptr;
+}
+
+static bool TestCulling()
+{
+	bool passed = true;
+
+	// Only what ends up in an external resource is kept, whatever order it's declared in
+	RenderGraph graph;
+	uint32_t unused = graph.AddResource();
+	uint32_t transient = graph.AddResource();
+	uint32_t backBuffer = graph.AddResource(true);
+
+	uint32_t deadPass = graph.AddPass();
+	graph.Write(deadPass, unused, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t producer = graph.AddPass();
+	graph.Write(producer, transient, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t deadReader = graph.AddPass();
+	graph.Read(deadReader, transient);
+	graph.Read(deadReader, unused);
+	graph.Write(deadReader, unused, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t present = graph.AddPass();
+	graph.Read(present, transient);
+	graph.Write(present, backBuffer, RenderGraph::ResourceUsage_ColorAttachment);
+
+	graph.Compile();
+
+	CHECK(graph.IsPassCulled(deadPass));
+	CHECK(graph.IsPassCulled(deadReader));
+	CHECK(!graph.IsPassCulled(producer));
+	CHECK(!graph.IsPassCulled(present));
+	CHECK(graph.GetExecutionOrder() == std::vector<uint32_t>({ producer, present }));
+
+	// A culled reader doesn't hold anything back
+	CHECK(graph.GetPassDependencies(present) == std::vector<uint32_t>({ producer }));
+	CHECK(graph.GetLevelsCount() == 2);
+
+	return passed;
+}
+
+static bool TestOrder()
+{
+	bool passed = true;
+
+	// Two chains declared one after another are independent, sorting interleaves them level by level
+	RenderGraph graph;
+	uint32_t shadow = graph.AddResource();
+	uint32_t gbuffer = graph.AddResource();
+	uint32_t blurredShadow = graph.AddResource();
+	uint32_t ssao = graph.AddResource();
+	uint32_t backBuffer = graph.AddResource(true);
+
+	uint32_t shadowPass = graph.AddPass();
+	graph.Write(shadowPass, shadow, RenderGraph::ResourceUsage_DepthStencilAttachment);
+
+	uint32_t shadowBlurPass = graph.AddPass();
+	graph.Read(shadowBlurPass, shadow);
+	graph.Write(shadowBlurPass, blurredShadow, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t gbufferPass = graph.AddPass();
+	graph.Write(gbufferPass, gbuffer, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t ssaoPass = graph.AddPass();
+	graph.Read(ssaoPass, gbuffer);
+	graph.Write(ssaoPass, ssao, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t shadingPass = graph.AddPass();
+	graph.Read(shadingPass, gbuffer);
+	graph.Read(shadingPass, blurredShadow);
+	graph.Read(shadingPass, ssao);
+	graph.Write(shadingPass, backBuffer, RenderGraph::ResourceUsage_ColorAttachment);
+
+	graph.Compile();
+
+	CHECK(graph.GetLevelsCount() == 3);
+	CHECK(graph.GetPassLevel(shadowPass) == 0 && graph.GetPassLevel(gbufferPass) == 0);
+	CHECK(graph.GetPassLevel(shadowBlurPass) == 1 && graph.GetPassLevel(ssaoPass) == 1);
+	CHECK(graph.GetPassLevel(shadingPass) == 2);
+	CHECK(graph.GetExecutionOrder() == std::vector<uint32_t>({ shadowPass, gbufferPass, shadowBlurPass, ssaoPass, shadingPass }));
+	CHECK(IsTopologicallySorted(graph));
+
+	// Reads of the same write don't order each other
+	CHECK(graph.GetPassDependencies(ssaoPass) == std::vector<uint32_t>({ gbufferPass }));
+
+	// Overwriting a resource waits for every read of what was there before, and for that write
+	RenderGraph reuse;
+	uint32_t scratch = reuse.AddResource();
+	uint32_t output0 = reuse.AddResource(true);
+	uint32_t output1 = reuse.AddResource(true);
+	uint32_t output2 = reuse.AddResource(true);
+
+	uint32_t write0 = reuse.AddPass();
+	reuse.Write(write0, scratch, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t read0 = reuse.AddPass();
+	reuse.Read(read0, scratch);
+	reuse.Write(read0, output0, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t write1 = reuse.AddPass();
+	reuse.Write(write1, scratch, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t read1 = reuse.AddPass();
+	reuse.Read(read1, scratch);
+	reuse.Write(read1, output1, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t independent = reuse.AddPass();
+	reuse.Write(independent, output2, RenderGraph::ResourceUsage_ColorAttachment);
+
+	reuse.Compile();
+
+	CHECK(reuse.GetPassDependencies(write1) == std::vector<uint32_t>({ write0, read0 }));
+	CHECK(reuse.GetPassDependencies(read1) == std::vector<uint32_t>({ write1 }));
+	CHECK(reuse.GetPassLevel(independent) == 0);
+	CHECK(reuse.GetExecutionOrder() == std::vector<uint32_t>({ write0, independent, read0, write1, read1 }));
+	CHECK(IsTopologicallySorted(reuse));
+
+	return passed;
+}
+
+static bool TestBarriers()
+{
+	bool passed = true;
+
+	RenderGraph graph;
+	uint32_t history = graph.AddResource(true, RenderGraph::ResourceUsage_ColorAttachment);
+	uint32_t color = graph.AddResource();
+	uint32_t depth = graph.AddResource();
+	uint32_t backBuffer = graph.AddResource(true);
+
+	uint32_t scenePass = graph.AddPass();
+	graph.Write(scenePass, color, RenderGraph::ResourceUsage_ColorAttachment);
+	graph.Write(scenePass, depth, RenderGraph::ResourceUsage_DepthStencilAttachment);
+
+	// Reads depth it also has attached
+	uint32_t fogPass = graph.AddPass();
+	graph.Read(fogPass, depth);
+	graph.Read(fogPass, color);
+	graph.Write(fogPass, depth, RenderGraph::ResourceUsage_DepthStencilAttachment);
+	graph.Write(fogPass, backBuffer, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t resolvePass = graph.AddPass();
+	graph.Read(resolvePass, color);
+	graph.Read(resolvePass, history);
+	graph.Write(resolvePass, history, RenderGraph::ResourceUsage_ColorAttachment);
+
+	graph.Compile();
+
+	// Fresh transient resources need nothing
+	CHECK(graph.GetPassBarriers(scenePass).size() == 0);
+
+	const RenderGraph::Barrier* pBarrier = FindBarrier(graph, fogPass, color);
+	CHECK(pBarrier != nullptr && pBarrier->srcUsages == RenderGraph::ResourceUsage_ColorAttachment && pBarrier->dstUsages == RenderGraph::ResourceUsage_ShaderRead && !pBarrier->discard);
+
+	pBarrier = FindBarrier(graph, fogPass, depth);
+	CHECK(pBarrier != nullptr && pBarrier->srcUsages == RenderGraph::ResourceUsage_DepthStencilAttachment
+		&& pBarrier->dstUsages == (RenderGraph::ResourceUsage_ShaderRead | RenderGraph::ResourceUsage_DepthStencilAttachment));
+
+	// Second read of the same write is already covered, whichever of the readers runs first
+	CHECK(FindBarrier(graph, resolvePass, color) == nullptr || FindBarrier(graph, fogPass, color) == nullptr);
+
+	// External resource starts from how last frame used it
+	pBarrier = FindBarrier(graph, resolvePass, history);
+	CHECK(pBarrier != nullptr && pBarrier->srcUsages == RenderGraph::ResourceUsage_ColorAttachment
+		&& pBarrier->dstUsages == (RenderGraph::ResourceUsage_ShaderRead | RenderGraph::ResourceUsage_ColorAttachment));
+
+	uint32_t barriersCount = 0;
+	for (uint32_t pass : graph.GetExecutionOrder())
+		barriersCount += (uint32_t)graph.GetPassBarriers(pass).size();
+	CHECK(barriersCount == graph.GetBarriersCount() && barriersCount == 3);
+
+	return passed;
+}
+
+static bool TestPlaceResources()
+{
+	bool passed = true;
+
+	// Two independent chains, each with a transient resource: sorting alone would run them side by side
+	RenderGraph graph;
+	uint32_t transient0 = graph.AddResource();
+	uint32_t transient1 = graph.AddResource();
+	uint32_t longLived = graph.AddResource();
+	uint32_t output0 = graph.AddResource(true);
+	uint32_t output1 = graph.AddResource(true);
+
+	uint32_t write0 = graph.AddPass();
+	graph.Write(write0, transient0, RenderGraph::ResourceUsage_ColorAttachment);
+	graph.Write(write0, longLived, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t read0 = graph.AddPass();
+	graph.Read(read0, transient0);
+	graph.Write(read0, output0, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t write1 = graph.AddPass();
+	graph.Write(write1, transient1, RenderGraph::ResourceUsage_ColorAttachment);
+
+	uint32_t read1 = graph.AddPass();
+	graph.Read(read1, transient1);
+	graph.Read(read1, longLived);
+	graph.Write(read1, output1, RenderGraph::ResourceUsage_ColorAttachment);
+
+	graph.Compile();
+	CHECK(graph.GetPassLevel(write0) == 0 && graph.GetPassLevel(write1) == 0);
+
+	graph.SetResourceMemory(transient0, { 0, 0, 100, 16 });
+	graph.SetResourceMemory(transient1, { 0, 0, 100, 16 });
+	graph.SetResourceMemory(longLived, { 0, 0, 50, 16 });
+
+	// Transient ones don't live at the same time in declaration order, so they share bytes, the long lived one goes after them
+	std::vector<uint32_t> heapSizes = graph.PlaceResources();
+	CHECK(graph.GetResourceMemory(transient0).offset == 0 && graph.GetResourceMemory(transient1).offset == 0);
+	CHECK(graph.GetResourceMemory(longLived).offset == 112);
+	CHECK(heapSizes == std::vector<uint32_t>({ 162 }));
+
+	// Once they share bytes, every use of the first one is done before the second one starts
+	graph.Compile();
+	CHECK(IsTopologicallySorted(graph));
+	CHECK(graph.GetExecutionOrder() == std::vector<uint32_t>({ write0, read0, write1, read1 }));
+
+	const RenderGraph::Barrier* pBarrier = FindBarrier(graph, write1, transient1);
+	CHECK(pBarrier != nullptr && pBarrier->discard && (pBarrier->srcUsages & RenderGraph::ResourceUsage_ShaderRead) != 0
+		&& pBarrier->dstUsages == RenderGraph::ResourceUsage_ColorAttachment);
+
+	// Memory of different heaps never overlaps
+	graph.SetResourceMemory(transient1, { 1, 0, 100, 16 });
+	heapSizes = graph.PlaceResources();
+	CHECK(heapSizes == std::vector<uint32_t>({ 162, 100 }));
+
+	return passed;
+}
+
+bool TestRenderGraph()
+{
+	bool passed = true;
+	passed &= TestCulling();
+	passed &= TestOrder();
+	passed &= TestBarriers();
+	passed &= TestPlaceResources();
+	return passed;
+}
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "Tests.h"
+#include "../class/StreamingScheduler.h"
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Deterministic stand in for a level: objects scattered over a square split into districts, each district draws most of its meshes
+// and texture slots from a pool of its own and the rest from a pool shared by all, so what's needed changes as camera moves around
+typedef struct _SimulatedScene
+{
+	std::vector<uint64_t>	resourceSizes;
+	std::vector<double>		objectX;
+	std::vector<double>		objectZ;
+	std::vector<double>		objectRadius;
+	std::vector<uint32_t>	objectResources;	// SIMULATED_RESOURCES_PER_OBJECT per object: mesh, albedo and normal slot
+}SimulatedScene;
+
+typedef struct _SimulatedPose
+{
+	double	x;
+	double	z;
+	double	yaw;		// Radian, 0 looks towards +z
+}SimulatedPose;
+
+static const uint32_t SIMULATED_RESOURCES_PER_OBJECT = 3;
+static const double SIMULATED_SCENE_SIZE = 600.0;
+static const uint32_t SIMULATED_DISTRICTS = 4;			// Per side
+static const double SIMULATED_FAR_PLANE = 200.0;
+static const double SIMULATED_TAN_HALF_FOV = 0.57735;	// 60 degrees vertically
+static const double SIMULATED_ASPECT = 16.0 / 9.0;
+
+// Loader reads this much per frame after a fixed latency per request, about 240MB/s at 60 fps
+static const double SIMULATED_LOADER_BYTES_PER_FRAME = 4.0 * 1024 * 1024;
+static const double SIMULATED_LOADER_LATENCY = 0.25;	// Frames
+
+typedef struct _SimulationResult
+{
+	double		averageResidentMB;
+	double		peakResidentMB;
+	double		missRatio;			// Misses over visible resources, summed over every frame
+	double		loadedMB;			// Read by loader over whole path
+}SimulationResult;
+
+static SimulatedScene BuildSimulatedScene()
+{
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> unit(0, 1);
+
+	SimulatedScene scene;
+
+	const uint32_t districtsCount = SIMULATED_DISTRICTS * SIMULATED_DISTRICTS;
+	const uint32_t meshesPerPool = 10;
+	const uint32_t texturesPerPool = 16;
+
+	// Pool 0 is shared, the rest belong to districts
+	std::vector<std::vector<uint32_t>> meshPools(districtsCount + 1);
+	std::vector<std::vector<uint32_t>> texturePools(districtsCount + 1);
+	for (uint32_t pool = 0; pool <= districtsCount; pool++)
+	{
+		for (uint32_t i = 0; i < meshesPerPool; i++)
+		{
+			meshPools[pool].push_back((uint32_t)scene.resourceSizes.size());
+			scene.resourceSizes.push_back((uint64_t)((0.5 + unit(random) * 5.5) * 1024 * 1024));
+		}
+
+		// 1024 by 1024 with full mip chain, mostly RGBA8 and some R8
+		for (uint32_t i = 0; i < texturesPerPool; i++)
+		{
+			texturePools[pool].push_back((uint32_t)scene.resourceSizes.size());
+			scene.resourceSizes.push_back((unit(random) < 0.7 ? 4ull : 1ull) * 1024 * 1024 * 4 / 3);
+		}
+	}
+
+	const uint32_t objectsCount = 2000;
+	for (uint32_t i = 0; i < objectsCount; i++)
+	{
+		double x = unit(random) * SIMULATED_SCENE_SIZE;
+		double z = unit(random) * SIMULATED_SCENE_SIZE;
+		scene.objectX.push_back(x);
+		scene.objectZ.push_back(z);
+		scene.objectRadius.push_back(0.5 + unit(random) * unit(random) * 8.0);
+
+		uint32_t districtX = std::min((uint32_t)(x / SIMULATED_SCENE_SIZE * SIMULATED_DISTRICTS), SIMULATED_DISTRICTS - 1);
+		uint32_t districtZ = std::min((uint32_t)(z / SIMULATED_SCENE_SIZE * SIMULATED_DISTRICTS), SIMULATED_DISTRICTS - 1);
+		uint32_t district = 1 + districtZ * SIMULATED_DISTRICTS + districtX;
+
+		uint32_t pool = unit(random) < 0.8 ? district : 0;
+		scene.objectResources.push_back(meshPools[pool][random() % meshesPerPool]);
+		scene.objectResources.push_back(texturePools[pool][random() % texturesPerPool]);
+		scene.objectResources.push_back(texturePools[pool][random() % texturesPerPool]);
+	}
+
+	return scene;
+}
+
+// Camera pose of every frame, interpolated between random key poses: a slow walk that keeps looking around,
+// or a fast flight facing where it goes
+static std::vector<SimulatedPose> RecordCameraPath(uint32_t seed, uint32_t framesCount, double keyDistance, uint32_t framesPerKey, bool lookAround)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<double> unit(0, 1);
+	const double pi = 3.14159265358979;
+
+	std::vector<SimulatedPose> keys = { { SIMULATED_SCENE_SIZE * 0.5, SIMULATED_SCENE_SIZE * 0.5, 0 } };
+	while ((uint32_t)keys.size() * framesPerKey <= framesCount)
+	{
+		const SimulatedPose& last = keys.back();
+		double heading = unit(random) * 2 * pi;
+		double x = std::min(std::max(last.x + std::sin(heading) * keyDistance, 0.0), SIMULATED_SCENE_SIZE);
+		double z = std::min(std::max(last.z + std::cos(heading) * keyDistance, 0.0), SIMULATED_SCENE_SIZE);
+		double yaw = lookAround ? unit(random) * 2 * pi : std::atan2(x - last.x, z - last.z);
+		keys.push_back({ x, z, yaw });
+	}
+
+	std::vector<SimulatedPose> path(framesCount);
+	for (uint32_t i = 0; i < framesCount; i++)
+	{
+		const SimulatedPose& key0 = keys[i / framesPerKey];
+		const SimulatedPose& key1 = keys[i / framesPerKey + 1];
+		double t = (double)(i % framesPerKey) / framesPerKey;
+
+		// Shortest way around
+		double turn = std::remainder(key1.yaw - key0.yaw, 2 * pi);
+		path[i] = { key0.x + (key1.x - key0.x) * t, key0.z + (key1.z - key0.z) * t, key0.yaw + turn * t };
+	}
+	return path;
+}
+
+// Run every path on a fresh scheduler with nothing resident, "consistent" is cleared if an invariant breaks:
+// budget is never exceeded, loads of an update go in priority order, and no more loads are in flight than allowed
+static SimulationResult SimulateStreaming(const SimulatedScene& scene, const std::vector<std::vector<SimulatedPose>>& paths, const StreamingScheduler::Settings& settings, bool& consistent)
+{
+	SimulationResult result = {};
+
+	const double halfHorizontalFOV = std::atan(SIMULATED_TAN_HALF_FOV * SIMULATED_ASPECT);
+	const double projectionScale = 1.0 / SIMULATED_TAN_HALF_FOV;
+
+	uint64_t framesCount = 0;
+	uint64_t visibleCount = 0;
+	uint64_t missesCount = 0;
+	double residentBytes = 0;
+
+	for (auto& path : paths)
+	{
+		StreamingScheduler scheduler;
+		scheduler.SetSettings(settings);
+		for (uint64_t size : scene.resourceSizes)
+			scheduler.RegisterResource(size, false);
+
+		std::vector<uint32_t> loaderQueue;
+		uint32_t loaderHead = 0;
+		double loaderProgress = 0;
+
+		for (auto& pose : path)
+		{
+			// Loader works through its queue in order, one frame of time per frame
+			loaderProgress += 1.0;
+			while (loaderHead < (uint32_t)loaderQueue.size())
+			{
+				uint32_t resource = loaderQueue[loaderHead];
+				double cost = SIMULATED_LOADER_LATENCY + scheduler.GetResourceSize(resource) / SIMULATED_LOADER_BYTES_PER_FRAME;
+				if (loaderProgress < cost)
+					break;
+
+				loaderProgress -= cost;
+				scheduler.OnLoaded(resource);
+				result.loadedMB += scheduler.GetResourceSize(resource) / (1024.0 * 1024.0);
+				loaderHead++;
+			}
+			if (loaderHead == (uint32_t)loaderQueue.size())
+				loaderProgress = 0;
+
+			for (uint32_t i = 0; i < (uint32_t)scene.objectX.size(); i++)
+			{
+				double dx = scene.objectX[i] - pose.x;
+				double dz = scene.objectZ[i] - pose.z;
+				double distance = std::sqrt(dx * dx + dz * dz);
+				double radius = scene.objectRadius[i];
+				if (distance > SIMULATED_FAR_PLANE + radius)
+					continue;
+
+				bool visible = true;
+				double coverage = 1.0;
+				if (distance > radius)
+				{
+					double angle = std::abs(std::remainder(std::atan2(dx, dz) - pose.yaw, 2 * 3.14159265358979));
+					visible = angle - std::asin(radius / distance) <= halfHorizontalFOV && distance - radius <= SIMULATED_FAR_PLANE;
+					coverage = std::min(1.0, std::pow(radius * projectionScale / distance, 2));
+				}
+
+				for (uint32_t j = 0; j < SIMULATED_RESOURCES_PER_OBJECT; j++)
+					scheduler.ReportVisibility(scene.objectResources[i * SIMULATED_RESOURCES_PER_OBJECT + j], coverage, distance, visible);
+			}
+
+			scheduler.Update();
+
+			double lastPriority = std::numeric_limits<double>::max();
+			for (auto& request : scheduler.GetRequests())
+			{
+				if (request.type != StreamingScheduler::RequestType_Load)
+					continue;
+
+				consistent &= scheduler.GetPriority(request.resource) <= lastPriority;
+				lastPriority = scheduler.GetPriority(request.resource);
+				loaderQueue.push_back(request.resource);
+			}
+
+			const StreamingScheduler::Statistics& statistics = scheduler.GetLastUpdateStatistics();
+			consistent &= statistics.residentBytes <= settings.budgetBytes;
+			consistent &= statistics.pendingLoadsCount <= settings.maxPendingLoads;
+			consistent &= statistics.pendingLoadsCount == (uint32_t)loaderQueue.size() - loaderHead;
+
+			framesCount++;
+			visibleCount += statistics.visibleCount;
+			missesCount += statistics.missesCount;
+
+			double residentMB = statistics.residentBytes / (1024.0 * 1024.0);
+			residentBytes += residentMB;
+			result.peakResidentMB = std::max(result.peakResidentMB, residentMB);
+		}
+	}
+
+	result.averageResidentMB = residentBytes / framesCount;
+	result.missRatio = visibleCount == 0 ? 0 : (double)missesCount / visibleCount;
+	return result;
+}
+
+bool TestStreamingScheduler()
+{
+	bool passed = true;
+
+	// Loads go most important first, and stop where budget ends
+	{
+		StreamingScheduler scheduler;
+		scheduler.SetSettings({ 20, 4, 0, 0 });
+		for (uint32_t i = 0; i < 3; i++)
+			scheduler.RegisterResource(10, false);
+
+		scheduler.ReportVisibility(2, 0.1, 1, true);
+		scheduler.ReportVisibility(1, 0.3, 1, true);
+		scheduler.ReportVisibility(0, 0.5, 1, true);
+		scheduler.Update();
+
+		auto& requests = scheduler.GetRequests();
+		CHECK(requests.size() == 2 && requests[0].resource == 0 && requests[1].resource == 1);
+		CHECK(requests[0].type == StreamingScheduler::RequestType_Load && requests[1].type == StreamingScheduler::RequestType_Load);
+		CHECK(scheduler.GetLastUpdateStatistics().visibleCount == 3 && scheduler.GetLastUpdateStatistics().missesCount == 3);
+
+		scheduler.OnLoaded(0);
+		scheduler.OnLoaded(1);
+
+		// Nothing wants more, resident data stays
+		scheduler.Update();
+		CHECK(scheduler.GetRequests().size() == 0 && scheduler.IsResident(0) && scheduler.IsResident(1));
+
+		// Room comes out of the least important, evict right before the load it's for
+		scheduler.ReportVisibility(2, 0.9, 1, true);
+		scheduler.ReportVisibility(0, 0.2, 1, true);
+		scheduler.Update();
+		CHECK(requests.size() == 2 && requests[0].resource == 1 && requests[0].type == StreamingScheduler::RequestType_Evict);
+		CHECK(requests[1].resource == 2 && requests[1].type == StreamingScheduler::RequestType_Load);
+		CHECK(scheduler.GetLastUpdateStatistics().residentBytes == 20 && scheduler.GetLastUpdateStatistics().missesCount == 1);
+
+		// Unregistered resource gives its memory back
+		scheduler.OnLoaded(2);
+		scheduler.UnregisterResource(0);
+		scheduler.Update();
+		CHECK(scheduler.GetLastUpdateStatistics().residentBytes == 10 && scheduler.RegisterResource(5, true) == 0);
+	}
+
+	// A load doesn't evict something about as important, and decay keeps what was seen recently
+	{
+		StreamingScheduler scheduler;
+		scheduler.SetSettings({ 10, 4, 0, 0.5 });
+		scheduler.RegisterResource(10, true);
+		scheduler.RegisterResource(10, false);
+
+		scheduler.ReportVisibility(0, 0.5, 1, true);
+		scheduler.ReportVisibility(1, 0.6, 1, true);
+		scheduler.Update();
+		CHECK(scheduler.GetRequests().size() == 0);
+
+		// Out of view, resource 0 keeps half of its coverage
+		scheduler.ReportVisibility(1, 0.6, 1, true);
+		scheduler.Update();
+		CHECK(scheduler.GetRequests().size() == 2 && scheduler.GetRequests()[0].resource == 0 && scheduler.GetRequests()[1].resource == 1);
+		CHECK(std::abs(scheduler.GetPriority(0) - 0.25) < 1e-9);
+	}
+
+	// Offscreen users only count with their weight, loads in flight are capped
+	{
+		StreamingScheduler scheduler;
+		scheduler.SetSettings({ 100, 1, 0.25, 0 });
+		scheduler.RegisterResource(10, false);
+		scheduler.RegisterResource(10, false);
+
+		scheduler.ReportVisibility(0, 0.8, 1, false);
+		scheduler.ReportVisibility(1, 0.3, 1, true);
+		scheduler.Update();
+		CHECK(scheduler.GetRequests().size() == 1 && scheduler.GetRequests()[0].resource == 1);
+		CHECK(std::abs(scheduler.GetPriority(0) - 0.2) < 1e-9 && std::abs(scheduler.GetPriority(1) - 1.3) < 1e-9);
+		CHECK(scheduler.GetLastUpdateStatistics().visibleCount == 1);
+
+		scheduler.Update();
+		CHECK(scheduler.GetRequests().size() == 0);
+	}
+
+	// Simulated paths hold every invariant, with budget tight or not, and replay exactly the same
+	SimulatedScene scene = BuildSimulatedScene();
+	std::vector<std::vector<SimulatedPose>> paths = { RecordCameraPath(5, 600, 15.0, 90, true), RecordCameraPath(6, 600, 60.0, 60, false) };
+
+	uint64_t totalBytes = 0;
+	for (uint64_t size : scene.resourceSizes)
+		totalBytes += size;
+
+	for (double budgetRatio : { 0.1, 0.5, 1.0 })
+	{
+		StreamingScheduler::Settings settings = StreamingScheduler::DEFAULT_SETTINGS;
+		settings.budgetBytes = (uint64_t)(totalBytes * budgetRatio);
+
+		SimulationResult run0 = SimulateStreaming(scene, paths, settings, passed);
+		SimulationResult run1 = SimulateStreaming(scene, paths, settings, passed);
+		CHECK(run0.averageResidentMB == run1.averageResidentMB && run0.missRatio == run1.missRatio && run0.loadedMB == run1.loadedMB);
+		CHECK(run0.peakResidentMB <= settings.budgetBytes / (1024.0 * 1024.0));
+
+		// Everything fits, so nothing is ever read twice
+		if (budgetRatio == 1.0)
+			CHECK(run0.loadedMB <= totalBytes * paths.size() / (1024.0 * 1024.0));
+	}
+
+	return passed;
+}
\ No newline at end of file
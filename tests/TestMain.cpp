@@ -0,0 +1,51 @@
+#include "Tests.h"
+#include <cstring>
+
+typedef struct _Test
+{
+	const char*	name;
+	bool		(*run)();
+}Test;
+
+static const Test TESTS[] =
+{
+	{ "AABBTree", TestAABBTree },
+	{ "CascadedShadowMap", TestCascadedShadowMap },
+#if defined(VULKAN_LEARN_TEST_GPU_CULLER)
+	{ "GPUCuller", TestGPUCuller },
+#endif
+	{ "HiZPyramid", TestHiZPyramid },
+	{ "LightClusterGrid", TestLightClusterGrid },
+	{ "OcclusionBuffer", TestOcclusionBuffer },
+	{ "PerDrawData", TestPerDrawData },
+	{ "PlanetHorizon", TestPlanetHorizon },
+	{ "PlanetSubdivider", TestPlanetSubdivider },
+	{ "RenderGraph", TestRenderGraph },
+	{ "StreamingScheduler", TestStreamingScheduler },
+};
+
+// Runs the test named on command line, or all of them, returns number of failed ones
+int main(int argc, char* argv[])
+{
+	int failedCount = 0;
+	bool found = false;
+	for (const Test& test : TESTS)
+	{
+		if (argc > 1 && strcmp(argv[1], test.name) != 0)
+			continue;
+
+		found = true;
+		bool passed = test.run();
+		std::cout << test.name << (passed ? " passed" : " FAILED") << "\n";
+		if (!passed)
+			failedCount++;
+	}
+
+	if (!found)
+	{
+		std::cout << "No test named " << argv[1] << "\n";
+		return 1;
+	}
+
+	return failedCount;
+}
\ No newline at end of file
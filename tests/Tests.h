@@ -0,0 +1,17 @@
+#pragma once
+#include <iostream>
+
+// Each test returns false if any check fails, a failed check prints where it is and goes on with the rest
+#define CHECK(express) if (!(express)) { std::cout << __FILE__ << "(" << __LINE__ << "): " << #express << " failed\n"; passed = false; }
+
+bool TestAABBTree();
+bool TestCascadedShadowMap();
+bool TestGPUCuller();
+bool TestHiZPyramid();
+bool TestLightClusterGrid();
+bool TestOcclusionBuffer();
+bool TestPerDrawData();
+bool TestPlanetHorizon();
+bool TestPlanetSubdivider();
+bool TestRenderGraph();
+bool TestStreamingScheduler();
\ No newline at end of file
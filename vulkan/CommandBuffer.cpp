@@ -6,6 +6,7 @@
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
 #include "GraphicPipeline.h"
+#include "ComputePipeline.h"
 #include "PipelineLayout.h"
 #include "Buffer.h"
 #include "Image.h"
@@ -17,6 +18,13 @@
 #include "IndirectBuffer.h"
 #include "../common/Enums.h"
 
+// Issue a full barrier for every tracked access, even those found not to need one, to tell a missing barrier from other issues
+bool VALIDATE_BARRIERS = false;
+
+std::atomic<uint32_t> CommandBuffer::m_pipelineBarrierCmdsCount(0);
+std::atomic<uint32_t> CommandBuffer::m_barriersCount(0);
+std::atomic<uint32_t> CommandBuffer::m_elidedBarriersCount(0);
+
 CommandBuffer::~CommandBuffer()
 {
 	vkFreeCommandBuffers(GetDevice()->GetDeviceHandle(), m_pCommandPool->GetDeviceHandle(), 1, &m_commandBuffer);
@@ -111,474 +119,300 @@ void CommandBuffer::PrepareNormalDrawCommands(const DrawCmdData& data)
 	m_drawCmdData = data;
 }
 
-void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+static bool HasWriteAccess(VkAccessFlags access)
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
-
-	// Src barriers
-	for (uint32_t i = 0; i < regions.size(); i++)
-	{
-		VkBufferMemoryBarrier bufferBarrier = {};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcAccessMask = pSrc->GetAccessFlags();
-		bufferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		bufferBarrier.buffer = pSrc->GetDeviceHandle();
-		bufferBarrier.offset = regions[i].srcOffset;
-		bufferBarrier.size = regions[i].size;
-		bufferBarriers.push_back(bufferBarrier);
-	}
-
-	AttachBarriers
-	(
-		pSrc->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		bufferBarriers,
-		{}
-	);
-
-	bufferBarriers.clear();
+	const VkAccessFlags writeAccess = VK_ACCESS_SHADER_WRITE_BIT
+		| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_TRANSFER_WRITE_BIT
+		| VK_ACCESS_HOST_WRITE_BIT
+		| VK_ACCESS_MEMORY_WRITE_BIT;
 
-	// Dst barriers
-	for (uint32_t i = 0; i < regions.size(); i++)
-	{
-		VkBufferMemoryBarrier bufferBarrier = {};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcAccessMask = pDst->GetAccessFlags();
-		bufferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		bufferBarrier.buffer = pDst->GetDeviceHandle();
-		bufferBarrier.offset = regions[i].dstOffset;
-		bufferBarrier.size = regions[i].size;
-		bufferBarriers.push_back(bufferBarrier);
-	}
+	return (access & writeAccess) != 0;
+}
 
-	AttachBarriers
-	(
-		pDst->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		bufferBarriers,
-		{}
-	);
+void CommandBuffer::QueueBarrier(const ResourceState& srcState, const ResourceState& dstState, const VkBufferMemoryBarrier& bufferBarrier)
+{
+	m_pendingSrcStages |= srcState.stages;
+	m_pendingDstStages |= dstState.stages;
+	m_pendingBufferBarriers.push_back(bufferBarrier);
 }
 
-void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+void CommandBuffer::QueueBarrier(const ResourceState& srcState, const ResourceState& dstState, const VkImageMemoryBarrier& imageBarrier)
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	m_pendingSrcStages |= srcState.stages;
+	m_pendingDstStages |= dstState.stages;
+	m_pendingImageBarriers.push_back(imageBarrier);
+}
 
-	// Src barriers
-	for (uint32_t i = 0; i < regions.size(); i++)
+void CommandBuffer::RequireBufferAccess(const std::shared_ptr<BufferBase>& pBuffer, uint32_t offset, uint32_t size, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+	TrackedBuffer& tracked = m_trackedBuffers[pBuffer.get()];
+	if (tracked.pBuffer == nullptr)
 	{
-		VkBufferMemoryBarrier bufferBarrier = {};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		bufferBarrier.dstAccessMask = pSrc->GetAccessFlags();
-		bufferBarrier.buffer = pSrc->GetDeviceHandle();
-		bufferBarrier.offset = regions[i].srcOffset;
-		bufferBarrier.size = regions[i].size;
-		bufferBarriers.push_back(bufferBarrier);
+		tracked.pBuffer = pBuffer;
+		tracked.state = { pBuffer->GetAccessStages(), pBuffer->GetAccessFlags(), VK_IMAGE_LAYOUT_UNDEFINED };
 	}
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pSrc->GetAccessStages(),
-		{},
-		bufferBarriers,
-		{}
-	);
-
-	bufferBarriers.clear();
+	ResourceState& state = tracked.state;
 
-	// Dst barriers
-	for (uint32_t i = 0; i < regions.size(); i++)
+	// Reads never conflict with reads, accesses of the same kind only conflict where their ranges overlap
+	bool conflict = HasWriteAccess(state.access) || HasWriteAccess(access);
+	if (conflict && state.stages == stages && state.access == access)
 	{
-		VkBufferMemoryBarrier bufferBarrier = {};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		bufferBarrier.dstAccessMask = pDst->GetAccessFlags();
-		bufferBarrier.buffer = pDst->GetDeviceHandle();
-		bufferBarrier.offset = regions[i].dstOffset;
-		bufferBarrier.size = regions[i].size;
-		bufferBarriers.push_back(bufferBarrier);
+		conflict = false;
+		for (auto& range : tracked.ranges)
+		{
+			if (offset < range.first + range.second && range.first < offset + size)
+			{
+				conflict = true;
+				break;
+			}
+		}
 	}
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pDst->GetAccessStages(),
-		{},
-		bufferBarriers,
-		{}
-	);
-}
-
-void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions) 
-{
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
-	
-	for (uint32_t i = 0; i < regions.size(); i++)
+	if (!conflict && !VALIDATE_BARRIERS)
 	{
-		VkBufferMemoryBarrier bufferBarrier = {};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcAccessMask = pSrc->GetAccessFlags();
-		bufferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		bufferBarrier.buffer = pSrc->GetDeviceHandle();
-		bufferBarrier.offset = regions[i].bufferOffset;
-
-		if (i < regions.size() - 1)
-			bufferBarrier.size = regions[i + 1].bufferOffset - regions[i].bufferOffset;
-		else
-			bufferBarrier.size = pSrc->GetBufferInfo().size - regions[i].bufferOffset;
-
-		bufferBarriers.push_back(bufferBarrier);
+		state.stages |= stages;
+		state.access |= access;
+		tracked.ranges.push_back({ offset, size });
+		m_elidedBarriersCount++;
+		return;
 	}
 
-	AttachBarriers
-	(
-		pSrc->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		bufferBarriers,
-		{}
-	);
+	ResourceState newState = { stages, access, VK_IMAGE_LAYOUT_UNDEFINED };
 
-	std::vector<VkImageMemoryBarrier> imgBarriers;
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = state.access;
+	bufferBarrier.dstAccessMask = access;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = pBuffer->GetDeviceHandle();
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	QueueBarrier(state, newState, bufferBarrier);
 
-	for (uint32_t i = 0; i < regions.size(); i++)
-	{
-		//Barrier for layout change from undefined to transfer dst
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = regions[i].imageSubresource.aspectMask;
-		subresourceRange.baseMipLevel = regions[i].imageSubresource.mipLevel;
-		subresourceRange.levelCount = 1;
-		subresourceRange.baseArrayLayer = regions[i].imageSubresource.baseArrayLayer;
-		subresourceRange.layerCount = regions[i].imageSubresource.layerCount;
-
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pDst->GetDeviceHandle();
-		imgBarrier.subresourceRange = subresourceRange;
-		imgBarrier.oldLayout = pDst->GetImageInfo().initialLayout;
-		imgBarrier.srcAccessMask = pDst->GetAccessFlags();
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-		imgBarriers.push_back(imgBarrier);
-	}
-
-	AttachBarriers
-	(
-		pDst->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		{},
-		imgBarriers
-	);
+	state = newState;
+	tracked.ranges.clear();
+	tracked.ranges.push_back({ offset, size });
 }
-void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions)
+
+void CommandBuffer::RequireImageAccess(const std::shared_ptr<Image>& pImage, const VkImageSubresourceRange& range, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access)
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	const VkImageCreateInfo& info = pImage->GetImageInfo();
 
-	for (uint32_t i = 0; i < regions.size(); i++)
+	TrackedImage& tracked = m_trackedImages[pImage.get()];
+	if (tracked.pImage == nullptr)
 	{
-		VkBufferMemoryBarrier bufferBarrier = {};
-		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		bufferBarrier.dstAccessMask = pSrc->GetAccessFlags();
-		bufferBarrier.buffer = pSrc->GetDeviceHandle();
-		bufferBarrier.offset = regions[i].bufferOffset;
-
-		if (i < regions.size() - 1)
-			bufferBarrier.size = regions[i + 1].bufferOffset - regions[i].bufferOffset;
-		else
-			bufferBarrier.size = pSrc->GetBufferInfo().size - regions[i].bufferOffset;
-
-		bufferBarriers.push_back(bufferBarrier);
+		tracked.pImage = pImage;
+		tracked.states.assign(info.mipLevels * info.arrayLayers, pImage->GetRestingState());
 	}
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pSrc->GetAccessStages(),
-		{},
-		bufferBarriers,
-		{}
-	);
+	uint32_t levelCount = range.levelCount == VK_REMAINING_MIP_LEVELS ? info.mipLevels - range.baseMipLevel : range.levelCount;
+	uint32_t layerCount = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? info.arrayLayers - range.baseArrayLayer : range.layerCount;
 
-	std::vector<VkImageMemoryBarrier> imgBarriers;
+	ResourceState newState = { stages, access, layout };
 
-	for (uint32_t i = 0; i < regions.size(); i++)
+	for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layerCount; layer++)
 	{
-		//Barrier for layout change from undefined to transfer dst
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = regions[i].imageSubresource.aspectMask;
-		subresourceRange.baseMipLevel = regions[i].imageSubresource.mipLevel;
-		subresourceRange.levelCount = 1;
-		subresourceRange.baseArrayLayer = regions[i].imageSubresource.baseArrayLayer;
-		subresourceRange.layerCount = regions[i].imageSubresource.layerCount;
-
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pDst->GetDeviceHandle();
-		imgBarrier.subresourceRange = subresourceRange;
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		imgBarrier.newLayout = pDst->GetImageInfo().initialLayout;
-		imgBarrier.dstAccessMask = pDst->GetAccessFlags();
-
-		imgBarriers.push_back(imgBarrier);
-	}
+		for (uint32_t mip = range.baseMipLevel; mip < range.baseMipLevel + levelCount; mip++)
+		{
+			ResourceState& state = tracked.states[layer * info.mipLevels + mip];
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pDst->GetAccessStages(),
-		{},
-		{},
-		imgBarriers
-	);
+			// Layout transitions are writes as well
+			if (state.layout == layout && !HasWriteAccess(state.access) && !HasWriteAccess(access) && !VALIDATE_BARRIERS)
+			{
+				state.stages |= stages;
+				state.access |= access;
+				m_elidedBarriersCount++;
+				continue;
+			}
+
+			VkImageMemoryBarrier imgBarrier = {};
+			imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imgBarrier.image = pImage->GetDeviceHandle();
+			imgBarrier.oldLayout = state.layout;
+			imgBarrier.srcAccessMask = state.access;
+			imgBarrier.newLayout = layout;
+			imgBarrier.dstAccessMask = access;
+			imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imgBarrier.subresourceRange = { range.aspectMask, mip, 1, layer, 1 };
+			QueueBarrier(state, newState, imgBarrier);
+
+			state = newState;
+		}
+	}
 }
 
-void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions) 
+void CommandBuffer::RequireImageAccess(const std::shared_ptr<Image>& pImage, const VkImageSubresourceLayers& layers, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access)
 {
-	std::vector<VkImageMemoryBarrier> imgBarriers;
-
-	for (uint32_t i = 0; i < regions.size(); i++)
-	{
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pSrc->GetDeviceHandle();
-		imgBarrier.oldLayout = pSrc->GetImageInfo().initialLayout;
-		imgBarrier.srcAccessMask = pSrc->GetAccessFlags();
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		imgBarrier.subresourceRange =
-		{
-			regions[i].srcSubresource.aspectMask,
-			regions[i].srcSubresource.mipLevel, 1,
-			regions[i].srcSubresource.baseArrayLayer, regions[i].srcSubresource.layerCount
-		};
+	RequireImageAccess(pImage, { layers.aspectMask, layers.mipLevel, 1, layers.baseArrayLayer, layers.layerCount }, layout, stages, access);
+}
 
-		imgBarriers.push_back(imgBarrier);
-	}
+void CommandBuffer::FlushBarriers()
+{
+	if (m_pendingBufferBarriers.size() == 0 && m_pendingImageBarriers.size() == 0)
+		return;
 
-	AttachBarriers
+	vkCmdPipelineBarrier
 	(
-		pSrc->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		{},
-		imgBarriers
+		GetDeviceHandle(),
+		m_pendingSrcStages,
+		m_pendingDstStages,
+		0,
+		0, nullptr,
+		(uint32_t)m_pendingBufferBarriers.size(), m_pendingBufferBarriers.data(),
+		(uint32_t)m_pendingImageBarriers.size(), m_pendingImageBarriers.data()
 	);
 
-	imgBarriers.clear();
+	m_pipelineBarrierCmdsCount++;
+	m_barriersCount += (uint32_t)(m_pendingBufferBarriers.size() + m_pendingImageBarriers.size());
 
-	for (uint32_t i = 0; i < regions.size(); i++)
-	{
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pDst->GetDeviceHandle();
-		imgBarrier.oldLayout = pDst->GetImageInfo().initialLayout;
-		imgBarrier.srcAccessMask = pDst->GetAccessFlags();
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		imgBarrier.subresourceRange =
-		{
-			regions[i].dstSubresource.aspectMask,
-			regions[i].dstSubresource.mipLevel, 1,
-			regions[i].dstSubresource.baseArrayLayer, regions[i].dstSubresource.layerCount
-		};
-
-		imgBarriers.push_back(imgBarrier);
-	}
-
-	AttachBarriers
-	(
-		pDst->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		{},
-		imgBarriers
-	);
+	m_pendingSrcStages = 0;
+	m_pendingDstStages = 0;
+	m_pendingBufferBarriers.clear();
+	m_pendingImageBarriers.clear();
 }
 
-void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions) 
+void CommandBuffer::RestoreResourceStates()
 {
-	std::vector<VkImageMemoryBarrier> imgBarriers;
-
-	for (uint32_t i = 0; i < regions.size(); i++)
+	for (auto& trackedBuffer : m_trackedBuffers)
 	{
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pSrc->GetDeviceHandle();
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		imgBarrier.newLayout = pSrc->GetImageInfo().initialLayout;
-		imgBarrier.dstAccessMask = pSrc->GetAccessFlags();
-		imgBarrier.subresourceRange =
-		{
-			regions[i].srcSubresource.aspectMask,
-			regions[i].srcSubresource.mipLevel, 1,
-			regions[i].srcSubresource.baseArrayLayer, regions[i].srcSubresource.layerCount
-		};
+		const std::shared_ptr<BufferBase>& pBuffer = trackedBuffer.second.pBuffer;
+		ResourceState restingState = { pBuffer->GetAccessStages(), pBuffer->GetAccessFlags(), VK_IMAGE_LAYOUT_UNDEFINED };
+		const ResourceState& state = trackedBuffer.second.state;
 
-		imgBarriers.push_back(imgBarrier);
+		if (state.stages != restingState.stages || state.access != restingState.access)
+		{
+			VkBufferMemoryBarrier bufferBarrier = {};
+			bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			bufferBarrier.srcAccessMask = state.access;
+			bufferBarrier.dstAccessMask = restingState.access;
+			bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.buffer = pBuffer->GetDeviceHandle();
+			bufferBarrier.offset = 0;
+			bufferBarrier.size = VK_WHOLE_SIZE;
+			QueueBarrier(state, restingState, bufferBarrier);
+		}
 	}
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pSrc->GetAccessStages(),
-		{},
-		{},
-		imgBarriers
-	);
+	for (auto& trackedImage : m_trackedImages)
+	{
+		const std::shared_ptr<Image>& pImage = trackedImage.second.pImage;
+		ResourceState restingState = pImage->GetRestingState();
+		const VkImageCreateInfo& info = pImage->GetImageInfo();
 
-	imgBarriers.clear();
+		VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		if (info.format == VK_FORMAT_D24_UNORM_S8_UINT
+			|| info.format == VK_FORMAT_D32_SFLOAT_S8_UINT)
+			aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
 
-	for (uint32_t i = 0; i < regions.size(); i++)
-	{
-		VkImageMemoryBarrier imgBarrier = {};
-		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		imgBarrier.image = pDst->GetDeviceHandle();
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		imgBarrier.newLayout = pDst->GetImageInfo().initialLayout;
-		imgBarrier.dstAccessMask = pDst->GetAccessFlags();
-		imgBarrier.subresourceRange =
-		{
-			regions[i].dstSubresource.aspectMask,
-			regions[i].dstSubresource.mipLevel, 1,
-			regions[i].dstSubresource.baseArrayLayer, regions[i].dstSubresource.layerCount
-		};
+		if (info.format == VK_FORMAT_D32_SFLOAT)
+			aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
 
-		imgBarriers.push_back(imgBarrier);
+		for (uint32_t layer = 0; layer < info.arrayLayers; layer++)
+		{
+			for (uint32_t mip = 0; mip < info.mipLevels; mip++)
+			{
+				const ResourceState& state = trackedImage.second.states[layer * info.mipLevels + mip];
+				if (state.layout == restingState.layout && state.stages == restingState.stages && state.access == restingState.access)
+					continue;
+
+				VkImageMemoryBarrier imgBarrier = {};
+				imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				imgBarrier.image = pImage->GetDeviceHandle();
+				imgBarrier.oldLayout = state.layout;
+				imgBarrier.srcAccessMask = state.access;
+				imgBarrier.newLayout = restingState.layout;
+				imgBarrier.dstAccessMask = restingState.access;
+				imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imgBarrier.subresourceRange = { aspectMask, mip, 1, layer, 1 };
+				QueueBarrier(state, restingState, imgBarrier);
+			}
+		}
 	}
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pDst->GetAccessStages(),
-		{},
-		{},
-		imgBarriers
-	);
+	m_trackedBuffers.clear();
+	m_trackedImages.clear();
+
+	FlushBarriers();
 }
 
-void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageSubresourceLayers& srcLayers, const VkImageSubresourceLayers& dstLayers)
+CommandBuffer::BarrierStatistics CommandBuffer::GetBarrierStatistics()
 {
-	VkImageMemoryBarrier imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pSrc->GetDeviceHandle();
-	imgBarrier.oldLayout = pSrc->GetImageInfo().initialLayout;
-	imgBarrier.srcAccessMask = pSrc->GetAccessFlags();
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	imgBarrier.subresourceRange =
-	{
-		srcLayers.aspectMask,
-		srcLayers.mipLevel, 1,
-		srcLayers.baseArrayLayer, srcLayers.layerCount
-	};
-
-	AttachBarriers
-	(
-		pSrc->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		{},
-		{ imgBarrier }
-	);
-
-	imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pDst->GetDeviceHandle();
-	imgBarrier.oldLayout = pDst->GetImageInfo().initialLayout;
-	imgBarrier.srcAccessMask = pDst->GetAccessFlags();
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	imgBarrier.subresourceRange =
-	{
-		dstLayers.aspectMask,
-		dstLayers.mipLevel, 1,
-		dstLayers.baseArrayLayer, dstLayers.layerCount
-	};
+	return { m_pipelineBarrierCmdsCount, m_barriersCount, m_elidedBarriersCount };
+}
 
-	AttachBarriers
-	(
-		pDst->GetAccessStages(),
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		{},
-		{},
-		{ imgBarrier }
-	);
+void CommandBuffer::ResetBarrierStatistics()
+{
+	m_pipelineBarrierCmdsCount = 0;
+	m_barriersCount = 0;
+	m_elidedBarriersCount = 0;
 }
 
-void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageSubresourceLayers& srcLayers, const VkImageSubresourceLayers& dstLayers, VkPipelineStageFlags extraDstStages)
+void CommandBuffer::CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
 {
-	VkImageMemoryBarrier imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pSrc->GetDeviceHandle();
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	imgBarrier.newLayout = pSrc->GetImageInfo().initialLayout;
-	imgBarrier.dstAccessMask = pSrc->GetAccessFlags();
-	imgBarrier.subresourceRange =
+	for (auto& region : regions)
 	{
-		srcLayers.aspectMask,
-		srcLayers.mipLevel, 1,
-		srcLayers.baseArrayLayer, srcLayers.layerCount
-	};
-
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pSrc->GetAccessStages(),
-		{},
-		{},
-		{ imgBarrier }
-	);
+		RequireBufferAccess(pSrc, (uint32_t)region.srcOffset, (uint32_t)region.size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		RequireBufferAccess(pDst, (uint32_t)region.dstOffset, (uint32_t)region.size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
+	FlushBarriers();
 
-	imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = pDst->GetDeviceHandle();
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	imgBarrier.newLayout = pDst->GetImageInfo().initialLayout;
-	imgBarrier.dstAccessMask = pDst->GetAccessFlags();
-	imgBarrier.subresourceRange =
-	{
-		dstLayers.aspectMask,
-		dstLayers.mipLevel, 1,
-		dstLayers.baseArrayLayer, dstLayers.layerCount
-	};
+	vkCmdCopyBuffer(GetDeviceHandle(), pSrc->GetDeviceHandle(), pDst->GetDeviceHandle(), (uint32_t)regions.size(), regions.data());
 
-	AttachBarriers
-	(
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		pDst->GetAccessStages() | extraDstStages,
-		{},
-		{},
-		{ imgBarrier }
-	);
+	AddToReferenceTable(pSrc);
+	AddToReferenceTable(pDst);
 }
 
-void CommandBuffer::CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+void CommandBuffer::CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::vector<std::shared_ptr<BufferBase>>& dsts, const std::vector<VkBufferCopy>& regions)
 {
-	IssueBarriersBeforeCopy(pSrc, pDst, regions);
+	ASSERTION(dsts.size() == regions.size());
 
-	vkCmdCopyBuffer(GetDeviceHandle(), pSrc->GetDeviceHandle(), pDst->GetDeviceHandle(), (uint32_t)regions.size(), regions.data());
+	uint32_t firstPending = 0;
+	for (uint32_t i = 0; i <= (uint32_t)regions.size(); i++)
+	{
+		bool overlap = false;
+		for (uint32_t j = firstPending; j < i && i < (uint32_t)regions.size(); j++)
+		{
+			if (dsts[j] == dsts[i] && regions[j].dstOffset < regions[i].dstOffset + regions[i].size && regions[i].dstOffset < regions[j].dstOffset + regions[j].size)
+			{
+				overlap = true;
+				break;
+			}
+		}
 
-	IssueBarriersAfterCopy(pSrc, pDst, regions);
+		// Write after write within the batch, copies so far have to go out before this one's barrier
+		if (overlap || i == (uint32_t)regions.size())
+		{
+			FlushBarriers();
+			for (uint32_t j = firstPending; j < i; j++)
+			{
+				vkCmdCopyBuffer(GetDeviceHandle(), pSrc->GetDeviceHandle(), dsts[j]->GetDeviceHandle(), 1, &regions[j]);
+				AddToReferenceTable(dsts[j]);
+			}
+			firstPending = i;
+		}
+
+		if (i == (uint32_t)regions.size())
+			break;
+
+		RequireBufferAccess(pSrc, (uint32_t)regions[i].srcOffset, (uint32_t)regions[i].size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		RequireBufferAccess(dsts[i], (uint32_t)regions[i].dstOffset, (uint32_t)regions[i].size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
 
 	AddToReferenceTable(pSrc);
-	AddToReferenceTable(pDst);
 }
 
 void CommandBuffer::BlitImage(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageBlit& blit)
 {
-	IssueBarriersBeforeCopy(pSrc, pDst, blit.srcSubresource, blit.dstSubresource);
+	RequireImageAccess(pSrc, blit.srcSubresource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	RequireImageAccess(pDst, blit.dstSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	FlushBarriers();
 
 	vkCmdBlitImage
 	(
@@ -589,8 +423,6 @@ void CommandBuffer::BlitImage(const std::shared_ptr<Image>& pSrc, const std::sha
 		VK_FILTER_LINEAR
 	);
 
-	IssueBarriersAfterCopy(pSrc, pDst, blit.srcSubresource, blit.dstSubresource);
-
 	AddToReferenceTable(pSrc);
 	AddToReferenceTable(pDst);
 }
@@ -625,7 +457,12 @@ void CommandBuffer::GenerateMipmaps(const std::shared_ptr<Image>& pImg, uint32_t
 
 void CommandBuffer::CopyImage(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions)
 {
-	IssueBarriersBeforeCopy(pSrc, pDst, regions);
+	for (auto& region : regions)
+	{
+		RequireImageAccess(pSrc, region.srcSubresource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+		RequireImageAccess(pDst, region.dstSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
+	FlushBarriers();
 
 	vkCmdCopyImage
 	(
@@ -635,15 +472,16 @@ void CommandBuffer::CopyImage(const std::shared_ptr<Image>& pSrc, const std::sha
 		(uint32_t)regions.size(), regions.data()
 	);
 
-	IssueBarriersAfterCopy(pSrc, pDst, regions);
-
 	AddToReferenceTable(pSrc);
 	AddToReferenceTable(pDst);
 }
 
 void CommandBuffer::CopyBufferImage(const std::shared_ptr<Buffer>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions)
 {
-	IssueBarriersBeforeCopy(pSrc, pDst, regions);
+	RequireBufferAccess(pSrc, 0, (uint32_t)pSrc->GetBufferInfo().size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	for (auto& region : regions)
+		RequireImageAccess(pDst, region.imageSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	FlushBarriers();
 
 	vkCmdCopyBufferToImage(GetDeviceHandle(),
 		pSrc->GetDeviceHandle(),
@@ -652,8 +490,6 @@ void CommandBuffer::CopyBufferImage(const std::shared_ptr<Buffer>& pSrc, const s
 		(uint32_t)regions.size(),
 		regions.data());
 
-	IssueBarriersAfterCopy(pSrc, pDst, regions);
-
 	AddToReferenceTable(pSrc);
 	AddToReferenceTable(pDst);
 }
@@ -783,6 +619,7 @@ void CommandBuffer::StartPrimaryRecording()
 
 void CommandBuffer::EndPrimaryRecording()
 {
+	RestoreResourceStates();
 	CHECK_VK_ERROR(vkEndCommandBuffer(m_commandBuffer));
 }
 
@@ -825,6 +662,8 @@ void CommandBuffer::AttachBarriers
 	const std::vector<VkImageMemoryBarrier>& imageMemBarriers
 )
 {
+	RestoreResourceStates();
+
 	vkCmdPipelineBarrier
 	(
 		GetDeviceHandle(),
@@ -835,6 +674,9 @@ void CommandBuffer::AttachBarriers
 		(uint32_t)bufferMemBarriers.size(), bufferMemBarriers.data(),
 		(uint32_t)imageMemBarriers.size(), imageMemBarriers.data()
 	);
+
+	m_pipelineBarrierCmdsCount++;
+	m_barriersCount += (uint32_t)(memBarriers.size() + bufferMemBarriers.size() + imageMemBarriers.size());
 }
 
 void CommandBuffer::SetViewports(const std::vector<VkViewport>& viewports)
@@ -847,7 +689,7 @@ void CommandBuffer::SetScissors(const std::vector<VkRect2D>& scissors)
 	vkCmdSetScissor(GetDeviceHandle(), 0, (uint32_t)scissors.size(), scissors.data());
 }
 
-void CommandBuffer::BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets)
+void CommandBuffer::BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets, VkPipelineBindPoint bindPoint)
 {
 	std::vector<VkDescriptorSet> rawDSList;
 	for (uint32_t i = 0; i < (uint32_t)descriptorSets.size(); i++)
@@ -859,7 +701,7 @@ void CommandBuffer::BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pP
 	vkCmdBindDescriptorSets
 	(
 		GetDeviceHandle(),
-		VK_PIPELINE_BIND_POINT_GRAPHICS, pPipelineLayout->GetDeviceHandle(),
+		bindPoint, pPipelineLayout->GetDeviceHandle(),
 		0, (uint32_t)descriptorSets.size(), rawDSList.data(),
 		(uint32_t)offsets.size(), offsets.data()
 	);
@@ -873,6 +715,12 @@ void CommandBuffer::BindPipeline(const std::shared_ptr<GraphicPipeline>& pPipeli
 	AddToReferenceTable(pPipeline);
 }
 
+void CommandBuffer::BindPipeline(const std::shared_ptr<ComputePipeline>& pPipeline)
+{
+	vkCmdBindPipeline(GetDeviceHandle(), VK_PIPELINE_BIND_POINT_COMPUTE, pPipeline->GetDeviceHandle());
+	AddToReferenceTable(pPipeline);
+}
+
 void CommandBuffer::BindVertexBuffer(const std::shared_ptr<BufferBase>& pBuffer, uint32_t offset, uint32_t startSlot)
 {
 	VkBuffer rawBuffer = pBuffer->GetDeviceHandle();
@@ -905,6 +753,11 @@ void CommandBuffer::DrawIndexed(uint32_t count)
 	vkCmdDrawIndexed(GetDeviceHandle(), count, 1, 0, 0, 0);
 }
 
+void CommandBuffer::DrawIndexed(const VkDrawIndexedIndirectCommand& cmd)
+{
+	vkCmdDrawIndexed(GetDeviceHandle(), cmd.indexCount, cmd.instanceCount, cmd.firstIndex, cmd.vertexOffset, cmd.firstInstance);
+}
+
 void CommandBuffer::DrawIndexedIndirect(const std::shared_ptr<BufferBase>& pIndirectBuffer, uint32_t offset, uint32_t count)
 {
 	// NOTE: offset of vkCmdDrawIndexedIndirect is mesured by bytes, not elements!
@@ -930,6 +783,11 @@ void CommandBuffer::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t
 	vkCmdDraw(GetDeviceHandle(), vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void CommandBuffer::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	vkCmdDispatch(GetDeviceHandle(), groupCountX, groupCountY, groupCountZ);
+}
+
 void CommandBuffer::NextSubpass()
 {
 	vkCmdNextSubpass(GetDeviceHandle(), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
@@ -949,6 +807,9 @@ void CommandBuffer::Execute(const std::vector<std::shared_ptr<CommandBuffer>>& c
 
 void CommandBuffer::BeginRenderPass(const std::shared_ptr<FrameBuffer>& pFrameBuffer, const std::shared_ptr<RenderPass>& pRenderPass, const std::vector<VkClearValue>& clearValues, bool includeSecondary)
 {
+	// Render passes expect resources in their resting state
+	RestoreResourceStates();
+
 	VkRenderPassBeginInfo renderPassBeginInfo = {};
 	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassBeginInfo.clearValueCount = (uint32_t)clearValues.size();
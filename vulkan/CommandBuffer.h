@@ -1,9 +1,13 @@
 #pragma once
 
 #include "DeviceObjectBase.h"
+#include "ResourceState.h"
+#include <atomic>
+#include <map>
 
 class CommandPool;
 class GraphicPipeline;
+class ComputePipeline;
 class RenderPass;
 class DescriptorSet;
 class VertexBuffer;
@@ -59,6 +63,14 @@ public:
 		std::vector<BarrierData>					postBarriers;
 	}BufferCopyCmdData;
 
+	// Barriers recorded by all command buffers since last reset
+	typedef struct _BarrierStatistics
+	{
+		uint32_t	pipelineBarrierCmds;	// "vkCmdPipelineBarrier" calls
+		uint32_t	barriers;				// Buffer and image barriers within them
+		uint32_t	elidedBarriers;			// Tracked accesses that needed no barrier
+	}BarrierStatistics;
+
 public:
 	~CommandBuffer();
 
@@ -78,6 +90,8 @@ public:
 	void PrepareBufferCopyCommands(const BufferCopyCmdData& data);
 
 	void CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions);
+	// One region per destination buffer, barriers of all copies go out together unless two of them write same bytes
+	void CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::vector<std::shared_ptr<BufferBase>>& dsts, const std::vector<VkBufferCopy>& regions);
 	void BlitImage(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageBlit& blit);
 	void CopyImage(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions);
 	void CopyBufferImage(const std::shared_ptr<Buffer>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions);
@@ -94,11 +108,26 @@ public:
 		const std::vector<VkImageMemoryBarrier>& imageMemBarriers
 	);
 
+	// Declare how a resource is about to be accessed, a barrier is queued only if it conflicts with the last access recorded
+	// Queued barriers go out together with one "vkCmdPipelineBarrier" at "FlushBarriers"
+	// Each command buffer tracks its own states, starting from resting state, so several of them could record accesses to a resource at the same time
+	void RequireBufferAccess(const std::shared_ptr<BufferBase>& pBuffer, uint32_t offset, uint32_t size, VkPipelineStageFlags stages, VkAccessFlags access);
+	void RequireImageAccess(const std::shared_ptr<Image>& pImage, const VkImageSubresourceRange& range, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access);
+	void FlushBarriers();
+
+	// Bring tracked resources back to their resting state, which render passes, descriptors and hand written barriers expect
+	// Done before render passes, hand written barriers and at the end of recording
+	void RestoreResourceStates();
+
+	static BarrierStatistics GetBarrierStatistics();
+	static void ResetBarrierStatistics();
+
 	void SetViewports(const std::vector<VkViewport>& viewports);
 	void SetScissors(const std::vector<VkRect2D>& scissors);
 
-	void BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets);
+	void BindDescriptorSets(const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS);
 	void BindPipeline(const std::shared_ptr<GraphicPipeline>& pPipeline);
+	void BindPipeline(const std::shared_ptr<ComputePipeline>& pPipeline);
 	void BindVertexBuffer(const std::shared_ptr<BufferBase>& pBuffer, uint32_t offset = 0, uint32_t startSlot = 0);
 	void BindVertexBuffers(const std::vector<std::shared_ptr<BufferBase>>& vertexBuffers, uint32_t startSlot = 0);
 	void BindIndexBuffer(const std::shared_ptr<BufferBase>& pIndexBuffer, VkIndexType type);
@@ -108,10 +137,14 @@ public:
 
 	void DrawIndexed(const std::shared_ptr<IndexBuffer>& pIndexBuffer);
 	void DrawIndexed(uint32_t count);
+	void DrawIndexed(const VkDrawIndexedIndirectCommand& cmd);
 	void DrawIndexedIndirect(const std::shared_ptr<BufferBase>& pIndirectBuffer, uint32_t offset, uint32_t count);
 	void DrawIndexedIndirectCount(const std::shared_ptr<BufferBase>& pIndirectBuffer, uint32_t indirectOffset, const std::shared_ptr<BufferBase>& pIndirectCmdCountBuffer, uint32_t indirectCountOffset);
 	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
 
+	// Outside render pass only
+	void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
 	void NextSubpass();
 
 	void Execute(const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffers);
@@ -123,17 +156,9 @@ protected:
 	bool IsValide() const { m_isValide; }
 	void SetIsValide(bool flag) { m_isValide = flag; }
 
-	void IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions);
-	void IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions);
-
-	void IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions);
-	void IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions);
-
-	void IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions);
-	void IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions);
-
-	void IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageSubresourceLayers& srcLayers, const VkImageSubresourceLayers& dstLayers);
-	void IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageSubresourceLayers& srcLayers, const VkImageSubresourceLayers& dstLayers, VkPipelineStageFlags extraDstStages = 0);
+	void RequireImageAccess(const std::shared_ptr<Image>& pImage, const VkImageSubresourceLayers& layers, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access);
+	void QueueBarrier(const ResourceState& srcState, const ResourceState& dstState, const VkBufferMemoryBarrier& bufferBarrier);
+	void QueueBarrier(const ResourceState& srcState, const ResourceState& dstState, const VkImageMemoryBarrier& imageBarrier);
 
 private:
 	VkCommandBuffer									m_commandBuffer;
@@ -145,5 +170,32 @@ private:
 	DrawCmdData										m_drawCmdData;
 	BufferCopyCmdData								m_bufferCopyCmdData;
 
+	// Barriers queued by tracked accesses, not recorded yet
+	VkPipelineStageFlags							m_pendingSrcStages = 0;
+	VkPipelineStageFlags							m_pendingDstStages = 0;
+	std::vector<VkBufferMemoryBarrier>				m_pendingBufferBarriers;
+	std::vector<VkImageMemoryBarrier>				m_pendingImageBarriers;
+
+	typedef struct _TrackedBuffer
+	{
+		std::shared_ptr<BufferBase>					pBuffer;
+		ResourceState								state;
+		std::vector<std::pair<uint32_t, uint32_t>>	ranges;		// Offset and size of accesses since last barrier
+	}TrackedBuffer;
+
+	typedef struct _TrackedImage
+	{
+		std::shared_ptr<Image>						pImage;
+		std::vector<ResourceState>					states;		// One per subresource indexed by "layer * mipLevels + mip"
+	}TrackedImage;
+
+	// Resources this command buffer accessed since last "RestoreResourceStates"
+	std::map<const BufferBase*, TrackedBuffer>		m_trackedBuffers;
+	std::map<const Image*, TrackedImage>			m_trackedImages;
+
+	static std::atomic<uint32_t>					m_pipelineBarrierCmdsCount;
+	static std::atomic<uint32_t>					m_barriersCount;
+	static std::atomic<uint32_t>					m_elidedBarriersCount;
+
 	friend class CommandPool;
 };
\ No newline at end of file
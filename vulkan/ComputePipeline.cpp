@@ -1,6 +1,8 @@
 #include "ComputePipeline.h"
 #include "PipelineLayout.h"
 #include "ShaderModule.h"
+#include "PipelineCache.h"
+#include "GlobalDeviceObjects.h"
 #include <fstream>
 
 ComputePipeline::~ComputePipeline()
@@ -27,7 +29,7 @@ bool ComputePipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 
 	m_info.stage = m_shaderStageInfo;
 
-	CHECK_VK_ERROR(vkCreateComputePipelines(m_pDevice->GetDeviceHandle(), 0, 1, &m_info, nullptr, &m_pipeline));
+	CHECK_VK_ERROR(vkCreateComputePipelines(m_pDevice->GetDeviceHandle(), GlobalPipelineCache()->GetDeviceHandle(), 1, &m_info, nullptr, &m_pipeline));
 
 	return true;
 }
@@ -0,0 +1,134 @@
+#include "DescriptorAllocator.h"
+#include "DescriptorPool.h"
+#include "DescriptorSetLayout.h"
+#include "DescriptorSet.h"
+#include <algorithm>
+
+bool DescriptorAllocator::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<DescriptorAllocator>& pSelf)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	return true;
+}
+
+std::shared_ptr<DescriptorAllocator> DescriptorAllocator::Create(const std::shared_ptr<Device>& pDevice)
+{
+	std::shared_ptr<DescriptorAllocator> pAllocator = std::make_shared<DescriptorAllocator>();
+	if (pAllocator.get() && pAllocator->Init(pDevice, pAllocator))
+		return pAllocator;
+	return nullptr;
+}
+
+uint64_t DescriptorAllocator::HashBindings(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	// FNV-1a over fields that define a binding
+	uint64_t hash = 14695981039346656037ull;
+	auto hashValue = [&hash](uint64_t value)
+	{
+		for (uint32_t i = 0; i < sizeof(value); i++)
+		{
+			hash ^= (value >> (i * 8)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	for (auto& binding : bindings)
+	{
+		hashValue(binding.binding);
+		hashValue(binding.descriptorType);
+		hashValue(binding.descriptorCount);
+		hashValue(binding.stageFlags);
+		hashValue((uint64_t)binding.pImmutableSamplers);
+	}
+	return hash;
+}
+
+bool DescriptorAllocator::BindingsEqual(const std::vector<VkDescriptorSetLayoutBinding>& bindings0, const std::vector<VkDescriptorSetLayoutBinding>& bindings1)
+{
+	if (bindings0.size() != bindings1.size())
+		return false;
+
+	for (uint32_t i = 0; i < (uint32_t)bindings0.size(); i++)
+	{
+		const VkDescriptorSetLayoutBinding& b0 = bindings0[i];
+		const VkDescriptorSetLayoutBinding& b1 = bindings1[i];
+
+		if (b0.binding != b1.binding || b0.descriptorType != b1.descriptorType || b0.descriptorCount != b1.descriptorCount
+			|| b0.stageFlags != b1.stageFlags || b0.pImmutableSamplers != b1.pImmutableSamplers)
+			return false;
+	}
+	return true;
+}
+
+std::shared_ptr<DescriptorSetLayout> DescriptorAllocator::AcquireDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	m_statistics.layoutRequests++;
+
+	std::vector<std::shared_ptr<DescriptorSetLayout>>& layouts = m_layouts[HashBindings(bindings)];
+	for (auto& pLayout : layouts)
+	{
+		if (BindingsEqual(pLayout->GetDescriptorSetLayoutBinding(), bindings))
+			return pLayout;
+	}
+
+	layouts.push_back(DescriptorSetLayout::Create(GetDevice(), bindings));
+	m_statistics.layoutsCreated++;
+
+	return layouts.back();
+}
+
+void DescriptorAllocator::CreatePool(const std::vector<uint32_t>& minDescriptors)
+{
+	// Every type gets room, pools are few and a missing type would mean a new pool for the first material using it
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	PoolCapacity capacity = { nullptr, POOL_SET_COUNT, std::vector<uint32_t>(VK_DESCRIPTOR_TYPE_RANGE_SIZE) };
+	for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; i++)
+	{
+		capacity.descriptorsLeft[i] = std::max(POOL_DESCRIPTOR_COUNT, minDescriptors[i]);
+		poolSizes.push_back({ (VkDescriptorType)i, capacity.descriptorsLeft[i] });
+	}
+
+	VkDescriptorPoolCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	info.pPoolSizes = poolSizes.data();
+	info.poolSizeCount = (uint32_t)poolSizes.size();
+	info.maxSets = POOL_SET_COUNT;
+
+	capacity.pPool = DescriptorPool::Create(GetDevice(), info);
+	m_pools.push_back(capacity);
+	m_statistics.poolsCreated++;
+}
+
+std::shared_ptr<DescriptorSet> DescriptorAllocator::AllocateDescriptorSet(const std::shared_ptr<DescriptorSetLayout>& pDescriptorSetLayout)
+{
+	std::vector<uint32_t> descriptors(VK_DESCRIPTOR_TYPE_RANGE_SIZE);
+	for (auto& binding : pDescriptorSetLayout->GetDescriptorSetLayoutBinding())
+		descriptors[binding.descriptorType] += binding.descriptorCount;
+
+	// Capacity is tracked here, so that allocation never has to fail to find out a pool is full
+	auto fits = [&descriptors](const PoolCapacity& capacity)
+	{
+		if (capacity.setsLeft == 0)
+			return false;
+
+		for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; i++)
+		{
+			if (capacity.descriptorsLeft[i] < descriptors[i])
+				return false;
+		}
+		return true;
+	};
+
+	if (m_pools.size() == 0 || !fits(m_pools.back()))
+		CreatePool(descriptors);
+
+	PoolCapacity& capacity = m_pools.back();
+	capacity.setsLeft--;
+	for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; i++)
+		capacity.descriptorsLeft[i] -= descriptors[i];
+
+	m_statistics.setsAllocated++;
+
+	return capacity.pPool->AllocateDescriptorSet(pDescriptorSetLayout);
+}
\ No newline at end of file
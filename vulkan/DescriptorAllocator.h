@@ -0,0 +1,56 @@
+#pragma once
+
+#include "DeviceObjectBase.h"
+#include <map>
+
+class DescriptorPool;
+class DescriptorSetLayout;
+class DescriptorSet;
+
+// Device wide source of descriptor set layouts and long lived descriptor sets
+// Layouts are cached by a hash of their bindings, so materials declaring the same bindings share one layout
+// Sets come out of a few large pools rather than one pool sized for each material, a new pool is only added when the last one runs out
+// Not thread safe, layouts and sets are created on main thread
+class DescriptorAllocator : public DeviceObjectBase<DescriptorAllocator>
+{
+	static const uint32_t POOL_SET_COUNT = 64;
+	static const uint32_t POOL_DESCRIPTOR_COUNT = 256;		// Of each descriptor type
+
+public:
+	typedef struct _AllocatorStatistics
+	{
+		uint32_t	layoutRequests;
+		uint32_t	layoutsCreated;
+		uint32_t	setsAllocated;
+		uint32_t	poolsCreated;
+	}AllocatorStatistics;
+
+public:
+	std::shared_ptr<DescriptorSetLayout> AcquireDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+	std::shared_ptr<DescriptorSet> AllocateDescriptorSet(const std::shared_ptr<DescriptorSetLayout>& pDescriptorSetLayout);
+
+	const AllocatorStatistics& GetStatistics() const { return m_statistics; }
+
+public:
+	static std::shared_ptr<DescriptorAllocator> Create(const std::shared_ptr<Device>& pDevice);
+
+protected:
+	typedef struct _PoolCapacity
+	{
+		std::shared_ptr<DescriptorPool>	pPool;
+		uint32_t						setsLeft;
+		std::vector<uint32_t>			descriptorsLeft;	// Indexed by descriptor type
+	}PoolCapacity;
+
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<DescriptorAllocator>& pSelf);
+
+	static uint64_t HashBindings(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+	static bool BindingsEqual(const std::vector<VkDescriptorSetLayoutBinding>& bindings0, const std::vector<VkDescriptorSetLayoutBinding>& bindings1);
+	void CreatePool(const std::vector<uint32_t>& minDescriptors);
+
+protected:
+	// Key: hash of bindings, layouts whose hashes collide are told apart by comparing bindings
+	std::map<uint64_t, std::vector<std::shared_ptr<DescriptorSetLayout>>>	m_layouts;
+	std::vector<PoolCapacity>												m_pools;
+	AllocatorStatistics														m_statistics = {};
+};
\ No newline at end of file
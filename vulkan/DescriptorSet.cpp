@@ -8,6 +8,9 @@
 #include "ImageView.h"
 #include "Sampler.h"
 
+std::atomic<uint32_t> DescriptorSet::m_updateCallsCount(0);
+std::atomic<uint32_t> DescriptorSet::m_descriptorsWrittenCount(0);
+
 DescriptorSet::~DescriptorSet()
 {
 	//Descriptor set will be destroyed when the pool allocates it is destroyed
@@ -46,6 +49,26 @@ std::shared_ptr<DescriptorSet> DescriptorSet::Create(const std::shared_ptr<Devic
 	return nullptr;
 }
 
+void DescriptorSet::WriteDescriptorSets(const std::vector<VkWriteDescriptorSet>& writeData)
+{
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+
+	m_updateCallsCount++;
+	for (auto& write : writeData)
+		m_descriptorsWrittenCount += write.descriptorCount;
+}
+
+DescriptorSet::UpdateStatistics DescriptorSet::GetUpdateStatistics()
+{
+	return { m_updateCallsCount, m_descriptorsWrittenCount };
+}
+
+void DescriptorSet::ResetUpdateStatistics()
+{
+	m_updateCallsCount = 0;
+	m_descriptorsWrittenCount = 0;
+}
+
 void DescriptorSet::UpdateUniformBufferDynamic(uint32_t binding, const std::shared_ptr<UniformBuffer>& pBuffer)
 {
 	std::vector<VkWriteDescriptorSet> writeData = { {} };
@@ -58,7 +81,7 @@ void DescriptorSet::UpdateUniformBufferDynamic(uint32_t binding, const std::shar
 	VkDescriptorBufferInfo info = pBuffer->GetDescBufferInfo();
 	writeData[0].pBufferInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(pBuffer);
 }
@@ -75,7 +98,7 @@ void DescriptorSet::UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<
 	VkDescriptorBufferInfo info = pBuffer->GetDescBufferInfo();
 	writeData[0].pBufferInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(pBuffer);
 }
@@ -95,7 +118,7 @@ void DescriptorSet::UpdateImage(uint32_t binding, const std::shared_ptr<Image>&
 	info.sampler = pSampler->GetDeviceHandle();
 	writeData[0].pImageInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(pImage);
 
@@ -118,7 +141,7 @@ void DescriptorSet::UpdateImage(uint32_t binding, const CombinedImage& image)
 	info.sampler = image.pSampler->GetDeviceHandle();
 	writeData[0].pImageInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(image.pImage);
 
@@ -150,7 +173,7 @@ void DescriptorSet::UpdateImages(uint32_t binding, const std::vector<CombinedIma
 	}
 	writeData[0].pImageInfo = info.data();
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 }
 
 void DescriptorSet::UpdateInputImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<Sampler> pSampler, const std::shared_ptr<ImageView> pImageView)
@@ -169,7 +192,7 @@ void DescriptorSet::UpdateInputImage(uint32_t binding, const std::shared_ptr<Ima
 
 	writeData[0].pImageInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(pImage);
 
@@ -187,7 +210,7 @@ void DescriptorSet::UpdateTexBuffer(uint32_t binding, const VkBufferView& texBuf
 	writeData[0].dstSet = GetDeviceHandle();
 	writeData[0].pTexelBufferView = &texBufferView;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 }
 
 void DescriptorSet::UpdateShaderStorageBufferDynamic(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer)
@@ -202,7 +225,7 @@ void DescriptorSet::UpdateShaderStorageBufferDynamic(uint32_t binding, const std
 	VkDescriptorBufferInfo info = pBuffer->GetDescBufferInfo();
 	writeData[0].pBufferInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(pBuffer);
 }
@@ -219,7 +242,45 @@ void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::share
 	VkDescriptorBufferInfo info = pBuffer->GetDescBufferInfo();
 	writeData[0].pBufferInfo = &info;
 
-	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+	WriteDescriptorSets(writeData);
+
+	m_resourceTable[binding].push_back(pBuffer);
+}
+
+void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<BufferBase>& pBuffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorBufferInfo info = { pBuffer->GetDeviceHandle(), offset, range };
+	writeData[0].pBufferInfo = &info;
+
+	WriteDescriptorSets(writeData);
 
 	m_resourceTable[binding].push_back(pBuffer);
+}
+
+void DescriptorSet::UpdateStorageImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<ImageView> pImageView)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorImageInfo info = {};
+	info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	info.imageView = pImageView->GetDeviceHandle();
+	writeData[0].pImageInfo = &info;
+
+	WriteDescriptorSets(writeData);
+
+	m_resourceTable[binding].push_back(pImage);
+
+	AddToReferenceTable(pImageView);
 }
\ No newline at end of file
@@ -2,11 +2,13 @@
 
 #include "DeviceObjectBase.h"
 #include <map>
+#include <atomic>
 
 class DescriptorPool;
 class DescriptorSetLayout;
 class UniformBuffer;
 class ShaderStorageBuffer;
+class BufferBase;
 class Image;
 class Sampler;
 class ImageView;
@@ -20,6 +22,14 @@ typedef struct _CombinedImage
 
 class DescriptorSet : public DeviceObjectBase<DescriptorSet>
 {
+public:
+	// Descriptor writes done by all sets since last reset
+	typedef struct _UpdateStatistics
+	{
+		uint32_t	updateCalls;		// "vkUpdateDescriptorSets" calls
+		uint32_t	descriptorsWritten;
+	}UpdateStatistics;
+
 public:
 	~DescriptorSet();
 
@@ -37,22 +47,35 @@ public:
 	void UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<UniformBuffer>& pBuffer);
 	void UpdateShaderStorageBufferDynamic(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer);
 	void UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer);
+	// Bind a range of the underlying device buffer as storage buffer, e.g. indirect commands written by a compute shader
+	void UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<BufferBase>& pBuffer, VkDeviceSize offset, VkDeviceSize range);
 	void UpdateImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<Sampler> pSampler, const std::shared_ptr<ImageView> pImageView);
 	void UpdateImage(uint32_t binding, const CombinedImage& image);
 	void UpdateImages(uint32_t binding, const std::vector<CombinedImage>& images);
 	void UpdateInputImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<Sampler> pSampler, const std::shared_ptr<ImageView> pImageView);
+	// Storage image is accessed in general layout, caller transitions image to it before dispatch
+	void UpdateStorageImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<ImageView> pImageView);
 
 	// FIXME: Refactor this when I create texture buffer object class
 	void UpdateTexBuffer(uint32_t binding, const VkBufferView& texBufferView);
 
+	static UpdateStatistics GetUpdateStatistics();
+	static void ResetUpdateStatistics();
+
 public:
 	static std::shared_ptr<DescriptorSet> Create(const std::shared_ptr<Device>& pDevice,
 		const std::shared_ptr<DescriptorPool>& pDescriptorPool,
 		const std::shared_ptr<DescriptorSetLayout>& pDescriptorSetLayout);
 
+protected:
+	void WriteDescriptorSets(const std::vector<VkWriteDescriptorSet>& writeData);
+
 protected:
 	VkDescriptorSet									m_descriptorSet;
 	std::shared_ptr<DescriptorPool>					m_pDescriptorPool;
 	std::shared_ptr<DescriptorSetLayout>			m_pDescriptorSetLayout;
 	std::map<uint32_t, std::vector<std::shared_ptr<Base>>>		m_resourceTable;
+
+	static std::atomic<uint32_t>					m_updateCallsCount;
+	static std::atomic<uint32_t>					m_descriptorsWrittenCount;
 };
\ No newline at end of file
@@ -42,6 +42,8 @@ bool Device::Init(const std::shared_ptr<Instance>& pInst, const std::shared_ptr<
 	enabledFeatures.fullDrawIndexUint32 = 1;
 	enabledFeatures.vertexPipelineStoresAndAtomics = 1;
 	enabledFeatures.fragmentStoresAndAtomics = 1;
+	// Hi-Z pyramid is written as rg32f storage image
+	enabledFeatures.shaderStorageImageExtendedFormats = 1;
 	deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
 
 	RETURN_FALSE_VK_RESULT(vkCreateDevice(m_pPhysicalDevice->GetDeviceHandle(), &deviceCreateInfo, nullptr, &m_device));
@@ -115,6 +115,25 @@ std::shared_ptr<MemoryKey> DeviceMemoryManager::AllocateImageMemChunk(const std:
 	return pMemKey;
 }
 
+std::shared_ptr<MemoryKey> DeviceMemoryManager::AllocateImageMemChunk(uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits)
+{
+	std::shared_ptr<MemoryKey> pMemKey = MemoryKey::Create(GetSelfSharedPtr(), false);
+
+	uint32_t typeIndex;
+	uint32_t offset;
+	AllocateImageMemory(pMemKey->m_key, numBytes, memoryTypeBits, memoryPropertyBits, typeIndex, offset);
+
+	return pMemKey;
+}
+
+void DeviceMemoryManager::BindImageMemChunk(const std::shared_ptr<Image>& pImage, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset)
+{
+	const MemoryNode& node = m_imageMemPool[m_imageMemPoolLookupTable[pMemKey->m_key].first];
+	ASSERTION(offset + pImage->GetMemoryReqirments().size <= node.numBytes);
+
+	pImage->BindMemory(node.memory, offset);
+}
+
 bool DeviceMemoryManager::UpdateBufferMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes)
 {
 	// Early return if it's been freed
@@ -134,6 +153,7 @@ bool DeviceMemoryManager::UpdateBufferMemChunk(const std::shared_ptr<MemoryKey>&
 	uint32_t updateNumBytes = numBytes > bindingInfo.numBytes ? bindingInfo.numBytes : numBytes;
 
 	UpdateMemoryChunk(memoryNode.memory, offset, updateNumBytes, bindingInfo.pData, pData);
+	m_bufferWritesCount++;
 	return true;
 }
 
@@ -58,10 +58,17 @@ public:
 	static std::shared_ptr<DeviceMemoryManager> Create(const std::shared_ptr<Device>& pDevice);
 	std::shared_ptr<MemoryKey> AllocateBufferMemChunk(const std::shared_ptr<Buffer>& pBuffer, uint32_t memoryPropertyBits, const void* pData = nullptr);
 	std::shared_ptr<MemoryKey> AllocateImageMemChunk(const std::shared_ptr<Image>& pImage, uint32_t memoryPropertyBits, const void* pData = nullptr);
+	// Memory not bound to any image yet, images are placed into it with "BindImageMemChunk" and could overlap each other
+	std::shared_ptr<MemoryKey> AllocateImageMemChunk(uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits);
+	void BindImageMemChunk(const std::shared_ptr<Image>& pImage, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset);
 	bool UpdateBufferMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes);
 	bool UpdateImageMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes);
 	void* GetDataPtr(const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset, uint32_t numBytes);
 
+	// Number of writes into host visible buffer memory since last reset, staging copies included as they're written here first
+	uint32_t GetBufferWritesCount() const { return m_bufferWritesCount; }
+	void ResetBufferWritesCount() { m_bufferWritesCount = 0; }
+
 protected:
 	void AllocateBufferMemory(uint32_t key, uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits, uint32_t& typeIndex, uint32_t& offset);
 	bool FindFreeBufferMemoryChunk(uint32_t key, uint32_t typeIndex, uint32_t numBytes, uint32_t& offset);
@@ -88,5 +95,7 @@ protected:
 
 	static const uint32_t						LOOKUP_TABLE_SIZE_INC = 256;
 
+	uint32_t									m_bufferWritesCount = 0;
+
 	friend class MemoryKey;
 };
\ No newline at end of file
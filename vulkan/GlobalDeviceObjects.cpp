@@ -13,6 +13,10 @@
 #include "GlobalVulkanStates.h"
 #include "PhysicalDevice.h"
 #include "PerFrameResource.h"
+#include "PipelineCache.h"
+#include "DescriptorAllocator.h"
+
+static const char* PIPELINE_CACHE_PATH = "../data/pipeline.cache";
 
 bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 {
@@ -43,8 +47,9 @@ bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 		(VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 
 		SHADER_STORAGE_BUFFER_SIZE);
 
+	// Storage usage lets compute shaders write draw commands, see "GPUCuller"
 	m_pIndirectBufferMgr = SharedBufferManager::Create(pDevice, 
-		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
 		(VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 
 		INDIRECT_BUFFER_SIZE);
 
@@ -59,6 +64,9 @@ bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 
 	m_pGlobalVulkanStates = GlobalVulkanStates::Create(pDevice);
 
+	m_pPipelineCache = PipelineCache::Create(pDevice, PIPELINE_CACHE_PATH);
+	m_pDescriptorAllocator = DescriptorAllocator::Create(pDevice);
+
 	for (uint32_t i = 0; i < m_pSwapChain->GetSwapChainImageCount(); i++)
 		m_mainThreadPerFrameRes.push_back(FrameMgr()->AllocatePerFrameResource(i));
 
@@ -113,4 +121,6 @@ std::shared_ptr<SharedBufferManager> IndirectBufferMgr() { return GlobalObjects(
 std::shared_ptr<SharedBufferManager> StreamingBufferMgr() { return GlobalObjects()->GetStreamingBufferMgr(); }
 std::shared_ptr<ThreadTaskQueue> GlobalThreadTaskQueue() { return GlobalObjects()->GetThreadTaskQueue(); }
 std::shared_ptr<GlobalVulkanStates> GetGlobalVulkanStates() { return GlobalObjects()->GetGlobalVulkanStates(); }
+std::shared_ptr<PipelineCache> GlobalPipelineCache() { return GlobalObjects()->GetPipelineCache(); }
+std::shared_ptr<DescriptorAllocator> GlobalDescriptorAllocator() { return GlobalObjects()->GetDescriptorAllocator(); }
 std::shared_ptr<PerFrameResource> MainThreadPerFrameRes() { return GlobalObjects()->GetMainThreadPerFrameRes(); }
\ No newline at end of file
@@ -18,6 +18,8 @@ class ThreadTaskQueue;
 class GlobalVulkanStates;
 class PerFrameResource;
 class RenderPass;
+class PipelineCache;
+class DescriptorAllocator;
 
 class GlobalDeviceObjects;
 
@@ -40,6 +42,8 @@ std::shared_ptr<SharedBufferManager> StreamingBufferMgr();
 std::shared_ptr<ThreadTaskQueue> GlobalThreadTaskQueue();
 std::shared_ptr<GlobalVulkanStates> GetGlobalVulkanStates();
 std::shared_ptr<PerFrameResource> MainThreadPerFrameRes();
+std::shared_ptr<PipelineCache> GlobalPipelineCache();
+std::shared_ptr<DescriptorAllocator> GlobalDescriptorAllocator();
 
 class GlobalDeviceObjects : public Singleton<GlobalDeviceObjects>
 {
@@ -65,6 +69,8 @@ public:
 	const std::shared_ptr<ThreadTaskQueue> GetThreadTaskQueue() const { return m_pThreadTaskQueue; }
 	const std::shared_ptr<GlobalVulkanStates> GetGlobalVulkanStates() const { return m_pGlobalVulkanStates; }
 	const std::shared_ptr<PerFrameResource> GetMainThreadPerFrameRes() const;
+	const std::shared_ptr<PipelineCache> GetPipelineCache() const { return m_pPipelineCache; }
+	const std::shared_ptr<DescriptorAllocator> GetDescriptorAllocator() const { return m_pDescriptorAllocator; }
 
 	//FIXME : remove me
 	bool RequestAttributeBuffer(uint32_t size, uint32_t& offset);
@@ -91,6 +97,9 @@ protected:
 
 	std::shared_ptr<GlobalVulkanStates>		m_pGlobalVulkanStates;
 
+	std::shared_ptr<PipelineCache>			m_pPipelineCache;
+	std::shared_ptr<DescriptorAllocator>	m_pDescriptorAllocator;
+
 	std::shared_ptr<ThreadTaskQueue>		m_pThreadTaskQueue;
 
 	std::vector<std::shared_ptr<PerFrameResource>> m_mainThreadPerFrameRes;
@@ -2,7 +2,15 @@
 #include "PipelineLayout.h"
 #include "RenderPass.h"
 #include "ShaderModule.h"
+#include "PipelineCache.h"
+#include "GlobalDeviceObjects.h"
+#include "FrameManager.h"
+#include "../thread/ThreadTaskQueue.hpp"
 #include <fstream>
+#include <chrono>
+
+bool GraphicPipeline::m_deferCreation = false;
+std::vector<std::shared_ptr<GraphicPipeline>> GraphicPipeline::m_deferredPipelines;
 
 GraphicPipeline::~GraphicPipeline()
 {
@@ -44,6 +52,7 @@ bool GraphicPipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 	m_viewportStateCreateInfo.pScissors = nullptr;
 	m_viewportStateCreateInfo.scissorCount = 1;
 	m_viewportStateCreateInfo.pViewports = nullptr;
+	m_info.pViewportState = &m_viewportStateCreateInfo;
 
 	m_dynamicStates =
 	{
@@ -74,11 +83,43 @@ bool GraphicPipeline::Init(const std::shared_ptr<Device>& pDevice, const std::sh
 	m_vertexInputCreateInfo.pVertexAttributeDescriptions = m_vertexAttributesInfo.data();
 	m_info.pVertexInputState = &m_vertexInputCreateInfo;
 
-	CHECK_VK_ERROR(vkCreateGraphicsPipelines(m_pDevice->GetDeviceHandle(), 0, 1, &m_info, nullptr, &m_pipeline));
+	// Everything "m_info" points to is owned by this object from here, so creation could happen later on another thread
+	if (m_deferCreation)
+		m_deferredPipelines.push_back(pSelf);
+	else
+		CreateDeviceObject();
 
 	return true;
 }
 
+void GraphicPipeline::CreateDeviceObject()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	CHECK_VK_ERROR(vkCreateGraphicsPipelines(m_pDevice->GetDeviceHandle(), GlobalPipelineCache()->GetDeviceHandle(), 1, &m_info, nullptr, &m_pipeline));
+	m_compileTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+double GraphicPipeline::CreateDeferredPipelines()
+{
+	// Pipeline cache is internally synchronized, pipelines could be compiled concurrently
+	for (auto& pPipeline : m_deferredPipelines)
+	{
+		std::shared_ptr<GraphicPipeline> pDeferred = pPipeline;
+		GlobalThreadTaskQueue()->AddJob([pDeferred](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+		{
+			pDeferred->CreateDeviceObject();
+		}, FrameMgr()->FrameIndex());
+	}
+	GlobalThreadTaskQueue()->WaitForFree();
+
+	double compileTime = 0;
+	for (auto& pPipeline : m_deferredPipelines)
+		compileTime += pPipeline->m_compileTime;
+
+	m_deferredPipelines.clear();
+	return compileTime;
+}
+
 std::shared_ptr<GraphicPipeline> GraphicPipeline::Create
 (
 	const std::shared_ptr<Device>& pDevice,
@@ -50,8 +50,14 @@ public:
 		const std::shared_ptr<PipelineLayout>& pPipelineLayout
 	);
 
+	// While deferred, pipelines only keep their create info and get no device handle until "CreateDeferredPipelines"
+	// which compiles all of them on worker threads and waits for them, returns summed compile time of each pipeline in ms
+	static void DeferCreation(bool defer) { m_deferCreation = defer; }
+	static double CreateDeferredPipelines();
+
 private:
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<GraphicPipeline>& pSelf, const VkGraphicsPipelineCreateInfo& info);
+	void CreateDeviceObject();
 
 protected:
 	VkPipeline						m_pipeline;
@@ -75,4 +81,9 @@ protected:
 	std::shared_ptr<RenderPass>							m_pRenderPass;
 	std::shared_ptr<PipelineLayout>						m_pPipelineLayout;
 	std::vector<std::shared_ptr<ShaderModule>>			m_shaders;
+
+	double												m_compileTime = 0;
+
+	static bool											m_deferCreation;
+	static std::vector<std::shared_ptr<GraphicPipeline>>	m_deferredPipelines;
 };
\ No newline at end of file
@@ -50,6 +50,31 @@ bool Image::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<I
 	return true;
 }
 
+bool Image::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const VkImageCreateInfo& info, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	VkImageLayout layout = info.initialLayout;
+	m_info = info;
+	m_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	CHECK_VK_ERROR(vkCreateImage(GetDevice()->GetDeviceHandle(), &m_info, nullptr, &m_image));
+
+	// Every image holds the key, memory goes away with the last of them
+	m_pMemKey = pMemKey;
+	DeviceMemMgr()->BindImageMemChunk(GetSelfSharedPtr(), m_pMemKey, offset);
+
+	m_info.initialLayout = layout;
+	m_memProperty = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	EnsureImageLayout();
+
+	m_bytesPerPixel = VulkanUtil::GetBytesFromFormat(m_info.format);
+
+	return true;
+}
+
 bool Image::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const GliImageWrapper& gliTex, const VkImageCreateInfo& info, uint32_t memoryPropertyFlag)
 {
 	if (!Image::Init(pDevice, pSelf, info, memoryPropertyFlag))
@@ -287,5 +312,24 @@ std::shared_ptr<ImageView> Image::CreateDefaultImageView() const
 	imgViewCreateInfo.subresourceRange.baseMipLevel = 0;
 	imgViewCreateInfo.subresourceRange.levelCount = m_info.mipLevels;
 
+	return ImageView::Create(GetDevice(), imgViewCreateInfo);
+}
+
+std::shared_ptr<ImageView> Image::CreateMipImageView(uint32_t mipLevel) const
+{
+	ASSERTION(mipLevel < m_info.mipLevels);
+
+	VkImageViewCreateInfo imgViewCreateInfo = {};
+	imgViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	imgViewCreateInfo.image = m_image;
+	imgViewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+	imgViewCreateInfo.format = m_info.format;
+	imgViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imgViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imgViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	imgViewCreateInfo.subresourceRange.layerCount = m_info.arrayLayers;
+	imgViewCreateInfo.subresourceRange.baseMipLevel = mipLevel;
+	imgViewCreateInfo.subresourceRange.levelCount = 1;
+
 	return ImageView::Create(GetDevice(), imgViewCreateInfo);
 }
\ No newline at end of file
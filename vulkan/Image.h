@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DeviceObjectBase.h"
+#include "ResourceState.h"
 #include <gli\gli.hpp>
 
 class SwapChain;
@@ -30,11 +31,15 @@ public:
 	VkPipelineStageFlags GetAccessStages() const { return m_accessStages; }
 	VkAccessFlags GetAccessFlags() const { return m_accessFlags; }
 	uint32_t GetBytesPerPixel() const { return m_bytesPerPixel; }
+	// Layout and accesses every subresource is left in outside of command buffer recording
+	ResourceState GetRestingState() const { return { m_accessStages, m_accessFlags, m_info.initialLayout }; }
 
 	void UpdateByteStream(const GliImageWrapper& gliTex);
 	void UpdateByteStream(const GliImageWrapper& gliTex, uint32_t layer);
 
 	virtual std::shared_ptr<ImageView> CreateDefaultImageView() const;
+	// View of a single mip level, e.g. a storage image a compute pass writes level by level
+	virtual std::shared_ptr<ImageView> CreateMipImageView(uint32_t mipLevel) const;
 	virtual std::shared_ptr<Sampler> CreateLinearRepeatSampler() const;
 	virtual std::shared_ptr<Sampler> CreateNearestRepeatSampler() const;
 	virtual std::shared_ptr<Sampler> CreateLinearClampToBorderSampler(VkBorderColor borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE) const;
@@ -47,6 +52,8 @@ protected:
 
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, VkImage img);
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const VkImageCreateInfo& info, uint32_t memoryPropertyFlag);
+	// Image placed at "offset" of memory allocated up front, which it shares with others
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const VkImageCreateInfo& info, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset);
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Image>& pSelf, const GliImageWrapper& gliTex, const VkImageCreateInfo& info, uint32_t memoryPropertyFlag);
 
 	virtual std::shared_ptr<StagingBuffer> PrepareStagingBuffer(const GliImageWrapper& gliTex, const std::shared_ptr<CommandBuffer>& pCmdBuffer) = 0;
@@ -0,0 +1,83 @@
+#include "PipelineCache.h"
+#include "PhysicalDevice.h"
+#include "../common/MappedFile.h"
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+PipelineCache::~PipelineCache()
+{
+	vkDestroyPipelineCache(GetDevice()->GetDeviceHandle(), m_pipelineCache, nullptr);
+}
+
+bool PipelineCache::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PipelineCache>& pSelf, const std::string& path)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	m_path = path;
+
+	VkPipelineCacheCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	// Mapping is only needed during creation, driver copies what it uses
+	std::shared_ptr<MappedFile> pMappedFile = MappedFile::Create(path);
+	if (pMappedFile != nullptr && IsHeaderValid(pMappedFile->GetData(), pMappedFile->GetSize()))
+	{
+		info.initialDataSize = (size_t)pMappedFile->GetSize();
+		info.pInitialData = pMappedFile->GetData();
+		m_loadedBytes = (uint32_t)pMappedFile->GetSize();
+	}
+
+	CHECK_VK_ERROR(vkCreatePipelineCache(pDevice->GetDeviceHandle(), &info, nullptr, &m_pipelineCache));
+
+	return true;
+}
+
+bool PipelineCache::IsHeaderValid(const uint8_t* pData, uint64_t numBytes) const
+{
+	// Header version one: header size, header version, vendor id, device id, cache uuid
+	const uint32_t headerBytes = sizeof(uint32_t) * 4 + VK_UUID_SIZE;
+	if (numBytes < headerBytes)
+		return false;
+
+	uint32_t header[4];
+	memcpy(header, pData, sizeof(header));
+
+	const VkPhysicalDeviceProperties& properties = GetDevice()->GetPhysicalDevice()->GetPhysicalDeviceProperties();
+
+	if (header[0] < headerBytes || header[0] > numBytes)
+		return false;
+
+	if (header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		return false;
+
+	if (header[2] != properties.vendorID || header[3] != properties.deviceID)
+		return false;
+
+	return memcmp(pData + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+uint32_t PipelineCache::Save() const
+{
+	size_t numBytes = 0;
+	CHECK_VK_ERROR(vkGetPipelineCacheData(GetDevice()->GetDeviceHandle(), m_pipelineCache, &numBytes, nullptr));
+
+	std::vector<uint8_t> data(numBytes);
+	CHECK_VK_ERROR(vkGetPipelineCacheData(GetDevice()->GetDeviceHandle(), m_pipelineCache, &numBytes, data.data()));
+
+	std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return 0;
+
+	file.write((const char*)data.data(), numBytes);
+	return file.good() ? (uint32_t)numBytes : 0;
+}
+
+std::shared_ptr<PipelineCache> PipelineCache::Create(const std::shared_ptr<Device>& pDevice, const std::string& path)
+{
+	std::shared_ptr<PipelineCache> pPipelineCache = std::make_shared<PipelineCache>();
+	if (pPipelineCache.get() && pPipelineCache->Init(pDevice, pPipelineCache, path))
+		return pPipelineCache;
+	return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "DeviceObjectBase.h"
+#include <string>
+
+// Pipeline cache persisted to disk, so that pipelines compiled by a previous run are not compiled again
+// Data on disk is only used if its header matches current driver and device, an empty cache is created otherwise
+class PipelineCache : public DeviceObjectBase<PipelineCache>
+{
+public:
+	~PipelineCache();
+
+public:
+	VkPipelineCache GetDeviceHandle() const { return m_pipelineCache; }
+	bool IsLoadedFromDisk() const { return m_loadedBytes != 0; }
+	uint32_t GetLoadedBytes() const { return m_loadedBytes; }
+
+	// Write current cache data back to where it's loaded from, returns bytes written, 0 if failed
+	uint32_t Save() const;
+
+public:
+	static std::shared_ptr<PipelineCache> Create(const std::shared_ptr<Device>& pDevice, const std::string& path);
+
+protected:
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<PipelineCache>& pSelf, const std::string& path);
+	bool IsHeaderValid(const uint8_t* pData, uint64_t numBytes) const;
+
+protected:
+	VkPipelineCache		m_pipelineCache;
+	std::string			m_path;
+	uint32_t			m_loadedBytes = 0;
+};
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "vulkan.h"
+
+// How a resource, or a subresource of it, is accessed by commands recorded so far
+typedef struct _ResourceState
+{
+	VkPipelineStageFlags	stages;
+	VkAccessFlags			access;
+	VkImageLayout			layout;		// Buffers keep it undefined
+}ResourceState;
\ No newline at end of file
@@ -1,30 +1,26 @@
 #include "ShaderModule.h"
-#include <fstream>
+#include "../common/MappedFile.h"
+#include <codecvt>
+#include <locale>
 
 ShaderModule::~ShaderModule()
 {
 	vkDestroyShaderModule(GetDevice()->GetDeviceHandle(), m_shaderModule, nullptr);
 }
 
-bool ShaderModule::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<ShaderModule>& pSelf, const std::wstring& path, ShaderType type, const std::string& entryName)
+bool ShaderModule::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<ShaderModule>& pSelf, const std::wstring& path, const uint32_t* pCode, uint32_t codeBytes, ShaderType type, const std::string& entryName)
 {
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
 
-	std::ifstream ifs;
-	ifs.open(path, std::ios::binary);
-	if (ifs.fail())
-		return false;
-
-	std::vector<char> buffer;
-	buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
-
 	VkShaderModuleCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	info.codeSize = buffer.size();
-	info.pCode = (uint32_t*)buffer.data();
+	info.codeSize = codeBytes;
+	info.pCode = pCode;
 	CHECK_VK_ERROR(vkCreateShaderModule(pDevice->GetDeviceHandle(), &info, nullptr, &m_shaderModule));
 
+	m_shaderPath = path;
+
 	m_shaderType = type;
 
 	switch (m_shaderType)
@@ -44,9 +40,19 @@ bool ShaderModule::Init(const std::shared_ptr<Device>& pDevice, const std::share
 }
 
 std::shared_ptr<ShaderModule> ShaderModule::Create(const std::shared_ptr<Device>& pDevice, const std::wstring& path, ShaderType type, const std::string& entryName)
+{
+	// Mapped pages are page aligned, good enough for SPIR-V words
+	std::shared_ptr<MappedFile> pMappedFile = MappedFile::Create(std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(path));
+	if (pMappedFile == nullptr)
+		return nullptr;
+
+	return Create(pDevice, path, (const uint32_t*)pMappedFile->GetData(), (uint32_t)pMappedFile->GetSize(), type, entryName);
+}
+
+std::shared_ptr<ShaderModule> ShaderModule::Create(const std::shared_ptr<Device>& pDevice, const std::wstring& path, const uint32_t* pCode, uint32_t codeBytes, ShaderType type, const std::string& entryName)
 {
 	std::shared_ptr<ShaderModule> pModule = std::make_shared<ShaderModule>();
-	if (pModule.get() && pModule->Init(pDevice, pModule, path, type, entryName))
+	if (pModule.get() && pModule->Init(pDevice, pModule, path, pCode, codeBytes, type, entryName))
 		return pModule;
 	return nullptr;
 }
\ No newline at end of file
@@ -28,9 +28,11 @@ public:
 
 public:
 	static std::shared_ptr<ShaderModule> Create(const std::shared_ptr<Device>& pDevice, const std::wstring& path, ShaderType type, const std::string& entryName);
+	// SPIR-V already in memory, "path" is only kept for reference
+	static std::shared_ptr<ShaderModule> Create(const std::shared_ptr<Device>& pDevice, const std::wstring& path, const uint32_t* pCode, uint32_t codeBytes, ShaderType type, const std::string& entryName);
 
 protected:
-	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<ShaderModule>& pSelf, const std::wstring& path, ShaderType type, const std::string& entryName);
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<ShaderModule>& pSelf, const std::wstring& path, const uint32_t* pCode, uint32_t codeBytes, ShaderType type, const std::string& entryName);
 
 protected:
 	VkShaderModule			m_shaderModule;
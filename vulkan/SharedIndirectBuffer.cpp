@@ -34,6 +34,14 @@ void SharedIndirectBuffer::SetIndirectCmd(uint32_t index, const VkDrawIndexedInd
 	UpdateByteStream(&cmd, index * sizeof(VkDrawIndexedIndirectCommand), sizeof(VkDrawIndexedIndirectCommand));
 }
 
+void SharedIndirectBuffer::SetIndirectCmds(const VkDrawIndexedIndirectCommand* pCmds, uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	UpdateByteStream(pCmds, 0, count * sizeof(VkDrawIndexedIndirectCommand));
+}
+
 void SharedIndirectBuffer::SetIndirectCmdCount(uint32_t count)
 {
 	UpdateByteStream(&count, 0, sizeof(uint32_t));
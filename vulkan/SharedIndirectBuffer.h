@@ -12,6 +12,7 @@ public:
 
 public:
 	void SetIndirectCmd(uint32_t index, const VkDrawIndexedIndirectCommand& cmd);
+	void SetIndirectCmds(const VkDrawIndexedIndirectCommand* pCmds, uint32_t count);
 	void SetIndirectCmdCount(uint32_t count);
 
 protected:
@@ -30,37 +30,30 @@ void StagingBufferManager::FlushDataMainThread()
 	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadPool()->AllocatePrimaryCommandBuffer();
 
 	pCmdBuffer->StartPrimaryRecording();
-
-	// Copy each chunk to dst buffer
-	std::for_each(m_pendingUpdateBuffer.begin(), m_pendingUpdateBuffer.end(), [&](const PendingBufferInfo& info)
-	{
-		VkBufferCopy copy = {};
-		copy.dstOffset = info.dstOffset;
-		copy.srcOffset = info.srcOffset;
-		copy.size = info.numBytes;
-		pCmdBuffer->CopyBuffer(m_pStagingBufferPool, info.pBuffer, { copy });
-	});
-
+	RecordDataFlush(pCmdBuffer);
 	pCmdBuffer->EndPrimaryRecording();
 
 	GlobalGraphicQueue()->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
-
-	m_pendingUpdateBuffer.clear();
-	m_usedNumBytes = 0;
 }
 
 void StagingBufferManager::RecordDataFlush(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
 {
-	// Copy each chunk to dst buffer
+	// Copy each chunk to dst buffer, all in one batch so that they share barriers
+	std::vector<std::shared_ptr<BufferBase>> dsts;
+	std::vector<VkBufferCopy> copies;
 	std::for_each(m_pendingUpdateBuffer.begin(), m_pendingUpdateBuffer.end(), [&](const PendingBufferInfo& info)
 	{
 		VkBufferCopy copy = {};
 		copy.dstOffset = info.dstOffset;
 		copy.srcOffset = info.srcOffset;
 		copy.size = info.numBytes;
-		pCmdBuffer->CopyBuffer(m_pStagingBufferPool, info.pBuffer, { copy });
+		dsts.push_back(info.pBuffer);
+		copies.push_back(copy);
 	});
 
+	if (copies.size() != 0)
+		pCmdBuffer->CopyBuffer(m_pStagingBufferPool, dsts, copies);
+
 	m_pendingUpdateBuffer.clear();
 	m_usedNumBytes = 0;
 }
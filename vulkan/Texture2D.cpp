@@ -58,6 +58,28 @@ bool Texture2D::Init(const std::shared_ptr<Device>& pDevice, const std::shared_p
 	return true;
 }
 
+bool Texture2D::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageLayout layout, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset)
+{
+	VkImageCreateInfo textureCreateInfo = {};
+	textureCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	textureCreateInfo.format = format;
+	textureCreateInfo.usage = usage;
+	textureCreateInfo.arrayLayers = 1;
+	textureCreateInfo.extent.depth = 1;
+	textureCreateInfo.extent.width = width;
+	textureCreateInfo.extent.height = height;
+	textureCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	textureCreateInfo.initialLayout = layout;
+	textureCreateInfo.mipLevels = 1;
+	textureCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	textureCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	textureCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (!Image::Init(pDevice, pSelf, textureCreateInfo, pMemKey, offset))
+		return false;
+
+	return true;
+}
+
 bool Texture2D::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, uint32_t width, uint32_t height, uint32_t mips, VkFormat format, VkImageUsageFlags usage, VkImageLayout layout)
 {
 	VkImageCreateInfo textureCreateInfo = {};
@@ -156,6 +178,21 @@ std::shared_ptr<Texture2D> Texture2D::CreateOffscreenTexture(const std::shared_p
 	return nullptr;
 }
 
+std::shared_ptr<Texture2D> Texture2D::CreateAliasedOffscreenTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset)
+{
+	std::shared_ptr<Texture2D> pTexture = std::make_shared<Texture2D>();
+
+	if (pTexture.get())
+	{
+		pTexture->m_accessStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		pTexture->m_accessFlags = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	}
+
+	if (pTexture.get() && pTexture->Init(pDevice, pTexture, width, height, format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, pMemKey, offset))
+		return pTexture;
+	return nullptr;
+}
+
 std::shared_ptr<Texture2D> Texture2D::CreateMipmapOffscreenTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format, VkImageLayout layout)
 {
 	std::shared_ptr<Texture2D> pTexture = std::make_shared<Texture2D>();
@@ -173,6 +210,21 @@ std::shared_ptr<Texture2D> Texture2D::CreateMipmapOffscreenTexture(const std::sh
 	return nullptr;
 }
 
+std::shared_ptr<Texture2D> Texture2D::CreateStorageMipmapTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, uint32_t mips, VkFormat format)
+{
+	std::shared_ptr<Texture2D> pTexture = std::make_shared<Texture2D>();
+
+	if (pTexture.get())
+	{
+		pTexture->m_accessStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		pTexture->m_accessFlags = VK_ACCESS_SHADER_READ_BIT;
+	}
+
+	if (pTexture.get() && pTexture->Init(pDevice, pTexture, width, height, mips, format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))
+		return pTexture;
+	return nullptr;
+}
+
 std::shared_ptr<StagingBuffer> Texture2D::PrepareStagingBuffer(const GliImageWrapper& gliTex, const std::shared_ptr<CommandBuffer>& pCmdBuffer)
 {
 	std::shared_ptr<StagingBuffer> pStagingBuffer = StagingBuffer::Create(m_pDevice, (uint32_t)gliTex.textures[0].size());
@@ -13,6 +13,7 @@ protected:
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, const GliImageWrapper& gliTex, uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageLayout layout);
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, const GliImageWrapper& gliTex2d, VkFormat format, VkImageLayout layout);
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageLayout layout);
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageLayout layout, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset);
 	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<Texture2D>& pSelf, uint32_t width, uint32_t height, uint32_t mips, VkFormat format, VkImageUsageFlags usage, VkImageLayout layout);
 
 public:
@@ -21,7 +22,10 @@ public:
 	static std::shared_ptr<Texture2D> CreateEmptyTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format);
 	static std::shared_ptr<Texture2D> CreateOffscreenTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format);
 	static std::shared_ptr<Texture2D> CreateOffscreenTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format, VkImageLayout layout);
+	static std::shared_ptr<Texture2D> CreateAliasedOffscreenTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format, const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset);
 	static std::shared_ptr<Texture2D> Texture2D::CreateMipmapOffscreenTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, VkFormat format, VkImageLayout layout);
+	// Written level by level by compute shaders as storage image, sampled by compute & fragment shaders otherwise
+	static std::shared_ptr<Texture2D> CreateStorageMipmapTexture(const std::shared_ptr<Device>& pDevice, uint32_t width, uint32_t height, uint32_t mips, VkFormat format);
 
 protected:
 	std::shared_ptr<StagingBuffer> PrepareStagingBuffer(const GliImageWrapper& gliTex, const std::shared_ptr<CommandBuffer>& pCmdBuffer) override;
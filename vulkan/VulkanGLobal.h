@@ -41,6 +41,8 @@
 #include "../class/ForwardMaterial.h"
 #include "../class/DeferredMaterial.h"
 #include "../component/DirectionLight.h"
+#include "../component/PointLight.h"
+#include "../component/SpotLight.h"
 #include "../class/ShadowMapMaterial.h"
 #include "../class/SSAOMaterial.h"
 #include "../class/GaussianBlurMaterial.h"
@@ -91,6 +93,9 @@ public:
 	void Draw();
 	void Update();
 
+	// Benchmarks that need device and scene assets, run after setup instead of frame loop
+	void RunBenchmarks();
+
 	void InitShaderModule();
 
 public:
@@ -134,6 +139,9 @@ public:
 	std::shared_ptr<BaseObject>			m_pDirLightObj;
 	std::shared_ptr<DirectionLight>		m_pDirLight;
 
+	std::shared_ptr<BaseObject>			m_pPointLightObj;
+	std::shared_ptr<BaseObject>			m_pSpotLightObj;
+
 	std::shared_ptr<PlanetGenerator>	m_pPlanetGenerator;
 
 	std::shared_ptr<Texture2D>			m_pAlbedoRoughness;
@@ -189,8 +197,8 @@ public:
 	std::shared_ptr<MaterialInstance>	m_pSophiaMaterialInstance;
 	std::shared_ptr<MaterialInstance>   m_pPlanetMaterialInstance;
 
-	std::shared_ptr<MaterialInstance>	m_pShadowMapMaterialInstance;
-	std::shared_ptr<MaterialInstance>	m_pSkinnedShadowMapMaterialInstance;
+	std::vector<std::shared_ptr<MaterialInstance>>	m_shadowMapMaterialInstances;			// One per shadow cascade
+	std::vector<std::shared_ptr<MaterialInstance>>	m_skinnedShadowMapMaterialInstances;
 
 	std::shared_ptr<BaseObject>			m_pSkyBoxObject;
 	std::shared_ptr<MeshRenderer>		m_pSkyBoxMeshRenderer;
@@ -210,6 +218,7 @@ public:
 	std::shared_ptr<BaseObject>			m_pSceneRootObject;
 
 	std::vector<std::shared_ptr<CommandBuffer>> m_commandBufferList;
+	std::vector<uint32_t>						m_commandBufferRenderStateMasks;	// Render state mask each command buffer was recorded with
 
 #if defined(_WIN32)
 	HINSTANCE							m_hPlatformInst;
@@ -40,8 +40,59 @@
 #include "../component/AnimationController.h"
 #include "../class/PerFrameData.h"
 #include "../class/FrameEventManager.h"
+#include "DeviceMemoryManager.h"
+#include "../class/FrustumCuller.h"
+#include "../class/AABBTree.h"
+#include "../class/OcclusionCuller.h"
+#include "../class/ClusteredLighting.h"
+#include "../class/StreamingManager.h"
 
 bool PREBAKE_CB = true;
+bool USE_COOKED_MESH = true;
+bool LOG_LOD_STATISTICS = false;
+bool LOG_BUFFER_WRITES = false;
+bool LOG_CMD_RECORDING = false;
+bool LOG_BARRIERS = false;
+bool LOG_DESCRIPTOR_UPDATES = false;
+bool LOG_CULLING_STATISTICS = false;
+bool LOG_LIGHTING_STATISTICS = false;
+bool LOG_STREAMING_STATISTICS = false;
+
+// Print wall time of each import stage for every scene read at startup
+bool LOG_IMPORT_TIMING = false;
+
+// Print vertex cache efficiency before and after mesh optimization for every mesh read at startup
+bool LOG_MESH_OPTIMIZATION = false;
+
+// A shadow caster draws with one shadow material instance per cascade besides its own
+static std::vector<std::shared_ptr<MaterialInstance>> WithShadowCasting(const std::shared_ptr<MaterialInstance>& pMaterialInstance, const std::vector<std::shared_ptr<MaterialInstance>>& shadowMaterialInstances)
+{
+	std::vector<std::shared_ptr<MaterialInstance>> materialInstances = { pMaterialInstance };
+	materialInstances.insert(materialInstances.end(), shadowMaterialInstances.begin(), shadowMaterialInstances.end());
+	return materialInstances;
+}
+
+static void LogImportTiming(const char* pName, const AssimpSceneReader::SceneInfo& sceneInfo)
+{
+	if (!LOG_IMPORT_TIMING)
+		return;
+
+	std::cout << "Import " << pName << ", read: " << sceneInfo.timing.readTime << "ms, convert: " << sceneInfo.timing.convertTime
+		<< "ms (animation: " << sceneInfo.timing.animationTime << "ms), create: " << sceneInfo.timing.createTime
+		<< "ms, link: " << sceneInfo.timing.linkTime << "ms, total: " << sceneInfo.timing.totalTime << "ms\n";
+}
+
+static void LogMeshOptimization(const char* pName, const AssimpSceneReader::SceneInfo& sceneInfo)
+{
+	if (!LOG_MESH_OPTIMIZATION)
+		return;
+
+	for (auto& report : sceneInfo.optimizeReports)
+	{
+		std::cout << "Mesh of " << pName << ", triangles: " << report.trianglesCount << ", vertices: " << report.verticesCountBefore << " -> " << report.verticesCountAfter
+			<< ", ACMR: " << report.acmrBefore << " -> " << report.acmrAfter << ", ATVR: " << report.atvrBefore << " -> " << report.atvrAfter << "\n";
+	}
+}
 
 void VulkanGlobal::InitVulkanInstance()
 {
@@ -645,8 +696,11 @@ void VulkanGlobal::InitMaterials()
 
 	m_pSkyBoxMaterialInstance = RenderWorkManager::GetInstance()->AcquireSkyBoxMaterialInstance();
 
-	m_pShadowMapMaterialInstance = RenderWorkManager::GetInstance()->AcquireShadowMaterialInstance();
-	m_pSkinnedShadowMapMaterialInstance = RenderWorkManager::GetInstance()->AcquireSkinnedShadowMaterialInstance();
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		m_shadowMapMaterialInstances.push_back(RenderWorkManager::GetInstance()->AcquireShadowMaterialInstance(i));
+		m_skinnedShadowMapMaterialInstances.push_back(RenderWorkManager::GetInstance()->AcquireSkinnedShadowMaterialInstance(i));
+	}
 }
 
 void VulkanGlobal::AddBoneBox(const std::shared_ptr<BaseObject>& pObject)
@@ -686,6 +740,7 @@ void VulkanGlobal::InitScene()
 	UniformData::GetInstance()->GetGlobalUniforms()->SetSSRTThickness(0.05);
 	UniformData::GetInstance()->GetGlobalUniforms()->SetSSRTBorderFadingDist(0.05);
 	UniformData::GetInstance()->GetGlobalUniforms()->SetSSRTStepCountFadingDist(0.1);
+	UniformData::GetInstance()->GetGlobalUniforms()->SetSSRTHiZMaxLevel(UniformData::GetInstance()->GetGBufferInputUniforms()->IsHiZPyramidEnabled() ? 4.0 : 0.0);
 
 	uint32_t smaller = FrameBufferDiction::WINDOW_HEIGHT < FrameBufferDiction::WINDOW_WIDTH ? FrameBufferDiction::WINDOW_HEIGHT : FrameBufferDiction::WINDOW_WIDTH;
 	UniformData::GetInstance()->GetGlobalUniforms()->SetScreenSizeMipLevel(log2(smaller) + 1);
@@ -756,6 +811,16 @@ void VulkanGlobal::InitScene()
 	m_pDirLight = DirectionLight::Create({ 4.0f, 4.0f, 4.0f });
 	m_pDirLightObj->AddComponent(m_pDirLight);
 
+	m_pPointLightObj = BaseObject::Create();
+	m_pPointLightObj->SetPos(0.7f, 0.25f, 0.3f);
+	m_pPointLightObj->AddComponent(PointLight::Create({ 3.0f, 1.8f, 0.9f }, 1.5));
+
+	// Spot light shines along -z of its object, this one points down at the boxes
+	m_pSpotLightObj = BaseObject::Create();
+	m_pSpotLightObj->SetPos(-0.3f, 1.2f, 0.5f);
+	m_pSpotLightObj->SetRotation(Matrix3d::EulerAngle(-1.57f, 0, 0));
+	m_pSpotLightObj->AddComponent(SpotLight::Create({ 0.6f, 1.2f, 3.0f }, 3.0, 0.3, 0.5));
+
 	m_pSphere1 = BaseObject::Create();
 	m_pSphere2 = BaseObject::Create();
 
@@ -764,44 +829,59 @@ void VulkanGlobal::InitScene()
 	m_pBoxObject1 = BaseObject::Create();
 	m_pBoxObject2 = BaseObject::Create();
 
-	m_pQuadRenderer = MeshRenderer::Create(m_pQuadMesh, { m_pQuadMaterialInstance, m_pShadowMapMaterialInstance });
-	m_pBoxRenderer0 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance0, m_pShadowMapMaterialInstance });
-	m_pBoxRenderer1 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance1, m_pShadowMapMaterialInstance });
-	m_pBoxRenderer2 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance2, m_pShadowMapMaterialInstance });
+	m_pQuadRenderer = MeshRenderer::Create(m_pQuadMesh, WithShadowCasting(m_pQuadMaterialInstance, m_shadowMapMaterialInstances));
+	m_pBoxRenderer0 = MeshRenderer::Create(m_pPBRBoxMesh, WithShadowCasting(m_pBoxMaterialInstance0, m_shadowMapMaterialInstances));
+	m_pBoxRenderer1 = MeshRenderer::Create(m_pPBRBoxMesh, WithShadowCasting(m_pBoxMaterialInstance1, m_shadowMapMaterialInstances));
+	m_pBoxRenderer2 = MeshRenderer::Create(m_pPBRBoxMesh, WithShadowCasting(m_pBoxMaterialInstance2, m_shadowMapMaterialInstances));
+
+	// Boxes are solid, they occlude exactly what they draw
+	std::shared_ptr<OcclusionBuffer::Occluder> pBoxOccluder = SceneGenerator::GenerateBoxOccluder();
+	m_pBoxRenderer0->SetOccluder(pBoxOccluder);
+	m_pBoxRenderer1->SetOccluder(pBoxOccluder);
+	m_pBoxRenderer2->SetOccluder(pBoxOccluder);
 
 	m_pPlanetGenerator = PlanetGenerator::Create(m_pCameraComp, 6378000);
 
 	AssimpSceneReader::SceneInfo sceneInfo;
 
-	m_pGunObject = AssimpSceneReader::ReadAndAssemblyScene("../data/textures/cerberus/cerberus.fbx", { VertexFormatPNTCT }, sceneInfo);
+	// Static meshes are read from cooked files, animated ones still go through assimp
+	auto readStaticScene = USE_COOKED_MESH ? &AssimpSceneReader::ReadAndAssemblyCookedScene : &AssimpSceneReader::ReadAndAssemblyScene;
+
+	m_pGunObject = readStaticScene("../data/textures/cerberus/cerberus.fbx", { VertexFormatPNTCT }, sceneInfo);
+	LogImportTiming("cerberus.fbx", sceneInfo);
+	LogMeshOptimization("cerberus.fbx", sceneInfo);
 	m_pGunMesh = sceneInfo.meshLinks[0].first;
-	m_pGunMeshRenderer = MeshRenderer::Create(m_pGunMesh, { m_pGunMaterialInstance, m_pShadowMapMaterialInstance });
+	m_pGunMeshRenderer = MeshRenderer::Create(m_pGunMesh, WithShadowCasting(m_pGunMaterialInstance, m_shadowMapMaterialInstances));
 	sceneInfo.meshLinks[0].second->AddComponent(m_pGunMeshRenderer);
 	sceneInfo.meshLinks.clear();
 	m_pGunObject->SetPos({ -0.8f, -0.08f, 0 });
 	m_pGunObject->SetScale(0.01f);
 
-	m_pSphere0 = AssimpSceneReader::ReadAndAssemblyScene("../data/models/sphere.obj", { VertexFormatPNTCT }, sceneInfo);
-	m_pSphereRenderer0 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, { m_pSphereMaterialInstance0, m_pShadowMapMaterialInstance });
+	m_pSphere0 = readStaticScene("../data/models/sphere.obj", { VertexFormatPNTCT }, sceneInfo);
+	LogImportTiming("sphere.obj", sceneInfo);
+	LogMeshOptimization("sphere.obj", sceneInfo);
+	m_pSphereRenderer0 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, WithShadowCasting(m_pSphereMaterialInstance0, m_shadowMapMaterialInstances));
 	sceneInfo.meshLinks[0].second->AddComponent(m_pSphereRenderer0);
 	m_pSphere0->SetPos(0.4f, -0.15f, 0);
 	m_pSphere0->SetScale(0.01f);
 
-	m_pSphereRenderer1 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, { m_pSphereMaterialInstance1, m_pShadowMapMaterialInstance });
+	m_pSphereRenderer1 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, WithShadowCasting(m_pSphereMaterialInstance1, m_shadowMapMaterialInstances));
 	m_pSphere1->AddComponent(m_pSphereRenderer1);
 	m_pSphere1->SetPos(1, -0.15f, 0);
 	m_pSphere1->SetScale(0.01f);
 
-	m_pSphereRenderer2 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, { m_pSphereMaterialInstance2, m_pShadowMapMaterialInstance });
+	m_pSphereRenderer2 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, WithShadowCasting(m_pSphereMaterialInstance2, m_shadowMapMaterialInstances));
 	m_pSphere2->AddComponent(m_pSphereRenderer2);
 	m_pSphere2->SetPos(1, -0.15f, 0.6f);
 	m_pSphere2->SetScale(0.01f);
 	sceneInfo.meshLinks.clear();
 
-	m_pInnerBall = AssimpSceneReader::ReadAndAssemblyScene("../data/models/Sample.FBX", { VertexFormatPNTCT }, sceneInfo);
+	m_pInnerBall = readStaticScene("../data/models/Sample.FBX", { VertexFormatPNTCT }, sceneInfo);
+	LogImportTiming("Sample.FBX", sceneInfo);
+	LogMeshOptimization("Sample.FBX", sceneInfo);
 	for (uint32_t i = 0; i < sceneInfo.meshLinks.size(); i++)
 	{
-		m_innerBallRenderers.push_back(MeshRenderer::Create(sceneInfo.meshLinks[i].first, { m_innerBallMaterialInstances[i], m_pShadowMapMaterialInstance }));
+		m_innerBallRenderers.push_back(MeshRenderer::Create(sceneInfo.meshLinks[i].first, WithShadowCasting(m_innerBallMaterialInstances[i], m_shadowMapMaterialInstances)));
 		sceneInfo.meshLinks[i].second->AddComponent(m_innerBallRenderers[i]);
 	}
 	m_pInnerBall->SetPos(-1.3f, -0.4f, 0);
@@ -830,13 +910,16 @@ void VulkanGlobal::InitScene()
 
 	m_pSkyBoxObject = BaseObject::Create();
 	m_pSkyBoxMeshRenderer = MeshRenderer::Create(m_pCubeMesh, { m_pSkyBoxMaterialInstance });
+	m_pSkyBoxMeshRenderer->SetFrustumCullingEnabled(false);
 	m_pSkyBoxObject->AddComponent(m_pSkyBoxMeshRenderer);
 
-	m_pSophiaObject = AssimpSceneReader::ReadAndAssemblyScene("../data/models/rp_sophia_animated_003_idling.FBX", { VertexFormatPNTCTB }, sceneInfo);
+	m_pSophiaObject = AssimpSceneReader::ReadAndAssemblyScene("../data/models/rp_sophia_animated_003_idling.FBX", { m_pSophiaMaterialInstance->GetMaterial()->GetVertexFormatInMem() }, sceneInfo);
+	LogImportTiming("rp_sophia_animated_003_idling.FBX", sceneInfo);
+	LogMeshOptimization("rp_sophia_animated_003_idling.FBX", sceneInfo);
 	m_pSophiaMesh = sceneInfo.meshLinks[0].first;
 
 	std::shared_ptr<AnimationController> pAnimationController = m_pSophiaObject->GetComponent<AnimationController>();
-	m_pSophiaRenderer = MeshRenderer::Create(m_pSophiaMesh, { m_pSophiaMaterialInstance, m_pSkinnedShadowMapMaterialInstance });
+	m_pSophiaRenderer = MeshRenderer::Create(m_pSophiaMesh, WithShadowCasting(m_pSophiaMaterialInstance, m_skinnedShadowMapMaterialInstances));
 	pAnimationController->SetMeshRenderer(m_pSophiaRenderer);
 	sceneInfo.meshLinks[0].second->AddComponent(m_pSophiaRenderer);
 	m_pSophiaRenderer->SetName(L"hehe");
@@ -867,9 +950,12 @@ void VulkanGlobal::InitScene()
 	m_pSceneRootObject->AddChild(m_pSophiaObject);
 	m_pSceneRootObject->AddChild(m_pSkyBoxObject);
 	m_pSceneRootObject->AddChild(m_pDirLightObj);
+	m_pSceneRootObject->AddChild(m_pPointLightObj);
+	m_pSceneRootObject->AddChild(m_pSpotLightObj);
 	m_pSceneRootObject->SetPosY(m_pPlanetGenerator->GetPlanetRadius() + 0.5);
 
 	m_pRootObject = BaseObject::Create();
+	m_pRootObject->SetSpatialIndex(std::make_shared<AABBTree>());
 	m_pRootObject->AddChild(m_pSceneRootObject);
 	m_pRootObject->AddChild(m_pPlanetObject);
 }
@@ -910,6 +996,7 @@ void VulkanGlobal::EndSetup()
 {
 	GlobalDeviceObjects::GetInstance()->GetStagingBufferMgr()->FlushDataMainThread();
 	m_commandBufferList.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+	m_commandBufferRenderStateMasks.resize(m_commandBufferList.size(), 0);
 
 	m_pRootObject->Awake();
 	m_pRootObject->Start();
@@ -918,6 +1005,14 @@ void VulkanGlobal::EndSetup()
 	InputHub::GetInstance()->Register(c);
 }
 
+void VulkanGlobal::RunBenchmarks()
+{
+	AssimpSceneReader::LoadBenchmark benchmark = AssimpSceneReader::BenchmarkLoad("../data/textures/cerberus/cerberus.fbx", { VertexFormatPNTCT });
+	std::cout << "Mesh load time, assimp: " << benchmark.assimpLoadTime << "ms, cooked: " << benchmark.cookedLoadTime << "ms\n";
+
+	FrameMgr()->WaitForAllJobsDone();
+}
+
 void VulkanGlobal::Draw()
 {
 	static uint32_t pingpong = 0;
@@ -941,7 +1036,8 @@ void VulkanGlobal::Draw()
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetHaltonIndexX32Jitter(HaltonSequence::GetHaltonJitter(HaltonSequence::x32, frameCount));
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetHaltonIndexX256Jitter(HaltonSequence::GetHaltonJitter(HaltonSequence::x256, frameCount));
 
-	RenderWorkManager::GetInstance()->SetRenderStateMask((1 << RenderWorkManager::Scene) | (1 << RenderWorkManager::ShadowMapGen));
+	// Shadow cascades to be rendered this frame are added by direction light
+	RenderWorkManager::GetInstance()->SetRenderStateMask(RenderWorkManager::Scene);
 
 	m_pCameraComp->SetFocalLength((1.0f - c->var) * 0.035f + c->var * 0.2f);
 	m_pPlanetGenerator->ToggleCameraInfoUpdate(c->boolVar);
@@ -953,11 +1049,23 @@ void VulkanGlobal::Draw()
 	m_pRootObject->OnPreRender();
 	m_pRootObject->OnRenderObject();
 
+	// Lights are all submitted by now, their cluster lists go out with the rest of uniform data
+	ClusteredLighting::GetInstance()->Flush();
+
 	// Sync data for current frame before rendering
+	DeviceMemMgr()->ResetBufferWritesCount();
+	CommandBuffer::ResetBarrierStatistics();
+	DescriptorSet::ResetUpdateStatistics();
 	UniformData::GetInstance()->SyncDataBuffer();
 	RenderWorkManager::GetInstance()->SyncMaterialData();
 	PerFrameData::GetInstance()->SyncDataBuffer();
 
+	// Culling is done by now, so is visibility of everything streamed
+	StreamingManager::GetInstance()->Update();
+
+	if (LOG_BUFFER_WRITES && frameCount % 120 == 0)
+		std::cout << "Buffer writes during frame data sync: " << DeviceMemMgr()->GetBufferWritesCount() << "\n";
+
 	RenderWorkManager::GetInstance()->OnFrameBegin();
 
 	static bool newCBCreated = false;
@@ -966,7 +1074,8 @@ void VulkanGlobal::Draw()
 		m_commandBufferList[cbIndex] = m_perFrameRes[FrameMgr()->FrameIndex()]->AllocateTransientPrimaryCommandBuffer();
 		newCBCreated = true;
 	}
-	else if (m_commandBufferList[cbIndex] == nullptr)
+	// A prebaked command buffer holds the passes of render states it was recorded with, cached shadow cascades come and go
+	else if (m_commandBufferList[cbIndex] == nullptr || m_commandBufferRenderStateMasks[cbIndex] != RenderWorkManager::GetInstance()->GetRenderStateMask())
 	{
 		m_commandBufferList[cbIndex] = m_perFrameRes[FrameMgr()->FrameIndex()]->AllocatePersistantPrimaryCommandBuffer();
 		newCBCreated = true;
@@ -974,12 +1083,19 @@ void VulkanGlobal::Draw()
 
 	if (newCBCreated)
 	{
+		m_commandBufferRenderStateMasks[cbIndex] = RenderWorkManager::GetInstance()->GetRenderStateMask();
 		m_commandBufferList[cbIndex]->StartPrimaryRecording();
 
 		RenderWorkManager::GetInstance()->Draw(m_commandBufferList[cbIndex], pingpong);
 
 		m_commandBufferList[cbIndex]->EndPrimaryRecording();
 
+		if (LOG_CMD_RECORDING && frameCount % 120 == 0)
+		{
+			const RenderWorkManager::RecordingStatistics& recordingStatistics = RenderWorkManager::GetInstance()->GetRecordingStatistics();
+			std::cout << "Secondary command buffers: " << recordingStatistics.secondaryCmdCount << ", recording time: " << recordingStatistics.recordingTime << "ms, wall time: " << recordingStatistics.wallTime << "ms\n";
+		}
+
 		newCBCreated = false;
 	}
 
@@ -987,6 +1103,59 @@ void VulkanGlobal::Draw()
 
 	RenderWorkManager::GetInstance()->OnFrameEnd();
 
+	if (LOG_LOD_STATISTICS && frameCount % 120 == 0)
+	{
+		const RenderWorkManager::LodStatistics& lodStatistics = RenderWorkManager::GetInstance()->GetLodStatistics();
+		std::cout << "Triangles submitted, full detail: " << lodStatistics.trianglesBeforeLod << ", with LOD: " << lodStatistics.trianglesAfterLod << "\n";
+	}
+
+	if (LOG_CULLING_STATISTICS && frameCount % 120 == 0)
+	{
+		std::cout << "Renderers visible to camera: " << FrustumCuller::GetInstance()->GetLastFlushVisibleCount(RenderWorkManager::Scene) << ", outside frustum: " << FrustumCuller::GetInstance()->GetLastFlushCulledCount(RenderWorkManager::Scene)
+			<< "\n";
+
+		for (uint32_t i = 0; i < m_pDirLight->GetCascadeCount(); i++)
+		{
+			if ((m_pDirLight->GetRenderedCascadeMask() & (1 << i)) == 0)
+				std::cout << "Shadow cascade " << i << ": cached\n";
+			else
+				std::cout << "Shadow cascade " << i << ": visible " << FrustumCuller::GetInstance()->GetLastFlushVisibleCount(RenderWorkManager::ShadowMapGen + i)
+					<< ", outside frustum: " << FrustumCuller::GetInstance()->GetLastFlushCulledCount(RenderWorkManager::ShadowMapGen + i) << "\n";
+		}
+
+		const OcclusionCuller::Statistics& occlusionStatistics = OcclusionCuller::GetInstance()->GetLastCullStatistics();
+		double occludedPercentage = occlusionStatistics.testedCount == 0 ? 0 : occlusionStatistics.occludedCount * 100.0 / occlusionStatistics.testedCount;
+		std::cout << "Occluded: " << occlusionStatistics.occludedCount << " of " << occlusionStatistics.testedCount << " (" << occludedPercentage << "%), occluder triangles: " << occlusionStatistics.occluderTrianglesCount
+			<< ", raster: " << occlusionStatistics.rasterTime << "ms, test: " << occlusionStatistics.testTime << "ms\n";
+	}
+
+	if (LOG_LIGHTING_STATISTICS && frameCount % 120 == 0)
+	{
+		const ClusteredLighting::Statistics& lightingStatistics = ClusteredLighting::GetInstance()->GetLastFlushStatistics();
+		std::cout << "Clustered lights: " << lightingStatistics.visibleCount << " of " << lightingStatistics.submittedCount << " visible, light indices: " << lightingStatistics.lightIndicesCount
+			<< ", dropped: " << lightingStatistics.droppedIndicesCount << ", assign: " << lightingStatistics.assignTime << "ms\n";
+	}
+
+	if (LOG_STREAMING_STATISTICS && frameCount % 120 == 0)
+	{
+		const StreamingScheduler::Statistics& streamingStatistics = StreamingManager::GetInstance()->GetLastUpdateStatistics();
+		std::cout << "Streaming: " << streamingStatistics.residentBytes / (1024.0 * 1024.0) << "MB in " << streamingStatistics.residentCount << " resident resources, visible: " << streamingStatistics.visibleCount
+			<< ", misses: " << streamingStatistics.missesCount << ", pending loads: " << streamingStatistics.pendingLoadsCount << "\n";
+	}
+
+	if (LOG_BARRIERS && frameCount % 120 == 0)
+	{
+		CommandBuffer::BarrierStatistics barrierStatistics = CommandBuffer::GetBarrierStatistics();
+		std::cout << "Pipeline barrier commands: " << barrierStatistics.pipelineBarrierCmds << ", barriers: " << barrierStatistics.barriers << ", accesses without barrier: " << barrierStatistics.elidedBarriers << "\n";
+	}
+
+	// Descriptor sets are written once at setup, anything reported here is written while rendering
+	if (LOG_DESCRIPTOR_UPDATES && frameCount % 120 == 0)
+	{
+		DescriptorSet::UpdateStatistics updateStatistics = DescriptorSet::GetUpdateStatistics();
+		std::cout << "Descriptor updates: " << updateStatistics.updateCalls << ", descriptors written: " << updateStatistics.descriptorsWritten << "\n";
+	}
+
 	FrameMgr()->CacheSubmissioninfo(GlobalGraphicQueue(), { m_commandBufferList[cbIndex] }, {}, false);
 	
 	GetSwapChain()->QueuePresentImage(GlobalObjects()->GetPresentQueue());